@@ -0,0 +1,495 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// for splice, pread and clock_gettime
+#define _GNU_SOURCE
+
+#include "ffp_afalg.h"
+#include <openssl/sha.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/if_alg.h>
+#include <fcntl.h>
+#endif
+
+#ifndef AF_ALG
+#define AF_ALG 38
+#endif
+
+afalg_info fp_afalg;
+
+static const char* alg_name[AFALG_ALG_NUM] =
+{   "sha1",     // CHECKSUM_SHA1_INDEX
+    "sha256",   // CHECKSUM_SHA256_INDEX
+    "sha512"    // CHECKSUM_SHA512_INDEX
+};
+
+static const uint16_t alg_id[AFALG_ALG_NUM] =
+{   CHECKSUM_SHA1_ID,
+    CHECKSUM_SHA256_ID,
+    CHECKSUM_SHA512_ID
+};
+
+static const uint16_t alg_len[AFALG_ALG_NUM] =
+{   SHA_DIGEST_LENGTH,
+    SHA256_DIGEST_LENGTH,
+    SHA512_DIGEST_LENGTH
+};
+
+// file descriptors currently open, closed by afalg_cleanup if hashing is interrupted
+static int live_fd[AFALG_LIVE_FD_MAX];
+static int live_fd_num = 0;
+
+static void track_fd(int fd) {
+    if (live_fd_num < AFALG_LIVE_FD_MAX) {
+        live_fd[live_fd_num++] = fd;
+    }
+}
+
+static void close_fd(int fd) {
+    int i;
+
+    if (fd < 0) {
+        return;
+    }
+
+    for (i = 0; i < live_fd_num; i++) {
+        if (live_fd[i] == fd) {
+            live_fd[i] = live_fd[--live_fd_num];
+            break;
+        }
+    }
+
+    close(fd);
+}
+
+static int64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t) ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static uint64_t calc_kbps(uint64_t bytes, int64_t ns) {
+    if (ns <= 0) {
+        ns = 1;
+    }
+
+    return bytes * UINT64_C(1000000) / (uint64_t) ns;
+}
+
+#ifdef __linux__
+
+// returns operation socket for algorithm, or -1
+static int open_op_fd(int index) {
+    struct sockaddr_alg sa;
+
+    int tfm_fd;
+    int op_fd;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    strcpy((char*) sa.salg_type, "hash");
+    strcpy((char*) sa.salg_name, alg_name[index]);
+
+    tfm_fd = socket(AF_ALG, SOCK_SEQPACKET, 0);
+    if (tfm_fd < 0) {
+        return -1;
+    }
+
+    if (bind(tfm_fd, (struct sockaddr*) &sa, sizeof(sa))) {
+        close(tfm_fd);
+        return -1;
+    }
+
+    op_fd = accept(tfm_fd, NULL, 0);
+
+    // operation socket keeps the transform alive
+    close(tfm_fd);
+
+    return op_fd;
+}
+
+// hash buf in kernel, returns 0 and fills digest on success
+static int kernel_hash_buf(int index, const unsigned char* buf, size_t len, unsigned char* digest) {
+    int op_fd;
+
+    size_t done;
+    ssize_t sent;
+
+    op_fd = open_op_fd(index);
+    if (op_fd < 0) {
+        return AFALG_UNAVAILABLE;
+    }
+
+    for (done = 0; done < len; done += sent) {
+        sent = send(op_fd, buf + done, ffp_min(AFALG_SPLICE_CHUNK, len - done), MSG_MORE);
+        if (sent <= 0) {
+            close(op_fd);
+            return AFALG_IO_FAIL;
+        }
+    }
+
+    if (read(op_fd, digest, alg_len[index]) != alg_len[index]) {
+        close(op_fd);
+        return AFALG_IO_FAIL;
+    }
+
+    close(op_fd);
+
+    return 0;
+}
+
+#else
+
+static int open_op_fd(int index) {
+    return -1;
+}
+
+static int kernel_hash_buf(int index, const unsigned char* buf, size_t len, unsigned char* digest) {
+    return AFALG_UNAVAILABLE;
+}
+
+#endif
+
+static void user_hash_buf(int index, const unsigned char* buf, size_t len, unsigned char* digest) {
+    switch (index) {
+        case CHECKSUM_SHA1_INDEX :
+            SHA1(buf, len, digest);
+            break;
+        case CHECKSUM_SHA256_INDEX :
+            SHA256(buf, len, digest);
+            break;
+        case CHECKSUM_SHA512_INDEX :
+            SHA512(buf, len, digest);
+            break;
+    }
+}
+
+int afalg_probe() {
+    unsigned char* buf;
+
+    unsigned char user_digest   [CHECKSUM_MAX_LEN];
+    unsigned char kernel_digest [CHECKSUM_MAX_LEN];
+
+    int64_t start_ns;
+    int64_t user_ns;
+    int64_t kernel_ns;
+
+    size_t i;
+    int j;
+
+    fp_afalg.probed = 1;
+
+    for (j = 0; j < AFALG_ALG_NUM; j++) {
+        fp_afalg.available[j] = 0;
+        fp_afalg.faster[j] = 0;
+        fp_afalg.kernel_kbps[j] = 0;
+        fp_afalg.user_kbps[j] = 0;
+    }
+
+    // skip measuring if kernel does not support AF_ALG at all
+    j = open_op_fd(CHECKSUM_SHA1_INDEX);
+    if (j < 0) {
+        return AFALG_UNAVAILABLE;
+    }
+    close(j);
+
+    buf = malloc(AFALG_PROBE_SIZE);
+    if (!buf) {
+        return MALLOC_FAIL;
+    }
+
+    for (i = 0; i < AFALG_PROBE_SIZE; i++) {
+        buf[i] = (unsigned char) (i * 31 + (i >> 11));
+    }
+
+    for (j = 0; j < AFALG_ALG_NUM; j++) {
+        start_ns = now_ns();
+        user_hash_buf(j, buf, AFALG_PROBE_SIZE, user_digest);
+        user_ns = now_ns() - start_ns;
+
+        start_ns = now_ns();
+        if (kernel_hash_buf(j, buf, AFALG_PROBE_SIZE, kernel_digest)) {
+            continue;
+        }
+        kernel_ns = now_ns() - start_ns;
+
+        // never use kernel hashing if results differ
+        if (memcmp(user_digest, kernel_digest, alg_len[j])) {
+            continue;
+        }
+
+        fp_afalg.available[j] = 1;
+        fp_afalg.faster[j] = kernel_ns < user_ns;
+        fp_afalg.user_kbps[j] = calc_kbps(AFALG_PROBE_SIZE, user_ns);
+        fp_afalg.kernel_kbps[j] = calc_kbps(AFALG_PROBE_SIZE, kernel_ns);
+    }
+
+    free(buf);
+
+    return 0;
+}
+
+int afalg_set_mode(unsigned char mode) {
+    if (mode != AFALG_MODE_AUTO && mode != AFALG_MODE_USER && mode != AFALG_MODE_KERNEL) {
+        return WRONG_ARGS;
+    }
+
+    fp_afalg.mode = mode;
+
+    return 0;
+}
+
+// mask of algorithms to be hashed in kernel under current mode
+uint32_t afalg_kernel_mask() {
+    uint32_t mask = 0;
+
+    int i;
+
+    if (fp_afalg.mode == AFALG_MODE_USER) {
+        return 0;
+    }
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        if (        fp_afalg.available[i]
+                &&  (fp_afalg.faster[i] || fp_afalg.mode == AFALG_MODE_KERNEL)
+           )
+        {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+}
+
+int afalg_open(afalg_ctx* ctx, uint32_t alg_mask) {
+    int i;
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        ctx->op_fd[i] = -1;
+    }
+    ctx->pipe_fd[0] = -1;
+    ctx->pipe_fd[1] = -1;
+
+    if (!alg_mask) {
+        return 0;
+    }
+
+    if (pipe(ctx->pipe_fd)) {
+        ctx->pipe_fd[0] = -1;
+        ctx->pipe_fd[1] = -1;
+        return AFALG_UNAVAILABLE;
+    }
+    track_fd(ctx->pipe_fd[0]);
+    track_fd(ctx->pipe_fd[1]);
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        if (!(alg_mask & (1 << i))) {
+            continue;
+        }
+
+        ctx->op_fd[i] = open_op_fd(i);
+        if (ctx->op_fd[i] < 0) {
+            afalg_close(ctx);
+            return AFALG_UNAVAILABLE;
+        }
+        track_fd(ctx->op_fd[i]);
+    }
+
+    return 0;
+}
+
+#ifdef __linux__
+
+// move len bytes of fd at pos into op_fd through pipe
+static int splice_to_op(int fd, loff_t pos, size_t len, int* pipe_fd, int op_fd) {
+    ssize_t in;
+    ssize_t out;
+
+    while (len > 0) {
+        in = splice(fd, &pos, pipe_fd[1], NULL, len, SPLICE_F_MORE);
+        if (in < 0 && errno == EINTR) {
+            continue;
+        }
+        if (in <= 0) {      // error or file ended early
+            return AFALG_IO_FAIL;
+        }
+        len -= in;
+
+        while (in > 0) {
+            out = splice(pipe_fd[0], NULL, op_fd, NULL, in, SPLICE_F_MORE);
+            if (out < 0 && errno == EINTR) {
+                continue;
+            }
+            if (out <= 0) {
+                return AFALG_IO_FAIL;
+            }
+            in -= out;
+        }
+    }
+
+    return 0;
+}
+
+#else
+
+static int splice_to_op(int fd, int64_t pos, size_t len, int* pipe_fd, int op_fd) {
+    return AFALG_UNAVAILABLE;
+}
+
+#endif
+
+// feed content of fd at [pos, pos + len) to every algorithm of ctx
+int afalg_splice(afalg_ctx* ctx, int fd, uint64_t pos, uint64_t len) {
+    uint64_t chunk;
+
+    int ret;
+    int i;
+
+    while (len > 0) {
+        chunk = ffp_min(len, AFALG_SPLICE_CHUNK);
+
+        for (i = 0; i < AFALG_ALG_NUM; i++) {
+            if (ctx->op_fd[i] < 0) {
+                continue;
+            }
+
+            ret = splice_to_op(fd, pos, chunk, ctx->pipe_fd, ctx->op_fd[i]);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        pos += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+// checksum should point to array of CHECKSUM_MAX_NUM results, ctx is closed afterwards
+int afalg_final(afalg_ctx* ctx, checksum_result* checksum) {
+    int ret = 0;
+    int i;
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        checksum[i].type = CHECKSUM_UNUSED;
+    }
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        if (ctx->op_fd[i] < 0) {
+            continue;
+        }
+
+        if (read(ctx->op_fd[i], checksum[i].checksum, alg_len[i]) != alg_len[i]) {
+            ret = AFALG_IO_FAIL;
+            continue;
+        }
+
+        checksum[i].type = alg_id[i];
+        checksum[i].len = alg_len[i];
+        bytes_to_hex_str(checksum[i].checksum_str, checksum[i].checksum, alg_len[i]);
+    }
+
+    afalg_close(ctx);
+
+    // do not leave partial results behind
+    if (ret) {
+        for (i = 0; i < AFALG_ALG_NUM; i++) {
+            checksum[i].type = CHECKSUM_UNUSED;
+        }
+    }
+
+    return ret;
+}
+
+void afalg_close(afalg_ctx* ctx) {
+    int i;
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        close_fd(ctx->op_fd[i]);
+        ctx->op_fd[i] = -1;
+    }
+
+    close_fd(ctx->pipe_fd[0]);
+    close_fd(ctx->pipe_fd[1]);
+    ctx->pipe_fd[0] = -1;
+    ctx->pipe_fd[1] = -1;
+}
+
+// close everything left open by interrupted hashing
+void afalg_cleanup() {
+    while (live_fd_num > 0) {
+        close(live_fd[--live_fd_num]);
+    }
+}
+
+int afalg_pread(int fd, unsigned char* buf, size_t len, uint64_t pos) {
+    ssize_t bytes;
+
+    while (len > 0) {
+        bytes = pread(fd, buf, len, pos);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return AFALG_IO_FAIL;
+        }
+
+        buf += bytes;
+        pos += bytes;
+        len -= bytes;
+    }
+
+    return 0;
+}
+
+int afalg_print_status() {
+    int i;
+
+    switch (fp_afalg.mode) {
+        case AFALG_MODE_AUTO :
+            printf("hash backend : auto\n");
+            break;
+        case AFALG_MODE_USER :
+            printf("hash backend : user space only\n");
+            break;
+        case AFALG_MODE_KERNEL :
+            printf("hash backend : kernel where available\n");
+            break;
+    }
+
+    for (i = 0; i < AFALG_ALG_NUM; i++) {
+        if (!fp_afalg.available[i]) {
+            printf("    %-8s : user space (kernel unavailable)\n", alg_name[i]);
+            continue;
+        }
+
+        printf("    %-8s : %s (kernel %"PRIu64" KB/s, user %"PRIu64" KB/s)\n",
+                alg_name[i],
+                afalg_kernel_mask() & (1 << i) ? "kernel" : "user space",
+                fp_afalg.kernel_kbps[i],
+                fp_afalg.user_kbps[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+
+#ifndef FFP_AFALG_H
+#define FFP_AFALG_H
+
+/*  Note on kernel hashing :
+ *      checksums can be computed by the kernel crypto API through AF_ALG
+ *      sockets, file content is moved into the sockets with splice
+ *      so it never enters user space
+ *
+ *      afalg_probe is run once at start up, it measures throughput of
+ *      kernel and user space hashing for each algorithm, and also checks
+ *      both give the same result
+ *      in auto mode kernel hashing is used for algorithms where it is faster
+ *
+ *      algorithms are selected by mask of (1 << CHECKSUM_*_INDEX)
+ *
+ *      on systems without AF_ALG nothing is available and
+ *      user space hashing is always used
+ */
+
+#define AFALG_ALG_NUM           3           // sha1, sha256, sha512
+#define AFALG_SPLICE_CHUNK      65536       // default pipe capacity
+#define AFALG_PROBE_SIZE        4194304     // 4MiB
+#define AFALG_LIVE_FD_MAX       16
+
+#define AFALG_MODE_AUTO         0
+#define AFALG_MODE_USER         1
+#define AFALG_MODE_KERNEL       2
+
+#define AFALG_UNAVAILABLE       600
+#define AFALG_IO_FAIL           601
+
+typedef struct afalg_ctx afalg_ctx;
+
+struct afalg_ctx {
+    int op_fd[AFALG_ALG_NUM];   // -1 if unused
+    int pipe_fd[2];
+};
+
+typedef struct afalg_info afalg_info;
+
+struct afalg_info {
+    unsigned char mode;
+    unsigned char probed;
+
+    unsigned char available [AFALG_ALG_NUM];    // supported by kernel and gives same results
+    unsigned char faster    [AFALG_ALG_NUM];    // kernel measured faster than user space
+    uint64_t kernel_kbps    [AFALG_ALG_NUM];
+    uint64_t user_kbps      [AFALG_ALG_NUM];
+};
+
+extern afalg_info fp_afalg;
+
+int afalg_probe();
+
+int afalg_set_mode(unsigned char mode);
+
+uint32_t afalg_kernel_mask();
+
+int afalg_open(afalg_ctx* ctx, uint32_t alg_mask);
+
+int afalg_splice(afalg_ctx* ctx, int fd, uint64_t pos, uint64_t len);
+
+int afalg_final(afalg_ctx* ctx, checksum_result* checksum);
+
+void afalg_close(afalg_ctx* ctx);
+
+void afalg_cleanup();
+
+int afalg_pread(int fd, unsigned char* buf, size_t len, uint64_t pos);
+
+int afalg_print_status();
+
+#endif
@@ -22,12 +22,16 @@
 #include "ffprinter_function_template.h"
 #include "ffp_term.h"
 #include "ffp_scanmem.h"
+#include "ffp_fuzzy.h"
 
 #pragma GCC diagnostic ignored "-Wunused-but-set-variable"
 
 int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {     // should only be omitted for manual repair
     int i;
     uint64_t sect_indx;
+    uint64_t start_pos;
+    uint64_t end_pos;
+    uint64_t prev_end_pos = 0;
     uint32_t extr_indx;
     uint16_t chks_indx;
     volatile extract_sample* temp_extract;
@@ -40,22 +44,13 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     volatile section*           temp_section;
     volatile file_data*         temp_file_data;
     volatile file_data          derefed_file_data;
-    volatile section            derefed_section;
-    volatile section*           derefed_section_p;
     volatile t_fn_to_e          derefed_fn_to_e;
     volatile t_tag_to_e         derefed_tag_to_e;
     volatile t_sha1f_to_fd      derefed_sha1f_to_fd;
     volatile t_sha256f_to_fd    derefed_sha256f_to_fd;
     volatile t_sha512f_to_fd    derefed_sha512f_to_fd;
-    volatile t_sha1s_to_s       derefed_sha1s_to_s;
-    volatile t_sha256s_to_s     derefed_sha256s_to_s;
-    volatile t_sha512s_to_s     derefed_sha512s_to_s;
+    volatile t_mrklf_to_fd      derefed_mrklf_to_fd;
     volatile t_f_size_to_fd     derefed_f_size_to_fd;
-    volatile dtt_hour           derefed_tod_hour;
-    volatile dtt_hour           derefed_tom_hour;
-    volatile dtt_hour           derefed_tusr_hour;
-
-    char id_buf[EID_STR_MAX+1];
 
     debug_printf("verifying entry\n");
 
@@ -68,12 +63,6 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     derefed_entry = *entry;
     debug_printf("dereferencing was successful\n");
 
-    debug_printf("checking of entry id string is terminated properly\n");
-    if (verify_str_terminated(entry->entry_id_str, EID_STR_MAX, NULL, 0x0)) {
-        printf("verify_entry : entry id string is not terminated properly\n");
-        return VERIFY_FAIL;
-    }
-
     if (entry == &dh->tree) {   // skip most tests if tree root
         debug_printf("entry is database tree root\n");
 
@@ -89,14 +78,6 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         }
         debug_printf("id byte array passed check\n");
 
-        debug_printf("checking if id string is all \'0\'\n");
-        bytes_to_hex_str(id_buf, entry->entry_id, EID_LEN);
-
-        if (strcmp(id_buf, entry->entry_id_str) != 0) {
-            printf("verify_entry : entry is tree root, but id string not all \'0\'\n");
-            return VERIFY_FAIL;
-        }
-
         return 0;
     }
 
@@ -111,6 +92,15 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     derefed_entry = *entry;
     debug_printf("dereferencing was successful\n");
 
+    debug_printf("checking slot in parent's children array\n");
+    if (        entry->child_slot >= entry->parent->child_num
+            ||  entry->parent->child[entry->child_slot] != entry
+       )
+    {
+        printf("verify_entry : entry is not in its slot of parent's children array\n");
+        return VERIFY_FAIL;
+    }
+
     debug_printf("checking children\n");
 
     if (entry->child_num == 0 && entry->child_free_num == 0) {
@@ -143,18 +133,16 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         }
     }
 
-    debug_printf("verifying prev_same_fn\n");
-    if (entry->prev_same_fn) {
-        debug_printf("dereferencing prev_same_fn\n");
-        derefed_entry = *entry->prev_same_fn;
-        debug_printf("dereferencing was successful\n");
+    debug_printf("verifying interned file name and tag\n");
+    if (entry->file_name != str_intern_get(&dh->strs, entry->file_name_id)) {
+        printf("verify_entry : file name does not match interned string\n");
+        return VERIFY_FAIL;
     }
-    debug_printf("verifying next_same_fn\n");
-    if (entry->next_same_fn) {
-        debug_printf("dereferencing next_same_fn\n");
-        derefed_entry = *entry->next_same_fn;
-        debug_printf("dereferencing was successful\n");
+    if (entry->tag_str != str_intern_get(&dh->strs, entry->tag_str_id)) {
+        printf("verify_entry : tag does not match interned string\n");
+        return VERIFY_FAIL;
     }
+
     debug_printf("verifying parent fn_to_e\n");
     if (!entry->fn_to_e) {
         printf("verify_entry : parent fn_to_e missing\n");
@@ -163,17 +151,10 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     debug_printf("dereferencing parent fn_to_e\n");
     derefed_fn_to_e = *entry->fn_to_e;
     debug_printf("dereferencing was successful\n");
-    debug_printf("verifying prev_same_tag\n");
-    if (entry->prev_same_tag) {
-        debug_printf("dereferencing prev_same_tag\n");
-        derefed_entry = *entry->prev_same_tag;
-        debug_printf("dereferencing was successful\n");
-    }
-    debug_printf("verifying next_same_tag\n");
-    if (entry->next_same_tag) {
-        debug_printf("dereferencing next_same_tag\n");
-        derefed_entry = *entry->next_same_tag;
-        debug_printf("dereferencing was successful\n");
+    debug_printf("verifying fn_slot\n");
+    if (entry->fn_slot >= entry->fn_to_e->tar_num || entry->fn_to_e->tar[entry->fn_slot] != entry) {
+        printf("verify_entry : fn_slot does not point to entry\n");
+        return VERIFY_FAIL;
     }
     if (entry->tag_str_len == 0) {
         debug_printf("tag not used, tag related testing skipped\n");
@@ -187,81 +168,116 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         debug_printf("dereferencing parent tag_to_e\n");
         derefed_tag_to_e = *entry->tag_to_e;
         debug_printf("dereferencing was successful\n");
+        debug_printf("verifying tag_slot\n");
+        if (entry->tag_slot >= entry->tag_to_e->tar_num || entry->tag_to_e->tar[entry->tag_slot] != entry) {
+            printf("verify_entry : tag_slot does not point to entry\n");
+            return VERIFY_FAIL;
+        }
     }
     if (!entry->tod_utc_used) {
         debug_printf("time of addition fields not used, tod related testing skipped\n");
     }
     else {
-        debug_printf("verifying tod_prev_sort_min\n");
-        if (entry->tod_prev_sort_min) {
-            debug_printf("dereferencing tod_prev_sort_min\n");
-            derefed_entry = *entry->tod_prev_sort_min;
+        debug_printf("verifying tod_node.left\n");
+        if (entry->tod_node.left) {
+            debug_printf("dereferencing tod_node.left\n");
+            derefed_entry = *entry->tod_node.left;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tod_node.left->tod_utc > entry->tod_utc
+                    ||  (       entry->tod_node.left->tod_utc == entry->tod_utc
+                            &&  entry->tod_node.left->obj_arr_index >= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tod_node.left out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tod_next_sort_min\n");
-        if (entry->tod_next_sort_min) {
-            debug_printf("dereferencing tod_next_sort_min\n");
-            derefed_entry = *entry->tod_next_sort_min;
+        debug_printf("verifying tod_node.right\n");
+        if (entry->tod_node.right) {
+            debug_printf("dereferencing tod_node.right\n");
+            derefed_entry = *entry->tod_node.right;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tod_node.right->tod_utc < entry->tod_utc
+                    ||  (       entry->tod_node.right->tod_utc == entry->tod_utc
+                            &&  entry->tod_node.right->obj_arr_index <= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tod_node.right out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tod_hour\n");
-        if (!entry->tod_hour) {
-            printf("verify_entry : tod_hour missing\n");
-            return VERIFY_FAIL;
-        }
-        debug_printf("dereferencing tod_hour\n");
-        derefed_tod_hour = *entry->tod_hour;
-        debug_printf("dereferencing was successful\n");
     }
     if (!entry->tom_utc_used) {
         debug_printf("time of modification fields not used, tod related testing skipped\n");
     }
     else {
-        debug_printf("verifying tom_prev_sort_min\n");
-        if (entry->tom_prev_sort_min) {
-            debug_printf("dereferencing tom_prev_sort_min\n");
-            derefed_entry = *entry->tom_prev_sort_min;
+        debug_printf("verifying tom_node.left\n");
+        if (entry->tom_node.left) {
+            debug_printf("dereferencing tom_node.left\n");
+            derefed_entry = *entry->tom_node.left;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tom_node.left->tom_utc > entry->tom_utc
+                    ||  (       entry->tom_node.left->tom_utc == entry->tom_utc
+                            &&  entry->tom_node.left->obj_arr_index >= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tom_node.left out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tom_next_sort_min\n");
-        if (entry->tom_next_sort_min) {
-            debug_printf("dereferencing tom_next_sort_min\n");
-            derefed_entry = *entry->tom_next_sort_min;
+        debug_printf("verifying tom_node.right\n");
+        if (entry->tom_node.right) {
+            debug_printf("dereferencing tom_node.right\n");
+            derefed_entry = *entry->tom_node.right;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tom_node.right->tom_utc < entry->tom_utc
+                    ||  (       entry->tom_node.right->tom_utc == entry->tom_utc
+                            &&  entry->tom_node.right->obj_arr_index <= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tom_node.right out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tom_hour\n");
-        if (!entry->tom_hour) {
-            printf("verify_entry : tom_hour missing\n");
-            return VERIFY_FAIL;
-        }
-        debug_printf("dereferencing tom_hour\n");
-        derefed_tom_hour = *entry->tom_hour;
-        debug_printf("dereferencing was successful\n");
     }
     if (!entry->tusr_utc_used) {
         debug_printf("user specified time fields not used, tod related testing skipped\n");
     }
     else {
-        debug_printf("verifying tusr_prev_sort_min\n");
-        if (entry->tusr_prev_sort_min) {
-            debug_printf("dereferencing tusr_prev_sort_min\n");
-            derefed_entry = *entry->tusr_prev_sort_min;
+        debug_printf("verifying tusr_node.left\n");
+        if (entry->tusr_node.left) {
+            debug_printf("dereferencing tusr_node.left\n");
+            derefed_entry = *entry->tusr_node.left;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tusr_node.left->tusr_utc > entry->tusr_utc
+                    ||  (       entry->tusr_node.left->tusr_utc == entry->tusr_utc
+                            &&  entry->tusr_node.left->obj_arr_index >= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tusr_node.left out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tusr_next_sort_min\n");
-        if (entry->tusr_next_sort_min) {
-            debug_printf("dereferencing tusr_next_sort_min\n");
-            derefed_entry = *entry->tusr_next_sort_min;
+        debug_printf("verifying tusr_node.right\n");
+        if (entry->tusr_node.right) {
+            debug_printf("dereferencing tusr_node.right\n");
+            derefed_entry = *entry->tusr_node.right;
             debug_printf("dereferencing was successful\n");
+            if (        entry->tusr_node.right->tusr_utc < entry->tusr_utc
+                    ||  (       entry->tusr_node.right->tusr_utc == entry->tusr_utc
+                            &&  entry->tusr_node.right->obj_arr_index <= entry->obj_arr_index
+                        )
+               )
+            {
+                printf("verify_entry : tusr_node.right out of order\n");
+                return VERIFY_FAIL;
+            }
         }
-        debug_printf("verifying tusr_hour\n");
-        if (!entry->tusr_hour) {
-            printf("verify_entry : tusr_hour missing\n");
-            return VERIFY_FAIL;
-        }
-        debug_printf("dereferencing tusr_hour\n");
-        derefed_tusr_hour = *entry->tusr_hour;
-        debug_printf("dereferencing was successful\n");
     }
 
     debug_printf("verifying branch id byte array\n");
@@ -274,12 +290,6 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         printf("verify_entry : invalid branch id byte array\n");
         return VERIFY_FAIL;
     }
-    debug_printf("verifying if branch id string is consistent with byte array\n");
-    bytes_to_hex_str(id_buf, entry->branch_id, EID_LEN);
-    if (strcmp(id_buf, entry->branch_id_str) != 0) {
-        printf("verify_entry : branch id string does not match branch id byte array\n");
-        return VERIFY_FAIL;
-    }
     if (entry->has_parent) {
         debug_printf("verifying if branch id byte array matches with parent's branch id byte array\n");
         for (i = 0; i < EID_LEN; i++) {
@@ -317,12 +327,6 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         printf("verify_entry : invalid entry id byte array\n");
         return VERIFY_FAIL;
     }
-    debug_printf("verifying if entry id string is consistent with byte array\n");
-    bytes_to_hex_str(id_buf, entry->entry_id, EID_LEN);
-    if (strcmp(id_buf, entry->entry_id_str) != 0) {
-        printf("verify_entry : entry id string does not match entry id byte array\n");
-        return VERIFY_FAIL;
-    }
 
     debug_printf("verifying type\n");
     if (        entry->type != ENTRY_FILE
@@ -343,6 +347,10 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     }
 
     debug_printf("verifying file name\n");
+    if (!entry->file_name || !entry->tag_str || !entry->user_msg) {
+        printf("verify_entry : string pointer is null\n");
+        return VERIFY_FAIL;
+    }
     if (entry->file_name_len == 0) {
         printf("verify_entry : entry name has zero length\n");
         return VERIFY_FAIL;
@@ -411,47 +419,7 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         }
     }
 
-    if (entry->tod_utc_used) {
-        debug_printf("verifying time of addition\n");
-        if (entry->tod_utc.tm_mon > 11) {
-            printf("verify_entry : invalid month number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tod_utc.tm_mday < 1 || entry->tod_utc.tm_mday > 31) {
-            printf("verify_entry : invalid day number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tod_utc.tm_hour > 23) {
-            printf("verify_entry : invalid hour number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tod_utc.tm_min > 59) {
-            printf("verify_entry : invalid minute number\n");
-            return VERIFY_FAIL;
-        }
-        // other fields are ignored
-    }
-
-    if (entry->tusr_utc_used) {
-        debug_printf("verifying user specified time\n");
-        if (entry->tusr_utc.tm_mon > 11) {
-            printf("verify_entry : invalid month number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tusr_utc.tm_mday < 1 || entry->tusr_utc.tm_mday > 31) {
-            printf("verify_entry : invalid day number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tusr_utc.tm_hour > 23) {
-            printf("verify_entry : invalid hour number\n");
-            return VERIFY_FAIL;
-        }
-        if (entry->tusr_utc.tm_min > 59) {
-            printf("verify_entry : invalid minute number\n");
-            return VERIFY_FAIL;
-        }
-        // other fields are ignored
-    }
+    // times are seconds since epoch, any value is a valid time
 
     // not checking hash handle
     debug_printf("ignoring hash handle\n");
@@ -466,61 +434,52 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
     debug_printf("dereferencing was successful\n");
     temp_file_data = entry->data;
     // sha1
-    debug_printf("verifying prev_same_sha1 in file data\n");
-    if (temp_file_data->prev_same_sha1) {
-        debug_printf("dereferencing prev_same_sha1 in file data\n");
-        derefed_file_data = *temp_file_data->prev_same_sha1;
-        debug_printf("dereferencing was successful\n");
-    }
-    debug_printf("verifying next_same_sha1 in file data\n");
-    if (temp_file_data->next_same_sha1) {
-        debug_printf("dereferencing next_same_sha1 in file data\n");
-        derefed_file_data = *temp_file_data->next_same_sha1;
-        debug_printf("dereferencing was successful\n");
-    }
     debug_printf("verifying parent sha1f_to_fd\n");
     if (temp_file_data->sha1f_to_fd) {
         debug_printf("dereferencing parent sha1f_to_fd\n");
         derefed_sha1f_to_fd = *temp_file_data->sha1f_to_fd;
         debug_printf("dereferencing was successful\n");
+        debug_printf("verifying sha1f_slot in file data\n");
+        if (temp_file_data->sha1f_slot >= temp_file_data->sha1f_to_fd->tar_num || temp_file_data->sha1f_to_fd->tar[temp_file_data->sha1f_slot] != temp_file_data) {
+            printf("verify_entry : sha1f_slot does not point to file data\n");
+            return VERIFY_FAIL;
+        }
     }
     // sha256
-    debug_printf("verifying prev_same_sha256 in file data\n");
-    if (temp_file_data->prev_same_sha256) {
-        debug_printf("dereferencing prev_same_sha256 in file data\n");
-        derefed_file_data = *temp_file_data->prev_same_sha256;
-        debug_printf("dereferencing was successful\n");
-    }
-    debug_printf("verifying next_same_sha256 in file data\n");
-    if (temp_file_data->next_same_sha256) {
-        debug_printf("dereferencing next_same_sha256 in file data\n");
-        derefed_file_data = *temp_file_data->next_same_sha256;
-        debug_printf("dereferencing was successful\n");
-    }
     debug_printf("verifying parent sha256f_to_fd\n");
     if (temp_file_data->sha256f_to_fd) {
         debug_printf("dereferencing parent sha256f_to_fd\n");
         derefed_sha256f_to_fd = *temp_file_data->sha256f_to_fd;
         debug_printf("dereferencing was successful\n");
+        debug_printf("verifying sha256f_slot in file data\n");
+        if (temp_file_data->sha256f_slot >= temp_file_data->sha256f_to_fd->tar_num || temp_file_data->sha256f_to_fd->tar[temp_file_data->sha256f_slot] != temp_file_data) {
+            printf("verify_entry : sha256f_slot does not point to file data\n");
+            return VERIFY_FAIL;
+        }
     }
     // sha512
-    debug_printf("verifying prev_same_sha512 in file data\n");
-    if (temp_file_data->prev_same_sha512) {
-        debug_printf("dereferencing prev_same_sha512 in file data\n");
-        derefed_file_data = *temp_file_data->prev_same_sha512;
-        debug_printf("dereferencing was successful\n");
-    }
-    debug_printf("verifying next_same_sha512 in file data\n");
-    if (temp_file_data->next_same_sha512) {
-        debug_printf("dereferencing next_same_sha512 in file data\n");
-        derefed_file_data = *temp_file_data->next_same_sha512;
-        debug_printf("dereferencing was successful\n");
-    }
     debug_printf("verifying parent sha512f_to_fd\n");
     if (temp_file_data->sha512f_to_fd) {
         debug_printf("dereferencing parent sha512f_to_fd\n");
         derefed_sha512f_to_fd = *temp_file_data->sha512f_to_fd;
         debug_printf("dereferencing was successful\n");
+        debug_printf("verifying sha512f_slot in file data\n");
+        if (temp_file_data->sha512f_slot >= temp_file_data->sha512f_to_fd->tar_num || temp_file_data->sha512f_to_fd->tar[temp_file_data->sha512f_slot] != temp_file_data) {
+            printf("verify_entry : sha512f_slot does not point to file data\n");
+            return VERIFY_FAIL;
+        }
+    }
+    // merkle
+    debug_printf("verifying parent mrklf_to_fd\n");
+    if (temp_file_data->mrklf_to_fd) {
+        debug_printf("dereferencing parent mrklf_to_fd\n");
+        derefed_mrklf_to_fd = *temp_file_data->mrklf_to_fd;
+        debug_printf("dereferencing was successful\n");
+        debug_printf("verifying mrklf_slot in file data\n");
+        if (temp_file_data->mrklf_slot >= temp_file_data->mrklf_to_fd->tar_num || temp_file_data->mrklf_to_fd->tar[temp_file_data->mrklf_slot] != temp_file_data) {
+            printf("verify_entry : mrklf_slot does not point to file data\n");
+            return VERIFY_FAIL;
+        }
     }
 
     debug_printf("verifying checksum\n");
@@ -532,6 +491,7 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
             &&  temp_checksum->type != CHECKSUM_SHA1_ID
             &&  temp_checksum->type != CHECKSUM_SHA256_ID
             &&  temp_checksum->type != CHECKSUM_SHA512_ID
+            &&  temp_checksum->type != CHECKSUM_MRKL_ID
            )
         {
             printf("verify_entry : checksum #%"PRIu16" invalid type\n", chks_indx);
@@ -576,23 +536,16 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         }
     }
     debug_printf("verifying file size\n");
-    debug_printf("verifying prev_same_f_size\n");
-    if (temp_file_data->prev_same_f_size) {
-        debug_printf("dereferencing prev_same_f_size\n");
-        derefed_file_data = *temp_file_data->prev_same_f_size;
-        debug_printf("dereferencing was successful\n");
-    }
-    debug_printf("verifying next_same_f_size\n");
-    if (temp_file_data->next_same_f_size) {
-        debug_printf("dereferencing next_same_f_size\n");
-        derefed_file_data = *temp_file_data->next_same_f_size;
-        debug_printf("dereferencing was successful\n");
-    }
     debug_printf("verifying parent f_size_to_fd\n");
     if (temp_file_data->f_size_to_fd) {
         debug_printf("dereferencing parent f_size_to_fd\n");
         derefed_f_size_to_fd = *temp_file_data->f_size_to_fd;
         debug_printf("dereferencing was successful\n");
+        debug_printf("verifying f_size_slot\n");
+        if (temp_file_data->f_size_slot >= temp_file_data->f_size_to_fd->tar_num || temp_file_data->f_size_to_fd->tar[temp_file_data->f_size_slot] != temp_file_data) {
+            printf("verify_entry : f_size_slot does not point to file data\n");
+            return VERIFY_FAIL;
+        }
     }
 
     debug_printf("verifying sections\n");
@@ -630,127 +583,49 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
         }
     }
 
-    debug_printf("dereferencing section pointers\n");
-    for (sect_indx = 0; sect_indx < temp_file_data->section_num; sect_indx++) {
-        debug_printf("dereferencing pointer to section pointer #%"PRIu64"\n", sect_indx);
-        derefed_section_p = temp_file_data->section[sect_indx];
-        debug_printf("dereferencing was successful\n");
-
-        debug_printf("dereferencing pointer to section\n");
-        derefed_section = *derefed_section_p;
-        debug_printf("dereferencing was successful\n");
+    if (temp_file_data->section_num > 0 && temp_file_data->norm_sect_size == 0 && !temp_file_data->sect_pos) {
+        printf("verify_entry : section positions are neither stored nor derivable\n");
+        return VERIFY_FAIL;
     }
 
     for (sect_indx = 0; sect_indx < temp_file_data->section_num; sect_indx++) {
         debug_printf("verifying section #%"PRIu64"\n", sect_indx);
-        temp_section = temp_file_data->section[sect_indx];
+        temp_section = temp_file_data->section + sect_indx;
+
+        get_sect_pos((file_data*) temp_file_data, sect_indx, &start_pos, &end_pos);
 
-        if (temp_section->start_pos >= temp_section->end_pos) {
+        if (start_pos >= end_pos) {
             printf("verify_entry : start position crosses over or overlaps with end pos\n");
             return VERIFY_FAIL;
         }
 
-        if (temp_section->start_pos >= temp_file_data->file_size) {
+        if (start_pos >= temp_file_data->file_size) {
             printf("verify_entry : start position crosses over end of file\n");
             return VERIFY_FAIL;
         }
-        if (temp_section->end_pos   >= temp_file_data->file_size) {
+        if (end_pos   >= temp_file_data->file_size) {
             printf("verify_entry : end position crosses over end of file\n");
             return VERIFY_FAIL;
         }
 
         if (temp_file_data->norm_sect_size > 0) {  // continuous sections
             if (sect_indx > 0) {
-                if (temp_section->start_pos <= temp_file_data->section[sect_indx-1]->end_pos) {
+                if (start_pos <= prev_end_pos) {
                     printf("verify_entry : section overlaps with the previous one\n");
                     return VERIFY_FAIL;
                 }
             }
         }
-
-        // sha1
-        debug_printf("verifying prev_same_sha1 in section\n");
-        if (temp_section->prev_same_sha1) {
-            debug_printf("dereferencing prev_same_sha1 in section\n");
-            derefed_section = *temp_section->prev_same_sha1;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying next_same_sha1 in section\n");
-        if (temp_section->next_same_sha1) {
-            debug_printf("dereferencing next_same_sha1 in section\n");
-            derefed_section = *temp_section->next_same_sha1;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying parent sha1_to_s\n");
-        if (temp_section->sha1s_to_s) {
-            debug_printf("dereferencing parent sha1s_to_s\n");
-            derefed_sha1s_to_s = *temp_section->sha1s_to_s;
-            debug_printf("dereferencing was successful\n");
-        }
-        // sha256
-        debug_printf("verifying prev_same_sha256 in section\n");
-        if (temp_section->prev_same_sha256) {
-            debug_printf("dereferencing prev_same_sha256 in section\n");
-            derefed_section = *temp_section->prev_same_sha256;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying next_same_sha256 in section\n");
-        if (temp_section->next_same_sha256) {
-            debug_printf("dereferencing next_same_sha256 in section\n");
-            derefed_section = *temp_section->next_same_sha256;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying parent sha256_to_s\n");
-        if (temp_section->sha256s_to_s) {
-            debug_printf("dereferencing parent sha256s_to_s\n");
-            derefed_sha256s_to_s = *temp_section->sha256s_to_s;
-            debug_printf("dereferencing was successful\n");
-        }
-        // sha512
-        debug_printf("verifying prev_same_sha512 in section\n");
-        if (temp_section->prev_same_sha512) {
-            debug_printf("dereferencing prev_same_sha512 in section\n");
-            derefed_section = *temp_section->prev_same_sha512;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying next_same_sha512 in section\n");
-        if (temp_section->next_same_sha512) {
-            debug_printf("dereferencing next_same_sha512 in section\n");
-            derefed_section = *temp_section->next_same_sha512;
-            debug_printf("dereferencing was successful\n");
-        }
-        debug_printf("verifying parent sha512_to_s\n");
-        if (temp_section->sha512s_to_s) {
-            debug_printf("dereferencing parent sha512s_to_s\n");
-            derefed_sha512s_to_s = *temp_section->sha512s_to_s;
-            debug_printf("dereferencing was successful\n");
-        }
+        prev_end_pos = end_pos;
 
         debug_printf("verifying checksum\n");
-        for (chks_indx = 0; chks_indx < CHECKSUM_MAX_NUM; chks_indx++) {
-            temp_checksum = temp_section->checksum + chks_indx;
-
-            debug_printf("verifying checksum #%"PRIu16"\n", chks_indx);
-            if (    temp_checksum->type != CHECKSUM_UNUSED
-                &&  temp_checksum->type != CHECKSUM_SHA1_ID
-                &&  temp_checksum->type != CHECKSUM_SHA256_ID
-                &&  temp_checksum->type != CHECKSUM_SHA512_ID
-                )
-            {
-                printf("verify_entry : checksum #%"PRIu16" invalid type\n", chks_indx);
-                return VERIFY_FAIL;
-            }
-
-            if (temp_checksum->type == CHECKSUM_UNUSED) {
-                continue;
-            }
-
-            if (temp_checksum->len > CHECKSUM_MAX_LEN) {
-                printf("verify_entry : checksum #%"PRIu16" length exceeds maximum\n", chks_indx);
-                return VERIFY_FAIL;
-            }
-            if (verify_str_terminated((char*) temp_checksum->checksum_str, CHECKSUM_STR_MAX, 0, 0)) {
-                printf("verify_entry : checksum #%"PRIu16" checksum_str not properly terminated\n", chks_indx);
+        if (temp_section->checksum_used >> SECT_CHECKSUM_NUM) {
+            printf("verify_entry : section #%"PRIu64" has invalid checksum type\n", sect_indx);
+            return VERIFY_FAIL;
+        }
+        for (chks_indx = 0; chks_indx < SECT_CHECKSUM_NUM; chks_indx++) {
+            if (sect_has_checksum(temp_file_data, sect_indx, chks_indx) && !temp_file_data->sect_digest[chks_indx]) {
+                printf("verify_entry : checksum #%"PRIu16" present but no digest array\n", chks_indx);
                 return VERIFY_FAIL;
             }
         }
@@ -760,8 +635,12 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
             printf("verify_entry : number of extract exceeds maximum\n");
             return VERIFY_FAIL;
         }
+        if (temp_section->extract_num > 0 && !temp_file_data->sect_extract) {
+            printf("verify_entry : section has extracts but no extract array\n");
+            return VERIFY_FAIL;
+        }
         for (extr_indx = 0; extr_indx < temp_section->extract_num; extr_indx++) {
-            temp_extract = temp_section->extract + extr_indx;
+            temp_extract = sect_extract(temp_file_data, sect_indx) + extr_indx;
 
             debug_printf("verifying extract #%"PRIu32"\n", extr_indx);
             if (temp_extract->len > EXTRACT_SIZE_MAX) {
@@ -782,15 +661,15 @@ int verify_entry (database_handle* dh, linked_entry* entry, uint32_t flags) {
                 return VERIFY_FAIL;
             }
 
-            if (temp_extract->position < temp_section->start_pos) {
+            if (temp_extract->position < start_pos) {
                 printf("verify_entry : extract %"PRIu32" starts before the section starts\n", extr_indx);
                 return VERIFY_FAIL;
             }
-            if (temp_extract->position > temp_section->end_pos) {
+            if (temp_extract->position > end_pos) {
                 printf("verify_entry : extract %"PRIu32" starting position exceeds section ending position\n", extr_indx);
                 return VERIFY_FAIL;
             }
-            if (temp_extract->position + temp_extract->len - 1 > temp_section->end_pos) {
+            if (temp_extract->position + temp_extract->len - 1 > end_pos) {
                 printf("verify_entry : extract %"PRIu32" runs past end of section\n", extr_indx);
                 return VERIFY_FAIL;
             }
@@ -804,21 +683,22 @@ skip_file:
     return 0;
 }
 
-verify_generic_trans_struct_one_to_one(eid, e, EID_STR_MAX)
+verify_generic_trans_struct_one_to_one_key(eid, e)
 
-verify_generic_trans_struct_one_to_many(fn, e, prev_same_fn, next_same_fn, linked_entry, FILE_NAME_MAX)
+verify_generic_trans_struct_one_to_many(fn, e, fn_slot, FILE_NAME_MAX)
 
-verify_generic_trans_struct_one_to_many(tag, e, prev_same_tag, next_same_tag, linked_entry, TAG_STR_MAX)
+verify_generic_trans_struct_one_to_many(tag, e, tag_slot, TAG_STR_MAX)
 
-verify_generic_trans_struct_one_to_many(sha1f, fd, prev_same_sha1, next_same_sha1, file_data, CHECKSUM_STR_MAX)
-verify_generic_trans_struct_one_to_many(sha256f, fd, prev_same_sha256, next_same_sha256, file_data, CHECKSUM_STR_MAX)
-verify_generic_trans_struct_one_to_many(sha512f, fd, prev_same_sha512, next_same_sha512, file_data, CHECKSUM_STR_MAX)
+verify_generic_trans_struct_one_to_many_key(sha1f, fd, sha1f_slot)
+verify_generic_trans_struct_one_to_many_key(sha256f, fd, sha256f_slot)
+verify_generic_trans_struct_one_to_many_key(sha512f, fd, sha512f_slot)
+verify_generic_trans_struct_one_to_many_key(mrklf, fd, mrklf_slot)
 
-verify_generic_trans_struct_one_to_many(sha1s, s, prev_same_sha1, next_same_sha1, section, CHECKSUM_STR_MAX)
-verify_generic_trans_struct_one_to_many(sha256s, s, prev_same_sha256, next_same_sha256, section, CHECKSUM_STR_MAX)
-verify_generic_trans_struct_one_to_many(sha512s, s, prev_same_sha512, next_same_sha512, section, CHECKSUM_STR_MAX)
+verify_generic_trans_struct_one_to_many_sect_key(sha1s, s, CHECKSUM_SHA1_INDEX)
+verify_generic_trans_struct_one_to_many_sect_key(sha256s, s, CHECKSUM_SHA256_INDEX)
+verify_generic_trans_struct_one_to_many_sect_key(sha512s, s, CHECKSUM_SHA512_INDEX)
 
-verify_generic_trans_struct_one_to_many(f_size, fd, prev_same_f_size, next_same_f_size, file_data, FILE_SIZE_STR_MAX)
+verify_generic_trans_struct_one_to_many(f_size, fd, f_size_slot, FILE_SIZE_STR_MAX)
 
 int lookup_db_name (database_handle* dh_table, const char* name, database_handle** result) {
     database_handle* temp_dh_find;
@@ -860,25 +740,46 @@ int del_db (database_handle** dh_table, database_handle* dh) {
 }
 
 /* Entry ID lookup */
-lookup_generic_one_to_one_tran_via_dh(database_handle, eid, e, entry_id, linked_entry)
+lookup_generic_one_to_one_key_tran_via_dh(database_handle, eid, e, entry_id_key, linked_entry, EID_LEN)
+
+// hex form, for ids typed in or stored as strings
+int lookup_entry_id_via_dh (database_handle* dh, const char* eid_str, linked_entry** result) {
+    char str_buf[EID_STR_MAX+1];
+    unsigned char eid[EID_LEN];
+
+    str_len_int str_len;
+
+    *result = 0;
+
+    if (verify_str_terminated(eid_str, EID_STR_MAX, &str_len, 0) || str_len != EID_STR_MAX) {
+        return FIND_FAIL;
+    }
+
+    strcpy(str_buf, eid_str);
+    if (hex_str_to_bytes(eid, str_buf)) {
+        return FIND_FAIL;
+    }
+
+    return lookup_entry_id_key_via_dh(dh, eid, result);
+}
 
-lookup_generic_part_map_via_dh(database_handle, eid, e, entry_id, EID_STR_MAX)
+lookup_generic_part_map_digest_via_dh(database_handle, eid, e, entry_id, EID_STR_MAX, L1_EID_TO_E_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, eid, e, entry_id, EID_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, eid, e, entry_id, EID_STR_MAX)
 
 /* File name lookup */
-lookup_generic_one_to_many_tran_via_dh(database_handle, fn, e, file_name, linked_entry)
+lookup_generic_one_to_many_str_id_tran_via_dh(database_handle, fn, e, file_name)
 
-lookup_generic_part_map_via_dh(database_handle, fn, e, file_name, FILE_NAME_MAX)
+lookup_generic_part_map_gram_via_dh(database_handle, fn, e, file_name, FILE_NAME_MAX, L1_FN_TO_E_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, fn, e, file_name, FILE_NAME_MAX)
+lookup_generic_part_gram_via_dh(database_handle, fn, e, file_name, FILE_NAME_MAX, L1_FN_TO_E_ARR_SIZE)
 
 /* Tag lookup */
-lookup_generic_one_to_many_tran_via_dh(database_handle, tag, e, tag_str, linked_entry)
+lookup_generic_one_to_many_str_id_tran_via_dh(database_handle, tag, e, tag_str)
 
-lookup_generic_part_map_via_dh(database_handle, tag, e, tag, TAG_STR_MAX)
+lookup_generic_part_map_gram_via_dh(database_handle, tag, e, tag, TAG_STR_MAX, L1_TAG_TO_E_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, tag, e, tag, TAG_STR_MAX)
+lookup_generic_part_gram_via_dh(database_handle, tag, e, tag, TAG_STR_MAX, L1_TAG_TO_E_ARR_SIZE)
 
 int lookup_tag_via_dh_with_preproc (database_handle* dh, const char* in_tag, simple_bitmap* map_buf, simple_bitmap* map_result, t_tag_to_e** result_buf, bit_index buf_size, bit_index* num_used) {
     char tag[TAG_STR_MAX+1];
@@ -993,139 +894,307 @@ int lookup_tag_part_map_via_dh_with_preproc (database_handle* dh, const char* in
 }
 
 /* File data checksum lookup */
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha1f,      fd, file_sha1,      file_data)
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha256f,    fd, file_sha256,    file_data)
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha512f,    fd, file_sha512,    file_data)
+lookup_generic_one_to_many_key_tran_via_dh(database_handle, sha1f,      fd, file_sha1_key,      SHA_DIGEST_LENGTH)
+lookup_generic_one_to_many_key_tran_via_dh(database_handle, sha256f,    fd, file_sha256_key,    SHA256_DIGEST_LENGTH)
+lookup_generic_one_to_many_key_tran_via_dh(database_handle, sha512f,    fd, file_sha512_key,    SHA512_DIGEST_LENGTH)
+lookup_generic_one_to_many_key_tran_via_dh(database_handle, mrklf,      fd, file_mrkl_key,      MRKL_DIGEST_LENGTH)
 
-lookup_generic_part_map_via_dh(database_handle, sha1f,      fd, file_sha1,      CHECKSUM_STR_MAX)
-lookup_generic_part_map_via_dh(database_handle, sha256f,    fd, file_sha256,    CHECKSUM_STR_MAX)
-lookup_generic_part_map_via_dh(database_handle, sha512f,    fd, file_sha512,    CHECKSUM_STR_MAX)
+lookup_generic_part_map_digest_via_dh(database_handle, sha1f,      fd, file_sha1,      CHECKSUM_STR_MAX, L1_CSUM_TO_FD_ARR_SIZE)
+lookup_generic_part_map_digest_via_dh(database_handle, sha256f,    fd, file_sha256,    CHECKSUM_STR_MAX, L1_CSUM_TO_FD_ARR_SIZE)
+lookup_generic_part_map_digest_via_dh(database_handle, sha512f,    fd, file_sha512,    CHECKSUM_STR_MAX, L1_CSUM_TO_FD_ARR_SIZE)
+lookup_generic_part_map_digest_via_dh(database_handle, mrklf,      fd, file_mrkl,      CHECKSUM_STR_MAX, L1_CSUM_TO_FD_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, sha1f,      fd, file_sha1,      CHECKSUM_STR_MAX)
-lookup_generic_part_via_dh(database_handle, sha256f,    fd, file_sha256,    CHECKSUM_STR_MAX)
-lookup_generic_part_via_dh(database_handle, sha512f,    fd, file_sha512,    CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha1f,      fd, file_sha1,      CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha256f,    fd, file_sha256,    CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha512f,    fd, file_sha512,    CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, mrklf,      fd, file_mrkl,      CHECKSUM_STR_MAX)
 
 /* Section checksum lookup */
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha1s,      s, sect_sha1,   section)
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha256s,    s, sect_sha256, section)
-lookup_generic_one_to_many_tran_via_dh(database_handle, sha512s,    s, sect_sha512, section)
+lookup_generic_one_to_many_sect_key_tran_via_dh(database_handle, sha1s,      s, sect_sha1_key,   SHA_DIGEST_LENGTH)
+lookup_generic_one_to_many_sect_key_tran_via_dh(database_handle, sha256s,    s, sect_sha256_key, SHA256_DIGEST_LENGTH)
+lookup_generic_one_to_many_sect_key_tran_via_dh(database_handle, sha512s,    s, sect_sha512_key, SHA512_DIGEST_LENGTH)
 
-lookup_generic_part_map_via_dh(database_handle, sha1s,      s, sect_sha1,   CHECKSUM_STR_MAX)
-lookup_generic_part_map_via_dh(database_handle, sha256s,    s, sect_sha256, CHECKSUM_STR_MAX)
-lookup_generic_part_map_via_dh(database_handle, sha512s,    s, sect_sha512, CHECKSUM_STR_MAX)
+lookup_generic_part_map_digest_via_dh(database_handle, sha1s,      s, sect_sha1,   CHECKSUM_STR_MAX, L1_CSUM_TO_S_ARR_SIZE)
+lookup_generic_part_map_digest_via_dh(database_handle, sha256s,    s, sect_sha256, CHECKSUM_STR_MAX, L1_CSUM_TO_S_ARR_SIZE)
+lookup_generic_part_map_digest_via_dh(database_handle, sha512s,    s, sect_sha512, CHECKSUM_STR_MAX, L1_CSUM_TO_S_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, sha1s,      s, sect_sha1,   CHECKSUM_STR_MAX)
-lookup_generic_part_via_dh(database_handle, sha256s,    s, sect_sha256, CHECKSUM_STR_MAX)
-lookup_generic_part_via_dh(database_handle, sha512s,    s, sect_sha512, CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha1s,      s, sect_sha1,   CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha256s,    s, sect_sha256, CHECKSUM_STR_MAX)
+lookup_generic_part_digest_via_dh(database_handle, sha512s,    s, sect_sha512, CHECKSUM_STR_MAX)
 
 /* File size lookup */
-lookup_generic_one_to_many_tran_via_dh(database_handle, f_size, fd, file_size, file_data)
+lookup_generic_one_to_many_tran_via_dh(database_handle, f_size, fd, file_size)
 
-lookup_generic_part_map_via_dh(database_handle, f_size, fd, f_size, FILE_SIZE_STR_MAX)
+lookup_generic_part_map_gram_via_dh(database_handle, f_size, fd, file_size, FILE_SIZE_STR_MAX, L1_FSIZE_TO_FD_ARR_SIZE)
 
-lookup_generic_part_via_dh(database_handle, f_size, fd, f_size, FILE_SIZE_STR_MAX)
+lookup_generic_part_gram_via_dh(database_handle, f_size, fd, file_size, FILE_SIZE_STR_MAX, L1_FSIZE_TO_FD_ARR_SIZE)
 
 /* Date time look up */
-int lookup_date_time (database_handle* dh, unsigned char date_type, int16_t year, uint8_t month, uint8_t day, uint8_t hour, linked_entry** result) {
-    dtt_year*   temp_year;
-    dtt_month*  temp_month;
-    dtt_day*    temp_day;
-    dtt_hour*   temp_hour;
-
-    if (date_type == DATE_TOD) {
-        temp_year = dh->tod_dt_tree;
-    }
-    else if (date_type == DATE_TUSR) {
-        temp_year = dh->tusr_dt_tree;
-    }
-    else {
-        printf("lookup_date_time : invalid date type\n");
-        return WRONG_ARGS;
+static time_index* get_time_index (database_handle* dh, unsigned char mode) {
+    switch (mode) {
+        case DATE_TOD :
+            return &dh->tod_index;
+        case DATE_TOM :
+            return &dh->tom_index;
+        case DATE_TUSR :
+            return &dh->tusr_index;
+        default :
+            return NULL;
     }
+}
 
-    while (temp_year) {
-        if (temp_year->year == year) {
-            break;
-        }
-        temp_year = temp_year->next;
+static time_node* get_time_node (linked_entry* entry, unsigned char mode) {
+    switch (mode) {
+        case DATE_TOD :
+            return &entry->tod_node;
+        case DATE_TOM :
+            return &entry->tom_node;
+        default :
+            return &entry->tusr_node;
     }
-    if (!temp_year) {
-        *result = 0;
-        return FIND_FAIL;
+}
+
+static int64_t get_entry_time (const linked_entry* entry, unsigned char mode) {
+    switch (mode) {
+        case DATE_TOD :
+            return entry->tod_utc;
+        case DATE_TOM :
+            return entry->tom_utc;
+        default :
+            return entry->tusr_utc;
     }
+}
 
-    temp_month = temp_year->month + month;
+// orders by time, then by obj_arr_index
+static int cmp_time_key (const linked_entry* a, const linked_entry* b, unsigned char mode) {
+    int64_t time_a = get_entry_time(a, mode);
+    int64_t time_b = get_entry_time(b, mode);
 
-    temp_day = temp_month->day + day;
+    if (time_a != time_b) {
+        return time_a < time_b ? -1 : 1;
+    }
 
-    temp_hour = temp_day->hour + hour;
+    if (a->obj_arr_index != b->obj_arr_index) {
+        return a->obj_arr_index < b->obj_arr_index ? -1 : 1;
+    }
 
-    *result = temp_hour->head;
     return 0;
 }
 
-/* Sub-branch search */
-int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head, field_record* rec, unsigned char only_examine_latest, field_match_bitmap* match_map, unsigned int score) {
-    sect_field* temp_sect;
+// entry ids are random, so are used as treap priority directly
+static uint64_t get_time_priority (const linked_entry* entry) {
+    uint64_t priority;
 
-    uint64_t i;
+    memcpy(&priority, entry->entry_id, sizeof(uint64_t));
 
-    bit_index bit_indx;
-    bit_index max_entry_map_length = 0;
+    return priority;
+}
 
-    unsigned int total_metric_num = 0;
-    unsigned int min_match_num;
-    unsigned int match_count;
+// returns the link pointing to target, or the null link target would take
+static linked_entry** find_time_link (linked_entry** link, const linked_entry* target, unsigned char mode) {
+    int order;
 
-    map_block temp_result;
+    while (*link && *link != target) {
+        order = cmp_time_key(target, *link, mode);
+        if (order == 0) {
+            break;
+        }
 
-    if (score > 100) {
-        return WRONG_ARGS;
+        link = order < 0 ? &get_time_node(*link, mode)->left : &get_time_node(*link, mode)->right;
     }
 
-    // match name
-    if (rec->field_usage_map & FIELD_REC_USE_E_NAME) {
-        lookup_file_name_part_map_via_dh(dh, rec->name, &match_map->map_buf1, &match_map->map_buf2);
+    return link;
+}
 
-        part_name_trans_map_to_entry_map(&dh->l2_fn_to_e_arr, &match_map->map_buf2, &match_map->map_name_match, rec->name);
+static int mark_time_range (linked_entry* cur, unsigned char mode, int64_t from, int64_t to, simple_bitmap* entry_map) {
+    int64_t time;
+    int ret;
 
-        if (match_map->map_name_match.length > max_entry_map_length) {
-            max_entry_map_length = match_map->map_name_match.length;
+    while (cur) {
+        time = get_entry_time(cur, mode);
+
+        if (time < from) {
+            cur = get_time_node(cur, mode)->right;
+            continue;
+        }
+        if (time > to) {
+            cur = get_time_node(cur, mode)->left;
+            continue;
         }
-        total_metric_num++;
-    }
 
-    // match time of addition
-    if (rec->field_usage_map & FIELD_REC_USE_E_TADD) {
-    }
+        ret = mark_time_range(get_time_node(cur, mode)->left, mode, from, to, entry_map);
+        if (ret) {
+            return ret;
+        }
 
-    // match time of modification
-    if (rec->field_usage_map & FIELD_REC_USE_E_TMOD) {
-    }
+        ret = ffp_grow_bitmap(entry_map, cur->obj_arr_index + 1);
+        if (ret) {
+            return ret;
+        }
+        bitmap_write(entry_map, cur->obj_arr_index, 1);
 
-    // match user specified time
-    if (rec->field_usage_map & FIELD_REC_USE_E_TMOD) {
+        cur = get_time_node(cur, mode)->right;
     }
 
-    // match tags
+    return 0;
+}
 
-    // match file size
-    if (rec->field_usage_map & FIELD_REC_USE_F_SIZE) {
-        lookup_file_name_part_map_via_dh(dh, rec->f_size, &match_map->map_buf1, &match_map->map_buf2);
+static int collect_time_range (linked_entry* cur, unsigned char mode, int64_t from, int64_t to, linked_entry** result_buf, bit_index buf_size, bit_index* num_used) {
+    int64_t time;
+    int ret;
 
-        part_f_size_trans_map_to_entry_map(&dh->l2_f_size_to_fd_arr, &match_map->map_buf2, &match_map->map_f_size_match, rec->f_size);
+    while (cur) {
+        time = get_entry_time(cur, mode);
 
-        if (match_map->map_f_size_match.length > max_entry_map_length) {
-            max_entry_map_length = match_map->map_f_size_match.length;
+        if (time < from) {
+            cur = get_time_node(cur, mode)->right;
+            continue;
+        }
+        if (time > to) {
+            cur = get_time_node(cur, mode)->left;
+            continue;
         }
-        total_metric_num++;
-    }
 
-    // match file sha1
-    if (rec->field_usage_map & FIELD_REC_USE_F_SHA1) {
-        lookup_file_sha1_part_map_via_dh(dh, rec->f_sha1, &match_map->map_buf1, &match_map->map_buf2);
+        ret = collect_time_range(get_time_node(cur, mode)->left, mode, from, to, result_buf, buf_size, num_used);
+        if (ret) {
+            return ret;
+        }
 
-        part_f_sha1_trans_map_to_entry_map(&dh->l2_sha1f_to_fd_arr, &match_map->map_buf2, &match_map->map_f_sha1_match, rec->f_sha1);
+        if (*num_used >= buf_size) {
+            return BUFFER_FULL;
+        }
+        result_buf[(*num_used)++] = cur;
+
+        cur = get_time_node(cur, mode)->right;
+    }
+
+    return 0;
+}
+
+/* entries with time in [from, to] in ascending order of time
+ * returns BUFFER_FULL if there are more than buf_size such entries
+ */
+int lookup_date_time (database_handle* dh, unsigned char date_type, int64_t from, int64_t to, linked_entry** result_buf, bit_index buf_size, bit_index* num_used) {
+    time_index* index;
+    int ret;
+
+    *num_used = 0;
+
+    index = get_time_index(dh, date_type);
+    if (!index) {
+        printf("lookup_date_time : invalid date type\n");
+        return WRONG_ARGS;
+    }
+
+    ret = collect_time_range(index->root, date_type, from, to, result_buf, buf_size, num_used);
+    if (ret) {
+        return ret;
+    }
+
+    if (*num_used == 0) {
+        return FIND_FAIL;
+    }
+
+    return 0;
+}
+
+/* marks obj_arr_index of entries with time in [from, to] in entry_map
+ * entry_map must be initialised, it is zeroed and grown as needed
+ */
+int lookup_date_time_map (database_handle* dh, unsigned char date_type, int64_t from, int64_t to, simple_bitmap* entry_map) {
+    time_index* index;
+
+    index = get_time_index(dh, date_type);
+    if (!index) {
+        printf("lookup_date_time_map : invalid date type\n");
+        return WRONG_ARGS;
+    }
+
+    bitmap_zero(entry_map);
+
+    return mark_time_range(index->root, date_type, from, to, entry_map);
+}
+
+/* Sub-branch search */
+int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head, field_record* rec, unsigned char only_examine_latest, field_match_bitmap* match_map, unsigned int score) {
+    sect_field* temp_sect;
+
+    uint64_t i;
+
+    bit_index bit_indx;
+    bit_index max_entry_map_length = 0;
+
+    unsigned int total_metric_num = 0;
+    unsigned int min_match_num;
+    unsigned int match_count;
+
+    map_block temp_result;
+
+    if (score > 100) {
+        return WRONG_ARGS;
+    }
+
+    // match name
+    if (rec->field_usage_map & FIELD_REC_USE_E_NAME) {
+        lookup_file_name_part_map_via_dh(dh, rec->name, &match_map->map_buf1, &match_map->map_buf2);
+
+        part_name_trans_map_to_entry_map(&dh->l2_fn_to_e_arr, &match_map->map_buf2, &match_map->map_name_match, rec->name);
+
+        if (match_map->map_name_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_name_match.length;
+        }
+        total_metric_num++;
+    }
+
+    // match time of addition
+    if (rec->field_usage_map & FIELD_REC_USE_E_TADD) {
+        lookup_date_time_map(dh, DATE_TOD, rec->tod_from, rec->tod_to, &match_map->map_tadd_match);
+
+        if (match_map->map_tadd_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_tadd_match.length;
+        }
+        total_metric_num++;
+    }
+
+    // match time of modification
+    if (rec->field_usage_map & FIELD_REC_USE_E_TMOD) {
+        lookup_date_time_map(dh, DATE_TOM, rec->tom_from, rec->tom_to, &match_map->map_tmod_match);
+
+        if (match_map->map_tmod_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_tmod_match.length;
+        }
+        total_metric_num++;
+    }
+
+    // match user specified time
+    if (rec->field_usage_map & FIELD_REC_USE_E_TUSR) {
+        lookup_date_time_map(dh, DATE_TUSR, rec->tusr_from, rec->tusr_to, &match_map->map_tusr_match);
+
+        if (match_map->map_tusr_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_tusr_match.length;
+        }
+        total_metric_num++;
+    }
+
+    // match tags
+
+    // match file size
+    if (rec->field_usage_map & FIELD_REC_USE_F_SIZE) {
+        lookup_file_size_part_map_via_dh(dh, rec->f_size, &match_map->map_buf1, &match_map->map_buf2);
+
+        part_f_size_trans_map_to_entry_map(&dh->l2_f_size_to_fd_arr, &match_map->map_buf2, &match_map->map_f_size_match, rec->f_size);
+
+        if (match_map->map_f_size_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_f_size_match.length;
+        }
+        total_metric_num++;
+    }
+
+    // match file sha1
+    if (rec->field_usage_map & FIELD_REC_USE_F_SHA1) {
+        lookup_file_sha1_part_map_via_dh(dh, rec->f_sha1, &match_map->map_buf1, &match_map->map_buf2);
+
+        part_f_sha1_trans_map_to_entry_map(&dh->l2_sha1f_to_fd_arr, &match_map->map_buf2, &match_map->map_f_sha1_match, rec->f_sha1);
 
         if (match_map->map_f_sha1_match.length > max_entry_map_length) {
             max_entry_map_length = match_map->map_f_sha1_match.length;
@@ -1157,6 +1226,18 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
         total_metric_num++;
     }
 
+    // match file merkle root
+    if (rec->field_usage_map & FIELD_REC_USE_F_MRKL) {
+        lookup_file_mrkl_part_map_via_dh(dh, rec->f_mrkl, &match_map->map_buf1, &match_map->map_buf2);
+
+        part_f_mrkl_trans_map_to_entry_map(&dh->l2_mrklf_to_fd_arr, &match_map->map_buf2, &match_map->map_f_mrkl_match, rec->f_mrkl);
+
+        if (match_map->map_f_mrkl_match.length > max_entry_map_length) {
+            max_entry_map_length = match_map->map_f_mrkl_match.length;
+        }
+        total_metric_num++;
+    }
+
     for (i = 0; i < rec->sect_field_in_use_num; i++) {
         temp_sect = rec->sect[i];
 
@@ -1164,7 +1245,7 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
         if (rec->field_usage_map & FIELD_REC_USE_S_SHA1) {
             lookup_sect_sha1_part_map_via_dh(dh, temp_sect->s_sha1, &match_map->map_buf1, &match_map->map_buf2);
 
-            part_s_sha1_trans_map_to_entry_map(&dh->l2_sha1s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha1_match, rec->f_sha1);
+            part_s_sha1_trans_map_to_entry_map(&dh->l2_sha1s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha1_match, temp_sect->s_sha1);
 
             if (match_map->map_s_sha1_match.length > max_entry_map_length) {
                 max_entry_map_length = match_map->map_s_sha1_match.length;
@@ -1176,7 +1257,7 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
         if (rec->field_usage_map & FIELD_REC_USE_S_SHA256) {
             lookup_sect_sha256_part_map_via_dh(dh, temp_sect->s_sha256, &match_map->map_buf1, &match_map->map_buf2);
 
-            part_s_sha256_trans_map_to_entry_map(&dh->l2_sha256s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha256_match, rec->f_sha256);
+            part_s_sha256_trans_map_to_entry_map(&dh->l2_sha256s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha256_match, temp_sect->s_sha256);
 
             if (match_map->map_s_sha256_match.length > max_entry_map_length) {
                 max_entry_map_length = match_map->map_s_sha256_match.length;
@@ -1188,7 +1269,7 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
         if (rec->field_usage_map & FIELD_REC_USE_S_SHA512) {
             lookup_sect_sha512_part_map_via_dh(dh, temp_sect->s_sha512, &match_map->map_buf1, &match_map->map_buf2);
 
-            part_s_sha512_trans_map_to_entry_map(&dh->l2_sha512s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha512_match, rec->f_sha512);
+            part_s_sha512_trans_map_to_entry_map(&dh->l2_sha512s_to_s_arr, &match_map->map_buf2, &match_map->map_s_sha512_match, temp_sect->s_sha512);
 
             if (match_map->map_s_sha512_match.length > max_entry_map_length) {
                 max_entry_map_length = match_map->map_s_sha512_match.length;
@@ -1201,6 +1282,9 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
     min_match_num = (score * total_metric_num  + (100 / 2)) / 100;  // rounding to nearest integer
 
     // set all to 0
+    if (ffp_grow_bitmap(&match_map->map_result, max_entry_map_length)) {
+        return MALLOC_FAIL;
+    }
     bitmap_zero(&match_map->map_result);
 
     // filter out entry with high enough matching metrics
@@ -1217,6 +1301,36 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
             }
         }
 
+        // check time of addition bitmap
+        if (rec->field_usage_map & FIELD_REC_USE_E_TADD) {
+            if (bit_indx <= match_map->map_tadd_match.length - 1) {
+                bitmap_read(&match_map->map_tadd_match, bit_indx, &temp_result);
+                if (temp_result) {
+                    match_count++;
+                }
+            }
+        }
+
+        // check time of modification bitmap
+        if (rec->field_usage_map & FIELD_REC_USE_E_TMOD) {
+            if (bit_indx <= match_map->map_tmod_match.length - 1) {
+                bitmap_read(&match_map->map_tmod_match, bit_indx, &temp_result);
+                if (temp_result) {
+                    match_count++;
+                }
+            }
+        }
+
+        // check user specified time bitmap
+        if (rec->field_usage_map & FIELD_REC_USE_E_TUSR) {
+            if (bit_indx <= match_map->map_tusr_match.length - 1) {
+                bitmap_read(&match_map->map_tusr_match, bit_indx, &temp_result);
+                if (temp_result) {
+                    match_count++;
+                }
+            }
+        }
+
         // check file size bitmap
         if (rec->field_usage_map & FIELD_REC_USE_F_SIZE) {
             if (bit_indx <= match_map->map_f_size_match.length - 1) {
@@ -1257,6 +1371,16 @@ int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head,
             }
         }
 
+        // check file merkle root bitmap
+        if (rec->field_usage_map & FIELD_REC_USE_F_MRKL) {
+            if (bit_indx <= match_map->map_f_mrkl_match.length - 1) {
+                bitmap_read(&match_map->map_f_mrkl_match, bit_indx, &temp_result);
+                if (temp_result) {
+                    match_count++;
+                }
+            }
+        }
+
         // check section sha1 bitmap
         if (rec->field_usage_map & FIELD_REC_USE_S_SHA1) {
             if (bit_indx <= match_map->map_s_sha1_match.length - 1) {
@@ -1303,16 +1427,18 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
     bit_index temp_index_result2;
     bit_index temp_index_skip_to2;
     bit_index i, j, ret;
+    uint32_t k;
 
     bit_index temp_num_used = 0;
 
     layer1_fn_to_e_arr* temp_l1_arr;
 
     linked_entry* temp_entry;
-    linked_entry* temp_entry_find;
 
     t_fn_to_e* fn_to_e;
 
+    child_cursor cursor;
+
     if (buf_size == 0) {
         return WRONG_ARGS;
     }
@@ -1328,13 +1454,26 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
     }
 
     // try to use hash table first
-    lookup_file_name_via_dh(dh, file_name, &temp_entry_find);
-    if (temp_entry_find) {  // found exact match
+    lookup_file_name_via_dh(dh, file_name, &fn_to_e);
+    if (fn_to_e) {  // found exact match
+        // go with child index if parent has one
+        if (parent->child_idx) {
+            child_cursor_init(&cursor, parent, fn_to_e->id);
+            while (child_cursor_next(&cursor, &temp_entry) == 0) {
+                result_buf[temp_num_used] = temp_entry;
+                temp_num_used++;
+
+                if (temp_num_used == buf_size) {
+                    *num_used = temp_num_used;
+                    return BUFFER_FULL;
+                }
+            }
+        }
         // pick option with lower number to search linearly
-        if (temp_entry_find->fn_to_e->number < parent->child_num) {
-            // do a sequential search on chain of entries with same name
-            temp_entry = temp_entry_find->fn_to_e->head_tar;
-            while (temp_entry) {
+        else if (fn_to_e->tar_num < parent->child_num) {
+            // do a sequential search on entries with same name
+            for (i = 0; i < fn_to_e->tar_num; i++) {
+                temp_entry = fn_to_e->tar[i];
                 if (temp_entry->parent == parent) {
                     result_buf[temp_num_used] = temp_entry;
                     temp_num_used++;
@@ -1344,14 +1483,13 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
                         return BUFFER_FULL;
                     }
                 }
-                temp_entry = temp_entry->next_same_fn;
             }
         }
         else {
-            // do a sequential search on children
+            // do a sequential search on children, names are interned so ids can be compared
             for (i = 0; i < parent->child_num; i++) {
                 temp_entry = parent->child[i];
-                if (strcmp(temp_entry->file_name, file_name) == 0) {
+                if (temp_entry->file_name_id == fn_to_e->id) {
                     result_buf[temp_num_used] = temp_entry;
                     temp_num_used++;
 
@@ -1397,8 +1535,8 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
 
                     fn_to_e = temp_l1_arr->arr + temp_index_result2;
                     if (strstr(fn_to_e->str, file_name)) {
-                        temp_entry = fn_to_e->head_tar;
-                        while (temp_entry) {
+                        for (k = 0; k < fn_to_e->tar_num; k++) {
+                            temp_entry = fn_to_e->tar[k];
                             if (temp_entry->parent == parent) {
                                 result_buf[temp_num_used] = temp_entry;
                                 temp_num_used++;
@@ -1408,8 +1546,6 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
                                     return BUFFER_FULL;
                                 }
                             }
-
-                            temp_entry = temp_entry->next_same_fn;
                         }
                     }
                 }
@@ -1439,21 +1575,20 @@ int find_children_via_file_name(database_handle* dh, simple_bitmap* map_buf, sim
 }
 
 int find_children_via_entry_id_part(database_handle* dh, simple_bitmap* map_buf, simple_bitmap* map_buf2, char* entry_id, linked_entry* parent, linked_entry** result_buf, bit_index buf_size, bit_index* num_used) {
-    bit_index temp_map_length;
-    map_block* temp_map_raw;
-    bit_index temp_index_result;
-    bit_index temp_index_skip_to;
-    bit_index temp_index_result2;
-    bit_index temp_index_skip_to2;
-    bit_index i, j, ret;
+    digest_cursor cursor;
 
-    bit_index temp_num_used = 0;
+    unsigned char prefix[EID_LEN];
+    uint32_t prefix_bits;
+    uint64_t expected_num;
 
-    layer1_eid_to_e_arr* temp_l1_arr;
+    bit_index i;
+
+    bit_index temp_num_used = 0;
 
     linked_entry* temp_entry;
     linked_entry* temp_entry_find;
 
+    void* temp_obj;
     t_eid_to_e* eid_to_e;
 
     if (buf_size == 0) {
@@ -1487,80 +1622,27 @@ int find_children_via_entry_id_part(database_handle* dh, simple_bitmap* map_buf,
         }
     }
     else {  // no exact match
-        // grow map_buf if necessary
-        temp_map_length = dh->l2_eid_to_e_arr.l1_arr_map.length;
-        if (temp_map_length > map_buf->length) {
-            if (        get_bitmap_map_block_number(temp_map_length)
-                    !=  get_bitmap_map_block_number(map_buf->length)
-               )
-            {
-                temp_map_raw =
-                    realloc(
-                            map_buf->base,
-                            get_bitmap_map_block_number(temp_map_length)
-                            * sizeof(map_block)
-                           );
-                if (!temp_map_raw) {
-                    return MALLOC_FAIL;
-                }
-            }
-            bitmap_grow(map_buf, temp_map_raw, 0, temp_map_length, 0);
-        }
-
-        // grow map_buf2 if necessary
-        if (temp_map_length > map_buf2->length) {
-            if (        get_bitmap_map_block_number(temp_map_length)
-                    !=  get_bitmap_map_block_number(map_buf2->length)
-               )
-            {
-                temp_map_raw =
-                    realloc(
-                            map_buf2->base,
-                            get_bitmap_map_block_number(temp_map_length)
-                            * sizeof(map_block)
-                           );
-                if (!temp_map_raw) {
-                    return MALLOC_FAIL;
-                }
-            }
-            bitmap_grow(map_buf2, temp_map_raw, 0, temp_map_length, 0);
-        }
-
-        ret = lookup_entry_id_part_map_via_dh(dh, entry_id, map_buf, map_buf2);
-        if (ret) {
-            return ret;
+        if (hex_to_digest_prefix(prefix, &prefix_bits, entry_id, EID_LEN)) {
+            return 0;   // not a prefix of any entry id
         }
 
         /* choose option with lower cost */
-        // go with bitmap based searching
-        if (map_buf2->number_of_ones * L1_EID_TO_E_ARR_SIZE <= parent->child_num) {
-            temp_index_skip_to = 0;
-            for (i = 0, temp_index_skip_to = 0; i < map_buf2->number_of_ones; i++) {
-                // get index of L1 array that contains matching entries
-                bitmap_first_one_bit_index(map_buf2, &temp_index_result, temp_index_skip_to);
-                temp_index_skip_to = temp_index_result + 1;
-
-                // get the L1 array
-                get_l1_eid_to_e_from_layer2_arr(&dh->l2_eid_to_e_arr, &temp_l1_arr, temp_index_result);
-
-                // go through the L1 array to find entries with exact matching string
-                for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
-                    // get index of entry to get
-                    bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
-                    temp_index_skip_to2 = temp_index_result2 + 1;
-
-                    eid_to_e = temp_l1_arr->arr + temp_index_result2;
-                    if (strstr(eid_to_e->str, entry_id)) {
-                        temp_entry = eid_to_e->tar;
-                        if (temp_entry->parent == parent) {
-                            result_buf[temp_num_used] = temp_entry;
-                            temp_num_used++;
+        // entry ids are random, so each hex digit divides the matches by 16
+        expected_num = prefix_bits < 64 ? dh->eid_digest.num >> prefix_bits : 0;
+        // go with digest index
+        if (expected_num <= parent->child_num) {
+            digest_cursor_init(&cursor, &dh->eid_digest, prefix, prefix_bits);
+
+            while (digest_cursor_next(&cursor, &temp_obj) == 0) {
+                eid_to_e = temp_obj;
+                temp_entry = eid_to_e->tar;
+                if (temp_entry->parent == parent) {
+                    result_buf[temp_num_used] = temp_entry;
+                    temp_num_used++;
 
-                            if (temp_num_used == buf_size) { // buf_size guaranteed to be larger than zero at this point, due to input check
-                                *num_used = temp_num_used;
-                                return BUFFER_FULL;
-                            }
-                        }
+                    if (temp_num_used == buf_size) { // buf_size guaranteed to be larger than zero at this point, due to input check
+                        *num_used = temp_num_used;
+                        return BUFFER_FULL;
                     }
                 }
             }
@@ -1569,7 +1651,7 @@ int find_children_via_entry_id_part(database_handle* dh, simple_bitmap* map_buf,
         else {
             for (i = 0; i < parent->child_num; i++) {
                 temp_entry = parent->child[i];
-                if (strstr(temp_entry->entry_id_str, entry_id)) {
+                if (match_digest_prefix(temp_entry->entry_id, prefix, prefix_bits)) {
                     result_buf[temp_num_used] = temp_entry;
                     temp_num_used++;
 
@@ -1627,13 +1709,12 @@ int set_new_entry_id(database_handle* dh, linked_entry* entry) {
     linked_entry* temp_entry_find;
 
     unsigned char eid[EID_LEN];
-    char eid_str[EID_STR_MAX+1];
 
     do {
-        gen_entry_id(eid, eid_str);
+        gen_entry_id(eid, NULL);
 
         // check for collision
-        lookup_entry_id_via_dh(dh, eid_str, &temp_entry_find);
+        lookup_entry_id_key_via_dh(dh, eid, &temp_entry_find);
 
         count++;
     } while (temp_entry_find && count < ID_GEN_MAX_TRIES);
@@ -1645,7 +1726,6 @@ int set_new_entry_id(database_handle* dh, linked_entry* entry) {
     for (i = 0; i < EID_LEN; i++) {
         entry->entry_id[i] = eid[i];
     }
-    strcpy(entry->entry_id_str, eid_str);
 
     return 0;
 }
@@ -1654,7 +1734,6 @@ int set_entry_general_info(database_handle* dh, linked_entry* entry) {
     int i;
 
     time_t raw_time;
-    struct tm* time_info;
 
     // set has parent flag
     if (entry->parent == &dh->tree) {
@@ -1670,14 +1749,12 @@ int set_entry_general_info(database_handle* dh, linked_entry* entry) {
         for (i = 0; i < EID_LEN; i++) {
             entry->branch_id[i] = entry->parent->branch_id[i];
         }
-        strcpy(entry->branch_id_str, entry->parent->branch_id_str);
     }
     else {
         // fill in branch id using entry id
         for (i = 0; i < EID_LEN; i++) {
             entry->branch_id[i] = entry->entry_id[i];
         }
-        strcpy(entry->branch_id_str, entry->entry_id_str);
     }
 
     // set depth
@@ -1685,25 +1762,14 @@ int set_entry_general_info(database_handle* dh, linked_entry* entry) {
 
     // get current time
     time(&raw_time);
-    time_info = gmtime(&raw_time);
 
     // set time of addition
-    memcpy(
-            &entry->tod_utc,
-            time_info,
-
-            sizeof(struct tm)
-          );
+    entry->tod_utc = raw_time;
 
     link_entry_to_date_time_tree(dh, entry, DATE_TOD);
 
     // set time of modification
-    memcpy(
-            &entry->tom_utc,
-            time_info,
-
-            sizeof(struct tm)
-          );
+    entry->tom_utc = raw_time;
 
     link_entry_to_date_time_tree(dh, entry, DATE_TOM);
 
@@ -1861,12 +1927,12 @@ int link_entry_to_entry_id_structures(database_handle* dh, linked_entry* target)
     // add entry to eid_to_entry hashtable
     add_eid_to_e_to_layer2_arr(&dh->l2_eid_to_e_arr, &temp_eid_to_e, &temp_index);
     init_eid_to_e(temp_eid_to_e);
-    strcpy(temp_eid_to_e->str, target->entry_id_str);
+    memcpy(temp_eid_to_e->key, target->entry_id, EID_LEN);
     temp_eid_to_e->tar = target;
     verify_eid_to_e(temp_eid_to_e, &verify_error_code, 0);
     add_eid_to_e_to_htab(&dh->eid_to_e, temp_eid_to_e);
-    // add entry to existence matrix
-    add_eid_to_eid_exist_mat(&dh->eid_mat, temp_eid_to_e->str, temp_index);
+    // add entry to digest index
+    add_eid_to_eid_digest_index(&dh->eid_digest, temp_eid_to_e);
     // link translation structure to entry
     target->eid_to_e = temp_eid_to_e;
 
@@ -1891,6 +1957,8 @@ int unlink_entry_from_entry_id_structures(database_handle* dh, linked_entry* tar
 
     // delete from hashtable
     del_eid_to_e_from_htab(&dh->eid_to_e, temp_eid_to_e);
+    // delete from digest index
+    del_eid_from_eid_digest_index(&dh->eid_digest, &dh->l2_eid_to_e_arr, temp_eid_to_e->obj_arr_index);
     // delete from layer 2 array
     del_eid_to_e_from_layer2_arr(&dh->l2_eid_to_e_arr, temp_eid_to_e->obj_arr_index);
 
@@ -1902,851 +1970,1181 @@ int unlink_entry_from_entry_id_structures(database_handle* dh, linked_entry* tar
 
 // link entry to file name related structures
 int link_entry_to_file_name_structures(database_handle* dh, linked_entry* target) {
-    linked_entry* temp_entry_find;
     bit_index temp_index;
     t_fn_to_e* temp_fn_to_e;
-    int verify_error_code;
 
-    lookup_file_name_via_dh(dh, target->file_name, &temp_entry_find);
-    if (!temp_entry_find) {   // no entry with same file name found
+    lookup_file_name_id_via_dh(dh, target->file_name_id, &temp_fn_to_e);
+    if (!temp_fn_to_e) {   // no entry with same file name found
         // add file name to layer 2 array
         add_fn_to_e_to_layer2_arr(&dh->l2_fn_to_e_arr, &temp_fn_to_e, &temp_index);
         init_fn_to_e(temp_fn_to_e);
-        strcpy(temp_fn_to_e->str, target->file_name);
-        temp_fn_to_e->head_tar = target;
-        temp_fn_to_e->tail_tar = target;
-        temp_fn_to_e->number = 1;
-        verify_fn_to_e(temp_fn_to_e, &verify_error_code, GO_THROUGH_CHAIN);
+        temp_fn_to_e->id = target->file_name_id;
+        temp_fn_to_e->str = target->file_name;
+        temp_fn_to_e->str_len = target->file_name_len;
         add_fn_to_e_to_htab(&dh->fn_to_e, temp_fn_to_e);
-        // add file name to existence matrix
-        add_fn_to_fn_exist_mat(&dh->fn_mat, temp_fn_to_e->str, temp_index);
-        // link translation structure to entry
-        target->fn_to_e = temp_fn_to_e;
-    }
-    else {      // found entry with same file name, add to chain
-        add_e_to_fn_to_e_chain(temp_entry_find, target);
+        // add file name to gram index
+        add_fn_to_fn_gram_index(&dh->fn_gram, temp_fn_to_e->str, temp_index);
     }
 
-    return 0;
+    return add_e_to_fn_to_e_postings(temp_fn_to_e, target);
 }
 
 int link_entry_to_tag_str_structures(database_handle* dh, linked_entry* target) {
-    linked_entry* temp_entry_find;
     bit_index temp_index;
     t_tag_to_e* temp_tag_to_e;
-    int verify_error_code;
 
-    lookup_tag_str_via_dh(dh, target->tag_str, &temp_entry_find);
-    if (!temp_entry_find) {     // no entry with same tag string found
+    lookup_tag_str_id_via_dh(dh, target->tag_str_id, &temp_tag_to_e);
+    if (!temp_tag_to_e) {     // no entry with same tag string found
         // add tag string to layer 2 array
         add_tag_to_e_to_layer2_arr(&dh->l2_tag_to_e_arr, &temp_tag_to_e, &temp_index);
         init_tag_to_e(temp_tag_to_e);
-        strcpy(temp_tag_to_e->str, target->tag_str);
-        temp_tag_to_e->head_tar = target;
-        temp_tag_to_e->tail_tar = target;
-        temp_tag_to_e->number = 1;
-        verify_tag_to_e(temp_tag_to_e, &verify_error_code, GO_THROUGH_CHAIN);
+        temp_tag_to_e->id = target->tag_str_id;
+        temp_tag_to_e->str = target->tag_str;
+        temp_tag_to_e->str_len = target->tag_str_len;
         add_tag_to_e_to_htab(&dh->tag_to_e, temp_tag_to_e);
-        // add tag string to existence matrix
-        add_tag_to_tag_exist_mat(&dh->tag_mat, temp_tag_to_e->str, temp_index);
-        // link translation structure to entry
-        target->tag_to_e = temp_tag_to_e;
-    }
-    else {      // found entry with same tag string, add to tail
-        add_e_to_tag_to_e_chain(temp_entry_find, target);
+        // add tag string to gram index
+        add_tag_to_tag_gram_index(&dh->tag_gram, temp_tag_to_e->str, temp_index);
     }
 
-    return 0;
+    return add_e_to_tag_to_e_postings(temp_tag_to_e, target);
 }
 
 int link_entry_to_date_time_tree(database_handle* dh, linked_entry* target, unsigned char mode) {
-    dtt_year* temp_year;
-    dtt_year* temp_year_backup;
-    dtt_month* temp_month;
-    dtt_day* temp_day;
-    dtt_hour* temp_hour;
+    time_index* index;
+    time_node* node;
 
-    dtt_year* dtt;
-    struct tm* tar_time;
-
-    time_t raw_time;
-    struct tm* time_info;
-
-    linked_entry* temp_entry_find;
-    linked_entry* temp_entry_find_backup;
+    linked_entry** link;
+    linked_entry** left;
+    linked_entry** right;
+    linked_entry* cur;
 
-    int i;
+    uint64_t priority;
 
-    if (        mode != DATE_TOD
-            &&  mode != DATE_TOM
-            &&  mode != DATE_TUSR
-       )
-    {
+    index = get_time_index(dh, mode);
+    if (!index) {
         return WRONG_ARGS;
     }
 
     switch (mode) {
         case DATE_TOD :
-            tar_time = &target->tod_utc;
+            target->tod_utc_used = 1;
             break;
         case DATE_TOM :
-            tar_time = &target->tom_utc;
+            target->tom_utc_used = 1;
             break;
         case DATE_TUSR :
-            tar_time = &target->tusr_utc;
+            target->tusr_utc_used = 1;
             break;
-        default :
-            return LOGIC_ERROR;
     }
 
-    if ((raw_time = timegm(tar_time)) == -1) {
-        return INVALID_DATE;
+    // already linked
+    if (*find_time_link(&index->root, target, mode) == target) {
+        return 0;
     }
-    time_info = gmtime(&raw_time);
-    memcpy(
-            tar_time,
-            time_info,
-
-            sizeof(struct tm)
-          );
 
-    // deal with year
-    if (        mode == DATE_TOD    &&  !dh->tod_dt_tree    ) {
-        add_dtt_year_to_layer2_arr(&dh->l2_dtt_year_arr, &dtt, NULL);
-        dh->tod_dt_tree = dtt;
-        dtt->year = tar_time->tm_year + 1900;
-        temp_year = dtt;
+    // go down to where target's priority puts it
+    priority = get_time_priority(target);
+    link = &index->root;
+    while (*link && get_time_priority(*link) >= priority) {
+        if (cmp_time_key(target, *link, mode) < 0) {
+            link = &get_time_node(*link, mode)->left;
+        }
+        else {
+            link = &get_time_node(*link, mode)->right;
+        }
     }
-    else if (   mode == DATE_TOM    &&  !dh->tom_dt_tree   ) {
-        add_dtt_year_to_layer2_arr(&dh->l2_dtt_year_arr, &dtt, NULL);
-        dh->tom_dt_tree = dtt;
-        dtt->year = tar_time->tm_year + 1900;
-        temp_year = dtt;
+
+    // split subtree there into entries before and after target
+    node = get_time_node(target, mode);
+    cur = *link;
+    left = &node->left;
+    right = &node->right;
+    while (cur) {
+        if (cmp_time_key(cur, target, mode) < 0) {
+            *left = cur;
+            left = &get_time_node(cur, mode)->right;
+            cur = *left;
+        }
+        else {
+            *right = cur;
+            right = &get_time_node(cur, mode)->left;
+            cur = *right;
+        }
     }
-    else if (   mode == DATE_TUSR   &&  !dh->tusr_dt_tree   ) {
-        add_dtt_year_to_layer2_arr(&dh->l2_dtt_year_arr, &dtt, NULL);
-        dh->tusr_dt_tree = dtt;
-        dtt->year = tar_time->tm_year + 1900;
-        temp_year = dtt;
+    *left = NULL;
+    *right = NULL;
+
+    *link = target;
+
+    index->num++;
+
+    return 0;
+}
+
+int unlink_entry_from_date_time_tree(database_handle* dh, linked_entry* target, unsigned char mode) {
+    time_index* index;
+    time_node* node;
+
+    linked_entry** link;
+    linked_entry* left;
+    linked_entry* right;
+
+    index = get_time_index(dh, mode);
+    if (!index) {
+        return WRONG_ARGS;
     }
-    else {
-        switch (mode) {
-            case DATE_TOD :
-                dtt = dh->tod_dt_tree;
-                break;
-            case DATE_TOM :
-                dtt = dh->tom_dt_tree;
-                break;
-            case DATE_TUSR :
-                dtt = dh->tusr_dt_tree;
-                break;
-            default :
-                return LOGIC_ERROR;
-        }
 
-        temp_year = dtt;
-        while (temp_year) {
-            if (temp_year->year == tar_time->tm_year + 1900) {
-                break;
-            }
+    link = find_time_link(&index->root, target, mode);
+    if (*link != target) {      // not previously linked
+        return 0;
+    }
 
-            temp_year_backup = temp_year;
-            temp_year = temp_year->next;
+    // merge subtrees of target in its place
+    node = get_time_node(target, mode);
+    left = node->left;
+    right = node->right;
+    while (left && right) {
+        if (get_time_priority(left) > get_time_priority(right)) {
+            *link = left;
+            link = &get_time_node(left, mode)->right;
+            left = *link;
         }
-        if (!temp_year) {
-            temp_year = temp_year_backup;
-        }
-        if (temp_year->year != tar_time->tm_year + 1900) {
-            add_dtt_year_to_layer2_arr(&dh->l2_dtt_year_arr, &temp_year->next, NULL);
-            temp_year = temp_year->next;
-
-            temp_year->year = tar_time->tm_year + 1900;
-            temp_year->next = NULL;
-            for (i = 0; i < 12; i++) {
-                temp_year->month[i].in_use = 0;
-            }
+        else {
+            *link = right;
+            link = &get_time_node(right, mode)->left;
+            right = *link;
         }
     }
+    *link = left ? left : right;
 
-    // deal with month
-    temp_month = temp_year->month + tar_time->tm_mon;
-    temp_month->in_use = 1;
+    node->left = NULL;
+    node->right = NULL;
 
-    // deal with day
-    temp_day = temp_month->day + tar_time->tm_mday;
-    temp_day->in_use = 1;
+    index->num--;
 
-    // deal with hour
-    temp_hour = temp_day->hour + tar_time->tm_hour;
-    if (!temp_hour->in_use) {
-        temp_hour->head = target;
+    return 0;
+}
 
-        switch (mode) {
-            case DATE_TOD :
-                target->tod_prev_sort_min = NULL;
-                target->tod_next_sort_min = NULL;
-                break;
-            case DATE_TOM :
-                target->tom_prev_sort_min = NULL;
-                target->tom_next_sort_min = NULL;
-                break;
-            case DATE_TUSR :
-                target->tusr_prev_sort_min = NULL;
-                target->tusr_next_sort_min = NULL;
-                break;
-            default :
-                return LOGIC_ERROR;
-        }
+int link_file_data_to_file_size_structures(database_handle* dh, file_data* target) {
+    bit_index temp_index;
+    t_f_size_to_fd* temp_f_size_to_fd;
+    char file_size_str_buf[FILE_SIZE_STR_MAX+1];
 
-        temp_hour->in_use = 1;
-    }
-    else {
-        temp_entry_find = temp_hour->head;
-        temp_entry_find_backup = temp_entry_find;
-
-        switch (mode) {
-            case DATE_TOD :
-                while (temp_entry_find) {
-                    if (temp_entry_find->tod_utc.tm_min > target->tod_utc.tm_min) {
-                        temp_entry_find_backup->tod_next_sort_min = target;
-                        target->tod_prev_sort_min = temp_entry_find_backup;
-                        target->tod_next_sort_min = temp_entry_find;
-                        temp_entry_find->tod_prev_sort_min = target;
-                        break;
-                    }
-                    temp_entry_find_backup = temp_entry_find;
-                    temp_entry_find = temp_entry_find->tod_next_sort_min;
-                }
-                if (!temp_entry_find) {
-                    temp_entry_find_backup->tod_next_sort_min = target;
-                    target->tod_prev_sort_min = temp_entry_find_backup;
-                    target->tod_next_sort_min = NULL;
-                }
+    // convert file size into string
+    strfy_sprintf(file_size_str_buf, FILE_SIZE_STR_MAX, PRIu64, target->file_size);
+
+    lookup_file_size_via_dh(dh, file_size_str_buf, &temp_f_size_to_fd);
+    if (!temp_f_size_to_fd) {   // no file data with same file size found
+        // add file size to layer 2 array
+        add_f_size_to_fd_to_layer2_arr(&dh->l2_f_size_to_fd_arr, &temp_f_size_to_fd, &temp_index);
+        init_f_size_to_fd(temp_f_size_to_fd);
+        strcpy(temp_f_size_to_fd->str, file_size_str_buf);
+        add_f_size_to_fd_to_htab(&dh->f_size_to_fd, temp_f_size_to_fd);
+        // add file size to gram index
+        add_f_size_to_f_size_gram_index(&dh->f_size_gram, temp_f_size_to_fd->str, temp_index);
+    }
+
+    return add_fd_to_f_size_to_fd_postings(temp_f_size_to_fd, target);
+}
+
+int link_file_data_to_sha1_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
+    bit_index temp_index;
+    t_sha1f_to_fd* temp_sha1f_to_fd;
+
+    lookup_file_sha1_key_via_dh(dh, target_checksum_result->checksum, &temp_sha1f_to_fd);
+    if (!temp_sha1f_to_fd) {     // no file data with same checksum
+        // add whole file checksum to layer 2 array
+        add_sha1f_to_fd_to_layer2_arr(&dh->l2_sha1f_to_fd_arr, &temp_sha1f_to_fd, &temp_index);
+        init_sha1f_to_fd(temp_sha1f_to_fd);
+        memcpy(temp_sha1f_to_fd->key, target_checksum_result->checksum, SHA_DIGEST_LENGTH);
+        add_sha1f_to_fd_to_htab(&dh->sha1f_to_fd, temp_sha1f_to_fd);
+        // add whole file checksum to digest index
+        add_sha1f_to_sha1f_digest_index(&dh->sha1f_digest, temp_sha1f_to_fd);
+    }
+
+    return add_fd_to_sha1f_to_fd_postings(temp_sha1f_to_fd, target);
+}
+
+int link_file_data_to_sha256_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
+    bit_index temp_index;
+    t_sha256f_to_fd* temp_sha256f_to_fd;
+
+    lookup_file_sha256_key_via_dh(dh, target_checksum_result->checksum, &temp_sha256f_to_fd);
+    if (!temp_sha256f_to_fd) {     // no file data with same checksum
+        // add whole file checksum to layer 2 array
+        add_sha256f_to_fd_to_layer2_arr(&dh->l2_sha256f_to_fd_arr, &temp_sha256f_to_fd, &temp_index);
+        init_sha256f_to_fd(temp_sha256f_to_fd);
+        memcpy(temp_sha256f_to_fd->key, target_checksum_result->checksum, SHA256_DIGEST_LENGTH);
+        add_sha256f_to_fd_to_htab(&dh->sha256f_to_fd, temp_sha256f_to_fd);
+        // add whole file checksum to digest index
+        add_sha256f_to_sha256f_digest_index(&dh->sha256f_digest, temp_sha256f_to_fd);
+    }
+
+    return add_fd_to_sha256f_to_fd_postings(temp_sha256f_to_fd, target);
+}
+
+int link_file_data_to_sha512_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
+    bit_index temp_index;
+    t_sha512f_to_fd* temp_sha512f_to_fd;
+
+    lookup_file_sha512_key_via_dh(dh, target_checksum_result->checksum, &temp_sha512f_to_fd);
+    if (!temp_sha512f_to_fd) {     // no file data with same checksum
+        // add whole file checksum to layer 2 array
+        add_sha512f_to_fd_to_layer2_arr(&dh->l2_sha512f_to_fd_arr, &temp_sha512f_to_fd, &temp_index);
+        init_sha512f_to_fd(temp_sha512f_to_fd);
+        memcpy(temp_sha512f_to_fd->key, target_checksum_result->checksum, SHA512_DIGEST_LENGTH);
+        add_sha512f_to_fd_to_htab(&dh->sha512f_to_fd, temp_sha512f_to_fd);
+        // add whole file checksum to digest index
+        add_sha512f_to_sha512f_digest_index(&dh->sha512f_digest, temp_sha512f_to_fd);
+    }
+
+    return add_fd_to_sha512f_to_fd_postings(temp_sha512f_to_fd, target);
+}
+
+int link_file_data_to_mrkl_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
+    bit_index temp_index;
+    t_mrklf_to_fd* temp_mrklf_to_fd;
+
+    lookup_file_mrkl_key_via_dh(dh, target_checksum_result->checksum, &temp_mrklf_to_fd);
+    if (!temp_mrklf_to_fd) {     // no file data with same checksum
+        // add whole file checksum to layer 2 array
+        add_mrklf_to_fd_to_layer2_arr(&dh->l2_mrklf_to_fd_arr, &temp_mrklf_to_fd, &temp_index);
+        init_mrklf_to_fd(temp_mrklf_to_fd);
+        memcpy(temp_mrklf_to_fd->key, target_checksum_result->checksum, MRKL_DIGEST_LENGTH);
+        add_mrklf_to_fd_to_htab(&dh->mrklf_to_fd, temp_mrklf_to_fd);
+        // add whole file checksum to digest index
+        add_mrklf_to_mrklf_digest_index(&dh->mrklf_digest, temp_mrklf_to_fd);
+    }
+
+    return add_fd_to_mrklf_to_fd_postings(temp_mrklf_to_fd, target);
+}
+
+int link_file_data_to_checksum_structures(database_handle* dh, file_data* target) {
+    checksum_result* target_checksum_result;
+    int i;
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        target_checksum_result = target->checksum + i;
+
+        switch (target_checksum_result->type) {
+            case CHECKSUM_UNUSED :
+                // do nothing
                 break;
-            case DATE_TOM :
-                while (temp_entry_find) {
-                    if (temp_entry_find->tom_utc.tm_min > target->tom_utc.tm_min) {
-                        temp_entry_find_backup->tom_next_sort_min = target;
-                        target->tom_prev_sort_min = temp_entry_find_backup;
-                        target->tom_next_sort_min = temp_entry_find;
-                        temp_entry_find->tom_prev_sort_min = target;
-                        break;
-                    }
-                    temp_entry_find_backup = temp_entry_find;
-                    temp_entry_find = temp_entry_find->tom_next_sort_min;
-                }
-                if (!temp_entry_find) {
-                    temp_entry_find_backup->tom_next_sort_min = target;
-                    target->tom_prev_sort_min = temp_entry_find_backup;
-                    target->tom_next_sort_min = NULL;
-                }
+            case CHECKSUM_SHA1_ID:
+                link_file_data_to_sha1_structures(dh, target, target_checksum_result);
                 break;
-            case DATE_TUSR :
-                while (temp_entry_find) {
-                    if (temp_entry_find->tusr_utc.tm_min > target->tusr_utc.tm_min) {
-                        temp_entry_find_backup->tusr_next_sort_min = target;
-                        target->tusr_prev_sort_min = temp_entry_find_backup;
-                        target->tusr_next_sort_min = temp_entry_find;
-                        temp_entry_find->tusr_prev_sort_min = target;
-                        break;
-                    }
-                    temp_entry_find_backup = temp_entry_find;
-                    temp_entry_find = temp_entry_find->tusr_next_sort_min;
-                }
-                if (!temp_entry_find) {
-                    temp_entry_find_backup->tusr_next_sort_min = target;
-                    target->tusr_prev_sort_min = temp_entry_find_backup;
-                    target->tusr_next_sort_min = NULL;
-                }
+            case CHECKSUM_SHA256_ID :
+                link_file_data_to_sha256_structures(dh, target, target_checksum_result);
                 break;
-            default :
+            case CHECKSUM_SHA512_ID :
+                link_file_data_to_sha512_structures(dh, target, target_checksum_result);
+                break;
+            case CHECKSUM_MRKL_ID :
+                link_file_data_to_mrkl_structures(dh, target, target_checksum_result);
+                break;
+            default:
                 return LOGIC_ERROR;
         }
     }
 
-    switch (mode) {
-        case DATE_TOD :
-            target->tod_hour = temp_hour;
-            target->tod_utc_used = 1;
-            break;
-        case DATE_TOM :
-            target->tom_hour = temp_hour;
-            target->tom_utc_used = 1;
-            break;
-        case DATE_TUSR :
-            target->tusr_hour = temp_hour;
-            target->tusr_utc_used = 1;
-            break;
-        default :
-            return LOGIC_ERROR;
+    return 0;
+}
+
+int link_file_data_to_pending_queue(database_handle* dh, file_data* target, uint32_t flags, char* path) {
+    if (!flags || !path || target->pending_flags) {
+        return WRONG_ARGS;
+    }
+
+    target->pending_flags = flags;
+    target->pending_path = path;
+
+    // add to tail
+    target->prev_pending = dh->pending_tail;
+    target->next_pending = NULL;
+    if (dh->pending_tail) {
+        dh->pending_tail->next_pending = target;
+    }
+    else {
+        dh->pending_head = target;
     }
+    dh->pending_tail = target;
+
+    dh->pending_num++;
 
     return 0;
 }
 
-int unlink_entry_from_date_time_tree(database_handle* dh, linked_entry* target, unsigned char mode) {
-    dtt_year* temp_year;
-    dtt_year* temp_year_backup;
-    dtt_month* temp_month;
-    dtt_day* temp_day;
-    dtt_hour* temp_hour;
+int unlink_file_data_from_pending_queue(database_handle* dh, file_data* target) {
+    if (!target->pending_flags) {
+        return WRONG_ARGS;
+    }
 
-    dtt_year* dtt;
-    struct tm* tar_time;
+    if (target->prev_pending) {
+        target->prev_pending->next_pending = target->next_pending;
+    }
+    else {
+        dh->pending_head = target->next_pending;
+    }
+    if (target->next_pending) {
+        target->next_pending->prev_pending = target->prev_pending;
+    }
+    else {
+        dh->pending_tail = target->prev_pending;
+    }
 
-    linked_entry* temp_entry_find;
-    linked_entry* temp_entry_find_backup;
+    dh->pending_num--;
 
-    int i;
+    free(target->pending_path);
 
-    if (        mode != DATE_TOD
-            &&  mode != DATE_TUSR
-       )
-    {
+    target->pending_flags = 0;
+    target->pending_path = NULL;
+    target->prev_pending = NULL;
+    target->next_pending = NULL;
+
+    return 0;
+}
+
+int link_file_data_to_fuzzy_index(database_handle* dh, file_data* target) {
+    uint64_t keys[FUZZY_GRAM_MAX];
+    uint32_t key_num;
+    uint32_t i;
+
+    fuzzy_gram* temp_gram;
+    file_data** temp_fd;
+
+    if (!target->fuzzy.block_size) {
         return WRONG_ARGS;
     }
 
-    if (mode == DATE_TOD) {
-        if (!target->tod_hour) {        // not previously linked
-            return 0;
+    key_num = fuzzy_gram_keys(&target->fuzzy, keys);
+
+    for (i = 0; i < key_num; i++) {
+        HASH_FIND(hh, dh->fuzzy_index, &keys[i], sizeof(uint64_t), temp_gram);
+        if (!temp_gram) {
+            temp_gram = malloc(sizeof(fuzzy_gram));
+            if (!temp_gram) {
+                return MALLOC_FAIL;
+            }
+            temp_gram->key = keys[i];
+            temp_gram->fd = NULL;
+            temp_gram->fd_num = 0;
+            temp_gram->fd_max = 0;
+            HASH_ADD(hh, dh->fuzzy_index, key, sizeof(uint64_t), temp_gram);
         }
 
-        dtt = dh->tod_dt_tree;
-        tar_time = &target->tod_utc;
-    }
-    else if (mode == DATE_TUSR) {
-        if (!target->tusr_hour) {       // not previously linked
-            return 0;
+        if (temp_gram->fd_num == temp_gram->fd_max) {
+            temp_fd = realloc(temp_gram->fd, sizeof(file_data*) * (temp_gram->fd_max ? temp_gram->fd_max * 2 : 1));
+            if (!temp_fd) {
+                return MALLOC_FAIL;
+            }
+            temp_gram->fd = temp_fd;
+            temp_gram->fd_max = temp_gram->fd_max ? temp_gram->fd_max * 2 : 1;
         }
 
-        dtt = dh->tusr_dt_tree;
-        tar_time = &target->tusr_utc;
+        temp_gram->fd[temp_gram->fd_num++] = target;
     }
 
-    // deal with year
-    temp_year = dtt;
-    while (temp_year) {
-        if (temp_year->year == tar_time->tm_year + 1900) {
-            break;
-        }
+    dh->fuzzy_num++;
+
+    return 0;
+}
+
+int unlink_file_data_from_fuzzy_index(database_handle* dh, file_data* target) {
+    uint64_t keys[FUZZY_GRAM_MAX];
+    uint32_t key_num;
+    uint32_t i, j;
 
-        temp_year_backup = temp_year;
-        temp_year = temp_year->next;
+    fuzzy_gram* temp_gram;
+
+    if (!target->fuzzy.block_size) {
+        return WRONG_ARGS;
     }
-    if (!temp_year) {
-        return LOGIC_ERROR;
+
+    key_num = fuzzy_gram_keys(&target->fuzzy, keys);
+
+    for (i = 0; i < key_num; i++) {
+        HASH_FIND(hh, dh->fuzzy_index, &keys[i], sizeof(uint64_t), temp_gram);
+        if (!temp_gram) {
+            continue;
+        }
+
+        // order does not matter, move last one in
+        for (j = 0; j < temp_gram->fd_num; j++) {
+            if (temp_gram->fd[j] == target) {
+                temp_gram->fd[j] = temp_gram->fd[--temp_gram->fd_num];
+                break;
+            }
+        }
+
+        if (temp_gram->fd_num == 0) {
+            HASH_DEL(dh->fuzzy_index, temp_gram);
+            free(temp_gram->fd);
+            free(temp_gram);
+        }
     }
 
-    // deal with month
-    temp_month = temp_year->month + tar_time->tm_mon;
+    dh->fuzzy_num--;
 
-    // deal with day
-    temp_day = temp_month->day + tar_time->tm_mday;
+    return 0;
+}
 
-    // deal with hour
-    temp_hour = temp_day->hour + tar_time->tm_hour;
+int lookup_file_fuzzy_via_dh (database_handle* dh, const fuzzy_digest* digest, int min_score, file_data** result_buf, int* score_buf, bit_index buf_size, bit_index* num_used) {
+    uint64_t keys[FUZZY_GRAM_MAX];
+    uint32_t key_num;
+    uint32_t i, j;
+    int score;
 
-    if (!temp_hour->in_use) {
-        return LOGIC_ERROR;
+    fuzzy_gram* temp_gram;
+    file_data* temp_file_data;
+
+    *num_used = 0;
+    if (buf_size > 0) {
+        result_buf[0] = 0;
     }
-    temp_entry_find = temp_hour->head;
-    temp_entry_find_backup = temp_entry_find;
-    if (mode == DATE_TOD) {
-        if (        target->tod_prev_sort_min == NULL
-                &&  target->tod_next_sort_min == NULL
-           )
-        {
-            temp_hour->head = NULL;
-            temp_hour->in_use = 0;
+
+    key_num = fuzzy_gram_keys(digest, keys);
+
+    // each file data is scored once, however many grams it shares
+    dh->fuzzy_mark++;
+
+    for (i = 0; i < key_num; i++) {
+        HASH_FIND(hh, dh->fuzzy_index, &keys[i], sizeof(uint64_t), temp_gram);
+        if (!temp_gram) {
+            continue;
         }
-        else if (target->tod_prev_sort_min == NULL) {
-            temp_hour->head = target->tod_next_sort_min;
-            target->tod_next_sort_min->tod_prev_sort_min = NULL;
 
-            target->tod_next_sort_min = NULL;
+        for (j = 0; j < temp_gram->fd_num; j++) {
+            temp_file_data = temp_gram->fd[j];
+
+            if (temp_file_data->fuzzy_mark == dh->fuzzy_mark) {
+                continue;
+            }
+            temp_file_data->fuzzy_mark = dh->fuzzy_mark;
+
+            score = fuzzy_compare(digest, &temp_file_data->fuzzy);
+            if (score == 0 || score < min_score) {
+                continue;
+            }
+
+            if (*num_used == buf_size) {
+                return BUFFER_FULL;
+            }
+
+            result_buf[*num_used] = temp_file_data;
+            score_buf[*num_used] = score;
+            (*num_used)++;
         }
-        else if (target->tod_next_sort_min == NULL) {
-            target->tod_prev_sort_min->tod_next_sort_min = NULL;
+    }
 
-            target->tod_prev_sort_min = NULL;
+    if (*num_used == 0) {
+        return FIND_FAIL;
+    }
+
+    return 0;
+}
+
+// positions of extracts already depend on file size, so size is not part of key
+static uint64_t extract_index_key(const extract_sample* extract, uint32_t extract_num) {
+    uint64_t key = UINT64_C(0xcbf29ce484222325);    // FNV-1a
+    uint32_t i, j;
+
+    for (i = 0; i < extract_num; i++) {
+        for (j = 0; j < 8; j++) {
+            key = (key ^ ((extract[i].position >> (j * 8)) & 0xFF)) * UINT64_C(0x100000001b3);
+        }
+        key = (key ^ extract[i].len) * UINT64_C(0x100000001b3);
+        for (j = 0; j < extract[i].len; j++) {
+            key = (key ^ extract[i].extract[j]) * UINT64_C(0x100000001b3);
         }
     }
-    else if (mode == DATE_TUSR) {
-        if (        target->tusr_prev_sort_min == NULL
-                &&  target->tusr_next_sort_min == NULL
+
+    return key;
+}
+
+// file data without size recorded (0) matches any size
+static int same_extract_samples(const file_data* data, uint64_t file_size, const extract_sample* extract, uint32_t extract_num) {
+    uint32_t i;
+
+    if (data->file_size && data->file_size != file_size) {
+        return 0;
+    }
+
+    if (data->extract_num != extract_num) {
+        return 0;
+    }
+
+    for (i = 0; i < extract_num; i++) {
+        if (        data->extract[i].position   != extract[i].position
+                ||  data->extract[i].len        != extract[i].len
+                ||  memcmp(data->extract[i].extract, extract[i].extract, extract[i].len) != 0
            )
         {
-            temp_hour->head = NULL;
-            temp_hour->in_use = 0;
+            return 0;
         }
-        else if (target->tusr_prev_sort_min == NULL) {
-            temp_hour->head = target->tusr_next_sort_min;
-            target->tusr_next_sort_min->tusr_prev_sort_min = NULL;
+    }
 
-            target->tusr_next_sort_min = NULL;
-        }
-        else if (target->tusr_next_sort_min == NULL) {
-            target->tusr_prev_sort_min->tusr_next_sort_min = NULL;
+    return 1;
+}
 
-            target->tusr_prev_sort_min = NULL;
-        }
+// file data without extracts is left out
+int link_file_data_to_extract_index(database_handle* dh, file_data* target) {
+    extract_bucket* temp_bucket;
+    file_data** temp_fd;
+    uint64_t key;
+
+    if (target->extract_indexed) {
+        unlink_file_data_from_extract_index(dh, target);
     }
 
-    if (!temp_hour->in_use) {
-        for (i = 0; i < 24; i++) {
-            if (temp_day->hour[i].in_use) {
-                break;
-            }
+    if (target->extract_num == 0) {
+        return 0;
+    }
+
+    key = extract_index_key(target->extract, target->extract_num);
+
+    HASH_FIND(hh, dh->extract_index, &key, sizeof(uint64_t), temp_bucket);
+    if (!temp_bucket) {
+        temp_bucket = malloc(sizeof(extract_bucket));
+        if (!temp_bucket) {
+            return MALLOC_FAIL;
         }
-        if (i == 24) {
-            temp_day->in_use = 0;
+        temp_bucket->key = key;
+        temp_bucket->fd = NULL;
+        temp_bucket->fd_num = 0;
+        temp_bucket->fd_max = 0;
+        HASH_ADD(hh, dh->extract_index, key, sizeof(uint64_t), temp_bucket);
+    }
+
+    if (temp_bucket->fd_num == temp_bucket->fd_max) {
+        temp_fd = realloc(temp_bucket->fd, sizeof(file_data*) * (temp_bucket->fd_max ? temp_bucket->fd_max * 2 : 1));
+        if (!temp_fd) {
+            return MALLOC_FAIL;
         }
+        temp_bucket->fd = temp_fd;
+        temp_bucket->fd_max = temp_bucket->fd_max ? temp_bucket->fd_max * 2 : 1;
+    }
+
+    temp_bucket->fd[temp_bucket->fd_num++] = target;
+
+    target->extract_key = key;
+    target->extract_indexed = 1;
+
+    dh->extract_index_num++;
+
+    return 0;
+}
+
+int unlink_file_data_from_extract_index(database_handle* dh, file_data* target) {
+    extract_bucket* temp_bucket;
+    uint32_t i;
+
+    if (!target->extract_indexed) {
+        return WRONG_ARGS;
     }
 
-    if (!temp_day->in_use) {
-        for (i = 0; i < 32; i++) {
-            if (temp_month->day[i].in_use) {
+    HASH_FIND(hh, dh->extract_index, &target->extract_key, sizeof(uint64_t), temp_bucket);
+    if (temp_bucket) {
+        // order does not matter, move last one in
+        for (i = 0; i < temp_bucket->fd_num; i++) {
+            if (temp_bucket->fd[i] == target) {
+                temp_bucket->fd[i] = temp_bucket->fd[--temp_bucket->fd_num];
                 break;
             }
         }
-        if (i == 32) {
-            temp_month->in_use = 0;
+
+        if (temp_bucket->fd_num == 0) {
+            HASH_DEL(dh->extract_index, temp_bucket);
+            free(temp_bucket->fd);
+            free(temp_bucket);
         }
     }
 
-    if (!temp_month->in_use) {
-        for (i = 0; i < 12; i++) {
-            if (temp_year->month[i].in_use) {
-                break;
-            }
+    target->extract_key = 0;
+    target->extract_indexed = 0;
+
+    dh->extract_index_num--;
+
+    return 0;
+}
+
+int lookup_file_extract_via_dh (database_handle* dh, uint64_t file_size, const extract_sample* extract, uint32_t extract_num, file_data** result_buf, bit_index buf_size, bit_index* num_used) {
+    extract_bucket* temp_bucket;
+    uint64_t key;
+    uint32_t i;
+
+    *num_used = 0;
+    if (buf_size > 0) {
+        result_buf[0] = 0;
+    }
+
+    if (extract_num == 0) {
+        return FIND_FAIL;
+    }
+
+    key = extract_index_key(extract, extract_num);
+
+    HASH_FIND(hh, dh->extract_index, &key, sizeof(uint64_t), temp_bucket);
+    if (!temp_bucket) {
+        return FIND_FAIL;
+    }
+
+    for (i = 0; i < temp_bucket->fd_num; i++) {
+        // different content may still share a key
+        if (!same_extract_samples(temp_bucket->fd[i], file_size, extract, extract_num)) {
+            continue;
         }
-        if (i == 12) {
-            if (temp_year == dh->tod_dt_tree) {
-                dh->tod_dt_tree = temp_year->next;
-            }
-            else if (temp_year == dh->tusr_dt_tree) {
-                dh->tusr_dt_tree = temp_year->next;
-            }
-            else {
-                temp_year_backup->next = temp_year->next;
-            }
 
-            del_dtt_year_from_layer2_arr(&dh->l2_dtt_year_arr, temp_year->obj_arr_index);
+        if (*num_used == buf_size) {
+            return BUFFER_FULL;
         }
+
+        result_buf[(*num_used)++] = temp_bucket->fd[i];
+    }
+
+    if (*num_used == 0) {
+        return FIND_FAIL;
     }
 
     return 0;
 }
 
-int link_file_data_to_file_size_structures(database_handle* dh, file_data* target) {
-    file_data* temp_file_data_find;
+int link_sect_to_sha1_structures(database_handle* dh, file_data* data, uint64_t sect_index) {
     bit_index temp_index;
-    t_f_size_to_fd* temp_f_size_to_fd;
-    int verify_error_code;
-    char file_size_str_buf[FILE_SIZE_STR_MAX+1];
-
-    // convert file size into string
-    strfy_sprintf(file_size_str_buf, FILE_SIZE_STR_MAX, PRIu64, target->file_size);
+    t_sha1s_to_s* temp_sha1s_to_s;
 
-    lookup_file_size_via_dh(dh, file_size_str_buf, &temp_file_data_find);
-    if (!temp_file_data_find) {   // no file data with same file size found
-        // add file size to layer 2 array
-        add_f_size_to_fd_to_layer2_arr(&dh->l2_f_size_to_fd_arr, &temp_f_size_to_fd, &temp_index);
-        init_f_size_to_fd(temp_f_size_to_fd);
-        strcpy(temp_f_size_to_fd->str, file_size_str_buf);
-        temp_f_size_to_fd->head_tar = target;
-        temp_f_size_to_fd->tail_tar = target;
-        temp_f_size_to_fd->number = 1;
-        verify_f_size_to_fd(temp_f_size_to_fd, &verify_error_code, GO_THROUGH_CHAIN);
-        add_f_size_to_fd_to_htab(&dh->f_size_to_fd, temp_f_size_to_fd);
-        // add file size to existence matrix
-        add_f_size_to_f_size_exist_mat(&dh->f_size_mat, temp_f_size_to_fd->str, temp_index);
-        // link translation structure to file data
-        target->f_size_to_fd = temp_f_size_to_fd;
+    lookup_sect_sha1_key_via_dh(dh, sect_digest(data, sect_index, CHECKSUM_SHA1_INDEX), &temp_sha1s_to_s);
+    if (!temp_sha1s_to_s) {     // no section with same checksum
+        // add section checksum to layer 2 array
+        add_sha1s_to_s_to_layer2_arr(&dh->l2_sha1s_to_s_arr, &temp_sha1s_to_s, &temp_index);
+        init_sha1s_to_s(temp_sha1s_to_s);
+        memcpy(temp_sha1s_to_s->key, sect_digest(data, sect_index, CHECKSUM_SHA1_INDEX), SHA_DIGEST_LENGTH);
+        add_sha1s_to_s_to_htab(&dh->sha1s_to_s, temp_sha1s_to_s);
+        // add section checksum to digest index
+        add_sha1s_to_sha1s_digest_index(&dh->sha1s_digest, temp_sha1s_to_s);
     }
-    else {      // found file_data with same file size, add to tail
-        add_fd_to_f_size_to_fd_chain(temp_file_data_find, target);
+
+    return add_s_to_sha1s_to_s_postings(temp_sha1s_to_s, data, sect_index);
+}
+
+int link_sect_to_sha256_structures(database_handle* dh, file_data* data, uint64_t sect_index) {
+    bit_index temp_index;
+    t_sha256s_to_s* temp_sha256s_to_s;
+
+    lookup_sect_sha256_key_via_dh(dh, sect_digest(data, sect_index, CHECKSUM_SHA256_INDEX), &temp_sha256s_to_s);
+    if (!temp_sha256s_to_s) {     // no section with same checksum
+        // add section checksum to layer 2 array
+        add_sha256s_to_s_to_layer2_arr(&dh->l2_sha256s_to_s_arr, &temp_sha256s_to_s, &temp_index);
+        init_sha256s_to_s(temp_sha256s_to_s);
+        memcpy(temp_sha256s_to_s->key, sect_digest(data, sect_index, CHECKSUM_SHA256_INDEX), SHA256_DIGEST_LENGTH);
+        add_sha256s_to_s_to_htab(&dh->sha256s_to_s, temp_sha256s_to_s);
+        // add section checksum to digest index
+        add_sha256s_to_sha256s_digest_index(&dh->sha256s_digest, temp_sha256s_to_s);
     }
 
-    return 0;
+    return add_s_to_sha256s_to_s_postings(temp_sha256s_to_s, data, sect_index);
 }
 
-int link_file_data_to_sha1_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
-    file_data* temp_file_data_find;
+int link_sect_to_sha512_structures(database_handle* dh, file_data* data, uint64_t sect_index) {
     bit_index temp_index;
-    t_sha1f_to_fd* temp_sha1f_to_fd;
-    int verify_error_code;
+    t_sha512s_to_s* temp_sha512s_to_s;
 
-    lookup_file_sha1_via_dh(dh, target_checksum_result->checksum_str, &temp_file_data_find);
-    if (!temp_file_data_find) {     // no file data with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha1f_to_fd_to_layer2_arr(&dh->l2_sha1f_to_fd_arr, &temp_sha1f_to_fd, &temp_index);
-        init_sha1f_to_fd(temp_sha1f_to_fd);
-        strcpy(temp_sha1f_to_fd->str, target_checksum_result->checksum_str);
-        temp_sha1f_to_fd->head_tar = target;
-        temp_sha1f_to_fd->tail_tar = target;
-        temp_sha1f_to_fd->number = 1;
-        verify_sha1f_to_fd(temp_sha1f_to_fd, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha1f_to_fd_to_htab(&dh->sha1f_to_fd, temp_sha1f_to_fd);
-        // add whole file checksum to existence matrix
-        add_sha1f_to_sha1f_exist_mat(&dh->sha1f_mat, temp_sha1f_to_fd->str, temp_index);
-        // link translation structure to file data
-        target->sha1f_to_fd = temp_sha1f_to_fd;
+    lookup_sect_sha512_key_via_dh(dh, sect_digest(data, sect_index, CHECKSUM_SHA512_INDEX), &temp_sha512s_to_s);
+    if (!temp_sha512s_to_s) {     // no section with same checksum
+        // add section checksum to layer 2 array
+        add_sha512s_to_s_to_layer2_arr(&dh->l2_sha512s_to_s_arr, &temp_sha512s_to_s, &temp_index);
+        init_sha512s_to_s(temp_sha512s_to_s);
+        memcpy(temp_sha512s_to_s->key, sect_digest(data, sect_index, CHECKSUM_SHA512_INDEX), SHA512_DIGEST_LENGTH);
+        add_sha512s_to_s_to_htab(&dh->sha512s_to_s, temp_sha512s_to_s);
+        // add section checksum to digest index
+        add_sha512s_to_sha512s_digest_index(&dh->sha512s_digest, temp_sha512s_to_s);
     }
-    else {  // found file_data with same checksum, add to tail
-        add_fd_to_sha1f_to_fd_chain(temp_file_data_find, target);
+
+    return add_s_to_sha512s_to_s_postings(temp_sha512s_to_s, data, sect_index);
+}
+
+int link_sect_to_checksum_structures(database_handle* dh, file_data* data, uint64_t sect_index) {
+    if (sect_has_checksum(data, sect_index, CHECKSUM_SHA1_INDEX)) {
+        link_sect_to_sha1_structures(dh,    data, sect_index);
+    }
+    if (sect_has_checksum(data, sect_index, CHECKSUM_SHA256_INDEX)) {
+        link_sect_to_sha256_structures(dh,  data, sect_index);
+    }
+    if (sect_has_checksum(data, sect_index, CHECKSUM_SHA512_INDEX)) {
+        link_sect_to_sha512_structures(dh,  data, sect_index);
     }
 
     return 0;
 }
 
-int link_file_data_to_sha256_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
-    file_data* temp_file_data_find;
-    bit_index temp_index;
-    t_sha256f_to_fd* temp_sha256f_to_fd;
-    int verify_error_code;
+int unlink_sect_from_checksum_structures(database_handle* dh, file_data* data, uint64_t sect_index) {
+    del_s_from_sha1s_to_s_postings(&dh->sha1s_to_s, &dh->sha1s_digest, &dh->l2_sha1s_to_s_arr, data, sect_index);
+    del_s_from_sha256s_to_s_postings(&dh->sha256s_to_s, &dh->sha256s_digest, &dh->l2_sha256s_to_s_arr, data, sect_index);
+    del_s_from_sha512s_to_s_postings(&dh->sha512s_to_s, &dh->sha512s_digest, &dh->l2_sha512s_to_s_arr, data, sect_index);
 
-    lookup_file_sha256_via_dh(dh, target_checksum_result->checksum_str, &temp_file_data_find);
-    if (!temp_file_data_find) {     // no file data with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha256f_to_fd_to_layer2_arr(&dh->l2_sha256f_to_fd_arr, &temp_sha256f_to_fd, &temp_index);
-        init_sha256f_to_fd(temp_sha256f_to_fd);
-        strcpy(temp_sha256f_to_fd->str, target_checksum_result->checksum_str);
-        temp_sha256f_to_fd->head_tar = target;
-        temp_sha256f_to_fd->tail_tar = target;
-        temp_sha256f_to_fd->number = 1;
-        verify_sha256f_to_fd(temp_sha256f_to_fd, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha256f_to_fd_to_htab(&dh->sha256f_to_fd, temp_sha256f_to_fd);
-        // add whole file checksum to existence matrix
-        add_sha256f_to_sha256f_exist_mat(&dh->sha256f_mat, temp_sha256f_to_fd->str, temp_index);
-        // link translation structure to file data
-        target->sha256f_to_fd = temp_sha256f_to_fd;
+    return 0;
+}
+
+int unlink_sects_from_checksum_structures(database_handle* dh, file_data* data) {
+    uint64_t i;
+
+    for (i = 0; i < data->section_num; i++) {
+        purge_fd_from_sha1s_to_s_postings(&dh->sha1s_to_s, &dh->sha1s_digest, &dh->l2_sha1s_to_s_arr, data, i);
+        purge_fd_from_sha256s_to_s_postings(&dh->sha256s_to_s, &dh->sha256s_digest, &dh->l2_sha256s_to_s_arr, data, i);
+        purge_fd_from_sha512s_to_s_postings(&dh->sha512s_to_s, &dh->sha512s_digest, &dh->l2_sha512s_to_s_arr, data, i);
+    }
+
+    return 0;
+}
+
+int grow_children_array(linked_entry* parent, ffp_eid_int increment) {
+    linked_entry** temp_entry_p;
+    linked_entry** temp_entry_p2;
+
+    // grow parent's children array
+    if (parent->child_num == 0 && parent->child_free_num == 0) {
+        temp_entry_p =
+            malloc(
+                    sizeof(linked_entry*)
+                    * increment
+                  );
+
+        temp_entry_p2 = temp_entry_p;
     }
-    else {  // found file_data with same checksum, add to tail
-        add_fd_to_sha256f_to_fd_chain(temp_file_data_find, target);
+    else {
+        temp_entry_p =
+            realloc(
+                    parent->child,
+
+                    sizeof(linked_entry*)
+                    * (parent->child_num + parent->child_free_num + increment)
+                   );
+
+        if (temp_entry_p) {
+            temp_entry_p2 = temp_entry_p + parent->child_num;
+        }
+    }
+
+    if (!temp_entry_p) {
+        return MALLOC_FAIL;
     }
 
+    // wipe array
+    mem_wipe_sec(temp_entry_p2, increment * sizeof(linked_entry*));
+
+    // update pointer
+    parent->child = temp_entry_p;
+
+    // update stats
+    parent->child_free_num += increment;
+
     return 0;
 }
 
-int link_file_data_to_sha512_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result) {
-    file_data* temp_file_data_find;
-    bit_index temp_index;
-    t_sha512f_to_fd* temp_sha512f_to_fd;
-    int verify_error_code;
+int put_into_children_array(linked_entry* parent, linked_entry* entry) {
+    int ret;
 
-    lookup_file_sha512_via_dh(dh, target_checksum_result->checksum_str, &temp_file_data_find);
-    if (!temp_file_data_find) {     // no file data with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha512f_to_fd_to_layer2_arr(&dh->l2_sha512f_to_fd_arr, &temp_sha512f_to_fd, &temp_index);
-        init_sha512f_to_fd(temp_sha512f_to_fd);
-        strcpy(temp_sha512f_to_fd->str, target_checksum_result->checksum_str);
-        temp_sha512f_to_fd->head_tar = target;
-        temp_sha512f_to_fd->tail_tar = target;
-        temp_sha512f_to_fd->number = 1;
-        verify_sha512f_to_fd(temp_sha512f_to_fd, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha512f_to_fd_to_htab(&dh->sha512f_to_fd, temp_sha512f_to_fd);
-        // add whole file checksum to existence matrix
-        add_sha512f_to_sha512f_exist_mat(&dh->sha512f_mat, temp_sha512f_to_fd->str, temp_index);
-        // link translation structure to file data
-        target->sha512f_to_fd = temp_sha512f_to_fd;
+    linked_entry** slot;
+
+    if (!parent) {
+        return WRONG_ARGS;
+    }
+
+    // grow geometrically, see note on child index
+    if (parent->child_free_num == 0) {
+        ret = grow_children_array(parent, parent->child_num < CHILD_ARR_MIN_GROW_NUM ? CHILD_ARR_MIN_GROW_NUM : parent->child_num);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    slot = parent->child + parent->child_num;
+
+    *slot = entry;
+
+    // add remaining linkage
+    entry->parent = parent;
+    entry->child_slot = parent->child_num;
+
+    // set depth
+    entry->depth = parent->depth + 1;
+
+    // update stats
+    parent->child_num++;
+    parent->child_free_num--;
+
+    // index children by name once there are enough of them
+    if (parent->child_idx) {
+        return add_to_child_index(parent, entry);
     }
-    else {  // found file_data with same checksum, add to tail
-        add_fd_to_sha512f_to_fd_chain(temp_file_data_find, target);
+    else if (parent->child_num >= CHILD_INDEX_MIN_NUM) {
+        return make_child_index(parent);
     }
 
     return 0;
 }
 
-int link_file_data_to_checksum_structures(database_handle* dh, file_data* target) {
-    checksum_result* target_checksum_result;
-    int i;
+static int cmp_child_by_name (const void* a, const void* b) {
+    const linked_entry* left = *(linked_entry* const*) a;
+    const linked_entry* right = *(linked_entry* const*) b;
 
-    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
-        target_checksum_result = target->checksum + i;
+    int ret;
 
-        switch (target_checksum_result->type) {
-            case CHECKSUM_UNUSED :
-                // do nothing
-                break;
-            case CHECKSUM_SHA1_ID:
-                link_file_data_to_sha1_structures(dh, target, target_checksum_result);
-                break;
-            case CHECKSUM_SHA256_ID :
-                link_file_data_to_sha256_structures(dh, target, target_checksum_result);
-                break;
-            case CHECKSUM_SHA512_ID :
-                link_file_data_to_sha512_structures(dh, target, target_checksum_result);
-                break;
-            default:
-                return LOGIC_ERROR;
+    ret = strcmp(left->file_name, right->file_name);
+    if (ret) {
+        return ret;
+    }
+
+    // same name, order by entry id so the order is stable
+    return memcmp(left->entry_id, right->entry_id, EID_LEN);
+}
+
+int get_sorted_children(linked_entry* parent, ffp_eid_int start, linked_entry** result_buf, bit_index buf_size, bit_index* num_used) {
+    child_index* idx;
+
+    bit_index temp_num_used = 0;
+
+    int ret;
+
+    if (!parent || !result_buf || !num_used || buf_size == 0) {
+        return WRONG_ARGS;
+    }
+
+    *num_used = 0;
+
+    if (start >= parent->child_num) {
+        return 0;
+    }
+
+    ret = make_child_index(parent);
+    if (ret) {
+        return ret;
+    }
+    idx = parent->child_idx;
+
+    // sort once, the sorted copy is dropped when children change
+    if (!idx->sorted) {
+        idx->sorted = malloc(parent->child_num * sizeof(linked_entry*));
+        if (!idx->sorted) {
+            return MALLOC_FAIL;
+        }
+        memcpy(idx->sorted, parent->child, parent->child_num * sizeof(linked_entry*));
+        qsort(idx->sorted, parent->child_num, sizeof(linked_entry*), cmp_child_by_name);
+    }
+
+    while (start + temp_num_used < parent->child_num) {
+        result_buf[temp_num_used] = idx->sorted[start + temp_num_used];
+        temp_num_used++;
+
+        if (temp_num_used == buf_size) {
+            *num_used = temp_num_used;
+            return BUFFER_FULL;
         }
     }
 
+    *num_used = temp_num_used;
+
     return 0;
 }
 
-int link_sect_to_sha1_structures(database_handle* dh, section* target, checksum_result* target_checksum_result) {
-    section* temp_section_find;
-    bit_index temp_index;
-    t_sha1s_to_s* temp_sha1s_to_s;
-    int verify_error_code;
+int grow_section_array(file_data* target, uint64_t increment) {
+    uint64_t old_cap = target->section_num + target->section_free_num;
+    uint64_t new_cap = old_cap + increment;
 
-    lookup_sect_sha1_via_dh(dh, target_checksum_result->checksum_str, &temp_section_find);
-    if (!temp_section_find) {     // no section with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha1s_to_s_to_layer2_arr(&dh->l2_sha1s_to_s_arr, &temp_sha1s_to_s, &temp_index);
-        init_sha1s_to_s(temp_sha1s_to_s);
-        strcpy(temp_sha1s_to_s->str, target_checksum_result->checksum_str);
-        temp_sha1s_to_s->head_tar = target;
-        temp_sha1s_to_s->tail_tar = target;
-        temp_sha1s_to_s->number = 1;
-        verify_sha1s_to_s(temp_sha1s_to_s, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha1s_to_s_to_htab(&dh->sha1s_to_s, temp_sha1s_to_s);
-        // add whole file checksum to existence matrix
-        add_sha1s_to_sha1s_exist_mat(&dh->sha1s_mat, temp_sha1s_to_s->str, temp_index);
-        // link translation structure to section
-        target->sha1s_to_s = temp_sha1s_to_s;
+    section* temp_sect_p;
+    uint64_t* temp_pos_p;
+    unsigned char* temp_digest_p;
+    extract_sample* temp_extract_p;
+
+    int i;
+
+    // side arrays are grown first, so section_free_num only changes once all succeeded
+    if (target->sect_pos) {
+        temp_pos_p = realloc(target->sect_pos, sizeof(uint64_t) * 2 * new_cap);
+        if (!temp_pos_p) {
+            return MALLOC_FAIL;
+        }
+        mem_wipe_sec(temp_pos_p + 2 * old_cap, sizeof(uint64_t) * 2 * increment);
+        target->sect_pos = temp_pos_p;
+    }
+
+    for (i = 0; i < SECT_CHECKSUM_NUM; i++) {
+        if (!target->sect_digest[i]) {
+            continue;
+        }
+        temp_digest_p = realloc(target->sect_digest[i], sect_checksum_len[i] * new_cap);
+        if (!temp_digest_p) {
+            return MALLOC_FAIL;
+        }
+        target->sect_digest[i] = temp_digest_p;
+    }
+
+    if (target->sect_extract) {
+        temp_extract_p = realloc(target->sect_extract, sizeof(extract_sample) * EXTRACT_MAX_NUM * new_cap);
+        if (!temp_extract_p) {
+            return MALLOC_FAIL;
+        }
+        mem_wipe_sec(temp_extract_p + EXTRACT_MAX_NUM * old_cap, sizeof(extract_sample) * EXTRACT_MAX_NUM * increment);
+        target->sect_extract = temp_extract_p;
     }
-    else {  // found file_data with same checksum, add to tail
-        add_s_to_sha1s_to_s_chain(temp_section_find, target);
+
+    temp_sect_p = realloc(target->section, sizeof(section) * new_cap);
+    if (!temp_sect_p) {
+        return MALLOC_FAIL;
     }
 
+    // wipe new part of array
+    mem_wipe_sec(temp_sect_p + old_cap, sizeof(section) * increment);
+
+    // update pointer
+    target->section = temp_sect_p;
+
+    // update stats
+    target->section_free_num += increment;
+
     return 0;
 }
 
-int link_sect_to_sha256_structures(database_handle* dh, section* target, checksum_result* target_checksum_result) {
-    section* temp_section_find;
-    bit_index temp_index;
-    t_sha256s_to_s* temp_sha256s_to_s;
-    int verify_error_code;
- 
-    lookup_sect_sha256_via_dh(dh, target_checksum_result->checksum_str, &temp_section_find);
-    if (!temp_section_find) {     // no section with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha256s_to_s_to_layer2_arr(&dh->l2_sha256s_to_s_arr, &temp_sha256s_to_s, &temp_index);
-        init_sha256s_to_s(temp_sha256s_to_s);
-        strcpy(temp_sha256s_to_s->str, target_checksum_result->checksum_str);
-        temp_sha256s_to_s->head_tar = target;
-        temp_sha256s_to_s->tail_tar = target;
-        temp_sha256s_to_s->number = 1;
-        verify_sha256s_to_s(temp_sha256s_to_s, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha256s_to_s_to_htab(&dh->sha256s_to_s, temp_sha256s_to_s);
-        // add whole file checksum to existence matrix
-        add_sha256s_to_sha256s_exist_mat(&dh->sha256s_mat, temp_sha256s_to_s->str, temp_index);
-        // link translation structure to section
-        target->sha256s_to_s = temp_sha256s_to_s;
+int append_sections(file_data* target, uint64_t num) {
+    int ret;
+
+    uint64_t cap;
+
+    if (!target) {
+        return WRONG_ARGS;
+    }
+
+    if (target->section_free_num < num) {
+        ret = grow_section_array(target, num - target->section_free_num);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    cap = target->section_num + target->section_free_num;
+
+    // positions cannot be derived without section sizes
+    if (target->norm_sect_size == 0 && !target->sect_pos && num > 0) {
+        target->sect_pos = malloc(sizeof(uint64_t) * 2 * cap);
+        if (!target->sect_pos) {
+            return MALLOC_FAIL;
+        }
+        mem_wipe_sec(target->sect_pos, sizeof(uint64_t) * 2 * cap);
     }
-    else {  // found file_data with same checksum, add to tail
-        add_s_to_sha256s_to_s_chain(temp_section_find, target);
+
+    // free slots may hold sections deleted previously
+    mem_wipe_sec(target->section + target->section_num, sizeof(section) * num);
+    if (target->sect_pos) {
+        mem_wipe_sec(target->sect_pos + 2 * target->section_num, sizeof(uint64_t) * 2 * num);
     }
 
+    // update stats
+    target->section_num += num;
+    target->section_free_num -= num;
+
     return 0;
 }
 
-int link_sect_to_sha512_structures(database_handle* dh, section* target, checksum_result* target_checksum_result) {
-    section* temp_section_find;
-    bit_index temp_index;
-    t_sha512s_to_s* temp_sha512s_to_s;
-    int verify_error_code;
-     
-    lookup_sect_sha512_via_dh(dh, target_checksum_result->checksum_str, &temp_section_find);
-    if (!temp_section_find) {     // no file data with same checksum
-        // add whole file checksum to layer 2 array
-        add_sha512s_to_s_to_layer2_arr(&dh->l2_sha512s_to_s_arr, &temp_sha512s_to_s, &temp_index);
-        init_sha512s_to_s(temp_sha512s_to_s);
-        strcpy(temp_sha512s_to_s->str, target_checksum_result->checksum_str);
-        temp_sha512s_to_s->head_tar = target;
-        temp_sha512s_to_s->tail_tar = target;
-        temp_sha512s_to_s->number = 1;
-        verify_sha512s_to_s(temp_sha512s_to_s, &verify_error_code, GO_THROUGH_CHAIN);
-        add_sha512s_to_s_to_htab(&dh->sha512s_to_s, temp_sha512s_to_s);
-        // add whole file checksum to existence matrix
-        add_sha512f_to_sha512f_exist_mat(&dh->sha512f_mat, temp_sha512s_to_s->str, temp_index);
-        // link translation structure to section
-        target->sha512s_to_s = temp_sha512s_to_s;
+int get_sect_pos(file_data* target, uint64_t sect_index, uint64_t* start_pos, uint64_t* end_pos) {
+    if (sect_index >= target->section_num) {
+        return WRONG_ARGS;
+    }
+
+    if (target->sect_pos) {
+        *start_pos  = target->sect_pos[2 * sect_index];
+        *end_pos    = target->sect_pos[2 * sect_index + 1];
+        return 0;
     }
-    else {  // found file_data with same checksum, add to tail
-        add_s_to_sha512s_to_s_chain(temp_section_find, target);
+
+    // continuous sections, only last one may be shorter
+    *start_pos = sect_index * target->norm_sect_size;
+    if (sect_index == target->section_num - 1) {
+        *end_pos = *start_pos + target->last_sect_size - 1;
+    }
+    else {
+        *end_pos = *start_pos + target->norm_sect_size - 1;
     }
 
     return 0;
 }
 
-int link_sect_to_checksum_structures(database_handle* dh, section* target) {
-    checksum_result* target_checksum_result;
-    int i;
+int make_sect_noncontinuous(file_data* target) {
+    uint64_t cap = target->section_num + target->section_free_num;
+    uint64_t* temp_pos_p;
+    uint64_t i;
 
-    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
-        target_checksum_result = target->checksum + i;
+    if (target->sect_pos) {
+        return 0;
+    }
 
-        switch (target_checksum_result->type) {
-            case CHECKSUM_UNUSED :
-                // do nothing
-                break;
-            case CHECKSUM_SHA1_ID :
-                link_sect_to_sha1_structures(dh,    target, target_checksum_result);
-                break;
-            case CHECKSUM_SHA256_ID :
-                link_sect_to_sha256_structures(dh,  target, target_checksum_result);
-                break;
-            case CHECKSUM_SHA512_ID :
-                link_sect_to_sha512_structures(dh,  target, target_checksum_result);
-                break;
-            default :
-                return LOGIC_ERROR;
+    if (cap > 0) {
+        temp_pos_p = malloc(sizeof(uint64_t) * 2 * cap);
+        if (!temp_pos_p) {
+            return MALLOC_FAIL;
+        }
+        mem_wipe_sec(temp_pos_p, sizeof(uint64_t) * 2 * cap);
+
+        for (i = 0; i < target->section_num; i++) {
+            get_sect_pos(target, i, temp_pos_p + 2 * i, temp_pos_p + 2 * i + 1);
         }
+
+        target->sect_pos = temp_pos_p;
     }
 
+    target->norm_sect_size = 0;
+    target->last_sect_size = 0;
+
     return 0;
 }
 
-int grow_children_array(linked_entry* parent, ffp_eid_int increment) {
-    linked_entry** temp_entry_p;
-    linked_entry** temp_entry_p2;
+int set_sect_pos(file_data* target, uint64_t sect_index, uint64_t start_pos, uint64_t end_pos) {
+    int ret;
 
-    // grow parent's children array
-    if (parent->child_num == 0 && parent->child_free_num == 0) {
-        temp_entry_p =
-            malloc(
-                    sizeof(linked_entry*)
-                    * increment
-                  );
+    uint64_t cur_start_pos;
+    uint64_t cur_end_pos;
 
-        temp_entry_p2 = temp_entry_p;
+    if (sect_index >= target->section_num) {
+        return WRONG_ARGS;
     }
-    else {
-        temp_entry_p =
-            realloc(
-                    parent->child,
 
-                    sizeof(linked_entry*)
-                    * (parent->child_num + parent->child_free_num + increment)
-                   );
+    if (!target->sect_pos) {
+        get_sect_pos(target, sect_index, &cur_start_pos, &cur_end_pos);
+        if (cur_start_pos == start_pos && cur_end_pos == end_pos) {
+            return 0;   // nothing to store
+        }
 
-        if (temp_entry_p) {
-            temp_entry_p2 = temp_entry_p + parent->child_num;
+        ret = make_sect_noncontinuous(target);
+        if (ret) {
+            return ret;
         }
     }
 
-    if (!temp_entry_p) {
-        return MALLOC_FAIL;
-    }
+    target->sect_pos[2 * sect_index]     = start_pos;
+    target->sect_pos[2 * sect_index + 1] = end_pos;
 
-    // wipe array
-    mem_wipe_sec(temp_entry_p2, increment * sizeof(linked_entry*));
+    return 0;
+}
 
-    // update pointer
-    parent->child = temp_entry_p;
+int get_sect_checksum(file_data* target, uint64_t sect_index, int chks_index, checksum_result* result) {
+    if (!sect_has_checksum(target, sect_index, chks_index)) {
+        result->type = CHECKSUM_UNUSED;
+        result->len = 0;
+        result->checksum_str[0] = 0;
+        return 0;
+    }
 
-    // update stats
-    parent->child_free_num += increment;
+    result->type = sect_checksum_type[chks_index];
+    result->len = sect_checksum_len[chks_index];
+    memcpy(result->checksum, sect_digest(target, sect_index, chks_index), result->len);
+    bytes_to_hex_str(result->checksum_str, result->checksum, result->len);
 
     return 0;
 }
 
-int put_into_children_array(linked_entry* parent, linked_entry* entry) {
-    int ret;
+int set_sect_checksum(file_data* target, uint64_t sect_index, const checksum_result* checksum) {
+    uint64_t cap = target->section_num + target->section_free_num;
+    int chks_index;
 
-    linked_entry** slot;
+    if (sect_index >= target->section_num) {
+        return WRONG_ARGS;
+    }
 
-    if (!parent) {
+    for (chks_index = 0; chks_index < SECT_CHECKSUM_NUM; chks_index++) {
+        if (sect_checksum_type[chks_index] == checksum->type) {
+            break;
+        }
+    }
+    if (chks_index == SECT_CHECKSUM_NUM || checksum->len != sect_checksum_len[chks_index]) {
         return WRONG_ARGS;
     }
 
-    if (parent->child_free_num == 0) {
-        ret = grow_children_array(parent, 1);
-        if (ret) {
-            return ret;
+    if (!target->sect_digest[chks_index]) {
+        target->sect_digest[chks_index] = malloc(sect_checksum_len[chks_index] * cap);
+        if (!target->sect_digest[chks_index]) {
+            return MALLOC_FAIL;
         }
     }
 
-    slot = parent->child + parent->child_num;
+    memcpy(sect_digest(target, sect_index, chks_index), checksum->checksum, checksum->len);
+    target->section[sect_index].checksum_used |= 1 << chks_index;
 
-    *slot = entry;
+    return 0;
+}
 
-    // add remaining linkage
-    entry->parent = parent;
+int set_sect_checksums(file_data* target, uint64_t sect_index, const checksum_result* checksum_arr) {
+    int ret;
+    int i;
 
-    // set depth
-    entry->depth = parent->depth + 1;
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (checksum_arr[i].type == CHECKSUM_UNUSED) {
+            continue;
+        }
 
-    // update stats
-    parent->child_num++;
-    parent->child_free_num--;
+        ret = set_sect_checksum(target, sect_index, checksum_arr + i);
+        if (ret) {
+            return ret;
+        }
+    }
 
     return 0;
 }
 
-int grow_section_array(file_data* target, uint64_t increment) {
-    section** temp_sect_p;
-    section** temp_sect_p2;
+int get_sect_extract_arr(file_data* target, uint64_t sect_index, extract_sample** result) {
+    uint64_t cap = target->section_num + target->section_free_num;
 
-    // grow target's section array
-    if (target->section_num == 0 && target->section_free_num == 0) {
-        temp_sect_p =
-            malloc(
-                    sizeof(section*)
-                    * increment
-                  );
-        temp_sect_p2 = temp_sect_p;
+    if (sect_index >= target->section_num) {
+        return WRONG_ARGS;
     }
-    else {
-        temp_sect_p =
-            realloc(
-                    target->section,
-
-                    sizeof(section*)
-                    * (target->section_num + target->section_free_num + increment)
-                   );
 
-        if (temp_sect_p) {
-            temp_sect_p2 = temp_sect_p + target->section_num;
+    if (!target->sect_extract) {
+        target->sect_extract = calloc(EXTRACT_MAX_NUM * cap, sizeof(extract_sample));
+        if (!target->sect_extract) {
+            return MALLOC_FAIL;
         }
     }
 
-    if (!temp_sect_p) {
-        return MALLOC_FAIL;
-    }
-
-    // wipe array
-    mem_wipe_sec(temp_sect_p2, increment * sizeof(section*));
-
-    // update pointer
-    target->section = temp_sect_p;
-
-    // update stats
-    target->section_free_num += increment;
+    *result = sect_extract(target, sect_index);
 
     return 0;
 }
 
-int put_into_section_array(file_data* target, section* sect) {
+int copy_section(file_data* dst, uint64_t dst_index, file_data* src, uint64_t src_index) {
     int ret;
+    int i;
 
-    section** slot;
+    uint64_t start_pos;
+    uint64_t end_pos;
 
-    if (!target) {
-        return WRONG_ARGS;
+    checksum_result temp_checksum;
+
+    extract_sample* temp_extract;
+
+    get_sect_pos(src, src_index, &start_pos, &end_pos);
+    ret = set_sect_pos(dst, dst_index, start_pos, end_pos);
+    if (ret) {
+        return ret;
     }
 
-    if (target->section_free_num == 0) {
-        ret = grow_section_array(target, 1);
+    dst->section[dst_index].checksum_used = 0;
+    for (i = 0; i < SECT_CHECKSUM_NUM; i++) {
+        if (!sect_has_checksum(src, src_index, i)) {
+            continue;
+        }
+        get_sect_checksum(src, src_index, i, &temp_checksum);
+        ret = set_sect_checksum(dst, dst_index, &temp_checksum);
         if (ret) {
             return ret;
         }
     }
 
-    slot = target->section + target->section_num;
-
-    *slot = sect;
-
-    // add remaining linkage
-    sect->parent_file_data = target;
-
-    // update stats
-    target->section_num++;
-    target->section_free_num--;
+    if (src->section[src_index].extract_num > 0) {
+        ret = get_sect_extract_arr(dst, dst_index, &temp_extract);
+        if (ret) {
+            return ret;
+        }
+        // memmove as dst and src may be the same array
+        memmove(temp_extract, src->sect_extract + src_index * EXTRACT_MAX_NUM, sizeof(extract_sample) * src->section[src_index].extract_num);
+    }
+    dst->section[dst_index].extract_num = src->section[src_index].extract_num;
 
     return 0;
 }
@@ -2855,6 +3253,23 @@ int init_field_match_bitmap(field_match_bitmap* match_map) {
 
     map_block* map_temp_raw;
 
+    simple_bitmap* entry_map[] = {
+        &match_map->map_name_match,
+        &match_map->map_tadd_match,
+        &match_map->map_tmod_match,
+        &match_map->map_tusr_match,
+        &match_map->map_f_size_match,
+        &match_map->map_f_sha1_match,
+        &match_map->map_f_sha256_match,
+        &match_map->map_f_sha512_match,
+        &match_map->map_f_mrkl_match,
+        &match_map->map_s_sha1_match,
+        &match_map->map_s_sha256_match,
+        &match_map->map_s_sha512_match
+    };
+
+    size_t i;
+
     map_temp_raw = malloc(map_alloc_size);
     if (!map_temp_raw) {
         return MALLOC_FAIL;
@@ -2873,30 +3288,37 @@ int init_field_match_bitmap(field_match_bitmap* match_map) {
     }
     bitmap_init(&match_map->map_result, map_temp_raw, 0, map_size, 0);
 
+    // entry maps are grown as needed by lookups
+    for (i = 0; i < sizeof(entry_map) / sizeof(simple_bitmap*); i++) {
+        map_temp_raw = malloc(map_alloc_size);
+        if (!map_temp_raw) {
+            return MALLOC_FAIL;
+        }
+        bitmap_init(entry_map[i], map_temp_raw, 0, map_size, 0);
+    }
+
     return 0;
 }
 
-int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry* src_entry, unsigned char recursive) {
-    int i, j;
+static int copy_entry_body(database_handle* dst_dh, linked_entry* dst_parent, linked_entry* src_entry, unsigned char recursive, linked_entry** ret_entry) {
+    int i;
 
     int ret;
 
     int number_of_tries = 0;
 
     unsigned char eid[EID_LEN];
-    char eid_str[EID_STR_MAX+1];
 
     linked_entry* temp_entry_find;
     linked_entry* copied_entry;
     file_data* temp_file_data;
     file_data* temp_file_data_src;
-    section* temp_section;
-    section* temp_section_src;
+    char* str;
 
     // generate id
     do {
-        gen_entry_id(eid, eid_str);
-        lookup_entry_id_via_dh(dst_dh, eid_str, &temp_entry_find);
+        gen_entry_id(eid, NULL);
+        lookup_entry_id_key_via_dh(dst_dh, eid, &temp_entry_find);
         number_of_tries++;
     } while (temp_entry_find && number_of_tries < 1000);
 
@@ -2910,46 +3332,44 @@ int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry*
         printf("copy_entry : failed to get space for new entry\n");
         return ret;
     }
+    init_entry_strs(copied_entry);
 
     // fill in entry_id
     for (i = 0; i < EID_LEN; i++) {
         copied_entry->entry_id[i] = eid[i];
     }
-    strcpy(copied_entry->entry_id_str, eid_str);
 
     // link to database via entry id
     link_entry_to_entry_id_structures(dst_dh, copied_entry);
 
-    // copy file name and length
-    strcpy(copied_entry->file_name, src_entry->file_name);
-    copied_entry->file_name_len = src_entry->file_name_len;
+    // copy file name, tag string and user message, lengths are set along
+    if (        set_entry_file_name(dst_dh, copied_entry, src_entry->file_name)
+            ||  set_entry_tag_str(dst_dh, copied_entry, src_entry->tag_str)
+            ||  set_entry_user_msg(copied_entry, src_entry->user_msg)
+       )
+    {
+        printf("copy_entry : failed to copy strings\n");
+        return MALLOC_FAIL;
+    }
     // copy type
     copied_entry->type = src_entry->type;
-    // copy tag string and length
-    strcpy(copied_entry->tag_str, src_entry->tag_str);
-    copied_entry->tag_str_len = src_entry->tag_str_len;
-    // copy user message and length
-    strcpy(copied_entry->user_msg, src_entry->tag_str);
-    copied_entry->user_msg_len = src_entry->user_msg_len;
-
-    // copy time structures
+
+    // copy times
     if (src_entry->tod_utc_used) {
         copied_entry->tod_utc_used = 1;
-        memcpy( &copied_entry->tod_utc,
-                &src_entry->tod_utc,
-
-                sizeof(struct tm)
-              );
+        copied_entry->tod_utc = src_entry->tod_utc;
 
         link_entry_to_date_time_tree(dst_dh, copied_entry, DATE_TOD);
     }
+    if (src_entry->tom_utc_used) {
+        copied_entry->tom_utc_used = 1;
+        copied_entry->tom_utc = src_entry->tom_utc;
+
+        link_entry_to_date_time_tree(dst_dh, copied_entry, DATE_TOM);
+    }
     if (src_entry->tusr_utc_used) {
         copied_entry->tusr_utc_used = 1;
-        memcpy( &copied_entry->tusr_utc,
-                &src_entry->tusr_utc,
-
-                sizeof(struct tm)
-              );
+        copied_entry->tusr_utc = src_entry->tusr_utc;
 
         link_entry_to_date_time_tree(dst_dh, copied_entry, DATE_TUSR);
     }
@@ -2960,11 +3380,43 @@ int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry*
     // insert itself to parent
     put_into_children_array(dst_parent, copied_entry);
 
+    // set has_parent flag, children copied below take branch id from here
+    if (copied_entry->parent == &dst_dh->tree) {   // head of branch
+        copied_entry->has_parent = 0;
+    }
+    else {
+        copied_entry->has_parent = 1;
+    }
+
+    // copy created by flag
+    copied_entry->created_by = src_entry->created_by;
+
+    // set depth
+    copied_entry->depth = copied_entry->parent->depth + 1;
+
+    // fill in new branch id
+    if (copied_entry->has_parent) {
+        // copy branch id from parent
+        for (i = 0; i < EID_LEN; i++) {
+            copied_entry->branch_id[i] = copied_entry->parent->branch_id[i];
+        }
+    }
+    else {
+        // fill in branch id using entry id
+        for (i = 0; i < EID_LEN; i++) {
+            copied_entry->branch_id[i] = copied_entry->entry_id[i];
+        }
+    }
+
+    if (ret_entry) {
+        *ret_entry = copied_entry;
+    }
+
     if (recursive) {
         if (src_entry->child_num > 0) {
             grow_children_array(copied_entry, src_entry->child_num);
             for (i = 0; i < src_entry->child_num; i++) {
-                copy_entry(dst_dh, copied_entry, src_entry->child[i], recursive);
+                copy_entry_body(dst_dh, copied_entry, src_entry->child[i], recursive, NULL);
             }
         }
     }
@@ -2974,7 +3426,7 @@ int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry*
 
     if (src_entry->tag_str_len > 0) {  // if tags are used
         // link to database via tag string
-        link_entry_to_entry_id_structures(dst_dh, copied_entry);
+        link_entry_to_tag_str_structures(dst_dh, copied_entry);
     }
     
     if (src_entry->data) { // if the src entry carries file data
@@ -3008,88 +3460,62 @@ int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry*
         strcpy(temp_file_data->file_size_str, temp_file_data_src->file_size_str);
 
         // link to database via file size
-        link_file_data_to_file_size_structures(dst_dh, temp_file_data);
+        ret = link_file_data_to_file_size_structures(dst_dh, temp_file_data);
+        if (ret) {
+            printf("copy_entry : failed to link copied file data via file size\n");
+            return ret;
+        }
+
+        // link to database via size and extracts
+        link_file_data_to_extract_index(dst_dh, temp_file_data);
 
         // copy section sizes
         temp_file_data->norm_sect_size = temp_file_data_src->norm_sect_size;
         temp_file_data->last_sect_size = temp_file_data_src->last_sect_size;
 
+        // copy digest state
+        temp_file_data->resume = temp_file_data_src->resume;
+
+        // copy fuzzy digest
+        if (temp_file_data_src->fuzzy.block_size) {
+            temp_file_data->fuzzy = temp_file_data_src->fuzzy;
+            link_file_data_to_fuzzy_index(dst_dh, temp_file_data);
+        }
+
+        // copy is hashed on its own if source is still waiting to be
+        if (temp_file_data_src->pending_flags) {
+            str = malloc(strlen(temp_file_data_src->pending_path) + 1);
+            if (!str) {
+                printf("copy_entry : failed to allocate space for pending path\n");
+                return MALLOC_FAIL;
+            }
+            strcpy(str, temp_file_data_src->pending_path);
+            link_file_data_to_pending_queue(dst_dh, temp_file_data, temp_file_data_src->pending_flags, str);
+        }
+
         // link file data to parent entry
         temp_file_data->parent_entry = copied_entry;
 
         if (temp_file_data_src->section_num > 0) {  // if source file data contains sections
-            // grow section pointer array
-            grow_section_array(temp_file_data, temp_file_data_src->section_num);
-
-            // fill in section pointer array
-            for (i = 0; i < temp_file_data_src->section_num; i++) {
-                // grab section object from l2 array
-                ret = add_section_to_layer2_arr(&dst_dh->l2_section_arr, &temp_section, NULL);
-                if (ret) {
-                    printf("copy_entry : failed to get space for new section, section #%d\n", i);
-                    return ret;
-                }
-                printf("temp_section : %p\n", temp_section);
-
-                put_into_section_array(temp_file_data, temp_section);
+            // make space for sections
+            ret = append_sections(temp_file_data, temp_file_data_src->section_num);
+            if (ret) {
+                printf("copy_entry : failed to get space for sections\n");
+                return ret;
             }
 
             // copy sections over
             for (i = 0; i < temp_file_data_src->section_num; i++) {
-                temp_section = temp_file_data->section[i];
-                temp_section_src = temp_file_data_src->section[i];
-
-                temp_section->start_pos = temp_section_src->start_pos;
-                temp_section->end_pos = temp_section_src->end_pos;
-
-                // copy section checksums
-                for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
-                    copy_checksum_result(temp_section->checksum + j, temp_section_src->checksum + j);
-                }
-
-                // link to database via section checksums
-                link_sect_to_checksum_structures(dst_dh, temp_section);
-
-                // copy extract
-                for (j = 0; j < temp_section_src->extract_num; j++) {
-                    copy_extract_sample(temp_section->extract + j, temp_section_src->extract + j);
-                }
-                temp_section->extract_num = temp_section_src->extract_num;
-
-                // link section to parent file data
-                temp_section->parent_file_data = temp_file_data;
-            }
-        }
-    }
-
-    // set has_parent flag
-    if (copied_entry->parent == &dst_dh->tree) {   // head of branch
-        copied_entry->has_parent = 0;
-    }
-    else {
-        copied_entry->has_parent = 1;
-    }
-
-    // copy created by flag
-    copied_entry->created_by = src_entry->created_by;
-
-    // set depth
-    copied_entry->depth = copied_entry->parent->depth + 1;
-
-    // fill in new branch id
-    if (copied_entry->has_parent) {
-        // copy branch id from parent
-        for (i = 0; i < EID_LEN; i++) {
-            copied_entry->branch_id[i] = copied_entry->parent->branch_id[i];
-        }
-        strcpy(copied_entry->branch_id_str, copied_entry->parent->branch_id_str);
-    }
-    else {
-        // fill in branch id using entry id
-        for (i = 0; i < EID_LEN; i++) {
-            copied_entry->branch_id[i] = copied_entry->entry_id[i];
+                ret = copy_section(temp_file_data, i, temp_file_data_src, i);
+                if (ret) {
+                    printf("copy_entry : failed to copy section #%d\n", i);
+                    return ret;
+                }
+
+                // link to database via section checksums
+                link_sect_to_checksum_structures(dst_dh, temp_file_data, i);
+            }
         }
-        strcpy(copied_entry->branch_id_str, copied_entry->entry_id_str);
     }
 
     ret = verify_entry(dst_dh, copied_entry, 0x0);
@@ -3103,35 +3529,59 @@ int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry*
     return 0;
 }
 
-int del_section (database_handle* dh, section* sect) {
-    int i;
+int copy_entry(database_handle* dst_dh, linked_entry* dst_parent, linked_entry* src_entry, unsigned char recursive) {
+    int ret;
 
-    checksum_result* temp_checksum;
+    linked_entry* copied_entry = NULL;
 
-    // unlink from section checksum structures
-    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
-        temp_checksum = sect->checksum + i;
+    ret = copy_entry_body(dst_dh, dst_parent, src_entry, recursive, &copied_entry);
 
-        switch (temp_checksum->type) {
-            case CHECKSUM_UNUSED :
-                // do nothing
-                break;
-            case CHECKSUM_SHA1_ID :
-                del_s_from_sha1s_to_s_chain(&dh->sha1s_to_s, &dh->sha1s_mat, &dh->l2_sha1s_to_s_arr, sect);
-                break;
-            case CHECKSUM_SHA256_ID :
-                del_s_from_sha256s_to_s_chain(&dh->sha256s_to_s, &dh->sha256s_mat, &dh->l2_sha256s_to_s_arr, sect);
-                break;
-            case CHECKSUM_SHA512_ID :
-                del_s_from_sha512s_to_s_chain(&dh->sha512s_to_s, &dh->sha512s_mat, &dh->l2_sha512s_to_s_arr, sect);
-                break;
-            default :
-                return LOGIC_ERROR;
+    // tree digests of the copied branch are computed in one pass
+    if (copied_entry) {
+        tree_digest_update(copied_entry, 1);
+    }
+
+    return ret;
+}
+
+int del_sections (database_handle* dh, file_data* data, simple_bitmap* map) {
+    int ret;
+
+    uint64_t sect_indx;
+    uint64_t sect_fill_indx;
+
+    map_block bit;
+
+    // section numbers change, so all sections are linked again afterwards
+    unlink_sects_from_checksum_structures(dh, data);
+
+    ret = make_sect_noncontinuous(data);
+    if (ret) {
+        return ret;
+    }
+
+    // collapse the section array by moving all remaining sections to start
+    sect_fill_indx = 0;
+    for (sect_indx = 0; sect_indx < data->section_num; sect_indx++) {
+        bit = 0;    // sections beyond map are kept
+        bitmap_read(map, sect_indx, &bit);
+        if (bit) {
+            continue;
         }
+
+        if (sect_fill_indx != sect_indx) {
+            copy_section(data, sect_fill_indx, data, sect_indx);
+        }
+
+        sect_fill_indx++;
     }
 
-    // delete section from layer 2 array
-    del_section_from_layer2_arr(&dh->l2_section_arr, sect->obj_arr_index);
+    data->section_free_num  += data->section_num - sect_fill_indx;
+    data->section_num        = sect_fill_indx;
+
+    for (sect_indx = 0; sect_indx < data->section_num; sect_indx++) {
+        link_sect_to_checksum_structures(dh, data, sect_indx);
+    }
 
     return 0;
 }
@@ -3150,13 +3600,16 @@ int del_file_data (database_handle* dh, file_data* data) {
                 // do nothing
                 break;
             case CHECKSUM_SHA1_ID :
-                del_fd_from_sha1f_to_fd_chain(&dh->sha1f_to_fd, &dh->sha1f_mat, &dh->l2_sha1f_to_fd_arr, data);
+                del_fd_from_sha1f_to_fd_postings(&dh->sha1f_to_fd, &dh->sha1f_digest, &dh->l2_sha1f_to_fd_arr, data);
                 break;
             case CHECKSUM_SHA256_ID :
-                del_fd_from_sha256f_to_fd_chain(&dh->sha256f_to_fd, &dh->sha256f_mat, &dh->l2_sha256f_to_fd_arr, data);
+                del_fd_from_sha256f_to_fd_postings(&dh->sha256f_to_fd, &dh->sha256f_digest, &dh->l2_sha256f_to_fd_arr, data);
                 break;
             case CHECKSUM_SHA512_ID :
-                del_fd_from_sha512f_to_fd_chain(&dh->sha512f_to_fd, &dh->sha512f_mat, &dh->l2_sha512f_to_fd_arr, data);
+                del_fd_from_sha512f_to_fd_postings(&dh->sha512f_to_fd, &dh->sha512f_digest, &dh->l2_sha512f_to_fd_arr, data);
+                break;
+            case CHECKSUM_MRKL_ID :
+                del_fd_from_mrklf_to_fd_postings(&dh->mrklf_to_fd, &dh->mrklf_digest, &dh->l2_mrklf_to_fd_arr, data);
                 break;
             default :
                 return LOGIC_ERROR;
@@ -3164,13 +3617,25 @@ int del_file_data (database_handle* dh, file_data* data) {
     }
 
     // delete sections
-    for (i = 0; i < data->section_num; i++) {
-        del_section(dh, data->section[i]);
-    }
+    unlink_sects_from_checksum_structures(dh, data);
+    fres_section_array(data);
 
-    // same file size double linked list
+    // file data with same file size
     if (data->f_size_to_fd) {     // if previously linked to file size structures
-        del_fd_from_f_size_to_fd_chain(&dh->f_size_to_fd, &dh->f_size_mat, &dh->l2_f_size_to_fd_arr, data);
+        del_fd_from_f_size_to_fd_postings(&dh->f_size_to_fd, &dh->f_size_gram, &dh->l2_f_size_to_fd_arr, data);
+    }
+
+    // no longer waiting to be hashed
+    if (data->pending_flags) {
+        unlink_file_data_from_pending_queue(dh, data);
+    }
+
+    if (data->fuzzy.block_size) {
+        unlink_file_data_from_fuzzy_index(dh, data);
+    }
+
+    if (data->extract_indexed) {
+        unlink_file_data_from_extract_index(dh, data);
     }
 
     // delete file data from layer 2 array
@@ -3179,35 +3644,33 @@ int del_file_data (database_handle* dh, file_data* data) {
     return 0;
 }
 
-int del_entry (database_handle* dh, linked_entry* entry) {
-    int i, j;
+static int del_entry_body (database_handle* dh, linked_entry* entry) {
+    ffp_eid_int slot;
     linked_entry* parent;
 
     parent = entry->parent;
 
     if (entry->child_num > 0) {
-        // recursive delete
-        for (i = 0; i < entry->child_num; i++) {
-            del_entry(dh, entry->child[i]);
+        // recursive delete, each child takes itself out of the array
+        while (entry->child_num > 0) {
+            del_entry_body(dh, entry->child[entry->child_num - 1]);
         }
 
         free(entry->child);
     }
+    fres_child_index(entry);
 
-    // find entry in parent's child array
-    for (i = 0; i < parent->child_num; i++) {
-        if (parent->child[i] == entry) {
-            break;
-        }
-    }
-    if (i == parent->child_num) {   // no match found
+    // check entry is in parent's child array
+    slot = entry->child_slot;
+    if (slot >= parent->child_num || parent->child[slot] != entry) {
         return LOGIC_ERROR;
     }
 
-    // shift the array
-    for (j = i; j < parent->child_num; j++) {
-        parent->child[j] = parent->child[j+1];
-    }
+    del_from_child_index(parent, entry);
+
+    // order does not matter, move last one in
+    parent->child[slot] = parent->child[parent->child_num-1];
+    parent->child[slot]->child_slot = slot;
 
     // nullify the extra spot
     parent->child[parent->child_num-1] = 0;
@@ -3222,12 +3685,12 @@ int del_entry (database_handle* dh, linked_entry* entry) {
     // entries are never chained based on entry id
     unlink_entry_from_entry_id_structures(dh, entry);
 
-    // same file name double linked list
-    del_e_from_fn_to_e_chain(&dh->fn_to_e, &dh->fn_mat, &dh->l2_fn_to_e_arr, entry);
+    // entries with same file name
+    del_e_from_fn_to_e_postings(&dh->fn_to_e, &dh->fn_gram, &dh->l2_fn_to_e_arr, entry);
 
-    // same tag double linked list
+    // entries with same tag
     if (entry->tag_to_e) {  // if previously linked to tag structures
-        del_e_from_tag_to_e_chain(&dh->tag_to_e, &dh->tag_mat, &dh->l2_tag_to_e_arr, entry);
+        del_e_from_tag_to_e_postings(&dh->tag_to_e, &dh->tag_gram, &dh->l2_tag_to_e_arr, entry);
     }
 
     if (entry->data) {  // if entry contains file data
@@ -3241,7 +3704,7 @@ int del_entry (database_handle* dh, linked_entry* entry) {
 
     // remove from tom date time tree
     if (entry->tom_utc_used) {
-        unlink_entry_from_date_time_tree(dh, entry, DATE_TOD);
+        unlink_entry_from_date_time_tree(dh, entry, DATE_TOM);
     }
 
     // remove from tusr date time tree
@@ -3249,23 +3712,231 @@ int del_entry (database_handle* dh, linked_entry* entry) {
         unlink_entry_from_date_time_tree(dh, entry, DATE_TUSR);
     }
 
+    // free strings owned by entry
+    fres_entry_strs(entry);
+
     // delete from entry layer 2 array
     del_entry_from_layer2_arr(&dh->l2_entry_arr, entry->obj_arr_index);
 
     return 0;
 }
 
+int del_entry (database_handle* dh, linked_entry* entry) {
+    // only the head of deleted branch needs to be taken out of the digests above
+    tree_digest_detach(entry);
+
+    return del_entry_body(dh, entry);
+}
+
+/* tree digest */
+// little endian addition mod 2^256
+static void tree_sum_add(unsigned char* sum, const unsigned char* digest) {
+    int i;
+    unsigned int carry = 0;
+
+    for (i = 0; i < TREE_DIGEST_LENGTH; i++) {
+        carry += sum[i] + digest[i];
+        sum[i] = carry & 0xFF;
+        carry >>= 8;
+    }
+}
+
+static void tree_sum_sub(unsigned char* sum, const unsigned char* digest) {
+    int i;
+    int diff;
+    int borrow = 0;
+
+    for (i = 0; i < TREE_DIGEST_LENGTH; i++) {
+        diff = sum[i] - digest[i] - borrow;
+        borrow = diff < 0;
+        sum[i] = diff & 0xFF;
+    }
+}
+
+static void put_u64_le(unsigned char* buf, uint64_t val) {
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        buf[i] = (val >> (8 * i)) & 0xFF;
+    }
+}
+
+static void calc_tree_hash(linked_entry* entry, unsigned char* digest) {
+    SHA256_CTX ctx;
+
+    unsigned char buf[8];
+
+    file_data* data;
+    checksum_result* checksum;
+
+    int i;
+
+    data = entry->data;
+
+    SHA256_Init(&ctx);
+
+    buf[0] = entry->type;
+    buf[1] = data ? 1 : 0;
+    SHA256_Update(&ctx, buf, 2);
+
+    // length goes first so name cannot run into the fields after it
+    put_u64_le(buf, entry->file_name_len);
+    SHA256_Update(&ctx, buf, 8);
+    SHA256_Update(&ctx, entry->file_name, entry->file_name_len);
+
+    if (data) {
+        for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+            checksum = data->checksum + i;
+
+            if (checksum->type == CHECKSUM_UNUSED) {
+                continue;
+            }
+
+            buf[0] = checksum->type;
+            SHA256_Update(&ctx, buf, 1);
+            SHA256_Update(&ctx, checksum->checksum, checksum->len);
+        }
+
+        put_u64_le(buf, data->file_size);
+        SHA256_Update(&ctx, buf, 8);
+    }
+
+    SHA256_Update(&ctx, entry->tree_sum, TREE_DIGEST_LENGTH);
+
+    SHA256_Final(digest, &ctx);
+}
+
+static void tree_digest_rebuild(linked_entry* entry) {
+    ffp_eid_int i;
+
+    memset(entry->tree_sum, 0, TREE_DIGEST_LENGTH);
+
+    for (i = 0; i < entry->child_num; i++) {
+        tree_digest_rebuild(entry->child[i]);
+
+        tree_sum_add(entry->tree_sum, entry->child[i]->tree_hash);
+    }
+
+    calc_tree_hash(entry, entry->tree_hash);
+}
+
+int tree_digest_update(linked_entry* entry, unsigned char rebuild) {
+    unsigned char old_hash[TREE_DIGEST_LENGTH];
+
+    linked_entry* parent;
+
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    memcpy(old_hash, entry->tree_hash, TREE_DIGEST_LENGTH);
+
+    if (rebuild) {
+        tree_digest_rebuild(entry);
+    }
+    else {
+        calc_tree_hash(entry, entry->tree_hash);
+    }
+
+    // swap old hash for new one in each ancestor, stop once nothing changes
+    while ((parent = entry->parent)) {
+        if (memcmp(old_hash, entry->tree_hash, TREE_DIGEST_LENGTH) == 0) {
+            break;
+        }
+
+        tree_sum_sub(parent->tree_sum, old_hash);
+        tree_sum_add(parent->tree_sum, entry->tree_hash);
+
+        memcpy(old_hash, parent->tree_hash, TREE_DIGEST_LENGTH);
+        calc_tree_hash(parent, parent->tree_hash);
+
+        entry = parent;
+    }
+
+    return 0;
+}
+
+static const unsigned char tree_hash_none[TREE_DIGEST_LENGTH];
+
+// digests entries with no tree hash yet below entry into its tree sum, returns 1 if sum changed
+static int tree_digest_fill_new(linked_entry* entry) {
+    unsigned char old_hash[TREE_DIGEST_LENGTH];
+
+    ffp_eid_int i;
+
+    linked_entry* child;
+
+    int changed = 0;
+
+    for (i = 0; i < entry->child_num; i++) {
+        child = entry->child[i];
+
+        if (memcmp(child->tree_hash, tree_hash_none, TREE_DIGEST_LENGTH) == 0) {
+            tree_digest_rebuild(child);
+        }
+        else if (child->child_num > 0 && tree_digest_fill_new(child)) {
+            memcpy(old_hash, child->tree_hash, TREE_DIGEST_LENGTH);
+            calc_tree_hash(child, child->tree_hash);
+
+            tree_sum_sub(entry->tree_sum, old_hash);
+        }
+        else {
+            continue;
+        }
+
+        tree_sum_add(entry->tree_sum, child->tree_hash);
+        changed = 1;
+    }
+
+    return changed;
+}
+
+int tree_digest_update_new(linked_entry* entry) {
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    if (memcmp(entry->tree_hash, tree_hash_none, TREE_DIGEST_LENGTH) == 0) {
+        return tree_digest_update(entry, 1);
+    }
+
+    if (!tree_digest_fill_new(entry)) {
+        return 0;
+    }
+
+    return tree_digest_update(entry, 0);
+}
+
+int tree_digest_detach(linked_entry* entry) {
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    if (!entry->parent) {
+        return 0;
+    }
+
+    tree_sum_sub(entry->parent->tree_sum, entry->tree_hash);
+    memset(entry->tree_hash, 0, TREE_DIGEST_LENGTH);
+
+    return tree_digest_update(entry->parent, 0);
+}
+
 /* map conversion */
 // name translation structure map to entry map
 int part_name_trans_map_to_entry_map(layer2_fn_to_e_arr* l2_arr, simple_bitmap* name_trans_map, simple_bitmap* entry_map, char* name_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
     linked_entry* temp_entry;
+    t_fn_to_e* temp_tran;
 
     layer1_fn_to_e_arr* temp_l1_arr;
 
+    bitmap_zero(entry_map);
+
     for (i = 0, temp_index_skip_to = 0; i < name_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(name_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3280,14 +3951,14 @@ int part_name_trans_map_to_entry_map(layer2_fn_to_e_arr* l2_arr, simple_bitmap*
             temp_index_skip_to2 = temp_index_result2 + 1;
             if (strstr(temp_l1_arr->arr[temp_index_result2].str, name_part)) {  // if entry contains target string as a substring
                 // mark all possible entries in bitmap
-                temp_entry = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
+
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k];
 
-                while (temp_entry) {
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_entry = temp_entry->next_same_fn;
                 }
             }
         }
@@ -3298,11 +3969,12 @@ int part_name_trans_map_to_entry_map(layer2_fn_to_e_arr* l2_arr, simple_bitmap*
 
 int part_f_size_trans_map_to_entry_map(layer2_f_size_to_fd_arr* l2_arr, simple_bitmap* f_size_trans_map, simple_bitmap* entry_map, char* f_size_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
     linked_entry* temp_entry;
-    file_data* temp_file_data;
+    t_f_size_to_fd* temp_tran;
 
     layer1_f_size_to_fd_arr* temp_l1_arr;
 
@@ -3322,16 +3994,14 @@ int part_f_size_trans_map_to_entry_map(layer2_f_size_to_fd_arr* l2_arr, simple_b
             temp_index_skip_to2 = temp_index_result2 + 1;
             if (strstr(temp_l1_arr->arr[temp_index_result2].str, f_size_part)) {  // if entry contains target string as a substring
                 // mark all possible entries in bitmap
-                temp_file_data = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_file_data) {
-                    temp_entry = temp_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k]->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_file_data = temp_file_data->next_same_f_size;
                 }
             }
         }
@@ -3342,16 +4012,24 @@ int part_f_size_trans_map_to_entry_map(layer2_f_size_to_fd_arr* l2_arr, simple_b
 
 int part_f_sha1_trans_map_to_entry_map(layer2_sha1f_to_fd_arr* l2_arr, simple_bitmap* f_sha1_trans_map, simple_bitmap* entry_map, char* f_sha1_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    file_data* temp_file_data;
+    t_sha1f_to_fd* temp_tran;
 
     layer1_sha1f_to_fd_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, f_sha1_part, SHA_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < f_sha1_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(f_sha1_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3360,22 +4038,20 @@ int part_f_sha1_trans_map_to_entry_map(layer2_sha1f_to_fd_arr* l2_arr, simple_bi
         // get the L1 array
         get_l1_sha1f_to_fd_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, f_sha1_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_file_data = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_file_data) {
-                    temp_entry = temp_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k]->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_file_data = temp_file_data->next_same_sha1;
                 }
             }
         }
@@ -3386,16 +4062,24 @@ int part_f_sha1_trans_map_to_entry_map(layer2_sha1f_to_fd_arr* l2_arr, simple_bi
 
 int part_f_sha256_trans_map_to_entry_map(layer2_sha256f_to_fd_arr* l2_arr, simple_bitmap* f_sha256_trans_map, simple_bitmap* entry_map, char* f_sha256_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA256_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    file_data* temp_file_data;
+    t_sha256f_to_fd* temp_tran;
 
     layer1_sha256f_to_fd_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, f_sha256_part, SHA256_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < f_sha256_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(f_sha256_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3404,22 +4088,20 @@ int part_f_sha256_trans_map_to_entry_map(layer2_sha256f_to_fd_arr* l2_arr, simpl
         // get the L1 array
         get_l1_sha256f_to_fd_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, f_sha256_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_file_data = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_file_data) {
-                    temp_entry = temp_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k]->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_file_data = temp_file_data->next_same_sha256;
                 }
             }
         }
@@ -3430,16 +4112,24 @@ int part_f_sha256_trans_map_to_entry_map(layer2_sha256f_to_fd_arr* l2_arr, simpl
 
 int part_f_sha512_trans_map_to_entry_map(layer2_sha512f_to_fd_arr* l2_arr, simple_bitmap* f_sha512_trans_map, simple_bitmap* entry_map, char* f_sha512_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA512_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    file_data* temp_file_data;
+    t_sha512f_to_fd* temp_tran;
 
     layer1_sha512f_to_fd_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, f_sha512_part, SHA512_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < f_sha512_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(f_sha512_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3448,22 +4138,70 @@ int part_f_sha512_trans_map_to_entry_map(layer2_sha512f_to_fd_arr* l2_arr, simpl
         // get the L1 array
         get_l1_sha512f_to_fd_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, f_sha512_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_file_data = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_file_data) {
-                    temp_entry = temp_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k]->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int part_f_mrkl_trans_map_to_entry_map(layer2_mrklf_to_fd_arr* l2_arr, simple_bitmap* f_mrkl_trans_map, simple_bitmap* entry_map, char* f_mrkl_part) {
+    bit_index i, j;
+    uint32_t k;
+    bit_index temp_index_skip_to, temp_index_result;
+    bit_index temp_index_skip_to2, temp_index_result2;
+
+    unsigned char prefix[MRKL_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
+    linked_entry* temp_entry;
+    t_mrklf_to_fd* temp_tran;
+
+    layer1_mrklf_to_fd_arr* temp_l1_arr;
+
+    bitmap_zero(entry_map);
+
+    if (hex_to_digest_prefix(prefix, &prefix_bits, f_mrkl_part, MRKL_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
+    for (i = 0, temp_index_skip_to = 0; i < f_mrkl_trans_map->number_of_ones; i++) {
+        // get index of L1 array that contains the translation structure
+        bitmap_first_one_bit_index(f_mrkl_trans_map, &temp_index_result, temp_index_skip_to);
+        temp_index_skip_to = temp_index_result + 1;
+
+        // get the L1 array
+        get_l1_mrklf_to_fd_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
+
+        // go through the L1 array to find entries with matching prefix
+        for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
+            bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
+            temp_index_skip_to2 = temp_index_result2 + 1;
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
+                // mark all possible entries in bitmap
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
+
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k]->parent_entry;
+
+                    ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
-                    temp_file_data = temp_file_data->next_same_sha512;
+                    bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
                 }
             }
         }
@@ -3474,16 +4212,24 @@ int part_f_sha512_trans_map_to_entry_map(layer2_sha512f_to_fd_arr* l2_arr, simpl
 
 int part_s_sha1_trans_map_to_entry_map(layer2_sha1s_to_s_arr* l2_arr, simple_bitmap* s_sha1_trans_map, simple_bitmap* entry_map, char* s_sha1_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    section* temp_section;
+    t_sha1s_to_s* temp_tran;
 
     layer1_sha1s_to_s_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, s_sha1_part, SHA_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < s_sha1_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(s_sha1_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3492,22 +4238,20 @@ int part_s_sha1_trans_map_to_entry_map(layer2_sha1s_to_s_arr* l2_arr, simple_bit
         // get the L1 array
         get_l1_sha1s_to_s_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, s_sha1_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_section = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_section) {
-                    temp_entry = temp_section->parent_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k].data->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_section = temp_section->next_same_sha1;
                 }
             }
         }
@@ -3518,16 +4262,24 @@ int part_s_sha1_trans_map_to_entry_map(layer2_sha1s_to_s_arr* l2_arr, simple_bit
 
 int part_s_sha256_trans_map_to_entry_map(layer2_sha256s_to_s_arr* l2_arr, simple_bitmap* s_sha256_trans_map, simple_bitmap* entry_map, char* s_sha256_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA256_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    section* temp_section;
+    t_sha256s_to_s* temp_tran;
 
     layer1_sha256s_to_s_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, s_sha256_part, SHA256_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < s_sha256_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(s_sha256_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3536,22 +4288,20 @@ int part_s_sha256_trans_map_to_entry_map(layer2_sha256s_to_s_arr* l2_arr, simple
         // get the L1 array
         get_l1_sha256s_to_s_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, s_sha256_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_section = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_section) {
-                    temp_entry = temp_section->parent_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k].data->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_section = temp_section->next_same_sha256;
                 }
             }
         }
@@ -3562,16 +4312,24 @@ int part_s_sha256_trans_map_to_entry_map(layer2_sha256s_to_s_arr* l2_arr, simple
 
 int part_s_sha512_trans_map_to_entry_map(layer2_sha512s_to_s_arr* l2_arr, simple_bitmap* s_sha512_trans_map, simple_bitmap* entry_map, char* s_sha512_part) {
     bit_index i, j;
+    uint32_t k;
     bit_index temp_index_skip_to, temp_index_result;
     bit_index temp_index_skip_to2, temp_index_result2;
 
+    unsigned char prefix[SHA512_DIGEST_LENGTH];
+    uint32_t prefix_bits;
+
     linked_entry* temp_entry;
-    section* temp_section;
+    t_sha512s_to_s* temp_tran;
 
     layer1_sha512s_to_s_arr* temp_l1_arr;
 
     bitmap_zero(entry_map);
 
+    if (hex_to_digest_prefix(prefix, &prefix_bits, s_sha512_part, SHA512_DIGEST_LENGTH)) {
+        return 0;   // not a prefix of any checksum
+    }
+
     for (i = 0, temp_index_skip_to = 0; i < s_sha512_trans_map->number_of_ones; i++) {
         // get index of L1 array that contains the translation structure
         bitmap_first_one_bit_index(s_sha512_trans_map, &temp_index_result, temp_index_skip_to);
@@ -3580,22 +4338,20 @@ int part_s_sha512_trans_map_to_entry_map(layer2_sha512s_to_s_arr* l2_arr, simple
         // get the L1 array
         get_l1_sha512s_to_s_from_layer2_arr(l2_arr, &temp_l1_arr, temp_index_result);
 
-        // go through the L1 array to find entries of partial matching string
+        // go through the L1 array to find entries with matching prefix
         for (j = 0, temp_index_skip_to2 = 0; j < temp_l1_arr->usage_map.number_of_ones; j++) {
             bitmap_first_one_bit_index(&temp_l1_arr->usage_map, &temp_index_result2, temp_index_skip_to2);
             temp_index_skip_to2 = temp_index_result2 + 1;
-            if (strstr(temp_l1_arr->arr[temp_index_result2].str, s_sha512_part)) {  // if entry contains target string as a substring
+            if (match_digest_prefix(temp_l1_arr->arr[temp_index_result2].key, prefix, prefix_bits)) {  // if checksum starts with target prefix
                 // mark all possible entries in bitmap
-                temp_section = temp_l1_arr->arr[temp_index_result2].head_tar;
+                temp_tran = temp_l1_arr->arr + temp_index_result2;
 
-                while (temp_section) {
-                    temp_entry = temp_section->parent_file_data->parent_entry;
+                for (k = 0; k < temp_tran->tar_num; k++) {
+                    temp_entry = temp_tran->tar[k].data->parent_entry;
 
                     ffp_grow_bitmap(entry_map, temp_entry->obj_arr_index + 1);
 
                     bitmap_write(entry_map, temp_entry->obj_arr_index, 1);
-
-                    temp_section = temp_section->next_same_sha512;
                 }
             }
         }
@@ -3677,9 +4433,7 @@ int scan_db(database_handle* dh, unsigned char* pattern, size_t pattern_size) {
 
     layer1_entry_arr*                   l1_entry_arr;
     layer1_file_data_arr*               l1_file_data_arr;
-    layer1_section_arr*                 l1_section_arr;
     layer1_misc_alloc_record_arr*       l1_misc_alloc_record_arr;
-    layer1_dtt_year_arr*                l1_dtt_year_arr;
 
     layer1_eid_to_e_arr*    l1_eid_to_e_arr;
     layer1_fn_to_e_arr*     l1_fn_to_e_arr;
@@ -3690,11 +4444,14 @@ int scan_db(database_handle* dh, unsigned char* pattern, size_t pattern_size) {
     layer1_sha1f_to_fd_arr*     l1_sha1f_to_fd_arr;
     layer1_sha256f_to_fd_arr*   l1_sha256f_to_fd_arr;
     layer1_sha512f_to_fd_arr*   l1_sha512f_to_fd_arr;
+    layer1_mrklf_to_fd_arr*     l1_mrklf_to_fd_arr;
 
     layer1_sha1s_to_s_arr*     l1_sha1s_to_s_arr;
     layer1_sha256s_to_s_arr*   l1_sha256s_to_s_arr;
     layer1_sha512s_to_s_arr*   l1_sha512s_to_s_arr;
 
+    file_data* temp_file_data;
+
     bit_index k;
 
     printf("scanning database : %s\n", dh->name);
@@ -3743,6 +4500,9 @@ int scan_db(database_handle* dh, unsigned char* pattern, size_t pattern_size) {
     //      sha512
     printf("scanning file data sha512 translation structures\n");
     scan_l2_arr(sha512f, fd, ret, ret2, k);
+    //      merkle
+    printf("scanning file data merkle translation structures\n");
+    scan_l2_arr(mrklf, fd, ret, ret2, k);
 
     // scan section checksum translation structures
     //      sha1
@@ -3766,15 +4526,36 @@ int scan_db(database_handle* dh, unsigned char* pattern, size_t pattern_size) {
     //      file data
     printf("scanning file data pool\n");
     scan_pool(file_data, ret, ret2, k);
-    //      section
-    printf("scanning section pool\n");
-    scan_pool(section, ret, ret2, k);
+    //      section extracts, kept per file data
+    printf("scanning section extract arrays\n");
+    for (k = 0; k < dh->l2_file_data_arr.l1_arr_map.length * L1_FILE_DATA_ARR_SIZE; k++) {
+        if (get_file_data_from_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, k)) {
+            continue;   // slot not used
+        }
+        if (!temp_file_data->sect_extract) {
+            continue;
+        }
+
+        ret2 = mem_scan(temp_file_data->sect_extract, sizeof(extract_sample) * EXTRACT_MAX_NUM * (temp_file_data->section_num + temp_file_data->section_free_num), pattern, pattern_size, ptr_buf, buf_size, &num_used);
+        if (ret2 == BUFFER_FULL) {
+            printf("scanner pointer buffer full\n");
+        }
+        else if (ret2) {
+            continue;
+        }
+
+        if (num_used > 0) {
+            sprintf(msg, "matches found within section extracts of file data #%"PRIu64"", k);
+            printf("%s%.*s : %"PRIu32"\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, num_used);
+
+            for (i = 0; i < num_used; i++) {
+                printf("#%d    address : %p    offset from extract array ptr : %ld\n", i, ptr_buf[i], (void*) ptr_buf[i] - (void*) temp_file_data->sect_extract);
+            }
+        }
+    }
     //      misc alloc record
     printf("scanning misc alloc record pool\n");
     scan_pool(misc_alloc_record, ret, ret2, k);
-    //      date time tree year
-    printf("scanning date time tree year pool\n");
-    scan_pool(dtt_year, ret, ret2, k);
 
     return 0;
 }
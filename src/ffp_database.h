@@ -57,6 +57,7 @@ int verify_tag_to_e(t_tag_to_e* tag_to_e, int* error_code, uint32_t flags);
 int verify_sha1f_to_fd(t_sha1f_to_fd* sha1f_to_fd, int* error_code, uint32_t flags);
 int verify_sha256f_to_fd(t_sha256f_to_fd* sha256f_to_fd, int* error_code, uint32_t flags);
 int verify_sha512f_to_fd(t_sha512f_to_fd* sha512f_to_fd, int* error_code, uint32_t flags);
+int verify_mrklf_to_fd(t_mrklf_to_fd* mrklf_to_fd, int* error_code, uint32_t flags);
 
 int verify_sha1s_to_s(t_sha1s_to_s* sha1s_to_s, int* error_code, uint32_t flags);
 int verify_sha256s_to_s(t_sha256s_to_s* sha256s_to_s, int* error_code, uint32_t flags);
@@ -124,6 +125,8 @@ int add_db (database_handle** dh_table, database_handle* target);
 int del_db (database_handle** dh_table, database_handle* dh);
 
 /* Entry ID lookup */
+int lookup_entry_id_key_via_dh (database_handle* dh, const unsigned char* eid, linked_entry** result);
+
 int lookup_entry_id_via_dh (database_handle* dh, const char* eid_str, linked_entry** result);
 
 int lookup_entry_id_part_via_dh (database_handle* dh, const char* eid_str_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_eid_to_e** result_buf, bit_index buf_size, bit_index* num_used);
@@ -131,14 +134,18 @@ int lookup_entry_id_part_via_dh (database_handle* dh, const char* eid_str_part,
 int lookup_entry_id_part_map_via_dh (database_handle* dh, const char* name_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 
 /* File name lookup */
-int lookup_file_name_via_dh (database_handle* dh, const char* file_name, linked_entry** result);
+int lookup_file_name_via_dh (database_handle* dh, const char* file_name, t_fn_to_e** result);
+
+int lookup_file_name_id_via_dh (database_handle* dh, str_id id, t_fn_to_e** result);
 
 int lookup_file_name_part_via_dh (database_handle* dh, const char* name_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_fn_to_e** result_buf, bit_index buf_size, bit_index* num_used);
 
 int lookup_file_name_part_map_via_dh (database_handle* dh, const char* name_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 
 /* Tag lookup */
-int lookup_tag_str_via_dh (database_handle* dh, const char* tag_str, linked_entry** result);
+int lookup_tag_str_via_dh (database_handle* dh, const char* tag_str, t_tag_to_e** result);
+
+int lookup_tag_str_id_via_dh (database_handle* dh, str_id id, t_tag_to_e** result);
 
 int lookup_tag_via_dh_with_preproc (database_handle* dh, const char* in_tag, simple_bitmap* map_buf, simple_bitmap* map_result, t_tag_to_e** result_buf, bit_index buf_size, bit_index* num_used);
 
@@ -149,22 +156,25 @@ int lookup_tag_part_via_dh_with_preproc (database_handle* dh, const char* in_tag
 int lookup_tag_part_map_via_dh_preproc (database_handle* dh, const char* in_tag, simple_bitmap* map_buf, simple_bitmap* map_result);
 
 /* File data checksum lookup */
-int lookup_file_sha1_via_dh (database_handle* dh, const char* checksum, file_data** result);
-int lookup_file_sha256_via_dh (database_handle* dh, const char* checksum, file_data** result);
-int lookup_file_sha512_via_dh (database_handle* dh, const char* checksum, file_data** result);
+int lookup_file_sha1_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha1f_to_fd** result);
+int lookup_file_sha256_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha256f_to_fd** result);
+int lookup_file_sha512_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha512f_to_fd** result);
+int lookup_file_mrkl_key_via_dh (database_handle* dh, const unsigned char* checksum, t_mrklf_to_fd** result);
 
 int lookup_file_sha1_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_sha1f_to_fd** result_buf, bit_index buf_size, bit_index* num_used);
 int lookup_file_sha256_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_sha256f_to_fd** result_buf, bit_index buf_size, bit_index* num_used);
 int lookup_file_sha512_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_sha512f_to_fd** result_buf, bit_index buf_size, bit_index* num_used);
+int lookup_file_mrkl_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_mrklf_to_fd** result_buf, bit_index buf_size, bit_index* num_used);
 
 int lookup_file_sha1_part_map_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 int lookup_file_sha256_part_map_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 int lookup_file_sha512_part_map_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result);
+int lookup_file_mrkl_part_map_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 
 /* Section checksum lookup */
-int lookup_sect_sha1_via_dh (database_handle* dh, const char* checksum, section** result);
-int lookup_sect_sha256_via_dh (database_handle* dh, const char* checksum, section** result);
-int lookup_sect_sha512_via_dh (database_handle* dh, const char* checksum, section** result);
+int lookup_sect_sha1_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha1s_to_s** result);
+int lookup_sect_sha256_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha256s_to_s** result);
+int lookup_sect_sha512_key_via_dh (database_handle* dh, const unsigned char* checksum, t_sha512s_to_s** result);
 
 int lookup_sect_sha1_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_sha1s_to_s** result_buf, bit_index buf_size, bit_index* num_used);
 int lookup_sect_sha256_part_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_sha256s_to_s** result_buf, bit_index buf_size, bit_index* num_used);
@@ -175,14 +185,16 @@ int lookup_sect_sha256_part_map_via_dh (database_handle* dh, const char* checksu
 int lookup_sect_sha512_part_map_via_dh (database_handle* dh, const char* checksum_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 
 /* File size lookup */
-int lookup_file_size_via_dh (database_handle* dh, const char* file_size, file_data** result);
+int lookup_file_size_via_dh (database_handle* dh, const char* file_size, t_f_size_to_fd** result);
 
 int lookup_file_size_part_via_dh (database_handle* dh, const char* file_size_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_f_size_to_fd** result_buf, bit_index buf_size, bit_index* num_used);
 
 int lookup_file_size_part_map_via_dh (database_handle* dh, const char* file_size_part, simple_bitmap* map_buf, simple_bitmap* map_result);
 
-/* Date time lookup */
-int lookup_date_time (database_handle* dh, unsigned char date_type, int16_t year, uint8_t month, uint8_t day, uint8_t hour, linked_entry** result);
+/* Date time lookup, time ranges are inclusive, see note on time index */
+int lookup_date_time (database_handle* dh, unsigned char date_type, int64_t from, int64_t to, linked_entry** result_buf, bit_index buf_size, bit_index* num_used);
+
+int lookup_date_time_map (database_handle* dh, unsigned char date_type, int64_t from, int64_t to, simple_bitmap* entry_map);
 
 int find_entry_in_sub_branch(database_handle* dh, linked_entry* sub_branch_head, field_record* rec, unsigned char only_examine_latest, field_match_bitmap* match_map, unsigned int score);
 
@@ -204,7 +216,7 @@ int set_new_entry_id(database_handle* dh, linked_entry* entry);
  *          depth
  *          time of addition
  *
- *      set_entry_general_info links entry to date time tree as well
+ *      set_entry_general_info links entry to time indices as well
  */
 int set_entry_general_info(database_handle* dh, linked_entry* entry);
 
@@ -231,18 +243,107 @@ int link_file_data_to_file_size_structures(database_handle* dh, file_data* targe
 int link_file_data_to_sha1_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result);
 
 int link_file_data_to_sha512_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result);
+int link_file_data_to_mrkl_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result);
 
 int link_file_data_to_sha256_structures(database_handle* dh, file_data* target, checksum_result* target_checksum_result);
 
 int link_file_data_to_checksum_structures(database_handle* dh, file_data* target);
 
+/*  Note on pending queue :
+ *      file data created by deferred fingerprinting only has what stat gives,
+ *      it is marked pending with the flags and absolute path to hash with later,
+ *      and kept in a queue per database in order of creation
+ *
+ *      path is allocated by caller and owned by the queue afterwards,
+ *      it is freed when file data is unlinked from the queue
+ */
+int link_file_data_to_pending_queue(database_handle* dh, file_data* target, uint32_t flags, char* path);
+
+int unlink_file_data_from_pending_queue(database_handle* dh, file_data* target);
+
+/*  Note on fuzzy index :
+ *      file data with fuzzy digest are indexed by every distinct gram of
+ *      FUZZY_GRAM_LEN characters of their signatures, together with block size,
+ *      as file data scoring above 0 always share a gram (see ffp_fuzzy.h),
+ *      lookup only needs to score file data found under grams of the target
+ */
+int link_file_data_to_fuzzy_index(database_handle* dh, file_data* target);
+
+int unlink_file_data_from_fuzzy_index(database_handle* dh, file_data* target);
+
+/*  Fuzzy lookup
+ *      follows rule for partial lookup functions using buffers,
+ *      similarity score of each result is put into score_buf at same index
+ *
+ *      only file data scoring at least min_score (and above 0) are returned,
+ *      results are not sorted
+ */
+int lookup_file_fuzzy_via_dh (database_handle* dh, const fuzzy_digest* digest, int min_score, file_data** result_buf, int* score_buf, bit_index buf_size, bit_index* num_used);
+
+/*  Note on extract index :
+ *      file data with extracts are indexed by a hash of position, length
+ *      and bytes of every extract, size is compared on lookup if recorded
+ *
+ *      as positions of extracts only depend on file size (see ffp_fingerprint.c),
+ *      a file on disk can be looked up by reading its extracts at those positions
+ *      (see sample_file_extracts), which costs a few small reads instead of
+ *      hashing the whole file, results are candidates to be confirmed by checksums
+ *
+ *      key used is kept in file data, so it can be unlinked after its fields change,
+ *      linking again moves it to its new key
+ */
+int link_file_data_to_extract_index(database_handle* dh, file_data* target);
+
+int unlink_file_data_from_extract_index(database_handle* dh, file_data* target);
+
+/*  Extract lookup
+ *      follows rule for partial lookup functions using buffers,
+ *      only file data of exactly the same size and extracts are returned
+ */
+int lookup_file_extract_via_dh (database_handle* dh, uint64_t file_size, const extract_sample* extract, uint32_t extract_num, file_data** result_buf, bit_index buf_size, bit_index* num_used);
+
 int grow_children_array(linked_entry* parent, ffp_eid_int increment);
 
 int put_into_children_array(linked_entry* parent, linked_entry* entry);
 
+/*  Sorted children
+ *      follows rule for partial lookup functions using buffers,
+ *      children are ordered by file name then entry id, starting from index start,
+ *      see note on child index in ffprinter.h
+ */
+int get_sorted_children(linked_entry* parent, ffp_eid_int start, linked_entry** result_buf, bit_index buf_size, bit_index* num_used);
+
+/*  Section storage
+ *      see note on section layout in ffprinter.h
+ *
+ *      norm_sect_size and last_sect_size should be set before sections are
+ *      appended, as positions are only stored when they cannot be derived
+ *
+ *      set_sect_pos switches file data to stored positions if the given
+ *      positions differ from the derived ones
+ *
+ *      sections should be unlinked from checksum structures before their
+ *      checksums are changed
+ */
 int grow_section_array(file_data* target, uint64_t increment);
 
-int put_into_section_array(file_data* target, section* sect);
+int append_sections(file_data* target, uint64_t num);
+
+int get_sect_pos(file_data* target, uint64_t sect_index, uint64_t* start_pos, uint64_t* end_pos);
+
+int set_sect_pos(file_data* target, uint64_t sect_index, uint64_t start_pos, uint64_t end_pos);
+
+int make_sect_noncontinuous(file_data* target);
+
+int get_sect_checksum(file_data* target, uint64_t sect_index, int chks_index, checksum_result* result);
+
+int set_sect_checksum(file_data* target, uint64_t sect_index, const checksum_result* checksum);
+
+int set_sect_checksums(file_data* target, uint64_t sect_index, const checksum_result* checksum_arr);
+
+int get_sect_extract_arr(file_data* target, uint64_t sect_index, extract_sample** result);
+
+int copy_section(file_data* dst, uint64_t dst_index, file_data* src, uint64_t src_index);
 
 int grow_sect_field_array(field_record* rec, uint64_t increment);
 
@@ -252,24 +353,60 @@ int init_field_record(layer2_sect_field_arr* l2_arr, field_record* rec);
 
 int init_field_match_bitmap(field_match_bitmap* match_map);
 
-int link_sect_to_sha1_structures(database_handle* dh, section* target, checksum_result* target_checksum_result);
+int link_sect_to_sha1_structures(database_handle* dh, file_data* data, uint64_t sect_index);
+
+int link_sect_to_sha256_structures(database_handle* dh, file_data* data, uint64_t sect_index);
 
-int link_sect_to_sha256_structures(database_handle* dh, section* target, checksum_result* target_checksum_result);
+int link_sect_to_sha512_structures(database_handle* dh, file_data* data, uint64_t sect_index);
 
-int link_sect_to_sha512_structures(database_handle* dh, section* target, checksum_result* target_checksum_result);
+int link_sect_to_checksum_structures(database_handle* dh, file_data* data, uint64_t sect_index);
 
-int link_sect_to_checksum_structures(database_handle* dh, section* target);
+int unlink_sect_from_checksum_structures(database_handle* dh, file_data* data, uint64_t sect_index);
+
+int unlink_sects_from_checksum_structures(database_handle* dh, file_data* data);
 
 int link_entry (database_handle* dh, linked_entry* new_parent, linked_entry* child);
 
 int copy_entry(database_handle* dh, linked_entry* dst_parent, linked_entry* src_entry, unsigned char recursive);
 
-int del_section (database_handle* dh, section* sect);
+// deletes sections marked in map, remaining sections are renumbered
+int del_sections (database_handle* dh, file_data* data, simple_bitmap* map);
 
 int del_file_data (database_handle* dh, file_data* data);
 
 int del_entry (database_handle* dh, linked_entry* entry);
 
+/*  Note on tree digest :
+ *      every entry carries a tree sum, which is the sum (mod 2^256)
+ *      of the tree hash of its children, and a tree hash, which is
+ *      sha256 over its type, name, file checksums, file size and tree sum
+ *
+ *      two entries with same tree sum have same children, compared recursively
+ *      by name and content, so comparison of trees can skip them entirely
+ *
+ *      since the sum does not depend on order of children, a change to one
+ *      entry only needs its old tree hash swapped for the new one in the
+ *      parent, and so on up to the root, which is O(depth)
+ *
+ *      tree digests are not stored in file, they are rebuilt after loading
+ *
+ *      tree_digest_update should be called after an entry is added,
+ *      or its name or file data changed, rebuild recomputes the whole branch
+ *      below the entry as well, which is used after bulk changes (e.g. fp)
+ *
+ *      tree_digest_update_new only digests entries which have no tree hash yet
+ *      (new entries start with all zero tree hash) and the entries above them,
+ *      for bulk additions spread over existing branches (e.g. fp --from-list)
+ *
+ *      tree_digest_detach should be called before an entry is removed
+ *      from its parent
+ */
+int tree_digest_update(linked_entry* entry, unsigned char rebuild);
+
+int tree_digest_update_new(linked_entry* entry);
+
+int tree_digest_detach(linked_entry* entry);
+
 /* map conversion */
 int part_name_trans_map_to_entry_map(layer2_fn_to_e_arr* l2_arr, simple_bitmap* name_trans_map, simple_bitmap* entry_map, char* name_part);
 
@@ -280,6 +417,7 @@ int part_f_sha1_trans_map_to_entry_map(layer2_sha1f_to_fd_arr* l2_arr, simple_bi
 int part_f_sha256_trans_map_to_entry_map(layer2_sha256f_to_fd_arr* l2_arr, simple_bitmap* f_sha256_trans_map, simple_bitmap* entry_map, char* f_sha256_part);
 
 int part_f_sha512_trans_map_to_entry_map(layer2_sha512f_to_fd_arr* l2_arr, simple_bitmap* f_sha512_trans_map, simple_bitmap* entry_map, char* f_sha512_part);
+int part_f_mrkl_trans_map_to_entry_map(layer2_mrklf_to_fd_arr* l2_arr, simple_bitmap* f_mrkl_trans_map, simple_bitmap* entry_map, char* f_mrkl_part);
 
 int part_s_sha1_trans_map_to_entry_map(layer2_sha1s_to_s_arr* l2_arr, simple_bitmap* s_sha1_trans_map, simple_bitmap* entry_map, char* s_sha1_part);
 
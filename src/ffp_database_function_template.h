@@ -36,8 +36,9 @@
         return lookup_##target_name(dh->tag_attr##_to_##tag_target, str, result);   \
     }
 
-#define lookup_generic_one_to_many_tran(tag_attr, tag_target, target_name, result_type) \
-    int lookup_##target_name (t_##tag_attr##_to_##tag_target* htab, const char* str, result_type ** result) { \
+/* targets are kept in tar of translation structure, so the translation structure is returned */
+#define lookup_generic_one_to_many_tran(tag_attr, tag_target, target_name) \
+    int lookup_##target_name (t_##tag_attr##_to_##tag_target* htab, const char* str, t_##tag_attr##_to_##tag_target ** result) { \
         t_##tag_attr##_to_##tag_target * temp_tran_find;                    \
                                                                             \
         HASH_FIND_STR(htab, str, temp_tran_find);                           \
@@ -46,16 +47,95 @@
             return FIND_FAIL;                                               \
         }                                                                   \
                                                                             \
-        *result = temp_tran_find->head_tar;                                 \
+        *result = temp_tran_find;                                           \
         return 0;                                                           \
     }
 
-#define lookup_generic_one_to_many_tran_via_dh(dh_type, tag_attr, tag_target, target_name, result_type) \
-    lookup_generic_one_to_many_tran(tag_attr, tag_target, target_name, result_type) \
-    int lookup_##target_name##_via_dh (dh_type* dh, const char* str, result_type ** result) { \
+#define lookup_generic_one_to_many_tran_via_dh(dh_type, tag_attr, tag_target, target_name) \
+    lookup_generic_one_to_many_tran(tag_attr, tag_target, target_name) \
+    int lookup_##target_name##_via_dh (dh_type* dh, const char* str, t_##tag_attr##_to_##tag_target ** result) { \
         return lookup_##target_name(dh->tag_attr##_to_##tag_target, str, result);   \
     }
 
+/* str is turned into id first, string never interned means no match */
+#define lookup_generic_one_to_many_str_id_tran_via_dh(dh_type, tag_attr, tag_target, target_name) \
+    int lookup_##target_name##_id_via_dh (dh_type* dh, str_id id, t_##tag_attr##_to_##tag_target ** result) { \
+        t_##tag_attr##_to_##tag_target * temp_tran_find;                    \
+                                                                            \
+        HASH_FIND(hh, dh->tag_attr##_to_##tag_target, &id, sizeof(str_id), temp_tran_find); \
+        if (!temp_tran_find) {                                              \
+            *result = 0;                                                    \
+            return FIND_FAIL;                                               \
+        }                                                                   \
+                                                                            \
+        *result = temp_tran_find;                                           \
+        return 0;                                                           \
+    }                                                                       \
+    int lookup_##target_name##_via_dh (dh_type* dh, const char* str, t_##tag_attr##_to_##tag_target ** result) { \
+        str_id id;                                                          \
+                                                                            \
+        if (str_intern_find(&dh->strs, str, strlen(str), &id)) {            \
+            *result = 0;                                                    \
+            return FIND_FAIL;                                               \
+        }                                                                   \
+                                                                            \
+        return lookup_##target_name##_id_via_dh(dh, id, result);            \
+    }
+
+#define lookup_generic_one_to_one_key_tran(tag_attr, tag_target, target_name, result_type, KEY_LEN) \
+    int lookup_##target_name (t_##tag_attr##_to_##tag_target* htab, const unsigned char* key, result_type ** result) { \
+        t_##tag_attr##_to_##tag_target * temp_tran_find;                    \
+                                                                            \
+        HASH_FIND_DIGEST(htab, key, KEY_LEN, temp_tran_find);               \
+        if (!temp_tran_find) {                                              \
+            *result = 0;                                                    \
+            return FIND_FAIL;                                               \
+        }                                                                   \
+                                                                            \
+        *result = temp_tran_find->tar;                                      \
+        return 0;                                                           \
+    }
+
+#define lookup_generic_one_to_one_key_tran_via_dh(dh_type, tag_attr, tag_target, target_name, result_type, KEY_LEN) \
+    lookup_generic_one_to_one_key_tran(tag_attr, tag_target, target_name, result_type, KEY_LEN) \
+    int lookup_##target_name##_via_dh (dh_type* dh, const unsigned char* key, result_type ** result) { \
+        return lookup_##target_name(dh->tag_attr##_to_##tag_target, key, result);   \
+    }
+
+#define lookup_generic_one_to_many_key_tran(tag_attr, tag_target, target_name, KEY_LEN) \
+    int lookup_##target_name (t_##tag_attr##_to_##tag_target* htab, const unsigned char* key, t_##tag_attr##_to_##tag_target ** result) { \
+        t_##tag_attr##_to_##tag_target * temp_tran_find;                    \
+                                                                            \
+        HASH_FIND_DIGEST(htab, key, KEY_LEN, temp_tran_find);               \
+        if (!temp_tran_find) {                                              \
+            *result = 0;                                                    \
+            return FIND_FAIL;                                               \
+        }                                                                   \
+                                                                            \
+        *result = temp_tran_find;                                           \
+        return 0;                                                           \
+    }
+
+#define lookup_generic_one_to_many_key_tran_via_dh(dh_type, tag_attr, tag_target, target_name, KEY_LEN) \
+    lookup_generic_one_to_many_key_tran(tag_attr, tag_target, target_name, KEY_LEN) \
+    int lookup_##target_name##_via_dh (dh_type* dh, const unsigned char* key, t_##tag_attr##_to_##tag_target ** result) { \
+        return lookup_##target_name(dh->tag_attr##_to_##tag_target, key, result);   \
+    }
+
+/* sections have no address of their own, so the translation structure is returned */
+#define lookup_generic_one_to_many_sect_key_tran_via_dh(dh_type, tag_attr, tag_target, target_name, KEY_LEN) \
+    int lookup_##target_name##_via_dh (dh_type* dh, const unsigned char* key, t_##tag_attr##_to_##tag_target ** result) { \
+        t_##tag_attr##_to_##tag_target * temp_tran_find;                    \
+                                                                            \
+        HASH_FIND_DIGEST(dh->tag_attr##_to_##tag_target, key, KEY_LEN, temp_tran_find); \
+        *result = temp_tran_find;                                           \
+        if (!temp_tran_find) {                                              \
+            return FIND_FAIL;                                               \
+        }                                                                   \
+                                                                            \
+        return 0;                                                           \
+    }
+
 #define lookup_generic_part_ranged(tag_attr, tag_target, target_name, STR_MAX_LEN) \
     int lookup_##target_name##_part_ranged (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_exist_mat* matrix, const char* str_part, int16_t start_pos_min, int16_t start_pos_max, simple_bitmap* map_buf, simple_bitmap* map_result, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
         int i, j;  /* used for counting */                                                      \
@@ -362,3 +442,270 @@
     int lookup_##target_name##_part_map_via_dh (dh_type* dh, const char* str_part, simple_bitmap* map_buf, simple_bitmap* map_result) { \
         return lookup_##target_name##_part_map(&dh->tag_attr##_mat, str_part, map_buf, map_result);    \
     }
+
+/* Partial lookups below go through gram index instead of existence matrix, see ffprinter.h
+ * results are exact, map_result marks only the L1 arrays holding a match
+ */
+#define lookup_generic_part_gram_ranged(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_ranged (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_gram_index* index, const char* str_part, int16_t start_pos_min, int16_t start_pos_max, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
+        gram_iter iter;                                                                         \
+                                                                                                \
+        bit_index temp_index;                                                                   \
+        bit_index temp_num_used = 0;                                                            \
+                                                                                                \
+        str_len_int str_part_len;                                                               \
+                                                                                                \
+        t_##tag_attr##_to_##tag_target * temp_tran;                                             \
+                                                                                                \
+        int ret;                                                                                \
+                                                                                                \
+        if (!num_used) {                                                                        \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        /* num_used defaults to 0 */                                                            \
+        *num_used = 0;                                                                          \
+                                                                                                \
+        if ((ret = verify_str_terminated(str_part, STR_MAX_LEN, &str_part_len, 0))) {           \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        if (buf_size == 0) {    /* should never get a zero size buffer */                       \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        if (start_pos_min >= 0 && start_pos_max >= 0 && start_pos_min > start_pos_max) {        \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        ret = gram_iter_init(&iter, index, str_part, str_part_len, l2_arr->l1_arr_map.length * L1_ARR_SIZE);\
+        if (ret == FIND_FAIL) { /* a gram of str_part is in no string */                        \
+            return 0;                                                                           \
+        }                                                                                       \
+        if (ret) {                                                                              \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        while (gram_iter_next(&iter, &temp_index) == 0) {                                       \
+            /* slot may be unused if going through layer 2 array */                             \
+            if (get_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, &temp_tran, temp_index)) {\
+                continue;                                                                       \
+            }                                                                                   \
+            /* candidate only has all grams, check string itself */                             \
+            if (!match_sub_min_max(temp_tran->str, str_part, start_pos_min, start_pos_max)) {   \
+                continue;                                                                       \
+            }                                                                                   \
+                                                                                                \
+            result_buf[temp_num_used] = temp_tran;                                              \
+            temp_num_used++;                                                                    \
+                                                                                                \
+            if (temp_num_used == buf_size) {                                                    \
+                *num_used = temp_num_used;                                                      \
+                return BUFFER_FULL; /* not necessarily an error, but let the caller know anyway */\
+            }                                                                                   \
+        }                                                                                       \
+                                                                                                \
+        *num_used = temp_num_used;                                                              \
+        return 0;                                                                               \
+    }
+
+#define lookup_generic_part_gram(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    lookup_generic_part_gram_ranged(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_gram_index* index, const char* str_part, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
+        return lookup_##target_name##_part_ranged(l2_arr, index, str_part, -1, -1, result_buf, buf_size, num_used); \
+    }
+
+// map_buf and map_result are not used, kept so the signature matches existence matrix lookups
+#define lookup_generic_part_gram_via_dh(dh_type, tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    lookup_generic_part_gram(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_via_dh (dh_type* dh, const char* str_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
+        return lookup_##target_name##_part(&dh->l2_##tag_attr##_to_##tag_target##_arr, &dh->tag_attr##_gram, str_part, result_buf, buf_size, num_used);    \
+    }
+
+#define lookup_generic_part_map_gram_ranged(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_map_ranged (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_gram_index* index, const char* str_part, int16_t start_pos_min, int16_t start_pos_max, simple_bitmap* map_result) { \
+        gram_iter iter;                                                                         \
+                                                                                                \
+        bit_index temp_index;                                                                   \
+                                                                                                \
+        str_len_int str_part_len;                                                               \
+                                                                                                \
+        t_##tag_attr##_to_##tag_target * temp_tran;                                             \
+                                                                                                \
+        int ret;                                                                                \
+                                                                                                \
+        if ((ret = verify_str_terminated(str_part, STR_MAX_LEN, &str_part_len, 0))) {           \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        if (start_pos_min >= 0 && start_pos_max >= 0 && start_pos_min > start_pos_max) {        \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        /* result map covers all L1 arrays */                                                   \
+        BACKUP_INTERRUPTABLE_FLAG();                                                            \
+                                                                                                \
+        SET_NOT_INTERRUPTABLE();                                                                \
+                                                                                                \
+        ret = ffp_grow_bitmap(map_result, l2_arr->l1_arr_map.length);                           \
+                                                                                                \
+        REVERT_INTERRUPTABLE_FLAG();                                                            \
+                                                                                                \
+        if (ret) {                                                                              \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        /* default result map to all 0 */                                                       \
+        bitmap_zero(map_result);                                                                \
+                                                                                                \
+        ret = gram_iter_init(&iter, index, str_part, str_part_len, l2_arr->l1_arr_map.length * L1_ARR_SIZE);\
+        if (ret == FIND_FAIL) { /* a gram of str_part is in no string */                        \
+            return 0;                                                                           \
+        }                                                                                       \
+        if (ret) {                                                                              \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        while (gram_iter_next(&iter, &temp_index) == 0) {                                       \
+            if (get_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, &temp_tran, temp_index)) {\
+                continue;                                                                       \
+            }                                                                                   \
+            if (!match_sub_min_max(temp_tran->str, str_part, start_pos_min, start_pos_max)) {   \
+                continue;                                                                       \
+            }                                                                                   \
+                                                                                                \
+            /* mark the L1 array, then skip the rest of it */                                   \
+            bitmap_write(map_result, temp_index / L1_ARR_SIZE, 1);                              \
+            gram_iter_skip(&iter, (temp_index / L1_ARR_SIZE + 1) * L1_ARR_SIZE);                \
+        }                                                                                       \
+                                                                                                \
+        return 0;                                                                               \
+    }
+
+#define lookup_generic_part_map_gram(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    lookup_generic_part_map_gram_ranged(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_map (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_gram_index* index, const char* str_part, simple_bitmap* map_result) { \
+        return lookup_##target_name##_part_map_ranged(l2_arr, index, str_part, -1, -1, map_result); \
+    }
+
+// map_buf is not used, kept so the signature matches existence matrix lookups
+#define lookup_generic_part_map_gram_via_dh(dh_type, tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    lookup_generic_part_map_gram(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_map_via_dh (dh_type* dh, const char* str_part, simple_bitmap* map_buf, simple_bitmap* map_result) { \
+        return lookup_##target_name##_part_map(&dh->l2_##tag_attr##_to_##tag_target##_arr, &dh->tag_attr##_gram, str_part, map_result);    \
+    }
+
+/* Partial lookups below go through digest index, see ffprinter.h
+ * str_part is a hex prefix of the key, results come in order of key
+ */
+#define lookup_generic_part_digest(tag_attr, tag_target, target_name, STR_MAX_LEN) \
+    int lookup_##target_name##_part (tag_attr##_digest_index* index, const char* str_part, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
+        digest_cursor cursor;                                                                   \
+                                                                                                \
+        unsigned char prefix[DIGEST_KEY_MAX_LEN];                                               \
+        uint32_t prefix_bits;                                                                   \
+                                                                                                \
+        bit_index temp_num_used = 0;                                                            \
+                                                                                                \
+        str_len_int str_part_len;                                                               \
+                                                                                                \
+        void* temp_obj;                                                                         \
+                                                                                                \
+        int ret;                                                                                \
+                                                                                                \
+        if (!num_used) {                                                                        \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        /* num_used defaults to 0 */                                                            \
+        *num_used = 0;                                                                          \
+                                                                                                \
+        if ((ret = verify_str_terminated(str_part, STR_MAX_LEN, &str_part_len, 0))) {           \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        if (buf_size == 0) {    /* should never get a zero size buffer */                       \
+            return WRONG_ARGS;                                                                  \
+        }                                                                                       \
+                                                                                                \
+        if (hex_to_digest_prefix(prefix, &prefix_bits, str_part, index->key_len)) {             \
+            return 0;   /* not a hex prefix of any key */                                       \
+        }                                                                                       \
+                                                                                                \
+        digest_cursor_init(&cursor, index, prefix, prefix_bits);                                \
+                                                                                                \
+        while (digest_cursor_next(&cursor, &temp_obj) == 0) {                                   \
+            result_buf[temp_num_used] = temp_obj;                                               \
+            temp_num_used++;                                                                    \
+                                                                                                \
+            if (temp_num_used == buf_size) {                                                    \
+                *num_used = temp_num_used;                                                      \
+                return BUFFER_FULL; /* not necessarily an error, but let the caller know anyway */\
+            }                                                                                   \
+        }                                                                                       \
+                                                                                                \
+        *num_used = temp_num_used;                                                              \
+        return 0;                                                                               \
+    }
+
+// map_buf and map_result are not used, kept so the signature matches existence matrix lookups
+#define lookup_generic_part_digest_via_dh(dh_type, tag_attr, tag_target, target_name, STR_MAX_LEN) \
+    lookup_generic_part_digest(tag_attr, tag_target, target_name, STR_MAX_LEN) \
+    int lookup_##target_name##_part_via_dh (dh_type* dh, const char* str_part, simple_bitmap* map_buf, simple_bitmap* map_result, t_##tag_attr##_to_##tag_target ** result_buf, bit_index buf_size, bit_index* num_used) { \
+        return lookup_##target_name##_part(&dh->tag_attr##_digest, str_part, result_buf, buf_size, num_used);    \
+    }
+
+#define lookup_generic_part_map_digest(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_map (layer2_##tag_attr##_to_##tag_target##_arr* l2_arr, tag_attr##_digest_index* index, const char* str_part, simple_bitmap* map_result) { \
+        digest_cursor cursor;                                                                   \
+                                                                                                \
+        unsigned char prefix[DIGEST_KEY_MAX_LEN];                                               \
+        uint32_t prefix_bits;                                                                   \
+                                                                                                \
+        str_len_int str_part_len;                                                               \
+                                                                                                \
+        void* temp_obj;                                                                         \
+        t_##tag_attr##_to_##tag_target * temp_tran;                                             \
+                                                                                                \
+        int ret;                                                                                \
+                                                                                                \
+        if ((ret = verify_str_terminated(str_part, STR_MAX_LEN, &str_part_len, 0))) {           \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        /* result map covers all L1 arrays */                                                   \
+        BACKUP_INTERRUPTABLE_FLAG();                                                            \
+                                                                                                \
+        SET_NOT_INTERRUPTABLE();                                                                \
+                                                                                                \
+        ret = ffp_grow_bitmap(map_result, l2_arr->l1_arr_map.length);                           \
+                                                                                                \
+        REVERT_INTERRUPTABLE_FLAG();                                                            \
+                                                                                                \
+        if (ret) {                                                                              \
+            return ret;                                                                         \
+        }                                                                                       \
+                                                                                                \
+        /* default result map to all 0 */                                                       \
+        bitmap_zero(map_result);                                                                \
+                                                                                                \
+        if (hex_to_digest_prefix(prefix, &prefix_bits, str_part, index->key_len)) {             \
+            return 0;   /* not a hex prefix of any key */                                       \
+        }                                                                                       \
+                                                                                                \
+        digest_cursor_init(&cursor, index, prefix, prefix_bits);                                \
+                                                                                                \
+        while (digest_cursor_next(&cursor, &temp_obj) == 0) {                                   \
+            temp_tran = temp_obj;                                                               \
+            bitmap_write(map_result, temp_tran->obj_arr_index / L1_ARR_SIZE, 1);                \
+        }                                                                                       \
+                                                                                                \
+        return 0;                                                                               \
+    }
+
+// map_buf is not used, kept so the signature matches existence matrix lookups
+#define lookup_generic_part_map_digest_via_dh(dh_type, tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    lookup_generic_part_map_digest(tag_attr, tag_target, target_name, STR_MAX_LEN, L1_ARR_SIZE) \
+    int lookup_##target_name##_part_map_via_dh (dh_type* dh, const char* str_part, simple_bitmap* map_buf, simple_bitmap* map_result) { \
+        return lookup_##target_name##_part_map(&dh->l2_##tag_attr##_to_##tag_target##_arr, &dh->tag_attr##_digest, str_part, map_result);    \
+    }
@@ -59,7 +59,7 @@ static int point_to_dh (dir_info* tar, database_handle* dh) {
 }
 
 static int point_to_entry (dir_info* tar, linked_entry* entry) {
-    strcpy(tar->entry_id, entry->entry_id_str);
+    bytes_to_hex_str(tar->entry_id, entry->entry_id, EID_LEN);
 
     tar->entry = entry;
 
@@ -194,7 +194,12 @@ int add_dh_to_root_dir (root_dir* root, char* name, database_handle** ret_dh, er
 
     // copy the name into the newly created database handle
     strcpy(temp_dh->name, name);
-    strcpy(temp_dh->tree.file_name, name);
+    if (set_entry_file_name(temp_dh, &temp_dh->tree, name)) {
+        error_write(er_h, "failed to allocate memory for database");
+        fres_database_handle(temp_dh);
+        free(temp_dh);
+        return MALLOC_FAIL;
+    }
 
     add_db(&root->db, temp_dh);
 
@@ -248,6 +253,7 @@ int path_to_dir(const dir_info* cur_dir_p, const char* path_buf, str_len_int* re
     database_handle* iter_dh, * iter_dh_temp;
 
     char buf[PATH_LEN_MAX+1];
+    char eid_str[EID_STR_MAX+1];
 
     str_len_int path_len;       // length of received path
     str_len_int rem_path_len;   // remaining path length
@@ -481,8 +487,9 @@ int path_to_dir(const dir_info* cur_dir_p, const char* path_buf, str_len_int* re
                     }
                 }
                 else if (mode == PDIR_MODE_EID) {
-                    if (strcmp(entry_buf[0]->entry_id_str, buf) != 0) {
-                        notify_ambig_resolve(buf, entry_buf[0]->entry_id_str);
+                    bytes_to_hex_str(eid_str, entry_buf[0]->entry_id, EID_LEN);
+                    if (strcmp(eid_str, buf) != 0) {
+                        notify_ambig_resolve(buf, eid_str);
                     }
                 }
             }
@@ -518,6 +525,8 @@ int dir_to_path(const dir_info* dir_p, char* path_buf, int mode, error_handle* e
 
     char path_buf2[PATH_LEN_MAX];
     char* path_cur2 = path_buf2;
+
+    char eid_str[EID_STR_MAX+1];
     str_len_int path_pos2 = 0;
 
     dir_info dir;
@@ -595,7 +604,7 @@ int dir_to_path(const dir_info* dir_p, char* path_buf, int mode, error_handle* e
                 }
                 else if (mode == PDIR_MODE_EID) {
                     ret_if_add_len_too_long(path_pos, EID_STR_MAX, er_h);
-                    strcpy(path_cur, cur_entry->entry_id_str);
+                    bytes_to_hex_str(path_cur, cur_entry->entry_id, EID_LEN);
                     path_pos += EID_STR_MAX;
                     path_cur += EID_STR_MAX;
                 }
@@ -665,7 +674,7 @@ int dir_to_path(const dir_info* dir_p, char* path_buf, int mode, error_handle* e
 
                         // fill in entry id
                         ret_if_add_len_too_long(path_pos, EID_STR_MAX, er_h);
-                        strcpy(path_cur, cur_entry->entry_id_str);
+                        bytes_to_hex_str(path_cur, cur_entry->entry_id, EID_LEN);
                         path_pos += EID_STR_MAX;
                         path_cur += EID_STR_MAX;
                     }
@@ -673,7 +682,8 @@ int dir_to_path(const dir_info* dir_p, char* path_buf, int mode, error_handle* e
                         temp_entry = cur_entry;
                         while (temp_entry != &cur_dh->tree) {    // while root of db not reached
                             /* no need to check if path too long */
-                            reverse_strcpy(path_cur2, temp_entry->entry_id_str);
+                            bytes_to_hex_str(eid_str, temp_entry->entry_id, EID_LEN);
+                            reverse_strcpy(path_cur2, eid_str);
                             path_pos2 += EID_STR_MAX;
                             path_cur2 += EID_STR_MAX;
                             path_buf2[path_pos2] = '/';
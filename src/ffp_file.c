@@ -17,6 +17,7 @@
  */
 
 #include "ffp_file.h"
+#include "ffp_fuzzy.h"
 
 #pragma GCC diagnostic ignored "-Wunused-function"
 
@@ -71,9 +72,9 @@ static int init_buffer_info(struct buffer_info* info, unsigned char* buffer, uns
 
 static int flush_buf (struct buffer_info* info);
 
-static void memcpy_forward(void* in_dst, void* in_src, uint32_t size) {
+static void memcpy_forward(void* in_dst, const void* in_src, uint32_t size) {
     unsigned char* dst = (unsigned char*) in_dst;
-    unsigned char* src = (unsigned char*) in_src;
+    const unsigned char* src = (const unsigned char*) in_src;
     unsigned char* dst_end = dst + size;
 
     debug_printf("memcpy_forward : ");
@@ -88,9 +89,9 @@ static void memcpy_forward(void* in_dst, void* in_src, uint32_t size) {
     debug_printf("\n");
 }
 
-static void memcpy_reverse(void* in_dst, void* in_src, uint32_t size) {
+static void memcpy_reverse(void* in_dst, const void* in_src, uint32_t size) {
     unsigned char* dst = (unsigned char*) in_dst;
-    unsigned char* src = (unsigned char*) in_src;
+    const unsigned char* src = (const unsigned char*) in_src;
     unsigned char* dst_end = dst;
 
     dst += size-1;
@@ -213,8 +214,8 @@ static int copy_buf_to_ptr (struct buffer_info* info, void* in_ptr, uint32_t siz
     return 0;
 }
 
-static int copy_ptr_to_buf (struct buffer_info* info, void* in_ptr, uint32_t size, unsigned char is_string) {
-    unsigned char* ptr = (unsigned char*) in_ptr;
+static int copy_ptr_to_buf (struct buffer_info* info, const void* in_ptr, uint32_t size, unsigned char is_string) {
+    const unsigned char* ptr = (const unsigned char*) in_ptr;
     unsigned int space = info->buffer_size - info->buffer_pos;  // empty space
 
     if (size > info->buffer_size) {
@@ -300,6 +301,10 @@ int load_file (database_handle* dh, char* file_name) {
 
     char eid_str_buf[EID_STR_MAX + 1];
 
+    char temp_file_name[FILE_NAME_MAX + 1];
+    char temp_tag_str[TAG_STR_MAX + 1];
+    char temp_user_msg[USER_MSG_MAX + 1];
+
     char version_buf[6];
 
     struct buffer_info info;
@@ -331,6 +336,7 @@ int load_file (database_handle* dh, char* file_name) {
     linked_entry* temp_entry;
     linked_entry* temp_parent_entry;
 
+    struct tm temp_time;        // times are stored as broken down utc in file
     int64_t temp_time_int64;
     int8_t temp_time_int8;
     uint8_t temp_time_uint8;
@@ -346,6 +352,20 @@ int load_file (database_handle* dh, char* file_name) {
     file_data* temp_file_data;
 
     section* temp_section;
+    uint64_t temp_start_pos;
+    uint64_t temp_end_pos;
+    checksum_result temp_sect_checksum;
+    extract_sample* temp_extract = NULL;
+
+    uint32_t temp_pending_flags;
+    uint16_t temp_path_len;
+    uint16_t temp_path_pos;
+    uint16_t temp_chunk_len;
+    char temp_path[FS_PATH_MAX+1];
+    char* temp_path_copy;
+
+    fuzzy_digest temp_fuzzy;
+    char temp_fuzzy_str[FUZZY_STR_MAX+1];
 
     misc_alloc_record*  temp_misc_alloc_record;
 
@@ -474,6 +494,7 @@ int load_file (database_handle* dh, char* file_name) {
         if (ret) {
             ret_close_file(ret, data_file);
         }
+        init_entry_strs(temp_entry);
 
         debug_printf("grabbing branch id\n");
 
@@ -484,8 +505,8 @@ int load_file (database_handle* dh, char* file_name) {
             ret_close_file(ret, data_file);
         }
 
-        bytes_to_hex_str(temp_entry->branch_id_str, temp_entry->branch_id, EID_LEN);
-        debug_printf("branch id : %s\n", temp_entry->branch_id_str);
+        bytes_to_hex_str(eid_str_buf, temp_entry->branch_id, EID_LEN);
+        debug_printf("branch id : %s\n", eid_str_buf);
 
         debug_printf("grabbing entry id\n");
 
@@ -496,8 +517,8 @@ int load_file (database_handle* dh, char* file_name) {
             ret_close_file(ret, data_file);
         }
 
-        bytes_to_hex_str(temp_entry->entry_id_str, temp_entry->entry_id, EID_LEN);
-        debug_printf("entry id : %s\n", temp_entry->entry_id_str);
+        bytes_to_hex_str(eid_str_buf, temp_entry->entry_id, EID_LEN);
+        debug_printf("entry id : %s\n", eid_str_buf);
 
         for (i = 0; i < EID_LEN; i++) {     // check if all 0
             if (temp_entry->entry_id[i] != 0) {
@@ -532,7 +553,7 @@ int load_file (database_handle* dh, char* file_name) {
             temp_entry->has_parent = 0;
         }
         else { // has parent apparently, attempt to find and link to it
-            lookup_entry_id_via_dh(dh, eid_str_buf, &temp_parent_entry);
+            lookup_entry_id_key_via_dh(dh, temp_parent_entry_id, &temp_parent_entry);
             if (!temp_parent_entry) {
                 printf("load_file : cannot find parent of entry\n");
                 ret_close_file(FIND_FAIL, data_file);
@@ -618,14 +639,19 @@ int load_file (database_handle* dh, char* file_name) {
         debug_printf("grabbing file name\n");
 
         // fill in file name
-        tmp = (unsigned char*) temp_entry->file_name;
+        tmp = (unsigned char*) temp_file_name;
         ret = copy_buf_to_ptr(&info, tmp, temp_entry->file_name_len, IS_STR);
         if (ret) {
             ret_close_file(ret, data_file);
         }
 
         // add null character
-        temp_entry->file_name[temp_entry->file_name_len] = 0;
+        temp_file_name[temp_entry->file_name_len] = 0;
+
+        ret = set_entry_file_name(dh, temp_entry, temp_file_name);
+        if (ret) {
+            ret_close_file(ret, data_file);
+        }
 
         debug_printf("file name : %s\n", temp_entry->file_name);
 
@@ -664,14 +690,19 @@ int load_file (database_handle* dh, char* file_name) {
             debug_printf("grabbing tag string\n");
 
             // fill in tag string
-            tmp = (unsigned char*) temp_entry->tag_str;
+            tmp = (unsigned char*) temp_tag_str;
             ret = copy_buf_to_ptr(&info, tmp, temp_entry->tag_str_len, 1);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // add null character
-            temp_entry->tag_str[temp_entry->tag_str_len] = 0;
+            temp_tag_str[temp_entry->tag_str_len] = 0;
+
+            ret = set_entry_tag_str(dh, temp_entry, temp_tag_str);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
 
             debug_printf("tag string : %s\n", temp_entry->tag_str);
 
@@ -713,13 +744,18 @@ int load_file (database_handle* dh, char* file_name) {
             debug_printf("grabbing user message\n");
 
             // fill in user message
-            tmp = (unsigned char*) temp_entry->user_msg;
+            tmp = (unsigned char*) temp_user_msg;
             ret = copy_buf_to_ptr(&info, tmp, temp_entry->user_msg_len, IS_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
-            temp_entry->user_msg[temp_entry->user_msg_len] = 0;
+            temp_user_msg[temp_entry->user_msg_len] = 0;
+
+            ret = set_entry_user_msg(temp_entry, temp_user_msg);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
 
             debug_printf("user message : %s\n", temp_entry->user_msg);
         }
@@ -736,9 +772,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_sec = temp_time_uint8;
+            temp_time.tm_sec = temp_time_uint8;
 
-            debug_printf("time of addition, seconds : %d\n", temp_entry->tod_utc.tm_sec);
+            debug_printf("time of addition, seconds : %d\n", temp_time.tm_sec);
 
             debug_printf("grabbing time of addition, minutes\n");
 
@@ -748,9 +784,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_min = temp_time_uint8;
+            temp_time.tm_min = temp_time_uint8;
 
-            debug_printf("time of addition, minutes : %d\n", temp_entry->tod_utc.tm_min);
+            debug_printf("time of addition, minutes : %d\n", temp_time.tm_min);
 
             debug_printf("grabbing time of addition, hours\n");
 
@@ -760,9 +796,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_hour = temp_time_uint8;
+            temp_time.tm_hour = temp_time_uint8;
 
-            debug_printf("time of addition, hours : %d\n", temp_entry->tod_utc.tm_hour);
+            debug_printf("time of addition, hours : %d\n", temp_time.tm_hour);
 
             debug_printf("grabbing time of addition, day of month\n");
 
@@ -772,9 +808,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_mday = temp_time_uint8;
+            temp_time.tm_mday = temp_time_uint8;
 
-            debug_printf("time of addition, day of month : %d\n", temp_entry->tod_utc.tm_mday);
+            debug_printf("time of addition, day of month : %d\n", temp_time.tm_mday);
 
             debug_printf("grabbing time of addition, month\n");
 
@@ -784,9 +820,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_mon = temp_time_uint8;
+            temp_time.tm_mon = temp_time_uint8;
 
-            debug_printf("time of addition, month : %d\n", temp_entry->tod_utc.tm_mon);
+            debug_printf("time of addition, month : %d\n", temp_time.tm_mon);
 
             debug_printf("grabbing time of addition, year\n");
 
@@ -800,9 +836,9 @@ int load_file (database_handle* dh, char* file_name) {
                 printf("load_file : invalid year in time of addition\n");
                 ret_close_file(FILE_BROKEN, data_file);
             }
-            temp_entry->tod_utc.tm_year = temp_time_int64;
+            temp_time.tm_year = temp_time_int64;
 
-            debug_printf("time of addition, year : %d\n", temp_entry->tod_utc.tm_year);
+            debug_printf("time of addition, year : %d\n", temp_time.tm_year);
 
             debug_printf("grabbing time of addition, week day\n");
 
@@ -812,9 +848,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_wday = temp_time_uint8;
+            temp_time.tm_wday = temp_time_uint8;
 
-            debug_printf("time of addition, week day : %d\n", temp_entry->tod_utc.tm_wday);
+            debug_printf("time of addition, week day : %d\n", temp_time.tm_wday);
 
             debug_printf("grabbing time of addition, year day\n");
 
@@ -824,9 +860,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_yday = temp_time_uint16;
+            temp_time.tm_yday = temp_time_uint16;
 
-            debug_printf("time of addition, year day : %d\n", temp_entry->tod_utc.tm_yday);
+            debug_printf("time of addition, year day : %d\n", temp_time.tm_yday);
 
             debug_printf("grabbing daylight saving flag\n");
 
@@ -836,12 +872,14 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tod_utc.tm_isdst = temp_time_int8;
+            temp_time.tm_isdst = temp_time_int8;
 
-            debug_printf("time of addition, daylight saving flag : %d\n", temp_entry->tod_utc.tm_isdst);
+            debug_printf("time of addition, daylight saving flag : %d\n", temp_time.tm_isdst);
 
             debug_printf("add entry to date time dh->tree\n");
 
+            temp_entry->tod_utc = utc_tm_to_epoch(&temp_time);
+
             link_entry_to_date_time_tree(dh, temp_entry, DATE_TOD);
         }
 
@@ -857,9 +895,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_sec = temp_time_uint8;
+            temp_time.tm_sec = temp_time_uint8;
 
-            debug_printf("time of modification, seconds : %d\n", temp_entry->tom_utc.tm_sec);
+            debug_printf("time of modification, seconds : %d\n", temp_time.tm_sec);
 
             debug_printf("grabbing time of modification, minutes\n");
 
@@ -869,9 +907,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_min = temp_time_uint8;
+            temp_time.tm_min = temp_time_uint8;
 
-            debug_printf("time of modification, minutes : %d\n", temp_entry->tom_utc.tm_min);
+            debug_printf("time of modification, minutes : %d\n", temp_time.tm_min);
 
             debug_printf("grabbing time of modification, hours\n");
 
@@ -881,9 +919,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_hour = temp_time_uint8;
+            temp_time.tm_hour = temp_time_uint8;
 
-            debug_printf("time of modification, hours : %d\n", temp_entry->tom_utc.tm_hour);
+            debug_printf("time of modification, hours : %d\n", temp_time.tm_hour);
 
             debug_printf("grabbing time of modification, day of month\n");
 
@@ -893,9 +931,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_mday = temp_time_uint8;
+            temp_time.tm_mday = temp_time_uint8;
 
-            debug_printf("time of modification, day of month : %d\n", temp_entry->tom_utc.tm_mday);
+            debug_printf("time of modification, day of month : %d\n", temp_time.tm_mday);
 
             debug_printf("grabbing time of modification, month\n");
 
@@ -905,9 +943,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_mon = temp_time_uint8;
+            temp_time.tm_mon = temp_time_uint8;
 
-            debug_printf("time of modification, month : %d\n", temp_entry->tom_utc.tm_mon);
+            debug_printf("time of modification, month : %d\n", temp_time.tm_mon);
 
             debug_printf("grabbing time of modification, year\n");
 
@@ -921,9 +959,9 @@ int load_file (database_handle* dh, char* file_name) {
                 printf("load_file : invalid year in time of modification\n");
                 ret_close_file(FILE_BROKEN, data_file);
             }
-            temp_entry->tom_utc.tm_year = temp_time_int64;
+            temp_time.tm_year = temp_time_int64;
 
-            debug_printf("time of modification, year : %d\n", temp_entry->tom_utc.tm_year);
+            debug_printf("time of modification, year : %d\n", temp_time.tm_year);
 
             debug_printf("grabbing time of modification, week day\n");
 
@@ -933,9 +971,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_wday = temp_time_uint8;
+            temp_time.tm_wday = temp_time_uint8;
 
-            debug_printf("time of modification, week day : %d\n", temp_entry->tom_utc.tm_wday);
+            debug_printf("time of modification, week day : %d\n", temp_time.tm_wday);
 
             debug_printf("grabbing time of modification, year day\n");
 
@@ -945,9 +983,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_yday = temp_time_uint16;
+            temp_time.tm_yday = temp_time_uint16;
 
-            debug_printf("time of modification, year day : %d\n", temp_entry->tom_utc.tm_yday);
+            debug_printf("time of modification, year day : %d\n", temp_time.tm_yday);
 
             debug_printf("grabbing daylight saving flag\n");
 
@@ -957,12 +995,14 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tom_utc.tm_isdst = temp_time_int8;
+            temp_time.tm_isdst = temp_time_int8;
 
-            debug_printf("time of modification, daylight saving flag : %d\n", temp_entry->tom_utc.tm_isdst);
+            debug_printf("time of modification, daylight saving flag : %d\n", temp_time.tm_isdst);
 
             debug_printf("add entry to date time dh->tree\n");
 
+            temp_entry->tom_utc = utc_tm_to_epoch(&temp_time);
+
             link_entry_to_date_time_tree(dh, temp_entry, DATE_TOM);
         }
 
@@ -978,9 +1018,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_sec = temp_time_uint8;
+            temp_time.tm_sec = temp_time_uint8;
 
-            debug_printf("user specified time, seconds : %d\n", temp_entry->tusr_utc.tm_sec);
+            debug_printf("user specified time, seconds : %d\n", temp_time.tm_sec);
 
             debug_printf("grabbing user specified time, minutes\n");
 
@@ -990,9 +1030,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_min = temp_time_uint8;
+            temp_time.tm_min = temp_time_uint8;
 
-            debug_printf("user specified time, minutes : %d\n", temp_entry->tusr_utc.tm_min);
+            debug_printf("user specified time, minutes : %d\n", temp_time.tm_min);
 
             debug_printf("grabbing user specified time, hours\n");
 
@@ -1002,9 +1042,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_hour = temp_time_uint8;
+            temp_time.tm_hour = temp_time_uint8;
 
-            debug_printf("user specified time, hours : %d\n", temp_entry->tusr_utc.tm_hour);
+            debug_printf("user specified time, hours : %d\n", temp_time.tm_hour);
 
             debug_printf("grabbing user specified time, day of month\n");
 
@@ -1014,9 +1054,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_mday = temp_time_uint8;
+            temp_time.tm_mday = temp_time_uint8;
 
-            debug_printf("user specified time, day of month : %d\n", temp_entry->tusr_utc.tm_mday);
+            debug_printf("user specified time, day of month : %d\n", temp_time.tm_mday);
 
             debug_printf("grabbing user specified time, month\n");
 
@@ -1026,9 +1066,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_mon = temp_time_uint8;
+            temp_time.tm_mon = temp_time_uint8;
 
-            debug_printf("user specified time, month : %d\n", temp_entry->tusr_utc.tm_mon);
+            debug_printf("user specified time, month : %d\n", temp_time.tm_mon);
 
             debug_printf("grabbing user specified time, year\n");
 
@@ -1038,9 +1078,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_year = temp_time_int64;
+            temp_time.tm_year = temp_time_int64;
 
-            debug_printf("user specified time, year : %d\n", temp_entry->tusr_utc.tm_year);
+            debug_printf("user specified time, year : %d\n", temp_time.tm_year);
 
             debug_printf("grabbing user specified time, week day\n");
 
@@ -1050,9 +1090,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_wday = temp_time_uint8;
+            temp_time.tm_wday = temp_time_uint8;
 
-            debug_printf("user specified time, week day : %d\n", temp_entry->tusr_utc.tm_wday);
+            debug_printf("user specified time, week day : %d\n", temp_time.tm_wday);
 
             debug_printf("grabbing user specified time, year day\n");
 
@@ -1062,9 +1102,9 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_yday = temp_time_uint16;
+            temp_time.tm_yday = temp_time_uint16;
 
-            debug_printf("user specified time, year day : %d\n", temp_entry->tusr_utc.tm_yday);
+            debug_printf("user specified time, year day : %d\n", temp_time.tm_yday);
 
             debug_printf("grabbing daylight saving flag\n");
 
@@ -1074,14 +1114,16 @@ int load_file (database_handle* dh, char* file_name) {
             if (ret) {
                 ret_close_file(ret, data_file);
             }
-            temp_entry->tusr_utc.tm_isdst = temp_time_int8;
+            temp_time.tm_isdst = temp_time_int8;
 
-            debug_printf("user specified time, daylight saving flag : %d\n", temp_entry->tusr_utc.tm_isdst);
+            debug_printf("user specified time, daylight saving flag : %d\n", temp_time.tm_isdst);
 
             debug_printf("add entry to date time dh->tree\n");
 
             debug_printf("add entry to date time dh->tree\n");
 
+            temp_entry->tusr_utc = utc_tm_to_epoch(&temp_time);
+
             link_entry_to_date_time_tree(dh, temp_entry, DATE_TUSR);
         }
 
@@ -1096,6 +1138,7 @@ int load_file (database_handle* dh, char* file_name) {
         // allocate space for file data
         add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
         temp_entry->data = temp_file_data;
+        temp_file_data->parent_entry = temp_entry;
 
         debug_printf("dealing with file data\n");
 
@@ -1119,9 +1162,15 @@ int load_file (database_handle* dh, char* file_name) {
 
         debug_printf("adding to file size translation structures\n");
 
-        // add entry to the file size translation hashtable
-        // or chain entry to other entries under same filename
-        link_file_data_to_file_size_structures(dh, temp_file_data);
+        sprintf(temp_file_data->file_size_str, "%"PRIu64"", temp_file_data->file_size);
+
+        // add file data to the file size translation hashtable
+        // or to posting array of file data with same size
+        ret = link_file_data_to_file_size_structures(dh, temp_file_data);
+        if (ret) {
+            printf("failed to link file data via file size\n");
+            ret_close_file(ret, data_file);
+        }
 
         debug_printf("grabbing number of checksum\n");
 
@@ -1164,6 +1213,9 @@ int load_file (database_handle* dh, char* file_name) {
                 case CHECKSUM_SHA512_ID :
                     temp_checksum_result = temp_file_data->checksum + CHECKSUM_SHA512_INDEX;
                     break;
+                case CHECKSUM_MRKL_ID :
+                    temp_checksum_result = temp_file_data->checksum + CHECKSUM_MRKL_INDEX;
+                    break;
                 default :
                     printf("load_file : invalid checksum type\n");
                     ret_close_file(FILE_BROKEN, data_file);
@@ -1298,6 +1350,8 @@ int load_file (database_handle* dh, char* file_name) {
             debug_printf("\n");
         }
 
+        // link to extract index now that size and extracts are known
+        link_file_data_to_extract_index(dh, temp_file_data);
 
         //** start to deal with sections **//
 
@@ -1312,13 +1366,6 @@ int load_file (database_handle* dh, char* file_name) {
 
         debug_printf("number of sections : %"PRIu64"\n", temp_sect_num);
 
-        // make space for the sections
-        if (temp_sect_num > 0) {
-            grow_section_array(temp_file_data, temp_sect_num);
-
-            record_misc_alloc(&dh->l2_misc_alloc_record_arr, temp_misc_alloc_record, ret, temp_file_data->section);
-        }
-
         debug_printf("grabbing normal section size\n");
 
         tmp = (unsigned char*) &temp_file_data->norm_sect_size;
@@ -1364,37 +1411,46 @@ int load_file (database_handle* dh, char* file_name) {
             ret_close_file(FILE_BROKEN, data_file);
         }
 
+        // make space for the sections, section sizes decide whether positions are stored
+        ret = append_sections(temp_file_data, temp_sect_num);
+        if (ret) {
+            ret_close_file(ret, data_file);
+        }
+
         debug_printf("dealing with sections\n");
 
         // go through sections
         for (i = 0; i < temp_sect_num; i++) {
-            add_section_to_layer2_arr(&dh->l2_section_arr, &temp_section, NULL);
-
-            put_into_section_array(temp_file_data, temp_section);
+            temp_section = temp_file_data->section + i;
 
             debug_printf("section #%d\n", i);
 
             debug_printf("grabbing section start position\n");
 
             // grab starting position
-            tmp = (unsigned char*) &temp_section->start_pos;
-            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(section, start_pos), NOT_STR);
+            tmp = (unsigned char*) &temp_start_pos;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof(temp_start_pos), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
-            debug_printf("start position : %"PRIu64"\n", temp_section->start_pos);
+            debug_printf("start position : %"PRIu64"\n", temp_start_pos);
 
             debug_printf("grabbing section end position\n");
 
             // grab ending position
-            tmp = (unsigned char*) &temp_section->end_pos;
-            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(section, end_pos), NOT_STR);
+            tmp = (unsigned char*) &temp_end_pos;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof(temp_end_pos), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
-            debug_printf("end position : %"PRIu64"\n", temp_section->end_pos);
+            debug_printf("end position : %"PRIu64"\n", temp_end_pos);
+
+            ret = set_sect_pos(temp_file_data, i, temp_start_pos, temp_end_pos);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
 
             debug_printf("grabbing number of checksum\n");
 
@@ -1429,13 +1485,9 @@ int load_file (database_handle* dh, char* file_name) {
 
                 switch (temp_checksum_type) {
                     case CHECKSUM_SHA1_ID :
-                        temp_checksum_result = temp_section->checksum + CHECKSUM_SHA1_INDEX;
-                        break;
                     case CHECKSUM_SHA256_ID :
-                        temp_checksum_result = temp_section->checksum + CHECKSUM_SHA256_INDEX;
-                        break;
                     case CHECKSUM_SHA512_ID :
-                        temp_checksum_result = temp_section->checksum + CHECKSUM_SHA512_INDEX;
+                        temp_checksum_result = &temp_sect_checksum;
                         break;
                     default :
                         printf("load_file : invalid checksum type\n");
@@ -1465,7 +1517,7 @@ int load_file (database_handle* dh, char* file_name) {
                 debug_printf("grabbing checksum result\n");
 
                 // fill in checksum result
-                tmp = (unsigned char*) temp_section->checksum[j].checksum;
+                tmp = (unsigned char*) temp_checksum_result->checksum;
                 ret = copy_buf_to_ptr(&info, tmp, temp_checksum_result->len, IS_STR);
                 if (ret) {
                     ret_close_file(ret, data_file);
@@ -1473,24 +1525,25 @@ int load_file (database_handle* dh, char* file_name) {
 
                 debug_printf("checksum result : ");
 #ifdef FFP_DEBUG
-                for (k = 0; k < temp_section->checksum[j].len; k++) {
+                for (k = 0; k < temp_checksum_result->len; k++) {
                     printf("%02X ", temp_checksum_result->checksum[k]);
                 }
                 debug_printf("\n");
 #endif
 
-                debug_printf("converting checksum to string\n");
+                debug_printf("storing checksum in section\n");
 
-                // add file checksums to hashtable
-                // convert checksum to string
-                bytes_to_hex_str(temp_checksum_result->checksum_str, temp_checksum_result->checksum, temp_checksum_result->len);
-
-                debug_printf("checksum string : %s\n", temp_checksum_result->checksum_str);
-
-                debug_printf("adding to checksum translation structures\n");
+                // length is checked against type here
+                ret = set_sect_checksum(temp_file_data, i, temp_checksum_result);
+                if (ret) {
+                    printf("load_file : invalid section checksum\n");
+                    ret_close_file(FILE_BROKEN, data_file);
+                }
             }
 
-            ret = link_sect_to_checksum_structures(dh, temp_section);
+            debug_printf("adding to checksum translation structures\n");
+
+            ret = link_sect_to_checksum_structures(dh, temp_file_data, i);
             if (ret) {
                 ret_close_file(FILE_BROKEN, data_file);
             }
@@ -1511,6 +1564,13 @@ int load_file (database_handle* dh, char* file_name) {
                 ret_close_file(FILE_BROKEN, data_file);
             }
 
+            if (temp_section->extract_num > 0) {
+                ret = get_sect_extract_arr(temp_file_data, i, &temp_extract);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+
             debug_printf("dealing with extracts\n");
 
             // fill in extract samples
@@ -1520,15 +1580,15 @@ int load_file (database_handle* dh, char* file_name) {
                 debug_printf("grabbing position of extract\n");
 
                 // fill in position of extract
-                tmp = (unsigned char*) &temp_section->extract[j].position;
+                tmp = (unsigned char*) &temp_extract[j].position;
                 ret = copy_buf_to_ptr(&info, tmp, sizeof_member(extract_sample, position), 0);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
 
-                debug_printf("position of extract : %"PRIu64"\n", temp_section->extract[j].position);
+                debug_printf("position of extract : %"PRIu64"\n", temp_extract[j].position);
 
-                if (temp_section->extract[j].position >= temp_entry->data->file_size) {
+                if (temp_extract[j].position >= temp_entry->data->file_size) {
                     printf("load_file : extract position exceeds or equal to file size\n");
                     ret_close_file(FILE_BROKEN, data_file);
                 }
@@ -1536,19 +1596,19 @@ int load_file (database_handle* dh, char* file_name) {
                 debug_printf("grabbing length of extract\n");
 
                 // fill in length of extract
-                tmp = (unsigned char*) &temp_section->extract[j].len;
+                tmp = (unsigned char*) &temp_extract[j].len;
                 ret = copy_buf_to_ptr(&info, tmp, sizeof_member(extract_sample, len), 0);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
 
-                debug_printf("length of extract : %u\n", temp_section->extract[j].len);
+                debug_printf("length of extract : %u\n", temp_extract[j].len);
 
-                if (temp_section->extract[j].len > EXTRACT_SIZE_MAX) {
+                if (temp_extract[j].len > EXTRACT_SIZE_MAX) {
                     printf("load_file : extract length exceeds maximum\n");
                     ret_close_file(FILE_BROKEN, data_file);
                 }
-                if (temp_section->extract[j].position + temp_section->extract[j].len > temp_entry->data->file_size) {
+                if (temp_extract[j].position + temp_extract[j].len > temp_entry->data->file_size) {
                     printf("load_file : extract cross the end of file\n");
                     ret_close_file(FILE_BROKEN, data_file);
                 }
@@ -1556,22 +1616,170 @@ int load_file (database_handle* dh, char* file_name) {
                 debug_printf("grabbing result of extraction\n");
 
                 // fill in the result of extraction
-                tmp = (unsigned char*) temp_section->extract[j].extract;
-                ret = copy_buf_to_ptr(&info, tmp, temp_section->extract[j].len, 1);
+                tmp = (unsigned char*) temp_extract[j].extract;
+                ret = copy_buf_to_ptr(&info, tmp, temp_extract[j].len, 1);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
 
                 debug_printf("result of extraction : ");
 #ifdef FFP_DEBUG
-                for (k = 0; k < temp_section->extract[j].len; k++) {
-                    printf("%02X ", temp_section->extract[j].extract[k]);
+                for (k = 0; k < temp_extract[j].len; k++) {
+                    printf("%02X ", temp_extract[j].extract[k]);
                 }
 #endif
                 debug_printf("\n");
             }
         }
 
+        if (field_presence_bitmap & HAS_DIGEST_STATE) {
+            debug_printf("grabbing digest state\n");
+
+            // grab position of digest state
+            tmp = (unsigned char*) &temp_file_data->resume.pos;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(digest_state, pos), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // grab flags of digest state
+            tmp = (unsigned char*) &temp_file_data->resume.flags;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(digest_state, flags), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // grab intermediate hash values
+            for (i = 0; i < 5; i++) {
+                tmp = (unsigned char*) &temp_file_data->resume.sha1_h[i];
+                ret = copy_buf_to_ptr(&info, tmp, sizeof(uint32_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+            for (i = 0; i < 8; i++) {
+                tmp = (unsigned char*) &temp_file_data->resume.sha256_h[i];
+                ret = copy_buf_to_ptr(&info, tmp, sizeof(uint32_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+            for (i = 0; i < 8; i++) {
+                tmp = (unsigned char*) &temp_file_data->resume.sha512_h[i];
+                ret = copy_buf_to_ptr(&info, tmp, sizeof(uint64_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+
+            debug_printf("digest state position : %"PRIu64"\n", temp_file_data->resume.pos);
+
+            if (        temp_file_data->resume.flags == 0
+                    ||  temp_file_data->resume.pos % DIGEST_STATE_BLOCK != 0
+                    ||  temp_file_data->resume.pos > temp_file_data->file_size
+               )
+            {
+                printf("load_file : invalid digest state\n");
+                ret_close_file(FILE_BROKEN, data_file);
+            }
+        }
+
+        if (field_presence_bitmap & HAS_PENDING_HASH) {
+            debug_printf("grabbing pending hash\n");
+
+            // grab flags to hash with
+            tmp = (unsigned char*) &temp_pending_flags;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(file_data, pending_flags), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // grab path length
+            tmp = (unsigned char*) &temp_path_len;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof(uint16_t), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            if (temp_pending_flags == 0 || temp_path_len == 0 || temp_path_len > FS_PATH_MAX) {
+                printf("load_file : invalid pending hash\n");
+                ret_close_file(FILE_BROKEN, data_file);
+            }
+
+            // grab path
+            for (temp_path_pos = 0; temp_path_pos < temp_path_len; temp_path_pos += temp_chunk_len) {
+                temp_chunk_len = ffp_min(PENDING_PATH_CHUNK, temp_path_len - temp_path_pos);
+
+                ret = copy_buf_to_ptr(&info, temp_path + temp_path_pos, temp_chunk_len, IS_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+            temp_path[temp_path_len] = 0;
+
+            debug_printf("pending path : %s\n", temp_path);
+
+            temp_path_copy = malloc(temp_path_len + 1);
+            if (!temp_path_copy) {
+                ret_close_file(MALLOC_FAIL, data_file);
+            }
+            strcpy(temp_path_copy, temp_path);
+
+            // queue it again, in the order entries were saved
+            link_file_data_to_pending_queue(dh, temp_file_data, temp_pending_flags, temp_path_copy);
+        }
+
+        if (field_presence_bitmap & HAS_FUZZY_DIGEST) {
+            debug_printf("grabbing fuzzy digest\n");
+
+            // grab block size
+            tmp = (unsigned char*) &temp_fuzzy.block_size;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(fuzzy_digest, block_size), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // grab signature lengths
+            tmp = (unsigned char*) &temp_fuzzy.len1;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(fuzzy_digest, len1), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+            tmp = (unsigned char*) &temp_fuzzy.len2;
+            ret = copy_buf_to_ptr(&info, tmp, sizeof_member(fuzzy_digest, len2), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            if (temp_fuzzy.len1 > FUZZY_SIG_MAX || temp_fuzzy.len2 > FUZZY_SIG_MAX / 2) {
+                printf("load_file : invalid fuzzy digest\n");
+                ret_close_file(FILE_BROKEN, data_file);
+            }
+
+            // grab signatures
+            ret = copy_buf_to_ptr(&info, temp_fuzzy.sig1, temp_fuzzy.len1, IS_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+            temp_fuzzy.sig1[temp_fuzzy.len1] = 0;
+            ret = copy_buf_to_ptr(&info, temp_fuzzy.sig2, temp_fuzzy.len2, IS_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+            temp_fuzzy.sig2[temp_fuzzy.len2] = 0;
+
+            // parsing checks block size and characters
+            fuzzy_digest_to_str(temp_fuzzy_str, &temp_fuzzy);
+            if (fuzzy_str_to_digest(&temp_file_data->fuzzy, temp_fuzzy_str)) {
+                printf("load_file : invalid fuzzy digest\n");
+                ret_close_file(FILE_BROKEN, data_file);
+            }
+
+            debug_printf("fuzzy digest : %s\n", temp_fuzzy_str);
+
+            link_file_data_to_fuzzy_index(dh, temp_file_data);
+        }
+
 skip_file:
 
         // extra line of defense
@@ -1591,7 +1799,7 @@ skip_file:
 
         //** add entry to other dh->tree/list/hashtable **//
         // add entry to eid_to_entry hashtable
-        lookup_entry_id_via_dh(dh, temp_entry->entry_id_str, &temp_entry_find);
+        lookup_entry_id_key_via_dh(dh, temp_entry->entry_id, &temp_entry_find);
         if (temp_entry_find) {  // duplicates
             printf("load_file : duplicated entry id\n");
             ret_close_file(DUPLICATE_ERROR, data_file);
@@ -1626,6 +1834,9 @@ skip_file:
 
     debug_printf("database file loaded\n");
 
+    // tree digests are not stored in file
+    tree_digest_update(&dh->tree, 1);
+
     printf("loading completed\n");
 
     ret_close_file(0, data_file);
@@ -1709,6 +1920,7 @@ int save_file (database_handle* dh, char* file_name) {
 
     long int file_pos;
 
+    struct tm temp_time;
     int64_t temp_time_int64;
     uint8_t temp_time_uint8;
     int8_t temp_time_int8;
@@ -1728,6 +1940,14 @@ int save_file (database_handle* dh, char* file_name) {
     file_data* temp_file_data;
 
     section* temp_section;
+    uint64_t temp_start_pos;
+    uint64_t temp_end_pos;
+    checksum_result temp_sect_checksum;
+    extract_sample* temp_extract;
+
+    uint16_t temp_path_len;
+    uint16_t temp_path_pos;
+    uint16_t temp_chunk_len;
 
     init_buffer_info(&info, buffer, buffer_secondary, DFILE_BUFFER_SIZE, BUF_WRITE);
 
@@ -1844,7 +2064,7 @@ int save_file (database_handle* dh, char* file_name) {
         }
 
         // write file name
-        ret = copy_ptr_to_buf(&info, &temp_entry->file_name, temp_entry->file_name_len, IS_STR);
+        ret = copy_ptr_to_buf(&info, temp_entry->file_name, temp_entry->file_name_len, IS_STR);
         if (ret) {
             ret_close_file(ret, data_file);
         }
@@ -1868,6 +2088,18 @@ int save_file (database_handle* dh, char* file_name) {
         }
         if (temp_entry->data) {
             field_presence_bitmap |= HAS_FILE_DATA;
+
+            if (temp_entry->data->resume.flags) {
+                field_presence_bitmap |= HAS_DIGEST_STATE;
+            }
+
+            if (temp_entry->data->pending_flags) {
+                field_presence_bitmap |= HAS_PENDING_HASH;
+            }
+
+            if (temp_entry->data->fuzzy.block_size) {
+                field_presence_bitmap |= HAS_FUZZY_DIGEST;
+            }
         }
         ret = copy_ptr_to_buf(&info, &field_presence_bitmap, sizeof(uint64_t), NOT_STR);
         if (ret) {
@@ -1882,7 +2114,7 @@ int save_file (database_handle* dh, char* file_name) {
             }
 
             // write tag string
-            ret = copy_ptr_to_buf(&info, &temp_entry->tag_str, temp_entry->tag_str_len, IS_STR);
+            ret = copy_ptr_to_buf(&info, temp_entry->tag_str, temp_entry->tag_str_len, IS_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
@@ -1896,78 +2128,80 @@ int save_file (database_handle* dh, char* file_name) {
             }
 
             // write user message
-            ret = copy_ptr_to_buf(&info, &temp_entry->user_msg, temp_entry->user_msg_len, IS_STR);
+            ret = copy_ptr_to_buf(&info, temp_entry->user_msg, temp_entry->user_msg_len, IS_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
         }
 
         if (temp_entry->tod_utc_used) {
+            epoch_to_utc_tm(temp_entry->tod_utc, &temp_time);
+
             // write time of addition of entry
             // seconds
-            temp_time_uint8 = temp_entry->tod_utc.tm_sec;
+            temp_time_uint8 = temp_time.tm_sec;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // minutes
-            temp_time_uint8 = temp_entry->tod_utc.tm_min;
+            temp_time_uint8 = temp_time.tm_min;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // hours
-            temp_time_uint8 = temp_entry->tod_utc.tm_hour;
+            temp_time_uint8 = temp_time.tm_hour;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day of month
-            temp_time_uint8 = temp_entry->tod_utc.tm_mday;
+            temp_time_uint8 = temp_time.tm_mday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // month
-            temp_time_uint8 = temp_entry->tod_utc.tm_mon;
+            temp_time_uint8 = temp_time.tm_mon;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year
-            temp_time_int64 = temp_entry->tod_utc.tm_year;
+            temp_time_int64 = temp_time.tm_year;
             ret = copy_ptr_to_buf(&info, &temp_time_int64, sizeof(int64_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // week day
-            temp_time_uint8 = temp_entry->tod_utc.tm_wday;
+            temp_time_uint8 = temp_time.tm_wday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year day
-            temp_time_uint16 = temp_entry->tod_utc.tm_yday;
+            temp_time_uint16 = temp_time.tm_yday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint16, sizeof(uint16_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day light saving flag
-            if (temp_entry->tod_utc.tm_isdst < 0) {
+            if (temp_time.tm_isdst < 0) {
                 temp_time_int8 = -1;
             }
-            else if (temp_entry->tod_utc.tm_isdst == 0) {
+            else if (temp_time.tm_isdst == 0) {
                 temp_time_int8 = 0;
             }
-            else if (temp_entry->tod_utc.tm_isdst > 0) {
+            else if (temp_time.tm_isdst > 0) {
                 temp_time_int8 = 1;
             }
             ret = copy_ptr_to_buf(&info, &temp_time_int8, sizeof(int8_t), NOT_STR);
@@ -1977,71 +2211,73 @@ int save_file (database_handle* dh, char* file_name) {
         }
 
         if (temp_entry->tom_utc_used) {
+            epoch_to_utc_tm(temp_entry->tom_utc, &temp_time);
+
             // write time of modification of entry
             // seconds
-            temp_time_uint8 = temp_entry->tom_utc.tm_sec;
+            temp_time_uint8 = temp_time.tm_sec;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // minutes
-            temp_time_uint8 = temp_entry->tom_utc.tm_min;
+            temp_time_uint8 = temp_time.tm_min;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // hours
-            temp_time_uint8 = temp_entry->tom_utc.tm_hour;
+            temp_time_uint8 = temp_time.tm_hour;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day of month
-            temp_time_uint8 = temp_entry->tom_utc.tm_mday;
+            temp_time_uint8 = temp_time.tm_mday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // month
-            temp_time_uint8 = temp_entry->tom_utc.tm_mon;
+            temp_time_uint8 = temp_time.tm_mon;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year
-            temp_time_int64 = temp_entry->tom_utc.tm_year;
+            temp_time_int64 = temp_time.tm_year;
             ret = copy_ptr_to_buf(&info, &temp_time_int64, sizeof(int64_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // week day
-            temp_time_uint8 = temp_entry->tom_utc.tm_wday;
+            temp_time_uint8 = temp_time.tm_wday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year day
-            temp_time_uint16 = temp_entry->tom_utc.tm_yday;
+            temp_time_uint16 = temp_time.tm_yday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint16, sizeof(uint16_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day light saving flag
-            if (temp_entry->tom_utc.tm_isdst < 0) {
+            if (temp_time.tm_isdst < 0) {
                 temp_time_int8 = -1;
             }
-            else if (temp_entry->tom_utc.tm_isdst == 0) {
+            else if (temp_time.tm_isdst == 0) {
                 temp_time_int8 = 0;
             }
-            else if (temp_entry->tom_utc.tm_isdst > 0) {
+            else if (temp_time.tm_isdst > 0) {
                 temp_time_int8 = 1;
             }
             ret = copy_ptr_to_buf(&info, &temp_time_int8, sizeof(int8_t), NOT_STR);
@@ -2051,71 +2287,73 @@ int save_file (database_handle* dh, char* file_name) {
         }
 
         if (temp_entry->tusr_utc_used) {
+            epoch_to_utc_tm(temp_entry->tusr_utc, &temp_time);
+
             // write user specified time of entry
             // seconds
-            temp_time_uint8 = temp_entry->tusr_utc.tm_sec;
+            temp_time_uint8 = temp_time.tm_sec;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // minutes
-            temp_time_uint8 = temp_entry->tusr_utc.tm_min;
+            temp_time_uint8 = temp_time.tm_min;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // hours
-            temp_time_uint8 = temp_entry->tusr_utc.tm_hour;
+            temp_time_uint8 = temp_time.tm_hour;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day of month
-            temp_time_uint8 = temp_entry->tusr_utc.tm_mday;
+            temp_time_uint8 = temp_time.tm_mday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // month
-            temp_time_uint8 = temp_entry->tusr_utc.tm_mon;
+            temp_time_uint8 = temp_time.tm_mon;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year
-            temp_time_int64 = temp_entry->tusr_utc.tm_year;
+            temp_time_int64 = temp_time.tm_year;
             ret = copy_ptr_to_buf(&info, &temp_time_int64, sizeof(int64_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // week day
-            temp_time_uint8 = temp_entry->tusr_utc.tm_wday;
+            temp_time_uint8 = temp_time.tm_wday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint8, sizeof(uint8_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // year day
-            temp_time_uint16 = temp_entry->tusr_utc.tm_yday;
+            temp_time_uint16 = temp_time.tm_yday;
             ret = copy_ptr_to_buf(&info, &temp_time_uint16, sizeof(uint16_t), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // day light saving flag
-            if (temp_entry->tusr_utc.tm_isdst < 0) {
+            if (temp_time.tm_isdst < 0) {
                 temp_time_int8 = -1;
             }
-            else if (temp_entry->tusr_utc.tm_isdst == 0) {
+            else if (temp_time.tm_isdst == 0) {
                 temp_time_int8 = 0;
             }
-            else if (temp_entry->tusr_utc.tm_isdst > 0) {
+            else if (temp_time.tm_isdst > 0) {
                 temp_time_int8 = 1;
             }
             ret = copy_ptr_to_buf(&info, &temp_time_int8, sizeof(int8_t), NOT_STR);
@@ -2228,26 +2466,27 @@ int save_file (database_handle* dh, char* file_name) {
 
         // write sections
         for (i = 0; i < temp_file_data->section_num; i++) {
-            temp_section = temp_file_data->section[i];
+            temp_section = temp_file_data->section + i;
+
+            // positions are written even if they can be derived
+            get_sect_pos(temp_file_data, i, &temp_start_pos, &temp_end_pos);
 
             // write starting position
-            ret = copy_ptr_to_buf(&info, &temp_section->start_pos, sizeof_member(section, start_pos), NOT_STR);
+            ret = copy_ptr_to_buf(&info, &temp_start_pos, sizeof(temp_start_pos), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // write ending position
-            ret = copy_ptr_to_buf(&info, &temp_section->end_pos, sizeof_member(section, end_pos), NOT_STR);
+            ret = copy_ptr_to_buf(&info, &temp_end_pos, sizeof(temp_end_pos), NOT_STR);
             if (ret) {
                 ret_close_file(ret, data_file);
             }
 
             // calculate number of checksums
             temp_checksum_num = 0;
-            for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
-                temp_checksum_result = temp_section->checksum + j;
-
-                if (temp_checksum_result->type != CHECKSUM_UNUSED) {
+            for (j = 0; j < SECT_CHECKSUM_NUM; j++) {
+                if (sect_has_checksum(temp_file_data, i, j)) {
                     temp_checksum_num++;
                 }
             }
@@ -2259,9 +2498,10 @@ int save_file (database_handle* dh, char* file_name) {
             }
 
             // write checksum results
-            for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
-                temp_checksum_result = temp_section->checksum + j;
+            for (j = 0; j < SECT_CHECKSUM_NUM; j++) {
+                temp_checksum_result = &temp_sect_checksum;
 
+                get_sect_checksum(temp_file_data, i, j, temp_checksum_result);
                 if (temp_checksum_result->type == CHECKSUM_UNUSED) {
                     continue;
                 }
@@ -2292,27 +2532,115 @@ int save_file (database_handle* dh, char* file_name) {
             }
 
             // write extract samples
+            temp_extract = sect_extract(temp_file_data, i);
             for (j = 0; j < temp_section->extract_num; j++) {
                 // write position of extract
-                ret = copy_ptr_to_buf(&info, &temp_section->extract[j].position, sizeof_member(extract_sample, position), NOT_STR);
+                ret = copy_ptr_to_buf(&info, &temp_extract[j].position, sizeof_member(extract_sample, position), NOT_STR);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
 
                 // write length of extract
-                ret = copy_ptr_to_buf(&info, &temp_section->extract[j].len, sizeof_member(extract_sample, len), NOT_STR);
+                ret = copy_ptr_to_buf(&info, &temp_extract[j].len, sizeof_member(extract_sample, len), NOT_STR);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
 
                 // write result of extraction
-                ret = copy_ptr_to_buf(&info, &temp_section->extract[j].extract, temp_section->extract[j].len, IS_STR);
+                ret = copy_ptr_to_buf(&info, &temp_extract[j].extract, temp_extract[j].len, IS_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+        }
+
+        if (field_presence_bitmap & HAS_DIGEST_STATE) {
+            // write position of digest state
+            ret = copy_ptr_to_buf(&info, &temp_file_data->resume.pos, sizeof_member(digest_state, pos), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write flags of digest state
+            ret = copy_ptr_to_buf(&info, &temp_file_data->resume.flags, sizeof_member(digest_state, flags), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write intermediate hash values
+            for (i = 0; i < 5; i++) {
+                ret = copy_ptr_to_buf(&info, &temp_file_data->resume.sha1_h[i], sizeof(uint32_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+            for (i = 0; i < 8; i++) {
+                ret = copy_ptr_to_buf(&info, &temp_file_data->resume.sha256_h[i], sizeof(uint32_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+            for (i = 0; i < 8; i++) {
+                ret = copy_ptr_to_buf(&info, &temp_file_data->resume.sha512_h[i], sizeof(uint64_t), NOT_STR);
+                if (ret) {
+                    ret_close_file(ret, data_file);
+                }
+            }
+        }
+
+        if (field_presence_bitmap & HAS_PENDING_HASH) {
+            // write flags to hash with
+            ret = copy_ptr_to_buf(&info, &temp_file_data->pending_flags, sizeof_member(file_data, pending_flags), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write path length
+            temp_path_len = strlen(temp_file_data->pending_path);
+            ret = copy_ptr_to_buf(&info, &temp_path_len, sizeof(uint16_t), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write path
+            for (temp_path_pos = 0; temp_path_pos < temp_path_len; temp_path_pos += temp_chunk_len) {
+                temp_chunk_len = ffp_min(PENDING_PATH_CHUNK, temp_path_len - temp_path_pos);
+
+                ret = copy_ptr_to_buf(&info, temp_file_data->pending_path + temp_path_pos, temp_chunk_len, IS_STR);
                 if (ret) {
                     ret_close_file(ret, data_file);
                 }
             }
         }
 
+        if (field_presence_bitmap & HAS_FUZZY_DIGEST) {
+            // write block size
+            ret = copy_ptr_to_buf(&info, &temp_file_data->fuzzy.block_size, sizeof_member(fuzzy_digest, block_size), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write signature lengths
+            ret = copy_ptr_to_buf(&info, &temp_file_data->fuzzy.len1, sizeof_member(fuzzy_digest, len1), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+            ret = copy_ptr_to_buf(&info, &temp_file_data->fuzzy.len2, sizeof_member(fuzzy_digest, len2), NOT_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+
+            // write signatures
+            ret = copy_ptr_to_buf(&info, temp_file_data->fuzzy.sig1, temp_file_data->fuzzy.len1, IS_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+            ret = copy_ptr_to_buf(&info, temp_file_data->fuzzy.sig2, temp_file_data->fuzzy.len2, IS_STR);
+            if (ret) {
+                ret_close_file(ret, data_file);
+            }
+        }
+
 skip_file:
 
         temp_entry = temp_entry->link_next;
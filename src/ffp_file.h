@@ -33,6 +33,11 @@
 #define HAS_MOD_TIME    0x0000000000000008LL
 #define HAS_USR_TIME    0x0000000000000010LL
 #define HAS_FILE_DATA   0x0000000000000020LL
+#define HAS_DIGEST_STATE 0x0000000000000040LL
+#define HAS_PENDING_HASH 0x0000000000000080LL
+#define HAS_FUZZY_DIGEST 0x0000000000000100LL
+
+#define PENDING_PATH_CHUNK  256     // pending path is copied in pieces to fit file buffer
 
 #define DFILE_BUFFER_SIZE   1024
 
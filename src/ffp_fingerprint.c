@@ -18,7 +18,12 @@
 
 #include "ffp_fingerprint.h"
 #include "ffp_database.h"
+#include "ffp_throttle.h"
+#include "ffp_afalg.h"
+#include "ffp_fuzzy.h"
+#include "ffp_hcache.h"
 #include "ffprinter_function_template.h"
+#include "ffp_fingerprint_function_template.h"
 
 #define record_dirp(l2_arr, temp_record, ret, target, max_index, er_h) \
     ret = add_dirp_record_to_layer2_arr(l2_arr, &temp_record, NULL);    \
@@ -77,10 +82,11 @@ get_obj_from_layer2_arr(dirp_record, dirp_record, L1_DIRP_RECORD_ARR_SIZE)
 get_l1_obj_from_layer2_arr(dirp_record)
 del_l2_obj_arr(dirp_record, L2_DIRP_RECORD_INIT_SIZE, L2_DIRP_RECORD_GROW_SIZE)
 
-int fill_rand_name(linked_entry* entry) {
+int fill_rand_name(database_handle* dh, linked_entry* entry) {
     int i;
 
     unsigned char name_bytes[FILE_NAME_MAX+1];
+    char name_str[FILE_NAME_MAX+1];
 
     int actual_file_name_len =
         ffp_min
@@ -95,11 +101,9 @@ int fill_rand_name(linked_entry* entry) {
     }
 
     // convert to hex string
-    bytes_to_hex_str(entry->file_name, name_bytes, actual_file_name_len / 2);
+    bytes_to_hex_str(name_str, name_bytes, actual_file_name_len / 2);
 
-    entry->file_name_len = strlen(entry->file_name);
-
-    return 0;
+    return set_entry_file_name(dh, entry, name_str);
 }
 
 static int path_to_file_name (const char* path, char* file_name) {
@@ -156,7 +160,69 @@ static int path_to_file_name (const char* path, char* file_name) {
     return 0;
 }
 
-int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t flags, unsigned char recursive, ffp_eid_int* rem_depth, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used, layer2_dirp_record_arr* l2_dirp_record_arr, bit_index* max_dirp_record_index) {
+// create a system made entry under parent, name is ignored if names are not used
+static int new_fs_entry (database_handle* dh, linked_entry* parent, const char* name, unsigned char type, uint32_t flags, linked_entry** result, error_handle* er_h) {
+    int ret;
+
+    linked_entry* entry;
+
+    char name_buf[FILE_NAME_MAX+1];
+
+    // grab space for entry
+    ret = add_entry_to_layer2_arr(&dh->l2_entry_arr, &entry, NULL);
+    if (ret) {
+        error_write(er_h, "failed to get space for entry");
+        return ret;
+    }
+    init_entry_strs(entry);
+
+    // no digest yet, see note on tree digest
+    memset(entry->tree_sum, 0, TREE_DIGEST_LENGTH);
+    memset(entry->tree_hash, 0, TREE_DIGEST_LENGTH);
+
+    // generate entry id
+    ret = set_new_entry_id(dh, entry);
+    if (ret) {
+        error_write(er_h, "failed to generate new entry id");
+        return ret;
+    }
+
+    // link to entry id related structures
+    link_entry_to_entry_id_structures(dh, entry);
+
+    // put into parent
+    put_into_children_array(parent, entry);
+
+    entry->type = type;
+
+    // fill in file name
+    if (flags & FPRINT_USE_F_NAME) {
+        strncpy(name_buf, name, FILE_NAME_MAX);
+        name_buf[FILE_NAME_MAX] = 0;
+
+        ret = set_entry_file_name(dh, entry, name_buf);
+    }
+    else {
+        ret = fill_rand_name(dh, entry);
+    }
+    if (ret) {
+        error_write(er_h, "failed to allocate memory for file name");
+        return ret;
+    }
+
+    // link to file name related structures
+    link_entry_to_file_name_structures(dh, entry);
+
+    set_entry_general_info(dh, entry);
+
+    entry->created_by = CREATED_BY_SYS;
+
+    *result = entry;
+
+    return 0;
+}
+
+int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t flags, unsigned char recursive, ffp_eid_int* rem_depth, walk_filter* filter, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used, layer2_dirp_record_arr* l2_dirp_record_arr, bit_index* max_dirp_record_index) {
     int ret;
 
     struct stat tar_stat;
@@ -169,9 +235,16 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
 
     dirp_record* temp_dirp_record;
 
+    char file_name[FILE_NAME_MAX+1];
+
+    int filter_result;
+
     error_mark_starter(er_h, "gen_tree");
 
     if (rem_depth && *rem_depth == 0) {
+        if (filter) {
+            filter->depth_num++;
+        }
         return 0;
     }
 
@@ -203,32 +276,9 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
         // set loose resource
         record_dirp(l2_dirp_record_arr, temp_dirp_record, ret, dirp, max_dirp_record_index, er_h);
 
-        // grab space for entry
-        ret = add_entry_to_layer2_arr(&dh->l2_entry_arr, &entry, NULL);
-        if (ret) {
-            error_write(er_h, "failed to get space for entry");
-            return ret;
-        }
-
-        // generate entry id
-        ret = set_new_entry_id(dh, entry);
-        if (ret) {
-            error_write(er_h, "failed to generate new entry id");
-            return ret;
-        }
-
-        // link to entry id related structures
-        link_entry_to_entry_id_structures(dh, entry);
-
-        // put into parent
-        put_into_children_array(parent, entry);
-
-        // set as group type
-        entry->type = ENTRY_GROUP;
-
-        // fill in file name
+        // work out file name
         if (flags & FPRINT_USE_F_NAME) {
-            ret = path_to_file_name(path, entry->file_name);
+            ret = path_to_file_name(path, file_name);
             switch (ret) {
                 case 0 :
                     break;
@@ -239,19 +289,13 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
                     error_write(er_h, "unknown error");
                     return ret;
             }
-
-            entry->file_name_len = strlen(entry->file_name);
-        }
-        else {
-            fill_rand_name(entry);
         }
 
-        // link to file name related structures
-        link_entry_to_file_name_structures(dh, entry);
-
-        set_entry_general_info(dh, entry);
-
-        entry->created_by = CREATED_BY_SYS;
+        // create group type entry
+        ret = new_fs_entry(dh, parent, file_name, ENTRY_GROUP, flags, &entry, er_h);
+        if (ret) {
+            return ret;
+        }
 
         MARK_DB_UNSAVED(dh);
 
@@ -262,6 +306,14 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
             return FS_FILE_ACCESS_FAIL;
         }
 
+        if (filter) {
+            ret = walk_filter_enter_dir(filter);
+            if (ret) {
+                error_write(er_h, "failed to read ignore rules");
+                return ret;
+            }
+        }
+
         while ((dp = readdir(dirp))) {
             if (        strcmp(dp->d_name, ".")     == 0
                     ||  strcmp(dp->d_name, "..")    == 0
@@ -279,13 +331,29 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
                     ||  S_ISREG(tar_stat.st_mode)
                )
             {
-                gen_tree(dh, dp->d_name, entry, flags, recursive, rem_depth, er_h, entry_being_used, file_being_used, l2_dirp_record_arr, max_dirp_record_index);
+                // skipped directories are never opened, entries beyond depth are counted by gen_tree instead
+                if (filter && !(rem_depth && *rem_depth == 0)) {
+                    ret = walk_filter_check(filter, dp->d_name, &tar_stat, &filter_result);
+                    if (ret) {
+                        error_write(er_h, "failed to match ignore rules");
+                        return ret;
+                    }
+                    if (filter_result != WALK_KEEP) {
+                        continue;
+                    }
+                }
+
+                gen_tree(dh, dp->d_name, entry, flags, recursive, rem_depth, filter, er_h, entry_being_used, file_being_used, l2_dirp_record_arr, max_dirp_record_index);
             }
             else /* other file types */ {
                 ;;  // ignore
             }
         }
 
+        if (filter) {
+            walk_filter_leave_dir(filter);
+        }
+
         SET_NOT_INTERRUPTABLE();
 
         if (closedir(dirp)) {
@@ -304,37 +372,9 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
         SET_INTERRUPTABLE();
     }
     else if (S_ISREG(tar_stat.st_mode)) {
-        SET_NOT_INTERRUPTABLE();
-
-        // grab space for entry
-        ret = add_entry_to_layer2_arr(&dh->l2_entry_arr, &entry, NULL);
-        if (ret) {
-            error_write(er_h, "failed to get space for entry");
-            return ret;
-        }
-
-        // set loose resource
-        *entry_being_used = entry;
-
-        // generate entry id
-        ret = set_new_entry_id(dh, entry);
-        if (ret) {
-            error_write(er_h, "failed to generate new entry id");
-            return ret;
-        }
-
-        // link to entry id related structures
-        link_entry_to_entry_id_structures(dh, entry);
-
-        // put into parent
-        put_into_children_array(parent, entry);
-
-        // set as file type
-        entry->type = ENTRY_FILE;
-
-        // fill in file name
+        // work out file name
         if (flags & FPRINT_USE_F_NAME) {
-            ret = path_to_file_name(path, entry->file_name);
+            ret = path_to_file_name(path, file_name);
             switch (ret) {
                 case 0 :
                     break;
@@ -345,19 +385,18 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
                     error_write(er_h, "unknown error");
                     return ret;
             }
-
-            entry->file_name_len = strlen(entry->file_name);
-        }
-        else {
-            fill_rand_name(entry);
         }
 
-        // link entry to file name related structures
-        link_entry_to_file_name_structures(dh, entry);
+        SET_NOT_INTERRUPTABLE();
 
-        set_entry_general_info(dh, entry);
+        // create file type entry
+        ret = new_fs_entry(dh, parent, file_name, ENTRY_FILE, flags, &entry, er_h);
+        if (ret) {
+            return ret;
+        }
 
-        entry->created_by = CREATED_BY_SYS;
+        // set loose resource
+        *entry_being_used = entry;
 
         SET_INTERRUPTABLE();
 
@@ -385,104 +424,14 @@ int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t fl
     return 0;
 }
 
-int fingerprint_file (database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used) {
-    FILE* file;
-    long int file_size;
-    struct stat file_stat;
-    file_data* temp_file_data;
-    section* temp_section;
-    checksum_result* temp_checksum;
-    extract_sample* temp_extract;
+// work out section layout for content of given size
+static int calc_sect_layout(uint64_t file_size, uint64_t* sect_num_p, uint64_t* norm_sect_size_p, uint64_t* last_sect_size_p) {
     uint64_t sect_num;
     uint64_t norm_sect_size;
     uint64_t last_sect_size;
-    uint64_t extract_pos;
-    uint16_t extract_num;
-    uint8_t extract_len;
-    int bytes, bytes_left;
-    uint64_t i, j;
-    int ret2;
-    int ret;
-
-    SHA_CTX wf_sha1;
-    SHA_CTX s_sha1;
-    unsigned char sha1_digest   [   SHA_DIGEST_LENGTH       ];
-
-    SHA256_CTX wf_sha256;
-    SHA256_CTX s_sha256;
-    unsigned char sha256_digest [   SHA256_DIGEST_LENGTH    ];
-
-    SHA512_CTX wf_sha512;
-    SHA512_CTX s_sha512;
-    unsigned char sha512_digest [   SHA512_DIGEST_LENGTH    ];
-
-    unsigned char data_buf[FILE_BUFFER_SIZE];   // 1KiB
-
-    unsigned char fread_failed = 0;
-
-    uint32_t sections_needed;
-
-    error_mark_starter(er_h, "fingerprint_file");
-
-    *file_being_used = NULL;
-
-    if ((ret = verify_str_terminated(path, FS_PATH_MAX, NULL, 0x0))) {
-        return ret;
-    }
-
-    if (stat(path, &file_stat)) {
-        error_write(er_h, "failed to get stats - file may not exist");
-        return FFP_GENERAL_FAIL;
-    }
-
-    if (        !S_ISREG(file_stat.st_mode)
-            &&  !S_ISDIR(file_stat.st_mode)
-       )
-    {
-        return FS_UNRECOGNISED_FILE_TYPE;
-    }
-
-    SET_NOT_INTERRUPTABLE();
-
-    file = fopen(path, "rb");
-    if (!file) {
-        error_write(er_h, "unable to open file");
-        return FOPEN_FAIL;
-    }
-
-    *file_being_used = file;
-
-    SET_INTERRUPTABLE();
-
-    file_size = file_stat.st_size;
 
-    if (file_size == 0) {
-        return 0;
-    }
-
-    if (file_size > FILE_SIZE_MAX) {
-        printf("fingerprint_file : %s : file too large\n", entry->file_name);
-        return FS_FILE_TOO_LARGE;
-    }
-
-    // initialise file wise hash structures
-    if (flags & FPRINT_USE_F_SHA1) {
-        SHA1_Init(&wf_sha1);
-    }
-    if (flags & FPRINT_USE_F_SHA256) {
-        SHA256_Init(&wf_sha256);
-    }
-    if (flags & FPRINT_USE_F_SHA512) {
-        SHA512_Init(&wf_sha512);
-    }
-
-    sections_needed
-        =   (flags & FPRINT_USE_S_EXTR)
-        |   (flags & FPRINT_USE_S_SHA1)
-        |   (flags & FPRINT_USE_S_SHA256)
-        |   (flags & FPRINT_USE_S_SHA512);
+    int i;
 
-    // handle sections
     if (file_size < SECT_SIZE_SMALL) {   // overly small
         sect_num = 1;
         norm_sect_size = file_size;
@@ -498,13 +447,8 @@ int fingerprint_file (database_handle* dh, char* path, linked_entry* entry, uint
                 if (file_size < file_size_class_arr[i]) {   // lies within class
                     sect_num = sect_ideal_num_arr[i];
                 }
-
-                if (i == 0) {   // avoid underflow and wrap around in case i is unsigned
-                    break;
-                }
             }
             if (sect_num == 0) {
-                printf("fingerprint_file : logic error\n");
                 return LOGIC_ERROR;
             }
         }
@@ -516,378 +460,3157 @@ int fingerprint_file (database_handle* dh, char* path, linked_entry* entry, uint
         }
     }
 
-    SET_NOT_INTERRUPTABLE();
+    *sect_num_p = sect_num;
+    *norm_sect_size_p = norm_sect_size;
+    *last_sect_size_p = last_sect_size;
 
-    // make space for file data
-    ret = add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
-    if (ret) {
-        error_write(er_h, "failed to get space for file data");
-        return ret;
+    return 0;
+}
+
+// work out extract sampling for content of given length
+static void calc_extract_layout(uint64_t len, uint16_t* extract_num_p, uint8_t* extract_len_p) {
+    uint16_t extract_num;
+    uint8_t extract_len;
+
+    if (len < EXTRACT_SIZE_MAX) {   // too small
+        extract_num = 1;
+        extract_len = len;
+    }
+    else if (len < EXTRACT_MAX_NUM * EXTRACT_SIZE_MAX) {
+        extract_num = len / EXTRACT_SIZE_MAX;     // deliberately truncating
+        extract_len = EXTRACT_SIZE_MAX;
+    }
+    else {      // expected normal length
+        extract_num = EXTRACT_MAX_NUM;
+        extract_len = EXTRACT_SIZE_MAX;
+    }
+    if (100 * extract_num * extract_len / len > EXTRACT_LEAK_MAX_PERCENT) {
+        extract_len = 1;
+        extract_num =
+            ffp_min(
+                    len * EXTRACT_LEAK_MAX_PERCENT / 100,
+                    EXTRACT_MAX_NUM
+                   );
     }
-    entry->data = temp_file_data;
 
-    if (sections_needed) {
-        // make space for sections
-        grow_section_array(temp_file_data, sect_num);
-        for (i = 0; i < sect_num; i++) {
-            ret = add_section_to_layer2_arr(&dh->l2_section_arr, &temp_section, NULL);
-            if (ret) {
-                error_write(er_h, "failed to get space for section");
-                goto fingerprint_done;
-            }
+    *extract_num_p = extract_num;
+    *extract_len_p = extract_len;
+}
 
-            put_into_section_array(temp_file_data, temp_section);
-        }
+// fill in positions and lengths of extracts for content at [start, start + len)
+static void set_extract_positions(extract_sample* extract, uint32_t* extract_num_p, uint64_t start, uint64_t len) {
+    uint16_t extract_num;
+    uint8_t extract_len;
 
-        temp_file_data->norm_sect_size = norm_sect_size;
-        temp_file_data->last_sect_size = last_sect_size;
-    }
+    uint16_t i;
 
-    SET_INTERRUPTABLE();
+    calc_extract_layout(len, &extract_num, &extract_len);
 
-    // start reading content
-    for (i = 0; i < sect_num; i++) {
-        if (sections_needed) {
-            temp_section = entry->data->section[i];
-            if (i < sect_num - 1) {
-                temp_section->start_pos = i * norm_sect_size;
-                temp_section->end_pos   = temp_section->start_pos + norm_sect_size - 1;
-            }
-            else {
-                temp_section->start_pos = i * norm_sect_size;
-                temp_section->end_pos   = temp_section->start_pos + last_sect_size - 1;
-            }
+    for (i = 0; i < extract_num; i++) {
+        extract[i].position = start + i * (len / extract_num);
+        extract[i].len = extract_len;
+    }
 
-            if (i < sect_num - 1) {
-                bytes_left = norm_sect_size;
-            }
-            else {
-                bytes_left = last_sect_size;
-            }
+    *extract_num_p = extract_num;
+}
 
-            if (flags & FPRINT_USE_S_SHA1) {
-                SHA1_Init(&s_sha1);
-            }
-            if (flags & FPRINT_USE_S_SHA256) {
-                SHA256_Init(&s_sha256);
-            }
-            if (flags & FPRINT_USE_S_SHA512) {
-                SHA512_Init(&s_sha512);
-            }
-        }
+// copy bytes of extracts which fall within buffer holding content at [buf_pos, buf_pos + buf_len)
+static void capture_extracts(extract_sample* extract, uint32_t extract_num, const unsigned char* buf, uint64_t buf_pos, uint64_t buf_len) {
+    uint32_t i;
 
-        while (bytes_left > 0) {
-            bytes = fread(data_buf, 1, ffp_min(FILE_BUFFER_SIZE, bytes_left), file);
-            if (bytes == 0) {
-                break;
-            }
-            bytes_left -= bytes;
+    uint64_t start, end;
 
-            if (flags & FPRINT_USE_F_SHA1) {
-                SHA1_Update(&wf_sha1, data_buf, bytes);
-            }
-            if (flags & FPRINT_USE_F_SHA256) {
-                SHA256_Update(&wf_sha256, data_buf, bytes);
-            }
-            if (flags & FPRINT_USE_F_SHA512) {
-                SHA512_Update(&wf_sha512, data_buf, bytes);
-            }
+    for (i = 0; i < extract_num; i++) {
+        start = ffp_max(extract[i].position, buf_pos);
+        end = ffp_min(extract[i].position + extract[i].len, buf_pos + buf_len);
 
-            if (sections_needed) {
-                if (flags & FPRINT_USE_S_SHA1) {
-                    SHA1_Update(&s_sha1, data_buf, bytes);
-                }
-                if (flags & FPRINT_USE_S_SHA256) {
-                    SHA256_Update(&s_sha256, data_buf, bytes);
-                }
-                if (flags & FPRINT_USE_S_SHA512) {
-                    SHA512_Update(&s_sha512, data_buf, bytes);
-                }
-            }
+        if (start < end) {
+            memcpy(extract[i].extract + (start - extract[i].position), buf + (start - buf_pos), end - start);
         }
+    }
+}
 
-        if (sections_needed) {
-            // initialise section wise checksums to unused
-            for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
-                temp_checksum = temp_section->checksum + j;
-                temp_checksum->type = CHECKSUM_UNUSED;
-            }
-
-            // section wise checksums
-            if (flags & FPRINT_USE_S_SHA1) {
-                SHA1_Final(sha1_digest, &s_sha1);
-                temp_checksum = temp_section->checksum + CHECKSUM_SHA1_INDEX;
-                memcpy(temp_checksum->checksum, sha1_digest, SHA_DIGEST_LENGTH);
-                temp_checksum->type = CHECKSUM_SHA1_ID;
-                temp_checksum->len = SHA_DIGEST_LENGTH;
-                bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-            }
-            if (flags & FPRINT_USE_S_SHA256) {
-                SHA256_Final(sha256_digest, &s_sha256);
-                temp_checksum = temp_section->checksum + CHECKSUM_SHA256_INDEX;
-                memcpy(temp_checksum->checksum, sha256_digest, SHA256_DIGEST_LENGTH);
-                temp_checksum->type = CHECKSUM_SHA256_ID;
-                temp_checksum->len = SHA256_DIGEST_LENGTH;
-                bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-            }
-            if (flags & FPRINT_USE_S_SHA512) {
-                SHA512_Final(sha512_digest, &s_sha512);
-                temp_checksum = temp_section->checksum + CHECKSUM_SHA512_INDEX;
-                memcpy(temp_checksum->checksum, sha512_digest, SHA512_DIGEST_LENGTH);
-                temp_checksum->type = CHECKSUM_SHA512_ID;
-                temp_checksum->len = SHA512_DIGEST_LENGTH;
-                bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-            }
+// fill extracts with content at their positions
+static int read_extracts_at(int fd, extract_sample* extract, uint32_t extract_num) {
+    uint32_t i;
 
-            link_sect_to_checksum_structures(dh, temp_section);
+    for (i = 0; i < extract_num; i++) {
+        if (afalg_pread(fd, extract[i].extract, extract[i].len, extract[i].position)) {
+            return AFALG_IO_FAIL;
         }
+    }
+
+    return 0;
+}
 
-        if (bytes_left != 0 && bytes == 0) {
-            fread_failed = 1;
+/* digest helpers */
 
-            printf("fingerprint_file : warning, file ended before fingerprinting is finished\n");
+typedef struct digest_ctx digest_ctx;
 
-            // edit current section as last section
-            if (i < sect_num - 1) { // if not already last section
-                last_sect_size = norm_sect_size - bytes_left;
-            }
-            else {  // if already last section
-                last_sect_size = last_sect_size - bytes_left;
-                if (sect_num == 1) {
-                    norm_sect_size = last_sect_size;
-                }
-            }
+// FPRINT_USE_F_SHA* bits to mask of (1 << CHECKSUM_*_INDEX)
+#define F_SUM_TO_ALG_MASK(use)  (((use) & FPRINT_F_SUM_MASK) >> 3)
 
-            if (sect_num > 1) {     // re-adjust section number if needed
-                temp_file_data->section_num = sect_num - (i + 1);
-                temp_file_data->section_free_num = sect_num - temp_file_data->section_num;
-            }
+struct digest_ctx {
+    uint32_t use;   // FPRINT_USE_F_SHA* bits of checksums in use
 
-            // reduce section number
-            sect_num = i + 1;
+    SHA_CTX     sha1;
+    SHA256_CTX  sha256;
+    SHA512_CTX  sha512;
 
-            // re-adjust file size
-            file_size = (sect_num - 1) * norm_sect_size + last_sect_size;
+    unsigned char in_kernel;
+    afalg_ctx kernel;
+};
 
-            break;
-        }
+static void digest_init(digest_ctx* ctx, uint32_t use) {
+    ctx->use = use;
+    ctx->in_kernel = 0;
+
+    if (use & FPRINT_USE_F_SHA1) {
+        SHA1_Init(&ctx->sha1);
+    }
+    if (use & FPRINT_USE_F_SHA256) {
+        SHA256_Init(&ctx->sha256);
     }
+    if (use & FPRINT_USE_F_SHA512) {
+        SHA512_Init(&ctx->sha512);
+    }
+}
 
-    // initialise whole file checksums to unused
-    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
-        temp_checksum = temp_file_data->checksum + i;
-        temp_checksum->type = CHECKSUM_UNUSED;
+static void digest_update(digest_ctx* ctx, const unsigned char* buf, size_t len) {
+    if (ctx->use & FPRINT_USE_F_SHA1) {
+        SHA1_Update(&ctx->sha1, buf, len);
+    }
+    if (ctx->use & FPRINT_USE_F_SHA256) {
+        SHA256_Update(&ctx->sha256, buf, len);
     }
+    if (ctx->use & FPRINT_USE_F_SHA512) {
+        SHA512_Update(&ctx->sha512, buf, len);
+    }
+}
 
+static void fill_checksum_result(checksum_result* checksum, uint16_t type, const unsigned char* digest, uint16_t len) {
+    memcpy(checksum->checksum, digest, len);
+    checksum->type = type;
+    checksum->len = len;
+    bytes_to_hex_str(checksum->checksum_str, checksum->checksum, len);
+}
 
-    // whole file checksums
-    if (flags & FPRINT_USE_F_SHA1) {
-        SHA1_Final(sha1_digest, &wf_sha1);
-        temp_checksum = temp_file_data->checksum + CHECKSUM_SHA1_INDEX;
-        memcpy(temp_checksum->checksum, sha1_digest, SHA_DIGEST_LENGTH);
-        temp_checksum->type = CHECKSUM_SHA1_ID;
-        temp_checksum->len = SHA_DIGEST_LENGTH;
-        bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-    }
-    if (flags & FPRINT_USE_F_SHA256) {
-        SHA256_Final(sha256_digest, &wf_sha256);
-        temp_checksum = temp_file_data->checksum + CHECKSUM_SHA256_INDEX;
-        memcpy(temp_checksum->checksum, sha256_digest, SHA256_DIGEST_LENGTH);
-        temp_checksum->type = CHECKSUM_SHA256_ID;
-        temp_checksum->len = SHA256_DIGEST_LENGTH;
-        bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-    }
-    if (flags & FPRINT_USE_F_SHA512) {
-        SHA512_Final(sha512_digest, &wf_sha512);
-        temp_checksum = temp_file_data->checksum + CHECKSUM_SHA512_INDEX;
-        memcpy(temp_checksum->checksum, sha512_digest, SHA512_DIGEST_LENGTH);
-        temp_checksum->type = CHECKSUM_SHA512_ID;
-        temp_checksum->len = SHA512_DIGEST_LENGTH;
-        bytes_to_hex_str(temp_checksum->checksum_str, temp_checksum->checksum, temp_checksum->len);
-    }
+// all checksums are computed in kernel, content is fed with digest_splice
+static int digest_init_kernel(digest_ctx* ctx, uint32_t use) {
+    ctx->use = use;
+    ctx->in_kernel = 1;
 
-    SET_NOT_INTERRUPTABLE();
+    return afalg_open(&ctx->kernel, F_SUM_TO_ALG_MASK(use));
+}
 
-    // fill in file size
-    if (flags & FPRINT_USE_F_SIZE) {
-        temp_file_data->file_size = file_size;
-        sprintf(temp_file_data->file_size_str, "%"PRIu64"", file_size);
+// feed content of fd at [pos, pos + len) to kernel checksums
+static int digest_splice(digest_ctx* ctx, int fd, uint64_t pos, uint64_t len) {
+    return afalg_splice(&ctx->kernel, fd, pos, len);
+}
 
-        // link to file size related structures
-        link_file_data_to_file_size_structures(dh, temp_file_data);
+static void digest_abort(digest_ctx* ctx) {
+    if (ctx->in_kernel) {
+        afalg_close(&ctx->kernel);
     }
+}
+
+// checksum should point to array of CHECKSUM_MAX_NUM results, unused ones are marked as such
+static int digest_final(digest_ctx* ctx, checksum_result* checksum) {
+    unsigned char sha1_digest   [   SHA_DIGEST_LENGTH       ];
+    unsigned char sha256_digest [   SHA256_DIGEST_LENGTH    ];
+    unsigned char sha512_digest [   SHA512_DIGEST_LENGTH    ];
+
+    int i;
+
+    if (ctx->in_kernel) {
+        return afalg_final(&ctx->kernel, checksum);
+    }
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        checksum[i].type = CHECKSUM_UNUSED;
+    }
+
+    if (ctx->use & FPRINT_USE_F_SHA1) {
+        SHA1_Final(sha1_digest, &ctx->sha1);
+        fill_checksum_result(checksum + CHECKSUM_SHA1_INDEX, CHECKSUM_SHA1_ID, sha1_digest, SHA_DIGEST_LENGTH);
+    }
+    if (ctx->use & FPRINT_USE_F_SHA256) {
+        SHA256_Final(sha256_digest, &ctx->sha256);
+        fill_checksum_result(checksum + CHECKSUM_SHA256_INDEX, CHECKSUM_SHA256_ID, sha256_digest, SHA256_DIGEST_LENGTH);
+    }
+    if (ctx->use & FPRINT_USE_F_SHA512) {
+        SHA512_Final(sha512_digest, &ctx->sha512);
+        fill_checksum_result(checksum + CHECKSUM_SHA512_INDEX, CHECKSUM_SHA512_ID, sha512_digest, SHA512_DIGEST_LENGTH);
+    }
+
+    return 0;
+}
+
+// only valid at DIGEST_STATE_BLOCK boundary, where no data is buffered in ctx
+static void digest_save(digest_ctx* ctx, uint64_t pos, uint32_t flags, digest_state* state) {
+    int i;
+
+    state->pos = pos;
+    state->flags = flags;
+
+    state->sha1_h[0] = ctx->sha1.h0;
+    state->sha1_h[1] = ctx->sha1.h1;
+    state->sha1_h[2] = ctx->sha1.h2;
+    state->sha1_h[3] = ctx->sha1.h3;
+    state->sha1_h[4] = ctx->sha1.h4;
+
+    for (i = 0; i < 8; i++) {
+        state->sha256_h[i] = ctx->sha256.h[i];
+        state->sha512_h[i] = ctx->sha512.h[i];
+    }
+}
+
+static void digest_restore(digest_ctx* ctx, uint32_t use, const digest_state* state) {
+    uint64_t bits = state->pos * 8;
+
+    int i;
+
+    digest_init(ctx, use);
+
+    if (use & FPRINT_USE_F_SHA1) {
+        ctx->sha1.h0 = state->sha1_h[0];
+        ctx->sha1.h1 = state->sha1_h[1];
+        ctx->sha1.h2 = state->sha1_h[2];
+        ctx->sha1.h3 = state->sha1_h[3];
+        ctx->sha1.h4 = state->sha1_h[4];
+        ctx->sha1.Nl = (SHA_LONG) bits;
+        ctx->sha1.Nh = (SHA_LONG) (bits >> 32);
+    }
+    if (use & FPRINT_USE_F_SHA256) {
+        for (i = 0; i < 8; i++) {
+            ctx->sha256.h[i] = state->sha256_h[i];
+        }
+        ctx->sha256.Nl = (SHA_LONG) bits;
+        ctx->sha256.Nh = (SHA_LONG) (bits >> 32);
+    }
+    if (use & FPRINT_USE_F_SHA512) {
+        for (i = 0; i < 8; i++) {
+            ctx->sha512.h[i] = state->sha512_h[i];
+        }
+        ctx->sha512.Nl = bits;
+        ctx->sha512.Nh = 0;
+    }
+}
+
+/* hashing kernels */
+
+typedef void (*hash_chunk_func) (digest_ctx* wf_ctx, digest_ctx* s_ctx, const unsigned char* buf, size_t len);
+
+typedef struct hash_chunk_record hash_chunk_record;
+
+struct hash_chunk_record {
+    uint32_t wf_use;
+    uint32_t s_use;
+    hash_chunk_func func;
+};
+
+// specialised for flag combinations of fp options commonly used
+//                name              whole file      section
+hash_chunk_kernel(all_all,          1, 1, 1,        1, 1, 1)    // default
+hash_chunk_kernel(all_none,         1, 1, 1,        0, 0, 0)    // --f:allsum
+hash_chunk_kernel(none_all,         0, 0, 0,        1, 1, 1)    // --s:allsum
+hash_chunk_kernel(sha256_none,      0, 1, 0,        0, 0, 0)    // --f:sha256
+hash_chunk_kernel(none_sha256,      0, 0, 0,        0, 1, 0)    // --f:mrkl
+hash_chunk_kernel(sha256_sha256,    0, 1, 0,        0, 1, 0)    // --f:sha256 --f:mrkl
+hash_chunk_kernel(all_sha256,       1, 1, 1,        0, 1, 0)    // --f:allsum --f:mrkl
+
+static const hash_chunk_record hash_chunk_table[] = {
+    hash_chunk_kernel_record(all_all,          1, 1, 1,        1, 1, 1),
+    hash_chunk_kernel_record(all_none,         1, 1, 1,        0, 0, 0),
+    hash_chunk_kernel_record(none_all,         0, 0, 0,        1, 1, 1),
+    hash_chunk_kernel_record(sha256_none,      0, 1, 0,        0, 0, 0),
+    hash_chunk_kernel_record(none_sha256,      0, 0, 0,        0, 1, 0),
+    hash_chunk_kernel_record(sha256_sha256,    0, 1, 0,        0, 1, 0),
+    hash_chunk_kernel_record(all_sha256,       1, 1, 1,        0, 1, 0)
+};
+
+#define HASH_CHUNK_TABLE_SIZE   (sizeof(hash_chunk_table) / sizeof(hash_chunk_table[0]))
+
+// fallback for other combinations, NULL context is skipped
+static void hash_chunk_generic(digest_ctx* wf_ctx, digest_ctx* s_ctx, const unsigned char* buf, size_t len) {
+    if (wf_ctx) {
+        digest_update(wf_ctx, buf, len);
+    }
+    if (s_ctx) {
+        digest_update(s_ctx, buf, len);
+    }
+}
+
+// pick kernel once per file rather than testing flags per chunk
+static hash_chunk_func select_hash_chunk(uint32_t wf_use, uint32_t s_use) {
+    size_t i;
+
+    for (i = 0; i < HASH_CHUNK_TABLE_SIZE; i++) {
+        if (hash_chunk_table[i].wf_use == wf_use && hash_chunk_table[i].s_use == s_use) {
+            return hash_chunk_table[i].func;
+        }
+    }
+
+    return &hash_chunk_generic;
+}
+
+// feed content at [pos, pos + len) to digests, saving whole file digest state when passing state_pos
+static void hash_chunk_saving(hash_chunk_func hash_chunk, digest_ctx* wf_ctx, digest_ctx* s_ctx, const unsigned char* buf, uint64_t pos, size_t len, uint64_t state_pos, uint32_t flags, digest_state* state) {
+    size_t split;
+
+    if (wf_ctx && pos < state_pos && pos + len >= state_pos) {
+        split = state_pos - pos;
+
+        hash_chunk(wf_ctx, s_ctx, buf, split);
+        digest_save(wf_ctx, state_pos, flags, state);
+        hash_chunk(wf_ctx, s_ctx, buf + split, len - split);
+    }
+    else {
+        hash_chunk(wf_ctx, s_ctx, buf, len);
+    }
+}
+
+/* merkle helpers */
+
+static void mrkl_node(const unsigned char* left, const unsigned char* right, unsigned char* result) {
+    SHA256_CTX ctx;
+
+    unsigned char prefix = MRKL_NODE_PREFIX;
+
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, &prefix, 1);
+    SHA256_Update(&ctx, left, MRKL_DIGEST_LENGTH);
+    SHA256_Update(&ctx, right, MRKL_DIGEST_LENGTH);
+    SHA256_Final(result, &ctx);
+}
+
+/*  mrkl_range_root computes root over sections [start, start + num) of data
+ *
+ *  leaves are folded in like a binary counter, node[i] holds root of
+ *  the pending complete subtree of 2^i leaves, remaining subtrees are
+ *  then joined from right to left, which gives the same shape as RFC 6962
+ */
+int mrkl_range_root(file_data* data, uint64_t start, uint64_t num, unsigned char* digest) {
+    unsigned char node[MRKL_LEVEL_MAX][MRKL_DIGEST_LENGTH];
+    unsigned char cur[MRKL_DIGEST_LENGTH];
+
+    uint64_t count;
+    uint64_t i;
+    int level;
+    unsigned char have_root = 0;
+
+    if (num == 0 || start > data->section_num || num > data->section_num - start) {
+        return WRONG_ARGS;
+    }
+
+    for (count = 0; count < num; count++) {
+        if (!sect_has_checksum(data, start + count, CHECKSUM_SHA256_INDEX)) {
+            return WRONG_ARGS;
+        }
+
+        memcpy(cur, sect_digest(data, start + count, CHECKSUM_SHA256_INDEX), MRKL_DIGEST_LENGTH);
+
+        for (level = 0; (count >> level) & 1; level++) {
+            mrkl_node(node[level], cur, cur);
+        }
+        memcpy(node[level], cur, MRKL_DIGEST_LENGTH);
+    }
+
+    for (i = 0; i < MRKL_LEVEL_MAX; i++) {
+        if (!((num >> i) & 1)) {
+            continue;
+        }
+
+        if (have_root) {
+            mrkl_node(node[i], cur, cur);
+        }
+        else {
+            memcpy(cur, node[i], MRKL_DIGEST_LENGTH);
+            have_root = 1;
+        }
+    }
+
+    memcpy(digest, cur, MRKL_DIGEST_LENGTH);
+
+    return 0;
+}
+
+static void fill_mrkl_root(file_data* data, uint32_t flags) {
+    unsigned char digest[MRKL_DIGEST_LENGTH];
+
+    if (!(flags & FPRINT_USE_F_MRKL)) {
+        return;
+    }
+
+    if (mrkl_range_root(data, 0, data->section_num, digest)) {
+        return;
+    }
+
+    fill_checksum_result(data->checksum + CHECKSUM_MRKL_INDEX, CHECKSUM_MRKL_ID, digest, MRKL_DIGEST_LENGTH);
+}
+
+// digest state is only kept if file size is recorded, as resuming needs the old size
+static uint64_t calc_state_pos(uint64_t file_size, uint32_t flags) {
+    if (!(flags & FPRINT_USE_F_SIZE)) {
+        return 0;
+    }
+
+    return file_size - file_size % DIGEST_STATE_BLOCK;
+}
+
+// kernel hashing is only used if it covers every checksum requested
+static int use_kernel_hashing(uint32_t flags) {
+    uint32_t needed;
+
+    flags = FPRINT_NORMALISE(flags);
+
+    // fuzzy digest needs content in user space
+    if (flags & FPRINT_USE_F_FUZZY) {
+        return 0;
+    }
+
+    needed = F_SUM_TO_ALG_MASK(flags) | F_SUM_TO_ALG_MASK(FPRINT_S_SUM_TO_F_SUM(flags));
+
+    return needed && !(needed & ~afalg_kernel_mask());
+}
+
+/*  Note on content jobs :
+ *      fingerprinting of content is split into start, step and finish,
+ *      with everything needed in between kept in a content_job,
+ *      so content can be hashed a bounded number of bytes at a time
+ *      (see deferred hashing below)
+ *
+ *      fingerprint_content simply runs one job to completion
+ */
+typedef struct content_job content_job;
+
+struct content_job {
+    database_handle* dh;
+    FILE* file;
+    int zc_fd;
+    linked_entry* entry;
+    file_data* data;            // NULL if there is nothing to fill in (empty file)
+    uint32_t flags;
+    uint32_t sections_needed;
+
+    uint64_t file_size;
+    uint64_t sect_num;
+    uint64_t norm_sect_size;
+    uint64_t last_sect_size;
+    uint64_t state_pos;
+
+    uint64_t sect_index;        // section being read
+    unsigned char sect_open;    // section wise hash structures are initialised
+    uint64_t bytes_left;        // in current section
+    uint64_t pos;
+
+    unsigned char fread_failed;
+    unsigned char done;         // all content read, only finishing is left
+
+    digest_ctx wf_ctx;
+    digest_ctx s_ctx;
+    digest_ctx* s_ctx_p;
+
+    hash_chunk_func hash_chunk;
+
+    fuzzy_ctx fuzzy;
+};
+
+// work out layout and make space for file data, nothing is read yet
+static int content_job_start (content_job* job, database_handle* dh, FILE* file, int zc_fd, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h) {
+    file_data* temp_file_data;
+    int ret = 0;
+
+    error_mark_starter(er_h, "fingerprint_stream");
+
+    flags = FPRINT_NORMALISE(flags);
+
+    job->dh = dh;
+    job->file = file;
+    job->zc_fd = zc_fd;
+    job->entry = entry;
+    job->data = NULL;
+    job->flags = flags;
+    job->file_size = file_size;
+    job->sect_index = 0;
+    job->sect_open = 0;
+    job->bytes_left = 0;
+    job->pos = 0;
+    job->fread_failed = 0;
+    job->done = 1;
+
+    if (file_size == 0) {
+        return 0;
+    }
+
+    if (file_size > FILE_SIZE_MAX) {
+        printf("fingerprint_stream : %s : file too large\n", entry->file_name);
+        return FS_FILE_TOO_LARGE;
+    }
+
+    job->state_pos = calc_state_pos(file_size, flags);
+
+    job->sections_needed
+        =   (flags & FPRINT_USE_S_EXTR)
+        |   (flags & FPRINT_USE_S_SHA1)
+        |   (flags & FPRINT_USE_S_SHA256)
+        |   (flags & FPRINT_USE_S_SHA512);
+
+    if (job->sections_needed) {
+        job->hash_chunk = select_hash_chunk(flags & FPRINT_F_SUM_MASK, FPRINT_S_SUM_TO_F_SUM(flags));
+        job->s_ctx_p = &job->s_ctx;
+    }
+    else {
+        job->hash_chunk = select_hash_chunk(flags & FPRINT_F_SUM_MASK, 0);
+        job->s_ctx_p = NULL;
+    }
+
+    // handle sections
+    ret = calc_sect_layout(file_size, &job->sect_num, &job->norm_sect_size, &job->last_sect_size);
+    if (ret) {
+        printf("fingerprint_stream : logic error\n");
+        return ret;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    // make space for file data
+    ret = add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
+    if (ret) {
+        error_write(er_h, "failed to get space for file data");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+    entry->data = temp_file_data;
+    temp_file_data->parent_entry = entry;
+    job->data = temp_file_data;
+
+    if (job->sections_needed) {
+        // sizes first, so positions are derived instead of stored
+        temp_file_data->norm_sect_size = job->norm_sect_size;
+        temp_file_data->last_sect_size = job->last_sect_size;
+
+        // make space for sections
+        ret = append_sections(temp_file_data, job->sect_num);
+        if (ret) {
+            error_write(er_h, "failed to get space for section");
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+    }
+
+    // lay out extracts so they can be collected while reading
+    if (flags & FPRINT_USE_F_EXTR) {
+        set_extract_positions(temp_file_data->extract, &temp_file_data->extract_num, 0, file_size);
+    }
+    else {
+        temp_file_data->extract_num = 0;
+    }
+
+    SET_INTERRUPTABLE();
+
+    // initialise file wise hash structures
+    if (zc_fd >= 0) {
+        if (digest_init_kernel(&job->wf_ctx, flags & FPRINT_F_SUM_MASK)) {
+            return AFALG_IO_FAIL;
+        }
+
+        if (read_extracts_at(zc_fd, temp_file_data->extract, temp_file_data->extract_num)) {
+            digest_abort(&job->wf_ctx);
+            return AFALG_IO_FAIL;
+        }
+    }
+    else {
+        digest_init(&job->wf_ctx, flags & FPRINT_F_SUM_MASK);
+    }
+
+    if (flags & FPRINT_USE_F_FUZZY) {
+        fuzzy_init(&job->fuzzy, file_size);
+    }
+
+    job->done = 0;
+
+    return 0;
+}
+
+// close hash structures of a job which is not going to be finished
+static void content_job_abort (content_job* job) {
+    if (!job->data || job->done) {
+        return;
+    }
+
+    digest_abort(&job->wf_ctx);
+    if (job->sect_open && job->sections_needed) {
+        digest_abort(&job->s_ctx);
+    }
+
+    job->done = 1;
+}
+
+// read and hash up to about budget bytes of content, job->done is set once all is read
+static int content_job_step (content_job* job, uint64_t budget) {
+    file_data* temp_file_data = job->data;
+    section* temp_section = NULL;
+    extract_sample* temp_extract;
+    checksum_result temp_checksum[CHECKSUM_MAX_NUM];
+    uint64_t i;
+    size_t bytes = 0;
+
+    unsigned char data_buf[FPRINT_READ_BUFFER_SIZE];
+
+    int64_t read_start_ns = 0;
+
+    while (!job->done) {
+        i = job->sect_index;
+
+        if (job->sections_needed) {
+            temp_section = temp_file_data->section + i;
+        }
+
+        if (!job->sect_open) {
+            if (i < job->sect_num - 1) {
+                job->bytes_left = job->norm_sect_size;
+            }
+            else {
+                job->bytes_left = job->last_sect_size;
+            }
+
+            if (job->sections_needed) {
+                set_sect_pos(temp_file_data, i, i * job->norm_sect_size, i * job->norm_sect_size + job->bytes_left - 1);
+
+                if (job->flags & FPRINT_USE_S_EXTR) {
+                    get_sect_extract_arr(temp_file_data, i, &temp_extract);
+                    set_extract_positions(temp_extract, &temp_section->extract_num, i * job->norm_sect_size, job->bytes_left);
+                }
+                else {
+                    temp_section->extract_num = 0;
+                }
+
+                if (job->zc_fd >= 0) {
+                    if (digest_init_kernel(&job->s_ctx, FPRINT_S_SUM_TO_F_SUM(job->flags))
+                        || read_extracts_at(job->zc_fd, sect_extract(temp_file_data, i), temp_section->extract_num))
+                    {
+                        job->sect_open = 1;
+                        goto kernel_fail;
+                    }
+                }
+                else {
+                    digest_init(&job->s_ctx, FPRINT_S_SUM_TO_F_SUM(job->flags));
+                }
+            }
+
+            job->sect_open = 1;
+        }
+
+        while (job->bytes_left > 0) {
+            if (budget == 0) {
+                return 0;
+            }
+
+            if (throttle_active()) {
+                read_start_ns = throttle_now_ns();
+            }
+
+            if (job->zc_fd >= 0) {
+                bytes = ffp_min(AFALG_SPLICE_CHUNK, job->bytes_left);
+
+                if (digest_splice(&job->wf_ctx, job->zc_fd, job->pos, bytes)
+                    || (job->sections_needed && digest_splice(&job->s_ctx, job->zc_fd, job->pos, bytes)))
+                {
+                    goto kernel_fail;
+                }
+            }
+            else {
+                bytes = fread(data_buf, 1, ffp_min(FPRINT_READ_BUFFER_SIZE, job->bytes_left), job->file);
+                if (bytes == 0) {
+                    break;
+                }
+            }
+            job->bytes_left -= bytes;
+            budget -= ffp_min(budget, bytes);
+
+            if (throttle_active()) {
+                throttle_record_latency(throttle_now_ns() - read_start_ns);
+                throttle_take_bytes(bytes);
+            }
+
+            if (job->zc_fd >= 0) {
+                job->pos += bytes;
+                continue;
+            }
+
+            hash_chunk_saving(job->hash_chunk, &job->wf_ctx, job->s_ctx_p, data_buf, job->pos, bytes, job->state_pos, job->flags, &temp_file_data->resume);
+
+            if (job->flags & FPRINT_USE_F_FUZZY) {
+                fuzzy_update(&job->fuzzy, data_buf, bytes);
+            }
+
+            capture_extracts(temp_file_data->extract, temp_file_data->extract_num, data_buf, job->pos, bytes);
+
+            if (job->sections_needed) {
+                capture_extracts(sect_extract(temp_file_data, i), temp_section->extract_num, data_buf, job->pos, bytes);
+            }
+
+            job->pos += bytes;
+        }
+
+        if (job->sections_needed) {
+            // section wise checksums
+            if (digest_final(&job->s_ctx, temp_checksum)) {
+                goto kernel_fail;
+            }
+            set_sect_checksums(temp_file_data, i, temp_checksum);
+
+            link_sect_to_checksum_structures(job->dh, temp_file_data, i);
+        }
+
+        job->sect_open = 0;
+
+        if (job->bytes_left != 0 && bytes == 0) {
+            job->fread_failed = 1;
+
+            printf("fingerprint_stream : warning, file ended before fingerprinting is finished\n");
+
+            // edit current section as last section
+            if (i < job->sect_num - 1) { // if not already last section
+                job->last_sect_size = job->norm_sect_size - job->bytes_left;
+            }
+            else {  // if already last section
+                job->last_sect_size = job->last_sect_size - job->bytes_left;
+                if (job->sect_num == 1) {
+                    job->norm_sect_size = job->last_sect_size;
+                }
+            }
+
+            if (job->sections_needed && job->sect_num > 1) {     // re-adjust section number if needed
+                temp_file_data->section_num = i + 1;
+                temp_file_data->section_free_num = job->sect_num - temp_file_data->section_num;
+            }
+
+            // derived positions follow the new section sizes
+            if (job->sections_needed && temp_file_data->norm_sect_size > 0) {
+                temp_file_data->norm_sect_size = job->norm_sect_size;
+                temp_file_data->last_sect_size = job->last_sect_size;
+            }
+
+            // reduce section number
+            job->sect_num = i + 1;
+
+            // re-adjust file size
+            job->file_size = (job->sect_num - 1) * job->norm_sect_size + job->last_sect_size;
+
+            job->done = 1;
+            break;
+        }
+
+        job->sect_index++;
+        if (job->sect_index == job->sect_num) {
+            job->done = 1;
+        }
+    }
+
+    return 0;
+
+kernel_fail:
+    content_job_abort(job);
+
+    return AFALG_IO_FAIL;
+}
+
+// fill in whole file checksums and size, and link file data to database
+static int content_job_finish (content_job* job) {
+    database_handle* dh = job->dh;
+    file_data* temp_file_data = job->data;
+    uint64_t i;
+    int ret;
+
+    if (!temp_file_data) {
+        return 0;
+    }
+
+    // whole file checksums
+    if (digest_final(&job->wf_ctx, temp_file_data->checksum)) {
+        return AFALG_IO_FAIL;
+    }
+
+    fill_mrkl_root(temp_file_data, job->flags);
+
+    SET_NOT_INTERRUPTABLE();
+
+    if (job->flags & FPRINT_USE_F_FUZZY) {
+        fuzzy_final(&job->fuzzy, &temp_file_data->fuzzy);
+
+        link_file_data_to_fuzzy_index(dh, temp_file_data);
+    }
+
+    if (job->fread_failed) {     // fread failed previously
+        // forget about extracts
+        temp_file_data->extract_num = 0;
+
+        if (job->sections_needed) {
+            for (i = 0; i < job->sect_num; i++) {
+                temp_file_data->section[i].extract_num = 0;
+            }
+        }
+
+        // saved state may lie beyond the actual end
+        temp_file_data->resume.flags = 0;
+    }
+
+    // fill in file size
+    if (job->flags & FPRINT_USE_F_SIZE) {
+        temp_file_data->file_size = job->file_size;
+        sprintf(temp_file_data->file_size_str, "%"PRIu64"", job->file_size);
+
+        // link to file size related structures
+        ret = link_file_data_to_file_size_structures(dh, temp_file_data);
+        if (ret) {
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+    }
+
+    link_file_data_to_extract_index(dh, temp_file_data);
+
+    link_file_data_to_checksum_structures(dh, temp_file_data);
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+/*  fingerprint_content reads exactly file_size bytes from file sequentially
+ *  and fills in file data of entry
+ *
+ *  if zc_fd is not -1, content of zc_fd is spliced into kernel checksums instead
+ *  and file is not touched, extracts are then read separately with pread
+ *  no digest state is kept in this case as kernel does not expose it
+ *
+ *  returns AFALG_IO_FAIL if kernel hashing failed, partial file data is
+ *  left in entry for the caller to remove
+ */
+static int fingerprint_content (database_handle* dh, FILE* file, int zc_fd, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h) {
+    content_job job;
+    int ret;
+
+    ret = content_job_start(&job, dh, file, zc_fd, file_size, entry, flags, er_h);
+    if (ret) {
+        return ret;
+    }
+
+    ret = content_job_step(&job, UINT64_MAX);
+    if (ret) {
+        return ret;
+    }
+
+    return content_job_finish(&job);
+}
+
+/*  fingerprint_stream reads exactly file_size bytes from file sequentially
+ *  and fills in file data of entry
+ *
+ *  extracts are collected during the same pass, so file does not need to be seekable
+ *
+ *  intermediate state of file wise checksums at the last block boundary
+ *  is kept in file data, see fingerprint_append
+ */
+int fingerprint_stream (database_handle* dh, FILE* file, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h) {
+    return fingerprint_content(dh, file, -1, file_size, entry, flags, er_h);
+}
+
+int sample_file_extracts (int fd, uint64_t file_size, extract_sample* extract, uint32_t* extract_num) {
+    if (file_size == 0) {
+        *extract_num = 0;
+        return 0;
+    }
+
+    set_extract_positions(extract, extract_num, 0, file_size);
+
+    return read_extracts_at(fd, extract, *extract_num);
+}
+
+int checksum_file (int fd, uint32_t use, checksum_result* checksum) {
+    unsigned char buf[FPRINT_READ_BUFFER_SIZE];
+    digest_ctx ctx;
+    ssize_t bytes;
+
+    if (lseek(fd, 0, SEEK_SET) < 0) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    digest_init(&ctx, use & FPRINT_F_SUM_MASK);
+
+    while ((bytes = read(fd, buf, FPRINT_READ_BUFFER_SIZE)) > 0) {
+        digest_update(&ctx, buf, bytes);
+
+        if (throttle_active()) {
+            throttle_take_bytes(bytes);
+        }
+    }
+    if (bytes < 0) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    return digest_final(&ctx, checksum);
+}
+
+/*  Note on hash cache records :
+ *      body of a hash cache record (see ffp_hcache.h) holds content part of file data
+ *          format                                                  uint32_t
+ *          file_size, norm_sect_size, last_sect_size, section_num  uint64_t each
+ *          checksums
+ *          extracts
+ *          resume state, fuzzy digest                              as in memory
+ *          for each section
+ *              start_pos, end_pos                                  uint64_t each
+ *              checksums
+ *              extracts
+ *
+ *      checksums are a mask (uint32_t) of checksum slots in use, followed by
+ *      type, len (uint16_t each) and digest of each slot in use
+ *      extracts are number of extracts (uint32_t), followed by
+ *      position (uint64_t), len (uint16_t) and bytes of each
+ *
+ *      bump FPRINT_CACHE_FORMAT whenever this or any structure stored as in memory changes
+ */
+#define FPRINT_CACHE_FORMAT     1
+
+// flags which make a difference to content part of file data
+#define FPRINT_CACHE_FLAGS(flags)   (FPRINT_NORMALISE(flags) & ~(FPRINT_USE_F_NAME | FPRINT_DEFER_HASH))
+
+static unsigned char cache_body[HCACHE_REC_MAX];
+
+static int cache_put(unsigned char* body, uint32_t* pos, const void* src, uint32_t len) {
+    if (len > HCACHE_REC_MAX - *pos) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    memcpy(body + *pos, src, len);
+    *pos += len;
+
+    return 0;
+}
+
+static int cache_get(const unsigned char* body, uint32_t body_len, uint32_t* pos, void* dst, uint32_t len) {
+    if (len > body_len - *pos) {
+        return HCACHE_MISS;
+    }
+
+    memcpy(dst, body + *pos, len);
+    *pos += len;
+
+    return 0;
+}
+
+static int cache_put_checksums(unsigned char* body, uint32_t* pos, checksum_result* checksum) {
+    uint32_t mask = 0;
+    int i;
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (checksum[i].type != CHECKSUM_UNUSED) {
+            mask |= UINT32_C(1) << i;
+        }
+    }
+
+    if (cache_put(body, pos, &mask, sizeof(mask))) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (!(mask & (UINT32_C(1) << i))) {
+            continue;
+        }
+
+        if (        cache_put(body, pos, &checksum[i].type, sizeof(uint16_t))
+                ||  cache_put(body, pos, &checksum[i].len, sizeof(uint16_t))
+                ||  cache_put(body, pos, checksum[i].checksum, checksum[i].len)
+           )
+        {
+            return FFP_GENERAL_FAIL;
+        }
+    }
+
+    return 0;
+}
+
+static int cache_get_checksums(const unsigned char* body, uint32_t body_len, uint32_t* pos, checksum_result* checksum) {
+    unsigned char digest[CHECKSUM_MAX_LEN];
+    uint32_t mask;
+    uint16_t type;
+    uint16_t len;
+    int i;
+
+    if (cache_get(body, body_len, pos, &mask, sizeof(mask))) {
+        return HCACHE_MISS;
+    }
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (!(mask & (UINT32_C(1) << i))) {
+            checksum[i].type = CHECKSUM_UNUSED;
+            continue;
+        }
+
+        if (        cache_get(body, body_len, pos, &type, sizeof(uint16_t))
+                ||  cache_get(body, body_len, pos, &len, sizeof(uint16_t))
+                ||  len > CHECKSUM_MAX_LEN
+                ||  cache_get(body, body_len, pos, digest, len)
+           )
+        {
+            return HCACHE_MISS;
+        }
+
+        // anything else would upset unlinking later on
+        if (        type != CHECKSUM_SHA1_ID
+                &&  type != CHECKSUM_SHA256_ID
+                &&  type != CHECKSUM_SHA512_ID
+                &&  type != CHECKSUM_MRKL_ID
+           )
+        {
+            return HCACHE_MISS;
+        }
+
+        fill_checksum_result(checksum + i, type, digest, len);
+    }
+
+    return 0;
+}
+
+static int cache_put_extracts(unsigned char* body, uint32_t* pos, extract_sample* extract, uint32_t extract_num) {
+    uint32_t i;
+
+    if (cache_put(body, pos, &extract_num, sizeof(uint32_t))) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    for (i = 0; i < extract_num; i++) {
+        if (        cache_put(body, pos, &extract[i].position, sizeof(uint64_t))
+                ||  cache_put(body, pos, &extract[i].len, sizeof(uint16_t))
+                ||  cache_put(body, pos, extract[i].extract, extract[i].len)
+           )
+        {
+            return FFP_GENERAL_FAIL;
+        }
+    }
+
+    return 0;
+}
+
+static int cache_get_extracts(const unsigned char* body, uint32_t body_len, uint32_t* pos, extract_sample* extract, uint32_t* extract_num_p) {
+    uint32_t extract_num;
+    uint32_t i;
+
+    if (        cache_get(body, body_len, pos, &extract_num, sizeof(uint32_t))
+            ||  extract_num > EXTRACT_MAX_NUM
+       )
+    {
+        return HCACHE_MISS;
+    }
+
+    for (i = 0; i < extract_num; i++) {
+        if (        cache_get(body, body_len, pos, &extract[i].position, sizeof(uint64_t))
+                ||  cache_get(body, body_len, pos, &extract[i].len, sizeof(uint16_t))
+                ||  extract[i].len > EXTRACT_SIZE_MAX
+                ||  cache_get(body, body_len, pos, extract[i].extract, extract[i].len)
+           )
+        {
+            return HCACHE_MISS;
+        }
+    }
+
+    *extract_num_p = extract_num;
+
+    return 0;
+}
+
+static int cache_write(file_data* data, unsigned char* body, uint32_t* len) {
+    uint32_t format = FPRINT_CACHE_FORMAT;
+    uint32_t pos = 0;
+    uint64_t start_pos;
+    uint64_t end_pos;
+    checksum_result temp_checksum[CHECKSUM_MAX_NUM];
+    uint64_t i;
+    int j;
+
+    if (        cache_put(body, &pos, &format, sizeof(uint32_t))
+            ||  cache_put(body, &pos, &data->file_size, sizeof(uint64_t))
+            ||  cache_put(body, &pos, &data->norm_sect_size, sizeof(uint64_t))
+            ||  cache_put(body, &pos, &data->last_sect_size, sizeof(uint64_t))
+            ||  cache_put(body, &pos, &data->section_num, sizeof(uint64_t))
+            ||  cache_put_checksums(body, &pos, data->checksum)
+            ||  cache_put_extracts(body, &pos, data->extract, data->extract_num)
+            ||  cache_put(body, &pos, &data->resume, sizeof(digest_state))
+            ||  cache_put(body, &pos, &data->fuzzy, sizeof(fuzzy_digest))
+       )
+    {
+        return FFP_GENERAL_FAIL;
+    }
+
+    for (i = 0; i < data->section_num; i++) {
+        get_sect_pos(data, i, &start_pos, &end_pos);
+        for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
+            get_sect_checksum(data, i, j, temp_checksum + j);
+        }
+
+        if (        cache_put(body, &pos, &start_pos, sizeof(uint64_t))
+                ||  cache_put(body, &pos, &end_pos, sizeof(uint64_t))
+                ||  cache_put_checksums(body, &pos, temp_checksum)
+                ||  cache_put_extracts(body, &pos, sect_extract(data, i), data->section[i].extract_num)
+           )
+        {
+            return FFP_GENERAL_FAIL;
+        }
+    }
+
+    *len = pos;
+
+    return 0;
+}
+
+/*  cache_read reads body into data, sections are appended to data, which should have none
+ *  if data is NULL body is only checked, and number of sections is given back
+ */
+static int cache_read(const unsigned char* body, uint32_t len, file_data* data, uint64_t* sect_num_p) {
+    static file_data scratch_data;
+    static extract_sample scratch_extract[EXTRACT_MAX_NUM];
+
+    file_data* target = data ? data : &scratch_data;
+    uint64_t start_pos;
+    uint64_t end_pos;
+    checksum_result temp_checksum[CHECKSUM_MAX_NUM];
+    extract_sample* temp_extract;
+    uint32_t extract_num;
+    uint32_t format;
+    uint32_t pos = 0;
+    uint64_t sect_num;
+    uint64_t i;
+    int j;
+
+    if (        cache_get(body, len, &pos, &format, sizeof(uint32_t))
+            ||  format != FPRINT_CACHE_FORMAT
+            ||  cache_get(body, len, &pos, &target->file_size, sizeof(uint64_t))
+            ||  cache_get(body, len, &pos, &target->norm_sect_size, sizeof(uint64_t))
+            ||  cache_get(body, len, &pos, &target->last_sect_size, sizeof(uint64_t))
+            ||  cache_get(body, len, &pos, &sect_num, sizeof(uint64_t))
+            ||  cache_get_checksums(body, len, &pos, target->checksum)
+            ||  cache_get_extracts(body, len, &pos, target->extract, &target->extract_num)
+            ||  cache_get(body, len, &pos, &target->resume, sizeof(digest_state))
+            ||  cache_get(body, len, &pos, &target->fuzzy, sizeof(fuzzy_digest))
+       )
+    {
+        return HCACHE_MISS;
+    }
+
+    // sizes are in place, so positions are only stored if needed
+    if (data && append_sections(data, sect_num)) {
+        return HCACHE_MISS;
+    }
+
+    for (i = 0; i < sect_num; i++) {
+        if (        cache_get(body, len, &pos, &start_pos, sizeof(uint64_t))
+                ||  cache_get(body, len, &pos, &end_pos, sizeof(uint64_t))
+                ||  cache_get_checksums(body, len, &pos, temp_checksum)
+                ||  cache_get_extracts(body, len, &pos, scratch_extract, &extract_num)
+           )
+        {
+            return HCACHE_MISS;
+        }
+
+        // sections only have room for their own checksum types
+        for (j = 0; j < CHECKSUM_MAX_NUM; j++) {
+            if (temp_checksum[j].type == CHECKSUM_UNUSED) {
+                continue;
+            }
+            if (        j >= SECT_CHECKSUM_NUM
+                    ||  temp_checksum[j].type != sect_checksum_type[j]
+                    ||  temp_checksum[j].len  != sect_checksum_len[j]
+               )
+            {
+                return HCACHE_MISS;
+            }
+        }
+
+        if (!data) {
+            continue;
+        }
+
+        if (        set_sect_pos(data, i, start_pos, end_pos)
+                ||  set_sect_checksums(data, i, temp_checksum)
+           )
+        {
+            return HCACHE_MISS;
+        }
+
+        if (extract_num > 0) {
+            if (get_sect_extract_arr(data, i, &temp_extract)) {
+                return HCACHE_MISS;
+            }
+            memcpy(temp_extract, scratch_extract, sizeof(extract_sample) * extract_num);
+        }
+        data->section[i].extract_num = extract_num;
+    }
+
+    if (pos != len) {
+        return HCACHE_MISS;
+    }
+
+    *sect_num_p = sect_num;
+
+    return 0;
+}
+
+/*  fill file data of entry from hash cache, in the same way content_job_start
+ *  and content_job_finish would
+ *
+ *  returns HCACHE_MISS if cache has nothing for file, entry is left untouched then
+ */
+static int fingerprint_from_cache (database_handle* dh, const struct stat* file_stat, linked_entry* entry, uint32_t flags, error_handle* er_h) {
+    file_data* temp_file_data;
+    uint64_t sect_num;
+    uint64_t i;
+    uint32_t len;
+    int ret;
+
+    if (hcache_lookup(&fp_hcache, file_stat, FPRINT_CACHE_FLAGS(flags), cache_body, &len)) {
+        return HCACHE_MISS;
+    }
+
+    // check all of it before anything is allocated
+    if (cache_read(cache_body, len, NULL, &sect_num)) {
+        return HCACHE_MISS;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    ret = add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
+    if (ret) {
+        error_write(er_h, "failed to get space for file data");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+    entry->data = temp_file_data;
+    temp_file_data->parent_entry = entry;
+
+    ret = cache_read(cache_body, len, temp_file_data, &sect_num);
+    if (ret) {
+        error_write(er_h, "failed to get space for section");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+
+    // flags not part of the key may differ from when state was taken
+    if (temp_file_data->resume.flags) {
+        temp_file_data->resume.flags = FPRINT_NORMALISE(flags) & ~FPRINT_DEFER_HASH;
+    }
+
+    for (i = 0; i < sect_num; i++) {
+        link_sect_to_checksum_structures(dh, temp_file_data, i);
+    }
+
+    if (flags & FPRINT_USE_F_FUZZY) {
+        link_file_data_to_fuzzy_index(dh, temp_file_data);
+    }
+
+    if (flags & FPRINT_USE_F_SIZE) {
+        sprintf(temp_file_data->file_size_str, "%"PRIu64"", temp_file_data->file_size);
+
+        ret = link_file_data_to_file_size_structures(dh, temp_file_data);
+        if (ret) {
+            error_write(er_h, "failed to link file data via file size");
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+    }
+
+    link_file_data_to_extract_index(dh, temp_file_data);
+
+    link_file_data_to_checksum_structures(dh, temp_file_data);
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+// record file data of entry in hash cache, file_stat is from before file was opened
+static void fingerprint_to_cache (const struct stat* file_stat, FILE* file, int64_t start_ns, linked_entry* entry, uint32_t flags) {
+    struct stat stat_after;
+    uint32_t len;
+
+    if (!entry->data || fstat(fileno(file), &stat_after)) {
+        return;
+    }
+
+    if (cache_write(entry->data, cache_body, &len)) {
+        return;
+    }
+
+    hcache_store(&fp_hcache, file_stat, &stat_after, start_ns, FPRINT_CACHE_FLAGS(flags), cache_body, len);
+}
+
+static int defer_file (database_handle* dh, char* path, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h);
+
+int fingerprint_file (database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used) {
+    FILE* file;
+    struct stat file_stat;
+    int64_t start_ns = 0;
+    int ret2;
+    int ret;
+
+    error_mark_starter(er_h, "fingerprint_file");
+
+    *file_being_used = NULL;
+
+    if ((ret = verify_str_terminated(path, FS_PATH_MAX, NULL, 0x0))) {
+        return ret;
+    }
+
+    if (stat(path, &file_stat)) {
+        error_write(er_h, "failed to get stats - file may not exist");
+        return FFP_GENERAL_FAIL;
+    }
+
+    if (        !S_ISREG(file_stat.st_mode)
+            &&  !S_ISDIR(file_stat.st_mode)
+       )
+    {
+        return FS_UNRECOGNISED_FILE_TYPE;
+    }
+
+    // unchanged since it was last fingerprinted, by any process using the same cache
+    if (S_ISREG(file_stat.st_mode) && file_stat.st_size > 0 && hcache_active()) {
+        ret = fingerprint_from_cache(dh, &file_stat, entry, flags, er_h);
+        if (ret != HCACHE_MISS) {
+            if (ret) {
+                return ret;
+            }
+
+            return verify_entry(dh, entry, 0x0);
+        }
+
+        start_ns = hcache_now_ns();
+    }
+
+    if ((flags & FPRINT_DEFER_HASH) && S_ISREG(file_stat.st_mode)) {
+        ret = defer_file(dh, path, file_stat.st_size, entry, flags, er_h);
+        if (ret) {
+            return ret;
+        }
+
+        return verify_entry(dh, entry, 0x0);
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    file = fopen(path, "rb");
+    if (!file) {
+        error_write(er_h, "unable to open file");
+        return FOPEN_FAIL;
+    }
+
+    *file_being_used = file;
+
+    SET_INTERRUPTABLE();
+
+    if (throttle_active()) {
+        throttle_take_file();
+    }
+
+    if (S_ISREG(file_stat.st_mode) && use_kernel_hashing(flags)) {
+        ret = fingerprint_content(dh, file, fileno(file), file_stat.st_size, entry, flags, er_h);
+        if (ret == AFALG_IO_FAIL) {
+            SET_NOT_INTERRUPTABLE();
+
+            // drop partial result and go through user space instead
+            if (entry->data) {
+                del_file_data(dh, entry->data);
+                entry->data = NULL;
+            }
+            rewind(file);
+
+            SET_INTERRUPTABLE();
+
+            ret = fingerprint_stream(dh, file, file_stat.st_size, entry, flags, er_h);
+        }
+    }
+    else {
+        ret = fingerprint_stream(dh, file, file_stat.st_size, entry, flags, er_h);
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    if (ret == 0 && start_ns) {
+        fingerprint_to_cache(&file_stat, file, start_ns, entry, flags);
+    }
+
+    fclose(file);
+
+    ret2 = verify_entry(dh, entry, 0x0);
+    if (ret2) {
+        printf("fingerprint_file : verify entry detected errors\n");
+        printf("file name : %s\n", path);
+        printf("Please report to developer as this should not happen\n");
+        printf("It is recommended that you revert to previous version of database as this may indicate your database is now corrupted\n");
+        printf("Sorry for the inconvenience\n");
+        ret = ret2;
+    }
+
+    // clear pointer so cleanup function will not clean it again
+    *file_being_used = NULL;
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return ret;
+}
+
+/* append aware re-fingerprinting */
+
+static int seek_to(FILE* file, uint64_t pos) {
+    if (pos > LONG_MAX) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    if (fseek(file, (long) pos, SEEK_SET)) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    return 0;
+}
+
+// read extracts at their positions, returns non zero if any cannot be read
+static int read_extracts(FILE* file, extract_sample* extract, uint32_t extract_num, uint64_t before) {
+    uint32_t i;
+
+    for (i = 0; i < extract_num; i++) {
+        if (extract[i].position >= before) {
+            continue;
+        }
+
+        if (seek_to(file, extract[i].position)) {
+            return FFP_GENERAL_FAIL;
+        }
+
+        if (fread(extract[i].extract, 1, extract[i].len, file) != extract[i].len) {
+            return FFP_GENERAL_FAIL;
+        }
+    }
+
+    return 0;
+}
+
+static int same_checksums(checksum_result* a, checksum_result* b) {
+    int i;
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (a[i].type != b[i].type) {
+            return 0;
+        }
+        if (a[i].type == CHECKSUM_UNUSED) {
+            continue;
+        }
+        if (a[i].len != b[i].len || memcmp(a[i].checksum, b[i].checksum, a[i].len)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int same_extracts(extract_sample* a, extract_sample* b, uint32_t extract_num) {
+    uint32_t i;
+
+    for (i = 0; i < extract_num; i++) {
+        if (memcmp(a[i].extract, b[i].extract, a[i].len)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// check file wise extracts and rehash last section of old data
+static int verify_old_prefix(FILE* file, file_data* old_data, uint32_t flags) {
+    uint64_t last = old_data->section_num - 1;
+    uint32_t last_extract_num = old_data->section[last].extract_num;
+    uint64_t start_pos;
+    uint64_t end_pos;
+
+    extract_sample extract[EXTRACT_MAX_NUM];
+    checksum_result checksum[CHECKSUM_MAX_NUM];
+    checksum_result old_checksum[CHECKSUM_MAX_NUM];
+
+    digest_ctx ctx;
+
+    unsigned char data_buf[FILE_BUFFER_SIZE];
+
+    uint64_t pos;
+    size_t bytes;
+
+    uint32_t i;
+
+    // file wise extracts
+    for (i = 0; i < old_data->extract_num; i++) {
+        extract[i] = old_data->extract[i];
+    }
+    if (read_extracts(file, extract, old_data->extract_num, old_data->file_size)) {
+        return FS_FILE_NOT_APPENDED;
+    }
+    if (!same_extracts(extract, old_data->extract, old_data->extract_num)) {
+        return FS_FILE_NOT_APPENDED;
+    }
+
+    // last section
+    get_sect_pos(old_data, last, &start_pos, &end_pos);
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        get_sect_checksum(old_data, last, i, old_checksum + i);
+    }
+    for (i = 0; i < last_extract_num; i++) {
+        extract[i] = sect_extract(old_data, last)[i];
+    }
+
+    digest_init(&ctx, FPRINT_S_SUM_TO_F_SUM(flags));
+
+    if (seek_to(file, start_pos)) {
+        return FS_FILE_NOT_APPENDED;
+    }
+
+    for (pos = start_pos; pos <= end_pos; pos += bytes) {
+        bytes = fread(data_buf, 1, ffp_min(FILE_BUFFER_SIZE, end_pos + 1 - pos), file);
+        if (bytes == 0) {
+            return FS_FILE_NOT_APPENDED;
+        }
+
+        if (throttle_active()) {
+            throttle_take_bytes(bytes);
+        }
+
+        digest_update(&ctx, data_buf, bytes);
+
+        capture_extracts(extract, last_extract_num, data_buf, pos, bytes);
+    }
+
+    digest_final(&ctx, checksum);
+
+    if (        !same_checksums(checksum, old_checksum)
+            ||  !same_extracts(extract, sect_extract(old_data, last), last_extract_num)
+       )
+    {
+        return FS_FILE_NOT_APPENDED;
+    }
+
+    return 0;
+}
+
+// put old data back into entry after new data is abandoned
+static void restore_old_data(database_handle* dh, linked_entry* entry, file_data* old_data, file_data** data_being_replaced) {
+    if (entry->data && entry->data != old_data) {
+        del_file_data(dh, entry->data);
+    }
+    entry->data = old_data;
+
+    *data_being_replaced = NULL;
+}
+
+/*  fingerprint_append brings file data of entry up to date for a file
+ *  which has only been appended to since it was last fingerprinted
+ *
+ *  old prefix is not rehashed, instead it is checked against file wise extracts,
+ *  and checksums and extracts of the last old section, then
+ *      whole file checksums continue from saved digest state
+ *      complete old sections are kept and partial last one is redone
+ *      new sections of the same size cover the appended tail
+ *
+ *  returns FS_FILE_NOT_APPENDED without changing entry if file cannot be
+ *  handled this way (no saved state, different flags, no section checksums,
+ *  file shrunk or changed, too many sections would result, or fuzzy digest
+ *  is requested, which cannot be continued), caller should fingerprint
+ *  the whole file instead
+ *
+ *  old file data is recorded in data_being_replaced until new file data is complete
+ */
+int fingerprint_append (database_handle* dh, FILE* file, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h, file_data** data_being_replaced) {
+    file_data* old_data = entry->data;
+    file_data* temp_file_data;
+    section* temp_section = NULL;
+    extract_sample* temp_extract;
+    checksum_result temp_checksum[CHECKSUM_MAX_NUM];
+
+    uint64_t norm_sect_size;
+    uint64_t last_sect_size;
+    uint64_t sect_num;
+    uint64_t keep_num;
+    uint64_t ideal_num;
+    uint64_t ideal_norm;
+    uint64_t ideal_last;
+    uint64_t new_start;
+    uint64_t stream_start;
+    uint64_t state_pos;
+    uint64_t pos;
+    uint64_t limit;
+    uint64_t cur_sect;
+    uint64_t sect_start = 0;
+    uint64_t sect_end = 0;
+    size_t bytes;
+    uint64_t i;
+    int ret;
+
+    unsigned char sect_open = 0;
+
+    digest_ctx wf_ctx;
+    digest_ctx s_ctx;
+
+    // [whole file digests fed][section open]
+    hash_chunk_func hash_chunk[2][2];
+
+    unsigned char wf_fed;
+
+    unsigned char data_buf[FPRINT_READ_BUFFER_SIZE];
+
+    int64_t read_start_ns = 0;
+
+    error_mark_starter(er_h, "fingerprint_append");
+
+    flags = FPRINT_NORMALISE(flags);
+
+    if (        !old_data
+            ||  old_data->resume.flags != flags
+            ||  !(flags & FPRINT_S_SUM_MASK)
+            ||  old_data->section_num == 0
+            ||  old_data->norm_sect_size == 0
+            ||  file_size < old_data->file_size
+            ||  ((flags & FPRINT_USE_F_FUZZY) && file_size != old_data->file_size)
+       )
+    {
+        return FS_FILE_NOT_APPENDED;
+    }
+
+    if (file_size > FILE_SIZE_MAX) {
+        printf("fingerprint_append : %s : file too large\n", entry->file_name);
+        return FS_FILE_TOO_LARGE;
+    }
+
+    // work out new layout, keeping section size
+    norm_sect_size = old_data->norm_sect_size;
+
+    keep_num = old_data->section_num;
+    if (old_data->last_sect_size != norm_sect_size) {
+        keep_num--;
+    }
+    new_start = keep_num * norm_sect_size;
+
+    if (file_size > old_data->file_size) {
+        sect_num = keep_num + (file_size - new_start + norm_sect_size - 1) / norm_sect_size;
+        last_sect_size = file_size - (sect_num - 1) * norm_sect_size;
+
+        // fall back if layout drifts too far from what a fresh fingerprint would use
+        ret = calc_sect_layout(file_size, &ideal_num, &ideal_norm, &ideal_last);
+        if (ret) {
+            return ret;
+        }
+        if (sect_num > SECT_MAX_NUM || sect_num > 2 * ideal_num) {
+            return FS_FILE_NOT_APPENDED;
+        }
+    }
+
+    ret = verify_old_prefix(file, old_data, flags);
+    if (ret) {
+        return ret;
+    }
+
+    if (file_size == old_data->file_size) {     // nothing appended
+        return 0;
+    }
+
+    state_pos = calc_state_pos(file_size, flags);
+    stream_start = ffp_min(old_data->resume.pos, new_start);
+
+    digest_restore(&wf_ctx, flags & FPRINT_F_SUM_MASK, &old_data->resume);
+
+    hash_chunk[0][0] = select_hash_chunk(0,                         0);
+    hash_chunk[0][1] = select_hash_chunk(0,                         FPRINT_S_SUM_TO_F_SUM(flags));
+    hash_chunk[1][0] = select_hash_chunk(flags & FPRINT_F_SUM_MASK, 0);
+    hash_chunk[1][1] = select_hash_chunk(flags & FPRINT_F_SUM_MASK, FPRINT_S_SUM_TO_F_SUM(flags));
+
+    SET_NOT_INTERRUPTABLE();
+
+    ret = add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
+    if (ret) {
+        error_write(er_h, "failed to get space for file data");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+    temp_file_data->parent_entry = entry;
+
+    *data_being_replaced = old_data;
+    entry->data = temp_file_data;
+
+    temp_file_data->norm_sect_size = norm_sect_size;
+    temp_file_data->last_sect_size = last_sect_size;
+
+    ret = append_sections(temp_file_data, sect_num);
+    if (ret) {
+        error_write(er_h, "failed to get space for section");
+        restore_old_data(dh, entry, old_data, data_being_replaced);
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+
+    // carry over complete sections
+    for (i = 0; i < keep_num; i++) {
+        ret = copy_section(temp_file_data, i, old_data, i);
+        if (ret) {
+            error_write(er_h, "failed to get space for section");
+            restore_old_data(dh, entry, old_data, data_being_replaced);
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+
+        link_sect_to_checksum_structures(dh, temp_file_data, i);
+    }
+
+    if (state_pos == old_data->resume.pos) {    // no new block boundary reached
+        temp_file_data->resume = old_data->resume;
+    }
+
+    SET_INTERRUPTABLE();
+
+    // file wise extracts before streamed part are read directly
+    if (flags & FPRINT_USE_F_EXTR) {
+        set_extract_positions(temp_file_data->extract, &temp_file_data->extract_num, 0, file_size);
+    }
+    else {
+        temp_file_data->extract_num = 0;
+    }
+
+    ret = read_extracts(file, temp_file_data->extract, temp_file_data->extract_num, stream_start);
+    if (!ret) {
+        ret = seek_to(file, stream_start);
+    }
+    if (ret) {
+        SET_NOT_INTERRUPTABLE();
+        restore_old_data(dh, entry, old_data, data_being_replaced);
+        SET_INTERRUPTABLE();
+        return FS_FILE_NOT_APPENDED;
+    }
+
+    // stream the tail
+    cur_sect = keep_num;
+    for (pos = stream_start; pos < file_size; pos += bytes) {
+        if (pos >= new_start && !sect_open) {
+            temp_section = temp_file_data->section + cur_sect;
+            get_sect_pos(temp_file_data, cur_sect, &sect_start, &sect_end);
+
+            if (flags & FPRINT_USE_S_EXTR) {
+                get_sect_extract_arr(temp_file_data, cur_sect, &temp_extract);
+                set_extract_positions(temp_extract, &temp_section->extract_num, sect_start, sect_end - sect_start + 1);
+            }
+            else {
+                temp_section->extract_num = 0;
+            }
+
+            digest_init(&s_ctx, FPRINT_S_SUM_TO_F_SUM(flags));
+
+            sect_open = 1;
+        }
+
+        // stop at every point where the set of consumers changes
+        limit = file_size;
+        if (pos < old_data->resume.pos) {
+            limit = ffp_min(limit, old_data->resume.pos);
+        }
+        if (sect_open) {
+            limit = ffp_min(limit, sect_end + 1);
+        }
+        else {
+            limit = ffp_min(limit, new_start);
+        }
+
+        if (throttle_active()) {
+            read_start_ns = throttle_now_ns();
+        }
+
+        bytes = fread(data_buf, 1, ffp_min(FPRINT_READ_BUFFER_SIZE, limit - pos), file);
+        if (bytes == 0) {   // file shrunk under us
+            SET_NOT_INTERRUPTABLE();
+            restore_old_data(dh, entry, old_data, data_being_replaced);
+            SET_INTERRUPTABLE();
+            return FS_FILE_NOT_APPENDED;
+        }
+
+        if (throttle_active()) {
+            throttle_record_latency(throttle_now_ns() - read_start_ns);
+            throttle_take_bytes(bytes);
+        }
+
+        wf_fed = pos >= old_data->resume.pos;
+
+        hash_chunk_saving(hash_chunk[wf_fed][sect_open], wf_fed ? &wf_ctx : NULL, sect_open ? &s_ctx : NULL, data_buf, pos, bytes, state_pos, flags, &temp_file_data->resume);
+
+        capture_extracts(temp_file_data->extract, temp_file_data->extract_num, data_buf, pos, bytes);
+
+        if (sect_open) {
+            capture_extracts(sect_extract(temp_file_data, cur_sect), temp_section->extract_num, data_buf, pos, bytes);
+
+            if (pos + bytes == sect_end + 1) {
+                SET_NOT_INTERRUPTABLE();
+
+                digest_final(&s_ctx, temp_checksum);
+                set_sect_checksums(temp_file_data, cur_sect, temp_checksum);
+
+                link_sect_to_checksum_structures(dh, temp_file_data, cur_sect);
+
+                SET_INTERRUPTABLE();
+
+                cur_sect++;
+                sect_open = 0;
+            }
+        }
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    digest_final(&wf_ctx, temp_file_data->checksum);
+
+    fill_mrkl_root(temp_file_data, flags);
+
+    temp_file_data->file_size = file_size;
+    sprintf(temp_file_data->file_size_str, "%"PRIu64"", file_size);
+
+    ret = link_file_data_to_file_size_structures(dh, temp_file_data);
+    if (ret) {
+        restore_old_data(dh, entry, old_data, data_being_replaced);
+        error_write(er_h, "failed to link file data via file size");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+
+    link_file_data_to_extract_index(dh, temp_file_data);
 
     link_file_data_to_checksum_structures(dh, temp_file_data);
 
-    SET_INTERRUPTABLE();
+    del_file_data(dh, old_data);
+
+    *data_being_replaced = NULL;
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+/*  fingerprint_refresh re-fingerprints file at path into existing entry
+ *
+ *  if the file was only appended to, only the tail is read (see fingerprint_append),
+ *  otherwise the whole file is fingerprinted again and replaces old file data
+ */
+int fingerprint_refresh (database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, refresh_stats* stats) {
+    FILE* file;
+    struct stat file_stat;
+    file_data* old_data;
+    uint64_t old_size;
+    int ret2;
+    int ret;
+
+    error_mark_starter(er_h, "fingerprint_refresh");
+
+    *file_being_used = NULL;
+    *data_being_replaced = NULL;
+
+    if ((ret = verify_str_terminated(path, FS_PATH_MAX, NULL, 0x0))) {
+        return ret;
+    }
+
+    if (stat(path, &file_stat)) {
+        error_write(er_h, "failed to get stats - file may not exist");
+        return FFP_GENERAL_FAIL;
+    }
+
+    if (!S_ISREG(file_stat.st_mode)) {
+        return FS_UNRECOGNISED_FILE_TYPE;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    file = fopen(path, "rb");
+    if (!file) {
+        error_write(er_h, "unable to open file");
+        SET_INTERRUPTABLE();
+        return FOPEN_FAIL;
+    }
+
+    *file_being_used = file;
+
+    SET_INTERRUPTABLE();
+
+    if (throttle_active()) {
+        throttle_take_file();
+    }
+
+    old_size = entry->data ? entry->data->file_size : 0;
+
+    ret = fingerprint_append(dh, file, file_stat.st_size, entry, flags, er_h, data_being_replaced);
+    if (ret == 0) {
+        if ((uint64_t) file_stat.st_size == old_size) {
+            stats->unchanged++;
+        }
+        else {
+            stats->appended++;
+        }
+    }
+    else if (ret == FS_FILE_NOT_APPENDED) {
+        rewind(file);
+
+        SET_NOT_INTERRUPTABLE();
+
+        old_data = entry->data;
+        *data_being_replaced = old_data;
+        entry->data = NULL;
+
+        SET_INTERRUPTABLE();
+
+        ret = fingerprint_stream(dh, file, file_stat.st_size, entry, flags, er_h);
+
+        SET_NOT_INTERRUPTABLE();
+
+        if (ret) {
+            restore_old_data(dh, entry, old_data, data_being_replaced);
+        }
+        else {
+            if (old_data) {
+                del_file_data(dh, old_data);
+            }
+            *data_being_replaced = NULL;
+
+            stats->full++;
+        }
+
+        SET_INTERRUPTABLE();
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    fclose(file);
+
+    ret2 = verify_entry(dh, entry, 0x0);
+    if (ret2) {
+        printf("fingerprint_refresh : verify entry detected errors\n");
+        printf("file name : %s\n", path);
+        printf("Please report to developer as this should not happen\n");
+        printf("It is recommended that you revert to previous version of database as this may indicate your database is now corrupted\n");
+        printf("Sorry for the inconvenience\n");
+        ret = ret2;
+    }
+
+    // clear pointer so cleanup function will not clean it again
+    *file_being_used = NULL;
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return ret;
+}
+
+/*  fingerprint_refresh_tree refreshes entry from path
+ *
+ *  file entries are refreshed from regular files, group entries from directories
+ *  by matching names of child entries against directory content,
+ *  entries without counterpart in file system are reported and skipped
+ */
+int fingerprint_refresh_tree (database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, refresh_stats* stats) {
+    struct stat file_stat;
+
+    char child_path[FS_PATH_MAX+1];
+
+    linked_entry* child;
+
+    ffp_eid_int i;
+
+    int ret;
+
+    if (stat(path, &file_stat)) {
+        printf("fingerprint_refresh_tree : failed to get stats, skipped : %s\n", path);
+        stats->skipped++;
+        return 0;
+    }
+
+    if (entry->type == ENTRY_FILE && S_ISREG(file_stat.st_mode)) {
+        return fingerprint_refresh(dh, path, entry, flags, er_h, file_being_used, data_being_replaced, stats);
+    }
+
+    if (entry->type != ENTRY_GROUP || !S_ISDIR(file_stat.st_mode)) {
+        printf("fingerprint_refresh_tree : type of entry does not match file, skipped : %s\n", path);
+        stats->skipped++;
+        return 0;
+    }
+
+    for (i = 0; i < entry->child_num; i++) {
+        child = entry->child[i];
+        if (!child) {
+            continue;
+        }
+
+        if (strlen(path) + 1 + child->file_name_len > FS_PATH_MAX) {
+            printf("fingerprint_refresh_tree : path too long, skipped : %s\n", child->file_name);
+            stats->skipped++;
+            continue;
+        }
+
+        sprintf(child_path, "%s/%s", path, child->file_name);
+
+        ret = fingerprint_refresh_tree(dh, child_path, child, flags, er_h, file_being_used, data_being_replaced, stats);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/* deferred hashing */
+
+hash_worker_info fp_hash_worker = {0};
+
+// loose resources of the job in progress, only meaningful while fp_hash_worker.dh is set
+static content_job worker_job;
+static FILE* worker_file = NULL;
+static file_data* worker_old_data = NULL;
+static error_handle worker_er_h;
+
+// file data with what stat gives, content is hashed later with flags
+static int defer_file (database_handle* dh, char* path, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h) {
+    file_data* temp_file_data;
+    char* abs_path;
+    int ret;
+
+    error_mark_starter(er_h, "defer_file");
+
+    flags = FPRINT_NORMALISE(flags) & ~FPRINT_DEFER_HASH;
+
+    // empty files carry no file data, same as fingerprint_stream
+    if (file_size == 0) {
+        return 0;
+    }
+
+    if (file_size > FILE_SIZE_MAX) {
+        printf("defer_file : %s : file too large\n", entry->file_name);
+        return FS_FILE_TOO_LARGE;
+    }
+
+    if (access(path, R_OK)) {
+        error_write(er_h, "unable to open file");
+        return FOPEN_FAIL;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    // worker does not run from the directory fp is walking
+    abs_path = malloc(FS_PATH_MAX+1);
+    if (!abs_path) {
+        error_write(er_h, "failed to allocate space for path");
+        SET_INTERRUPTABLE();
+        return MALLOC_FAIL;
+    }
+
+    if (path[0] == '/') {
+        abs_path[0] = 0;
+    }
+    else if (!getcwd(abs_path, FS_PATH_MAX+1)) {
+        free(abs_path);
+        error_write(er_h, "failed to get current directory");
+        SET_INTERRUPTABLE();
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    if (strlen(abs_path) + 1 + strlen(path) > FS_PATH_MAX) {
+        free(abs_path);
+        error_write(er_h, "path too long");
+        SET_INTERRUPTABLE();
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    if (abs_path[0] != 0) {
+        strcat(abs_path, "/");
+    }
+    strcat(abs_path, path);
+
+    ret = add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, NULL);
+    if (ret) {
+        free(abs_path);
+        error_write(er_h, "failed to get space for file data");
+        SET_INTERRUPTABLE();
+        return ret;
+    }
+    entry->data = temp_file_data;
+    temp_file_data->parent_entry = entry;
+
+    if (flags & FPRINT_USE_F_SIZE) {
+        temp_file_data->file_size = file_size;
+        sprintf(temp_file_data->file_size_str, "%"PRIu64"", file_size);
+
+        ret = link_file_data_to_file_size_structures(dh, temp_file_data);
+        if (ret) {
+            free(abs_path);
+            error_write(er_h, "failed to link file data via file size");
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+    }
+
+    link_file_data_to_pending_queue(dh, temp_file_data, flags, abs_path);
+
+    MARK_DB_UNSAVED(dh);
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+int hash_worker_busy() {
+    return fp_hash_worker.dh != NULL;
+}
+
+// pending file data could not be hashed, keep what stat gave and stop trying
+static void hash_worker_give_up(database_handle* dh, file_data* data) {
+    unlink_file_data_from_pending_queue(dh, data);
+
+    fp_hash_worker.failed_num++;
+}
+
+static void hash_worker_close() {
+    fclose(worker_file);
+    worker_file = NULL;
+    worker_old_data = NULL;
+
+    fp_hash_worker.dh = NULL;
+    fp_hash_worker.entry = NULL;
+}
+
+// (re)start job on file data at head of queue of dh, kernel hashing is only tried if allowed
+static int hash_worker_start(database_handle* dh, unsigned char allow_kernel) {
+    file_data* data = worker_file ? worker_old_data : dh->pending_head;
+    linked_entry* entry = data->parent_entry;
+    struct stat file_stat;
+    int zc_fd;
+    int ret;
+
+    if (!worker_file) {
+        worker_file = fopen(data->pending_path, "rb");
+        if (!worker_file) {
+            hash_worker_give_up(dh, data);
+            return FOPEN_FAIL;
+        }
+
+        if (fstat(fileno(worker_file), &file_stat) || !S_ISREG(file_stat.st_mode)) {
+            fclose(worker_file);
+            worker_file = NULL;
+            hash_worker_give_up(dh, data);
+            return FS_UNRECOGNISED_FILE_TYPE;
+        }
+
+        if (throttle_active()) {
+            throttle_take_file();
+        }
+
+        fp_hash_worker.dh = dh;
+        fp_hash_worker.entry = entry;
+        fp_hash_worker.size = file_stat.st_size;
+        worker_old_data = data;
+    }
+
+    while (1) {
+        rewind(worker_file);
+        fp_hash_worker.pos = 0;
+
+        // partial file data lives in entry until it is complete
+        entry->data = NULL;
+
+        zc_fd = allow_kernel && use_kernel_hashing(data->pending_flags) ? fileno(worker_file) : -1;
+
+        ret = content_job_start(&worker_job, dh, worker_file, zc_fd, fp_hash_worker.size, entry, data->pending_flags, &worker_er_h);
+        if (ret == AFALG_IO_FAIL && zc_fd >= 0) {
+            // drop partial result and go through user space instead
+            if (entry->data) {
+                del_file_data(dh, entry->data);
+            }
+            allow_kernel = 0;
+            continue;
+        }
+
+        break;
+    }
+
+    if (ret) {
+        restore_old_data(dh, entry, data, &worker_old_data);
+        hash_worker_close();
+        hash_worker_give_up(dh, data);
+        return ret;
+    }
+
+    return 0;
+}
+
+/*  hash_worker_abort drops job in progress, partial file data is removed
+ *  and pending file data put back, it stays at head of queue
+ *
+ *  this has to be done before anything else touches the database
+ */
+int hash_worker_abort() {
+    linked_entry* entry = fp_hash_worker.entry;
+    file_data* old_data = worker_old_data;
+
+    if (!hash_worker_busy()) {
+        return 0;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    content_job_abort(&worker_job);
+
+    restore_old_data(fp_hash_worker.dh, entry, old_data, &worker_old_data);
+
+    hash_worker_close();
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+/*  hash_worker_step hashes up to about budget bytes of the file at head of
+ *  queue of dh, or of the file already being hashed if worker is busy
+ *
+ *  returns error code of a file the worker had to give up on, which is
+ *  dropped from queue, this does not stop the worker
+ */
+int hash_worker_step(database_handle* dh, uint64_t budget) {
+    database_handle* job_dh;
+    linked_entry* entry;
+    file_data* old_data;
+    int ret;
+
+    if (!hash_worker_busy()) {
+        if (!dh || !dh->pending_head) {
+            return 0;
+        }
+
+        ret = hash_worker_start(dh, 1);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    job_dh = fp_hash_worker.dh;
+    entry = fp_hash_worker.entry;
+    old_data = worker_old_data;
+
+    ret = content_job_step(&worker_job, budget);
+    if (ret == 0 && worker_job.done) {
+        ret = content_job_finish(&worker_job);
+    }
+    fp_hash_worker.pos = worker_job.pos;
+
+    if (ret == AFALG_IO_FAIL) {
+        // drop partial result and go through user space instead
+        if (entry->data && entry->data != old_data) {
+            del_file_data(job_dh, entry->data);
+        }
+
+        return hash_worker_start(job_dh, 0);
+    }
+    else if (ret) {
+        restore_old_data(job_dh, entry, old_data, &worker_old_data);
+        hash_worker_close();
+        hash_worker_give_up(job_dh, old_data);
+        return ret;
+    }
+
+    if (!worker_job.done) {
+        return 0;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    // new file data replaces pending one, which also leaves the queue
+    del_file_data(job_dh, old_data);
+
+    if (verify_entry(job_dh, entry, 0x0)) {
+        fp_hash_worker.failed_num++;
+    }
+    else {
+        fp_hash_worker.hashed_num++;
+    }
+
+    hash_worker_close();
+
+    tree_digest_update(entry, 0);
+
+    MARK_DB_UNSAVED(job_dh);
+
+    SET_INTERRUPTABLE();
+
+    return 0;
+}
+
+/*  hash_pending_now hashes pending file data of entry immediately,
+ *  ahead of the rest of the queue
+ *
+ *  if file cannot be hashed, entry keeps what stat gave
+ *  and file data is dropped from queue
+ *
+ *  old file data is recorded in data_being_replaced until new file data is complete
+ */
+int hash_pending_now (database_handle* dh, linked_entry* entry, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced) {
+    file_data* old_data = entry->data;
+    int ret;
+
+    if (!old_data || !old_data->pending_flags) {
+        return 0;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    *data_being_replaced = old_data;
+    entry->data = NULL;
+
+    SET_INTERRUPTABLE();
+
+    ret = fingerprint_file(dh, old_data->pending_path, entry, old_data->pending_flags, er_h, file_being_used);
+
+    SET_NOT_INTERRUPTABLE();
+
+    if (ret) {
+        restore_old_data(dh, entry, old_data, data_being_replaced);
+        unlink_file_data_from_pending_queue(dh, old_data);
+    }
+    else {
+        del_file_data(dh, old_data);
+        *data_being_replaced = NULL;
+    }
+
+    tree_digest_update(entry, 0);
+
+    SET_INTERRUPTABLE();
+
+    return ret;
+}
+
+static void hash_pending_count (database_handle* dh, linked_entry* entry, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, uint64_t* hashed, uint64_t* failed) {
+    if (!entry->data || !entry->data->pending_flags) {
+        return;
+    }
+
+    if (hash_pending_now(dh, entry, er_h, file_being_used, data_being_replaced)) {
+        printf("hash_pending_tree : failed to hash, dropped from queue : %s\n", entry->file_name);
+        (*failed)++;
+    }
+    else {
+        (*hashed)++;
+    }
+}
+
+/*  hash_pending_tree hashes pending file data of entry and its children immediately,
+ *  or of the whole branch if recursive
+ *
+ *  files which cannot be hashed are reported and counted in failed
+ */
+int hash_pending_tree (database_handle* dh, linked_entry* entry, unsigned char recursive, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, uint64_t* hashed, uint64_t* failed) {
+    ffp_eid_int i;
+    linked_entry* child;
+
+    hash_pending_count(dh, entry, er_h, file_being_used, data_being_replaced, hashed, failed);
+
+    for (i = 0; i < entry->child_num; i++) {
+        child = entry->child[i];
+        if (!child) {
+            continue;
+        }
+
+        if (recursive) {
+            hash_pending_tree(dh, child, recursive, er_h, file_being_used, data_being_replaced, hashed, failed);
+        }
+        else {
+            hash_pending_count(dh, child, er_h, file_being_used, data_being_replaced, hashed, failed);
+        }
+    }
+
+    return 0;
+}
+
+/* tar archive handling */
+
+// parse numeric field of tar header, handles both octal and base-256 encoding
+static int tar_parse_number(const unsigned char* field, int len, uint64_t* result) {
+    uint64_t val = 0;
+
+    int i;
+
+    if (field[0] & 0x80) {     // base-256
+        val = field[0] & 0x3F;
+        for (i = 1; i < len; i++) {
+            if (val >> 56) {
+                return TAR_INVALID_HEADER;
+            }
+            val = (val << 8) | field[i];
+        }
+    }
+    else {
+        for (i = 0; i < len && field[i] == ' '; i++) {
+            ;;  // skip leading spaces
+        }
+        for (; i < len && field[i] >= '0' && field[i] <= '7'; i++) {
+            val = (val << 3) | (field[i] - '0');
+        }
+        if (i < len && field[i] != 0 && field[i] != ' ') {
+            return TAR_INVALID_HEADER;
+        }
+    }
+
+    *result = val;
+
+    return 0;
+}
+
+static int tar_verify_header(const unsigned char* block) {
+    uint64_t expected;
+    uint64_t sum = 0;
+
+    int i;
+
+    if (tar_parse_number(block + TAR_CHKSUM_OFFSET, TAR_CHKSUM_LEN, &expected)) {
+        return TAR_INVALID_HEADER;
+    }
+
+    for (i = 0; i < TAR_BLOCK_SIZE; i++) {
+        if (i >= TAR_CHKSUM_OFFSET && i < TAR_CHKSUM_OFFSET + TAR_CHKSUM_LEN) {
+            sum += ' ';
+        }
+        else {
+            sum += block[i];
+        }
+    }
+
+    return sum == expected ? 0 : TAR_INVALID_HEADER;
+}
+
+// read and discard len bytes from stream
+static int tar_skip(FILE* file, uint64_t len) {
+    unsigned char buf[FILE_BUFFER_SIZE];
+
+    size_t bytes;
+
+    while (len > 0) {
+        bytes = fread(buf, 1, ffp_min(FILE_BUFFER_SIZE, len), file);
+        if (bytes == 0) {
+            return FILE_END_TOO_SOON;
+        }
+        len -= bytes;
+
+        if (throttle_active()) {
+            throttle_take_bytes(bytes);
+        }
+    }
+
+    return 0;
+}
+
+// read member data of length len into buf as string, excess is discarded
+static int tar_read_str(FILE* file, uint64_t len, char* buf, size_t buf_size) {
+    size_t to_read = ffp_min(len, buf_size - 1);
+
+    if (fread(buf, 1, to_read, file) != to_read) {
+        return FILE_END_TOO_SOON;
+    }
+    buf[to_read] = 0;
+
+    return tar_skip(file, len - to_read);
+}
+
+// pick out path and size records from pax extended header
+static void tar_parse_pax(char* buf, size_t buf_len, char* name, unsigned char* name_set, uint64_t* size, unsigned char* size_set) {
+    char* rec = buf;
+    char* key;
+    char* val;
+    char* end;
+
+    unsigned long rec_len;
+
+    while (rec < buf + buf_len) {
+        rec_len = strtoul(rec, &key, 10);
+        if (rec_len == 0 || *key != ' ' || rec + rec_len > buf + buf_len) {
+            break;
+        }
+        key++;
+
+        end = rec + rec_len - 1;   // newline
+        if (*end != '\n') {
+            break;
+        }
+        *end = 0;
+
+        val = strchr(key, '=');
+        if (val) {
+            *val = 0;
+            val++;
+
+            if (        strcmp(key, "path") == 0) {
+                strncpy(name, val, FS_PATH_MAX);
+                name[FS_PATH_MAX] = 0;
+                *name_set = 1;
+            }
+            else if (   strcmp(key, "size") == 0) {
+                if (sscanf(val, "%"SCNu64"", size) == 1) {
+                    *size_set = 1;
+                }
+            }
+        }
+
+        rec = end + 1;
+    }
+}
+
+static linked_entry* find_child_group(database_handle* dh, linked_entry* parent, const char* name) {
+    child_cursor cursor;
+    linked_entry* child;
+    str_id id;
+
+    // name was never interned, so no entry has it
+    if (str_intern_find(&dh->strs, name, strlen(name), &id)) {
+        return NULL;
+    }
+
+    child_cursor_init(&cursor, parent, id);
+    while (child_cursor_next(&cursor, &child) == 0) {
+        if (child->type == ENTRY_GROUP) {
+            return child;
+        }
+    }
+
+    return NULL;
+}
+
+// find or create the group entry for each directory component of path under parent
+// returns the last component in *leaf, or NULL if path names a directory only
+static int resolve_group_path(database_handle* dh, linked_entry* parent, char* path, uint32_t flags, linked_entry** dir_entry, char** leaf, error_handle* er_h) {
+    int ret;
+
+    char* comp;
+    char* next;
+
+    linked_entry* cur = parent;
+    linked_entry* found;
+
+    *leaf = NULL;
+
+    comp = path;
+
+    // treat absolute paths as relative to parent
+    while (*comp == '/') {
+        comp++;
+    }
+
+    while (comp) {
+        next = strchr(comp, '/');
+        if (next) {
+            *next = 0;
+            next++;
+        }
+
+        if (comp[0] == 0 || strcmp(comp, ".") == 0) {
+            comp = next;
+            continue;
+        }
+
+        if (strcmp(comp, "..") == 0) {
+            error_write(er_h, "path goes above target");
+            return WRONG_ARGS;
+        }
+
+        // skip trailing empty components to see if this is the last one
+        while (next && (next[0] == '/' || next[0] == 0)) {
+            if (next[0] == 0) {
+                next = NULL;
+            }
+            else {
+                next++;
+            }
+        }
+
+        if (!next) {
+            *leaf = comp;
+            break;
+        }
+
+        found = find_child_group(dh, cur, comp);
+        if (!found) {
+            ret = new_fs_entry(dh, cur, comp, ENTRY_GROUP, flags, &found, er_h);
+            if (ret) {
+                return ret;
+            }
+        }
 
-    // rewind file
-    fseek(file, 0, SEEK_SET);
+        cur = found;
+        comp = next;
+    }
 
-    if (fread_failed) {     // fread failed previously
-        // forget about extracts
-        temp_file_data->extract_num = 0;
+    *dir_entry = cur;
 
-        for (i = 0; i < sect_num; i++) {
-            temp_section = temp_file_data->section[i];
+    return 0;
+}
 
-            temp_section->extract_num = 0;
-        }
+/*  fingerprint_tar reads a tar archive (or "-" for stdin) in one sequential pass
+ *  and creates a group entry under parent holding one entry per member
+ *
+ *  member directory structure is kept when names are used,
+ *  otherwise all members are put directly under the group entry
+ *
+ *  members other than regular files and directories are skipped
+ */
+int fingerprint_tar (database_handle* dh, char* path, linked_entry* parent, uint32_t flags, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used) {
+    FILE* file;
+
+    int ret = 0;
+    int ret2;
+
+    unsigned char block[TAR_BLOCK_SIZE];
+
+    char name[FS_PATH_MAX+1];
+    unsigned char name_set = 0;
+    char pax_buf[TAR_PAX_BUF_SIZE];
+    char* leaf;
+
+    uint64_t size;
+    uint64_t pax_size = 0;
+    unsigned char pax_size_set = 0;
+    uint64_t padding;
+
+    unsigned char typeflag;
+
+    char group_name[FILE_NAME_MAX+1];
+
+    linked_entry* tar_entry;
+    linked_entry* dir_entry;
+    linked_entry* entry;
+
+    uint64_t member_count = 0;
+
+    error_mark_starter(er_h, "fingerprint_tar");
+
+    *file_being_used = NULL;
+
+    if ((ret = verify_str_terminated(path, FS_PATH_MAX, NULL, 0x0))) {
+        return ret;
     }
-    else {
-        if (flags & FPRINT_USE_F_EXTR) {
-            // whole file extract
-            // calculation for extract sampling
-            if (file_size < EXTRACT_SIZE_MAX) {   // too small of a file
-                extract_num = 1;
-                extract_len = file_size;
-            }
-            else if (file_size < EXTRACT_MAX_NUM * EXTRACT_SIZE_MAX) {
-                extract_num = file_size / EXTRACT_SIZE_MAX;     // deliberately truncating
-                extract_len = EXTRACT_SIZE_MAX;
-            }
-            else {      // expected normal length
-                extract_num = EXTRACT_MAX_NUM;
-                extract_len = EXTRACT_SIZE_MAX;
-            }
-            if (100 * extract_num * extract_len / file_size > EXTRACT_LEAK_MAX_PERCENT) {
-                extract_len = 1;
-                extract_num =
-                    ffp_min(
-                            file_size * EXTRACT_LEAK_MAX_PERCENT / 100,
-                            EXTRACT_MAX_NUM
-                           );
-            }
 
-            temp_file_data->extract_num = extract_num;
+    SET_NOT_INTERRUPTABLE();
+
+    if (strcmp(path, "-") == 0) {
+        file = stdin;
+        strcpy(group_name, "stdin");
+    }
+    else {
+        file = fopen(path, "rb");
+        if (!file) {
+            error_write(er_h, "unable to open file");
+            SET_INTERRUPTABLE();
+            return FOPEN_FAIL;
+        }
 
-            for (i = 0; i < extract_num; i++) {
-                extract_pos = i * (file_size / extract_num);
+        // stdin is never closed by cleanup
+        *file_being_used = file;
 
-                fseek(file, extract_pos, SEEK_SET);
+        ret = path_to_file_name(path, group_name);
+        if (ret) {
+            strcpy(group_name, "archive");
+        }
+    }
 
-                bytes = fread(data_buf, 1, extract_len, file);
-                if (bytes != extract_len) {
-                    fread_failed = 1;
+    // create group entry for archive
+    ret = new_fs_entry(dh, parent, group_name, ENTRY_GROUP, flags, &tar_entry, er_h);
+    if (ret) {
+        goto tar_done;
+    }
 
-                    printf("fingerprint_fail : warning, file ended before extract sampling is finished\n");
-                }
+    MARK_DB_UNSAVED(dh);
 
-                if (fread_failed) {
-                    // discard current extract
-                    temp_file_data->extract_num = i;
+    SET_INTERRUPTABLE();
 
-                    break;
-                }
+    while (1) {
+        if (fread(block, 1, TAR_BLOCK_SIZE, file) != TAR_BLOCK_SIZE) {
+            printf("fingerprint_tar : warning, archive ended without end of archive marker\n");
+            break;
+        }
 
-                temp_extract = temp_file_data->extract + i;
-                memcpy(temp_extract->extract, data_buf, extract_len);
-                temp_extract->len = extract_len;
-                temp_extract->position = extract_pos; //i * (file_size / extract_num);
-            }
+        if (block[0] == 0) {        // end of archive
+            break;
+        }
 
+        if (tar_verify_header(block)) {
+            error_write(er_h, "invalid tar header");
+            ret = TAR_INVALID_HEADER;
+            break;
         }
-        else {
-            temp_file_data->extract_num = 0;
+
+        if (tar_parse_number(block + TAR_SIZE_OFFSET, TAR_SIZE_LEN, &size)) {
+            error_write(er_h, "invalid member size");
+            ret = TAR_INVALID_HEADER;
+            break;
         }
+        padding = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
 
-        if (flags & FPRINT_USE_S_EXTR) {
-            // handle section wise extracts
-            for (i = 0; i < sect_num; i++) {
-                temp_section = temp_file_data->section[i];
+        typeflag = block[TAR_TYPEFLAG_OFFSET];
 
-                if (i < sect_num - 1) {
-                    bytes_left = norm_sect_size;
-                }
-                else {
-                    bytes_left = last_sect_size;
+        switch (typeflag) {
+            case 'L' :      // gnu long name for next member
+                ret = tar_read_str(file, size, name, sizeof(name));
+                name_set = 1;
+                break;
+            case 'x' :      // pax extended header for next member
+                ret = tar_read_str(file, size, pax_buf, sizeof(pax_buf));
+                if (!ret) {
+                    tar_parse_pax(pax_buf, strlen(pax_buf), name, &name_set, &pax_size, &pax_size_set);
                 }
-                if (bytes_left < EXTRACT_SIZE_MAX) {   // too small of a section
-                    extract_num = 1;
-                    extract_len = bytes_left;
+                break;
+            case '0' :
+            case '7' :
+            case 0 :
+            case '5' :
+                if (pax_size_set) {
+                    size = pax_size;
+                    padding = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
                 }
-                else if (bytes_left < EXTRACT_MAX_NUM * EXTRACT_SIZE_MAX) {
-                    extract_num = bytes_left / EXTRACT_SIZE_MAX;
-                    extract_len = EXTRACT_SIZE_MAX;
+
+                if (!name_set) {
+                    // only POSIX ustar has a prefix field, GNU "ustar  " keeps atime/ctime there
+                    if (memcmp(block + TAR_MAGIC_OFFSET, "ustar", 6) == 0 && block[TAR_PREFIX_OFFSET]) {
+                        snprintf(name, sizeof(name), "%.*s/%.*s", TAR_PREFIX_LEN, block + TAR_PREFIX_OFFSET, TAR_NAME_LEN, block + TAR_NAME_OFFSET);
+                    }
+                    else {
+                        snprintf(name, sizeof(name), "%.*s", TAR_NAME_LEN, block + TAR_NAME_OFFSET);
+                    }
                 }
-                else {      // expected normal length
-                    extract_num = EXTRACT_MAX_NUM;
-                    extract_len = EXTRACT_SIZE_MAX;
+
+                SET_NOT_INTERRUPTABLE();
+
+                if (flags & FPRINT_USE_F_NAME) {
+                    ret = resolve_group_path(dh, tar_entry, name, flags, &dir_entry, &leaf, er_h);
+                    if (ret) {
+                        SET_INTERRUPTABLE();
+                        break;
+                    }
                 }
-                if (100 * extract_num * extract_len / (temp_section->end_pos - temp_section->start_pos + 1) > EXTRACT_LEAK_MAX_PERCENT) {
-                    extract_len = 1;
-                    extract_num =
-                        ffp_min(
-                                (temp_section->end_pos - temp_section->start_pos + 1) * EXTRACT_LEAK_MAX_PERCENT / 100,
-                                EXTRACT_MAX_NUM
-                               );
+                else {
+                    dir_entry = tar_entry;
+                    leaf = name;
                 }
 
-                temp_section->extract_num = extract_num;
+                if (typeflag == '5') {
+                    if (leaf && !(flags & FPRINT_USE_F_NAME)) {
+                        ;;  // no structure to keep without names
+                    }
+                    else if (leaf && !find_child_group(dh, dir_entry, leaf)) {
+                        ret = new_fs_entry(dh, dir_entry, leaf, ENTRY_GROUP, flags, &entry, er_h);
+                    }
 
-                for (j = 0; j < extract_num; j++) {
-                    extract_pos = i * norm_sect_size + j * (bytes_left / extract_num);
+                    SET_INTERRUPTABLE();
 
-                    fseek(file, extract_pos, SEEK_SET);
+                    if (!ret) {
+                        ret = tar_skip(file, size);
+                    }
+                    break;
+                }
 
-                    bytes = fread(data_buf, 1, extract_len, file);
-                    if (bytes != extract_len) {
-                        fread_failed = 1;
+                if (!leaf) {
+                    SET_INTERRUPTABLE();
+                    error_write(er_h, "member has empty name");
+                    ret = FILE_NAME_EMPTY;
+                    break;
+                }
 
-                        printf("fingerprint_file : warning, file ended before extract sampling is finished\n");
-                    }
+                ret = new_fs_entry(dh, dir_entry, leaf, ENTRY_FILE, flags, &entry, er_h);
+                if (ret) {
+                    SET_INTERRUPTABLE();
+                    break;
+                }
 
-                    if (fread_failed) {
-                        // discard current extract
-                        temp_section->extract_num = j;
+                // set loose resource
+                *entry_being_used = entry;
 
-                        break;
-                    }
+                SET_INTERRUPTABLE();
 
-                    temp_extract = temp_section->extract + j;
-                    memcpy(temp_extract->extract, data_buf, extract_len);
-                    temp_extract->len = extract_len;
-                    temp_extract->position = extract_pos;
+                if (throttle_active()) {
+                    throttle_take_file();
                 }
 
-                if (fread_failed) {
-                    // set remaining section's extract num to 0
-                    for (j = i + 1; j < sect_num; j++) {
-                        temp_section = temp_file_data->section[j];
+                ret = fingerprint_stream(dh, file, size, entry, flags, er_h);
+                if (ret) {
+                    break;
+                }
 
-                        temp_section->extract_num = 0;
-                    }
+                SET_NOT_INTERRUPTABLE();
 
-                    break;
+                ret2 = verify_entry(dh, entry, 0x0);
+                if (ret2) {
+                    printf("fingerprint_tar : verify entry detected errors\n");
+                    printf("member name : %s\n", entry->file_name);
+                    printf("Please report to developer as this should not happen\n");
+                    printf("Sorry for the inconvenience\n");
                 }
-            }
+
+                // clean up pointers
+                *entry_being_used = NULL;
+
+                SET_INTERRUPTABLE();
+
+                member_count++;
+                break;
+            default :       // links, devices, fifos, global headers etc
+                ret = tar_skip(file, size);
+                break;
+        }
+
+        if (ret) {
+            break;
+        }
+
+        if (typeflag != 'L' && typeflag != 'x') {
+            // extended headers only apply to the member following them
+            name_set = 0;
+            pax_size_set = 0;
+        }
+
+        ret = tar_skip(file, padding);
+        if (ret) {
+            printf("fingerprint_tar : warning, archive ended inside member padding\n");
+            ret = 0;
+            break;
         }
     }
 
+    printf("fingerprint_tar : %"PRIu64" member(s) fingerprinted\n", member_count);
+
     SET_NOT_INTERRUPTABLE();
 
-fingerprint_done:
+tar_done:
 
-    if (file) {
+    if (file != stdin) {
         fclose(file);
     }
 
-    ret2 = verify_entry(dh, entry, 0x0);
-    if (ret2) {
-        printf("fingerprint_file : verify entry detected errors\n");
-        printf("file name : %s\n", path);
-        printf("Please report to developer as this should not happen\n");
-        printf("It is recommended that you revert to previous version of database as this may indicate your database is now corrupted\n");
-        printf("Sorry for the inconvenience\n");
-        ret = ret2;
-    }
-
     // clear pointer so cleanup function will not clean it again
     *file_being_used = NULL;
 
-    MARK_DB_UNSAVED(dh);
-
     SET_INTERRUPTABLE();
 
     return ret;
 }
+
+/* file list handling */
+
+typedef struct list_record list_record;
+
+struct list_record {
+    char* path;
+    str_len_int dir_len;
+    ino_t ino;
+};
+
+// left behind if fingerprint_list is interrupted, freed on next call
+static char* list_buf = NULL;
+static list_record* list_rec = NULL;
+
+static int cmp_list_record(const void* a, const void* b) {
+    const list_record* rec_a = a;
+    const list_record* rec_b = b;
+
+    int ret;
+
+    str_len_int min_len = ffp_min(rec_a->dir_len, rec_b->dir_len);
+
+    // group by directory first
+    ret = strncmp(rec_a->path, rec_b->path, min_len);
+    if (ret) {
+        return ret;
+    }
+    if (rec_a->dir_len != rec_b->dir_len) {
+        return rec_a->dir_len < rec_b->dir_len ? -1 : 1;
+    }
+
+    // then follow inode order within directory
+    if (rec_a->ino != rec_b->ino) {
+        return rec_a->ino < rec_b->ino ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static int read_whole_file(FILE* file, char** buf_p, size_t* len_p) {
+    char* buf = NULL;
+    char* temp;
+    size_t len = 0;
+    size_t cap = 0;
+    size_t bytes;
+
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 4096;
+
+            temp = realloc(buf, cap + 1);
+            if (!temp) {
+                free(buf);
+                return MALLOC_FAIL;
+            }
+            buf = temp;
+        }
+
+        bytes = fread(buf + len, 1, cap - len, file);
+        len += bytes;
+    } while (bytes > 0);
+
+    buf[len] = 0;
+
+    *buf_p = buf;
+    *len_p = len;
+
+    return 0;
+}
+
+/*  fingerprint_list fingerprints paths listed in list_path (or "-" for stdin)
+ *
+ *  paths are separated by NUL if list contains any NUL, otherwise by newline
+ *  relative directory structure is recreated under parent when names are used,
+ *  otherwise all files are put directly under parent
+ *
+ *  paths are visited grouped by directory and in inode order within
+ *  each directory to keep disk access local
+ *
+ *  missing or unreadable paths are reported and skipped
+ */
+int fingerprint_list (database_handle* dh, char* list_path, linked_entry* parent, uint32_t flags, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used) {
+    FILE* file;
+
+    int ret;
+
+    char sep;
+
+    char* cur;
+    char* end;
+    char* slash;
+    char* leaf;
+
+    char path_copy[FS_PATH_MAX+1];
+
+    size_t len;
+    uint64_t rec_num;
+    uint64_t rec_used;
+    uint64_t i;
+
+    uint64_t done_count = 0;
+    uint64_t skip_count = 0;
+
+    struct stat tar_stat;
+
+    linked_entry* dir_entry;
+    linked_entry* entry;
+
+    error_mark_starter(er_h, "fingerprint_list");
+
+    *file_being_used = NULL;
+
+    free(list_buf);
+    free(list_rec);
+    list_buf = NULL;
+    list_rec = NULL;
+
+    // load list
+    if (strcmp(list_path, "-") == 0) {
+        file = stdin;
+    }
+    else {
+        file = fopen(list_path, "rb");
+        if (!file) {
+            error_write(er_h, "unable to open list file");
+            return FOPEN_FAIL;
+        }
+    }
+
+    ret = read_whole_file(file, &list_buf, &len);
+
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    if (ret) {
+        error_write(er_h, "failed to read list file");
+        return ret;
+    }
+
+    sep = memchr(list_buf, 0, len) ? 0 : '\n';
+
+    // count records
+    rec_num = 0;
+    for (cur = list_buf; cur < list_buf + len; cur = end + 1) {
+        end = memchr(cur, sep, list_buf + len - cur);
+        if (!end) {
+            end = list_buf + len;
+        }
+        rec_num++;
+    }
+
+    list_rec = malloc(sizeof(list_record) * (rec_num ? rec_num : 1));
+    if (!list_rec) {
+        error_write(er_h, "failed to allocate list records");
+        return MALLOC_FAIL;
+    }
+
+    // split list and gather stats
+    rec_used = 0;
+    for (cur = list_buf; cur < list_buf + len; cur = end + 1) {
+        end = memchr(cur, sep, list_buf + len - cur);
+        if (!end) {
+            end = list_buf + len;
+        }
+        *end = 0;
+
+        // allow CRLF line endings
+        if (sep == '\n' && end > cur && end[-1] == '\r') {
+            end[-1] = 0;
+        }
+
+        if (cur[0] == 0) {
+            continue;
+        }
+
+        if (strlen(cur) > FS_PATH_MAX) {
+            printf("fingerprint_list : path too long, skipped : %.40s...\n", cur);
+            skip_count++;
+            continue;
+        }
+
+        if (stat(cur, &tar_stat)) {
+            printf("fingerprint_list : failed to get stats, skipped : %s\n", cur);
+            skip_count++;
+            continue;
+        }
+
+        if (!S_ISREG(tar_stat.st_mode) && !S_ISDIR(tar_stat.st_mode)) {
+            printf("fingerprint_list : unsupported file type, skipped : %s\n", cur);
+            skip_count++;
+            continue;
+        }
+
+        slash = strrchr(cur, '/');
+
+        list_rec[rec_used].path = cur;
+        list_rec[rec_used].dir_len = slash ? slash - cur : 0;
+        list_rec[rec_used].ino = tar_stat.st_ino;
+        rec_used++;
+    }
+
+    qsort(list_rec, rec_used, sizeof(list_record), cmp_list_record);
+
+    for (i = 0; i < rec_used; i++) {
+        if (stat(list_rec[i].path, &tar_stat)) {
+            printf("fingerprint_list : file disappeared, skipped : %s\n", list_rec[i].path);
+            skip_count++;
+            continue;
+        }
+
+        SET_NOT_INTERRUPTABLE();
+
+        strcpy(path_copy, list_rec[i].path);
+
+        if (flags & FPRINT_USE_F_NAME) {
+            ret = resolve_group_path(dh, parent, path_copy, flags, &dir_entry, &leaf, er_h);
+            if (ret) {
+                SET_INTERRUPTABLE();
+                printf("fingerprint_list : invalid path, skipped : %s\n", list_rec[i].path);
+                skip_count++;
+                continue;
+            }
+        }
+        else {
+            dir_entry = parent;
+            leaf = path_copy;
+        }
+
+        if (S_ISDIR(tar_stat.st_mode)) {
+            if (leaf && (flags & FPRINT_USE_F_NAME) && !find_child_group(dh, dir_entry, leaf)) {
+                ret = new_fs_entry(dh, dir_entry, leaf, ENTRY_GROUP, flags, &entry, er_h);
+                if (ret) {
+                    SET_INTERRUPTABLE();
+                    return ret;
+                }
+            }
+
+            MARK_DB_UNSAVED(dh);
+
+            SET_INTERRUPTABLE();
+            continue;
+        }
+
+        if (!leaf) {
+            SET_INTERRUPTABLE();
+            printf("fingerprint_list : empty file name, skipped : %s\n", list_rec[i].path);
+            skip_count++;
+            continue;
+        }
+
+        ret = new_fs_entry(dh, dir_entry, leaf, ENTRY_FILE, flags, &entry, er_h);
+        if (ret) {
+            SET_INTERRUPTABLE();
+            return ret;
+        }
+
+        // set loose resource
+        *entry_being_used = entry;
+
+        SET_INTERRUPTABLE();
+
+        ret = fingerprint_file(dh, list_rec[i].path, entry, flags, er_h, file_being_used);
+        if (ret == MALLOC_FAIL || ret == LOGIC_ERROR || ret == VERIFY_FAIL) {
+            // database cannot be trusted to take more entries
+            return ret;
+        }
+        else if (ret) {
+            SET_NOT_INTERRUPTABLE();
+
+            printf("fingerprint_list : %s, skipped : %s\n", er_h->active ? er_h->msg : "failed to fingerprint", list_rec[i].path);
+            error_mark_inactive(er_h);
+            error_mark_starter(er_h, "fingerprint_list");
+
+            // drop half made entry
+            del_entry(dh, entry);
+            *entry_being_used = NULL;
+
+            MARK_DB_UNSAVED(dh);
+
+            SET_INTERRUPTABLE();
+
+            skip_count++;
+            continue;
+        }
+
+        SET_NOT_INTERRUPTABLE();
+
+        // clean up pointers
+        *entry_being_used = NULL;
+
+        SET_INTERRUPTABLE();
+
+        done_count++;
+    }
+
+    printf("fingerprint_list : %"PRIu64" file(s) fingerprinted, %"PRIu64" path(s) skipped\n", done_count, skip_count);
+
+    free(list_buf);
+    free(list_rec);
+    list_buf = NULL;
+    list_rec = NULL;
+
+    return 0;
+}
@@ -18,6 +18,7 @@
 
 #include "ffprinter.h"
 #include "ffp_error.h"
+#include "ffp_ignore.h"
 #include <openssl/sha.h>
 #include <sys/stat.h>
 
@@ -31,6 +32,8 @@
 #define FS_FILE_ACCESS_FAIL             500
 #define FS_UNRECOGNISED_FILE_TYPE       501
 #define FS_FILE_TOO_LARGE               502
+#define TAR_INVALID_HEADER              503
+#define FS_FILE_NOT_APPENDED            504
 
 // fallback section number
 #define FALLBACK_SECT_NUM       100
@@ -47,8 +50,49 @@
 #define FPRINT_USE_S_SHA1       UINT32_C(0x00000080)
 #define FPRINT_USE_S_SHA256     UINT32_C(0x00000100)
 #define FPRINT_USE_S_SHA512     UINT32_C(0x00000200)
+#define FPRINT_USE_F_MRKL       UINT32_C(0x00000400)
+#define FPRINT_DEFER_HASH       UINT32_C(0x00000800)    // only stat data now, content is queued for hashing
+#define FPRINT_USE_F_FUZZY      UINT32_C(0x00001000)
+
+#define FPRINT_F_SUM_MASK       (FPRINT_USE_F_SHA1 | FPRINT_USE_F_SHA256 | FPRINT_USE_F_SHA512)
+#define FPRINT_S_SUM_MASK       (FPRINT_USE_S_SHA1 | FPRINT_USE_S_SHA256 | FPRINT_USE_S_SHA512)
+// section checksum flags translated to the corresponding file checksum flags
+#define FPRINT_S_SUM_TO_F_SUM(flags)    (((flags) & FPRINT_S_SUM_MASK) >> 4)
+// merkle leaves are section sha256 checksums, so they are always recorded with it
+#define FPRINT_NORMALISE(flags) \
+    ((flags) & FPRINT_USE_F_MRKL ? (flags) | FPRINT_USE_S_SHA256 : (flags))
+
+/*  Note on merkle digest :
+ *      merkle root is a file wise checksum built from section sha256 checksums
+ *      as leaves, following the tree shape of RFC 6962
+ *          root of 1 leaf      = the leaf
+ *          root of n > 1 leaves = sha256(0x01 || root(first k) || root(rest))
+ *      where k is the largest power of 2 less than n
+ *
+ *      sections can therefore be hashed independently, and root of any range
+ *      of sections can be worked out from section checksums alone to check
+ *      part of a file, or to narrow down differing sections between two versions
+ *      with the same section layout
+ */
+#define MRKL_NODE_PREFIX        0x01
 
 #define FILE_BUFFER_SIZE            1024
+#define FPRINT_READ_BUFFER_SIZE     65536   // chunk size for hashing content
+
+// tar header layout
+#define TAR_BLOCK_SIZE          512
+#define TAR_NAME_OFFSET         0
+#define TAR_NAME_LEN            100
+#define TAR_SIZE_OFFSET         124
+#define TAR_SIZE_LEN            12
+#define TAR_CHKSUM_OFFSET       148
+#define TAR_CHKSUM_LEN          8
+#define TAR_TYPEFLAG_OFFSET     156
+#define TAR_MAGIC_OFFSET        257
+#define TAR_PREFIX_OFFSET       345
+#define TAR_PREFIX_LEN          155
+
+#define TAR_PAX_BUF_SIZE        8192
 
 #define L1_DIRP_RECORD_ARR_SIZE     1000
 #define L2_DIRP_RECORD_INIT_SIZE    1
@@ -58,6 +102,44 @@
 extern const uint64_t file_size_class_arr[CLASS_NUM];
 extern const uint64_t sect_ideal_size_arr[CLASS_NUM];
 
+typedef struct refresh_stats refresh_stats;
+
+struct refresh_stats {
+    uint64_t unchanged;
+    uint64_t appended;
+    uint64_t full;          // fingerprinted from start again
+    uint64_t skipped;
+};
+
+/*  Note on deferred hashing :
+ *      with FPRINT_DEFER_HASH, fingerprint_file only fills in what stat gives
+ *      and puts file data into pending queue of database (see ffp_database.h),
+ *      content is hashed later by the hash worker
+ *
+ *      the worker hashes one file at a time, a bounded number of bytes per step,
+ *      so it can run in between other work (the prompt runs it while waiting for input),
+ *      partially hashed file data is kept in entry and pending file data aside,
+ *      so job in progress must be aborted before anything else touches the database
+ *
+ *      hash_pending_now and hash_pending_tree hash pending entries immediately,
+ *      for anything which needs the hash of an entry before the worker gets to it
+ */
+typedef struct hash_worker_info hash_worker_info;
+
+struct hash_worker_info {
+    unsigned char paused;
+
+    database_handle* dh;        // database of file being hashed, NULL if idle
+    linked_entry* entry;        // entry of file being hashed
+    uint64_t pos;
+    uint64_t size;
+
+    uint64_t hashed_num;
+    uint64_t failed_num;        // dropped from queue without being hashed
+};
+
+extern hash_worker_info fp_hash_worker;
+
 typedef struct dirp_record dirp_record;
 
 struct dirp_record {
@@ -80,12 +162,43 @@ int get_dirp_record_from_layer2_arr(layer2_dirp_record_arr* l2_arr, dirp_record*
 int get_l1_dirp_record_from_layer2_arr(layer2_dirp_record_arr* l2_arr, layer1_dirp_record_arr** result, bit_index index_of_l1_arr);
 int del_l2_dirp_record_arr(layer2_dirp_record_arr* l2_arr);
 
-int fill_rand_name(linked_entry* entry);
+int fill_rand_name(database_handle* dh, linked_entry* entry);
 
-int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t flags, unsigned char recursive, ffp_eid_int* rem_depth_p, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used, layer2_dirp_record_arr* l2_dirp_record_arr, bit_index* max_dirp_record_index);
+// filter may be NULL, otherwise walk_filter_begin should be called on path first
+int gen_tree (database_handle* dh, char* path, linked_entry* parent, uint32_t flags, unsigned char recursive, ffp_eid_int* rem_depth_p, walk_filter* filter, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used, layer2_dirp_record_arr* l2_dirp_record_arr, bit_index* max_dirp_record_index);
+
+int mrkl_range_root(file_data* data, uint64_t start, uint64_t num, unsigned char* digest);
+
+int fingerprint_stream(database_handle* dh, FILE* file, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h);
+
+// read extracts of file at positions fingerprinting would use, for lookup by extract index
+int sample_file_extracts(int fd, uint64_t file_size, extract_sample* extract, uint32_t* extract_num);
+
+// whole file checksums of file selected by FPRINT_USE_F_SHA* bits, checksum should point to CHECKSUM_MAX_NUM results
+int checksum_file(int fd, uint32_t use, checksum_result* checksum);
 
 int fingerprint_file(database_handle* dh, char* file_name, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used);
 
+int fingerprint_append(database_handle* dh, FILE* file, uint64_t file_size, linked_entry* entry, uint32_t flags, error_handle* er_h, file_data** data_being_replaced);
+
+int fingerprint_refresh(database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, refresh_stats* stats);
+
+int fingerprint_refresh_tree(database_handle* dh, char* path, linked_entry* entry, uint32_t flags, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, refresh_stats* stats);
+
+int hash_worker_busy();
+
+int hash_worker_abort();
+
+int hash_worker_step(database_handle* dh, uint64_t budget);
+
+int hash_pending_now(database_handle* dh, linked_entry* entry, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced);
+
+int hash_pending_tree(database_handle* dh, linked_entry* entry, unsigned char recursive, error_handle* er_h, FILE** file_being_used, file_data** data_being_replaced, uint64_t* hashed, uint64_t* failed);
+
+int fingerprint_tar(database_handle* dh, char* path, linked_entry* parent, uint32_t flags, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used);
+
+int fingerprint_list(database_handle* dh, char* list_path, linked_entry* parent, uint32_t flags, error_handle* er_h, linked_entry** entry_being_used, FILE** file_being_used);
+
 int compare_fingerprint(linked_entry* entry1, linked_entry* entry2, uint16_t result_flags);
 
 #endif
@@ -0,0 +1,68 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Note on hashing kernels :
+ *      hash_chunk_kernel generates a function which feeds one chunk of content
+ *      to whole file and section wise digests
+ *
+ *      the set of checksums is fixed when the function is generated,
+ *      so no flags are tested per chunk, and the compiler is free to inline
+ *      and schedule the digest updates
+ *
+ *      generated function :
+ *          static void hash_chunk_##name (digest_ctx* wf_ctx, digest_ctx* s_ctx, const unsigned char* buf, size_t len)
+ *
+ *      F_* and S_* should be 0 or 1, a context is not touched if none of
+ *      its checksums is used, so it may be NULL in that case
+ *
+ *      hash_chunk_kernel_record generates the matching initialiser of
+ *      hash_chunk_record, uses are stored as FPRINT_USE_F_SHA* bits
+ *      for both contexts, same as digest_ctx
+ */
+#define hash_chunk_kernel(name, F_SHA1, F_SHA256, F_SHA512, S_SHA1, S_SHA256, S_SHA512) \
+    static void hash_chunk_##name (digest_ctx* wf_ctx, digest_ctx* s_ctx, const unsigned char* buf, size_t len) { \
+        if (F_SHA1) {                                   \
+            SHA1_Update(&wf_ctx->sha1, buf, len);       \
+        }                                               \
+        if (F_SHA256) {                                 \
+            SHA256_Update(&wf_ctx->sha256, buf, len);   \
+        }                                               \
+        if (F_SHA512) {                                 \
+            SHA512_Update(&wf_ctx->sha512, buf, len);   \
+        }                                               \
+        if (S_SHA1) {                                   \
+            SHA1_Update(&s_ctx->sha1, buf, len);        \
+        }                                               \
+        if (S_SHA256) {                                 \
+            SHA256_Update(&s_ctx->sha256, buf, len);    \
+        }                                               \
+        if (S_SHA512) {                                 \
+            SHA512_Update(&s_ctx->sha512, buf, len);    \
+        }                                               \
+    }
+
+#define hash_chunk_kernel_record(name, F_SHA1, F_SHA256, F_SHA512, S_SHA1, S_SHA256, S_SHA512) \
+    {                                                   \
+            ((F_SHA1)   ? FPRINT_USE_F_SHA1     : 0)    \
+        |   ((F_SHA256) ? FPRINT_USE_F_SHA256   : 0)    \
+        |   ((F_SHA512) ? FPRINT_USE_F_SHA512   : 0),   \
+            ((S_SHA1)   ? FPRINT_USE_F_SHA1     : 0)    \
+        |   ((S_SHA256) ? FPRINT_USE_F_SHA256   : 0)    \
+        |   ((S_SHA512) ? FPRINT_USE_F_SHA512   : 0),   \
+        &hash_chunk_##name                              \
+    }
@@ -0,0 +1,406 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffp_fuzzy.h"
+
+static const char b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int b64_index(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+
+    return -1;
+}
+
+static void stream_init(fuzzy_stream* stream, uint64_t block_size, uint32_t sig_max) {
+    stream->block_size = block_size;
+    stream->sig_max = sig_max;
+    stream->h = FUZZY_FNV_INIT;
+    stream->len = 0;
+    stream->tail = 0;
+    stream->sig[0] = 0;
+}
+
+void fuzzy_init(fuzzy_ctx* ctx, uint64_t file_size) {
+    uint64_t block_size = FUZZY_BS_MIN;
+    int shift = 0;
+
+    while (block_size * FUZZY_SIG_MAX < file_size && shift < FUZZY_BS_SHIFT_MAX) {
+        block_size *= 2;
+        shift++;
+    }
+
+    ctx->h1 = 0;
+    ctx->h2 = 0;
+    ctx->h3 = 0;
+    ctx->n = 0;
+    memset(ctx->window, 0, FUZZY_ROLL_WINDOW);
+
+    ctx->block_size = block_size;
+
+    // no half block size to fall back to at minimum
+    stream_init(ctx->stream + 0, block_size > FUZZY_BS_MIN ? block_size / 2 : 0, FUZZY_SIG_MAX);
+    stream_init(ctx->stream + 1, block_size,        FUZZY_SIG_MAX);
+    stream_init(ctx->stream + 2, block_size,        FUZZY_SIG_MAX / 2);
+    stream_init(ctx->stream + 3, block_size * 2,    FUZZY_SIG_MAX / 2);
+}
+
+void fuzzy_update(fuzzy_ctx* ctx, const unsigned char* buf, size_t len) {
+    fuzzy_stream* stream;
+    uint64_t min_block_size;
+    uint32_t sum;
+    unsigned char c;
+    size_t i;
+    int j;
+
+    min_block_size = ctx->stream[0].block_size ? ctx->stream[0].block_size : ctx->block_size;
+
+    for (i = 0; i < len; i++) {
+        c = buf[i];
+
+        // rolling hash
+        ctx->h2 -= ctx->h1;
+        ctx->h2 += FUZZY_ROLL_WINDOW * (uint32_t) c;
+
+        ctx->h1 += c;
+        ctx->h1 -= ctx->window[ctx->n % FUZZY_ROLL_WINDOW];
+
+        ctx->window[ctx->n % FUZZY_ROLL_WINDOW] = c;
+        ctx->n++;
+
+        ctx->h3 <<= 5;
+        ctx->h3 ^= c;
+
+        sum = ctx->h1 + ctx->h2 + ctx->h3;
+
+        for (j = 0; j < FUZZY_STREAM_NUM; j++) {
+            stream = ctx->stream + j;
+            stream->h = (stream->h * FUZZY_FNV_PRIME) ^ c;
+            stream->tail = 1;
+        }
+
+        // block sizes are multiples of the smallest, so no cut point of any stream is missed
+        if (sum % min_block_size != min_block_size - 1) {
+            continue;
+        }
+
+        for (j = 0; j < FUZZY_STREAM_NUM; j++) {
+            stream = ctx->stream + j;
+
+            if (!stream->block_size || sum % stream->block_size != stream->block_size - 1) {
+                continue;
+            }
+
+            // last character covers the rest once signature is full
+            if (stream->len < stream->sig_max - 1) {
+                stream->sig[stream->len++] = b64[stream->h % 64];
+                stream->h = FUZZY_FNV_INIT;
+                stream->tail = 0;
+            }
+        }
+    }
+}
+
+static void stream_final(fuzzy_stream* stream, char* sig, uint8_t* len) {
+    if (stream->tail) {
+        stream->sig[stream->len++] = b64[stream->h % 64];
+    }
+    stream->sig[stream->len] = 0;
+
+    memcpy(sig, stream->sig, stream->len + 1);
+    *len = stream->len;
+}
+
+void fuzzy_final(fuzzy_ctx* ctx, fuzzy_digest* digest) {
+    fuzzy_stream* first;
+    fuzzy_stream* second;
+
+    first   = ctx->stream + 1;
+    second  = ctx->stream + 3;
+    digest->block_size = ctx->block_size;
+
+    // too few cut points at expected block size, use half of it
+    if (first->len + first->tail < FUZZY_SIG_MAX / 2 && ctx->stream[0].block_size) {
+        first   = ctx->stream + 0;
+        second  = ctx->stream + 2;
+        digest->block_size = ctx->stream[0].block_size;
+    }
+
+    stream_final(first,     digest->sig1, &digest->len1);
+    stream_final(second,    digest->sig2, &digest->len2);
+}
+
+// cut runs of one character down to FUZZY_RUN_MAX, they carry little information
+static uint32_t cut_runs(char* dst, const char* src, uint32_t len) {
+    uint32_t i;
+    uint32_t j = 0;
+
+    for (i = 0; i < len; i++) {
+        if (i >= FUZZY_RUN_MAX && src[i] == src[i-1] && src[i] == src[i-2] && src[i] == src[i-3]) {
+            continue;
+        }
+        dst[j++] = src[i];
+    }
+    dst[j] = 0;
+
+    return j;
+}
+
+static int has_common_gram(const char* a, uint32_t a_len, const char* b, uint32_t b_len) {
+    uint32_t i, j;
+
+    if (a_len < FUZZY_GRAM_LEN || b_len < FUZZY_GRAM_LEN) {
+        return 0;
+    }
+
+    for (i = 0; i + FUZZY_GRAM_LEN <= a_len; i++) {
+        for (j = 0; j + FUZZY_GRAM_LEN <= b_len; j++) {
+            if (memcmp(a + i, b + j, FUZZY_GRAM_LEN) == 0) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// insertion and deletion cost 1, substitution costs 2
+static uint32_t edit_distance(const char* a, uint32_t a_len, const char* b, uint32_t b_len) {
+    uint32_t row[2][FUZZY_SIG_MAX + 1];
+    uint32_t* prev = row[0];
+    uint32_t* cur = row[1];
+    uint32_t* tmp;
+    uint32_t cost;
+    uint32_t i, j;
+
+    for (j = 0; j <= b_len; j++) {
+        prev[j] = j;
+    }
+
+    for (i = 1; i <= a_len; i++) {
+        cur[0] = i;
+        for (j = 1; j <= b_len; j++) {
+            cost = prev[j-1] + (a[i-1] == b[j-1] ? 0 : 2);
+            cost = ffp_min(cost, prev[j] + 1);
+            cost = ffp_min(cost, cur[j-1] + 1);
+            cur[j] = cost;
+        }
+
+        tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+
+    return prev[b_len];
+}
+
+static int score_sigs(const char* a_raw, uint32_t a_raw_len, const char* b_raw, uint32_t b_raw_len, uint64_t block_size) {
+    char a[FUZZY_SIG_MAX + 1];
+    char b[FUZZY_SIG_MAX + 1];
+    uint32_t a_len;
+    uint32_t b_len;
+    uint64_t score;
+    uint64_t cap;
+
+    a_len = cut_runs(a, a_raw, a_raw_len);
+    b_len = cut_runs(b, b_raw, b_raw_len);
+
+    if (!has_common_gram(a, a_len, b, b_len)) {
+        return 0;
+    }
+
+    score = (uint64_t) edit_distance(a, a_len, b, b_len) * FUZZY_SIG_MAX / (a_len + b_len);
+    score = 100 * score / FUZZY_SIG_MAX;
+    if (score >= 100) {
+        return 0;
+    }
+    score = 100 - score;
+
+    // small block sizes mean small files, where matching pieces say less
+    if (block_size < (99 + FUZZY_GRAM_LEN) / FUZZY_GRAM_LEN * FUZZY_BS_MIN) {
+        cap = block_size / FUZZY_BS_MIN * ffp_min(a_len, b_len);
+        score = ffp_min(score, cap);
+    }
+
+    return (int) score;
+}
+
+/*  returns similarity score 0 to 100
+ *  digests can only be compared if block sizes are equal or a factor of 2 apart
+ */
+int fuzzy_compare(const fuzzy_digest* a, const fuzzy_digest* b) {
+    int score1, score2;
+
+    if (!a->block_size || !b->block_size) {
+        return 0;
+    }
+
+    if (a->block_size == b->block_size) {
+        if (        a->len1 == b->len1 && memcmp(a->sig1, b->sig1, a->len1) == 0
+                &&  a->len2 == b->len2 && memcmp(a->sig2, b->sig2, a->len2) == 0
+           )
+        {
+            return 100;
+        }
+
+        score1 = score_sigs(a->sig1, a->len1, b->sig1, b->len1, a->block_size);
+        score2 = score_sigs(a->sig2, a->len2, b->sig2, b->len2, a->block_size * 2);
+
+        return ffp_max(score1, score2);
+    }
+    else if (a->block_size == b->block_size * 2) {
+        return score_sigs(a->sig1, a->len1, b->sig2, b->len2, a->block_size);
+    }
+    else if (b->block_size == a->block_size * 2) {
+        return score_sigs(a->sig2, a->len2, b->sig1, b->len1, b->block_size);
+    }
+
+    return 0;
+}
+
+int fuzzy_digest_to_str(char* dst, const fuzzy_digest* digest) {
+    sprintf(dst, "%"PRIu64":%s:%s", digest->block_size, digest->sig1, digest->sig2);
+
+    return 0;
+}
+
+static int parse_sig(char* dst, uint8_t* len, const char* src, char end, uint32_t max, const char** rest) {
+    uint32_t i;
+
+    for (i = 0; src[i] && src[i] != end; i++) {
+        if (i >= max || b64_index(src[i]) < 0) {
+            return WRONG_ARGS;
+        }
+        dst[i] = src[i];
+    }
+    dst[i] = 0;
+    *len = i;
+
+    *rest = src + i;
+
+    return 0;
+}
+
+// parses digest in form of "block size:sig1:sig2"
+int fuzzy_str_to_digest(fuzzy_digest* dst, const char* src) {
+    uint64_t block_size = 0;
+    const char* rest;
+    int shift;
+
+    for (rest = src; *rest >= '0' && *rest <= '9'; rest++) {
+        if (block_size > (UINT64_MAX - 9) / 10) {
+            return WRONG_ARGS;
+        }
+        block_size = block_size * 10 + (*rest - '0');
+    }
+
+    for (shift = 0; shift <= FUZZY_BS_SHIFT_MAX; shift++) {
+        if (block_size == ((uint64_t) FUZZY_BS_MIN << shift)) {
+            break;
+        }
+    }
+    if (shift > FUZZY_BS_SHIFT_MAX || *rest != ':') {
+        return WRONG_ARGS;
+    }
+
+    if (parse_sig(dst->sig1, &dst->len1, rest + 1, ':', FUZZY_SIG_MAX, &rest) || *rest != ':') {
+        return WRONG_ARGS;
+    }
+
+    if (parse_sig(dst->sig2, &dst->len2, rest + 1, 0, FUZZY_SIG_MAX / 2, &rest)) {
+        return WRONG_ARGS;
+    }
+
+    dst->block_size = block_size;
+
+    return 0;
+}
+
+static int block_size_shift(uint64_t block_size) {
+    int shift = 0;
+
+    while ((uint64_t) FUZZY_BS_MIN << shift < block_size) {
+        shift++;
+    }
+
+    return shift;
+}
+
+// key is shift of block size in top bits, and 6 bits per gram character below
+static uint32_t add_grams(const char* raw, uint32_t raw_len, int shift, uint64_t* keys, uint32_t num) {
+    char sig[FUZZY_SIG_MAX + 1];
+    uint32_t len;
+    uint64_t key;
+    uint32_t i, j;
+
+    len = cut_runs(sig, raw, raw_len);
+
+    for (i = 0; i + FUZZY_GRAM_LEN <= len; i++) {
+        key = (uint64_t) shift;
+        for (j = 0; j < FUZZY_GRAM_LEN; j++) {
+            key = (key << 6) | (uint64_t) b64_index(sig[i + j]);
+        }
+
+        for (j = 0; j < num; j++) {
+            if (keys[j] == key) {
+                break;
+            }
+        }
+        if (j == num) {
+            keys[num++] = key;
+        }
+    }
+
+    return num;
+}
+
+/*  fills keys (of at least FUZZY_GRAM_MAX) with distinct grams of both signatures,
+ *  second signature grams are keyed with the doubled block size,
+ *  so they meet first signature grams of digests with that block size
+ *
+ *  returns number of keys
+ */
+uint32_t fuzzy_gram_keys(const fuzzy_digest* digest, uint64_t* keys) {
+    uint32_t num = 0;
+    int shift;
+
+    if (!digest->block_size) {
+        return 0;
+    }
+
+    shift = block_size_shift(digest->block_size);
+
+    num = add_grams(digest->sig1, digest->len1, shift,      keys, num);
+    num = add_grams(digest->sig2, digest->len2, shift + 1,  keys, num);
+
+    return num;
+}
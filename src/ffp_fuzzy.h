@@ -0,0 +1,103 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+
+#ifndef FFP_FUZZY_H
+#define FFP_FUZZY_H
+
+/*  Note on fuzzy digest :
+ *      context triggered piecewise hash, in the manner of spamsum
+ *
+ *      a rolling hash over the last FUZZY_ROLL_WINDOW bytes picks cut points
+ *      from content, and each piece between cut points is reduced to one
+ *      base64 character, so an edit only changes characters of pieces it touches
+ *
+ *      cut points are where rolling hash % block size == block size - 1,
+ *      block size is picked from file size so first signature is about
+ *      FUZZY_SIG_MAX characters long, second signature uses twice the block size
+ *      so digests with block sizes a factor of 2 apart can still be compared
+ *
+ *      spamsum picks block size after seeing the whole file and may go through
+ *      it again with half the block size, here file size is known before reading,
+ *      so signatures at half, same and double the expected block size are all
+ *      collected in the single pass and the half one is used if signature at the
+ *      expected block size turns out short
+ *
+ *      similarity score is 0 to 100, from weighted edit distance of signatures,
+ *      signatures without FUZZY_GRAM_LEN characters in common always score 0,
+ *      so every file data scoring above 0 shares at least one gram with the
+ *      target, which the gram index (see ffp_database.h) relies on
+ */
+
+#define FUZZY_ROLL_WINDOW       7
+#define FUZZY_GRAM_LEN          7
+#define FUZZY_BS_MIN            3
+#define FUZZY_BS_SHIFT_MAX      40      // block size of 3 TiB, covers FILE_SIZE_MAX
+#define FUZZY_RUN_MAX           3       // longer runs of one character are cut down before comparing
+#define FUZZY_STREAM_NUM        4
+
+#define FUZZY_FNV_INIT          UINT32_C(0x28021967)
+#define FUZZY_FNV_PRIME         UINT32_C(0x01000193)
+
+// maximum number of distinct grams of a digest
+#define FUZZY_GRAM_MAX  \
+    ((FUZZY_SIG_MAX - FUZZY_GRAM_LEN + 1) + (FUZZY_SIG_MAX / 2 - FUZZY_GRAM_LEN + 1))
+
+typedef struct fuzzy_stream fuzzy_stream;
+
+struct fuzzy_stream {
+    uint64_t block_size;    // 0 if unused
+    uint32_t sig_max;
+    uint32_t h;             // FNV hash of current piece
+    uint32_t len;
+    unsigned char tail;     // bytes hashed since last cut point
+    char sig[FUZZY_SIG_MAX + 1];
+};
+
+typedef struct fuzzy_ctx fuzzy_ctx;
+
+struct fuzzy_ctx {
+    // rolling hash
+    uint32_t h1;
+    uint32_t h2;
+    uint32_t h3;
+    uint32_t n;
+    unsigned char window[FUZZY_ROLL_WINDOW];
+
+    uint64_t block_size;    // expected block size
+
+    // half first, same first, same second, double second
+    fuzzy_stream stream[FUZZY_STREAM_NUM];
+};
+
+void fuzzy_init(fuzzy_ctx* ctx, uint64_t file_size);
+
+void fuzzy_update(fuzzy_ctx* ctx, const unsigned char* buf, size_t len);
+
+void fuzzy_final(fuzzy_ctx* ctx, fuzzy_digest* digest);
+
+int fuzzy_compare(const fuzzy_digest* a, const fuzzy_digest* b);
+
+int fuzzy_digest_to_str(char* dst, const fuzzy_digest* digest);
+
+int fuzzy_str_to_digest(fuzzy_digest* dst, const char* src);
+
+uint32_t fuzzy_gram_keys(const fuzzy_digest* digest, uint64_t* keys);
+
+#endif
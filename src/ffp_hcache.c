@@ -0,0 +1,477 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// for flock, nanosecond stat timestamps and clock_gettime
+#define _GNU_SOURCE
+
+#include "ffp_hcache.h"
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HCACHE_SLOT_OFF     64      // slot table follows header
+#define HCACHE_CHECK_INIT   UINT64_C(0xcbf29ce484222325)
+#define HCACHE_CHECK_PRIME  UINT64_C(0x100000001b3)
+
+hash_cache fp_hcache = { .fd = -1 };
+
+int64_t hcache_now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (int64_t) ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void make_key(hcache_key* key, const struct stat* st, uint32_t flags) {
+    memset(key, 0, sizeof(hcache_key));
+
+    key->dev        = st->st_dev;
+    key->ino        = st->st_ino;
+    key->size       = st->st_size;
+    key->mtime_ns   = (int64_t) st->st_mtim.tv_sec * INT64_C(1000000000) + st->st_mtim.tv_nsec;
+    key->ctime_ns   = (int64_t) st->st_ctim.tv_sec * INT64_C(1000000000) + st->st_ctim.tv_nsec;
+    key->flags      = flags;
+}
+
+// first slot of bucket of key
+static hcache_slot* bucket_of(hash_cache* cache, const hcache_key* key) {
+    uint64_t h;
+
+    h = key->ino * UINT64_C(0x9e3779b97f4a7c15) ^ key->dev * UINT64_C(0xc2b2ae3d27d4eb4f);
+    h ^= h >> 32;
+
+    return cache->slot + (h & (cache->header->slot_num - 1) & ~(uint64_t) (HCACHE_WAYS - 1));
+}
+
+// FNV-1a over record head past check field, and body
+static uint64_t calc_check(const hcache_rec_head* head, const unsigned char* body, uint32_t len) {
+    const unsigned char* p = (const unsigned char*) &head->key;
+    uint64_t h = HCACHE_CHECK_INIT;
+    size_t i;
+
+    for (i = 0; i < sizeof(hcache_rec_head) - offsetof(hcache_rec_head, key); i++) {
+        h = (h ^ p[i]) * HCACHE_CHECK_PRIME;
+    }
+    for (i = 0; i < len; i++) {
+        h = (h ^ body[i]) * HCACHE_CHECK_PRIME;
+    }
+
+    return h;
+}
+
+static uint64_t rec_total_len(uint32_t len) {
+    uint64_t total = sizeof(hcache_rec_head) + len;
+
+    return (total + HCACHE_REC_ALIGN - 1) / HCACHE_REC_ALIGN * HCACHE_REC_ALIGN;
+}
+
+// record reserved at pos has not been written over, given current head
+static int rec_live(hash_cache* cache, uint64_t pos, uint64_t head) {
+    return head <= pos + cache->header->data_size;
+}
+
+static void init_geometry(hcache_header* header, uint64_t size) {
+    uint64_t slot_num = HCACHE_WAYS;
+
+    while (slot_num * 2 * sizeof(hcache_slot) <= size / HCACHE_SLOT_SHARE) {
+        slot_num *= 2;
+    }
+
+    header->version     = HCACHE_VERSION;
+    header->slot_size   = sizeof(hcache_slot);
+    header->slot_num    = slot_num;
+    header->data_off    = HCACHE_SLOT_OFF + slot_num * sizeof(hcache_slot);
+    header->data_size   = (size - header->data_off) / HCACHE_REC_ALIGN * HCACHE_REC_ALIGN;
+    header->head        = 0;
+}
+
+static int check_geometry(hcache_header* header, uint64_t map_size) {
+    if (map_size < HCACHE_SLOT_OFF) {
+        return HCACHE_BAD_FILE;
+    }
+
+    if (        memcmp(header->magic, HCACHE_MAGIC, HCACHE_MAGIC_LEN) != 0
+            ||  header->version != HCACHE_VERSION
+            ||  header->slot_size != sizeof(hcache_slot)
+       )
+    {
+        return HCACHE_BAD_FILE;
+    }
+
+    if (        header->slot_num < HCACHE_WAYS
+            ||  (header->slot_num & (header->slot_num - 1)) != 0
+            ||  header->data_off != HCACHE_SLOT_OFF + header->slot_num * sizeof(hcache_slot)
+            ||  header->data_size % HCACHE_REC_ALIGN != 0
+            ||  header->data_size < rec_total_len(HCACHE_REC_MAX)
+            ||  header->data_off + header->data_size > map_size
+       )
+    {
+        return HCACHE_BAD_FILE;
+    }
+
+    return 0;
+}
+
+/*  hcache_open maps cache file at path, which is created with given size
+ *  if it does not exist yet, an existing cache file keeps its own size
+ */
+int hcache_open(hash_cache* cache, const char* path, uint64_t size) {
+    struct stat file_stat;
+    hcache_header header;
+    unsigned char* map;
+    int fd;
+    int ret = 0;
+
+    if (strlen(path) > FS_PATH_MAX) {
+        return WRONG_ARGS;
+    }
+
+    size = ffp_max(size, HCACHE_SIZE_MIN);
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return FOPEN_FAIL;
+    }
+
+    // creation is done under lock so other processes never map a half made file
+    if (flock(fd, LOCK_EX)) {
+        close(fd);
+        return FFP_GENERAL_FAIL;
+    }
+
+    if (fstat(fd, &file_stat)) {
+        ret = FFP_GENERAL_FAIL;
+        goto fail;
+    }
+
+    if (file_stat.st_size == 0) {
+        memset(&header, 0, sizeof(hcache_header));
+        init_geometry(&header, size);
+
+        // sparse, slot table reads as unused
+        if (ftruncate(fd, header.data_off + header.data_size)) {
+            ret = FFP_GENERAL_FAIL;
+            goto fail;
+        }
+
+        if (pwrite(fd, &header, sizeof(hcache_header), 0) != sizeof(hcache_header)) {
+            ret = FFP_GENERAL_FAIL;
+            goto fail;
+        }
+
+        // magic goes in last, so a file left over from failed creation is rejected
+        if (pwrite(fd, HCACHE_MAGIC, HCACHE_MAGIC_LEN, 0) != HCACHE_MAGIC_LEN) {
+            ret = FFP_GENERAL_FAIL;
+            goto fail;
+        }
+
+        file_stat.st_size = header.data_off + header.data_size;
+    }
+
+    map = mmap(NULL, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = FFP_GENERAL_FAIL;
+        goto fail;
+    }
+
+    if ((ret = check_geometry((hcache_header*) map, file_stat.st_size))) {
+        munmap(map, file_stat.st_size);
+        goto fail;
+    }
+
+    flock(fd, LOCK_UN);
+
+    if (hcache_active()) {
+        hcache_close(cache);
+    }
+
+    cache->fd = fd;
+    strcpy(cache->path, path);
+    cache->map = map;
+    cache->map_size = file_stat.st_size;
+    cache->header = (hcache_header*) map;
+    cache->slot = (hcache_slot*) (map + HCACHE_SLOT_OFF);
+    cache->data = map + cache->header->data_off;
+
+    cache->lookup_num = 0;
+    cache->hit_num = 0;
+    cache->store_num = 0;
+    cache->skip_num = 0;
+
+    return 0;
+
+fail:
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    return ret;
+}
+
+int hcache_close(hash_cache* cache) {
+    if (cache->fd < 0) {
+        return HCACHE_NOT_OPEN;
+    }
+
+    munmap(cache->map, cache->map_size);
+    close(cache->fd);
+
+    cache->fd = -1;
+    cache->map = NULL;
+    cache->header = NULL;
+    cache->slot = NULL;
+    cache->data = NULL;
+
+    return 0;
+}
+
+/*  hcache_lookup copies body of record of file with stats st and fingerprint flags
+ *  into body, which should have space for HCACHE_REC_MAX bytes
+ *
+ *  returns HCACHE_MISS if there is no such record
+ */
+int hcache_lookup(hash_cache* cache, const struct stat* st, uint32_t flags, unsigned char* body, uint32_t* len) {
+    hcache_key key;
+    hcache_slot* bucket;
+    hcache_slot found;
+    hcache_rec_head rec_head;
+    const unsigned char* rec;
+    uint64_t seq;
+    uint64_t total;
+    int i;
+
+    if (cache->fd < 0) {
+        return HCACHE_NOT_OPEN;
+    }
+
+    cache->lookup_num++;
+
+    make_key(&key, st, flags);
+
+    bucket = bucket_of(cache, &key);
+
+    for (i = 0; i < HCACHE_WAYS; i++) {
+        seq = __atomic_load_n(&bucket[i].seq, __ATOMIC_ACQUIRE);
+        if (seq == 0 || (seq & 1)) {
+            continue;
+        }
+
+        memcpy(&found, bucket + i, sizeof(hcache_slot));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&bucket[i].seq, __ATOMIC_RELAXED) != seq) {
+            continue;
+        }
+
+        if (memcmp(&found.key, &key, sizeof(hcache_key)) == 0) {
+            break;
+        }
+    }
+    if (i == HCACHE_WAYS) {
+        return HCACHE_MISS;
+    }
+
+    if (found.len > HCACHE_REC_MAX) {
+        return HCACHE_MISS;
+    }
+
+    total = rec_total_len(found.len);
+    if (found.pos % cache->header->data_size + total > cache->header->data_size) {
+        return HCACHE_MISS;
+    }
+
+    rec = cache->data + found.pos % cache->header->data_size;
+
+    memcpy(&rec_head, rec, sizeof(hcache_rec_head));
+    memcpy(body, rec + sizeof(hcache_rec_head), found.len);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // writer may have reused the space while it was being copied
+    if (!rec_live(cache, found.pos, __atomic_load_n(&cache->header->head, __ATOMIC_ACQUIRE))) {
+        return HCACHE_MISS;
+    }
+
+    if (        memcmp(&rec_head.key, &key, sizeof(hcache_key)) != 0
+            ||  rec_head.pos != found.pos
+            ||  rec_head.len != found.len
+            ||  rec_head.check != calc_check(&rec_head, body, found.len)
+       )
+    {
+        return HCACHE_MISS;
+    }
+
+    *len = found.len;
+
+    cache->hit_num++;
+
+    return 0;
+}
+
+// slot to put record of key in, cache file should be locked
+static hcache_slot* pick_slot(hash_cache* cache, const hcache_key* key) {
+    hcache_slot* bucket;
+    hcache_slot* oldest = NULL;
+    uint64_t head = cache->header->head;
+    int i;
+
+    bucket = bucket_of(cache, key);
+
+    // older record of the same file
+    for (i = 0; i < HCACHE_WAYS; i++) {
+        if (        bucket[i].seq != 0
+                &&  bucket[i].key.dev == key->dev
+                &&  bucket[i].key.ino == key->ino
+                &&  bucket[i].key.flags == key->flags
+           )
+        {
+            return bucket + i;
+        }
+    }
+
+    // unused, left half written, or record already written over
+    for (i = 0; i < HCACHE_WAYS; i++) {
+        if (        bucket[i].seq == 0
+                ||  (bucket[i].seq & 1)
+                ||  !rec_live(cache, bucket[i].pos, head)
+           )
+        {
+            return bucket + i;
+        }
+    }
+
+    for (i = 0; i < HCACHE_WAYS; i++) {
+        if (!oldest || bucket[i].pos < oldest->pos) {
+            oldest = bucket + i;
+        }
+    }
+
+    return oldest;
+}
+
+/*  hcache_store records body for file with stats st before it was read,
+ *  st_after after it was read, start_ns is time (see hcache_now_ns) reading started
+ *
+ *  records nothing if file may have changed, returns 0 either way
+ */
+int hcache_store(hash_cache* cache, const struct stat* st, const struct stat* st_after, int64_t start_ns, uint32_t flags, const unsigned char* body, uint32_t len) {
+    hcache_key key;
+    hcache_key key_after;
+    hcache_slot* slot;
+    hcache_rec_head rec_head;
+    unsigned char* rec;
+    uint64_t head;
+    uint64_t pos;
+    uint64_t total;
+    uint64_t seq;
+
+    if (cache->fd < 0) {
+        return HCACHE_NOT_OPEN;
+    }
+
+    make_key(&key, st, flags);
+    make_key(&key_after, st_after, flags);
+
+    if (        len > HCACHE_REC_MAX
+            ||  memcmp(&key, &key_after, sizeof(hcache_key)) != 0
+            ||  ffp_max(key.mtime_ns, key.ctime_ns) > start_ns - HCACHE_RACY_NS
+       )
+    {
+        cache->skip_num++;
+        return 0;
+    }
+
+    // another process is storing, not worth waiting for
+    if (flock(cache->fd, LOCK_EX | LOCK_NB)) {
+        cache->skip_num++;
+        return 0;
+    }
+
+    slot = pick_slot(cache, &key);
+
+    // reserve space in ring, records do not wrap around
+    total = rec_total_len(len);
+    head = cache->header->head;
+    pos = head;
+    if (pos % cache->header->data_size + total > cache->header->data_size) {
+        pos += cache->header->data_size - pos % cache->header->data_size;
+    }
+
+    // head moves before space is written, so readers of older records there see it has gone
+    __atomic_store_n(&cache->header->head, pos + total, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    memset(&rec_head, 0, sizeof(hcache_rec_head));
+    rec_head.key = key;
+    rec_head.pos = pos;
+    rec_head.len = len;
+    rec_head.check = calc_check(&rec_head, body, len);
+
+    rec = cache->data + pos % cache->header->data_size;
+    memcpy(rec, &rec_head, sizeof(hcache_rec_head));
+    memcpy(rec + sizeof(hcache_rec_head), body, len);
+
+    // update slot, sequence number is odd in between
+    seq = slot->seq | 1;
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->key = key;
+    slot->pos = pos;
+    slot->len = len;
+
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+
+    flock(cache->fd, LOCK_UN);
+
+    cache->store_num++;
+
+    return 0;
+}
+
+int hcache_print_status(hash_cache* cache) {
+    uint64_t head;
+    uint64_t used = 0;
+    uint64_t i;
+
+    if (cache->fd < 0) {
+        printf("hash cache : off\n");
+        return 0;
+    }
+
+    head = __atomic_load_n(&cache->header->head, __ATOMIC_ACQUIRE);
+
+    for (i = 0; i < cache->header->slot_num; i++) {
+        if (        cache->slot[i].seq != 0
+                &&  !(cache->slot[i].seq & 1)
+                &&  rec_live(cache, cache->slot[i].pos, head)
+           )
+        {
+            used++;
+        }
+    }
+
+    printf("hash cache : %s\n", cache->path);
+    printf("    size    : %"PRIu64" KiB, %"PRIu64" of %"PRIu64" slots in use\n", cache->map_size / 1024, used, cache->header->slot_num);
+    printf("    lookups : %"PRIu64", %"PRIu64" hit\n", cache->lookup_num, cache->hit_num);
+    printf("    stored  : %"PRIu64", %"PRIu64" skipped\n", cache->store_num, cache->skip_num);
+
+    return 0;
+}
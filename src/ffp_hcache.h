@@ -0,0 +1,151 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+#include <sys/stat.h>
+
+#ifndef FFP_HCACHE_H
+#define FFP_HCACHE_H
+
+/*  Note on hash cache :
+ *      file shared by any number of ffprinter processes, mapping stat identity
+ *      of a file (device, inode, size, mtime, ctime) and fingerprint flags
+ *      to content fingerprint worked out before, so fingerprinting an
+ *      unchanged file again only costs a stat
+ *
+ *      layout of cache file
+ *          header
+ *          slot table          HCACHE_WAYS slots per bucket, bucket picked by device and inode
+ *          record area         ring buffer of records, written in order
+ *
+ *      size of cache file is fixed when created, records are evicted
+ *      oldest written first as the ring wraps around, slots are replaced
+ *      within a bucket by the same file, an unused slot, or the oldest record
+ *
+ *      lookups take no lock
+ *          slot has sequence number which is odd while slot is being written,
+ *          slot is read between two reads of sequence number, and is discarded
+ *          if they differ
+ *          record is copied out, then discarded if ring has moved on past it,
+ *          or if its check value does not match
+ *      stores take an exclusive lock on cache file (flock), and are skipped
+ *      if lock is not available right away
+ *
+ *      records are only stored if file looked the same before and after it
+ *      was read, and was last changed HCACHE_RACY_NS before reading started,
+ *      as timestamps of some file systems are too coarse to tell a change
+ *      made within the same tick
+ *
+ *      record body is opaque to the cache, see ffp_fingerprint.c for its layout
+ *      content is in host byte order, cache files are not meant to be moved between machines
+ */
+
+#define HCACHE_MAGIC            "FFPHCACH"
+#define HCACHE_MAGIC_LEN        8
+#define HCACHE_VERSION          1
+
+#define HCACHE_WAYS             8           // slots per bucket
+#define HCACHE_REC_ALIGN        8
+#define HCACHE_REC_MAX          65536       // largest record body
+#define HCACHE_SIZE_MIN         UINT64_C(1048576)
+#define HCACHE_SIZE_DEFAULT     UINT64_C(268435456)
+#define HCACHE_SLOT_SHARE       8           // 1/HCACHE_SLOT_SHARE of cache file is slot table
+
+#define HCACHE_RACY_NS          INT64_C(2000000000)
+
+#define HCACHE_NOT_OPEN         720
+#define HCACHE_BAD_FILE         721
+#define HCACHE_MISS             722
+
+typedef struct hcache_header hcache_header;
+typedef struct hcache_key hcache_key;
+typedef struct hcache_slot hcache_slot;
+typedef struct hcache_rec_head hcache_rec_head;
+typedef struct hash_cache hash_cache;
+
+struct hcache_header {
+    char magic[HCACHE_MAGIC_LEN];
+    uint32_t version;
+    uint32_t slot_size;         // sizeof(hcache_slot) of writer, guards against layout changes
+    uint64_t slot_num;          // power of 2
+    uint64_t data_off;          // offset of record area from start of file
+    uint64_t data_size;
+    uint64_t head;              // bytes ever reserved in record area, next record starts at head % data_size
+};
+
+struct hcache_key {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+    uint32_t flags;
+    uint32_t pad;
+};
+
+struct hcache_slot {
+    uint64_t seq;       // odd while being written, 0 if never used
+    hcache_key key;
+    uint64_t pos;       // value of head when record was reserved
+    uint32_t len;       // of record body
+    uint32_t pad;
+};
+
+struct hcache_rec_head {
+    uint64_t check;     // of key, pos and body
+    hcache_key key;
+    uint64_t pos;
+    uint32_t len;
+    uint32_t pad;
+};
+
+struct hash_cache {
+    int fd;     // -1 if no cache is open
+
+    char path[FS_PATH_MAX+1];
+
+    unsigned char* map;
+    uint64_t map_size;
+    hcache_header* header;
+    hcache_slot* slot;
+    unsigned char* data;
+
+    /* stats of this process */
+    uint64_t lookup_num;
+    uint64_t hit_num;
+    uint64_t store_num;
+    uint64_t skip_num;      // not stored, file changed, too recent or cache busy
+};
+
+extern hash_cache fp_hcache;
+
+#define hcache_active()     (fp_hcache.fd >= 0)
+
+int64_t hcache_now_ns();
+
+int hcache_open(hash_cache* cache, const char* path, uint64_t size);
+
+int hcache_close(hash_cache* cache);
+
+int hcache_lookup(hash_cache* cache, const struct stat* st, uint32_t flags, unsigned char* body, uint32_t* len);
+
+int hcache_store(hash_cache* cache, const struct stat* st, const struct stat* st_after, int64_t start_ns, uint32_t flags, const unsigned char* body, uint32_t len);
+
+int hcache_print_status(hash_cache* cache);
+
+#endif
@@ -0,0 +1,679 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffp_ignore.h"
+#include <fnmatch.h>
+
+static ignore_node* new_node(ignore_set* set, const char* name, unsigned char is_dstar) {
+    ignore_node* node;
+
+    node = malloc(sizeof(ignore_node));
+    if (!node) {
+        return NULL;
+    }
+
+    memset(node, 0, sizeof(ignore_node));
+
+    strcpy(node->name, name);
+    node->is_dstar = is_dstar;
+
+    node->set = set;
+
+    node->rule = -1;
+    node->dir_rule = -1;
+
+    return node;
+}
+
+static void free_node(ignore_node* node) {
+    ignore_node* child;
+    ignore_node* temp;
+
+    uint32_t i;
+
+    HASH_ITER(hh, node->plain, child, temp) {
+        HASH_DEL(node->plain, child);
+        free_node(child);
+    }
+
+    for (i = 0; i < node->wild_num; i++) {
+        free_node(node->wild[i]);
+    }
+    free(node->wild);
+
+    if (node->dstar) {
+        free_node(node->dstar);
+    }
+
+    free(node);
+}
+
+static ignore_set* new_set(uint32_t level) {
+    ignore_set* set;
+
+    set = malloc(sizeof(ignore_set));
+    if (!set) {
+        return NULL;
+    }
+
+    set->root = new_node(set, "", 0);
+    if (!set->root) {
+        free(set);
+        return NULL;
+    }
+
+    set->level = level;
+
+    set->negate = NULL;
+    set->rule_num = 0;
+    set->rule_max = 0;
+
+    return set;
+}
+
+static void free_set(ignore_set* set) {
+    free_node(set->root);
+    free(set->negate);
+    free(set);
+}
+
+static int get_dstar(ignore_node* parent, ignore_node** result) {
+    if (parent->is_dstar) {     // "**/**" is same as "**"
+        *result = parent;
+        return 0;
+    }
+
+    if (!parent->dstar) {
+        parent->dstar = new_node(parent->set, "", 1);
+        if (!parent->dstar) {
+            return MALLOC_FAIL;
+        }
+    }
+
+    *result = parent->dstar;
+
+    return 0;
+}
+
+static int get_child(ignore_node* parent, const char* name, ignore_node** result) {
+    ignore_node* child = NULL;
+    ignore_node** temp_wild;
+
+    uint32_t i;
+
+    if (strpbrk(name, "*?[\\") == NULL) {
+        HASH_FIND_STR(parent->plain, name, child);
+        if (!child) {
+            child = new_node(parent->set, name, 0);
+            if (!child) {
+                return MALLOC_FAIL;
+            }
+            HASH_ADD_STR(parent->plain, name, child);
+        }
+    }
+    else {
+        for (i = 0; i < parent->wild_num; i++) {
+            if (strcmp(parent->wild[i]->name, name) == 0) {
+                child = parent->wild[i];
+                break;
+            }
+        }
+        if (!child) {
+            temp_wild = realloc(parent->wild, sizeof(ignore_node*) * (parent->wild_num + 1));
+            if (!temp_wild) {
+                return MALLOC_FAIL;
+            }
+            parent->wild = temp_wild;
+
+            child = new_node(parent->set, name, 0);
+            if (!child) {
+                return MALLOC_FAIL;
+            }
+            parent->wild[parent->wild_num++] = child;
+        }
+    }
+
+    *result = child;
+
+    return 0;
+}
+
+// compile one pattern into set, blank lines and comments are skipped
+static int add_rule(ignore_set* set, const char* pattern) {
+    char buf[IGNORE_LINE_MAX+1];
+    char* str;
+    char* name;
+    char* next;
+
+    size_t len;
+
+    unsigned char negate = 0;
+    unsigned char dir_only = 0;
+    unsigned char anchored = 0;
+
+    unsigned char* temp_negate;
+    int32_t new_max;
+
+    ignore_node* node;
+
+    int ret;
+
+    len = strlen(pattern);
+    if (len > IGNORE_LINE_MAX) {
+        return IGNORE_PATTERN_INVALID;
+    }
+    strcpy(buf, pattern);
+
+    // strip line ending, and trailing spaces unless escaped
+    while (len > 0) {
+        if (        buf[len-1] == '\n'
+                ||  buf[len-1] == '\r'
+                ||  (buf[len-1] == ' ' && !(len >= 2 && buf[len-2] == '\\'))
+           )
+        {
+            buf[--len] = 0;
+        }
+        else {
+            break;
+        }
+    }
+
+    str = buf;
+
+    if (str[0] == 0 || str[0] == '#') {
+        return 0;
+    }
+
+    if (str[0] == '!') {
+        negate = 1;
+        str++;
+    }
+
+    len = strlen(str);
+    if (len > 0 && str[len-1] == '/') {
+        dir_only = 1;
+        str[--len] = 0;
+    }
+
+    if (str[0] == '/') {
+        anchored = 1;
+        str++;
+    }
+    else if (strchr(str, '/')) {
+        anchored = 1;
+    }
+
+    node = set->root;
+
+    // name without slash matches at any depth
+    if (!anchored) {
+        ret = get_dstar(node, &node);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    for (name = str; name; name = next) {
+        next = strchr(name, '/');
+        if (next) {
+            *next = 0;
+            next++;
+        }
+
+        if (name[0] == 0) {     // repeated slashes
+            continue;
+        }
+
+        if (strcmp(name, "**") == 0) {
+            ret = get_dstar(node, &node);
+        }
+        else if (strlen(name) > FILE_NAME_MAX) {
+            return IGNORE_PATTERN_INVALID;
+        }
+        else {
+            ret = get_child(node, name, &node);
+        }
+        if (ret) {
+            return ret;
+        }
+    }
+
+    if (node == set->root) {
+        return IGNORE_PATTERN_INVALID;
+    }
+
+    if (set->rule_num == set->rule_max) {
+        new_max = set->rule_max ? set->rule_max * 2 : 16;
+
+        temp_negate = realloc(set->negate, new_max);
+        if (!temp_negate) {
+            return MALLOC_FAIL;
+        }
+
+        set->negate = temp_negate;
+        set->rule_max = new_max;
+    }
+
+    set->negate[set->rule_num] = negate;
+
+    if (dir_only) {
+        node->dir_rule = set->rule_num;
+    }
+    else {
+        node->rule = set->rule_num;
+    }
+
+    set->rule_num++;
+
+    return 0;
+}
+
+// read ignore file in current directory, result is NULL if there is none
+static int read_ignore_file(uint32_t level, ignore_set** result) {
+    FILE* file;
+
+    char line[IGNORE_LINE_MAX+1];
+
+    ignore_set* set;
+
+    size_t len;
+    int c;
+
+    int ret = 0;
+
+    *result = NULL;
+
+    file = fopen(IGNORE_FILE_NAME, "r");
+    if (!file) {
+        return 0;
+    }
+
+    set = new_set(level);
+    if (!set) {
+        fclose(file);
+        return MALLOC_FAIL;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        len = strlen(line);
+
+        // skip overly long line
+        if (len > 0 && line[len-1] != '\n' && !feof(file)) {
+            while ((c = fgetc(file)) != EOF && c != '\n') {
+                ;;
+            }
+            continue;
+        }
+
+        // invalid patterns are skipped, same as git
+        ret = add_rule(set, line);
+        if (ret == IGNORE_PATTERN_INVALID) {
+            ret = 0;
+        }
+        if (ret) {
+            break;
+        }
+    }
+
+    fclose(file);
+
+    if (ret || set->rule_num == 0) {
+        free_set(set);
+        return ret;
+    }
+
+    *result = set;
+
+    return 0;
+}
+
+static int reserve_frames(walk_filter* filter, uint32_t num) {
+    ignore_frame* temp_frame;
+    uint32_t new_max;
+
+    if (num <= filter->frame_max) {
+        return 0;
+    }
+
+    new_max = filter->frame_max ? filter->frame_max * 2 : 16;
+    if (new_max < num) {
+        new_max = num;
+    }
+
+    temp_frame = realloc(filter->frame, sizeof(ignore_frame) * new_max);
+    if (!temp_frame) {
+        return MALLOC_FAIL;
+    }
+
+    memset(temp_frame + filter->frame_max, 0, sizeof(ignore_frame) * (new_max - filter->frame_max));
+
+    filter->frame = temp_frame;
+    filter->frame_max = new_max;
+
+    return 0;
+}
+
+// add node and the "**" following it, each node is added once per mark
+static int frame_add(walk_filter* filter, ignore_frame* frame, ignore_node* node) {
+    ignore_node** temp_node;
+    uint32_t new_max;
+
+    while (node && node->mark != filter->mark) {
+        node->mark = filter->mark;
+
+        if (frame->node_num == frame->node_max) {
+            new_max = frame->node_max ? frame->node_max * 2 : 16;
+
+            temp_node = realloc(frame->node, sizeof(ignore_node*) * new_max);
+            if (!temp_node) {
+                return MALLOC_FAIL;
+            }
+
+            frame->node = temp_node;
+            frame->node_max = new_max;
+        }
+
+        frame->node[frame->node_num++] = node;
+
+        node = node->dstar;
+    }
+
+    return 0;
+}
+
+int walk_filter_init(walk_filter* filter) {
+    memset(filter, 0, sizeof(walk_filter));
+
+    filter->use_ignore_file = 1;
+
+    return 0;
+}
+
+int walk_filter_free(walk_filter* filter) {
+    uint32_t i;
+
+    for (i = 0; i < filter->frame_max; i++) {
+        if (filter->frame[i].own) {
+            free_set(filter->frame[i].own);
+        }
+        free(filter->frame[i].node);
+    }
+    free(filter->frame);
+
+    if (filter->run_set) {
+        free_set(filter->run_set);
+    }
+
+    return walk_filter_init(filter);
+}
+
+int walk_filter_add_pattern(walk_filter* filter, const char* pattern) {
+    if (!filter->run_set) {
+        filter->run_set = new_set(IGNORE_SET_LEVEL_RUN);
+        if (!filter->run_set) {
+            return MALLOC_FAIL;
+        }
+    }
+
+    return add_rule(filter->run_set, pattern);
+}
+
+// prepare for walking from path, path itself is never filtered
+int walk_filter_begin(walk_filter* filter, const char* path) {
+    struct stat tar_stat;
+
+    uint32_t i;
+
+    int ret;
+
+    if (stat(path, &tar_stat)) {
+        return GENERAL_FAIL;
+    }
+
+    filter->dev = tar_stat.st_dev;
+
+    // drop what an interrupted walk left behind
+    for (i = 0; i < filter->frame_max; i++) {
+        if (filter->frame[i].own) {
+            free_set(filter->frame[i].own);
+            filter->frame[i].own = NULL;
+        }
+    }
+    filter->frame_num = 0;
+
+    ret = reserve_frames(filter, 1);
+    if (ret) {
+        return ret;
+    }
+
+    filter->frame[0].node_num = 0;
+    filter->mark++;
+
+    if (filter->run_set) {
+        ret = frame_add(filter, &filter->frame[0], filter->run_set->root);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    filter->ignored_dir_num     = 0;
+    filter->ignored_file_num    = 0;
+    filter->other_fs_num        = 0;
+    filter->size_num            = 0;
+    filter->depth_num           = 0;
+    filter->ignore_file_num     = 0;
+
+    return 0;
+}
+
+// record rule ending at node reached by name, and keep node for subdirectory
+static int reach_node(walk_filter* filter, ignore_frame* next, ignore_node* node, unsigned char is_dir, ignore_set** best_set, int32_t* best_rule) {
+    int32_t rule;
+
+    rule = node->rule;
+    if (is_dir && node->dir_rule > rule) {
+        rule = node->dir_rule;
+    }
+
+    if (        rule >= 0
+            &&  (       !*best_set
+                    ||  node->set->level > (*best_set)->level
+                    ||  (node->set == *best_set && rule > *best_rule)
+                )
+       )
+    {
+        *best_set = node->set;
+        *best_rule = rule;
+    }
+
+    if (is_dir) {
+        return frame_add(filter, next, node);
+    }
+
+    return 0;
+}
+
+// match name against nodes reachable in current directory, and work out frame for it if it is a directory
+static int match_name(walk_filter* filter, const char* name, unsigned char is_dir, unsigned char* excluded) {
+    ignore_frame* cur;
+    ignore_frame* next;
+
+    ignore_node* node;
+    ignore_node* child;
+
+    ignore_set* best_set = NULL;
+    int32_t best_rule = -1;
+
+    uint32_t i, j;
+
+    int ret;
+
+    *excluded = 0;
+
+    if (filter->frame_num == 0) {
+        return 0;
+    }
+
+    ret = reserve_frames(filter, filter->frame_num + 1);
+    if (ret) {
+        return ret;
+    }
+
+    cur = &filter->frame[filter->frame_num - 1];
+    next = &filter->frame[filter->frame_num];
+
+    next->node_num = 0;
+    if (next->own) {
+        free_set(next->own);
+        next->own = NULL;
+    }
+
+    filter->mark++;
+
+    for (i = 0; i < cur->node_num; i++) {
+        node = cur->node[i];
+
+        // "**" takes in any name and stays
+        if (node->is_dstar) {
+            ret = reach_node(filter, next, node, is_dir, &best_set, &best_rule);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        HASH_FIND_STR(node->plain, name, child);
+        if (child) {
+            ret = reach_node(filter, next, child, is_dir, &best_set, &best_rule);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        for (j = 0; j < node->wild_num; j++) {
+            if (fnmatch(node->wild[j]->name, name, 0) == 0) {
+                ret = reach_node(filter, next, node->wild[j], is_dir, &best_set, &best_rule);
+                if (ret) {
+                    return ret;
+                }
+            }
+        }
+    }
+
+    if (best_set && !best_set->negate[best_rule]) {
+        *excluded = 1;
+    }
+
+    return 0;
+}
+
+int walk_filter_check(walk_filter* filter, const char* name, const struct stat* st, int* result) {
+    unsigned char is_dir = S_ISDIR(st->st_mode) ? 1 : 0;
+    unsigned char excluded;
+
+    int ret;
+
+    *result = WALK_KEEP;
+
+    if (filter->one_fs && st->st_dev != filter->dev) {
+        filter->other_fs_num++;
+        *result = WALK_SKIP_OTHER_FS;
+        return 0;
+    }
+
+    if (        !is_dir
+            &&  (       (uint64_t) st->st_size < filter->min_size
+                    ||  (filter->max_size && (uint64_t) st->st_size > filter->max_size)
+                )
+       )
+    {
+        filter->size_num++;
+        *result = WALK_SKIP_SIZE;
+        return 0;
+    }
+
+    ret = match_name(filter, name, is_dir, &excluded);
+    if (ret) {
+        return ret;
+    }
+
+    if (excluded) {
+        if (is_dir) {
+            filter->ignored_dir_num++;
+        }
+        else {
+            filter->ignored_file_num++;
+        }
+        *result = WALK_SKIP_IGNORED;
+    }
+
+    return 0;
+}
+
+// called after changing into a directory which passed walk_filter_check
+int walk_filter_enter_dir(walk_filter* filter) {
+    ignore_frame* frame;
+
+    int ret;
+
+    ret = reserve_frames(filter, filter->frame_num + 1);
+    if (ret) {
+        return ret;
+    }
+
+    frame = &filter->frame[filter->frame_num];
+    filter->frame_num++;
+
+    if (!filter->use_ignore_file) {
+        return 0;
+    }
+
+    ret = read_ignore_file(filter->frame_num - 1, &frame->own);
+    if (ret) {
+        return ret;
+    }
+
+    if (frame->own) {
+        filter->ignore_file_num++;
+
+        filter->mark++;
+        ret = frame_add(filter, frame, frame->own->root);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+int walk_filter_leave_dir(walk_filter* filter) {
+    ignore_frame* frame;
+
+    if (filter->frame_num == 0) {
+        return LOGIC_ERROR;
+    }
+
+    filter->frame_num--;
+
+    frame = &filter->frame[filter->frame_num];
+    if (frame->own) {
+        free_set(frame->own);
+        frame->own = NULL;
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+#include <sys/stat.h>
+
+#ifndef FFP_IGNORE_H
+#define FFP_IGNORE_H
+
+/*  Note on ignore rules :
+ *      gitignore style patterns, given to fp or read from IGNORE_FILE_NAME
+ *      of each directory walked, patterns from IGNORE_FILE_NAME are relative
+ *      to the directory holding it, patterns given to fp are relative to target
+ *
+ *          # ...           comment, blank lines are skipped as well
+ *          !pattern        include again what an earlier pattern excluded
+ *          pattern/        only match directories
+ *          /a or a/b       anchored, matched against path from base directory
+ *          a               without slash, matched against name at any depth
+ *          * ? [...]       wildcards within one name, see fnmatch(3)
+ *          **              any number of directories
+ *
+ *      last matching pattern decides, patterns given to fp take precedence
+ *      over ignore files, and deeper ignore files over those above them
+ *      as in git, nothing under an excluded directory can be included again,
+ *      since excluded directories are never opened
+ *
+ *      patterns of a set are compiled into a trie of names, patterns sharing
+ *      leading names share nodes, children with plain names are hashed so
+ *      they are matched by a single lookup, only children with wildcards are
+ *      tried one by one
+ *
+ *      while walking, each directory level keeps the trie nodes reachable at
+ *      that level (a frame), the frame of a subdirectory is worked out from
+ *      the frame of its parent as its name is matched, so names are never
+ *      matched against full paths
+ */
+
+#define IGNORE_FILE_NAME        ".ffpignore"
+#define IGNORE_LINE_MAX         FS_PATH_MAX
+
+#define IGNORE_PATTERN_INVALID  700
+
+#define IGNORE_SET_LEVEL_RUN    UINT32_MAX  // level of patterns given to fp
+
+// results of walk_filter_check
+#define WALK_KEEP               0
+#define WALK_SKIP_IGNORED       1
+#define WALK_SKIP_OTHER_FS      2
+#define WALK_SKIP_SIZE          3
+
+typedef struct ignore_node ignore_node;
+typedef struct ignore_set ignore_set;
+typedef struct ignore_frame ignore_frame;
+typedef struct walk_filter walk_filter;
+
+struct ignore_node {
+    char name[FILE_NAME_MAX+1];     // empty for root and "**"
+    unsigned char is_dstar;
+
+    ignore_set* set;
+
+    int32_t rule;       // last rule ending here, -1 if none
+    int32_t dir_rule;   // last rule ending here which only matches directories, -1 if none
+
+    ignore_node* plain;     // children without wildcard, hashed by name
+    ignore_node** wild;     // children with wildcard
+    uint32_t wild_num;
+    ignore_node* dstar;     // "**" child
+
+    uint64_t mark;
+
+    UT_hash_handle hh;
+};
+
+struct ignore_set {
+    ignore_node* root;
+
+    uint32_t level;     // precedence, higher wins
+
+    unsigned char* negate;  // of each rule
+    int32_t rule_num;
+    int32_t rule_max;
+};
+
+struct ignore_frame {
+    ignore_node** node;
+    uint32_t node_num;
+    uint32_t node_max;
+
+    ignore_set* own;    // read from ignore file of the directory, NULL if none
+};
+
+struct walk_filter {
+    /* options */
+    ignore_set* run_set;
+    unsigned char use_ignore_file;
+    unsigned char one_fs;
+    uint64_t min_size;
+    uint64_t max_size;      // 0 for unlimited
+
+    /* walk state */
+    dev_t dev;
+    ignore_frame* frame;
+    uint32_t frame_num;
+    uint32_t frame_max;
+    uint64_t mark;
+
+    /* stats */
+    uint64_t ignored_dir_num;
+    uint64_t ignored_file_num;
+    uint64_t other_fs_num;
+    uint64_t size_num;
+    uint64_t depth_num;
+    uint64_t ignore_file_num;
+};
+
+int walk_filter_init(walk_filter* filter);
+
+int walk_filter_free(walk_filter* filter);
+
+int walk_filter_add_pattern(walk_filter* filter, const char* pattern);
+
+int walk_filter_begin(walk_filter* filter, const char* path);
+
+int walk_filter_check(walk_filter* filter, const char* name, const struct stat* st, int* result);
+
+int walk_filter_enter_dir(walk_filter* filter);
+
+int walk_filter_leave_dir(walk_filter* filter);
+
+#endif
@@ -0,0 +1,938 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// for realpath and pread
+#define _GNU_SOURCE
+
+#include "ffp_reconcile.h"
+#include "ffp_fingerprint.h"
+#include "ffp_throttle.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+typedef struct reconcile_file reconcile_file;
+typedef struct reconcile_missing reconcile_missing;
+
+// file only on disk
+struct reconcile_file {
+    char* path;     // relative to directory reconciled
+    uint64_t size;
+    linked_entry* moved_from;
+};
+
+// file entry only in database
+struct reconcile_missing {
+    linked_entry* entry;
+    uint64_t size;
+    unsigned char has_size;
+    unsigned char taken;
+};
+
+/* walk state, kept here so an interrupted walk can be cleaned up */
+
+static char base_path[FS_PATH_MAX+1];   // absolute
+static char cur_path[FS_PATH_MAX+1];    // absolute path of directory being read
+static size_t base_len;
+
+static char old_cwd[FS_PATH_MAX+1];
+static unsigned char old_cwd_set = 0;
+
+static DIR* cur_dirp = NULL;
+static int cur_fd = -1;
+
+static linked_entry* root_entry;
+
+// names of all levels being visited, as a stack like cmp_buf
+static char* name_pool = NULL;
+static size_t name_pool_size = 0;
+static size_t* name_off = NULL;
+static size_t name_off_size = 0;
+
+static linked_entry** ent_buf = NULL;
+static size_t ent_buf_size = 0;
+
+static reconcile_file* new_arr = NULL;
+static size_t new_num = 0;
+static size_t new_max = 0;
+
+static reconcile_missing* miss_arr = NULL;
+static size_t miss_num = 0;
+static size_t miss_max = 0;
+
+static size_t* new_idx = NULL;
+static size_t new_idx_size = 0;
+static size_t* miss_idx = NULL;
+static size_t miss_idx_size = 0;
+
+static unsigned char read_buf[RECONCILE_READ_BUFFER_SIZE];
+
+static int reserve(void** arr, size_t* size, size_t need, size_t elem_size) {
+    void* temp;
+
+    if (need <= *size) {
+        return 0;
+    }
+
+    need = ffp_max(need, *size * 2);
+
+    SET_NOT_INTERRUPTABLE();
+
+    temp = realloc(*arr, need * elem_size);
+    if (temp) {
+        *arr = temp;
+        *size = need;
+    }
+
+    SET_INTERRUPTABLE();
+
+    return temp ? 0 : MALLOC_FAIL;
+}
+
+int reconcile_cleanup() {
+    size_t i;
+
+    if (cur_dirp) {
+        closedir(cur_dirp);
+        cur_dirp = NULL;
+    }
+
+    if (cur_fd >= 0) {
+        close(cur_fd);
+        cur_fd = -1;
+    }
+
+    if (old_cwd_set) {
+        if (chdir(old_cwd)) {
+            printf("reconcile : failed to change back to %s\n", old_cwd);
+        }
+        old_cwd_set = 0;
+    }
+
+    for (i = 0; i < new_num; i++) {
+        free(new_arr[i].path);
+    }
+
+    free(name_pool);
+    free(name_off);
+    free(ent_buf);
+    free(new_arr);
+    free(miss_arr);
+    free(new_idx);
+    free(miss_idx);
+
+    name_pool = NULL;
+    name_pool_size = 0;
+    name_off = NULL;
+    name_off_size = 0;
+    ent_buf = NULL;
+    ent_buf_size = 0;
+    new_arr = NULL;
+    new_num = 0;
+    new_max = 0;
+    miss_arr = NULL;
+    miss_num = 0;
+    miss_max = 0;
+    new_idx = NULL;
+    new_idx_size = 0;
+    miss_idx = NULL;
+    miss_idx_size = 0;
+
+    return 0;
+}
+
+static const char* rel_path(const char* name) {
+    static char buf[FS_PATH_MAX+1];
+
+    if (cur_path[base_len] == 0) {
+        snprintf(buf, sizeof(buf), "%s", name);
+    }
+    else {
+        snprintf(buf, sizeof(buf), "%s/%s", cur_path + base_len + 1, name);
+    }
+
+    return buf;
+}
+
+static void print_entry_path(linked_entry* entry) {
+    if (entry->parent != root_entry) {
+        print_entry_path(entry->parent);
+        printf("/");
+    }
+
+    printf("%s", entry->file_name);
+}
+
+static int cmp_name_off(const void* a, const void* b) {
+    return strcmp(name_pool + *(const size_t*) a, name_pool + *(const size_t*) b);
+}
+
+static int cmp_entry_name(const void* a, const void* b) {
+    return strcmp((*(linked_entry* const*) a)->file_name, (*(linked_entry* const*) b)->file_name);
+}
+
+static int cmp_new_size(const void* a, const void* b) {
+    uint64_t x = new_arr[*(const size_t*) a].size;
+    uint64_t y = new_arr[*(const size_t*) b].size;
+
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_miss_size(const void* a, const void* b) {
+    uint64_t x = miss_arr[*(const size_t*) a].size;
+    uint64_t y = miss_arr[*(const size_t*) b].size;
+
+    return x < y ? -1 : x > y;
+}
+
+// size recorded in entry, returns 0 if entry does not record one
+static int entry_size(linked_entry* entry, uint64_t* size) {
+    if (!entry->data) {
+        *size = 0;      // empty files carry no file data
+        return 1;
+    }
+
+    // file data is only made for non-empty files, and load_file leaves size string empty
+    if (entry->data->file_size == 0) {
+        return 0;
+    }
+
+    *size = entry->data->file_size;
+    return 1;
+}
+
+// whole file checksums of entry which can be worked out here, as FPRINT_USE_F_SHA* bits
+static uint32_t entry_sum_use(linked_entry* entry) {
+    file_data* data = entry->data;
+    uint32_t use = 0;
+
+    if (!data || data->pending_flags) {
+        return 0;
+    }
+
+    if (data->checksum[CHECKSUM_SHA1_INDEX].type == CHECKSUM_SHA1_ID) {
+        use |= FPRINT_USE_F_SHA1;
+    }
+    if (data->checksum[CHECKSUM_SHA256_INDEX].type == CHECKSUM_SHA256_ID) {
+        use |= FPRINT_USE_F_SHA256;
+    }
+    if (data->checksum[CHECKSUM_SHA512_INDEX].type == CHECKSUM_SHA512_ID) {
+        use |= FPRINT_USE_F_SHA512;
+    }
+
+    return use;
+}
+
+static int open_file(const char* name) {
+    SET_NOT_INTERRUPTABLE();
+
+    cur_fd = open(name, O_RDONLY);
+
+    SET_INTERRUPTABLE();
+
+    return cur_fd;
+}
+
+static void close_file() {
+    SET_NOT_INTERRUPTABLE();
+
+    close(cur_fd);
+    cur_fd = -1;
+
+    SET_INTERRUPTABLE();
+}
+
+// returns 1 if bytes at extract positions of entry are the same in fd
+static int same_extracts(int fd, file_data* data) {
+    unsigned char buf[EXTRACT_SIZE_MAX];
+    uint32_t i;
+
+    if (!data) {
+        return 1;
+    }
+
+    for (i = 0; i < data->extract_num; i++) {
+        if (pread(fd, buf, data->extract[i].len, data->extract[i].position) != data->extract[i].len) {
+            return 0;
+        }
+
+        if (memcmp(buf, data->extract[i].extract, data->extract[i].len) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// whole file checksums of fd, digest of each algorithm at its CHECKSUM_*_INDEX
+static int hash_fd(int fd, uint32_t use, unsigned char digest[][CHECKSUM_MAX_LEN]) {
+    SHA_CTX     sha1;
+    SHA256_CTX  sha256;
+    SHA512_CTX  sha512;
+
+    ssize_t bytes;
+    uint64_t pos = 0;
+
+    SHA1_Init(&sha1);
+    SHA256_Init(&sha256);
+    SHA512_Init(&sha512);
+
+    while ((bytes = pread(fd, read_buf, RECONCILE_READ_BUFFER_SIZE, pos)) > 0) {
+        if (use & FPRINT_USE_F_SHA1) {
+            SHA1_Update(&sha1, read_buf, bytes);
+        }
+        if (use & FPRINT_USE_F_SHA256) {
+            SHA256_Update(&sha256, read_buf, bytes);
+        }
+        if (use & FPRINT_USE_F_SHA512) {
+            SHA512_Update(&sha512, read_buf, bytes);
+        }
+
+        pos += bytes;
+
+        if (throttle_active()) {
+            throttle_take_bytes(bytes);
+        }
+    }
+    if (bytes < 0) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    SHA1_Final(digest[CHECKSUM_SHA1_INDEX], &sha1);
+    SHA256_Final(digest[CHECKSUM_SHA256_INDEX], &sha256);
+    SHA512_Final(digest[CHECKSUM_SHA512_INDEX], &sha512);
+
+    return 0;
+}
+
+// returns 1 if every checksum in use agrees with digest worked out by hash_fd
+static int same_checksums(file_data* data, uint32_t use, unsigned char digest[][CHECKSUM_MAX_LEN]) {
+    int i;
+
+    if (!use) {
+        return 0;
+    }
+
+    for (i = CHECKSUM_SHA1_INDEX; i <= CHECKSUM_SHA512_INDEX; i++) {
+        if (!(use & (FPRINT_USE_F_SHA1 << i))) {
+            continue;
+        }
+
+        if (memcmp(data->checksum[i].checksum, digest[i], data->checksum[i].len) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int add_new(const char* name, uint64_t size) {
+    reconcile_file* file;
+    int ret;
+
+    ret = reserve((void**) &new_arr, &new_max, new_num + 1, sizeof(reconcile_file));
+    if (ret) {
+        return ret;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    file = new_arr + new_num;
+    file->path = malloc(strlen(rel_path(name)) + 1);
+    if (file->path) {
+        strcpy(file->path, rel_path(name));
+        file->size = size;
+        file->moved_from = NULL;
+        new_num++;
+    }
+
+    SET_INTERRUPTABLE();
+
+    return file->path ? 0 : MALLOC_FAIL;
+}
+
+static int add_missing(linked_entry* entry) {
+    reconcile_missing* missing;
+    uint64_t i;
+    int ret;
+
+    if (entry->type == ENTRY_GROUP) {
+        for (i = 0; i < entry->child_num; i++) {
+            ret = add_missing(entry->child[i]);
+            if (ret) {
+                return ret;
+            }
+        }
+
+        return 0;
+    }
+
+    ret = reserve((void**) &miss_arr, &miss_max, miss_num + 1, sizeof(reconcile_missing));
+    if (ret) {
+        return ret;
+    }
+
+    missing = miss_arr + miss_num;
+    missing->entry = entry;
+    missing->size = 0;
+    missing->has_size = entry_size(entry, &missing->size);
+    missing->taken = 0;
+    miss_num++;
+
+    return 0;
+}
+
+// compare file matched by path with its entry, changed files are printed right away
+static int compare_matched(linked_entry* entry, const char* name, const struct stat* st, uint32_t opts, reconcile_stats* stats) {
+    unsigned char digest[CHECKSUM_MAX_NUM][CHECKSUM_MAX_LEN];
+    uint64_t size;
+    uint32_t use;
+    int same = 1;
+
+    if (entry_size(entry, &size) && size != (uint64_t) st->st_size) {
+        same = 0;
+    }
+
+    use = entry_sum_use(entry);
+
+    if (same && entry->data && (entry->data->extract_num > 0 || (use && (opts & RECONCILE_HASH_MATCHED)))) {
+        if (open_file(name) < 0) {
+            stats->failed++;
+            return 0;
+        }
+
+        same = same_extracts(cur_fd, entry->data);
+
+        if (same && use && (opts & RECONCILE_HASH_MATCHED)) {
+            stats->hashed++;
+
+            if (hash_fd(cur_fd, use, digest)) {
+                stats->failed++;
+                close_file();
+                return 0;
+            }
+
+            same = same_checksums(entry->data, use, digest);
+        }
+
+        close_file();
+    }
+
+    if (same) {
+        stats->same++;
+    }
+    else {
+        printf("* %s\n", rel_path(name));
+        stats->changed++;
+    }
+
+    return 0;
+}
+
+// on failure nothing is entered
+static int enter_dir(size_t* saved_len, const char* name) {
+    size_t len = strlen(cur_path);
+
+    if (len + 1 + strlen(name) > FS_PATH_MAX) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    *saved_len = len;
+    sprintf(cur_path + len, "/%s", name);
+
+    if (chdir(cur_path)) {
+        cur_path[len] = 0;
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    return 0;
+}
+
+static int leave_dir(size_t saved_len) {
+    cur_path[saved_len] = 0;
+
+    if (chdir(cur_path[0] ? cur_path : "/")) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    return 0;
+}
+
+/*  read names of current directory onto name stack, sorted,
+ *  names are at name_off[off_start] up to name_off[*off_top - 1],
+ *  *pool_top is moved past them
+ */
+static int read_names(size_t* pool_top, size_t off_start, size_t* off_top) {
+    struct dirent* dp;
+    size_t len;
+    size_t n = off_start;
+    int ret = 0;
+
+    SET_NOT_INTERRUPTABLE();
+
+    cur_dirp = opendir(".");
+
+    SET_INTERRUPTABLE();
+
+    if (!cur_dirp) {
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    while ((dp = readdir(cur_dirp))) {
+        if (        strcmp(dp->d_name, ".")     == 0
+                ||  strcmp(dp->d_name, "..")    == 0
+           )
+        {
+            continue;
+        }
+
+        len = strlen(dp->d_name) + 1;
+
+        if (        (ret = reserve((void**) &name_pool, &name_pool_size, *pool_top + len, 1))
+                ||  (ret = reserve((void**) &name_off, &name_off_size, n + 1, sizeof(size_t)))
+           )
+        {
+            break;
+        }
+
+        memcpy(name_pool + *pool_top, dp->d_name, len);
+        name_off[n++] = *pool_top;
+        *pool_top += len;
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    closedir(cur_dirp);
+    cur_dirp = NULL;
+
+    SET_INTERRUPTABLE();
+
+    if (ret) {
+        return ret;
+    }
+
+    qsort(name_off + off_start, n - off_start, sizeof(size_t), cmp_name_off);
+
+    *off_top = n;
+
+    return 0;
+}
+
+// stats of name in current directory, returns 0 if it should be looked at
+static int check_name(walk_filter* filter, const char* name, struct stat* st, reconcile_stats* stats) {
+    int filter_result;
+
+    if (stat(name, st)) {
+        stats->failed++;
+        return 1;
+    }
+
+    if (!S_ISREG(st->st_mode) && !S_ISDIR(st->st_mode)) {
+        return 1;
+    }
+
+    if (filter) {
+        if (walk_filter_check(filter, name, st, &filter_result) || filter_result != WALK_KEEP) {
+            stats->ignored++;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int walk_dir(linked_entry* group, walk_filter* filter, uint32_t opts, size_t pool_top, size_t off_top, size_t ent_top, reconcile_stats* stats);
+
+static int add_new_dir(walk_filter* filter, size_t pool_top, size_t off_top, reconcile_stats* stats);
+
+// walk directory name against group, or as only on disk if group is NULL
+static int visit_dir(linked_entry* group, const char* name, walk_filter* filter, uint32_t opts, size_t pool_top, size_t off_top, size_t ent_top, reconcile_stats* stats) {
+    size_t saved_len;
+    int ret;
+
+    // unreadable, so nothing below is known to be gone either
+    if (enter_dir(&saved_len, name)) {
+        stats->failed++;
+        return 0;
+    }
+
+    if (filter) {
+        ret = walk_filter_enter_dir(filter);
+        if (ret) {
+            leave_dir(saved_len);
+            return ret;
+        }
+    }
+
+    if (group) {
+        ret = walk_dir(group, filter, opts, pool_top, off_top, ent_top, stats);
+    }
+    else {
+        ret = add_new_dir(filter, pool_top, off_top, stats);
+    }
+
+    if (filter) {
+        walk_filter_leave_dir(filter);
+    }
+
+    if (leave_dir(saved_len) && !ret) {
+        ret = FS_FILE_ACCESS_FAIL;
+    }
+
+    return ret;
+}
+
+// everything under current directory is only on disk
+static int add_new_dir(walk_filter* filter, size_t pool_top, size_t off_top, reconcile_stats* stats) {
+    struct stat st;
+    size_t off_start = off_top;
+    size_t i;
+    int ret;
+
+    ret = read_names(&pool_top, off_start, &off_top);
+    if (ret) {
+        return ret;
+    }
+
+    for (i = off_start; i < off_top; i++) {
+        if (check_name(filter, name_pool + name_off[i], &st, stats)) {
+            continue;
+        }
+
+        if (S_ISREG(st.st_mode)) {
+            ret = add_new(name_pool + name_off[i], st.st_size);
+            if (ret) {
+                return ret;
+            }
+            continue;
+        }
+
+        ret = visit_dir(NULL, name_pool + name_off[i], filter, 0, pool_top, off_top, 0, stats);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static int walk_dir(linked_entry* group, walk_filter* filter, uint32_t opts, size_t pool_top, size_t off_top, size_t ent_top, reconcile_stats* stats) {
+    struct stat st;
+    size_t off_start = off_top;
+    size_t ent_start = ent_top;
+    size_t ent_num = group->child_num;
+    size_t i, j;
+    linked_entry* child;
+    const char* name;
+    int order;
+    int ret;
+
+    ret = read_names(&pool_top, off_start, &off_top);
+    if (ret) {
+        return ret;
+    }
+
+    ret = reserve((void**) &ent_buf, &ent_buf_size, ent_top + ent_num, sizeof(linked_entry*));
+    if (ret) {
+        return ret;
+    }
+
+    memcpy(ent_buf + ent_start, group->child, sizeof(linked_entry*) * ent_num);
+    qsort(ent_buf + ent_start, ent_num, sizeof(linked_entry*), cmp_entry_name);
+    ent_top += ent_num;
+
+    i = off_start;
+    j = 0;
+    while (i < off_top || j < ent_num) {
+        // buffers may be moved by deeper levels, so always index from them
+        if (i == off_top) {
+            order = 1;
+        }
+        else if (j == ent_num) {
+            order = -1;
+        }
+        else {
+            order = strcmp(name_pool + name_off[i], ent_buf[ent_start + j]->file_name);
+        }
+
+        if (order > 0) {
+            ret = add_missing(ent_buf[ent_start + j]);
+            if (ret) {
+                return ret;
+            }
+
+            j++;
+            continue;
+        }
+
+        name = name_pool + name_off[i];
+        child = order == 0 ? ent_buf[ent_start + j] : NULL;
+
+        i++;
+        if (child) {
+            j++;
+        }
+
+        // ignored on disk, so not missing either
+        if (check_name(filter, name, &st, stats)) {
+            continue;
+        }
+
+        if (child && (child->type == ENTRY_GROUP) != (S_ISDIR(st.st_mode) != 0)) {
+            ret = add_missing(child);
+            if (ret) {
+                return ret;
+            }
+
+            child = NULL;
+        }
+
+        if (S_ISREG(st.st_mode)) {
+            if (child) {
+                ret = compare_matched(child, name, &st, opts, stats);
+            }
+            else {
+                ret = add_new(name, st.st_size);
+            }
+
+            if (ret) {
+                return ret;
+            }
+            continue;
+        }
+
+        ret = visit_dir(child, name, filter, opts, pool_top, off_top, ent_top, stats);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+// pair files only on disk with entries only in database of the same content
+static int pair_moved(reconcile_stats* stats) {
+    unsigned char digest[CHECKSUM_MAX_NUM][CHECKSUM_MAX_LEN];
+    reconcile_file* file;
+    reconcile_missing* missing;
+    size_t i, j, k;
+    size_t m_start, m_end;
+    uint32_t use;
+    int ret;
+
+    if (new_num == 0 || miss_num == 0) {
+        return 0;
+    }
+
+    if (        (ret = reserve((void**) &new_idx, &new_idx_size, new_num, sizeof(size_t)))
+            ||  (ret = reserve((void**) &miss_idx, &miss_idx_size, miss_num, sizeof(size_t)))
+       )
+    {
+        return ret;
+    }
+
+    for (i = 0; i < new_num; i++) {
+        new_idx[i] = i;
+    }
+    for (i = 0; i < miss_num; i++) {
+        miss_idx[i] = i;
+    }
+
+    qsort(new_idx, new_num, sizeof(size_t), cmp_new_size);
+    qsort(miss_idx, miss_num, sizeof(size_t), cmp_miss_size);
+
+    j = 0;
+    for (i = 0; i < new_num; i++) {
+        file = new_arr + new_idx[i];
+
+        // empty files all look the same, pairing them says nothing
+        if (file->size == 0) {
+            continue;
+        }
+
+        while (j < miss_num && (!miss_arr[miss_idx[j]].has_size || miss_arr[miss_idx[j]].size < file->size)) {
+            j++;
+        }
+
+        m_start = j;
+        for (m_end = m_start; m_end < miss_num && miss_arr[miss_idx[m_end]].size == file->size; m_end++) {
+            ;;
+        }
+
+        if (m_start == m_end) {
+            continue;
+        }
+
+        if (open_file(file->path) < 0) {
+            stats->failed++;
+            continue;
+        }
+
+        // narrow down by extracts first, and only hash with checksums candidates have
+        use = 0;
+        for (k = m_start; k < m_end; k++) {
+            missing = miss_arr + miss_idx[k];
+
+            if (!missing->taken && entry_sum_use(missing->entry) && same_extracts(cur_fd, missing->entry->data)) {
+                use |= entry_sum_use(missing->entry);
+            }
+        }
+
+        if (use) {
+            stats->hashed++;
+
+            if (hash_fd(cur_fd, use, digest)) {
+                stats->failed++;
+                use = 0;
+            }
+        }
+
+        for (k = m_start; use && k < m_end; k++) {
+            missing = miss_arr + miss_idx[k];
+
+            if (        !missing->taken
+                    &&  entry_sum_use(missing->entry)
+                    &&  same_extracts(cur_fd, missing->entry->data)
+                    &&  same_checksums(missing->entry->data, entry_sum_use(missing->entry), digest)
+               )
+            {
+                missing->taken = 1;
+                file->moved_from = missing->entry;
+                break;
+            }
+        }
+
+        close_file();
+    }
+
+    return 0;
+}
+
+static void print_results(reconcile_stats* stats) {
+    size_t i;
+
+    for (i = 0; i < new_num; i++) {
+        if (!new_arr[i].moved_from) {
+            continue;
+        }
+
+        printf("> ");
+        print_entry_path(new_arr[i].moved_from);
+        printf(" -> %s\n", new_arr[i].path);
+
+        stats->moved++;
+    }
+
+    for (i = 0; i < new_num; i++) {
+        if (new_arr[i].moved_from) {
+            continue;
+        }
+
+        printf("+ %s\n", new_arr[i].path);
+
+        stats->new_num++;
+    }
+
+    for (i = 0; i < miss_num; i++) {
+        if (miss_arr[i].taken) {
+            continue;
+        }
+
+        printf("- ");
+        print_entry_path(miss_arr[i].entry);
+        printf("\n");
+
+        stats->missing++;
+    }
+}
+
+int reconcile_tree(linked_entry* entry, const char* path, walk_filter* filter, uint32_t opts, reconcile_stats* stats, error_handle* er_h) {
+    struct stat st;
+    int ret;
+
+    error_mark_starter(er_h, "reconcile_tree");
+
+    if (entry->type != ENTRY_GROUP) {
+        error_write(er_h, "entry is not a group");
+        return WRONG_ARGS;
+    }
+
+    if (stat(path, &st) || !S_ISDIR(st.st_mode)) {
+        error_write(er_h, "path is not a directory");
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    if (!realpath(path, base_path)) {
+        error_write(er_h, "failed to resolve path");
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    // root directory itself, names below are joined with '/'
+    if (strcmp(base_path, "/") == 0) {
+        base_path[0] = 0;
+    }
+
+    if (!getcwd(old_cwd, sizeof(old_cwd))) {
+        error_write(er_h, "failed to get current directory");
+        return FS_FILE_ACCESS_FAIL;
+    }
+    old_cwd_set = 1;
+
+    base_len = strlen(base_path);
+    strcpy(cur_path, base_path);
+    root_entry = entry;
+
+    if (chdir(base_path[0] ? base_path : "/")) {
+        error_write(er_h, "failed to change to directory");
+        reconcile_cleanup();
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    ret = filter ? walk_filter_enter_dir(filter) : 0;
+    if (ret) {
+        error_write(er_h, "failed to read ignore rules");
+        reconcile_cleanup();
+        return ret;
+    }
+
+    ret = walk_dir(entry, filter, opts, 0, 0, 0, stats);
+
+    if (filter) {
+        walk_filter_leave_dir(filter);
+    }
+
+    if (ret == 0) {
+        ret = pair_moved(stats);
+    }
+
+    if (ret == 0) {
+        print_results(stats);
+    }
+    else {
+        error_write(er_h, "failed to walk directory");
+    }
+
+    SET_NOT_INTERRUPTABLE();
+
+    reconcile_cleanup();
+
+    SET_INTERRUPTABLE();
+
+    return ret;
+}
@@ -0,0 +1,76 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+#include "ffp_error.h"
+#include "ffp_ignore.h"
+
+#ifndef FFP_RECONCILE_H
+#define FFP_RECONCILE_H
+
+/*  Note on reconcile :
+ *      walks a directory against a group entry and reports, per file
+ *          * path          in both, content differs
+ *          + path          only on disk
+ *          - path          only in database
+ *          > old -> new    moved, same content under another path
+ *      paths are relative to the directory and the group entry
+ *
+ *      each directory is read and its names sorted, then merged with the
+ *      sorted children of the entry of the same path, as cmp does with two entries
+ *
+ *      a file matched by path is compared by size, then by extracts stored
+ *      in entry (read with pread at their positions), and is only hashed if
+ *      asked for (RECONCILE_HASH_MATCHED), changed files are printed as found
+ *
+ *      files left unmatched on either side (including everything under
+ *      directories only on one side) are collected until the walk is done,
+ *      then sorted by size, files only on disk are paired with entries only
+ *      in database of the same size, candidates are narrowed down by extracts,
+ *      and only files which still have a candidate are hashed, with the
+ *      checksums the candidates carry
+ *
+ *      entries with hashing still queued (see fp --defer-hash) or without
+ *      whole file checksums are only compared by size and extracts,
+ *      and are never taken as moved
+ */
+
+#define RECONCILE_HASH_MATCHED  0x01    // hash files matched by path even if size and extracts agree
+
+#define RECONCILE_READ_BUFFER_SIZE  65536
+
+typedef struct reconcile_stats reconcile_stats;
+
+struct reconcile_stats {
+    uint64_t same;
+    uint64_t changed;
+    uint64_t moved;
+    uint64_t new_num;
+    uint64_t missing;
+
+    uint64_t hashed;        // files read in full
+    uint64_t ignored;       // skipped by walk filter
+    uint64_t failed;        // could not be read
+};
+
+// filter may be NULL, otherwise walk_filter_begin should be called on path first
+int reconcile_tree(linked_entry* entry, const char* path, walk_filter* filter, uint32_t opts, reconcile_stats* stats, error_handle* er_h);
+
+int reconcile_cleanup();
+
+#endif
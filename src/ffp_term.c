@@ -61,9 +61,18 @@ static char cwd_backup[1024];
 static FILE* file_being_used = NULL;
 static database_handle* dh_being_used = NULL;
 static linked_entry* entry_being_used = NULL;
+static linked_entry* entry_being_filled = NULL;
+static file_data* data_being_replaced = NULL;
 static int l2_dirp_record_arr_set = 0;
 static layer2_dirp_record_arr l2_dirp_record_arr;
 static bit_index max_dirp_record_index = 0;
+static walk_filter fp_walk_filter;
+static walk_filter reconcile_walk_filter;
+// for cmp
+static linked_entry** cmp_buf = NULL;
+static size_t cmp_buf_size = 0;
+// for hashing while waiting for input
+static root_dir* hashq_root = NULL;
 
 /*  Note on locator_to_dir :
  *      locator_to_dir stays silent and leave error message reporting
@@ -270,7 +279,7 @@ int locator_to_dir(term_info* info, dir_info* dir, const char* locator_str, dir_
             }
             else if (   num_used == 1   ) {
                 strcpy(result_dir.db_name, temp_dh_find->name);
-                strcpy(result_dir.entry_id, eid_to_e_buf[0]->str);
+                bytes_to_hex_str(result_dir.entry_id, eid_to_e_buf[0]->tar->entry_id, EID_LEN);
                 result_dir.dh = temp_dh_find;
                 result_dir.entry = eid_to_e_buf[0]->tar;
                 result_dir.pointers_usable = 1;
@@ -280,7 +289,7 @@ int locator_to_dir(term_info* info, dir_info* dir, const char* locator_str, dir_
                 return FOUND_DUPLICATE;
             }
 
-            notify_ambig_resolve(str_buf + j, eid_to_e_buf[0]->str);
+            notify_ambig_resolve(str_buf + j, result_dir.entry_id);
         }
     }
     else if (IS_ENTRY_ID(locator_str)) {        // entry id path
@@ -352,6 +361,7 @@ static int parse_keyval_pair(char* str, unsigned char* has_arrow, char** key_p,
 
     if (arrow == NULL) {
         *has_arrow = 0;
+        return FFP_GENERAL_FAIL;    // neither key nor val can be told apart
     }
     else {
         *has_arrow = 1;
@@ -572,6 +582,9 @@ int process_cmd (term_info* info, char* cmd, dir_info* dir) {
         arg_str_ptr += len_read + 1;
     }
 
+    // partially hashed file is put back before command can see the database
+    hash_worker_abort();
+
     need_cleanup = 0;
 
     if (func_interruptable) {
@@ -631,6 +644,72 @@ void inthandler(int sig) {
     }
 }
 
+// run by readline while waiting for input, hashes pending files for a bounded time
+static int hashq_event_hook() {
+    database_handle* iter_dh;
+
+    int64_t start_ns;
+
+    if (fp_hash_worker.paused || !hashq_root) {
+        return 0;
+    }
+
+    start_ns = throttle_now_ns();
+
+    do {
+        iter_dh = NULL;
+
+        if (!hash_worker_busy()) {
+            for (iter_dh = hashq_root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+                if (iter_dh->pending_num > 0) {
+                    break;
+                }
+            }
+
+            if (!iter_dh) {
+                return 0;
+            }
+        }
+
+        hash_worker_step(iter_dh, HASHQ_STEP_SIZE);
+    } while (throttle_now_ns() - start_ns < HASHQ_SLICE_NS);
+
+    return 0;
+}
+
+// run by readline while waiting for input, applies file system changes seen by watch
+static int watch_event_hook() {
+    unsigned char applied;
+
+    int ret;
+
+    if (!watch_active(&fp_watch)) {
+        return 0;
+    }
+
+    ret = watch_poll(&fp_watch, 0, &applied);
+    if (ret == WATCH_ROOT_GONE) {
+        printf("\nwatch : watched directory or its entry is gone, stopped watching\n");
+    }
+    else if (ret) {
+        printf("\nwatch : failed to apply changes, error code : %d\n", ret);
+    }
+    else {
+        return 0;
+    }
+
+    rl_on_new_line();
+    rl_redisplay();
+
+    return 0;
+}
+
+static int idle_event_hook() {
+    watch_event_hook();
+
+    return hashq_event_hook();
+}
+
 int prompt (term_info* info, dir_info* dir) {    // should have size COMMAND_BUFFER_SIZE
     int i, ret = 0;
 
@@ -647,6 +726,12 @@ int prompt (term_info* info, dir_info* dir) {    // should have size COMMAND_BUF
         l2_dirp_record_arr_set = 1;
     }
 
+    if (!rl_event_hook) {
+        rl_event_hook = idle_event_hook;
+        rl_set_keyboard_input_timeout(HASHQ_TICK_US);
+    }
+    hashq_root = dir->root;
+
     i = setjmp(prompt_func);
     if (i == 0) {
         prompt_func_jmp_set = 1;
@@ -764,9 +849,19 @@ int init_func_arr (term_info* info) {
     add_func(info, "attach",    &attach,    NOT_INTERRUPTABLE,  NULL);
     add_func(info, "detach",    &detach,    NOT_INTERRUPTABLE,  NULL);
 
+    add_func(info, "find",      &find,      NOT_INTERRUPTABLE,  NULL);
+    add_func(info, "cmp",       &cmp,           INTERRUPTABLE,  &cmp_cleanup);
+    add_func(info, "similar",   &similar,   NOT_INTERRUPTABLE,  NULL);
+    add_func(info, "reconcile", &reconcile,     INTERRUPTABLE,  &reconcile_cleanup);
+
     add_func(info, "exit",      &ffp_exit,  NOT_INTERRUPTABLE,  NULL);
 
     add_func(info, "fp",        &fp,            INTERRUPTABLE,  &fp_cleanup);
+    add_func(info, "throttle",  &throttle,  NOT_INTERRUPTABLE,  NULL);
+    add_func(info, "hashbackend", &hashbackend, NOT_INTERRUPTABLE, NULL);
+    add_func(info, "hcache",    &hcache,    NOT_INTERRUPTABLE,  NULL);
+    add_func(info, "hashq",     &hashq,         INTERRUPTABLE,  &hashq_cleanup);
+    add_func(info, "watch",     &watch,     NOT_INTERRUPTABLE,  NULL);
 
     add_func(info, "fpwd",      &fpwd,          INTERRUPTABLE,  NULL);
     add_func(info, "fls",       &fls,           INTERRUPTABLE,  &fls_cleanup);
@@ -883,7 +978,9 @@ int ls(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     int arg_count = 0;
 
-    char* str;
+    const char* str;
+
+    char eid_str[EID_STR_MAX+1];
 
     error_handle er_h;
 
@@ -891,6 +988,10 @@ int ls(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     database_handle* iter_dh, * iter_dh_temp;
 
+    linked_entry* page_buf[LS_PAGE_SIZE];
+    ffp_eid_int page_start;
+    bit_index page_num, k;
+
     error_mark_inactive(&er_h);
     error_mark_owner(&er_h, "ls");
 
@@ -975,21 +1076,23 @@ print_result_dir:
                                     &&  temp_entry_find->parent->type == ENTRY_FILE
                                )
                             {
+                                bytes_to_hex_str(eid_str, temp_entry_find->entry_id, EID_LEN);
                                 printf(
                                         "%s%.*s    id : %s    type : file (a version of parent file)\n",
                                         str,
                                         calc_pad(str, PRINT_PAD_SIZE),
                                         space_pad,
-                                        temp_entry_find->entry_id_str
+                                        eid_str
                                       );
                             }
                             else {
+                                bytes_to_hex_str(eid_str, temp_entry_find->entry_id, EID_LEN);
                                 printf(
                                         "%s%.*s    id : %s    type : file\n",
                                         str,
                                         calc_pad(str, PRINT_PAD_SIZE),
                                         space_pad,
-                                        temp_entry_find->entry_id_str
+                                        eid_str
                                       );
                             }
                         }
@@ -998,34 +1101,48 @@ print_result_dir:
                         }
                     }
                     else {
-                        for (j = 0; j < temp_entry_find->child_num; j++) {
-                            temp_entry = temp_entry_find->child[j];
-                            if (opt_flag[LS_OPT_l]) {
-                                str = temp_entry->file_name;
-                                printf(
-                                        "%s%.*s    id : %s    type : file (a version of parent file)\n",
-                                        str,
-                                        calc_pad(str, PRINT_PAD_SIZE),
-                                        space_pad,
-                                        temp_entry->entry_id_str
-                                      );
+                        // list children sorted by name, a page at a time
+                        page_start = 0;
+                        do {
+                            ret = get_sorted_children(temp_entry_find, page_start, page_buf, LS_PAGE_SIZE, &page_num);
+                            if (ret && ret != BUFFER_FULL) {
+                                printf("ls : failed to sort children\n");
+                                return ret;
                             }
-                            else {
-                                printf("%s\n", temp_entry->file_name);
+
+                            for (k = 0; k < page_num; k++) {
+                                temp_entry = page_buf[k];
+                                if (opt_flag[LS_OPT_l]) {
+                                    str = temp_entry->file_name;
+                                    bytes_to_hex_str(eid_str, temp_entry->entry_id, EID_LEN);
+                                    printf(
+                                            "%s%.*s    id : %s    type : file (a version of parent file)\n",
+                                            str,
+                                            calc_pad(str, PRINT_PAD_SIZE),
+                                            space_pad,
+                                            eid_str
+                                          );
+                                }
+                                else {
+                                    printf("%s\n", temp_entry->file_name);
+                                }
                             }
-                        }
+
+                            page_start += page_num;
+                        } while (ret == BUFFER_FULL);
                     }
                 }
                 else if (temp_entry_find->type == ENTRY_GROUP) {
                     if (opt_flag[LS_OPT_d]) {
                         if (opt_flag[LS_OPT_l]) {
                             str = temp_entry_find->file_name;
+                            bytes_to_hex_str(eid_str, temp_entry_find->entry_id, EID_LEN);
                             printf(
                                     "%s%.*s    id : %s    type : group\n",
                                     str,
                                     calc_pad(str, PRINT_PAD_SIZE),
                                     space_pad,
-                                    temp_entry_find->entry_id_str
+                                    eid_str
                                   );
                         }
                         else {
@@ -1033,33 +1150,47 @@ print_result_dir:
                         }
                     }
                     else {
-                        for (j = 0; j < temp_entry_find->child_num; j++) {
-                            temp_entry = temp_entry_find->child[j];
-                            if (opt_flag[LS_OPT_l]) {
-                                str = temp_entry->file_name;
-                                if (temp_entry->type == ENTRY_FILE) {
-                                    printf(
-                                            "%s%.*s    id : %s    type : file\n",
-                                            str,
-                                            calc_pad(str, PRINT_PAD_SIZE),
-                                            space_pad,
-                                            temp_entry->entry_id_str
-                                          );
+                        // list children sorted by name, a page at a time
+                        page_start = 0;
+                        do {
+                            ret = get_sorted_children(temp_entry_find, page_start, page_buf, LS_PAGE_SIZE, &page_num);
+                            if (ret && ret != BUFFER_FULL) {
+                                printf("ls : failed to sort children\n");
+                                return ret;
+                            }
+
+                            for (k = 0; k < page_num; k++) {
+                                temp_entry = page_buf[k];
+                                if (opt_flag[LS_OPT_l]) {
+                                    str = temp_entry->file_name;
+                                    if (temp_entry->type == ENTRY_FILE) {
+                                        bytes_to_hex_str(eid_str, temp_entry->entry_id, EID_LEN);
+                                        printf(
+                                                "%s%.*s    id : %s    type : file\n",
+                                                str,
+                                                calc_pad(str, PRINT_PAD_SIZE),
+                                                space_pad,
+                                                eid_str
+                                              );
+                                    }
+                                    else if (temp_entry->type == ENTRY_GROUP) {
+                                        bytes_to_hex_str(eid_str, temp_entry->entry_id, EID_LEN);
+                                        printf(
+                                                "%s%.*s    id : %s    type : group\n",
+                                                str,
+                                                calc_pad(str, PRINT_PAD_SIZE),
+                                                space_pad,
+                                                eid_str
+                                              );
+                                    }
                                 }
-                                else if (temp_entry->type == ENTRY_GROUP) {
-                                    printf(
-                                            "%s%.*s    id : %s    type : group\n",
-                                            str,
-                                            calc_pad(str, PRINT_PAD_SIZE),
-                                            space_pad,
-                                            temp_entry->entry_id_str
-                                          );
+                                else {
+                                    printf("%s\n", temp_entry->file_name);
                                 }
                             }
-                            else {
-                                printf("%s\n", temp_entry->file_name);
-                            }
-                        }
+
+                            page_start += page_num;
+                        } while (ret == BUFFER_FULL);
                     }
                 }
             }
@@ -1817,6 +1948,11 @@ int unloaddb(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     strcpy(name, result_dir.dh->name);
 
+    if (watch_active(&fp_watch) && fp_watch.dh == result_dir.dh) {
+        watch_stop(&fp_watch);
+        printf("unloaddb : stopped watching %s\n", name);
+    }
+
     ret = del_dh_from_root_dir(dir->root, result_dir.dh->name, &er_h);
     if (ret) {
         error_print_owner_msg(&er_h);
@@ -1850,7 +1986,6 @@ static int make_entry(term_info* info, dir_info* dir, int argc, char* argv[], un
     int number_of_tries = 0;
 
     time_t raw_time;
-    struct tm* time_info;
 
     unsigned char eid[EID_LEN];
     char eid_str[EID_STR_MAX+1];
@@ -1972,6 +2107,15 @@ static int make_entry(term_info* info, dir_info* dir, int argc, char* argv[], un
         printf("%s : failed to get space for entry\n", name);
         return ret;
     }
+    init_entry_strs(temp_entry);
+
+    // fill in file name and length
+    ret = set_entry_file_name(tar_dh, temp_entry, file_name);
+    if (ret) {
+        printf("%s : failed to allocate memory for file name\n", name);
+        del_entry_from_layer2_arr(&tar_dh->l2_entry_arr, temp_entry->obj_arr_index);
+        return ret;
+    }
 
     // set type
     if (mode == MAKE_MODE_TOUCH) {
@@ -1991,11 +2135,6 @@ static int make_entry(term_info* info, dir_info* dir, int argc, char* argv[], un
     for (i = 0; i < EID_LEN; i++) {
         temp_entry->entry_id[i] = eid[i];
     }
-    strcpy(temp_entry->entry_id_str, eid_str);
-
-    // fill in file name and length
-    strcpy(temp_entry->file_name, file_name);
-    temp_entry->file_name_len = strlen(file_name);
 
     // put into parent as a new child
     put_into_children_array(tar_entry, temp_entry);
@@ -2014,14 +2153,12 @@ static int make_entry(term_info* info, dir_info* dir, int argc, char* argv[], un
         for (i = 0; i < EID_LEN; i++) {
             temp_entry->branch_id[i] = temp_entry->parent->branch_id[i];
         }
-        strcpy(temp_entry->branch_id_str, temp_entry->parent->branch_id_str);
     }
     else {
         // fill in branch id using entry id
         for (i = 0; i < EID_LEN; i++) {
             temp_entry->branch_id[i] = temp_entry->entry_id[i];
         }
-        strcpy(temp_entry->branch_id_str, temp_entry->entry_id_str);
     }
 
     link_entry_to_file_name_structures(tar_dh, temp_entry);
@@ -2030,28 +2167,19 @@ static int make_entry(term_info* info, dir_info* dir, int argc, char* argv[], un
 
     // get current time
     time(&raw_time);
-    time_info = gmtime(&raw_time);
 
     // fill in time of addition
-    memcpy(
-            &temp_entry->tod_utc,
-            time_info,
-
-            sizeof(struct tm)
-          );
+    temp_entry->tod_utc = raw_time;
 
     link_entry_to_date_time_tree(tar_dh, temp_entry, DATE_TOD);
 
     // fill in time of modification
-    memcpy(
-            &temp_entry->tom_utc,
-            time_info,
-
-            sizeof(struct tm)
-          );
+    temp_entry->tom_utc = raw_time;
 
     link_entry_to_date_time_tree(tar_dh, temp_entry, DATE_TOM);
 
+    tree_digest_update(temp_entry, 0);
+
     MARK_DB_UNSAVED(tar_dh);
 
     ret = verify_entry(tar_dh, temp_entry, 0x0);
@@ -2106,14 +2234,16 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
     database_handle* tar_dh;
     linked_entry* tar_entry;
     file_data* tar_file_data;
-    section* tar_section;
+    uint64_t tar_sect_index = 0;
+    uint64_t temp_start_pos;
+    uint64_t temp_end_pos;
+    checksum_result temp_checksum;
 
-    time_t raw_time_local;
     struct tm local_time;
-    struct tm* utc_time_p;
 
     time_t raw_time;
-    struct tm* time_info;
+
+    char tag_buf[2 * TAG_STR_MAX + 1];
 
     error_handle er_h;
 
@@ -2208,7 +2338,7 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
             return WRONG_ARGS;
         }
 
-        tar_section = tar_file_data->section[sect_num];
+        tar_sect_index = sect_num;
 
         cur_index++;
     }
@@ -2612,10 +2742,7 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 }
                 else if (   strcmp(key, "sha1")     == 0) {
                     if (modify_flag == MODIFY_APPEND_MODE) {
-                        if (        tar_section->checksum[CHECKSUM_SHA1_INDEX].type
-                                !=  CHECKSUM_UNUSED
-                           )
-                        {
+                        if (sect_has_checksum(tar_file_data, tar_sect_index, CHECKSUM_SHA1_INDEX)) {
                             printf("edit : append error : section sha1 checksum already recorded\n");
                             return WRONG_ARGS;
                         }
@@ -2639,10 +2766,7 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 }
                 else if (   strcmp(key, "sha256")   == 0) {
                     if (modify_flag == MODIFY_APPEND_MODE) {
-                        if (        tar_section->checksum[CHECKSUM_SHA256_INDEX].type
-                                !=  CHECKSUM_UNUSED
-                           )
-                        {
+                        if (sect_has_checksum(tar_file_data, tar_sect_index, CHECKSUM_SHA256_INDEX)) {
                             printf("edit : append error : section sha256 checksum already recorded\n");
                             return WRONG_ARGS;
                         }
@@ -2666,10 +2790,7 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 }
                 else if (   strcmp(key, "sha512")   == 0) {
                     if (modify_flag == MODIFY_APPEND_MODE) {
-                        if (        tar_section->checksum[CHECKSUM_SHA512_INDEX].type
-                                !=  CHECKSUM_UNUSED
-                           )
-                        {
+                        if (sect_has_checksum(tar_file_data, tar_sect_index, CHECKSUM_SHA512_INDEX)) {
                             printf("edit : append error : section sha512 checksum already recorded\n");
                             return WRONG_ARGS;
                         }
@@ -2713,18 +2834,19 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
         switch (mode) {
             case UPDATE_ENTRY_MODE :
                 if (        strcmp(key, "name")     == 0) {
-                    // unlink from same file name double linked list
-                    del_e_from_fn_to_e_chain
+                    // unlink from entries with same file name
+                    del_e_from_fn_to_e_postings
                         (
                          &tar_dh->fn_to_e,
-                         &tar_dh->fn_mat,
+                         &tar_dh->fn_gram,
                          &tar_dh->l2_fn_to_e_arr,
                          tar_entry
                         );
 
-                    // update file name
-                    strcpy(tar_entry->file_name, val);
-                    tar_entry->file_name_len = strlen(val);
+                    // update file name, old name is kept on failure
+                    if (set_entry_file_name(tar_dh, tar_entry, val)) {
+                        printf("edit : failed to update file name\n");
+                    }
 
                     // link back to same file name related structures
                     link_entry_to_file_name_structures(tar_dh, tar_entry);
@@ -2736,7 +2858,9 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     }
 
                     // update time of addition
-                    strptime(val, time_format, &tar_entry->tod_utc);
+                    mem_wipe_sec(&temp_time, sizeof(struct tm));
+                    strptime(val, time_format, &temp_time);
+                    tar_entry->tod_utc = utc_tm_to_epoch(&temp_time);
 
                     // link back to time of addition tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TOD);
@@ -2750,16 +2874,8 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     // parse local time of addition
                     strptime(val, time_format, &local_time);
 
-                    // convert from local time to utc
-                    raw_time_local = mktime(&local_time);
-
-                    utc_time_p = gmtime(&raw_time_local);
-                    memcpy(
-                            &tar_entry->tod_utc,
-                            utc_time_p,
-
-                            sizeof(struct tm)
-                          );
+                    // convert from local time to seconds since epoch
+                    tar_entry->tod_utc = mktime(&local_time);
 
                     // link back to time of addition tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TOD);
@@ -2771,7 +2887,9 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     }
 
                     // update time of modification
-                    strptime(val, time_format, &tar_entry->tom_utc);
+                    mem_wipe_sec(&temp_time, sizeof(struct tm));
+                    strptime(val, time_format, &temp_time);
+                    tar_entry->tom_utc = utc_tm_to_epoch(&temp_time);
 
                     // link back to time of modification tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TOM);
@@ -2785,16 +2903,8 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     // parse local time of modification
                     strptime(val, time_format, &local_time);
 
-                    // convert from local time to utc
-                    raw_time_local = mktime(&local_time);
-
-                    utc_time_p = gmtime(&raw_time_local);
-                    memcpy(
-                            &tar_entry->tom_utc,
-                            utc_time_p,
-
-                            sizeof(struct tm)
-                          );
+                    // convert from local time to seconds since epoch
+                    tar_entry->tom_utc = mktime(&local_time);
 
                     // link back to time of modification tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TOM);
@@ -2806,7 +2916,9 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     }
 
                     // update user specified time
-                    strptime(val, time_format, &tar_entry->tusr_utc);
+                    mem_wipe_sec(&temp_time, sizeof(struct tm));
+                    strptime(val, time_format, &temp_time);
+                    tar_entry->tusr_utc = utc_tm_to_epoch(&temp_time);
 
                     // link back to user specified time tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TUSR);
@@ -2820,16 +2932,8 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     // parse local user specified time
                     strptime(val, time_format, &local_time);
 
-                    // convert from local time to utc
-                    raw_time_local = mktime(&local_time);
-
-                    utc_time_p = gmtime(&raw_time_local);
-                    memcpy(
-                            &tar_entry->tusr_utc,
-                            utc_time_p,
-
-                            sizeof(struct tm)
-                          );
+                    // convert from local time to seconds since epoch
+                    tar_entry->tusr_utc = mktime(&local_time);
 
                     // link back to user specified time tree
                     link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TUSR);
@@ -2851,12 +2955,12 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     }
                 }
                 else if (   strcmp(key, "tag")      == 0) {
-                    // unlink from same tag double linked list
+                    // unlink from entries with same tag
                     if (tar_entry->tag_to_e) {  // if previously linked
-                        del_e_from_tag_to_e_chain
+                        del_e_from_tag_to_e_postings
                             (
                              &tar_dh->tag_to_e,
-                             &tar_dh->tag_mat,
+                             &tar_dh->tag_gram,
                              &tar_dh->l2_tag_to_e_arr,
                              tar_entry
                             );
@@ -2864,32 +2968,37 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
                     // update tag string
                     if (modify_flag == MODIFY_WRITE_MODE) {
-                        strcpy(tar_entry->tag_str, val);
-                        tar_entry->tag_str_len = strlen(val);
+                        ret = set_entry_tag_str(tar_dh, tar_entry, val);
                     }
                     else if (modify_flag == MODIFY_APPEND_MODE) {
+                        // existing tags end with the bar new tags start with
                         str_len = tar_entry->tag_str_len;
-                        strcpy(tar_entry->tag_str + str_len - 1, val);
-                        tar_entry->tag_str_len = strlen(tar_entry->tag_str);
+                        strcpy(tag_buf, tar_entry->tag_str);
+                        strcpy(tag_buf + (str_len > 0 ? str_len - 1 : 0), val);
+                        ret = set_entry_tag_str(tar_dh, tar_entry, tag_buf);
+                    }
+                    if (ret) {
+                        printf("edit : failed to update tag string\n");
                     }
 
-                    // link back to same tag double linked list
+                    // link back to entries with same tag
                     link_entry_to_tag_str_structures(tar_dh, tar_entry);
                 }
                 else if (   strcmp(key, "msg")      == 0) {
                     // update user message
-                    strcpy(tar_entry->user_msg, val);
-                    tar_entry->user_msg_len = strlen(val);
+                    if (set_entry_user_msg(tar_entry, val)) {
+                        printf("edit : failed to update user message\n");
+                    }
                 }
                 break;
             case UPDATE_FILE_MODE :
                 if (        strcmp(key, "size")     == 0) {
                     // unlink from file size structures
                     if (tar_file_data->f_size_to_fd) {
-                        del_fd_from_f_size_to_fd_chain
+                        del_fd_from_f_size_to_fd_postings
                             (
                              &tar_dh->f_size_to_fd,
-                             &tar_dh->f_size_mat,
+                             &tar_dh->f_size_gram,
                              &tar_dh->l2_f_size_to_fd_arr,
                              tar_file_data
                             );
@@ -2900,15 +3009,20 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     sprintf(tar_file_data->file_size_str, "%"PRIu64"", tar_file_data->file_size);
 
                     // link back to file size structures
-                    link_file_data_to_file_size_structures(tar_dh, tar_file_data);
+                    if (link_file_data_to_file_size_structures(tar_dh, tar_file_data)) {
+                        printf("edit : failed to link file data via file size\n");
+                    }
+
+                    // extracts are keyed by size as well
+                    link_file_data_to_extract_index(tar_dh, tar_file_data);
                 }
                 else if (   strcmp(key, "sha1")     == 0) {
                     // unlink from sha1 structures
                     if (tar_file_data->sha1f_to_fd) {
-                        del_fd_from_sha1f_to_fd_chain
+                        del_fd_from_sha1f_to_fd_postings
                             (
                              &tar_dh->sha1f_to_fd,
-                             &tar_dh->sha1f_mat,
+                             &tar_dh->sha1f_digest,
                              &tar_dh->l2_sha1f_to_fd_arr,
                              tar_file_data
                             );
@@ -2932,10 +3046,10 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 else if (   strcmp(key, "sha256")   == 0) {
                     // unlink from sha256 structures
                     if (tar_file_data->sha256f_to_fd) {
-                        del_fd_from_sha256f_to_fd_chain
+                        del_fd_from_sha256f_to_fd_postings
                             (
                              &tar_dh->sha256f_to_fd,
-                             &tar_dh->sha256f_mat,
+                             &tar_dh->sha256f_digest,
                              &tar_dh->l2_sha256f_to_fd_arr,
                              tar_file_data
                             );
@@ -2959,10 +3073,10 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 else if (   strcmp(key, "sha512")   == 0) {
                     // unlink from sha512 structures
                     if (tar_file_data->sha512f_to_fd) {
-                        del_fd_from_sha512f_to_fd_chain
+                        del_fd_from_sha512f_to_fd_postings
                             (
                              &tar_dh->sha512f_to_fd,
-                             &tar_dh->sha512f_mat,
+                             &tar_dh->sha512f_digest,
                              &tar_dh->l2_sha512f_to_fd_arr,
                              tar_file_data
                             );
@@ -2986,93 +3100,88 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 break;
             case UPDATE_SECT_MODE :
                 if (        strcmp(key, "startpos") == 0) {
-                    // update start position
-                    sscanf(val, "%"PRIu64"", &tar_section->start_pos);
+                    // update start position, positions are stored from now on if they differ from derived ones
+                    get_sect_pos(tar_file_data, tar_sect_index, &temp_start_pos, &temp_end_pos);
+                    sscanf(val, "%"PRIu64"", &temp_start_pos);
+                    set_sect_pos(tar_file_data, tar_sect_index, temp_start_pos, temp_end_pos);
                 }
                 else if (   strcmp(key, "endpos")   == 0) {
                     // update end position
-                    sscanf(val, "%"PRIu64"", &tar_section->end_pos);
+                    get_sect_pos(tar_file_data, tar_sect_index, &temp_start_pos, &temp_end_pos);
+                    sscanf(val, "%"PRIu64"", &temp_end_pos);
+                    set_sect_pos(tar_file_data, tar_sect_index, temp_start_pos, temp_end_pos);
                 }
                 else if (   strcmp(key, "sha1")     == 0) {
                     // unlink from sha1 structures
-                    if (tar_section->sha1s_to_s) {
-                        del_s_from_sha1s_to_s_chain
-                            (
-                             &tar_dh->sha1s_to_s,
-                             &tar_dh->sha1s_mat,
-                             &tar_dh->l2_sha1s_to_s_arr,
-                             tar_section
-                            );
-                    }
-
-                    // update sha1 checksum
-                    strcpy
+                    del_s_from_sha1s_to_s_postings
                         (
-                         tar_section->checksum[CHECKSUM_SHA1_INDEX].checksum_str,
-                         val
+                         &tar_dh->sha1s_to_s,
+                         &tar_dh->sha1s_digest,
+                         &tar_dh->l2_sha1s_to_s_arr,
+                         tar_file_data,
+                         tar_sect_index
                         );
+
+                    // update sha1 checksum
+                    temp_checksum.type = CHECKSUM_SHA1_ID;
+                    temp_checksum.len = SHA_DIGEST_LENGTH;
                     hex_str_to_bytes
                         (
-                         tar_section->checksum[CHECKSUM_SHA1_INDEX].checksum,
+                         temp_checksum.checksum,
                          val
                         );
+                    set_sect_checksum(tar_file_data, tar_sect_index, &temp_checksum);
 
-                    // link file data back to sha1 structures
-                    link_sect_to_sha1_structures(tar_dh, tar_section, tar_section->checksum + CHECKSUM_SHA1_INDEX);
+                    // link section back to sha1 structures
+                    link_sect_to_sha1_structures(tar_dh, tar_file_data, tar_sect_index);
                 }
                 else if (   strcmp(key, "sha256")   == 0) {
                     // unlink from sha256 structures
-                    if (tar_section->sha256s_to_s) {
-                        del_s_from_sha256s_to_s_chain
-                            (
-                             &tar_dh->sha256s_to_s,
-                             &tar_dh->sha256s_mat,
-                             &tar_dh->l2_sha256s_to_s_arr,
-                             tar_section
-                            );
-                    }
-
-                    // update sha256 checksum
-                    strcpy
+                    del_s_from_sha256s_to_s_postings
                         (
-                         tar_section->checksum[CHECKSUM_SHA256_INDEX].checksum_str,
-                         val
+                         &tar_dh->sha256s_to_s,
+                         &tar_dh->sha256s_digest,
+                         &tar_dh->l2_sha256s_to_s_arr,
+                         tar_file_data,
+                         tar_sect_index
                         );
+
+                    // update sha256 checksum
+                    temp_checksum.type = CHECKSUM_SHA256_ID;
+                    temp_checksum.len = SHA256_DIGEST_LENGTH;
                     hex_str_to_bytes
                         (
-                         tar_section->checksum[CHECKSUM_SHA256_INDEX].checksum,
+                         temp_checksum.checksum,
                          val
                         );
+                    set_sect_checksum(tar_file_data, tar_sect_index, &temp_checksum);
 
-                    // link file data back to sha256 structures
-                    link_sect_to_sha256_structures(tar_dh, tar_section, tar_section->checksum + CHECKSUM_SHA256_INDEX);
+                    // link section back to sha256 structures
+                    link_sect_to_sha256_structures(tar_dh, tar_file_data, tar_sect_index);
                 }
                 else if (   strcmp(key, "sha512")   == 0) {
                     // unlink from sha512 structures
-                    if (tar_section->sha512s_to_s) {
-                        del_s_from_sha512s_to_s_chain
-                            (
-                             &tar_dh->sha512s_to_s,
-                             &tar_dh->sha512s_mat,
-                             &tar_dh->l2_sha512s_to_s_arr,
-                             tar_section
-                            );
-                    }
-
-                    // update sha512 checksum
-                    strcpy
+                    del_s_from_sha512s_to_s_postings
                         (
-                         tar_section->checksum[CHECKSUM_SHA512_INDEX].checksum_str,
-                         val
+                         &tar_dh->sha512s_to_s,
+                         &tar_dh->sha512s_digest,
+                         &tar_dh->l2_sha512s_to_s_arr,
+                         tar_file_data,
+                         tar_sect_index
                         );
+
+                    // update sha512 checksum
+                    temp_checksum.type = CHECKSUM_SHA512_ID;
+                    temp_checksum.len = SHA512_DIGEST_LENGTH;
                     hex_str_to_bytes
                         (
-                         tar_section->checksum[CHECKSUM_SHA512_INDEX].checksum,
+                         temp_checksum.checksum,
                          val
                         );
+                    set_sect_checksum(tar_file_data, tar_sect_index, &temp_checksum);
 
-                    // link file data back to sha512 structures
-                    link_sect_to_sha512_structures(tar_dh, tar_section, tar_section->checksum + CHECKSUM_SHA512_INDEX);
+                    // link section back to sha512 structures
+                    link_sect_to_sha512_structures(tar_dh, tar_file_data, tar_sect_index);
                 }
                 break;
         }
@@ -3087,18 +3196,15 @@ int edit(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
         // get current time
         time(&raw_time);
-        time_info = gmtime(&raw_time);
-        memcpy(
-                &tar_entry->tom_utc,
-                time_info,
-
-                sizeof(struct tm)
-              );
+        tar_entry->tom_utc = raw_time;
 
         // link back to time of modification tree
         link_entry_to_date_time_tree(tar_dh, tar_entry, DATE_TOM);
     }
 
+    // name or file checksums may have changed
+    tree_digest_update(tar_entry, 0);
+
     // verify entry
     ret = verify_entry(tar_dh, tar_entry, 0x0);
     if (ret) {
@@ -3112,6 +3218,7 @@ static int verify_recursive(database_handle* dh, linked_entry* entry, ffp_eid_in
     ffp_eid_int i;
     int ret;
     linked_entry* temp;
+    char eid_str[EID_STR_MAX+1];
 
     if (rem_depth && *rem_depth == 0) {
         return 0;
@@ -3123,14 +3230,16 @@ static int verify_recursive(database_handle* dh, linked_entry* entry, ffp_eid_in
 
     ret = verify_entry(dh, entry, 0x0);
     if (ret) {
-        printf("entry failed verification ^ : %s\n", entry->entry_id_str);
+        bytes_to_hex_str(eid_str, entry->entry_id, EID_LEN);
+        printf("entry failed verification ^ : %s\n", eid_str);
     }
 
     temp = entry;
     while (temp->child_num == 1) {
         ret = verify_entry(dh, temp, 0x0);
         if (ret) {
-            printf("entry failed verification ^ : %s\n", temp->entry_id_str);
+            bytes_to_hex_str(eid_str, temp->entry_id, EID_LEN);
+            printf("entry failed verification ^ : %s\n", eid_str);
         }
 
         temp = temp->child[0];
@@ -3212,8 +3321,6 @@ int attach(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     char* str;
 
-    uint64_t i;
-
     uint64_t sect_num;
 
     int ret;
@@ -3221,7 +3328,6 @@ int attach(term_info* info, dir_info* dir, int argc, char* argv[]) {
     int cur_index;
 
     file_data* temp_file_data;
-    section* temp_section;
 
     error_handle er_h;
 
@@ -3273,6 +3379,8 @@ int attach(term_info* info, dir_info* dir, int argc, char* argv[]) {
         }
 
         entry->data = temp_file_data;
+
+        tree_digest_update(entry, 0);
     }
     else if (   strcmp(str, "sect")     == 0) {
         if (argc > 3) {
@@ -3296,16 +3404,14 @@ int attach(term_info* info, dir_info* dir, int argc, char* argv[]) {
             return WRONG_ARGS;
         }
 
-        // make space for sections
-        grow_section_array(temp_file_data, sect_num);
-        for (i = 0; i < sect_num; i++) {
-            ret = add_section_to_layer2_arr(&dh->l2_section_arr, &temp_section, NULL);
-            if (ret) {
-                printf("attach : failed to get space for section\n");
-                return ret;
-            }
-
-            put_into_section_array(temp_file_data, temp_section);
+        // attached sections have no layout, so all positions are stored
+        ret = make_sect_noncontinuous(temp_file_data);
+        if (!ret) {
+            ret = append_sections(temp_file_data, sect_num);
+        }
+        if (ret) {
+            printf("attach : failed to get space for section\n");
+            return ret;
         }
     }
     else {
@@ -3322,9 +3428,6 @@ int detach(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     char* str;
 
-    bit_index bit_count;
-    bit_index map_indx;
-    bit_index skip_to_bit;
     str_len_int i, j;
     str_len_int str_len;
 
@@ -3333,15 +3436,13 @@ int detach(term_info* info, dir_info* dir, int argc, char* argv[]) {
 
     uint64_t sect_num, sect_num2;
     uint64_t sect_start_indx, sect_end_indx; // sect_end_indx is inclusive
-    uint64_t sect_indx, sect_indx2;
-    uint64_t sect_fill_indx;
+    uint64_t sect_indx;
 
     int ret;
 
     int cur_index;
 
     file_data* temp_file_data;
-    section* temp_section;
 
     error_handle er_h;
 
@@ -3388,6 +3489,8 @@ int detach(term_info* info, dir_info* dir, int argc, char* argv[]) {
         del_file_data(dh, entry->data);
 
         entry->data = NULL;
+
+        tree_digest_update(entry, 0);
     }
     else if (   strcmp(str, "sect")     == 0) {
         if (argc > 3) {
@@ -3483,59 +3586,12 @@ int detach(term_info* info, dir_info* dir, int argc, char* argv[]) {
             i = j;      // skip processed substring
         }
 
-        // go through bitmap
-        for (   bit_count = 0, skip_to_bit = 0;
-                bit_count < info->map_buf.number_of_ones;
-                bit_count++
-            )
-        {
-            bitmap_first_one_bit_index(&info->map_buf, &map_indx, skip_to_bit);
-            skip_to_bit = map_indx + 1;
-
-            // delete section
-            del_section(dh, temp_file_data->section[map_indx]);
-
-            temp_file_data->section[map_indx] = NULL;
-        }
-
-        // collapse the section array by moving all remaining sections to start
-        // and update the section_num and section_free_num
-        sect_fill_indx = 0;
-        for (sect_indx = 0; sect_indx < temp_file_data->section_num; sect_indx++) {
-            temp_section = temp_file_data->section[sect_indx];
-            if (!temp_section) {    // empty slot
-                sect_fill_indx = sect_indx;
-
-                // skip over empty slots
-                for (   sect_indx2 = sect_indx;
-                        sect_indx2 < temp_file_data->section_num;
-                        sect_indx2++
-                    )
-                {
-                    if (temp_file_data->section[sect_indx2]) {
-                        break;
-                    }
-                }
-
-                sect_indx = sect_indx2 - 1;
-            }
-            else {
-                if (sect_fill_indx == sect_indx) {
-                    ;;  // do nothing
-                }
-                else {
-                    temp_file_data
-                    ->section[sect_fill_indx] = temp_file_data->section[sect_indx];
-
-                    temp_file_data->section[sect_indx] = NULL;
-                }
-
-                sect_fill_indx++;
-            }
+        // delete marked sections, remaining ones are moved to start
+        ret = del_sections(dh, temp_file_data, &info->map_buf);
+        if (ret) {
+            printf("detach : failed to delete sections\n");
+            return ret;
         }
-
-        temp_file_data->section_num       -= info->map_buf.number_of_ones;
-        temp_file_data->section_free_num  += info->map_buf.number_of_ones;
     }
     else {
         printf("detach : unknown component\n");
@@ -3548,17 +3604,23 @@ int detach(term_info* info, dir_info* dir, int argc, char* argv[]) {
 static void print_entry_eid(linked_entry* entry) {
     char msg[] = "entry id";
 
-    printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, entry->entry_id_str);
+    char eid_str[EID_STR_MAX+1];
+
+    bytes_to_hex_str(eid_str, entry->entry_id, EID_LEN);
+    printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, eid_str);
 }
 
 static void print_entry_bid(linked_entry* entry) {
     char msg[] = "branch id";
+    char bid_str[EID_STR_MAX+1];
+
+    bytes_to_hex_str(bid_str, entry->branch_id, EID_LEN);
 
     if (!entry->has_parent) {   // head of branch
-        printf("%s%.*s : %s  (head)\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, entry->branch_id_str);
+        printf("%s%.*s : %s  (head)\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, bid_str);
     }
     else {  // other entries
-        printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, entry->branch_id_str);
+        printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, bid_str);
     }
 }
 
@@ -3572,6 +3634,7 @@ static void print_entry_date(linked_entry* entry) {
     time_t raw_time_utc;
     struct tm* local_time_p;
     struct tm local_time;
+    struct tm utc_time;
 
     const char time_format[] = "%Y-%m-%d %H:%M:%S";
 
@@ -3579,11 +3642,12 @@ static void print_entry_date(linked_entry* entry) {
     char msg[100];
 
     if (entry->tod_utc_used) {
-        strftime(buf, 100, time_format, &entry->tod_utc);
+        epoch_to_utc_tm(entry->tod_utc, &utc_time);
+        strftime(buf, 100, time_format, &utc_time);
         strcpy(msg, "time of addition UTC");
         printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, buf);
 
-        raw_time_utc = timegm(&entry->tod_utc);
+        raw_time_utc = entry->tod_utc;
 
         local_time_p = localtime(&raw_time_utc);
         memcpy(
@@ -3602,11 +3666,12 @@ static void print_entry_date(linked_entry* entry) {
     }
 
     if (entry->tom_utc_used) {
-        strftime(buf, 100, time_format, &entry->tom_utc);
+        epoch_to_utc_tm(entry->tom_utc, &utc_time);
+        strftime(buf, 100, time_format, &utc_time);
         strcpy(msg, "time of modification UTC");
         printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, buf);
 
-        raw_time_utc = timegm(&entry->tom_utc);
+        raw_time_utc = entry->tom_utc;
 
         local_time_p = localtime(&raw_time_utc);
         memcpy(
@@ -3625,11 +3690,12 @@ static void print_entry_date(linked_entry* entry) {
     }
 
     if (entry->tusr_utc_used) {
-        strftime(buf, 100, time_format, &entry->tusr_utc);
+        epoch_to_utc_tm(entry->tusr_utc, &utc_time);
+        strftime(buf, 100, time_format, &utc_time);
         strcpy(msg, "user specified time UTC");
         printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, buf);
 
-        raw_time_utc = timegm(&entry->tusr_utc);
+        raw_time_utc = entry->tusr_utc;
 
         local_time_p = localtime(&raw_time_utc);
         memcpy(
@@ -3682,7 +3748,7 @@ static void print_entry_created_by(linked_entry* entry) {
 
 static void print_entry_tag(linked_entry* entry) {
     char tag[TAG_LEN_MAX+1];
-    char* str;
+    const char* str;
     char msg[100];
 
     int count;
@@ -3729,6 +3795,21 @@ static void print_entry_childnum(linked_entry* entry) {
     printf("%s%.*s : %"PRIu64"\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, entry->child_num);
 }
 
+static void print_entry_tree(linked_entry* entry) {
+    char msg[] = "tree digest";
+    char tree_buf[2 * TREE_DIGEST_LENGTH + 1];
+
+    bytes_to_hex_str(tree_buf, entry->tree_sum, TREE_DIGEST_LENGTH);
+
+    printf("%s :\n", msg);
+    printf("    %s\n", tree_buf);
+}
+
+static void print_file_pending(file_data* data) {
+    char msg[] = "queued for hashing";
+    printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, data->pending_path);
+}
+
 static void print_file_size(file_data* data) {
     char msg[] = "file size";
     printf("%s%.*s : %s\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, data->file_size_str);
@@ -3795,6 +3876,30 @@ static void print_file_sha512(file_data* data) {
     }
 }
 
+static void print_file_mrkl(file_data* data) {
+    char msg[] = "file merkle root";
+    if (data->checksum[CHECKSUM_MRKL_INDEX].type == CHECKSUM_UNUSED) {
+        printf("No - merkle root - recorded\n");
+    }
+    else {
+        printf("%s :\n", msg);
+        printf("    %s\n", data->checksum[CHECKSUM_MRKL_INDEX].checksum_str);
+    }
+}
+
+static void print_file_fuzzy(file_data* data) {
+    char msg[] = "file fuzzy digest";
+    char str[FUZZY_STR_MAX+1];
+    if (data->fuzzy.block_size == 0) {
+        printf("No - fuzzy digest - recorded\n");
+    }
+    else {
+        fuzzy_digest_to_str(str, &data->fuzzy);
+        printf("%s :\n", msg);
+        printf("    %s\n", str);
+    }
+}
+
 static void print_file_sectnum(file_data* data) {
     char msg[] = "number of sections";
     printf("%s%.*s : %"PRIu64"\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, data->section_num);
@@ -3814,69 +3919,86 @@ static void print_file_sectsize(file_data* data) {
     }
 }
 
-static void print_sect_size(section* sect) {
+static void print_sect_size(file_data* data, uint64_t sect_index) {
     char msg[] = "section size";
 
+    uint64_t start_pos;
+    uint64_t end_pos;
     uint64_t size;
 
-    size = sect->end_pos - sect->start_pos + 1;
+    get_sect_pos(data, sect_index, &start_pos, &end_pos);
+    size = end_pos - start_pos + 1;
 
     printf("%s%.*s : %"PRIu64"\n", msg, calc_pad(msg, PRINT_PAD_SIZE), space_pad, size);
 }
 
-static void print_sect_extr(section* sect) {
+static void print_sect_extr(file_data* data, uint64_t sect_index) {
     int i;
 
-    if (sect->extract_num == 0) {
+    if (data->section[sect_index].extract_num == 0) {
         printf("No - extracts - recorded\n");
     }
     else {
-        for (i = 0; i < sect->extract_num; i++) {
+        for (i = 0; i < data->section[sect_index].extract_num; i++) {
             printf("extract : %*d\n", NUMBER_SHIFT, i);
 
-            print_extract(sect->extract + i);
+            print_extract(sect_extract(data, sect_index) + i);
         }
     }
 }
 
-static void print_sect_pos(section* sect) {
+static void print_sect_pos(file_data* data, uint64_t sect_index) {
     char msg1[] = "section start pos";
     char msg2[] = "section end pos";
 
-    printf("%s%.*s : %"PRIu64"\n", msg1, calc_pad(msg1, PRINT_PAD_SIZE), space_pad, sect->start_pos);
-    printf("%s%.*s : %"PRIu64"\n", msg2, calc_pad(msg2, PRINT_PAD_SIZE), space_pad, sect->end_pos);
+    uint64_t start_pos;
+    uint64_t end_pos;
+
+    get_sect_pos(data, sect_index, &start_pos, &end_pos);
+
+    printf("%s%.*s : %"PRIu64"\n", msg1, calc_pad(msg1, PRINT_PAD_SIZE), space_pad, start_pos);
+    printf("%s%.*s : %"PRIu64"\n", msg2, calc_pad(msg2, PRINT_PAD_SIZE), space_pad, end_pos);
 }
 
-static void print_sect_sha1(section* sect) {
+static void print_sect_sha1(file_data* data, uint64_t sect_index) {
     char msg[] = "section sha1 checksum";
-    if (sect->checksum[CHECKSUM_SHA1_INDEX].type == CHECKSUM_UNUSED) {
+    checksum_result checksum;
+
+    get_sect_checksum(data, sect_index, CHECKSUM_SHA1_INDEX, &checksum);
+    if (checksum.type == CHECKSUM_UNUSED) {
         printf("No - sha1 checksum - recorded\n");
     }
     else {
         printf("%s :\n", msg);
-        printf("    %s\n", sect->checksum[CHECKSUM_SHA1_INDEX].checksum_str);
+        printf("    %s\n", checksum.checksum_str);
     }
 }
 
-static void print_sect_sha256(section* sect) {
+static void print_sect_sha256(file_data* data, uint64_t sect_index) {
     char msg[] = "section sha256 checksum";
-    if (sect->checksum[CHECKSUM_SHA256_INDEX].type == CHECKSUM_UNUSED) {
+    checksum_result checksum;
+
+    get_sect_checksum(data, sect_index, CHECKSUM_SHA256_INDEX, &checksum);
+    if (checksum.type == CHECKSUM_UNUSED) {
         printf("No - sha256 checksum - recorded\n");
     }
     else {
         printf("%s :\n", msg);
-        printf("    %s\n", sect->checksum[CHECKSUM_SHA256_INDEX].checksum_str);
+        printf("    %s\n", checksum.checksum_str);
     }
 }
 
-static void print_sect_sha512(section* sect) {
+static void print_sect_sha512(file_data* data, uint64_t sect_index) {
     char msg[] = "section sha512 checksum";
-    if (sect->checksum[CHECKSUM_SHA512_INDEX].type == CHECKSUM_UNUSED) {
+    checksum_result checksum;
+
+    get_sect_checksum(data, sect_index, CHECKSUM_SHA512_INDEX, &checksum);
+    if (checksum.type == CHECKSUM_UNUSED) {
         printf("No - sha512 checksum - recorded\n");
     }
     else {
         printf("%s :\n", msg);
-        printf("    %s\n", sect->checksum[CHECKSUM_SHA512_INDEX].checksum_str);
+        printf("    %s\n", checksum.checksum_str);
     }
 }
 
@@ -3884,13 +4006,13 @@ static void print_sect_sha512(section* sect) {
  Design for show command:
 
  show locator FIELD1 FIELD2 ...
- FIELD := all | basic | eid | bid | name | date | type | madeby | tag | msg | childnum | file | sect
+ FIELD := all | basic | eid | bid | name | date | type | madeby | tag | msg | childnum | tree | file | sect
  choosing all will display all entry info, all file info, and all sect info
  choosing basic will display only the basic info of entry(does not print file info)
  defaults to basic
 
  show locator ... file FIELD1 FIELD2 ...
- FIELD := all | size | sha1 | sha256 | sha512 | sectnum | sectsize
+ FIELD := all | size | sha1 | sha256 | sha512 | mrkl | fuzzy | sectnum | sectsize
  choosing all will display all file info
  defaults to all
 
@@ -3907,7 +4029,6 @@ int show(term_info* info, dir_info* dir, int argc, char* argv[]) {
     database_handle* temp_dh_find;
 
     file_data* temp_file_data;
-    section* temp_section;
 
     int i, ret;
 
@@ -4049,6 +4170,7 @@ int show(term_info* info, dir_info* dir, int argc, char* argv[]) {
                             &&  strcmp(str, "tag"       )   != 0
                             &&  strcmp(str, "msg"       )   != 0
                             &&  strcmp(str, "childnum"  )   != 0
+                            &&  strcmp(str, "tree"      )   != 0
                             &&  strcmp(str, "file"      )   != 0
                             &&  strcmp(str, "sect"      )   != 0
                        )
@@ -4075,6 +4197,8 @@ int show(term_info* info, dir_info* dir, int argc, char* argv[]) {
                             &&  strcmp(str, "sha1"      )   != 0
                             &&  strcmp(str, "sha256"    )   != 0
                             &&  strcmp(str, "sha512"    )   != 0
+                            &&  strcmp(str, "mrkl"      )   != 0
+                            &&  strcmp(str, "fuzzy"     )   != 0
                             &&  strcmp(str, "sectnum"   )   != 0
                             &&  strcmp(str, "sectsize"  )   != 0
                        )
@@ -4192,6 +4316,9 @@ finish_categorise:
             else if (   strcmp(str, "childnum") == 0    ) {
                 print_entry_childnum    (temp_entry_find);
             }
+            else if (   strcmp(str, "tree")     == 0    ) {
+                print_entry_tree        (temp_entry_find);
+            }
         }
 
         printf("===== entry fields END =====\n");
@@ -4207,6 +4334,10 @@ finish_categorise:
         else {
             printf("===== file fields START =====\n");
 
+            if (temp_file_data->pending_flags) {
+                print_file_pending  (temp_file_data);
+            }
+
             for (i = 0; i < f_argc; i++) {
                 str = f_argv[i];
 
@@ -4216,6 +4347,8 @@ finish_categorise:
                     print_file_sha1     (temp_file_data);
                     print_file_sha256   (temp_file_data);
                     print_file_sha512   (temp_file_data);
+                    print_file_mrkl     (temp_file_data);
+                    print_file_fuzzy    (temp_file_data);
                     print_file_sectnum  (temp_file_data);
                     print_file_sectsize (temp_file_data);
                 }
@@ -4234,6 +4367,12 @@ finish_categorise:
                 else if (   strcmp(str, "sha512"    )   == 0    ) {
                     print_file_sha512   (temp_file_data);
                 }
+                else if (   strcmp(str, "mrkl"      )   == 0    ) {
+                    print_file_mrkl     (temp_file_data);
+                }
+                else if (   strcmp(str, "fuzzy"     )   == 0    ) {
+                    print_file_fuzzy    (temp_file_data);
+                }
                 else if (   strcmp(str, "sectnum"   )   == 0    ) {
                     print_file_sectnum  (temp_file_data);
                 }
@@ -4274,35 +4413,33 @@ finish_categorise:
 
                 printf("--------------------------------------------------\n");
 
-                temp_section = temp_file_data->section[s_loop_cur];
-
                 for (i = 0; i < s_argc; i++) {
                     str = s_argv[i];
                     if (        strcmp(str, "all"       )   == 0    ) {
-                        print_sect_size     (temp_section);
-                        print_sect_pos      (temp_section);
-                        print_sect_extr     (temp_section);
-                        print_sect_sha1     (temp_section);
-                        print_sect_sha256   (temp_section);
-                        print_sect_sha512   (temp_section);
+                        print_sect_size     (temp_file_data, s_loop_cur);
+                        print_sect_pos      (temp_file_data, s_loop_cur);
+                        print_sect_extr     (temp_file_data, s_loop_cur);
+                        print_sect_sha1     (temp_file_data, s_loop_cur);
+                        print_sect_sha256   (temp_file_data, s_loop_cur);
+                        print_sect_sha512   (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "size"      )   == 0    ) {
-                        print_sect_size     (temp_section);
+                        print_sect_size     (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "pos"       )   == 0    ) {
-                        print_sect_pos      (temp_section);
+                        print_sect_pos      (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "extr"      )   == 0    ) {
-                        print_sect_extr     (temp_section);
+                        print_sect_extr     (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "sha1"      )   == 0    ) {
-                        print_sect_sha1     (temp_section);
+                        print_sect_sha1     (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "sha256"    )   == 0    ) {
-                        print_sect_sha256   (temp_section);
+                        print_sect_sha256   (temp_file_data, s_loop_cur);
                     }
                     else if (   strcmp(str, "sha512"    )   == 0    ) {
-                        print_sect_sha512   (temp_section);
+                        print_sect_sha512   (temp_file_data, s_loop_cur);
                     }
                 }
             }
@@ -4359,11 +4496,19 @@ static void print_commands() {
     printf("                  search on disk using fingerprints stored\n");
     printf("        cmp     - compare between fingerprints (recursively), or\n");
     printf("                  compare between fingerprints and files\n");
+    printf("        similar - list files with similar content by fuzzy digest\n");
+    printf("        reconcile - compare fingerprints with a directory on disk,\n");
+    printf("                  telling moved files apart from new and missing ones\n");
 
     // data collection
     printf("\n");
     printf("== data collection ==\n");
     printf("    fp      - fingerprint file or directory\n");
+    printf("    throttle - limit disk bandwidth used by fp\n");
+    printf("    hashbackend - choose between kernel and user space hashing\n");
+    printf("    hcache  - share fingerprints of unchanged files between runs\n");
+    printf("    hashq   - show or control hashing deferred by fp --defer-hash\n");
+    printf("    watch   - keep an entry in sync with a directory as it changes\n");
 
     // file system
     printf("\n");
@@ -4400,7 +4545,8 @@ static void print_topics() {
     printf("            when dbname is not provided, and you are somewhere in a database\n");
     printf("            it will default to the database you are currently residing in\n");
     printf("\n");
-    printf("            partial matching is done on both dbname and entryid\n");
+    printf("            partial matching is done on both dbname and entryid,\n");
+    printf("            entryid is matched by prefix\n");
     printf("\n");
     printf("        e:path\n");
     printf("            access entry via path constructed using entry id\n");
@@ -4408,7 +4554,8 @@ static void print_topics() {
     printf("            path can be relative or absolute\n");
     printf("            path structure is same as what you would use in FS\n");
     printf("\n");
-    printf("            partial matching is done on each level of the path\n");
+    printf("            partial matching is done on each level of the path,\n");
+    printf("            each entry id is matched by prefix\n");
     printf("\n");
     printf("        f:path or path\n");
     printf("            access entry via path constructed using entry (file)name\n");
@@ -4543,7 +4690,7 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("Usage: show locator [entryfield...] [file filefield...] [sect SOPT sectionfield...]\n");
             printf("Format:\n");
             printf("    entryfield  := all | basic | eid | bid | name | date | type\n");
-            printf("                   madeby | tag | msg | childnum\n");
+            printf("                   madeby | tag | msg | childnum | tree\n");
             printf("\n");
             printf("        choosing all will display all entry info\n");
             printf("        all file info, and all section info\n");
@@ -4551,7 +4698,7 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("        defaults to basic\n");
             printf("\n");
             printf("    filefield   := all | size | extr | sha1 | sha256 | sha512\n");
-            printf("                   sectnum | sectsize\n");
+            printf("                   mrkl | fuzzy | sectnum | sectsize\n");
             printf("\n");
             printf("        choosing all will display all file info\n");
             printf("        defaults to all\n");
@@ -4686,6 +4833,8 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("                and find entry with matching fingerprints\n");
             printf("                defaults to using all possible fields\n");
             printf("                see list [1] for possible fields\n");
+            printf("                with f:extr, entries are looked up by size and extracts,\n");
+            printf("                and file is only hashed if one is found\n");
             printf("\n");
             printf("        entry in locator via entry ARG1 ARG2...\n");
             printf("                supply a entry locator in ARG1\n");
@@ -4714,6 +4863,7 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("            f:sha1      - file sha1 checksum\n");
             printf("            f:sha256    - file sha256 checksum\n");
             printf("            f:sha512    - file sha512 checksum\n");
+            printf("            f:mrkl      - file merkle root\n");
             printf("            s:extr      - section extracts\n");
             printf("                          (not used when used to find entry via entry)\n");
             printf("            s:sha1      - section sha1 checksum\n");
@@ -4724,27 +4874,27 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("            e:name          - name of entry\n");
             printf("                format : name\n");
             printf("            e:timeaddutc    - time of addition in UTC\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
             printf("            e:timeaddloc    - time of addition in local timezone\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
-            printf("            e:timemodutc    - time of addition in UTC\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
-            printf("            e:timemodloc    - time of addition in local timezone\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
-            printf("            e:timeusrutc    - time of addition in UTC\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
-            printf("            e:timeusrloc    - time of addition in local timezone\n");
-            printf("                format : YYYY/MM/DD_hh:mm\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
+            printf("            e:timemodutc    - time of modification in UTC\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
+            printf("            e:timemodloc    - time of modification in local timezone\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
+            printf("            e:timeusrutc    - user specified time in UTC\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
+            printf("            e:timeusrloc    - user specified time in local timezone\n");
+            printf("                format : YYYY-MM-DD_hh:mm:ss\n");
             printf("\n");
             printf("            Search syntax for date time (examples):\n");
             printf("                before some date:\n");
-            printf("                    <2016/8/9\n");
-            printf("                    <=2016/8/9\n");
+            printf("                    \"e:timeaddutc-><2016-08-09_00:00:00\"\n");
+            printf("                    \"e:timeaddutc-><=2016-08-09_00:00:00\"\n");
             printf("                after some date:\n");
-            printf("                    >2016/8/9\n");
-            printf("                    >=2016/8/9\n");
+            printf("                    \"e:timeaddutc->>2016-08-09_00:00:00\"\n");
+            printf("                    \"e:timeaddutc->>=2016-08-09_00:00:00\"\n");
             printf("                within range (inclusive):\n");
-            printf("                    \"2016/1/1 .. 2016/12/31\"\n");
+            printf("                    \"e:timeaddutc->2016-01-01_00:00:00 .. 2016-12-31_23:59:59\"\n");
             printf("\n");
             printf("            e:tag           - tags for indexing entry\n");
             printf("                format : |tag1|tag2|tag3|, | can be escaped using \\\n");
@@ -4753,6 +4903,7 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("            f:sha1          - sha1 checksum of file\n");
             printf("            f:sha256        - sha256 checksum of file\n");
             printf("            f:sha512        - sha512 checksum of file\n");
+            printf("            f:mrkl          - merkle root of file\n");
             printf("\n");
             printf("            s:sha1          - sha1 checksum of section\n");
             printf("            s:sha256        - sha256 checksum of section\n");
@@ -4761,18 +4912,84 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
         }
         else if (   strcmp(str, "cmp")      == 0) {
             printf("******************************\n");
+            printf("Usage: cmp [-r] locator1 locator2\n");
+            printf("compares children of two entries by name and content\n");
+            printf("branches with same tree digest are skipped without being visited\n");
+            printf("Format:\n");
+            printf("    OPT :\n");
+            printf("        -r      recursive\n");
+            printf("\n");
+            printf("    output :\n");
+            printf("        - path  only in locator1\n");
+            printf("        + path  only in locator2\n");
+            printf("        * path  in both, but differ\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "similar")  == 0) {
+            printf("******************************\n");
+            printf("Usage: similar [--min N] locator\n");
+            printf("lists files in loaded databases with content similar to locator\n");
+            printf("Format:\n");
+            printf("    OPT :\n");
+            printf("        --min N     only list files scoring at least N, 1 to 100\n");
+            printf("\n");
+            printf("    output :\n");
+            printf("        score  /dbname/path\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    Only files fingerprinted with fp --f:fuzzy can be compared\n");
+            printf("    Score is from 0 to 100, 100 meaning fuzzy digests are the same,\n");
+            printf("    files sharing no run of 7 digest characters score 0 and are not listed\n");
+            printf("    Results are listed from most similar first\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "reconcile")    == 0) {
+            printf("******************************\n");
+            printf("Usage: reconcile [-c] [--exclude PATTERN] [--no-ignore-file] locator dirpath\n");
+            printf("compares group entry locator with directory dirpath on disk\n");
+            printf("Format:\n");
+            printf("    OPT :\n");
+            printf("        -c                  hash files matched by path as well,\n");
+            printf("                            otherwise they are compared by size and extracts\n");
+            printf("        --exclude PATTERN   skip files and directories matching PATTERN,\n");
+            printf("                            same syntax as fp --exclude\n");
+            printf("        --no-ignore-file    do not read .ffpignore files\n");
+            printf("\n");
+            printf("    output :\n");
+            printf("        * path          in both, but differ\n");
+            printf("        > old -> new    moved, same content under another path\n");
+            printf("        + path          only on disk\n");
+            printf("        - path          only in locator\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    Changed files are listed as they are found, the rest after the walk\n");
+            printf("    Only files of the same size as an entry not found on disk are hashed,\n");
+            printf("    and only if extracts of that entry agree with them\n");
+            printf("    Entries still queued for hashing (see hashq) are never taken as moved\n");
             printf("******************************\n");
         }
         /* == data collection == */
         else if (   strcmp(str, "fp")       == 0) {
             printf("******************************\n");
             printf("Usage: fp [OPT] mode targetinFS dir\n");
+            printf("       fp [OPT] --from-list listfile dir\n");
             printf("fingerprints targetinFS and stores resulted entries in dir\n");
             printf("Format:\n");
             printf("    mode := new | update\n");
             printf("    OPT  :\n");
             printf("        -r              recursive\n");
             printf("        --depth N       depth to traverse\n");
+            printf("        --tar           targetinFS is a tar archive, or - for stdin\n");
+            printf("        --from-list F   fingerprint paths listed in F, or - for stdin\n");
+            printf("        --append        refresh existing entry dir from targetinFS\n");
+            printf("        --defer-hash    only record what stat gives now,\n");
+            printf("                        hash content later, see hashq\n");
+            printf("        --exclude P     skip files matching gitignore style pattern P\n");
+            printf("        --include P     do not skip files matching P, same as --exclude !P\n");
+            printf("        --no-ignore-file    do not read %s in directories\n", IGNORE_FILE_NAME);
+            printf("        --one-fs        do not go into other file systems\n");
+            printf("        --min-size N[K|M|G] skip files smaller than N bytes\n");
+            printf("        --max-size N[K|M|G] skip files larger than N bytes\n");
             printf("\n");
             printf("        --name          include file name\n");
             printf("        --f:size        include file size\n");
@@ -4780,6 +4997,10 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("        --f:sha1        include file wise sha1 checksum\n");
             printf("        --f:sha256      include file wise sha256 checksum\n");
             printf("        --f:sha512      include file wise sha512 checksum\n");
+            printf("        --f:mrkl        include merkle root over section sha256\n");
+            printf("                        checksums (implies --s:sha256)\n");
+            printf("        --f:fuzzy       include fuzzy digest for similarity lookup,\n");
+            printf("                        see similar\n");
             printf("\n");
             printf("        --s:extr        include section extracts\n");
             printf("        --s:sha1        include file wise sha1 checksum\n");
@@ -4791,21 +5012,160 @@ int help(term_info* info, dir_info* dir, int argc, char* argv[]) {
             printf("    targetinFS will be used as entry name\n");
             printf("    if entryname is absent and name is not included\n");
             printf("    the replacement name will be used as entry name\n");
+            printf("\n");
+            printf("    With --tar, the archive is read in one sequential pass without\n");
+            printf("    extracting, and a group entry holding one entry per member is\n");
+            printf("    created in dir. Members are fingerprinted exactly as the\n");
+            printf("    extracted files would be\n");
+            printf("\n");
+            printf("    With --from-list, paths are separated by NUL if the list contains\n");
+            printf("    any, otherwise by newline, e.g. output of find -print0 or git\n");
+            printf("    diff --name-only. Listed files are put under dir with their\n");
+            printf("    relative directory structure kept (if name is included).\n");
+            printf("    Paths are visited grouped by directory and in inode order,\n");
+            printf("    missing paths are reported and skipped\n");
+            printf("\n");
+            printf("    With --append, dir is an existing file entry (or group entry\n");
+            printf("    matched by child names against directory targetinFS) which is\n");
+            printf("    brought up to date. Files which only grew since last time are\n");
+            printf("    checked via their last section and extracts, and only the\n");
+            printf("    appended tail is read. Other files are fingerprinted again.\n");
+            printf("    Appending needs the same flags as before and section checksums\n");
+            printf("\n");
+            printf("    With --defer-hash, entries are created with file size only and\n");
+            printf("    queued, content is hashed with the flags given while the prompt\n");
+            printf("    is waiting for input. Cannot be used with --tar or --append\n");
+            printf("\n");
+            printf("    When walking directories, patterns in %s of each directory\n", IGNORE_FILE_NAME);
+            printf("    are followed, one per line in gitignore syntax, relative to that directory\n");
+            printf("    Patterns given to fp are relative to targetinFS and take precedence\n");
+            printf("    Skipped directories are not opened, and nothing under them can be\n");
+            printf("    included again. Numbers of files skipped are shown after fp finishes\n");
             printf("******************************\n");
         }
-        /* == file system == */
-        else if (   strcmp(str, "fpwd")     == 0) {
+        else if (   strcmp(str, "throttle") == 0) {
             printf("******************************\n");
-            printf("Usage: fpwd\n");
-            printf("Displays ffprinter's current working directory in file system\n");
+            printf("Usage: throttle [off | reset | OPT...]\n");
+            printf("Limits disk bandwidth and file rate used when fingerprinting\n");
+            printf("Format:\n");
+            printf("    OPT  :\n");
+            printf("        --bytes N[K|M|G]    bytes per second, 0 for unlimited\n");
+            printf("        --files N           files per second, 0 for unlimited\n");
+            printf("        --latency N         back off while average read latency\n");
+            printf("                            is above N microseconds, 0 to disable\n");
+            printf("\n");
+            printf("    off     - disable throttling\n");
+            printf("    reset   - reset throttle statistics\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    With no arguments, current limits and statistics are shown\n");
+            printf("    Options not specified keep their current values\n");
+            printf("    Throttling adds no overhead to fp when off\n");
             printf("******************************\n");
         }
-        else if (   strcmp(str, "fls")      == 0) {
+        else if (   strcmp(str, "hashbackend") == 0) {
             printf("******************************\n");
-            printf("Usage: fls [opt] [dir]\n");
-            printf("List content in directory\n");
+            printf("Usage: hashbackend [auto | user | kernel | probe]\n");
+            printf("Chooses where fp computes checksums\n");
             printf("Format:\n");
-            printf("    opt:\n");
+            printf("    auto    - use kernel crypto API for checksums where\n");
+            printf("              it was measured faster (default)\n");
+            printf("    user    - always hash in user space\n");
+            printf("    kernel  - use kernel crypto API wherever available\n");
+            printf("    probe   - measure throughput again\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    With no arguments, current backend and measured throughput are shown\n");
+            printf("    Kernel hashing is only used for a file if it covers every checksum requested,\n");
+            printf("    file content is then spliced into the kernel without copying\n");
+            printf("    Files fingerprinted in kernel keep no state for fp --append,\n");
+            printf("    so they are fingerprinted again in full when they grow\n");
+            printf("    Checksums are the same with either backend\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "hcache")   == 0) {
+            printf("******************************\n");
+            printf("Usage: hcache open path [--size N[K|M|G]]\n");
+            printf("       hcache [close]\n");
+            printf("Keeps fingerprints of files in a cache file, so fp only needs\n");
+            printf("to stat a file it (or another ffprinter) has fingerprinted before\n");
+            printf("Format:\n");
+            printf("    open    - use cache file at path, created if it does not exist\n");
+            printf("    OPT :\n");
+            printf("        --size N[K|M|G]     size of cache file when created, default 256M\n");
+            printf("    close   - stop using cache file\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    With no arguments, cache file in use and its statistics are shown\n");
+            printf("    A file is recognised by device, inode, size, modification and\n");
+            printf("    status change time, and only for the same fingerprint options\n");
+            printf("    Files changed in the last 2 seconds are not cached\n");
+            printf("    Any number of ffprinter processes may use the same cache file,\n");
+            printf("    oldest fingerprints are dropped once it is full\n");
+            printf("    Size of an existing cache file is kept, remove it to resize\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "hashq")    == 0) {
+            printf("******************************\n");
+            printf("Usage: hashq [pause | resume | run]\n");
+            printf("       hashq now [-r] locator...\n");
+            printf("Shows or controls hashing of files queued by fp --defer-hash\n");
+            printf("Format:\n");
+            printf("    pause   - stop hashing while waiting for input\n");
+            printf("    resume  - hash while waiting for input again (default)\n");
+            printf("    run     - hash everything queued now\n");
+            printf("    now     - hash queued entries at locator and its children now,\n");
+            printf("              ahead of the rest of the queue\n");
+            printf("    OPT :\n");
+            printf("        -r      recursive\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    With no arguments, number of files queued and hashed is shown\n");
+            printf("    Queued files are hashed in order while the prompt is idle,\n");
+            printf("    a bounded amount at a time, a file in progress is started over\n");
+            printf("    if a command runs before it is finished\n");
+            printf("    Queue is saved with the database, and cmp hashes queued\n");
+            printf("    entries it compares first\n");
+            printf("    Files which cannot be read are dropped from queue,\n");
+            printf("    their entries keep the file size only\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "watch")    == 0) {
+            printf("******************************\n");
+            printf("Usage: watch locator dirpath\n");
+            printf("       watch [sync | stop]\n");
+            printf("Keeps entry at locator in sync with directory at dirpath as files change\n");
+            printf("Format:\n");
+            printf("    locator dirpath - start watching, entry should be the group entry\n");
+            printf("                      dirpath was fingerprinted into\n");
+            printf("    sync    - apply changes seen so far now\n");
+            printf("    stop    - stop watching\n");
+            printf("\n");
+            printf("Note:\n");
+            printf("    With no arguments, what is watched and changes applied so far are shown\n");
+            printf("    Changes are applied while the prompt is idle, once events have stopped\n");
+            printf("    for a moment, so a file written many times is fingerprinted once\n");
+            printf("    Changed files are fingerprinted again (only the tail if appended to),\n");
+            printf("    new files are fingerprinted, removed files are deleted from database,\n");
+            printf("    and renamed files are renamed without reading them again\n");
+            printf("    Files added or removed before watch started are picked up when it starts,\n");
+            printf("    but content changed before then is not, use fp --append for that\n");
+            printf("    Only one directory is watched at a time, on Linux only\n");
+            printf("******************************\n");
+        }
+        /* == file system == */
+        else if (   strcmp(str, "fpwd")     == 0) {
+            printf("******************************\n");
+            printf("Usage: fpwd\n");
+            printf("Displays ffprinter's current working directory in file system\n");
+            printf("******************************\n");
+        }
+        else if (   strcmp(str, "fls")      == 0) {
+            printf("******************************\n");
+            printf("Usage: fls [opt] [dir]\n");
+            printf("List content in directory\n");
+            printf("Format:\n");
+            printf("    opt:\n");
             printf("        -a      show all\n");
             printf("        -A      show almost all(hide . and ..)\n");
             printf("\n");
@@ -5250,6 +5610,38 @@ int fcd(term_info* info, dir_info* dir, int argc, char* argv[]) {
     return 0;
 }
 
+// close file being hashed and put back file data being replaced, shared by fp, cmp and hashq
+static int hashing_cleanup(const char* func_name) {
+    linked_entry* entry;
+
+    int ret = 0;
+
+    if (file_being_used) {
+        if (fclose(file_being_used)) {
+            printf("%s : failed to close file\n", func_name);
+            ret =  FFP_GENERAL_FAIL;
+        }
+
+        file_being_used = NULL;
+    }
+
+    // close kernel hashing sockets left open
+    afalg_cleanup();
+
+    if (data_being_replaced) {
+        // drop partially built file data and put the old one back
+        entry = data_being_replaced->parent_entry;
+        if (entry->data && entry->data != data_being_replaced) {
+            del_file_data(dh_being_used, entry->data);
+        }
+        entry->data = data_being_replaced;
+
+        data_being_replaced = NULL;
+    }
+
+    return ret;
+}
+
 int fp_cleanup() {
     dirp_record* temp_dirp_record;
 
@@ -5263,13 +5655,8 @@ int fp_cleanup() {
         ret = FFP_GENERAL_FAIL;
     }
 
-    if (file_being_used) {
-        if (fclose(file_being_used)) {
-            perror("fp_cleanup ");
-            ret =  FFP_GENERAL_FAIL;
-        }
-
-        file_being_used = NULL;
+    if (hashing_cleanup("fp_cleanup")) {
+        ret = FFP_GENERAL_FAIL;
     }
 
     if (entry_being_used) {
@@ -5288,6 +5675,13 @@ int fp_cleanup() {
         entry_being_used = NULL;
     }
 
+    if (entry_being_filled) {
+        // entries fingerprinted before interruption are kept
+        tree_digest_update_new(entry_being_filled);
+
+        entry_being_filled = NULL;
+    }
+
     for (i = 0; i < max_dirp_record_index; i++) {
         j = get_dirp_record_from_layer2_arr(&l2_dirp_record_arr, &temp_dirp_record, i);
 
@@ -5307,9 +5701,72 @@ int fp_cleanup() {
 
     max_dirp_record_index = 0;
 
+    walk_filter_free(&fp_walk_filter);
+
     return ret;
 }
 
+static int parse_rate(const char* str, uint64_t* result) {
+    uint64_t val;
+    char suffix = 0;
+
+    int matched;
+
+    matched = sscanf(str, "%"SCNu64"%c", &val, &suffix);
+    if (matched < 1) {
+        return WRONG_ARGS;
+    }
+
+    switch (suffix) {
+        case 0 :
+            break;
+        case 'k' :
+        case 'K' :
+            val *= UINT64_C(1024);
+            break;
+        case 'm' :
+        case 'M' :
+            val *= UINT64_C(1048576);
+            break;
+        case 'g' :
+        case 'G' :
+            val *= UINT64_C(1073741824);
+            break;
+        default :
+            return WRONG_ARGS;
+    }
+
+    *result = val;
+
+    return 0;
+}
+
+static void print_walk_filter_stats(walk_filter* filter) {
+    if (        filter->ignored_dir_num
+            ||  filter->ignored_file_num
+            ||  filter->ignore_file_num
+       )
+    {
+        printf("fp : %"PRIu64" director(ies) and %"PRIu64" file(s) skipped by ignore rules, %"PRIu64" ignore file(s) read\n",
+                filter->ignored_dir_num,
+                filter->ignored_file_num,
+                filter->ignore_file_num
+              );
+    }
+
+    if (        filter->other_fs_num
+            ||  filter->size_num
+            ||  filter->depth_num
+       )
+    {
+        printf("fp : %"PRIu64" skipped on other file systems, %"PRIu64" by size, %"PRIu64" beyond depth\n",
+                filter->other_fs_num,
+                filter->size_num,
+                filter->depth_num
+              );
+    }
+}
+
 int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
     int i, j;
 
@@ -5338,10 +5795,26 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
     ffp_eid_int* depth_p;
     unsigned char depth_specified = 0;
 
+    unsigned char tar_mode = 0;
+    unsigned char append_mode = 0;
+    unsigned char defer_mode = 0;
+    char* list_path = NULL;
+
+    uint64_t pending_num_before;
+    ffp_eid_int child_num_before;
+
+    refresh_stats stats;
+
+    char pattern[IGNORE_LINE_MAX+2];
+    unsigned char filter_specified = 0;
+
     unsigned char opt_flag[FP_OPT_NUM];
 
     error_mark_owner(&er_h, "fp");
 
+    // drop rules of last run
+    walk_filter_free(&fp_walk_filter);
+
     for (i = 0; i < FP_OPT_NUM; i++) {
         opt_flag[i] = 0;
     }
@@ -5377,6 +5850,79 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
                     i++;
                 }
             }
+            else if (   strcmp(str, "tar")          == 0) {
+                tar_mode = 1;
+            }
+            else if (   strcmp(str, "append")       == 0) {
+                append_mode = 1;
+            }
+            else if (   strcmp(str, "defer-hash")   == 0) {
+                defer_mode = 1;
+            }
+            else if (       strcmp(str, "exclude")  == 0
+                        ||  strcmp(str, "include")  == 0
+                    )
+            {
+                if (i + 1 >= argc) {
+                    printf("fp : please specify pattern\n");
+                    return WRONG_ARGS;
+                }
+                if (strlen(argv[i+1]) > IGNORE_LINE_MAX) {
+                    printf("fp : pattern too long\n");
+                    return WRONG_ARGS;
+                }
+
+                // include is an exclude pattern negated
+                strcpy(pattern, str[0] == 'i' ? "!" : "");
+                strcat(pattern, argv[i+1]);
+
+                ret = walk_filter_add_pattern(&fp_walk_filter, pattern);
+                switch (ret) {
+                    case 0 :
+                        break;
+                    case IGNORE_PATTERN_INVALID :
+                        printf("fp : invalid pattern : %s\n", argv[i+1]);
+                        return WRONG_ARGS;
+                    default :
+                        printf("fp : failed to add pattern\n");
+                        return ret;
+                }
+                filter_specified = 1;
+
+                i++;
+            }
+            else if (   strcmp(str, "no-ignore-file")   == 0) {
+                fp_walk_filter.use_ignore_file = 0;
+            }
+            else if (   strcmp(str, "one-fs")       == 0) {
+                fp_walk_filter.one_fs = 1;
+                filter_specified = 1;
+            }
+            else if (       strcmp(str, "min-size") == 0
+                        ||  strcmp(str, "max-size") == 0
+                    )
+            {
+                if (i + 1 >= argc) {
+                    printf("fp : please specify size\n");
+                    return WRONG_ARGS;
+                }
+                if (parse_rate(argv[i+1], str[1] == 'i' ? &fp_walk_filter.min_size : &fp_walk_filter.max_size)) {
+                    printf("fp : invalid size\n");
+                    return WRONG_ARGS;
+                }
+                filter_specified = 1;
+
+                i++;
+            }
+            else if (   strcmp(str, "from-list")    == 0) {
+                if (i + 1 >= argc) {
+                    printf("fp : please specify list file\n");
+                    return WRONG_ARGS;
+                }
+                list_path = argv[i+1];
+
+                i++;
+            }
             else if (   strcmp(str, "name")         == 0) {
                 flags |= FPRINT_USE_F_NAME;
                 flags_modifier_specified = 1;
@@ -5401,6 +5947,17 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
                 flags |= FPRINT_USE_F_SHA512;
                 flags_modifier_specified = 1;
             }
+            else if (   strcmp(str, "f:mrkl")       == 0) {
+                flags |= FPRINT_USE_F_MRKL;
+                flags |= FPRINT_USE_S_SHA256;
+                flags |= FPRINT_USE_F_SIZE;
+                flags_modifier_specified = 1;
+            }
+            else if (   strcmp(str, "f:fuzzy")      == 0) {
+                flags |= FPRINT_USE_F_FUZZY;
+                flags |= FPRINT_USE_F_SIZE;
+                flags_modifier_specified = 1;
+            }
             else if (   strcmp(str, "f:allsum")     == 0) {     // awesome, hahahahahaha... okay i will walk myself out
                 flags |=    FPRINT_USE_F_SHA1
                     |       FPRINT_USE_F_SHA256
@@ -5452,7 +6009,46 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
         }
     }
 
-    if (tar_count < 1) {
+    if (append_mode && (tar_mode || list_path)) {
+        printf("fp : --append cannot be used with --tar or --from-list\n");
+        return WRONG_ARGS;
+    }
+
+    if (filter_specified && (tar_mode || list_path || append_mode)) {
+        printf("fp : ignore patterns and walk limits cannot be used with --tar, --from-list or --append\n");
+        return WRONG_ARGS;
+    }
+
+    if (        fp_walk_filter.max_size
+            &&  fp_walk_filter.min_size > fp_walk_filter.max_size
+       )
+    {
+        printf("fp : minimum size is larger than maximum size\n");
+        return WRONG_ARGS;
+    }
+
+    // content of archive members cannot be read again later, and refreshing needs old hashes
+    if (defer_mode && (tar_mode || append_mode)) {
+        printf("fp : --defer-hash cannot be used with --tar or --append\n");
+        return WRONG_ARGS;
+    }
+
+    if (list_path) {
+        if (tar_mode) {
+            printf("fp : --from-list cannot be used with --tar\n");
+            return WRONG_ARGS;
+        }
+
+        // paths come from list, so the only target is the destination entry
+        if (tar_count > 1) {
+            printf("fp : too many targets\n");
+            return WRONG_ARGS;
+        }
+
+        entry_tar_index = fs_tar_index;
+        entry_tar_index_set = fs_tar_index_set;
+    }
+    else if (tar_count < 1) {
         printf("fp : too few targets\n");
         return WRONG_ARGS;
     }
@@ -5464,7 +6060,9 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
     // initialise loose resource pointer
     dh_being_used = NULL;
     entry_being_used = NULL;
+    entry_being_filled = NULL;
     file_being_used = NULL;
+    data_being_replaced = NULL;
     max_dirp_record_index = 0;
 
     // default to using everything
@@ -5481,6 +6079,10 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
             |   FPRINT_USE_S_SHA512;
     }
 
+    if (defer_mode) {
+        flags |= FPRINT_DEFER_HASH;
+    }
+
     // backup current working directory
     if (getcwd(cwd_backup, sizeof(cwd_backup)) == NULL) {
         printf("fp : failed to backup current directory\n");
@@ -5524,481 +6126,1993 @@ int fp(term_info* info, dir_info* dir, int argc, char* argv[]) {
         depth_p = NULL;
     }
 
+    pending_num_before = tar_dh->pending_num;
+    child_num_before = tar_entry->child_num;
+
     // mark needing cleanup before calling gen tree
     MARK_NEED_CLEANUP();
 
     dh_being_used = tar_dh;
+    entry_being_filled = tar_entry;
+
+    if (append_mode) {
+        if (strcmp(argv[fs_tar_index], "-") == 0) {
+            printf("fp : reading from stdin is only supported with --tar\n");
+            MARK_NO_NEED_CLEANUP();
+            return WRONG_ARGS;
+        }
+
+        memset(&stats, 0, sizeof(stats));
+
+        ret = fingerprint_refresh_tree(tar_dh, argv[fs_tar_index], tar_entry, flags, &er_h, &file_being_used, &data_being_replaced, &stats);
+        if (!ret) {
+            printf("fp : %"PRIu64" appended, %"PRIu64" unchanged, %"PRIu64" fingerprinted again, %"PRIu64" skipped\n", stats.appended, stats.unchanged, stats.full, stats.skipped);
+        }
+    }
+    else if (list_path) {
+        ret = fingerprint_list(tar_dh, list_path, tar_entry, flags, &er_h, &entry_being_used, &file_being_used);
+    }
+    else if (tar_mode) {
+        ret = fingerprint_tar(tar_dh, argv[fs_tar_index], tar_entry, flags, &er_h, &entry_being_used, &file_being_used);
+    }
+    else {
+        if (strcmp(argv[fs_tar_index], "-") == 0) {
+            printf("fp : reading from stdin is only supported with --tar\n");
+            MARK_NO_NEED_CLEANUP();
+            return WRONG_ARGS;
+        }
+
+        if (walk_filter_begin(&fp_walk_filter, argv[fs_tar_index])) {
+            printf("fp : failed to get stats - file may not exist\n");
+            MARK_NO_NEED_CLEANUP();
+            return FS_FILE_ACCESS_FAIL;
+        }
+
+        ret = gen_tree(tar_dh, argv[fs_tar_index], tar_entry, flags, opt_flag[FP_OPT_r], depth_p, &fp_walk_filter, &er_h, &entry_being_used, &file_being_used, &l2_dirp_record_arr, &max_dirp_record_index);
+        if (!ret) {
+            print_walk_filter_stats(&fp_walk_filter);
+        }
 
-    ret = gen_tree(tar_dh, argv[fs_tar_index], tar_entry, flags, opt_flag[FP_OPT_r], depth_p, &er_h, &entry_being_used, &file_being_used, &l2_dirp_record_arr, &max_dirp_record_index);
+        walk_filter_free(&fp_walk_filter);
+    }
     if (ret) {
         error_print_owner_msg(&er_h);
         error_mark_inactive(&er_h);
         return ret;
     }
 
+    // tree digests are not maintained while fingerprinting, only digest what this fp added
+    if (append_mode || list_path || tar_mode) {
+        // new entries may be spread over existing groups
+        tree_digest_update_new(tar_entry);
+    }
+    else {
+        // gen_tree only appends children to tar_entry
+        for (i = child_num_before; i < tar_entry->child_num; i++) {
+            tree_digest_update(tar_entry->child[i], 1);
+        }
+    }
+    entry_being_filled = NULL;
+
+    if (defer_mode) {
+        printf("fp : %"PRIu64" file(s) queued for hashing, %"PRIu64" in total\n", tar_dh->pending_num - pending_num_before, tar_dh->pending_num);
+    }
+
     // everything finished successfully, no need for cleanup
     MARK_NO_NEED_CLEANUP();
 
     return 0;
 }
 
-/* local macros */
-#define find_parse_fields() \
-    for (   /* no initialisation needed */;                         \
-            cur_indx <= argv_end_indx;   /* inclusive */            \
-            cur_indx++                                              \
-        )                                                           \
-    {                                                               \
-        str = argv[cur_indx];                                       \
-        if (        strcmp(str, "all")      == 0) {                 \
-            for (i = 0; i < FIND_FIELD_NUM; i++) {                  \
-                field_specified[i] = 1;                             \
-            }                                                       \
-            break;                                                  \
-        }                                                           \
-        else if (   strcmp(str, "name")     == 0) {                 \
-            if (field_specified[FIND_FIELD_E_NAME]) {               \
-                printf("find : field \"name\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_E_NAME] = 1;                 \
-        }                                                           \
-        else if (   strcmp(str, "f:size")   == 0) {                 \
-            if (field_specified[FIND_FIELD_F_SIZE]) {               \
-                printf("find : field \"f:size\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_F_SIZE] = 1;                 \
-        }                                                           \
-        else if (   strcmp(str, "f:sha1")   == 0) {                 \
-            if (field_specified[FIND_FIELD_F_SHA1]) {               \
-                printf("find : field \"f:sha1\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_F_SHA1] = 1;                 \
-        }                                                           \
-        else if (   strcmp(str, "f:sha256") == 0) {                 \
-            if (field_specified[FIND_FIELD_F_SHA256]) {             \
-                printf("find : field \"f:sha256\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_F_SHA256] = 1;               \
-        }                                                           \
-        else if (   strcmp(str, "f:sha512") == 0) {                 \
-            if (field_specified[FIND_FIELD_F_SHA512]) {             \
-                printf("find : field \"f:sha512\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_F_SHA512] = 1;               \
-        }                                                           \
-        else if (   strcmp(str, "s:sha1")   == 0) {                 \
-            if (field_specified[FIND_FIELD_S_SHA1]) {               \
-                printf("find : field \"s:sha1\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_S_SHA1] = 1;                 \
-        }                                                           \
-        else if (   strcmp(str, "s:sha256") == 0) {                 \
-            if (field_specified[FIND_FIELD_S_SHA256]) {             \
-                printf("find : field \"s:sha256\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_S_SHA256] = 1;               \
-        }                                                           \
-        else if (   strcmp(str, "s:sha512") == 0) {                 \
-            if (field_specified[FIND_FIELD_S_SHA512]) {             \
-                printf("find : field \"s:sha512\" already specified\n");\
-                return WRONG_ARGS;                                  \
-            }                                                       \
-            field_specified[FIND_FIELD_S_SHA512] = 1;               \
-        }                                                           \
-        else {                                                      \
-            printf("find : unknown field : %s\n", str);             \
-            return WRONG_ARGS;                                      \
-        }                                                           \
-    }
-
-int find(term_info* info, dir_info* dir, int argc, char* argv[]) {
+int throttle(term_info* info, dir_info* dir, int argc, char* argv[]) {
     int i;
-    int ret;
-
-    const char time_format[] = "%Y-%m-%d_%H:%M:%S";
 
-    int argv_end_indx;  // inclusive
-    int cur_indx;
+    char* str;
 
-    int keyval_indx;
+    uint64_t bytes_per_sec      = fp_throttle.bytes_per_sec;
+    uint64_t files_per_sec      = fp_throttle.files_per_sec;
+    uint64_t latency_thres_us   = fp_throttle.latency_thres_us;
 
-    char* str;
+    if (argc == 0) {
+        throttle_print_status();
+        return 0;
+    }
 
-    char* path;
+    if (argc == 1 && strcmp(argv[0], "off") == 0) {
+        throttle_off();
+        printf("throttle : off\n");
+        return 0;
+    }
 
-    struct stat file_stat;
+    if (argc == 1 && strcmp(argv[0], "reset") == 0) {
+        throttle_reset_stats();
+        return 0;
+    }
 
-    float score_float;
-    unsigned int score_uint;
+    for (i = 0; i < argc; i++) {
+        if (!IS_WORD_OPTION(argv[i])) {
+            printf("throttle : unknown argument : %s\n", argv[i]);
+            return WRONG_ARGS;
+        }
 
-    dir_info result_dir;
+        str = argv[i] + 2;
 
-    error_handle er_h;
+        if (i + 1 >= argc) {
+            printf("throttle : missing value for %s\n", argv[i]);
+            return WRONG_ARGS;
+        }
 
-    unsigned char target;
+        if (        strcmp(str, "bytes")    == 0) {
+            if (parse_rate(argv[i+1], &bytes_per_sec)) {
+                printf("throttle : invalid byte rate\n");
+                return WRONG_ARGS;
+            }
+        }
+        else if (   strcmp(str, "files")    == 0) {
+            if (sscanf(argv[i+1], "%"SCNu64"", &files_per_sec) != 1) {
+                printf("throttle : invalid file rate\n");
+                return WRONG_ARGS;
+            }
+        }
+        else if (   strcmp(str, "latency")  == 0) {
+            if (sscanf(argv[i+1], "%"SCNu64"", &latency_thres_us) != 1) {
+                printf("throttle : invalid latency threshold\n");
+                return WRONG_ARGS;
+            }
+        }
+        else {
+            printf("throttle : unknown option\n");
+            return NO_SUCH_OPT;
+        }
 
-    unsigned char field_specified[FIND_FIELD_NUM];
+        i++;
+    }
 
-    field_record rec;
+    // bucket arithmetic is signed
+    if (bytes_per_sec > INT64_MAX || files_per_sec > INT64_MAX) {
+        printf("throttle : rate too large\n");
+        return WRONG_ARGS;
+    }
 
-    struct tm temp_time;
+    throttle_set(bytes_per_sec, files_per_sec, latency_thres_us);
 
-    mem_wipe_sec(field_specified, sizeof(field_specified));
+    throttle_print_status();
 
-    error_mark_owner(&er_h, "find");
+    return 0;
+}
 
-    mem_wipe_sec(&rec, sizeof(field_record));
+int hashbackend(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    if (argc == 0) {
+        afalg_print_status();
+        return 0;
+    }
 
-    if (argc < 6) {
-        printf("find : too few arguments\n");
+    if (argc > 1) {
+        printf("hashbackend : too many arguments\n");
         return WRONG_ARGS;
     }
 
-    // check if score is specified
-    if (strcmp(argv[(argc-1) -1], "score")  == 0) {
-        if (argc-2 < 6) {
-            printf("find : too few arguments\n");
-            return WRONG_ARGS;
+    if (        strcmp(argv[0], "auto")     == 0) {
+        afalg_set_mode(AFALG_MODE_AUTO);
+    }
+    else if (   strcmp(argv[0], "user")     == 0) {
+        afalg_set_mode(AFALG_MODE_USER);
+    }
+    else if (   strcmp(argv[0], "kernel")   == 0) {
+        afalg_set_mode(AFALG_MODE_KERNEL);
+    }
+    else if (   strcmp(argv[0], "probe")    == 0) {
+        if (afalg_probe() == MALLOC_FAIL) {
+            printf("hashbackend : failed to allocate probe buffer\n");
+            return MALLOC_FAIL;
         }
+    }
+    else {
+        printf("hashbackend : unknown argument : %s\n", argv[0]);
+        return WRONG_ARGS;
+    }
 
-        // parse score
-        if (sscanf(argv[argc-1], "%f", &score_float) != 1) {
-            printf("find : invalid score\n");
+    afalg_print_status();
+
+    return 0;
+}
+
+int hcache(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    uint64_t size = HCACHE_SIZE_DEFAULT;
+    int ret;
+
+    if (argc == 0) {
+        hcache_print_status(&fp_hcache);
+        return 0;
+    }
+
+    if (strcmp(argv[0], "close") == 0) {
+        if (argc > 1) {
+            printf("hcache : too many arguments\n");
             return WRONG_ARGS;
         }
 
-        if (score_float < 0.0 || 100.0 < score_float) {
-            printf("find : score out of range\n");
-            return WRONG_ARGS;
+        hcache_close(&fp_hcache);
+
+        hcache_print_status(&fp_hcache);
+        return 0;
+    }
+
+    if (strcmp(argv[0], "open") != 0) {
+        printf("hcache : unknown argument : %s\n", argv[0]);
+        return WRONG_ARGS;
+    }
+
+    if (argc != 2 && argc != 4) {
+        printf("hcache : wrong number of arguments\n");
+        return WRONG_ARGS;
+    }
+
+    if (argc == 4) {
+        if (strcmp(argv[2], "--size") != 0) {
+            printf("hcache : unknown option\n");
+            return NO_SUCH_OPT;
         }
 
-        // convert to integer
-        score_uint = score_float * 100; // precise to 2 decimal place
-        if (score_uint > 100 * 100) {
-            printf("find : score out of range\n");
+        if (parse_rate(argv[3], &size) || size < HCACHE_SIZE_MIN) {
+            printf("hcache : invalid size, minimum is %"PRIu64"K\n", HCACHE_SIZE_MIN / 1024);
             return WRONG_ARGS;
         }
+    }
 
-        argv_end_indx = (argc-1) - 2;
+    ret = hcache_open(&fp_hcache, argv[1], size);
+    if (ret == HCACHE_BAD_FILE) {
+        printf("hcache : %s is not a cache file, or was made by another version\n", argv[1]);
+        return ret;
     }
-    else {
-        argv_end_indx = argc - 1;
+    if (ret) {
+        printf("hcache : failed to open %s\n", argv[1]);
+        return ret;
     }
 
-    cur_indx = 0;
+    hcache_print_status(&fp_hcache);
 
-    // parse target
-    str = argv[cur_indx];
-    if (        strcmp(str, "entry")    == 0) {
-        target = FIND_TARGET_ENTRY;
+    return 0;
+}
+
+int hashq_cleanup() {
+    return hashing_cleanup("hashq_cleanup");
+}
+
+static void hashq_print_status(dir_info* dir) {
+    database_handle* iter_dh;
+
+    uint64_t total = 0;
+
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        if (iter_dh->pending_num > 0) {
+            printf("%s%.*s : %"PRIu64" queued\n", iter_dh->name, calc_pad(iter_dh->name, PRINT_PAD_SIZE), space_pad, iter_dh->pending_num);
+        }
+        total += iter_dh->pending_num;
     }
-    else if (   strcmp(str, "file")     == 0) {
-        target = FIND_TARGET_FILE;
+
+    printf("hashq : %"PRIu64" file(s) queued, %s\n", total, fp_hash_worker.paused ? "paused" : "hashing while idle");
+    printf("hashq : %"PRIu64" hashed, %"PRIu64" dropped in background so far\n", fp_hash_worker.hashed_num, fp_hash_worker.failed_num);
+}
+
+int hashq(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    int i, j;
+    int ret;
+
+    database_handle* iter_dh;
+
+    dir_info result_dir;
+
+    error_handle er_h;
+
+    str_len_int str_len;
+
+    unsigned char opt_flag[HASHQ_OPT_NUM];
+
+    uint64_t hashed = 0;
+    uint64_t failed = 0;
+
+    int tar_count = 0;
+
+    error_mark_inactive(&er_h);
+    error_mark_owner(&er_h, "hashq");
+
+    if (argc == 0) {
+        hashq_print_status(dir);
+        return 0;
     }
-    else {
-        printf("find : unknown target\n");
+
+    if (        strcmp(argv[0], "pause")    == 0
+            ||  strcmp(argv[0], "resume")   == 0
+       )
+    {
+        if (argc > 1) {
+            printf("hashq : too many arguments\n");
+            return WRONG_ARGS;
+        }
+
+        fp_hash_worker.paused = strcmp(argv[0], "pause") == 0;
+
+        hashq_print_status(dir);
+        return 0;
+    }
+
+    // initialise loose resource pointer
+    file_being_used = NULL;
+    data_being_replaced = NULL;
+
+    if (strcmp(argv[0], "run") == 0) {
+        if (argc > 1) {
+            printf("hashq : too many arguments\n");
+            return WRONG_ARGS;
+        }
+
+        MARK_NEED_CLEANUP();
+
+        for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+            dh_being_used = iter_dh;
+
+            // file data leaves queue whether it is hashed or not
+            while (iter_dh->pending_head) {
+                hash_pending_tree(iter_dh, iter_dh->pending_head->parent_entry, 0, &er_h, &file_being_used, &data_being_replaced, &hashed, &failed);
+            }
+        }
+
+        MARK_NO_NEED_CLEANUP();
+
+        printf("hashq : %"PRIu64" hashed, %"PRIu64" dropped\n", hashed, failed);
+        return 0;
+    }
+
+    if (strcmp(argv[0], "now") != 0) {
+        printf("hashq : unknown argument : %s\n", argv[0]);
         return WRONG_ARGS;
     }
 
-    cur_indx++;
+    for (i = 0; i < HASHQ_OPT_NUM; i++) {
+        opt_flag[i] = 0;
+    }
 
-    // check for the word "in"
-    str = argv[cur_indx];
-    if (strcmp(str, "in") != 0) {
-        printf("find : syntax error - missing \"in\"\n");
+    for (i = 1; i < argc; i++) {
+        if (IS_CHAR_OPTION(argv[i])) {
+            str_len = strlen(argv[i]);
+            for (j = 1; j < str_len; j++) {
+                switch (argv[i][j]) {
+                    case 'r' :
+                        opt_flag[HASHQ_OPT_r] = 1;
+                        break;
+                    default :
+                        printf("hashq : unknown option\n");
+                        return NO_SUCH_OPT;
+                }
+            }
+        }
+        else if (IS_WORD_OPTION(argv[i])) {
+            printf("hashq : unknown option\n");
+            return NO_SUCH_OPT;
+        }
+        else {
+            tar_count++;
+        }
+    }
+
+    if (tar_count == 0) {
+        printf("hashq : too few targets\n");
         return WRONG_ARGS;
     }
 
-    cur_indx++;
+    for (i = 1; i < argc; i++) {
+        if (IS_OPTION(argv[i])) {
+            continue;
+        }
 
-    // parse scope
-    str = argv[cur_indx];
-    if (target == FIND_TARGET_ENTRY) {
-        // parse locator
-        ret = locator_to_dir(info, dir, str, &result_dir, &er_h);
+        ret = locator_to_dir(info, dir, argv[i], &result_dir, &er_h);
         switch (ret) {
-            case 0:
-                // no error
+            case 0 :
+                // do nothing
                 break;
+            case NO_SUCH_LOGIC_DIR:
+                printf("hashq : \"%s\" does not exist\n", argv[i]);
+                return ret;
+            case FOUND_DUPLICATE:
+                printf("hashq : ambiguous target \"%s\"\n", argv[i]);
+                return ret;
             default:
                 error_print_owner_msg(&er_h);
                 error_mark_inactive(&er_h);
                 return ret;
         }
-    }
-    else if (target == FIND_TARGET_FILE) {
-        // check if path is directory
-        path = str;
-        if (stat(path, &file_stat)) {
-            printf("find : failed to get stats of file - file may not exist");
-            return FS_FILE_ACCESS_FAIL;
-        }
 
-        if (        S_ISDIR(file_stat.st_mode)) {
-            ;;  // all good
-        }
-        else if (   S_ISREG(file_stat.st_mode)) {
-            printf("find : specified a file instead of a directory for scope\n");
-            printf("       please use cmp instead for file vs entry comparison\n");
-            printf("       (see help cmp)\n");
-            return WRONG_ARGS;
-        }
-        else {
-            printf("find : unsupported file type\n");
+        if (is_pointing_to_root(&result_dir)) {
+            printf("hashq : cannot hash root directory\n");
             return WRONG_ARGS;
         }
-    }
-    else {
-        printf("find : logical error\n");
-        return LOGIC_ERROR;
-    }
 
-    cur_indx++;
+        MARK_NEED_CLEANUP();
 
-    // check for the word "via"
+        dh_being_used = result_dir.dh;
+
+        hash_pending_tree(result_dir.dh, result_dir.entry, opt_flag[HASHQ_OPT_r], &er_h, &file_being_used, &data_being_replaced, &hashed, &failed);
+
+        MARK_NO_NEED_CLEANUP();
+    }
+
+    printf("hashq : %"PRIu64" hashed, %"PRIu64" dropped\n", hashed, failed);
+
+    return 0;
+}
+
+static void watch_print_status() {
+    watch_stats* batch = &fp_watch.batch;
+    watch_stats* total = &fp_watch.total;
+
+    if (!watch_active(&fp_watch)) {
+        printf("watch : not watching\n");
+        return;
+    }
+
+    printf("watch : %s -> %s : %s\n", fp_watch.root_path, fp_watch.dh->name, fp_watch.root_id_str);
+    printf("watch : %"PRIu64" directories watched\n", fp_watch.dir_num);
+
+    if (fp_watch.first_event_ns) {
+        printf("watch : %"PRIu64" event(s) waiting\n", batch->event_num);
+    }
+    else {
+        printf("watch : last batch : %"PRIu64" changed, %"PRIu64" added, %"PRIu64" deleted, %"PRIu64" moved, %"PRIu64" failed\n", batch->changed_num, batch->added_num, batch->deleted_num, batch->moved_num, batch->failed_num);
+    }
+
+    printf("watch : so far : %"PRIu64" changed, %"PRIu64" added, %"PRIu64" deleted, %"PRIu64" moved, %"PRIu64" failed\n", total->changed_num, total->added_num, total->deleted_num, total->moved_num, total->failed_num);
+
+    if (total->overflow_num) {
+        printf("watch : event queue overflowed %"PRIu64" time(s), affected directories were rescanned\n", total->overflow_num);
+    }
+}
+
+int watch(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    unsigned char applied;
+
+    int ret;
+
+    dir_info result_dir;
+
+    error_handle er_h;
+
+    uint32_t flags;
+
+    error_mark_inactive(&er_h);
+    error_mark_owner(&er_h, "watch");
+
+    if (argc == 0) {
+        watch_print_status();
+        return 0;
+    }
+
+    if (argc == 1 && strcmp(argv[0], "stop") == 0) {
+        if (watch_stop(&fp_watch)) {
+            printf("watch : not watching\n");
+        }
+        else {
+            printf("watch : stopped\n");
+        }
+        return 0;
+    }
+
+    if (argc == 1 && strcmp(argv[0], "sync") == 0) {
+        ret = watch_poll(&fp_watch, 1, &applied);
+        switch (ret) {
+            case 0 :
+                break;
+            case WATCH_NOT_ACTIVE :
+                printf("watch : not watching\n");
+                return ret;
+            case WATCH_ROOT_GONE :
+                printf("watch : watched directory or its entry is gone, stopped watching\n");
+                return ret;
+            default :
+                printf("watch : failed to apply changes, error code : %d\n", ret);
+                return ret;
+        }
+
+        watch_print_status();
+        return 0;
+    }
+
+    if (argc != 2) {
+        printf("watch : wrong number of arguments\n");
+        return WRONG_ARGS;
+    }
+
+    ret = locator_to_dir(info, dir, argv[0], &result_dir, &er_h);
+    switch (ret) {
+        case 0 :
+            break;
+        case NO_SUCH_LOGIC_DIR:
+            printf("watch : \"%s\" does not exist\n", argv[0]);
+            return ret;
+        case FOUND_DUPLICATE:
+            printf("watch : ambiguous target \"%s\"\n", argv[0]);
+            return ret;
+        default:
+            error_print_owner_msg(&er_h);
+            error_mark_inactive(&er_h);
+            return ret;
+    }
+
+    if (is_pointing_to_root(&result_dir) || is_pointing_to_db(&result_dir)) {
+        printf("watch : target is not an entry\n");
+        return WRONG_ARGS;
+    }
+
+    // same as fp, only used if branch has no file to take flags from
+    flags = FPRINT_USE_F_NAME
+        |   FPRINT_USE_F_SIZE
+        |   FPRINT_USE_F_EXTR
+        |   FPRINT_USE_F_SHA1
+        |   FPRINT_USE_F_SHA256
+        |   FPRINT_USE_F_SHA512
+        |   FPRINT_USE_S_EXTR
+        |   FPRINT_USE_S_SHA1
+        |   FPRINT_USE_S_SHA256
+        |   FPRINT_USE_S_SHA512;
+
+    ret = watch_start(&fp_watch, result_dir.dh, result_dir.entry, argv[1], flags, &er_h);
+    if (ret) {
+        error_print_owner_msg(&er_h);
+        error_mark_inactive(&er_h);
+        return ret;
+    }
+
+    watch_print_status();
+
+    return 0;
+}
+
+/* local macros */
+/*  Note on find via extracts :
+ *      extracts of file are read at positions fingerprinting would use,
+ *      and looked up in extract index of each database in scope,
+ *      which gives candidates of the same size and extracts without reading the whole file
+ *
+ *      file is only hashed if whole file checksums are asked for and there is a candidate,
+ *      candidates without a checksum asked for are not taken as matching
+ */
+static void print_cmp_path(linked_entry* root, linked_entry* entry);
+
+static int find_in_scope(const dir_info* scope, linked_entry* entry) {
+    linked_entry* temp_entry;
+
+    if (is_pointing_to_root(scope) || is_pointing_to_db(scope)) {
+        return 1;
+    }
+
+    for (temp_entry = entry; temp_entry; temp_entry = temp_entry->parent) {
+        if (temp_entry == scope->entry) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int find_via_extracts(dir_info* dir, dir_info* scope, const char* path, unsigned char* field_specified) {
+    extract_sample extract[EXTRACT_MAX_NUM];
+    uint32_t extract_num;
+
+    checksum_result checksum[CHECKSUM_MAX_NUM];
+    unsigned char hashed = 0;
+    uint32_t use = 0;
+
+    database_handle* iter_dh;
+    file_data** data_buf;
+    bit_index buf_size = 0;
+    bit_index num_used;
+    bit_index i;
+    uint64_t found = 0;
+
+    const char* name;
+
+    struct stat file_stat;
+    int fd;
+    int ret = 0;
+    int k;
+
+    if (field_specified[FIND_FIELD_F_SHA1]) {
+        use |= FPRINT_USE_F_SHA1;
+    }
+    if (field_specified[FIND_FIELD_F_SHA256]) {
+        use |= FPRINT_USE_F_SHA256;
+    }
+    if (field_specified[FIND_FIELD_F_SHA512]) {
+        use |= FPRINT_USE_F_SHA512;
+    }
+
+    name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("find : failed to open file\n");
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    if (fstat(fd, &file_stat) || sample_file_extracts(fd, file_stat.st_size, extract, &extract_num)) {
+        printf("find : failed to read extracts of file\n");
+        close(fd);
+        return FS_FILE_ACCESS_FAIL;
+    }
+
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        if (iter_dh->extract_index_num > buf_size) {
+            buf_size = iter_dh->extract_index_num;
+        }
+    }
+
+    data_buf = malloc(sizeof(file_data*) * (buf_size ? buf_size : 1));
+    if (!data_buf) {
+        printf("find : failed to allocate memory\n");
+        close(fd);
+        return MALLOC_FAIL;
+    }
+
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        if (!is_pointing_to_root(scope) && iter_dh != scope->dh) {
+            continue;
+        }
+
+        if (lookup_file_extract_via_dh(iter_dh, file_stat.st_size, extract, extract_num, data_buf, buf_size, &num_used) == FIND_FAIL) {
+            continue;
+        }
+
+        for (i = 0; i < num_used; i++) {
+            if (!find_in_scope(scope, data_buf[i]->parent_entry)) {
+                continue;
+            }
+
+            if (field_specified[FIND_FIELD_E_NAME] && strcmp(data_buf[i]->parent_entry->file_name, name) != 0) {
+                continue;
+            }
+
+            if (use && !hashed) {
+                if (checksum_file(fd, use, checksum)) {
+                    printf("find : failed to read file\n");
+                    ret = FS_FILE_ACCESS_FAIL;
+                    goto done;
+                }
+                hashed = 1;
+            }
+
+            for (k = CHECKSUM_SHA1_INDEX; k <= CHECKSUM_SHA512_INDEX; k++) {
+                // checksums not recorded for entry cannot rule it out
+                if (        !(use & (FPRINT_USE_F_SHA1 << k))
+                        ||  data_buf[i]->checksum[k].type == CHECKSUM_UNUSED
+                   )
+                {
+                    continue;
+                }
+
+                if (        data_buf[i]->checksum[k].type != checksum[k].type
+                        ||  memcmp(data_buf[i]->checksum[k].checksum, checksum[k].checksum, checksum[k].len) != 0
+                   )
+                {
+                    break;
+                }
+            }
+            if (k <= CHECKSUM_SHA512_INDEX) {
+                continue;
+            }
+
+            printf("/%s/", iter_dh->name);
+            print_cmp_path(&iter_dh->tree, data_buf[i]->parent_entry);
+            printf("\n");
+            found++;
+        }
+    }
+
+    if (found == 0) {
+        printf("find : no matching entry found\n");
+    }
+    else {
+        printf("find : %"PRIu64" matching entr%s found%s\n", found, found == 1 ? "y" : "ies", hashed ? "" : ", file not hashed");
+    }
+
+done:
+    free(data_buf);
+    close(fd);
+
+    return ret;
+}
+
+/* parses "T", "<T", "<=T", ">T", ">=T" or "T1..T2" into inclusive range [from, to] */
+static int parse_time_range(const char* str, const char* time_format, unsigned char local, int64_t* from, int64_t* to) {
+    struct tm temp_time;
+    const char* end;
+    int64_t time;
+
+    char op = 0;
+    unsigned char or_equal = 0;
+
+    if (*str == '<' || *str == '>') {
+        op = *str++;
+        if (*str == '=') {
+            or_equal = 1;
+            str++;
+        }
+    }
+
+    mem_wipe_sec(&temp_time, sizeof(struct tm));
+    temp_time.tm_isdst = -1;
+    end = strptime(str, time_format, &temp_time);
+    if (!end) {
+        return WRONG_ARGS;
+    }
+    time = local ? mktime(&temp_time) : utc_tm_to_epoch(&temp_time);
+
+    *from = time;
+    *to = time;
+
+    switch (op) {
+        case '<' :
+            *from = INT64_MIN;
+            *to = or_equal ? time : time - 1;
+            break;
+        case '>' :
+            *from = or_equal ? time : time + 1;
+            *to = INT64_MAX;
+            break;
+        default :
+            while (*end == ' ') {
+                end++;
+            }
+            if (strncmp(end, "..", 2) != 0) {
+                break;
+            }
+            end += 2;
+            while (*end == ' ') {
+                end++;
+            }
+
+            mem_wipe_sec(&temp_time, sizeof(struct tm));
+            temp_time.tm_isdst = -1;
+            end = strptime(end, time_format, &temp_time);
+            if (!end) {
+                return WRONG_ARGS;
+            }
+            *to = local ? mktime(&temp_time) : utc_tm_to_epoch(&temp_time);
+            break;
+    }
+
+    if (*end != '\0' || *from > *to) {
+        return WRONG_ARGS;
+    }
+
+    return 0;
+}
+
+/* score is in percent */
+static int find_via_value(term_info* info, dir_info* dir, dir_info* scope, field_record* rec, unsigned int score) {
+    database_handle* iter_dh;
+    linked_entry* temp_entry;
+
+    bit_index i;
+    bit_index temp_index_skip_to, temp_index_result;
+    uint64_t found = 0;
+
+    int ret;
+
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        if (!is_pointing_to_root(scope) && iter_dh != scope->dh) {
+            continue;
+        }
+
+        ret = find_entry_in_sub_branch(iter_dh, scope->entry, rec, 0, &info->match_map, score);
+        if (ret) {
+            printf("find : failed to search database \"%s\"\n", iter_dh->name);
+            return ret;
+        }
+
+        for (i = 0, temp_index_skip_to = 0; i < info->match_map.map_result.number_of_ones; i++) {
+            bitmap_first_one_bit_index(&info->match_map.map_result, &temp_index_result, temp_index_skip_to);
+            temp_index_skip_to = temp_index_result + 1;
+
+            if (get_entry_from_layer2_arr(&iter_dh->l2_entry_arr, &temp_entry, temp_index_result)) {
+                continue;   // slot not used
+            }
+
+            if (!find_in_scope(scope, temp_entry)) {
+                continue;
+            }
+
+            printf("/%s/", iter_dh->name);
+            print_cmp_path(&iter_dh->tree, temp_entry);
+            printf("\n");
+            found++;
+        }
+    }
+
+    if (found == 0) {
+        printf("find : no matching entry found\n");
+    }
+    else {
+        printf("find : %"PRIu64" matching entr%s found\n", found, found == 1 ? "y" : "ies");
+    }
+
+    return 0;
+}
+
+#define find_parse_fields() \
+    for (   /* no initialisation needed */;                         \
+            cur_indx <= argv_end_indx;   /* inclusive */            \
+            cur_indx++                                              \
+        )                                                           \
+    {                                                               \
+        str = argv[cur_indx];                                       \
+        if (        strcmp(str, "all")      == 0) {                 \
+            for (i = 0; i < FIND_FIELD_NUM; i++) {                  \
+                field_specified[i] = 1;                             \
+            }                                                       \
+            break;                                                  \
+        }                                                           \
+        else if (   strcmp(str, "name")     == 0) {                 \
+            if (field_specified[FIND_FIELD_E_NAME]) {               \
+                printf("find : field \"name\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_E_NAME] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "f:size")   == 0) {                 \
+            if (field_specified[FIND_FIELD_F_SIZE]) {               \
+                printf("find : field \"f:size\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_SIZE] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "f:extr")   == 0) {                 \
+            if (field_specified[FIND_FIELD_F_EXTR]) {               \
+                printf("find : field \"f:extr\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_EXTR] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "f:sha1")   == 0) {                 \
+            if (field_specified[FIND_FIELD_F_SHA1]) {               \
+                printf("find : field \"f:sha1\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_SHA1] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "f:sha256") == 0) {                 \
+            if (field_specified[FIND_FIELD_F_SHA256]) {             \
+                printf("find : field \"f:sha256\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_SHA256] = 1;               \
+        }                                                           \
+        else if (   strcmp(str, "f:sha512") == 0) {                 \
+            if (field_specified[FIND_FIELD_F_SHA512]) {             \
+                printf("find : field \"f:sha512\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_SHA512] = 1;               \
+        }                                                           \
+        else if (   strcmp(str, "f:mrkl")   == 0) {                 \
+            if (field_specified[FIND_FIELD_F_MRKL]) {               \
+                printf("find : field \"f:mrkl\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_F_MRKL] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "s:sha1")   == 0) {                 \
+            if (field_specified[FIND_FIELD_S_SHA1]) {               \
+                printf("find : field \"s:sha1\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_S_SHA1] = 1;                 \
+        }                                                           \
+        else if (   strcmp(str, "s:sha256") == 0) {                 \
+            if (field_specified[FIND_FIELD_S_SHA256]) {             \
+                printf("find : field \"s:sha256\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_S_SHA256] = 1;               \
+        }                                                           \
+        else if (   strcmp(str, "s:sha512") == 0) {                 \
+            if (field_specified[FIND_FIELD_S_SHA512]) {             \
+                printf("find : field \"s:sha512\" already specified\n");\
+                return WRONG_ARGS;                                  \
+            }                                                       \
+            field_specified[FIND_FIELD_S_SHA512] = 1;               \
+        }                                                           \
+        else {                                                      \
+            printf("find : unknown field : %s\n", str);             \
+            return WRONG_ARGS;                                      \
+        }                                                           \
+    }
+
+int find(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    int i;
+    int ret;
+
+    const char time_format[] = "%Y-%m-%d_%H:%M:%S";
+
+    int argv_end_indx;  // inclusive
+    int cur_indx;
+
+    int keyval_indx;
+
+    char* str;
+    str_len_int str_len;
+
+    unsigned char has_arrow;
+    char* key;
+    char* val;
+
+    char* path;
+
+    struct stat file_stat;
+
+    float score_float;
+    unsigned int score_uint = 100 * 100;
+
+    dir_info result_dir;
+
+    error_handle er_h;
+
+    unsigned char target;
+
+    unsigned char field_specified[FIND_FIELD_NUM];
+
+    field_record rec;
+
+    mem_wipe_sec(field_specified, sizeof(field_specified));
+
+    error_mark_owner(&er_h, "find");
+
+    mem_wipe_sec(&rec, sizeof(field_record));
+
+    if (argc < 6) {
+        printf("find : too few arguments\n");
+        return WRONG_ARGS;
+    }
+
+    // check if score is specified
+    if (strcmp(argv[(argc-1) -1], "score")  == 0) {
+        if (argc-2 < 6) {
+            printf("find : too few arguments\n");
+            return WRONG_ARGS;
+        }
+
+        // parse score
+        if (sscanf(argv[argc-1], "%f", &score_float) != 1) {
+            printf("find : invalid score\n");
+            return WRONG_ARGS;
+        }
+
+        if (score_float < 0.0 || 100.0 < score_float) {
+            printf("find : score out of range\n");
+            return WRONG_ARGS;
+        }
+
+        // convert to integer
+        score_uint = score_float * 100; // precise to 2 decimal place
+        if (score_uint > 100 * 100) {
+            printf("find : score out of range\n");
+            return WRONG_ARGS;
+        }
+
+        argv_end_indx = (argc-1) - 2;
+    }
+    else {
+        argv_end_indx = argc - 1;
+    }
+
+    cur_indx = 0;
+
+    // parse target
+    str = argv[cur_indx];
+    if (        strcmp(str, "entry")    == 0) {
+        target = FIND_TARGET_ENTRY;
+    }
+    else if (   strcmp(str, "file")     == 0) {
+        target = FIND_TARGET_FILE;
+    }
+    else {
+        printf("find : unknown target\n");
+        return WRONG_ARGS;
+    }
+
+    cur_indx++;
+
+    // check for the word "in"
+    str = argv[cur_indx];
+    if (strcmp(str, "in") != 0) {
+        printf("find : syntax error - missing \"in\"\n");
+        return WRONG_ARGS;
+    }
+
+    cur_indx++;
+
+    // parse scope
+    str = argv[cur_indx];
+    if (target == FIND_TARGET_ENTRY) {
+        // parse locator
+        ret = locator_to_dir(info, dir, str, &result_dir, &er_h);
+        switch (ret) {
+            case 0:
+                // no error
+                break;
+            default:
+                error_print_owner_msg(&er_h);
+                error_mark_inactive(&er_h);
+                return ret;
+        }
+    }
+    else if (target == FIND_TARGET_FILE) {
+        // check if path is directory
+        path = str;
+        if (stat(path, &file_stat)) {
+            printf("find : failed to get stats of file - file may not exist");
+            return FS_FILE_ACCESS_FAIL;
+        }
+
+        if (        S_ISDIR(file_stat.st_mode)) {
+            ;;  // all good
+        }
+        else if (   S_ISREG(file_stat.st_mode)) {
+            printf("find : specified a file instead of a directory for scope\n");
+            printf("       please use cmp instead for file vs entry comparison\n");
+            printf("       (see help cmp)\n");
+            return WRONG_ARGS;
+        }
+        else {
+            printf("find : unsupported file type\n");
+            return WRONG_ARGS;
+        }
+    }
+    else {
+        printf("find : logical error\n");
+        return LOGIC_ERROR;
+    }
+
+    cur_indx++;
+
+    // check for the word "via"
     str = argv[cur_indx];
     if (strcmp(str, "via") != 0) {
         printf("find : syntax error - missing \"via\"\n");
         return WRONG_ARGS;
     }
 
-    cur_indx++;
+    cur_indx++;
+
+    // parse means
+    str = argv[cur_indx];
+    if (        strcmp(str, "file")     == 0) {
+
+        switch (target) {
+            case FIND_TARGET_ENTRY:     // find entry via file
+                // confirm there are at least 2 arguments remaining
+                if (argv_end_indx - cur_indx < 2) {
+                    printf("find : too few arguments\n");
+                    return WRONG_ARGS;
+                }
+
+                cur_indx++;
+
+                // parse path
+                str = argv[cur_indx];
+                path = str;
+                if (stat(path, &file_stat)) {
+                    printf("find : failed to get stats - file may not exist\n");
+                    return WRONG_ARGS;
+                }
+
+                // check if file type is supported
+                if (        !S_ISDIR(file_stat.st_mode)
+                        &&  !S_ISREG(file_stat.st_mode)
+                   )
+                {
+                    printf("find : unsupported file type\n");
+                    return WRONG_ARGS;
+                }
+
+                cur_indx++;
+
+                // parse fields
+                find_parse_fields();
+
+                // fill in field record
+                // does NOT use extract fields
+                // does NOT use section fields
+                if (field_specified[FIND_FIELD_E_NAME]) {
+                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
+                }
+                if (field_specified[FIND_FIELD_F_SIZE]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
+                }
+                if (field_specified[FIND_FIELD_F_SHA1]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
+                }
+                if (field_specified[FIND_FIELD_F_SHA256]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
+                }
+                if (field_specified[FIND_FIELD_F_SHA512]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
+                }
+                if (field_specified[FIND_FIELD_F_MRKL]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_MRKL;
+                }
+
+                // candidates come from extract index, other fields only narrow them down
+                if (field_specified[FIND_FIELD_F_EXTR] && S_ISREG(file_stat.st_mode)) {
+                    return find_via_extracts(dir, &result_dir, path, field_specified);
+                }
+                break;
+            case FIND_TARGET_FILE:      // find file via file
+                printf("find : cannot find file via file\n");
+                printf("       please use external tools for this purpose, such as find\n");
+                return WRONG_ARGS;
+        }
+    }
+    else if (   strcmp(str, "entry")    == 0) {
+        switch (target) {
+            case FIND_TARGET_ENTRY:     // find entry via entry
+                // confirm there are at least 2 arguments remaining
+                if (argv_end_indx - cur_indx < 2) {
+                    printf("find : too few arguments\n");
+                    return WRONG_ARGS;
+                }
+
+                cur_indx++;
+
+                // parse locator
+                str = argv[cur_indx];
+                ret = locator_to_dir(info, dir, str, &result_dir, &er_h);
+                switch (ret) {
+                    case 0:
+                        break;
+                    default:
+                        error_print_owner_msg(&er_h);
+                        error_mark_inactive(&er_h);
+                        return ret;
+                }
+
+                cur_indx++;
+
+                // parse fields
+                find_parse_fields();
+
+                // fill in field record
+                // does NOT use extract fields
+                if (field_specified[FIND_FIELD_E_NAME]) {
+                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
+                }
+                if (field_specified[FIND_FIELD_F_SIZE]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
+                }
+                if (field_specified[FIND_FIELD_F_SHA1]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
+                }
+                if (field_specified[FIND_FIELD_F_SHA256]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
+                }
+                if (field_specified[FIND_FIELD_F_SHA512]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
+                }
+                if (field_specified[FIND_FIELD_F_MRKL]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_MRKL;
+                }
+                if (field_specified[FIND_FIELD_S_SHA1]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA1;
+                }
+                if (field_specified[FIND_FIELD_S_SHA256]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA256;
+                }
+                if (field_specified[FIND_FIELD_S_SHA512]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA512;
+                }
+                break;
+            case FIND_TARGET_FILE:      // find file via entry
+                cur_indx++;
+
+                // parse fields
+                find_parse_fields();
+
+                // fill in field record
+                // use all fields
+                if (field_specified[FIND_FIELD_E_NAME]) {
+                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
+                }
+                if (field_specified[FIND_FIELD_F_SIZE]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
+                }
+                if (field_specified[FIND_FIELD_F_SHA1]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
+                }
+                if (field_specified[FIND_FIELD_F_SHA256]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
+                }
+                if (field_specified[FIND_FIELD_F_SHA512]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
+                }
+                if (field_specified[FIND_FIELD_F_MRKL]) {
+                    rec.field_usage_map |= FIELD_REC_USE_F_MRKL;
+                }
+                if (field_specified[FIND_FIELD_S_SHA1]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA1;
+                }
+                if (field_specified[FIND_FIELD_S_SHA256]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA256;
+                }
+                if (field_specified[FIND_FIELD_S_SHA512]) {
+                    rec.field_usage_map |= FIELD_REC_USE_S_SHA512;
+                }
+                break;
+        }
+    }
+    else if (   strcmp(str, "value")    == 0) {
+        switch (target) {
+            case FIND_TARGET_ENTRY:     // find entry via value
+                cur_indx++;
+
+                // verify all keyval pairs and fill in field record
+                for (keyval_indx = cur_indx; keyval_indx <= argv_end_indx; keyval_indx++) {
+                    str = argv[keyval_indx];
+
+                    ret = parse_keyval_pair(str, &has_arrow, &key, &val);
+                    if (ret) {
+                        if (!has_arrow) {
+                            printf("find : arrow missing in \"%s\"\n", str);
+                            return WRONG_ARGS;
+                        }
+                        else if (key == NULL && val == NULL) {
+                            printf("find : both key and value are missing in \"%s\"\n", str);
+                            return WRONG_ARGS;
+                        }
+                        else if (key == NULL) {
+                            printf("find : key is missing in \"%s\"\n", str);
+                            return WRONG_ARGS;
+                        }
+                        else if (val == NULL) {
+                            printf("find : val is missing in \"%s\"\n", str);
+                            return WRONG_ARGS;
+                        }
+                    }
+
+                    // check if keys exist and if values are valid
+                    if (        strcmp(key, "e:name")           == 0) {
+                        str_len = strlen(val);
+                        if (str_len == 0) {
+                            printf("find : name cannot be empty\n");
+                            return WRONG_ARGS;
+                        }
+                        if (str_len > FILE_NAME_MAX) {
+                            printf("find : name too long\n");
+                            return WRONG_ARGS;
+                        }
+
+                        if (field_specified[FIND_FIELD_E_NAME]) {
+                            printf("find : name already specified\n");
+                            return WRONG_ARGS;
+                        }
+                        field_specified[FIND_FIELD_E_NAME] = 1;
+
+                        strcpy(rec.name, val);
+                        rec.field_usage_map |= FIELD_REC_USE_E_NAME;
+                    }
+                    else if (   strcmp(key, "e:timeaddutc")     == 0
+                            ||  strcmp(key, "e:timeaddloc")     == 0
+                            )
+                    {
+                        if (parse_time_range(val, time_format, strcmp(key, "e:timeaddloc") == 0, &rec.tod_from, &rec.tod_to)) {
+                            printf("find : invalid date time format : %s\n", val);
+                            return WRONG_ARGS;
+                        }
+
+                        if (field_specified[FIND_FIELD_E_TADD]) {
+                            printf("find : time of addition already specified\n");
+                            return WRONG_ARGS;
+                        }
+                        field_specified[FIND_FIELD_E_TADD] = 1;
+
+                        rec.field_usage_map |= FIELD_REC_USE_E_TADD;
+                    }
+                    else if (   strcmp(key, "e:timemodutc")     == 0
+                            ||  strcmp(key, "e:timemodloc")     == 0
+                            )
+                    {
+                        if (parse_time_range(val, time_format, strcmp(key, "e:timemodloc") == 0, &rec.tom_from, &rec.tom_to)) {
+                            printf("find : invalid date time format : %s\n", val);
+                            return WRONG_ARGS;
+                        }
+
+                        if (field_specified[FIND_FIELD_E_TMOD]) {
+                            printf("find : time of modification already specified\n");
+                            return WRONG_ARGS;
+                        }
+                        field_specified[FIND_FIELD_E_TMOD] = 1;
+
+                        rec.field_usage_map |= FIELD_REC_USE_E_TMOD;
+                    }
+                    else if (   strcmp(key, "e:timeusrutc")     == 0
+                            ||  strcmp(key, "e:timeusrloc")     == 0
+                            )
+                    {
+                        if (parse_time_range(val, time_format, strcmp(key, "e:timeusrloc") == 0, &rec.tusr_from, &rec.tusr_to)) {
+                            printf("find : invalid date time format : %s\n", val);
+                            return WRONG_ARGS;
+                        }
+
+                        if (field_specified[FIND_FIELD_E_TUSR]) {
+                            printf("find : user specified time already specified\n");
+                            return WRONG_ARGS;
+                        }
+                        field_specified[FIND_FIELD_E_TUSR] = 1;
+
+                        rec.field_usage_map |= FIELD_REC_USE_E_TUSR;
+                    }
+                    else {
+                        printf("find : unsupported key : %s\n", key);
+                        return WRONG_ARGS;
+                    }
+
+                    repair_keyval_pair(has_arrow, key, val);
+                }
+
+                return find_via_value(info, dir, &result_dir, &rec, score_uint / 100);
+            case FIND_TARGET_FILE:
+                printf("find : cannot find file via value\n");
+                return WRONG_ARGS;
+        }
+    }
+    else {
+        printf("find : unknown means\n");
+        return WRONG_ARGS;
+    }
+
+    // only entry via value and entry via file with f:extr do a search so far
+    printf("find : %s via %s with these fields is not supported yet\n", argv[0], argv[4]);
+    return WRONG_ARGS;
+}
+
+/*  Note on cmp :
+ *      children of both sides are sorted by name and paired up,
+ *      pairs with same tree hash have same name and content all the way down
+ *      (see note on tree digest in ffp_database.h), so the branches below
+ *      them are skipped without being visited
+ *
+ *      the sorted children of all levels being visited are kept in cmp_buf
+ *      as a stack, so an interrupted cmp only leaves one buffer to clean up
+ */
+int cmp_cleanup() {
+    int ret;
+
+    ret = hashing_cleanup("cmp_cleanup");
+
+    free(cmp_buf);
+
+    cmp_buf = NULL;
+    cmp_buf_size = 0;
+
+    return ret;
+}
+
+static int cmp_reserve(size_t size) {
+    linked_entry** temp;
+
+    if (size <= cmp_buf_size) {
+        return 0;
+    }
+
+    size = ffp_max(size, cmp_buf_size * 2);
+
+    SET_NOT_INTERRUPTABLE();
+
+    temp = realloc(cmp_buf, sizeof(linked_entry*) * size);
+    if (temp) {
+        cmp_buf = temp;
+        cmp_buf_size = size;
+    }
+
+    SET_INTERRUPTABLE();
+
+    if (!temp) {
+        return MALLOC_FAIL;
+    }
+
+    return 0;
+}
+
+static int cmp_entry_name(const void* a, const void* b) {
+    return strcmp((*(linked_entry* const*) a)->file_name, (*(linked_entry* const*) b)->file_name);
+}
+
+static void print_cmp_path(linked_entry* root, linked_entry* entry) {
+    if (entry->parent != root) {
+        print_cmp_path(root, entry->parent);
+        printf("/");
+    }
+
+    printf("%s", entry->file_name);
+}
+
+static int same_file_data(file_data* a, file_data* b) {
+    int i;
+
+    if (!a || !b) {
+        return a == b;
+    }
+
+    if (a->file_size != b->file_size) {
+        return 0;
+    }
+
+    for (i = 0; i < CHECKSUM_MAX_NUM; i++) {
+        if (a->checksum[i].type != b->checksum[i].type) {
+            return 0;
+        }
+
+        if (a->checksum[i].type == CHECKSUM_UNUSED) {
+            continue;
+        }
+
+        if (        a->checksum[i].len != b->checksum[i].len
+                ||  memcmp(a->checksum[i].checksum, b->checksum[i].checksum, a->checksum[i].len) != 0
+           )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int cmp_branch(linked_entry* left_root, linked_entry* left, linked_entry* right_root, linked_entry* right, unsigned char recursive, size_t top, uint64_t* stats) {
+    size_t l_start, r_start;
+    size_t l_num, r_num;
+    size_t i, j;
+
+    int order;
+    int ret;
+
+    linked_entry* l_child;
+    linked_entry* r_child;
+
+    l_num = left->child_num;
+    r_num = right->child_num;
+
+    ret = cmp_reserve(top + l_num + r_num);
+    if (ret) {
+        printf("cmp : failed to allocate buffer\n");
+        return ret;
+    }
+
+    l_start = top;
+    r_start = top + l_num;
+
+    memcpy(cmp_buf + l_start, left->child, sizeof(linked_entry*) * l_num);
+    memcpy(cmp_buf + r_start, right->child, sizeof(linked_entry*) * r_num);
+
+    qsort(cmp_buf + l_start, l_num, sizeof(linked_entry*), cmp_entry_name);
+    qsort(cmp_buf + r_start, r_num, sizeof(linked_entry*), cmp_entry_name);
+
+    top += l_num + r_num;
+
+    i = 0;
+    j = 0;
+    while (i < l_num || j < r_num) {
+        // cmp_buf may be moved by deeper levels, so always index from it
+        if (i == l_num) {
+            order = 1;
+        }
+        else if (j == r_num) {
+            order = -1;
+        }
+        else {
+            order = strcmp(cmp_buf[l_start + i]->file_name, cmp_buf[r_start + j]->file_name);
+        }
+
+        if (order < 0) {
+            printf("- ");
+            print_cmp_path(left_root, cmp_buf[l_start + i]);
+            printf("\n");
+
+            stats[CMP_STAT_ONLY_LEFT]++;
+            i++;
+            continue;
+        }
+        else if (order > 0) {
+            printf("+ ");
+            print_cmp_path(right_root, cmp_buf[r_start + j]);
+            printf("\n");
+
+            stats[CMP_STAT_ONLY_RIGHT]++;
+            j++;
+            continue;
+        }
+
+        l_child = cmp_buf[l_start + i];
+        r_child = cmp_buf[r_start + j];
+        i++;
+        j++;
+
+        if (memcmp(l_child->tree_hash, r_child->tree_hash, TREE_DIGEST_LENGTH) == 0) {
+            stats[CMP_STAT_SAME]++;
+            continue;
+        }
+
+        printf("* ");
+        print_cmp_path(left_root, l_child);
+        printf("\n");
+
+        stats[CMP_STAT_DIFFER]++;
+
+        if (recursive) {
+            ret = cmp_branch(left_root, l_child, right_root, r_child, recursive, top, stats);
+            if (ret) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int cmp(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    linked_entry* tar_entry[2];
+    database_handle* tar_dh[2];
+
+    uint64_t hashed = 0;
+    uint64_t failed = 0;
+
+    unsigned char opt_flag[CMP_OPT_NUM];
+
+    uint64_t stats[CMP_STAT_NUM];
+
+    int i, j;
+    int target_count = 0;
+    int ret;
+
+    dir_info result_dir;
+
+    str_len_int str_len;
+
+    error_handle er_h;
+
+    error_mark_inactive(&er_h);
+    error_mark_owner(&er_h, "cmp");
+
+    for (i = 0; i < CMP_OPT_NUM; i++) {
+        opt_flag[i] = 0;
+    }
+
+    for (i = 0; i < CMP_STAT_NUM; i++) {
+        stats[i] = 0;
+    }
+
+    for (i = 0; i < argc; i++) {
+        if (IS_CHAR_OPTION(argv[i])) {
+            str_len = strlen(argv[i]);
+            for (j = 1; j < str_len; j++) {
+                switch (argv[i][j]) {
+                    case 'r' :
+                        opt_flag[CMP_OPT_r] = 1;
+                        break;
+                    default :
+                        printf("cmp : unknown option\n");
+                        return NO_SUCH_OPT;
+                }
+            }
+        }
+        else if (IS_WORD_OPTION(argv[i])) {
+            printf("cmp : unknown option\n");
+            return NO_SUCH_OPT;
+        }
+        else {
+            if (target_count == 2) {
+                printf("cmp : too many targets\n");
+                return WRONG_ARGS;
+            }
+
+            ret = locator_to_dir(info, dir, argv[i], &result_dir, &er_h);
+            switch (ret) {
+                case 0 :
+                    // do nothing
+                    break;
+                case NO_SUCH_LOGIC_DIR:
+                    printf("cmp : \"%s\" does not exist\n", argv[i]);
+                    return ret;
+                case FOUND_DUPLICATE:
+                    printf("cmp : ambiguous target \"%s\"\n", argv[i]);
+                    return ret;
+                default:
+                    error_print_owner_msg(&er_h);
+                    error_mark_inactive(&er_h);
+                    return ret;
+            }
+
+            if (is_pointing_to_root(&result_dir)) {
+                printf("cmp : cannot compare root directory\n");
+                return WRONG_ARGS;
+            }
+
+            tar_dh[target_count] = result_dir.dh;
+            tar_entry[target_count++] = result_dir.entry;
+        }
+    }
+
+    if (target_count < 2) {
+        printf("cmp : too few targets\n");
+        return WRONG_ARGS;
+    }
+
+    // initialise loose resource pointer
+    file_being_used = NULL;
+    data_being_replaced = NULL;
+
+    // queued entries have no checksums yet, so they are hashed before being compared
+    if (tar_dh[0]->pending_num > 0 || tar_dh[1]->pending_num > 0) {
+        MARK_NEED_CLEANUP();
+
+        for (i = 0; i < 2; i++) {
+            dh_being_used = tar_dh[i];
+
+            hash_pending_tree(tar_dh[i], tar_entry[i], opt_flag[CMP_OPT_r], &er_h, &file_being_used, &data_being_replaced, &hashed, &failed);
+        }
+
+        MARK_NO_NEED_CLEANUP();
+
+        if (hashed > 0) {
+            printf("cmp : %"PRIu64" queued file(s) hashed first\n", hashed);
+        }
+    }
+
+    if (!same_file_data(tar_entry[0]->data, tar_entry[1]->data)) {
+        printf("cmp : file data differ\n");
+        stats[CMP_STAT_DIFFER]++;
+    }
+
+    if (memcmp(tar_entry[0]->tree_sum, tar_entry[1]->tree_sum, TREE_DIGEST_LENGTH) != 0) {
+        MARK_NEED_CLEANUP();
+
+        ret = cmp_branch(tar_entry[0], tar_entry[0], tar_entry[1], tar_entry[1], opt_flag[CMP_OPT_r], 0, stats);
+
+        SET_NOT_INTERRUPTABLE();
+
+        cmp_cleanup();
+
+        MARK_NO_NEED_CLEANUP();
+
+        if (ret) {
+            return ret;
+        }
+    }
+
+    if (        stats[CMP_STAT_DIFFER]      == 0
+            &&  stats[CMP_STAT_ONLY_LEFT]   == 0
+            &&  stats[CMP_STAT_ONLY_RIGHT]  == 0
+       )
+    {
+        printf("cmp : identical\n");
+    }
+    else {
+        printf("cmp : %"PRIu64" same, %"PRIu64" differ, %"PRIu64" only in first, %"PRIu64" only in second\n",
+                stats[CMP_STAT_SAME],
+                stats[CMP_STAT_DIFFER],
+                stats[CMP_STAT_ONLY_LEFT],
+                stats[CMP_STAT_ONLY_RIGHT]
+              );
+    }
+
+    return 0;
+}
+
+static int cmp_similar_result(const void* a, const void* b) {
+    const similar_result* x = a;
+    const similar_result* y = b;
+
+    return y->score - x->score;     // most similar first
+}
+
+int similar(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    linked_entry* tar_entry = NULL;
+    database_handle* iter_dh;
+
+    similar_result* results = NULL;
+    bit_index result_num = 0;
+
+    file_data** data_buf = NULL;
+    int* score_buf = NULL;
+    bit_index buf_size = 0;
+    bit_index num_used;
+
+    int min_score = SIMILAR_SCORE_MIN;
+
+    bit_index i;
+    int ret;
+
+    dir_info result_dir;
+
+    error_handle er_h;
+
+    error_mark_inactive(&er_h);
+    error_mark_owner(&er_h, "similar");
+
+    for (i = 0; i < argc; i++) {
+        if (IS_WORD_OPTION(argv[i])) {
+            if (strcmp(argv[i] + 2, "min") != 0) {
+                printf("similar : unknown option\n");
+                return NO_SUCH_OPT;
+            }
+
+            if (i + 1 >= argc) {
+                printf("similar : missing value for %s\n", argv[i]);
+                return WRONG_ARGS;
+            }
+
+            if (        sscanf(argv[i+1], "%d", &min_score) != 1
+                    ||  min_score < 1
+                    ||  min_score > 100
+               )
+            {
+                printf("similar : score out of range\n");
+                return WRONG_ARGS;
+            }
+
+            i++;
+        }
+        else if (IS_CHAR_OPTION(argv[i])) {
+            printf("similar : unknown option\n");
+            return NO_SUCH_OPT;
+        }
+        else {
+            if (tar_entry) {
+                printf("similar : too many targets\n");
+                return WRONG_ARGS;
+            }
+
+            ret = locator_to_dir(info, dir, argv[i], &result_dir, &er_h);
+            switch (ret) {
+                case 0 :
+                    // do nothing
+                    break;
+                case NO_SUCH_LOGIC_DIR:
+                    printf("similar : \"%s\" does not exist\n", argv[i]);
+                    return ret;
+                case FOUND_DUPLICATE:
+                    printf("similar : ambiguous target \"%s\"\n", argv[i]);
+                    return ret;
+                default:
+                    error_print_owner_msg(&er_h);
+                    error_mark_inactive(&er_h);
+                    return ret;
+            }
+
+            if (is_pointing_to_root(&result_dir) || is_pointing_to_db(&result_dir)) {
+                printf("similar : target is not an entry\n");
+                return WRONG_ARGS;
+            }
+
+            tar_entry = result_dir.entry;
+        }
+    }
+
+    if (!tar_entry) {
+        printf("similar : too few targets\n");
+        return WRONG_ARGS;
+    }
+
+    if (!tar_entry->data || tar_entry->data->fuzzy.block_size == 0) {
+        printf("similar : no fuzzy digest recorded for target\n");
+        printf("          please fingerprint with fp --f:fuzzy\n");
+        return WRONG_ARGS;
+    }
+
+    // every file data indexed could be a result, so buffers are sized to the largest index
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        result_num += iter_dh->fuzzy_num;
+        if (iter_dh->fuzzy_num > buf_size) {
+            buf_size = iter_dh->fuzzy_num;
+        }
+    }
+
+    results   = malloc(sizeof(similar_result) * result_num);
+    data_buf  = malloc(sizeof(file_data*) * buf_size);
+    score_buf = malloc(sizeof(int) * buf_size);
+    if (!results || !data_buf || !score_buf) {
+        printf("similar : failed to allocate memory\n");
+        free(results);
+        free(data_buf);
+        free(score_buf);
+        return MALLOC_FAIL;
+    }
+
+    result_num = 0;
+    for (iter_dh = dir->root->db; iter_dh; iter_dh = iter_dh->hh.next) {
+        ret = lookup_file_fuzzy_via_dh(iter_dh, &tar_entry->data->fuzzy, min_score, data_buf, score_buf, buf_size, &num_used);
+        if (ret == FIND_FAIL) {
+            continue;
+        }
+
+        for (i = 0; i < num_used; i++) {
+            if (data_buf[i] == tar_entry->data) {
+                continue;
+            }
+
+            results[result_num].dh = iter_dh;
+            results[result_num].data = data_buf[i];
+            results[result_num].score = score_buf[i];
+            result_num++;
+        }
+    }
+
+    qsort(results, result_num, sizeof(similar_result), cmp_similar_result);
+
+    for (i = 0; i < result_num; i++) {
+        printf("%3d  /%s/", results[i].score, results[i].dh->name);
+        print_cmp_path(&results[i].dh->tree, results[i].data->parent_entry);
+        printf("\n");
+    }
+
+    if (result_num == 0) {
+        printf("similar : no similar file found\n");
+    }
+    else {
+        printf("similar : %"PRIu64" similar file(s) found\n", (uint64_t) result_num);
+    }
+
+    free(results);
+    free(data_buf);
+    free(score_buf);
+
+    return 0;
+}
+
+int reconcile(term_info* info, dir_info* dir, int argc, char* argv[]) {
+    linked_entry* tar_entry = NULL;
+    const char* fs_tar = NULL;
 
-    // parse means
-    str = argv[cur_indx];
-    if (        strcmp(str, "file")     == 0) {
+    reconcile_stats stats;
+    uint32_t opts = 0;
 
-        switch (target) {
-            case FIND_TARGET_ENTRY:     // find entry via file
-                // confirm there are at least 2 arguments remaining
-                if (argv_end_indx - cur_indx < 2) {
-                    printf("find : too few arguments\n");
-                    return WRONG_ARGS;
-                }
+    int i, j;
+    int ret;
 
-                cur_indx++;
+    dir_info result_dir;
 
-                // parse path
-                str = argv[cur_indx];
-                path = str;
-                if (stat(path, &file_stat)) {
-                    printf("find : failed to get stats - file may not exist\n");
-                    return WRONG_ARGS;
-                }
+    str_len_int str_len;
 
-                // check if file type is supported
-                if (        !S_ISDIR(file_stat.st_mode)
-                        &&  !S_ISREG(file_stat.st_mode)
-                   )
-                {
-                    printf("find : unsupported file type\n");
-                    return WRONG_ARGS;
-                }
+    error_handle er_h;
 
-                cur_indx++;
+    error_mark_inactive(&er_h);
+    error_mark_owner(&er_h, "reconcile");
 
-                // parse fields
-                find_parse_fields();
+    // drop rules of last run
+    walk_filter_free(&reconcile_walk_filter);
 
-                // fill in field record
-                // does NOT use extract fields
-                // does NOT use section fields
-                if (field_specified[FIND_FIELD_E_NAME]) {
-                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
-                }
-                if (field_specified[FIND_FIELD_F_SIZE]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
-                }
-                if (field_specified[FIND_FIELD_F_SHA1]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
-                }
-                if (field_specified[FIND_FIELD_F_SHA256]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
-                }
-                if (field_specified[FIND_FIELD_F_SHA512]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
+    memset(&stats, 0, sizeof(reconcile_stats));
+
+    for (i = 0; i < argc; i++) {
+        if (IS_CHAR_OPTION(argv[i])) {
+            str_len = strlen(argv[i]);
+            for (j = 1; j < str_len; j++) {
+                switch (argv[i][j]) {
+                    case 'c' :
+                        opts |= RECONCILE_HASH_MATCHED;
+                        break;
+                    default :
+                        printf("reconcile : unknown option\n");
+                        return NO_SUCH_OPT;
                 }
-                break;
-            case FIND_TARGET_FILE:      // find file via file
-                printf("find : cannot find file via file\n");
-                printf("       please use external tools for this purpose, such as find\n");
-                return WRONG_ARGS;
+            }
         }
-    }
-    else if (   strcmp(str, "entry")    == 0) {
-        switch (target) {
-            case FIND_TARGET_ENTRY:     // find entry via entry
-                // confirm there are at least 2 arguments remaining
-                if (argv_end_indx - cur_indx < 2) {
-                    printf("find : too few arguments\n");
+        else if (IS_WORD_OPTION(argv[i])) {
+            if (strcmp(argv[i] + 2, "exclude") == 0) {
+                if (i + 1 >= argc) {
+                    printf("reconcile : please specify pattern\n");
+                    return WRONG_ARGS;
+                }
+                if (strlen(argv[i+1]) > IGNORE_LINE_MAX) {
+                    printf("reconcile : pattern too long\n");
                     return WRONG_ARGS;
                 }
 
-                cur_indx++;
-
-                // parse locator
-                str = argv[cur_indx];
-                ret = locator_to_dir(info, dir, str, &result_dir, &er_h);
+                ret = walk_filter_add_pattern(&reconcile_walk_filter, argv[i+1]);
                 switch (ret) {
-                    case 0:
+                    case 0 :
                         break;
-                    default:
-                        error_print_owner_msg(&er_h);
-                        error_mark_inactive(&er_h);
+                    case IGNORE_PATTERN_INVALID :
+                        printf("reconcile : invalid pattern : %s\n", argv[i+1]);
+                        return WRONG_ARGS;
+                    default :
+                        printf("reconcile : failed to add pattern\n");
                         return ret;
                 }
 
-                cur_indx++;
-
-                // parse fields
-                find_parse_fields();
+                i++;
+            }
+            else if (strcmp(argv[i] + 2, "no-ignore-file") == 0) {
+                reconcile_walk_filter.use_ignore_file = 0;
+            }
+            else {
+                printf("reconcile : unknown option\n");
+                return NO_SUCH_OPT;
+            }
+        }
+        else if (!tar_entry) {
+            ret = locator_to_dir(info, dir, argv[i], &result_dir, &er_h);
+            switch (ret) {
+                case 0 :
+                    // do nothing
+                    break;
+                case NO_SUCH_LOGIC_DIR:
+                    printf("reconcile : \"%s\" does not exist\n", argv[i]);
+                    return ret;
+                case FOUND_DUPLICATE:
+                    printf("reconcile : ambiguous target \"%s\"\n", argv[i]);
+                    return ret;
+                default:
+                    error_print_owner_msg(&er_h);
+                    error_mark_inactive(&er_h);
+                    return ret;
+            }
 
-                // fill in field record
-                // does NOT use extract fields
-                if (field_specified[FIND_FIELD_E_NAME]) {
-                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
-                }
-                if (field_specified[FIND_FIELD_F_SIZE]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
-                }
-                if (field_specified[FIND_FIELD_F_SHA1]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
-                }
-                if (field_specified[FIND_FIELD_F_SHA256]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
-                }
-                if (field_specified[FIND_FIELD_F_SHA512]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
-                }
-                if (field_specified[FIND_FIELD_S_SHA1]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA1;
-                }
-                if (field_specified[FIND_FIELD_S_SHA256]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA256;
-                }
-                if (field_specified[FIND_FIELD_S_SHA512]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA512;
-                }
-                break;
-            case FIND_TARGET_FILE:      // find file via entry
-                cur_indx++;
+            if (is_pointing_to_root(&result_dir)) {
+                printf("reconcile : cannot reconcile root directory\n");
+                return WRONG_ARGS;
+            }
 
-                // parse fields
-                find_parse_fields();
+            if (result_dir.entry->type != ENTRY_GROUP) {
+                printf("reconcile : \"%s\" is not a group\n", argv[i]);
+                return WRONG_ARGS;
+            }
 
-                // fill in field record
-                // use all fields
-                if (field_specified[FIND_FIELD_E_NAME]) {
-                    rec.field_usage_map |= FIELD_REC_USE_E_NAME;
-                }
-                if (field_specified[FIND_FIELD_F_SIZE]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SIZE;
-                }
-                if (field_specified[FIND_FIELD_F_SHA1]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA1;
-                }
-                if (field_specified[FIND_FIELD_F_SHA256]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA256;
-                }
-                if (field_specified[FIND_FIELD_F_SHA512]) {
-                    rec.field_usage_map |= FIELD_REC_USE_F_SHA512;
-                }
-                if (field_specified[FIND_FIELD_S_SHA1]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA1;
-                }
-                if (field_specified[FIND_FIELD_S_SHA256]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA256;
-                }
-                if (field_specified[FIND_FIELD_S_SHA512]) {
-                    rec.field_usage_map |= FIELD_REC_USE_S_SHA512;
-                }
-                break;
+            tar_entry = result_dir.entry;
+        }
+        else if (!fs_tar) {
+            fs_tar = argv[i];
+        }
+        else {
+            printf("reconcile : too many targets\n");
+            return WRONG_ARGS;
         }
     }
-    else if (   strcmp(str, "value")    == 0) {
-        switch (target) {
-            case FIND_TARGET_ENTRY:     // find entry via value
-                cur_indx++;
 
-                // verify all keyval pairs
-                for (keyval_indx = i; keyval_indx <= argv_end_indx; keyval_indx++) {
-                    str = argv[keyval_indx];
+    if (!fs_tar) {
+        printf("reconcile : too few targets\n");
+        return WRONG_ARGS;
+    }
 
-                    ret = parse_keyval_pair(str, &has_arrow, &key, &val);
-                    if (ret) {
-                        if (!has_arrow) {
-                            printf("find : arrow missing in \"%s\"\n", str);
-                            return WRONG_ARGS;
-                        }
-                        else if (key == NULL && val == NULL) {
-                            printf("find : both key and value are missing in \"%s\"\n", str);
-                            return WRONG_ARGS;
-                        }
-                        else if (key == NULL) {
-                            printf("find : key is missing in \"%s\"\n", str);
-                            return WRONG_ARGS;
-                        }
-                        else if (val == NULL) {
-                            printf("edit : val is missing in \"%s\"\n", str);
-                            return WRONG_ARGS;
-                        }
-                    }
+    if (walk_filter_begin(&reconcile_walk_filter, fs_tar)) {
+        printf("reconcile : failed to get stats - file may not exist\n");
+        return FS_FILE_ACCESS_FAIL;
+    }
 
-                    // check if keys exist and if values are valid
-                    if (        strcmp(key, "e:name")           == 0) {
-                        str_len = strlen(val);
-                        if (str_len == 0) {
-                            printf("find : name cannot be empty\n");
-                            return WRONG_ARGS;
-                        }
-                        if (str_len > FILE_NAME_MAX) {
-                            printf("find : name too long\n");
-                            return WRONG_ARGS;
-                        }
+    MARK_NEED_CLEANUP();
 
-                        if (field_specified[FIND_FIELD_E_NAME]) {
-                            printf("find : name already specified\n");
-                            return WRONG_ARGS;
-                        }
-                        field_specified[FIND_FIELD_E_NAME] = 1;
-                    }
-                    else if (   strcmp(key, "e:timeaddutc")     == 0
-                            ||  strcmp(key, "e:timeaddloc")     == 0
-                            )
-                    {
-                        if (strptime(val, time_format, &temp_time) == NULL) {
-                            printf("find : invalid date time format : %s\n", val);
-                            return WRONG_ARGS;
-                        }
+    ret = reconcile_tree(tar_entry, fs_tar, &reconcile_walk_filter, opts, &stats, &er_h);
 
-                        if (field_specified[FIND_FIELD_E_TADD]) {
-                            printf("find : time of addition already specified\n");
-                            return WRONG_ARGS;
-                        }
-                        field_specified[FIND_FIELD_E_TADD] = 1;
-                    }
+    MARK_NO_NEED_CLEANUP();
 
-                    repair_keyval_pair(has_arrow, key, val);
-                }
-                break;
-            case FIND_TARGET_FILE:
-                printf("find : cannot find file via value\n");
-                return WRONG_ARGS;
-        }
+    walk_filter_free(&reconcile_walk_filter);
+
+    if (ret) {
+        error_print_owner_msg(&er_h);
+        error_mark_inactive(&er_h);
+        return ret;
     }
 
-    return 0;
-}
+    printf("reconcile : %"PRIu64" same, %"PRIu64" changed, %"PRIu64" moved, %"PRIu64" new, %"PRIu64" missing, %"PRIu64" hashed\n",
+            stats.same,
+            stats.changed,
+            stats.moved,
+            stats.new_num,
+            stats.missing,
+            stats.hashed
+          );
 
-int cmp(term_info* info, dir_info* dir, int argc, char* argv[]) {
-    
+    if (stats.ignored || stats.failed) {
+        printf("reconcile : %"PRIu64" ignored, %"PRIu64" could not be read\n", stats.ignored, stats.failed);
+    }
 
     return 0;
 }
@@ -21,8 +21,15 @@
 #include "ffp_file.h"
 #include "ffp_error.h"
 #include "ffp_fingerprint.h"
+#include "ffp_throttle.h"
+#include "ffp_afalg.h"
+#include "ffp_fuzzy.h"
+#include "ffp_watch.h"
+#include "ffp_hcache.h"
+#include "ffp_reconcile.h"
 #include <signal.h>
 #include <setjmp.h>
+#include <fcntl.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 
@@ -32,7 +39,7 @@
 #define SETTING_AMBIG   1
 
 #define FUNC_NAME_MAX           40
-#define FUNC_NUM_MAX            30
+#define FUNC_NUM_MAX            40
 
 #define LOCATOR_LEN_MAX         200
 
@@ -48,6 +55,8 @@
 #define LS_OPT_l        0
 #define LS_OPT_d        1
 
+#define LS_PAGE_SIZE    100
+
 #define CD_OPT_NUM      0
 
 #define CP_OPT_NUM      1
@@ -59,6 +68,17 @@
 #define MV_OPT_NUM      1
 #define MV_OPT_r        0
 
+#define CMP_OPT_NUM     1
+#define CMP_OPT_r       0
+
+#define CMP_STAT_NUM        4
+#define CMP_STAT_SAME       0
+#define CMP_STAT_DIFFER     1
+#define CMP_STAT_ONLY_LEFT  2
+#define CMP_STAT_ONLY_RIGHT 3
+
+#define SIMILAR_SCORE_MIN   1
+
 #define SHOW_MAX_ARG    40
 #define SHOW_ENTRY_MODE 0
 #define SHOW_FILE_MODE  1
@@ -97,7 +117,7 @@
 #define FIND_TARGET_ENTRY   0
 #define FIND_TARGET_FILE    1
 
-#define FIND_FIELD_NUM          14
+#define FIND_FIELD_NUM          15
 #define FIND_FIELD_E_NAME       0
 #define FIND_FIELD_E_TADD       1
 #define FIND_FIELD_E_TMOD       2
@@ -112,6 +132,7 @@
 #define FIND_FIELD_S_SHA1       11
 #define FIND_FIELD_S_SHA256     12
 #define FIND_FIELD_S_SHA512     13
+#define FIND_FIELD_F_MRKL       14
 
 #define ADD_OPT_NUM     16
 #define ADD_OPT_man     0
@@ -130,6 +151,14 @@
 #define FP_OPT_NUM      5
 #define FP_OPT_r        0
 
+#define HASHQ_OPT_NUM   1
+#define HASHQ_OPT_r     0
+
+// deferred hashing while prompt is waiting for input
+#define HASHQ_STEP_SIZE     1048576     // bytes hashed per worker step
+#define HASHQ_SLICE_NS      50000000    // time spent hashing each time readline is idle
+#define HASHQ_TICK_US       10000       // readline idle time before hashing
+
 #define MAKE_MODE_TOUCH     0
 #define MAKE_MODE_MKDIR     1
 
@@ -157,6 +186,7 @@
 typedef struct str_to_func str_to_func;
 typedef struct entry_alias entry_alias;
 typedef struct term_info term_info;
+typedef struct similar_result similar_result;
 
 struct str_to_func {
     char name[FUNC_NAME_MAX];
@@ -176,6 +206,12 @@ struct entry_alias {
     UT_hash_handle hh;
 };
 
+struct similar_result {
+    database_handle* dh;
+    file_data* data;
+    int score;
+};
+
 struct term_info {
     str_to_func func_arr[FUNC_NUM_MAX];
     entry_alias* alias;
@@ -241,11 +277,20 @@ int attach      (term_info* info, dir_info* dir, int argc, char* argv[]);
 int detach      (term_info* info, dir_info* dir, int argc, char* argv[]);
 
 int find        (term_info* info, dir_info* dir, int argc, char* argv[]);
+int cmp_cleanup();
 int cmp         (term_info* info, dir_info* dir, int argc, char* argv[]);
+int similar     (term_info* info, dir_info* dir, int argc, char* argv[]);
+int reconcile   (term_info* info, dir_info* dir, int argc, char* argv[]);
 
 // data collection related
 int fp_cleanup();
 int fp          (term_info* info, dir_info* dir, int argc, char* argv[]);
+int throttle    (term_info* info, dir_info* dir, int argc, char* argv[]);
+int hashbackend (term_info* info, dir_info* dir, int argc, char* argv[]);
+int hcache      (term_info* info, dir_info* dir, int argc, char* argv[]);
+int hashq_cleanup();
+int hashq       (term_info* info, dir_info* dir, int argc, char* argv[]);
+int watch       (term_info* info, dir_info* dir, int argc, char* argv[]);
 int fpwd        (term_info* info, dir_info* dir, int argc, char* argv[]);
 int fls_cleanup();
 int fls         (term_info* info, dir_info* dir, int argc, char* argv[]);
@@ -0,0 +1,259 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// for clock_gettime and nanosleep
+#define _POSIX_C_SOURCE 200809L
+
+#include "ffp_throttle.h"
+
+io_throttle fp_throttle;
+
+int64_t throttle_now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t) ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void throttle_sleep_ns(int64_t ns) {
+    struct timespec ts;
+
+    if (ns <= 0) {
+        return;
+    }
+
+    // keep each sleep short so interrupts and limit changes take effect quickly
+    ns = ffp_min(ns, THROTTLE_SLEEP_MAX_NS);
+
+    ts.tv_sec  = ns / INT64_C(1000000000);
+    ts.tv_nsec = ns % INT64_C(1000000000);
+
+    nanosleep(&ts, NULL);
+
+    fp_throttle.sleep_total_us += ns / 1000;
+}
+
+static uint64_t effective_rate(uint64_t rate) {
+    rate = rate >> fp_throttle.backoff_shift;
+
+    return rate == 0 ? 1 : rate;
+}
+
+// a * b / c without overflow, product is kept in 128 bits
+static int64_t mul_div(int64_t a, int64_t b, int64_t c) {
+    return (int64_t) ((__int128) a * b / c);
+}
+
+// add tokens accumulated since last refill to the bucket, capped at one second worth
+// debt is paid off by elapsed time like any other shortfall, never forgiven
+static void refill_bucket(int64_t* tokens, int64_t* last_refill_ns, uint64_t rate) {
+    int64_t now = throttle_now_ns();
+    int64_t elapsed_ns;
+    int64_t add;
+
+    elapsed_ns = now - *last_refill_ns;
+
+    // long enough to fill the bucket from current balance
+    if (elapsed_ns >= mul_div((int64_t) rate - *tokens, INT64_C(1000000000), (int64_t) rate)) {
+        *tokens = rate;
+        *last_refill_ns = now;
+        return;
+    }
+
+    add = mul_div(elapsed_ns, (int64_t) rate, INT64_C(1000000000));
+    if (add == 0) {
+        // keep the refill point so slow rates still accumulate tokens
+        return;
+    }
+
+    // stays below rate, see above
+    *tokens += add;
+
+    // only advance by the time the added tokens account for
+    *last_refill_ns += mul_div(add, INT64_C(1000000000), (int64_t) rate);
+}
+
+// sleep off any debt in the bucket
+static void pay_debt(int64_t tokens, uint64_t rate) {
+    if (tokens >= 0) {
+        return;
+    }
+
+    throttle_sleep_ns(mul_div(-tokens, INT64_C(1000000000), (int64_t) rate));
+}
+
+int throttle_set(uint64_t bytes_per_sec, uint64_t files_per_sec, uint64_t latency_thres_us) {
+    fp_throttle.bytes_per_sec       = bytes_per_sec;
+    fp_throttle.files_per_sec       = files_per_sec;
+    fp_throttle.latency_thres_us    = latency_thres_us;
+
+    // start with full buckets so changing limits mid job does not stall
+    fp_throttle.byte_tokens = bytes_per_sec;
+    fp_throttle.file_tokens = files_per_sec;
+    fp_throttle.last_byte_refill_ns = throttle_now_ns();
+    fp_throttle.last_file_refill_ns = fp_throttle.last_byte_refill_ns;
+
+    fp_throttle.latency_avg_us = 0;
+    fp_throttle.backoff_shift = 0;
+    fp_throttle.last_adjust_ns = fp_throttle.last_byte_refill_ns;
+
+    __sync_synchronize();
+    fp_throttle.enabled = (bytes_per_sec || files_per_sec || latency_thres_us);
+    __sync_synchronize();
+
+    return 0;
+}
+
+int throttle_off() {
+    __sync_synchronize();
+    fp_throttle.enabled = 0;
+    __sync_synchronize();
+
+    fp_throttle.bytes_per_sec       = 0;
+    fp_throttle.files_per_sec       = 0;
+    fp_throttle.latency_thres_us    = 0;
+    fp_throttle.backoff_shift       = 0;
+
+    return 0;
+}
+
+int throttle_reset_stats() {
+    fp_throttle.bytes_total     = 0;
+    fp_throttle.files_total     = 0;
+    fp_throttle.sleep_total_us  = 0;
+
+    return 0;
+}
+
+int throttle_take_bytes(uint64_t bytes) {
+    if (!fp_throttle.enabled) {
+        return 0;
+    }
+
+    fp_throttle.bytes_total += bytes;
+
+    if (!fp_throttle.bytes_per_sec) {
+        return 0;
+    }
+
+    refill_bucket(&fp_throttle.byte_tokens, &fp_throttle.last_byte_refill_ns, effective_rate(fp_throttle.bytes_per_sec));
+
+    fp_throttle.byte_tokens -= bytes;
+
+    pay_debt(fp_throttle.byte_tokens, effective_rate(fp_throttle.bytes_per_sec));
+
+    return 0;
+}
+
+int throttle_take_file() {
+    if (!fp_throttle.enabled) {
+        return 0;
+    }
+
+    fp_throttle.files_total++;
+
+    if (!fp_throttle.files_per_sec) {
+        return 0;
+    }
+
+    refill_bucket(&fp_throttle.file_tokens, &fp_throttle.last_file_refill_ns, effective_rate(fp_throttle.files_per_sec));
+
+    fp_throttle.file_tokens--;
+
+    pay_debt(fp_throttle.file_tokens, effective_rate(fp_throttle.files_per_sec));
+
+    return 0;
+}
+
+int throttle_record_latency(int64_t latency_ns) {
+    int64_t now;
+    uint64_t latency_us;
+
+    if (!fp_throttle.enabled || !fp_throttle.latency_thres_us) {
+        return 0;
+    }
+
+    latency_us = latency_ns > 0 ? latency_ns / 1000 : 0;
+
+    fp_throttle.latency_avg_us =
+        (fp_throttle.latency_avg_us * THROTTLE_LATENCY_WEIGHT + latency_us)
+        / (THROTTLE_LATENCY_WEIGHT + 1);
+
+    now = throttle_now_ns();
+    if (now - fp_throttle.last_adjust_ns < THROTTLE_ADJUST_INTERVAL_NS) {
+        return 0;
+    }
+    fp_throttle.last_adjust_ns = now;
+
+    if (fp_throttle.latency_avg_us > fp_throttle.latency_thres_us) {
+        if (fp_throttle.backoff_shift < THROTTLE_BACKOFF_MAX) {
+            fp_throttle.backoff_shift++;
+        }
+
+        // if no rate limit is set, latency alone still paces the reads
+        if (!fp_throttle.bytes_per_sec && !fp_throttle.files_per_sec) {
+            throttle_sleep_ns((int64_t) fp_throttle.latency_avg_us * 1000 * fp_throttle.backoff_shift);
+        }
+    }
+    else if (fp_throttle.latency_avg_us < fp_throttle.latency_thres_us / 2) {
+        if (fp_throttle.backoff_shift > 0) {
+            fp_throttle.backoff_shift--;
+        }
+    }
+
+    return 0;
+}
+
+int throttle_print_status() {
+    if (!fp_throttle.enabled) {
+        printf("throttle : off\n");
+    }
+    else {
+        printf("throttle : on\n");
+
+        if (fp_throttle.bytes_per_sec) {
+            printf("    bytes/sec         : %"PRIu64" (effective %"PRIu64")\n", fp_throttle.bytes_per_sec, effective_rate(fp_throttle.bytes_per_sec));
+        }
+        else {
+            printf("    bytes/sec         : unlimited\n");
+        }
+
+        if (fp_throttle.files_per_sec) {
+            printf("    files/sec         : %"PRIu64" (effective %"PRIu64")\n", fp_throttle.files_per_sec, effective_rate(fp_throttle.files_per_sec));
+        }
+        else {
+            printf("    files/sec         : unlimited\n");
+        }
+
+        if (fp_throttle.latency_thres_us) {
+            printf("    latency threshold : %"PRIu64" us\n", fp_throttle.latency_thres_us);
+            printf("    latency average   : %"PRIu64" us\n", fp_throttle.latency_avg_us);
+            printf("    backoff level     : %"PRIu8"\n", fp_throttle.backoff_shift);
+        }
+        else {
+            printf("    latency threshold : none\n");
+        }
+    }
+
+    printf("    bytes read        : %"PRIu64"\n", fp_throttle.bytes_total);
+    printf("    files read        : %"PRIu64"\n", fp_throttle.files_total);
+    printf("    time slept        : %"PRIu64" ms\n", fp_throttle.sleep_total_us / 1000);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+
+#ifndef FFP_THROTTLE_H
+#define FFP_THROTTLE_H
+
+/*  Note on throttling :
+ *      token bucket rate limiting for the fingerprint read path
+ *
+ *      two buckets are kept, one for bytes and one for files,
+ *      a limit of 0 means unlimited
+ *      each bucket holds at most one second worth of tokens
+ *
+ *      if latency threshold is set, read latency is tracked
+ *      as moving average, and the effective rates are halved
+ *      (up to THROTTLE_BACKOFF_MAX times) while the average stays
+ *      above threshold, and restored gradually once it drops
+ *      below half of the threshold
+ *
+ *      callers should only test throttle_active() in hot paths,
+ *      everything else is skipped when throttling is off
+ */
+
+#define THROTTLE_BACKOFF_MAX        6
+#define THROTTLE_ADJUST_INTERVAL_NS INT64_C(100000000)     // 100ms
+#define THROTTLE_SLEEP_MAX_NS       INT64_C(1000000000)    // 1s
+#define THROTTLE_LATENCY_WEIGHT     8   // weight of old value in moving average, out of 8 + 1
+
+#define throttle_active()   (fp_throttle.enabled)
+
+typedef struct io_throttle io_throttle;
+
+struct io_throttle {
+    unsigned char enabled;
+
+    /* limits */
+    uint64_t bytes_per_sec;
+    uint64_t files_per_sec;
+    uint64_t latency_thres_us;
+
+    /* bucket states */
+    int64_t byte_tokens;
+    int64_t file_tokens;
+    int64_t last_byte_refill_ns;
+    int64_t last_file_refill_ns;
+
+    /* latency adaptation */
+    uint64_t latency_avg_us;
+    uint8_t backoff_shift;
+    int64_t last_adjust_ns;
+
+    /* stats */
+    uint64_t bytes_total;
+    uint64_t files_total;
+    uint64_t sleep_total_us;
+};
+
+extern io_throttle fp_throttle;
+
+int64_t throttle_now_ns();
+
+int throttle_set(uint64_t bytes_per_sec, uint64_t files_per_sec, uint64_t latency_thres_us);
+
+int throttle_off();
+
+int throttle_reset_stats();
+
+int throttle_take_bytes(uint64_t bytes);
+
+int throttle_take_file();
+
+int throttle_record_latency(int64_t latency_ns);
+
+int throttle_print_status();
+
+#endif
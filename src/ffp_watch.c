@@ -0,0 +1,1085 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffp_watch.h"
+#include "ffp_throttle.h"
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+
+fs_watch fp_watch = { .fd = -1 };
+
+// for creating entries of new directories
+static int l2_dirp_record_arr_set = 0;
+static layer2_dirp_record_arr l2_dirp_record_arr;
+static bit_index max_dirp_record_index = 0;
+
+static char event_buf[WATCH_EVENT_BUF_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+static int join_path(char* buf, const char* dir, const char* name) {
+    if (strlen(dir) + 1 + strlen(name) > FS_PATH_MAX) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    if (dir[0]) {
+        sprintf(buf, "%s/%s", dir, name);
+    }
+    else {
+        strcpy(buf, name);
+    }
+
+    return 0;
+}
+
+// whether path is rel or below it
+static int path_under(const char* path, const char* rel, size_t rel_len) {
+    if (rel_len == 0) {
+        return 1;
+    }
+
+    return strncmp(path, rel, rel_len) == 0 && (path[rel_len] == 0 || path[rel_len] == '/');
+}
+
+// child of parent with name, found through entries with same file name
+static linked_entry* find_child(database_handle* dh, linked_entry* parent, const char* name) {
+    child_cursor cursor;
+    linked_entry* child;
+    str_id id;
+
+    // name was never interned, so no entry has it
+    if (str_intern_find(&dh->strs, name, strlen(name), &id)) {
+        return NULL;
+    }
+
+    child_cursor_init(&cursor, parent, id);
+    child_cursor_next(&cursor, &child);
+
+    return child;
+}
+
+static void rename_entry(database_handle* dh, linked_entry* entry, const char* name) {
+    del_e_from_fn_to_e_postings(&dh->fn_to_e, &dh->fn_gram, &dh->l2_fn_to_e_arr, entry);
+
+    // old name is kept if the new one cannot be set
+    set_entry_file_name(dh, entry, name);
+
+    link_entry_to_file_name_structures(dh, entry);
+
+    tree_digest_update(entry, 0);
+}
+
+// flags of first file fingerprinted in branch, fallback if none
+static uint32_t branch_flags(linked_entry* entry, uint32_t fallback) {
+    uint32_t flags;
+    ffp_eid_int i;
+
+    if (entry->data && entry->data->resume.flags) {
+        return entry->data->resume.flags;
+    }
+
+    for (i = 0; i < entry->child_num; i++) {
+        flags = branch_flags(entry->child[i], 0);
+        if (flags) {
+            return flags;
+        }
+    }
+
+    return fallback;
+}
+
+/* directory records */
+
+static watch_dir* find_dir_by_path(fs_watch* watch, const char* rel) {
+    watch_dir* wdir;
+
+    HASH_FIND(hh_path, watch->by_path, rel, strlen(rel), wdir);
+
+    return wdir;
+}
+
+// whether directory at rel is the one being watched for it
+static int is_watched(fs_watch* watch, const char* rel, const struct stat* file_stat) {
+    watch_dir* wdir = find_dir_by_path(watch, rel);
+
+    return wdir && wdir->dev == file_stat->st_dev && wdir->ino == file_stat->st_ino;
+}
+
+static void queue_dir(fs_watch* watch, watch_dir* wdir) {
+    if (wdir->queued) {
+        return;
+    }
+
+    wdir->prev_queued = NULL;
+    wdir->next_queued = watch->queue_head;
+    if (watch->queue_head) {
+        watch->queue_head->prev_queued = wdir;
+    }
+    watch->queue_head = wdir;
+
+    wdir->queued = 1;
+}
+
+static void unqueue_dir(fs_watch* watch, watch_dir* wdir) {
+    if (!wdir->queued) {
+        return;
+    }
+
+    if (wdir->prev_queued) {
+        wdir->prev_queued->next_queued = wdir->next_queued;
+    }
+    else {
+        watch->queue_head = wdir->next_queued;
+    }
+    if (wdir->next_queued) {
+        wdir->next_queued->prev_queued = wdir->prev_queued;
+    }
+
+    wdir->prev_queued = NULL;
+    wdir->next_queued = NULL;
+    wdir->queued = 0;
+}
+
+// returns whether name was dirty already
+static int add_dirty_name(watch_dir* wdir, const char* name) {
+    watch_name* wname;
+
+    HASH_FIND_STR(wdir->dirty, name, wname);
+    if (wname) {
+        return 1;
+    }
+
+    wname = malloc(sizeof(watch_name));
+    if (!wname) {
+        return 0;
+    }
+
+    strcpy(wname->name, name);
+    HASH_ADD_STR(wdir->dirty, name, wname);
+
+    return 0;
+}
+
+static int take_dirty_name(watch_dir* wdir, const char* name) {
+    watch_name* wname;
+
+    HASH_FIND_STR(wdir->dirty, name, wname);
+    if (!wname) {
+        return 0;
+    }
+
+    HASH_DEL(wdir->dirty, wname);
+    free(wname);
+
+    return 1;
+}
+
+static void mark_dirty(fs_watch* watch, watch_dir* wdir, const char* name) {
+    add_dirty_name(wdir, name);
+    queue_dir(watch, wdir);
+}
+
+static void drop_dir(fs_watch* watch, watch_dir* wdir, unsigned char rm_watch) {
+    watch_name* wname;
+    watch_name* temp;
+
+    unqueue_dir(watch, wdir);
+
+    HASH_DELETE(hh, watch->by_wd, wdir);
+    HASH_DELETE(hh_path, watch->by_path, wdir);
+
+    if (rm_watch) {
+        inotify_rm_watch(watch->fd, wdir->wd);
+    }
+
+    HASH_ITER(hh, wdir->dirty, wname, temp) {
+        HASH_DEL(wdir->dirty, wname);
+        free(wname);
+    }
+
+    free(wdir->rel_path);
+    free(wdir);
+
+    watch->dir_num--;
+}
+
+// drop directory at rel and everything below it
+static void drop_tree(fs_watch* watch, const char* rel) {
+    watch_dir* wdir;
+    watch_dir* temp;
+
+    size_t rel_len = strlen(rel);
+
+    HASH_ITER(hh, watch->by_wd, wdir, temp) {
+        if (path_under(wdir->rel_path, rel, rel_len)) {
+            drop_dir(watch, wdir, 1);
+        }
+    }
+}
+
+// directory at old_rel and everything below it now sit at new_rel
+static void retarget_tree(fs_watch* watch, const char* old_rel, const char* new_rel) {
+    watch_dir* wdir;
+    watch_dir* temp;
+
+    char* path;
+
+    size_t old_len = strlen(old_rel);
+    size_t new_len = strlen(new_rel);
+
+    HASH_ITER(hh, watch->by_wd, wdir, temp) {
+        if (!path_under(wdir->rel_path, old_rel, old_len)) {
+            continue;
+        }
+
+        path = malloc(new_len + strlen(wdir->rel_path + old_len) + 1);
+        if (!path) {
+            drop_dir(watch, wdir, 1);
+            continue;
+        }
+
+        sprintf(path, "%s%s", new_rel, wdir->rel_path + old_len);
+
+        HASH_DELETE(hh_path, watch->by_path, wdir);
+
+        free(wdir->rel_path);
+        wdir->rel_path = path;
+
+        HASH_ADD_KEYPTR(hh_path, watch->by_path, wdir->rel_path, strlen(wdir->rel_path), wdir);
+    }
+}
+
+static int add_dir(fs_watch* watch, linked_entry* entry, const char* rel, unsigned char rescan, error_handle* er_h) {
+    char path[FS_PATH_MAX+1];
+
+    struct stat file_stat;
+
+    watch_dir* wdir;
+
+    int wd;
+
+    if (join_path(path, watch->root_path, rel)) {
+        return 0;
+    }
+
+    wd = inotify_add_watch(watch->fd, path, WATCH_MASK);
+    if (wd >= 0 && stat(path, &file_stat)) {
+        inotify_rm_watch(watch->fd, wd);
+        return 0;
+    }
+    if (wd < 0) {
+        if (errno == ENOSPC || errno == ENOMEM) {
+            error_write(er_h, "too many directories, see /proc/sys/fs/inotify/max_user_watches");
+            return WATCH_ADD_FAIL;
+        }
+        // gone or not accessible, parent finds out when it is applied
+        return 0;
+    }
+
+    // same directory reached twice, e.g. through a symbolic link
+    HASH_FIND_INT(watch->by_wd, &wd, wdir);
+    if (wdir) {
+        return 0;
+    }
+
+    wdir = malloc(sizeof(watch_dir));
+    if (!wdir) {
+        inotify_rm_watch(watch->fd, wd);
+        error_write(er_h, "failed to allocate memory");
+        return MALLOC_FAIL;
+    }
+
+    memset(wdir, 0, sizeof(watch_dir));
+
+    wdir->rel_path = malloc(strlen(rel) + 1);
+    if (!wdir->rel_path) {
+        inotify_rm_watch(watch->fd, wd);
+        free(wdir);
+        error_write(er_h, "failed to allocate memory");
+        return MALLOC_FAIL;
+    }
+
+    strcpy(wdir->rel_path, rel);
+    bytes_to_hex_str(wdir->entry_id_str, entry->entry_id, EID_LEN);
+
+    wdir->wd = wd;
+    wdir->dev = file_stat.st_dev;
+    wdir->ino = file_stat.st_ino;
+    wdir->rescan = rescan;
+
+    HASH_ADD_INT(watch->by_wd, wd, wdir);
+    HASH_ADD_KEYPTR(hh_path, watch->by_path, wdir->rel_path, strlen(wdir->rel_path), wdir);
+
+    watch->dir_num++;
+
+    if (rescan) {
+        queue_dir(watch, wdir);
+    }
+
+    return 0;
+}
+
+// watch directory of entry and every directory below it
+static int add_tree(fs_watch* watch, linked_entry* entry, const char* rel, unsigned char rescan, error_handle* er_h) {
+    char child_rel[FS_PATH_MAX+1];
+
+    linked_entry* child;
+
+    ffp_eid_int i;
+
+    int ret;
+
+    ret = add_dir(watch, entry, rel, rescan, er_h);
+    if (ret) {
+        return ret;
+    }
+
+    for (i = 0; i < entry->child_num; i++) {
+        child = entry->child[i];
+        if (child->type != ENTRY_GROUP || join_path(child_rel, rel, child->file_name)) {
+            continue;
+        }
+
+        ret = add_tree(watch, child, child_rel, rescan, er_h);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static linked_entry* resolve_path(fs_watch* watch, const char* rel) {
+    char comp[FILE_NAME_MAX+1];
+
+    linked_entry* entry;
+
+    const char* end;
+
+    lookup_entry_id_via_dh(watch->dh, watch->root_id_str, &entry);
+
+    while (entry && *rel) {
+        end = strchr(rel, '/');
+        if (!end) {
+            end = rel + strlen(rel);
+        }
+
+        if (end - rel > FILE_NAME_MAX) {
+            return NULL;
+        }
+
+        memcpy(comp, rel, end - rel);
+        comp[end - rel] = 0;
+
+        entry = find_child(watch->dh, entry, comp);
+        if (!entry || entry->type != ENTRY_GROUP) {
+            return NULL;
+        }
+
+        rel = *end ? end + 1 : end;
+    }
+
+    return entry;
+}
+
+static linked_entry* resolve_dir(fs_watch* watch, watch_dir* wdir) {
+    linked_entry* entry;
+
+    lookup_entry_id_via_dh(watch->dh, wdir->entry_id_str, &entry);
+    if (entry && entry->type == ENTRY_GROUP) {
+        return entry;
+    }
+
+    entry = resolve_path(watch, wdir->rel_path);
+    if (entry) {
+        bytes_to_hex_str(wdir->entry_id_str, entry->entry_id, EID_LEN);
+    }
+
+    return entry;
+}
+
+/* applying changes */
+
+static void delete_child(fs_watch* watch, linked_entry* child, const char* rel) {
+    if (child->type == ENTRY_GROUP) {
+        drop_tree(watch, rel);
+    }
+
+    del_entry(watch->dh, child);
+
+    watch->batch.deleted_num++;
+}
+
+static void close_dirp_records() {
+    dirp_record* temp_dirp_record;
+
+    bit_index i;
+
+    for (i = 0; i < max_dirp_record_index; i++) {
+        if (get_dirp_record_from_layer2_arr(&l2_dirp_record_arr, &temp_dirp_record, i)) {
+            continue;
+        }
+
+        closedir(temp_dirp_record->dirp);
+
+        del_dirp_record_from_layer2_arr(&l2_dirp_record_arr, temp_dirp_record->obj_arr_index);
+    }
+
+    max_dirp_record_index = 0;
+}
+
+static void add_child(fs_watch* watch, linked_entry* parent, const char* path, const char* rel, const char* name, unsigned char is_dir, error_handle* er_h) {
+    char path_buf[FS_PATH_MAX+1];
+
+    linked_entry* entry_being_used = NULL;
+    linked_entry* entry;
+    FILE* file_being_used = NULL;
+
+    int ret;
+
+    if (!l2_dirp_record_arr_set) {
+        init_layer2_dirp_record_arr(&l2_dirp_record_arr);
+        l2_dirp_record_arr_set = 1;
+    }
+
+    strcpy(path_buf, path);
+
+    ret = gen_tree(watch->dh, path_buf, parent, watch->flags, is_dir, NULL, NULL, er_h, &entry_being_used, &file_being_used, &l2_dirp_record_arr, &max_dirp_record_index);
+
+    close_dirp_records();
+
+    if (file_being_used) {
+        fclose(file_being_used);
+    }
+
+    if (ret && entry_being_used) {
+        del_entry(watch->dh, entry_being_used);
+    }
+
+    entry = find_child(watch->dh, parent, name);
+    if (!entry) {
+        watch->batch.failed_num++;
+        return;
+    }
+
+    tree_digest_update(entry, 1);
+
+    watch->batch.added_num++;
+
+    // files created before the new directories were watched are picked up by rescan
+    if (is_dir && add_tree(watch, entry, rel, WATCH_RESCAN_NAMES, er_h)) {
+        watch->batch.failed_num++;
+    }
+}
+
+static void refresh_child(fs_watch* watch, linked_entry* child, const char* path, error_handle* er_h) {
+    char path_buf[FS_PATH_MAX+1];
+
+    FILE* file_being_used = NULL;
+    file_data* data_being_replaced = NULL;
+
+    refresh_stats stats;
+
+    unsigned char old_hash[TREE_DIGEST_LENGTH];
+
+    uint32_t flags;
+
+    int ret;
+
+    memset(&stats, 0, sizeof(stats));
+    memcpy(old_hash, child->tree_hash, TREE_DIGEST_LENGTH);
+
+    flags = child->data && child->data->resume.flags ? child->data->resume.flags : watch->flags;
+    flags &= ~FPRINT_DEFER_HASH;
+
+    strcpy(path_buf, path);
+
+    ret = fingerprint_refresh(watch->dh, path_buf, child, flags, er_h, &file_being_used, &data_being_replaced, &stats);
+    if (ret) {
+        watch->batch.failed_num++;
+        return;
+    }
+
+    // small files are fingerprinted again in full, so only a different digest counts as change
+    tree_digest_update(child, 0);
+    if (memcmp(old_hash, child->tree_hash, TREE_DIGEST_LENGTH) != 0) {
+        watch->batch.changed_num++;
+    }
+}
+
+// bring entry of one dirty name up to date
+static void apply_name(fs_watch* watch, watch_dir* wdir, linked_entry* parent, const char* dir_path, const char* name, error_handle* er_h) {
+    char path[FS_PATH_MAX+1];
+    char rel[FS_PATH_MAX+1];
+
+    struct stat file_stat;
+
+    linked_entry* child;
+
+    if (join_path(path, dir_path, name) || join_path(rel, wdir->rel_path, name)) {
+        watch->batch.failed_num++;
+        return;
+    }
+
+    if (stat(path, &file_stat)) {
+        if (errno != ENOENT && errno != ENOTDIR) {
+            watch->batch.failed_num++;
+            return;
+        }
+        file_stat.st_mode = 0;      // gone
+    }
+
+    child = find_child(watch->dh, parent, name);
+
+    if (S_ISREG(file_stat.st_mode) && child && child->type == ENTRY_FILE) {
+        refresh_child(watch, child, path, er_h);
+        return;
+    }
+
+    // content of a directory still watched is taken care of by its own events
+    if (S_ISDIR(file_stat.st_mode) && child && child->type == ENTRY_GROUP && is_watched(watch, rel, &file_stat)) {
+        return;
+    }
+
+    if (child) {
+        delete_child(watch, child, rel);
+    }
+
+    if (S_ISREG(file_stat.st_mode) || S_ISDIR(file_stat.st_mode)) {
+        add_child(watch, parent, path, rel, name, S_ISDIR(file_stat.st_mode), er_h);
+    }
+}
+
+// mark names which may differ between directory and entry
+static void rescan_dir(fs_watch* watch, watch_dir* wdir, linked_entry* entry, const char* dir_path) {
+    char path[FS_PATH_MAX+1];
+    char rel[FS_PATH_MAX+1];
+
+    struct stat file_stat;
+
+    linked_entry* child;
+
+    DIR* dirp;
+    struct dirent* dp;
+
+    ffp_eid_int i;
+
+    dirp = opendir(dir_path);
+    if (!dirp) {
+        watch->batch.failed_num++;
+        return;
+    }
+
+    while ((dp = readdir(dirp))) {
+        if (        strcmp(dp->d_name, ".")     == 0
+                ||  strcmp(dp->d_name, "..")    == 0
+                ||  strlen(dp->d_name) > FILE_NAME_MAX
+           )
+        {
+            continue;
+        }
+
+        if (wdir->rescan == WATCH_RESCAN_FULL || !find_child(watch->dh, entry, dp->d_name)) {
+            add_dirty_name(wdir, dp->d_name);
+        }
+    }
+
+    closedir(dirp);
+
+    for (i = 0; i < entry->child_num; i++) {
+        child = entry->child[i];
+
+        if (wdir->rescan == WATCH_RESCAN_FULL) {
+            add_dirty_name(wdir, child->file_name);
+            continue;
+        }
+
+        if (join_path(path, dir_path, child->file_name) || join_path(rel, wdir->rel_path, child->file_name)) {
+            continue;
+        }
+
+        if (        stat(path, &file_stat)
+                ||  (S_ISREG(file_stat.st_mode) && child->type != ENTRY_FILE)
+                ||  (S_ISDIR(file_stat.st_mode) && (child->type != ENTRY_GROUP || !is_watched(watch, rel, &file_stat)))
+                ||  (!S_ISREG(file_stat.st_mode) && !S_ISDIR(file_stat.st_mode))
+           )
+        {
+            add_dirty_name(wdir, child->file_name);
+        }
+    }
+}
+
+static void apply_dir(fs_watch* watch, watch_dir* wdir, error_handle* er_h) {
+    char path[FS_PATH_MAX+1];
+    char rel[FS_PATH_MAX+1];
+
+    linked_entry* entry;
+
+    watch_name* wname;
+    watch_name* temp;
+
+    entry = resolve_dir(watch, wdir);
+    if (!entry || join_path(path, watch->root_path, wdir->rel_path)) {
+        // entry went away, e.g. removed by user, directory is no longer followed
+        strcpy(rel, wdir->rel_path);
+        drop_tree(watch, rel);
+        return;
+    }
+
+    if (wdir->rescan) {
+        rescan_dir(watch, wdir, entry, path);
+        wdir->rescan = WATCH_RESCAN_NONE;
+    }
+
+    HASH_ITER(hh, wdir->dirty, wname, temp) {
+        HASH_DEL(wdir->dirty, wname);
+
+        apply_name(watch, wdir, entry, path, wname->name, er_h);
+
+        free(wname);
+    }
+}
+
+// entry moves along with a paired rename, content is not read again
+static void apply_move(fs_watch* watch, watch_move* move, watch_dir* to_dir, const char* to_name) {
+    char old_rel[FS_PATH_MAX+1];
+    char new_rel[FS_PATH_MAX+1];
+
+    watch_dir* from_dir;
+
+    linked_entry* from_parent = NULL;
+    linked_entry* to_parent;
+    linked_entry* src = NULL;
+    linked_entry* old;
+    linked_entry* copy;
+
+    unsigned char is_group;
+
+    HASH_FIND_INT(watch->by_wd, &move->wd, from_dir);
+    if (from_dir) {
+        from_parent = resolve_dir(watch, from_dir);
+    }
+    to_parent = resolve_dir(watch, to_dir);
+    if (from_parent && to_parent) {
+        src = find_child(watch->dh, from_parent, move->name);
+    }
+
+    if (        !src
+            ||  join_path(old_rel, from_dir->rel_path, move->name)
+            ||  join_path(new_rel, to_dir->rel_path, to_name)
+       )
+    {
+        // nothing known about it, looked at like any new name
+        mark_dirty(watch, to_dir, to_name);
+        return;
+    }
+
+    hash_worker_abort();
+
+    is_group = src->type == ENTRY_GROUP;
+
+    old = find_child(watch->dh, to_parent, to_name);
+    if (old) {
+        delete_child(watch, old, new_rel);
+    }
+
+    if (from_parent == to_parent) {
+        rename_entry(watch->dh, src, to_name);
+    }
+    else {
+        if (copy_entry(watch->dh, to_parent, src, 1)) {
+            watch->batch.failed_num++;
+            mark_dirty(watch, to_dir, to_name);
+            return;
+        }
+
+        copy = to_parent->child[to_parent->child_num - 1];
+        if (strcmp(copy->file_name, to_name) != 0) {
+            rename_entry(watch->dh, copy, to_name);
+        }
+
+        del_entry(watch->dh, src);
+    }
+
+    if (is_group) {
+        retarget_tree(watch, old_rel, new_rel);
+    }
+
+    // changes not applied yet move along, anything seen under new name before is replaced
+    take_dirty_name(to_dir, to_name);
+    if (move->was_dirty) {
+        mark_dirty(watch, to_dir, to_name);
+    }
+
+    watch->batch.moved_num++;
+
+    MARK_DB_UNSAVED(watch->dh);
+}
+
+static void mark_overflow(fs_watch* watch, int64_t now_ns) {
+    watch_dir* wdir;
+    watch_dir* temp;
+
+    unsigned char rescan;
+
+    HASH_ITER(hh, watch->by_wd, wdir, temp) {
+        rescan = now_ns - wdir->last_event_ns < WATCH_RECENT_NS ? WATCH_RESCAN_FULL : WATCH_RESCAN_NAMES;
+        if (rescan > wdir->rescan) {
+            wdir->rescan = rescan;
+        }
+        queue_dir(watch, wdir);
+    }
+
+    // names moved from are dirty already, pairs cannot be trusted any more
+    watch->move_num = 0;
+
+    watch->batch.overflow_num++;
+}
+
+static void handle_event(fs_watch* watch, struct inotify_event* event, int64_t now_ns) {
+    watch_dir* wdir;
+    watch_move* move;
+
+    uint32_t i;
+
+    if (!watch->first_event_ns) {
+        memset(&watch->batch, 0, sizeof(watch_stats));
+        watch->first_event_ns = now_ns;
+    }
+    watch->last_event_ns = now_ns;
+
+    watch->batch.event_num++;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+        mark_overflow(watch, now_ns);
+        return;
+    }
+
+    HASH_FIND_INT(watch->by_wd, &event->wd, wdir);
+    if (!wdir) {
+        return;
+    }
+
+    if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        if (wdir->rel_path[0] == 0) {
+            watch->root_gone = 1;
+        }
+        else if (event->mask & IN_IGNORED) {
+            drop_dir(watch, wdir, 0);
+        }
+        // otherwise parent sees the name go away
+        return;
+    }
+
+    // event on the directory itself
+    if (event->len == 0 || event->name[0] == 0) {
+        return;
+    }
+
+    if (strlen(event->name) > FILE_NAME_MAX) {
+        watch->batch.failed_num++;
+        return;
+    }
+
+    wdir->last_event_ns = now_ns;
+
+    if (event->mask & IN_MOVED_TO) {
+        for (i = watch->move_num; i > 0; i--) {
+            move = watch->move + i - 1;
+            if (move->cookie != event->cookie) {
+                continue;
+            }
+
+            apply_move(watch, move, wdir, event->name);
+
+            memmove(move, move + 1, (watch->move_num - i) * sizeof(watch_move));
+            watch->move_num--;
+            return;
+        }
+    }
+
+    if (event->mask & IN_MOVED_FROM) {
+        if (watch->move_num == WATCH_MOVE_MAX) {
+            memmove(watch->move, watch->move + 1, (WATCH_MOVE_MAX - 1) * sizeof(watch_move));
+            watch->move_num--;
+        }
+
+        move = watch->move + watch->move_num;
+        move->cookie = event->cookie;
+        move->wd = event->wd;
+        move->was_dirty = add_dirty_name(wdir, event->name);
+        strcpy(move->name, event->name);
+
+        watch->move_num++;
+    }
+
+    mark_dirty(watch, wdir, event->name);
+}
+
+static int read_events(fs_watch* watch) {
+    struct inotify_event* event;
+
+    ssize_t len;
+    char* pos;
+
+    int64_t now_ns;
+
+    for (;;) {
+        len = read(watch->fd, event_buf, sizeof(event_buf));
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            return FFP_GENERAL_FAIL;
+        }
+        if (len == 0) {
+            return 0;
+        }
+
+        now_ns = throttle_now_ns();
+
+        for (pos = event_buf; pos < event_buf + len; pos += sizeof(struct inotify_event) + event->len) {
+            event = (struct inotify_event*) pos;
+            handle_event(watch, event, now_ns);
+        }
+    }
+}
+
+static int apply_batch(fs_watch* watch) {
+    char cwd[FS_PATH_MAX+1];
+
+    watch_dir* wdir;
+    linked_entry* root;
+
+    watch_stats* batch = &watch->batch;
+    watch_stats* total = &watch->total;
+
+    error_handle er_h;
+
+    int ret = 0;
+
+    error_mark_owner(&er_h, "watch");
+
+    lookup_entry_id_via_dh(watch->dh, watch->root_id_str, &root);
+    if (!root) {
+        watch->root_gone = 1;
+        return 0;
+    }
+
+    // new directories are walked with chdir
+    if (!getcwd(cwd, sizeof(cwd))) {
+        return FFP_GENERAL_FAIL;
+    }
+
+    // partially hashed file is put back before the database is touched
+    hash_worker_abort();
+
+    while ((wdir = watch->queue_head)) {
+        unqueue_dir(watch, wdir);
+        apply_dir(watch, wdir, &er_h);
+    }
+
+    if (chdir(cwd)) {
+        ret = FFP_GENERAL_FAIL;
+    }
+
+    watch->move_num = 0;
+    watch->first_event_ns = 0;
+
+    total->event_num    += batch->event_num;
+    total->changed_num  += batch->changed_num;
+    total->added_num    += batch->added_num;
+    total->deleted_num  += batch->deleted_num;
+    total->moved_num    += batch->moved_num;
+    total->failed_num   += batch->failed_num;
+    total->overflow_num += batch->overflow_num;
+
+    if (batch->changed_num || batch->added_num || batch->deleted_num || batch->moved_num) {
+        MARK_DB_UNSAVED(watch->dh);
+    }
+
+    return ret;
+}
+
+/* interface */
+
+int watch_init(fs_watch* watch) {
+    memset(watch, 0, sizeof(fs_watch));
+
+    watch->fd = -1;
+
+    return 0;
+}
+
+/*  watch_start watches directory at path for entry
+ *
+ *  new files are fingerprinted with flags used for the branch so far,
+ *  given flags are only used if branch has no file yet
+ *
+ *  every directory is compared by names once, so files added or removed
+ *  since branch was fingerprinted are picked up, content of files already
+ *  recorded is not read again
+ */
+int watch_start(fs_watch* watch, database_handle* dh, linked_entry* entry, const char* path, uint32_t flags, error_handle* er_h) {
+    struct stat file_stat;
+
+    linked_entry* temp_entry;
+
+    size_t len;
+
+    int ret;
+
+    error_mark_starter(er_h, "watch_start");
+
+    if (watch_active(watch)) {
+        watch_stop(watch);
+    }
+
+    lookup_entry_id_key_via_dh(dh, entry->entry_id, &temp_entry);
+    if (temp_entry != entry || entry->type != ENTRY_GROUP) {
+        error_write(er_h, "entry is not a group entry");
+        return WRONG_ARGS;
+    }
+
+    if (stat(path, &file_stat) || !S_ISDIR(file_stat.st_mode)) {
+        error_write(er_h, "path is not a directory");
+        return WRONG_ARGS;
+    }
+
+    flags = branch_flags(entry, flags) & ~FPRINT_DEFER_HASH;
+    if (!(flags & FPRINT_USE_F_NAME)) {
+        error_write(er_h, "branch was fingerprinted without file names");
+        return WRONG_ARGS;
+    }
+
+    // made absolute, since new directories are walked with chdir
+    if (path[0] == '/') {
+        if (strlen(path) > FS_PATH_MAX) {
+            error_write(er_h, "path too long");
+            return WRONG_ARGS;
+        }
+        strcpy(watch->root_path, path);
+    }
+    else {
+        if (!getcwd(watch->root_path, sizeof(watch->root_path))) {
+            error_write(er_h, "failed to get current directory");
+            return FFP_GENERAL_FAIL;
+        }
+        len = strlen(watch->root_path);
+        if (len + 1 + strlen(path) > FS_PATH_MAX) {
+            error_write(er_h, "path too long");
+            return WRONG_ARGS;
+        }
+        sprintf(watch->root_path + len, "/%s", path);
+    }
+
+    len = strlen(watch->root_path);
+    while (len > 1 && watch->root_path[len-1] == '/') {
+        watch->root_path[--len] = 0;
+    }
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd < 0) {
+        error_write(er_h, "failed to initialise inotify");
+        watch->fd = -1;
+        return WATCH_ADD_FAIL;
+    }
+
+    watch->dh = dh;
+    bytes_to_hex_str(watch->root_id_str, entry->entry_id, EID_LEN);
+    watch->flags = flags;
+
+    ret = add_tree(watch, entry, "", WATCH_RESCAN_NAMES, er_h);
+    if (ret) {
+        watch_stop(watch);
+        return ret;
+    }
+
+    watch->first_event_ns = throttle_now_ns();
+    watch->last_event_ns = watch->first_event_ns;
+
+    return 0;
+}
+
+int watch_stop(fs_watch* watch) {
+    watch_dir* wdir;
+    watch_dir* temp;
+
+    if (!watch_active(watch)) {
+        return WATCH_NOT_ACTIVE;
+    }
+
+    HASH_ITER(hh, watch->by_wd, wdir, temp) {
+        drop_dir(watch, wdir, 0);
+    }
+
+    // closing removes every watch
+    close(watch->fd);
+
+    return watch_init(watch);
+}
+
+int watch_active(fs_watch* watch) {
+    return watch->dh != NULL;
+}
+
+/*  watch_poll reads events waiting and applies them once batch is due,
+ *  or right away if force is set
+ *
+ *  watch is stopped and WATCH_ROOT_GONE returned if watched directory
+ *  or its entry is gone
+ */
+int watch_poll(fs_watch* watch, unsigned char force, unsigned char* applied) {
+    int64_t now_ns;
+
+    int ret;
+
+    *applied = 0;
+
+    if (!watch_active(watch)) {
+        return WATCH_NOT_ACTIVE;
+    }
+
+    ret = read_events(watch);
+    if (ret) {
+        return ret;
+    }
+
+    if (!watch->root_gone && watch->first_event_ns) {
+        now_ns = throttle_now_ns();
+
+        if (        force
+                ||  now_ns - watch->last_event_ns >= WATCH_SETTLE_NS
+                ||  now_ns - watch->first_event_ns >= WATCH_DELAY_MAX_NS
+           )
+        {
+            ret = apply_batch(watch);
+            *applied = 1;
+        }
+    }
+
+    if (watch->root_gone) {
+        watch_stop(watch);
+        return WATCH_ROOT_GONE;
+    }
+
+    return ret;
+}
@@ -0,0 +1,166 @@
+/*  Copyright (c) 2016 Darrenldl All rights reserved.
+ *
+ *  This file is part of ffprinter
+ *
+ *  ffprinter is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ffprinter is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ffprinter.h"
+#include "ffp_database.h"
+#include "ffp_fingerprint.h"
+#include "ffp_error.h"
+#include <sys/stat.h>
+
+#ifndef FFP_WATCH_H
+#define FFP_WATCH_H
+
+/*  Note on watch :
+ *      keeps a branch in sync with the directory it was fingerprinted from,
+ *      using one inotify watch per directory of the branch
+ *
+ *      events only mark names of a directory as dirty, nothing is read
+ *      until events stop coming for WATCH_SETTLE_NS, or the oldest event
+ *      is WATCH_DELAY_MAX_NS old, so a file written many times in a burst
+ *      is fingerprinted once, applying a batch then stats each dirty name
+ *          gone                    entry is deleted
+ *          file, entry exists      entry is refreshed (see fingerprint_refresh)
+ *          otherwise               entry is created (see gen_tree)
+ *
+ *      renames are paired by cookie of moved from and moved to events,
+ *      and the entry is renamed (or copied over if parent changed) without
+ *      reading content again, a move without its pair is only seen
+ *      as a name going away or coming in
+ *
+ *      if the event queue overflows, events are lost without telling where,
+ *      directories with events in the last WATCH_RECENT_NS are compared in full
+ *      (every file refreshed), all other directories only by names present
+ *
+ *      directories are recorded by path relative to watched directory and
+ *      entry id of their group entry, entry id is only a shortcut, when it
+ *      no longer resolves (e.g. entry copied over) the path is followed instead
+ */
+
+#define WATCH_SETTLE_NS         INT64_C(500000000)      // quiet time before batch is applied
+#define WATCH_DELAY_MAX_NS      INT64_C(5000000000)     // batch is applied by then however busy
+#define WATCH_RECENT_NS         INT64_C(10000000000)    // see queue overflow above
+
+#define WATCH_EVENT_BUF_SIZE    65536
+#define WATCH_MOVE_MAX          64      // moved from events waiting for their pair
+
+// attribute changes are left out, they do not change content
+#define WATCH_MASK      (   IN_CREATE       | IN_DELETE     | IN_MODIFY     \
+                        |   IN_CLOSE_WRITE  | IN_MOVED_FROM | IN_MOVED_TO   \
+                        |   IN_DELETE_SELF  | IN_MOVE_SELF  | IN_ONLYDIR    )
+
+// rescan of a directory
+#define WATCH_RESCAN_NONE       0
+#define WATCH_RESCAN_NAMES      1   // names added or gone only
+#define WATCH_RESCAN_FULL       2   // every file refreshed as well
+
+#define WATCH_NOT_ACTIVE        710
+#define WATCH_ADD_FAIL          711
+#define WATCH_ROOT_GONE         712
+
+typedef struct watch_name watch_name;
+typedef struct watch_dir watch_dir;
+typedef struct watch_move watch_move;
+typedef struct watch_stats watch_stats;
+typedef struct fs_watch fs_watch;
+
+struct watch_name {
+    char name[FILE_NAME_MAX+1];
+
+    UT_hash_handle hh;
+};
+
+struct watch_dir {
+    int wd;
+
+    char* rel_path;     // empty for watched directory
+    char entry_id_str[EID_STR_MAX+1];
+
+    // watch follows the directory if it is moved away, so what is at rel_path is checked against it
+    dev_t dev;
+    ino_t ino;
+
+    watch_name* dirty;      // names with events not applied yet
+    unsigned char rescan;
+
+    int64_t last_event_ns;
+
+    // directories to visit in next batch
+    unsigned char queued;
+    watch_dir* prev_queued;
+    watch_dir* next_queued;
+
+    UT_hash_handle hh;          // by wd
+    UT_hash_handle hh_path;     // by rel_path
+};
+
+struct watch_move {
+    uint32_t cookie;
+    int wd;
+    unsigned char was_dirty;
+    char name[FILE_NAME_MAX+1];
+};
+
+struct watch_stats {
+    uint64_t event_num;
+    uint64_t changed_num;
+    uint64_t added_num;
+    uint64_t deleted_num;
+    uint64_t moved_num;
+    uint64_t failed_num;
+    uint64_t overflow_num;
+};
+
+struct fs_watch {
+    int fd;     // -1 if not watching
+
+    database_handle* dh;
+    char root_path[FS_PATH_MAX+1];      // absolute
+    char root_id_str[EID_STR_MAX+1];
+    uint32_t flags;     // for new files, changed files keep flags they were fingerprinted with
+
+    watch_dir* by_wd;
+    watch_dir* by_path;
+    uint64_t dir_num;
+
+    watch_dir* queue_head;
+
+    watch_move move[WATCH_MOVE_MAX];
+    uint32_t move_num;
+
+    int64_t first_event_ns;     // 0 if nothing is waiting
+    int64_t last_event_ns;
+
+    unsigned char root_gone;
+
+    watch_stats batch;      // last batch applied
+    watch_stats total;
+};
+
+extern fs_watch fp_watch;
+
+int watch_init(fs_watch* watch);
+
+int watch_start(fs_watch* watch, database_handle* dh, linked_entry* entry, const char* path, uint32_t flags, error_handle* er_h);
+
+int watch_stop(fs_watch* watch);
+
+int watch_active(fs_watch* watch);
+
+int watch_poll(fs_watch* watch, unsigned char force, unsigned char* applied);
+
+#endif
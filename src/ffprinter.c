@@ -56,6 +56,1096 @@ int init_uniq_char_map (uniq_char_map* uniq_char) {
     return 0;
 }
 
+/* String interning */
+// shared by all empty strings of entries, never written to or freed
+static char empty_entry_str[1];
+
+// FNV-1a
+static uint32_t str_intern_hash (const char* str, str_len_int len) {
+    uint32_t hash = UINT32_C(0x811c9dc5);
+
+    str_len_int i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char) str[i]) * UINT32_C(0x01000193);
+    }
+
+    return hash;
+}
+
+// slot holding id of str, or the free slot it would go into
+static uint32_t str_intern_probe (const str_intern* strs, const char* str, str_len_int len, uint32_t hash) {
+    uint32_t mask = strs->slot_num - 1;
+    uint32_t i = hash & mask;
+
+    const str_intern_rec* rec;
+
+    while (strs->slot[i]) {
+        rec = strs->rec + strs->slot[i] - 1;
+        if (rec->hash == hash && rec->len == len && memcmp(rec->str, str, len) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+static int str_intern_grow_slot (str_intern* strs) {
+    uint32_t* old_slot = strs->slot;
+    uint32_t old_slot_num = strs->slot_num;
+
+    uint32_t* temp_slot;
+
+    uint32_t i, j, mask;
+
+    temp_slot = calloc((size_t) old_slot_num * 2, sizeof(uint32_t));
+    if (!temp_slot) {
+        return MALLOC_FAIL;
+    }
+
+    strs->slot = temp_slot;
+    strs->slot_num = old_slot_num * 2;
+    mask = strs->slot_num - 1;
+
+    // ids are unique so no comparison is needed
+    for (i = 0; i < old_slot_num; i++) {
+        if (old_slot[i]) {
+            j = strs->rec[old_slot[i] - 1].hash & mask;
+            while (temp_slot[j]) {
+                j = (j + 1) & mask;
+            }
+            temp_slot[j] = old_slot[i];
+        }
+    }
+
+    free(old_slot);
+
+    return 0;
+}
+
+int init_str_intern (str_intern* strs) {
+    if (!strs) {
+        return WRONG_ARGS;
+    }
+
+    strs->rec_size = STR_INTERN_INIT_SLOT_NUM / 2;
+    strs->rec = malloc(strs->rec_size * sizeof(str_intern_rec));
+    if (!strs->rec) {
+        return MALLOC_FAIL;
+    }
+
+    strs->slot_num = STR_INTERN_INIT_SLOT_NUM;
+    strs->slot = calloc(strs->slot_num, sizeof(uint32_t));
+    if (!strs->slot) {
+        free(strs->rec);
+        strs->rec = NULL;
+        return MALLOC_FAIL;
+    }
+
+    strs->chunk = NULL;
+
+    // empty string takes STR_ID_EMPTY, it is never looked up through slots
+    strs->rec[STR_ID_EMPTY].str = empty_entry_str;
+    strs->rec[STR_ID_EMPTY].len = 0;
+    strs->rec[STR_ID_EMPTY].hash = str_intern_hash(empty_entry_str, 0);
+    strs->rec_num = 1;
+
+    return 0;
+}
+
+int str_intern_add (str_intern* strs, const char* str, str_len_int len, str_id* id) {
+    str_intern_rec* temp_rec;
+    str_intern_chunk* temp_chunk;
+
+    uint32_t hash;
+    uint32_t i;
+
+    if (!strs || !str || !id) {
+        return WRONG_ARGS;
+    }
+    if (len + 1 > STR_INTERN_CHUNK_SIZE) {
+        return WRONG_ARGS;
+    }
+
+    if (len == 0) {
+        *id = STR_ID_EMPTY;
+        return 0;
+    }
+
+    hash = str_intern_hash(str, len);
+
+    i = str_intern_probe(strs, str, len, hash);
+    if (strs->slot[i]) {
+        *id = strs->slot[i] - 1;
+        return 0;
+    }
+
+    // grow records
+    if (strs->rec_num == strs->rec_size) {
+        if (strs->rec_size > UINT32_MAX / 2) {
+            return MALLOC_FAIL;
+        }
+        temp_rec = realloc(strs->rec, (size_t) strs->rec_size * 2 * sizeof(str_intern_rec));
+        if (!temp_rec) {
+            return MALLOC_FAIL;
+        }
+        strs->rec = temp_rec;
+        strs->rec_size *= 2;
+    }
+
+    // copy string into chunk
+    if (!strs->chunk || strs->chunk->used + len + 1 > STR_INTERN_CHUNK_SIZE) {
+        temp_chunk = malloc(sizeof(str_intern_chunk));
+        if (!temp_chunk) {
+            return MALLOC_FAIL;
+        }
+        temp_chunk->next = strs->chunk;
+        temp_chunk->used = 0;
+        strs->chunk = temp_chunk;
+    }
+    temp_rec = strs->rec + strs->rec_num;
+    temp_rec->str = strs->chunk->data + strs->chunk->used;
+    memcpy(strs->chunk->data + strs->chunk->used, str, len);
+    strs->chunk->data[strs->chunk->used + len] = 0;
+    strs->chunk->used += len + 1;
+
+    temp_rec->len = len;
+    temp_rec->hash = hash;
+
+    strs->slot[i] = strs->rec_num + 1;
+    *id = strs->rec_num;
+    strs->rec_num++;
+
+    // keep load factor at most half
+    if (strs->rec_num * 2 > strs->slot_num) {
+        return str_intern_grow_slot(strs);
+    }
+
+    return 0;
+}
+
+int str_intern_find (const str_intern* strs, const char* str, str_len_int len, str_id* id) {
+    uint32_t i;
+
+    if (!strs || !str || !id) {
+        return WRONG_ARGS;
+    }
+
+    if (len == 0) {
+        *id = STR_ID_EMPTY;
+        return 0;
+    }
+
+    i = str_intern_probe(strs, str, len, str_intern_hash(str, len));
+    if (!strs->slot[i]) {
+        return FIND_FAIL;
+    }
+
+    *id = strs->slot[i] - 1;
+
+    return 0;
+}
+
+int fres_str_intern (str_intern* strs) {
+    str_intern_chunk* temp_chunk;
+
+    if (!strs) {
+        return WRONG_ARGS;
+    }
+
+    while (strs->chunk) {
+        temp_chunk = strs->chunk;
+        strs->chunk = temp_chunk->next;
+        free(temp_chunk);
+    }
+
+    free(strs->rec);
+    free(strs->slot);
+    strs->rec = NULL;
+    strs->slot = NULL;
+    strs->rec_num = 0;
+    strs->rec_size = 0;
+    strs->slot_num = 0;
+
+    return 0;
+}
+
+/* Gram index */
+#define GRAM_VARINT_MAX     10  // bytes of uint64_t in varint
+
+static uint32_t gram_key (const char* str) {
+    return    ((uint32_t) (unsigned char) str[0] << 16)
+            | ((uint32_t) (unsigned char) str[1] << 8)
+            |  (uint32_t) (unsigned char) str[2];
+}
+
+static uint32_t gram_put_varint (unsigned char* dst, uint64_t val) {
+    uint32_t len = 0;
+
+    while (val >= 0x80) {
+        dst[len++] = (unsigned char) (val | 0x80);
+        val >>= 7;
+    }
+    dst[len++] = (unsigned char) val;
+
+    return len;
+}
+
+static uint32_t gram_get_varint (const unsigned char* src, uint64_t* val) {
+    uint32_t len = 0;
+    uint32_t shift = 0;
+    uint64_t temp = 0;
+
+    do {
+        temp |= (uint64_t) (src[len] & 0x7F) << shift;
+        shift += 7;
+    } while (src[len++] & 0x80);
+
+    *val = temp;
+
+    return len;
+}
+
+static uint32_t gram_block_decode (const gram_block* block, bit_index* val) {
+    uint32_t i, pos;
+    uint64_t gap;
+
+    val[0] = block->first;
+    for (i = 1, pos = 0; i < block->num; i++) {
+        pos += gram_get_varint(block->gap + pos, &gap);
+        val[i] = val[i-1] + gap;
+    }
+
+    return block->num;
+}
+
+// num must be larger than 0
+static int gram_block_encode (gram_block* block, const bit_index* val, uint32_t num) {
+    unsigned char buf[GRAM_BLOCK_MAX * GRAM_VARINT_MAX];
+    unsigned char* temp;
+
+    uint32_t i, len;
+
+    for (i = 1, len = 0; i < num; i++) {
+        len += gram_put_varint(buf + len, val[i] - val[i-1]);
+    }
+
+    if (len > block->max) {
+        temp = realloc(block->gap, len);
+        if (!temp) {
+            return MALLOC_FAIL;
+        }
+        block->gap = temp;
+        block->max = len;
+    }
+    if (len) {
+        memcpy(block->gap, buf, len);
+    }
+
+    block->first = val[0];
+    block->last = val[num-1];
+    block->num = num;
+    block->len = len;
+
+    return 0;
+}
+
+// id must be larger than last index of block
+static int gram_block_append (gram_block* block, bit_index id) {
+    unsigned char buf[GRAM_VARINT_MAX];
+    unsigned char* temp;
+
+    uint32_t len;
+    uint32_t new_max;
+
+    len = gram_put_varint(buf, id - block->last);
+
+    if (block->len + len > block->max) {
+        new_max = block->max ? block->max * 2 : 8;
+        while (new_max < block->len + len) {
+            new_max *= 2;
+        }
+        temp = realloc(block->gap, new_max);
+        if (!temp) {
+            return MALLOC_FAIL;
+        }
+        block->gap = temp;
+        block->max = new_max;
+    }
+
+    memcpy(block->gap + block->len, buf, len);
+    block->len += len;
+    block->num++;
+    block->last = id;
+
+    return 0;
+}
+
+// last block with first index not larger than id, or 0 if none, posting must have a block
+static uint32_t gram_find_block (const gram_posting* post, bit_index id) {
+    uint32_t lo = 0;
+    uint32_t hi = post->block_num;
+    uint32_t mid;
+
+    while (hi - lo > 1) {
+        mid = lo + (hi - lo) / 2;
+        if (post->block[mid].first <= id) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static int gram_insert_block (gram_posting* post, uint32_t at) {
+    gram_block* temp;
+
+    uint32_t new_max;
+
+    if (post->block_num == post->block_max) {
+        new_max = post->block_max ? post->block_max * 2 : 1;
+        temp = realloc(post->block, new_max * sizeof(gram_block));
+        if (!temp) {
+            return MALLOC_FAIL;
+        }
+        post->block = temp;
+        post->block_max = new_max;
+    }
+
+    memmove(post->block + at + 1, post->block + at, (post->block_num - at) * sizeof(gram_block));
+    memset(post->block + at, 0, sizeof(gram_block));
+    post->block_num++;
+
+    return 0;
+}
+
+static int gram_posting_add (gram_posting* post, bit_index id) {
+    bit_index val[GRAM_BLOCK_MAX + 1];
+
+    gram_block* block;
+
+    uint32_t b, i, num;
+
+    int ret;
+
+    if (post->block_num == 0) {
+        if ((ret = gram_insert_block(post, 0))) {
+            return ret;
+        }
+        post->block[0].first = id;
+        post->block[0].last = id;
+        post->block[0].num = 1;
+        post->num = 1;
+        return 0;
+    }
+
+    b = gram_find_block(post, id);
+    block = post->block + b;
+
+    if (id == block->last) {    // already in list
+        return 0;
+    }
+
+    // common case, new index goes after last index of block
+    if (id > block->last && (block->num < GRAM_BLOCK_MAX || b == post->block_num - 1)) {
+        if (block->num < GRAM_BLOCK_MAX) {
+            if ((ret = gram_block_append(block, id))) {
+                return ret;
+            }
+        }
+        else {  // start new block at the end
+            if ((ret = gram_insert_block(post, b + 1))) {
+                return ret;
+            }
+            block = post->block + b + 1;
+            block->first = id;
+            block->last = id;
+            block->num = 1;
+        }
+        post->num++;
+        return 0;
+    }
+
+    num = gram_block_decode(block, val);
+    for (i = 0; i < num && val[i] < id; i++) {
+        ;;
+    }
+    if (i < num && val[i] == id) {
+        return 0;
+    }
+    memmove(val + i + 1, val + i, (num - i) * sizeof(bit_index));
+    val[i] = id;
+    num++;
+
+    if (num <= GRAM_BLOCK_MAX) {
+        if ((ret = gram_block_encode(block, val, num))) {
+            return ret;
+        }
+    }
+    else {  // split block in half
+        if ((ret = gram_insert_block(post, b + 1))) {
+            return ret;
+        }
+        if ((ret = gram_block_encode(post->block + b, val, num / 2))) {
+            return ret;
+        }
+        if ((ret = gram_block_encode(post->block + b + 1, val + num / 2, num - num / 2))) {
+            return ret;
+        }
+    }
+
+    post->num++;
+
+    return 0;
+}
+
+static int gram_posting_del (gram_posting* post, bit_index id) {
+    bit_index val[GRAM_BLOCK_MAX];
+
+    gram_block* block;
+
+    uint32_t b, i, num;
+
+    if (post->block_num == 0) {
+        return FIND_FAIL;
+    }
+
+    b = gram_find_block(post, id);
+    block = post->block + b;
+
+    if (id < block->first || id > block->last) {
+        return FIND_FAIL;
+    }
+
+    num = gram_block_decode(block, val);
+    for (i = 0; i < num && val[i] < id; i++) {
+        ;;
+    }
+    if (i == num || val[i] != id) {
+        return FIND_FAIL;
+    }
+    memmove(val + i, val + i + 1, (num - i - 1) * sizeof(bit_index));
+    num--;
+
+    if (num == 0) {
+        free(block->gap);
+        memmove(post->block + b, post->block + b + 1, (post->block_num - b - 1) * sizeof(gram_block));
+        post->block_num--;
+    }
+    else {
+        // does not grow, cannot fail
+        gram_block_encode(block, val, num);
+    }
+
+    post->num--;
+
+    return 0;
+}
+
+int init_gram_index (gram_index* index) {
+    if (!index) {
+        return WRONG_ARGS;
+    }
+
+    index->htab = NULL;
+    index->gram_num = 0;
+    index->str_num = 0;
+
+    return 0;
+}
+
+int add_str_to_gram_index (gram_index* index, const char* str, str_len_int str_len, bit_index id) {
+    gram_posting* temp_post;
+
+    uint32_t key;
+
+    str_len_int i;
+
+    int ret;
+
+    if (!index || !str) {
+        return WRONG_ARGS;
+    }
+
+    // grams occuring more than once in str are added once only
+    for (i = 0; i + GRAM_LEN <= str_len; i++) {
+        key = gram_key(str + i);
+
+        HASH_FIND(hh, index->htab, &key, sizeof(uint32_t), temp_post);
+        if (!temp_post) {
+            temp_post = calloc(1, sizeof(gram_posting));
+            if (!temp_post) {
+                return MALLOC_FAIL;
+            }
+            temp_post->key = key;
+            HASH_ADD(hh, index->htab, key, sizeof(uint32_t), temp_post);
+            index->gram_num++;
+        }
+
+        if ((ret = gram_posting_add(temp_post, id))) {
+            return ret;
+        }
+    }
+
+    index->str_num++;
+
+    return 0;
+}
+
+int del_str_from_gram_index (gram_index* index, const char* str, str_len_int str_len, bit_index id) {
+    gram_posting* temp_post;
+
+    uint32_t key;
+
+    str_len_int i;
+
+    if (!index || !str) {
+        return WRONG_ARGS;
+    }
+
+    for (i = 0; i + GRAM_LEN <= str_len; i++) {
+        key = gram_key(str + i);
+
+        HASH_FIND(hh, index->htab, &key, sizeof(uint32_t), temp_post);
+        if (!temp_post) {   // gram seen earlier in str, and list is gone already
+            continue;
+        }
+
+        // FIND_FAIL for grams seen earlier in str is expected
+        gram_posting_del(temp_post, id);
+
+        if (temp_post->num == 0) {
+            HASH_DEL(index->htab, temp_post);
+            free(temp_post->block);
+            free(temp_post);
+            index->gram_num--;
+        }
+    }
+
+    if (index->str_num) {
+        index->str_num--;
+    }
+
+    return 0;
+}
+
+int del_gram_index (gram_index* index) {
+    gram_posting* temp_post;
+    gram_posting* temp_post_tmp;
+
+    uint32_t i;
+
+    if (!index) {
+        return WRONG_ARGS;
+    }
+
+    HASH_ITER(hh, index->htab, temp_post, temp_post_tmp) {
+        HASH_DEL(index->htab, temp_post);
+        for (i = 0; i < temp_post->block_num; i++) {
+            free(temp_post->block[i].gap);
+        }
+        free(temp_post->block);
+        free(temp_post);
+    }
+
+    index->gram_num = 0;
+    index->str_num = 0;
+
+    return 0;
+}
+
+static void gram_cursor_load (gram_cursor* cur, uint32_t b) {
+    cur->block = b;
+    cur->num = gram_block_decode(cur->post->block + b, cur->val);
+    cur->pos = 0;
+}
+
+// move cursor to first index not smaller than id, returns 0 if there is none
+static int gram_cursor_seek (gram_cursor* cur, bit_index id) {
+    gram_posting* post = cur->post;
+
+    uint32_t b;
+
+    if (cur->block >= post->block_num) {
+        return 0;
+    }
+
+    if (id > post->block[cur->block].last) {
+        b = gram_find_block(post, id);
+        if (post->block[b].last < id) {
+            b++;
+        }
+        if (b >= post->block_num) {
+            cur->block = post->block_num;
+            return 0;
+        }
+        gram_cursor_load(cur, b);
+    }
+
+    // last index of block is not smaller than id at this point
+    while (cur->val[cur->pos] < id) {
+        cur->pos++;
+    }
+
+    return 1;
+}
+
+int gram_iter_init (gram_iter* iter, gram_index* index, const char* str_part, str_len_int str_part_len, bit_index limit) {
+    gram_posting* temp_post;
+    gram_cursor* cur;
+
+    uint32_t key;
+
+    str_len_int i;
+    uint32_t j;
+
+    if (!iter || !index || !str_part) {
+        return WRONG_ARGS;
+    }
+
+    iter->cur_num = 0;
+    iter->next = 0;
+    iter->limit = limit;
+
+    if (str_part_len < GRAM_LEN) {
+        iter->scan = 1;
+        return 0;
+    }
+
+    iter->scan = 0;
+
+    // keep the GRAM_QUERY_MAX shortest lists, sorted by length
+    for (i = 0; i + GRAM_LEN <= str_part_len; i++) {
+        key = gram_key(str_part + i);
+
+        HASH_FIND(hh, index->htab, &key, sizeof(uint32_t), temp_post);
+        if (!temp_post) {   // nothing contains this gram
+            iter->cur_num = 0;
+            return FIND_FAIL;
+        }
+
+        for (j = 0; j < iter->cur_num; j++) {
+            if (iter->cur[j].post == temp_post) {
+                break;
+            }
+        }
+        if (j < iter->cur_num) {    // already picked
+            continue;
+        }
+
+        if (iter->cur_num == GRAM_QUERY_MAX) {
+            if (temp_post->num >= iter->cur[GRAM_QUERY_MAX - 1].post->num) {
+                continue;
+            }
+            iter->cur_num--;    // drop longest
+        }
+
+        for (j = iter->cur_num; j > 0 && iter->cur[j-1].post->num > temp_post->num; j--) {
+            iter->cur[j].post = iter->cur[j-1].post;
+        }
+        iter->cur[j].post = temp_post;
+        iter->cur_num++;
+    }
+
+    for (j = 0; j < iter->cur_num; j++) {
+        cur = iter->cur + j;
+        gram_cursor_load(cur, 0);
+    }
+
+    return 0;
+}
+
+int gram_iter_next (gram_iter* iter, bit_index* id) {
+    gram_cursor* lead;
+    gram_cursor* cur;
+
+    bit_index cand;
+
+    uint32_t i;
+
+    if (!iter || !id) {
+        return WRONG_ARGS;
+    }
+
+    if (iter->scan) {
+        if (iter->next >= iter->limit) {
+            return FIND_FAIL;
+        }
+        *id = iter->next;
+        iter->next++;
+        return 0;
+    }
+
+    if (iter->cur_num == 0) {
+        return FIND_FAIL;
+    }
+
+    lead = iter->cur;
+    if (!gram_cursor_seek(lead, iter->next)) {
+        iter->cur_num = 0;
+        return FIND_FAIL;
+    }
+    cand = lead->val[lead->pos];
+
+    // move every cursor to cand, restart from the shortest list when one goes past it
+    for (i = 1; i < iter->cur_num; ) {
+        cur = iter->cur + i;
+        if (!gram_cursor_seek(cur, cand)) {
+            iter->cur_num = 0;
+            return FIND_FAIL;
+        }
+        if (cur->val[cur->pos] == cand) {
+            i++;
+            continue;
+        }
+        if (!gram_cursor_seek(lead, cur->val[cur->pos])) {
+            iter->cur_num = 0;
+            return FIND_FAIL;
+        }
+        cand = lead->val[lead->pos];
+        i = 1;
+    }
+
+    *id = cand;
+    iter->next = cand + 1;
+
+    return 0;
+}
+
+int gram_iter_skip (gram_iter* iter, bit_index id) {
+    if (!iter) {
+        return WRONG_ARGS;
+    }
+
+    if (id > iter->next) {
+        iter->next = id;
+    }
+
+    return 0;
+}
+
+#define digest_is_node(p)   ((uintptr_t) (p) & 1)
+#define digest_node_of(p)   ((digest_node*) ((uintptr_t) (p) - 1))
+
+// direction to take at node for key, bytes past the key count as 0
+static int digest_dir (const digest_node* node, const unsigned char* key, uint32_t key_len) {
+    unsigned char c = 0;
+
+    if (node->byte < key_len) {
+        c = key[node->byte];
+    }
+
+    return (1 + (node->other_bits | c)) >> 8;
+}
+
+// position of critical bit counting from most significant bit of first byte
+static uint32_t digest_node_bit (const digest_node* node) {
+    unsigned char mask = ~node->other_bits;
+    uint32_t i = 0;
+
+    while (!(mask & 0x80)) {
+        mask <<= 1;
+        i++;
+    }
+
+    return node->byte * 8 + i;
+}
+
+int init_digest_index (digest_index* index, uint32_t key_len) {
+    if (!index) {
+        return WRONG_ARGS;
+    }
+    if (key_len == 0 || key_len > DIGEST_KEY_MAX_LEN) {
+        return WRONG_ARGS;
+    }
+
+    index->root = NULL;
+    index->key_len = key_len;
+    index->num = 0;
+
+    return 0;
+}
+
+int add_to_digest_index (digest_index* index, void* obj) {
+    const unsigned char* key = obj;
+    const unsigned char* leaf_key;
+
+    void* p;
+    void** where;
+
+    digest_node* node;
+    digest_node* q;
+
+    uint32_t new_byte;
+    unsigned int new_other_bits;
+    int new_dir;
+
+    if (!index || !obj) {
+        return WRONG_ARGS;
+    }
+
+    if (!index->root) {
+        index->root = obj;
+        index->num = 1;
+        return 0;
+    }
+
+    // find leaf sharing the longest prefix with key
+    p = index->root;
+    while (digest_is_node(p)) {
+        q = digest_node_of(p);
+        p = q->child[digest_dir(q, key, index->key_len)];
+    }
+    leaf_key = p;
+
+    for (new_byte = 0; new_byte < index->key_len; new_byte++) {
+        if (leaf_key[new_byte] != key[new_byte]) {
+            break;
+        }
+    }
+    if (new_byte == index->key_len) {
+        return DUPLICATE_ERROR;
+    }
+
+    // keep only highest differing bit
+    new_other_bits = leaf_key[new_byte] ^ key[new_byte];
+    new_other_bits |= new_other_bits >> 1;
+    new_other_bits |= new_other_bits >> 2;
+    new_other_bits |= new_other_bits >> 4;
+    new_other_bits = (new_other_bits & ~(new_other_bits >> 1)) ^ 0xFF;
+
+    new_dir = (1 + (new_other_bits | leaf_key[new_byte])) >> 8;
+
+    node = malloc(sizeof(digest_node));
+    if (!node) {
+        return MALLOC_FAIL;
+    }
+    node->byte = new_byte;
+    node->other_bits = new_other_bits;
+    node->child[1 - new_dir] = obj;
+
+    // insert above first node testing a later bit
+    where = &index->root;
+    while (digest_is_node(*where)) {
+        q = digest_node_of(*where);
+        if (q->byte > new_byte) {
+            break;
+        }
+        if (q->byte == new_byte && q->other_bits > new_other_bits) {
+            break;
+        }
+        where = q->child + digest_dir(q, key, index->key_len);
+    }
+
+    node->child[new_dir] = *where;
+    *where = (void*) ((uintptr_t) node + 1);
+
+    index->num++;
+
+    return 0;
+}
+
+int del_from_digest_index (digest_index* index, void* obj) {
+    const unsigned char* key = obj;
+
+    void** where_p;
+    void** where_q = NULL;
+
+    digest_node* q = NULL;
+
+    int dir = 0;
+
+    if (!index || !obj) {
+        return WRONG_ARGS;
+    }
+
+    if (!index->root) {
+        return FIND_FAIL;
+    }
+
+    where_p = &index->root;
+    while (digest_is_node(*where_p)) {
+        where_q = where_p;
+        q = digest_node_of(*where_p);
+        dir = digest_dir(q, key, index->key_len);
+        where_p = q->child + dir;
+    }
+
+    if (*where_p != obj) {
+        return FIND_FAIL;
+    }
+
+    if (!where_q) {     // only key
+        index->root = NULL;
+    }
+    else {  // replace parent node with sibling
+        *where_q = q->child[1 - dir];
+        free(q);
+    }
+
+    index->num--;
+
+    return 0;
+}
+
+int del_digest_index (digest_index* index) {
+    void* stack[DIGEST_DEPTH_MAX + 1];
+    uint32_t depth = 0;
+
+    digest_node* q;
+
+    if (!index) {
+        return WRONG_ARGS;
+    }
+
+    if (digest_is_node(index->root)) {
+        stack[depth++] = index->root;
+    }
+
+    // at most one sibling per level is waiting on stack
+    while (depth) {
+        q = digest_node_of(stack[--depth]);
+        if (digest_is_node(q->child[0])) {
+            stack[depth++] = q->child[0];
+        }
+        if (digest_is_node(q->child[1])) {
+            stack[depth++] = q->child[1];
+        }
+        free(q);
+    }
+
+    index->root = NULL;
+    index->num = 0;
+
+    return 0;
+}
+
+int hex_to_digest_prefix (unsigned char* prefix, uint32_t* prefix_bits, const char* hex, uint32_t key_len) {
+    uint32_t i;
+    unsigned char nibble;
+
+    if (!prefix || !prefix_bits || !hex) {
+        return WRONG_ARGS;
+    }
+
+    for (i = 0; hex[i] != 0; i++) {
+        if (i == key_len * 2) {
+            return INVALID_HEX_STR;
+        }
+
+        if ('0' <= hex[i] && hex[i] <= '9') {
+            nibble = hex[i] - '0';
+        }
+        else if ('a' <= hex[i] && hex[i] <= 'f') {
+            nibble = hex[i] - 'a' + 0x0A;
+        }
+        else if ('A' <= hex[i] && hex[i] <= 'F') {
+            nibble = hex[i] - 'A' + 0x0A;
+        }
+        else {
+            return INVALID_HEX_STR;
+        }
+
+        if (i % 2 == 0) {
+            prefix[i / 2] = nibble << 4;
+        }
+        else {
+            prefix[i / 2] |= nibble;
+        }
+    }
+
+    *prefix_bits = i * 4;
+
+    return 0;
+}
+
+int match_digest_prefix (const unsigned char* key, const unsigned char* prefix, uint32_t prefix_bits) {
+    uint32_t full = prefix_bits / 8;
+    unsigned char mask;
+
+    if (memcmp(key, prefix, full) != 0) {
+        return 0;
+    }
+
+    if (prefix_bits % 8 == 0) {
+        return 1;
+    }
+
+    mask = 0xFF << (8 - prefix_bits % 8);
+
+    return (key[full] & mask) == (prefix[full] & mask);
+}
+
+int digest_cursor_init (digest_cursor* cursor, digest_index* index, const unsigned char* prefix, uint32_t prefix_bits) {
+    void* p;
+    void* top;
+
+    digest_node* q;
+
+    if (!cursor || !index) {
+        return WRONG_ARGS;
+    }
+
+    cursor->depth = 0;
+
+    if (!index->root) {
+        return 0;
+    }
+
+    // go down while node tests a bit within prefix
+    p = index->root;
+    while (digest_is_node(p)) {
+        q = digest_node_of(p);
+        if (digest_node_bit(q) >= prefix_bits) {
+            break;
+        }
+        p = q->child[digest_dir(q, prefix, (prefix_bits + 7) / 8)];
+    }
+    top = p;
+
+    // keys below top agree on all bits within prefix, so checking one is enough
+    while (digest_is_node(p)) {
+        p = digest_node_of(p)->child[0];
+    }
+    if (!match_digest_prefix(p, prefix, prefix_bits)) {
+        return 0;
+    }
+
+    cursor->stack[cursor->depth++] = top;
+
+    return 0;
+}
+
+int digest_cursor_next (digest_cursor* cursor, void** obj) {
+    void* p;
+
+    digest_node* q;
+
+    if (!cursor || !obj) {
+        return WRONG_ARGS;
+    }
+
+    if (cursor->depth == 0) {
+        *obj = NULL;
+        return FIND_FAIL;
+    }
+
+    p = cursor->stack[--cursor->depth];
+    while (digest_is_node(p)) {
+        q = digest_node_of(p);
+        cursor->stack[cursor->depth++] = q->child[1];
+        p = q->child[0];
+    }
+
+    *obj = p;
+
+    return 0;
+}
+
 int reverse_strcpy(char* dst, const char* src) {
     int i, len;
 
@@ -270,10 +1360,14 @@ int escape_char(char* dst, const char* src, str_len_int max_len, char tar) {
 }
 
 int bytes_to_hex_str (char* dst, unsigned char* ptr, uint32_t size) {
+    static const char hex_digit[] = "0123456789abcdef";
+
     uint32_t i;
 
+    // ids are turned into hex whenever displayed or walked through as path, so avoid sprintf
     for (i = 0; i < size; i++) {
-        dst += sprintf(dst, "%02x", ptr[i]);
+        *dst++ = hex_digit[ptr[i] >> 4];
+        *dst++ = hex_digit[ptr[i] & 0x0F];
     }
     *dst = 0;
 
@@ -328,10 +1422,10 @@ int hex_str_to_bytes (unsigned char* dst, char* src) {
         // handle second digit
         // since remaining number of digits must be even at this point
         // i+1 must be a valid index
-        if ('a' <= src[i] && src[i] <= 'f') {
+        if ('a' <= src[i+1] && src[i+1] <= 'f') {
             dst[dst_indx] += ((src[i+1] - 'a') + 0x0A);   // consume only one digit
         }
-        else if ('0' <= src[i] && src[i] <= '9') {
+        else if ('0' <= src[i+1] && src[i+1] <= '9') {
             dst[dst_indx] +=  (src[i+1] - '0')        ;   // consume only one digit
         }
     }
@@ -339,6 +1433,77 @@ int hex_str_to_bytes (unsigned char* dst, char* src) {
     return 0;
 }
 
+// days since 1970-01-01 of a date in proleptic gregorian calendar, month is 1 to 12
+static int64_t days_from_civil (int64_t year, int64_t month, int64_t day) {
+    int64_t era, yoe, doy, doe;
+
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+int64_t utc_tm_to_epoch (const struct tm* tm) {
+    int64_t year, month;
+
+    // carry months over into years, as timegm does
+    year = (int64_t) tm->tm_year + 1900 + tm->tm_mon / 12;
+    month = tm->tm_mon % 12;
+    if (month < 0) {
+        month += 12;
+        year--;
+    }
+
+    return      days_from_civil(year, month + 1, 1) * 86400
+            +   (int64_t) (tm->tm_mday - 1) * 86400
+            +   (int64_t) tm->tm_hour * 3600
+            +   (int64_t) tm->tm_min * 60
+            +   tm->tm_sec;
+}
+
+int epoch_to_utc_tm (int64_t epoch, struct tm* tm) {
+    int64_t epoch_days, days, secs;
+    int64_t era, doe, yoe, doy, mp, year, month, day;
+
+    if (!tm) {
+        return WRONG_ARGS;
+    }
+
+    epoch_days = epoch / 86400;
+    secs = epoch % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        epoch_days--;
+    }
+
+    // inverse of days_from_civil
+    days = epoch_days + 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+
+    memset(tm, 0, sizeof(struct tm));
+    tm->tm_year = year - 1900;
+    tm->tm_mon = month - 1;
+    tm->tm_mday = day;
+    tm->tm_hour = secs / 3600;
+    tm->tm_min = secs / 60 % 60;
+    tm->tm_sec = secs % 60;
+    tm->tm_wday = (epoch_days % 7 + 11) % 7;    // 1970-01-01 was a thursday
+    tm->tm_yday = epoch_days - days_from_civil(year, 1, 1);
+    tm->tm_isdst = 0;
+
+    return 0;
+}
+
 int upper_to_lower_case (char* str) {
     while (*str) {
         if ('A' <= *str && *str <= 'F') {
@@ -443,13 +1608,25 @@ int copy_extract_sample(extract_sample* dst, extract_sample* src) {
     return 0;
 }
 
+// checksum type and digest length of each section checksum index
+const uint16_t sect_checksum_type[SECT_CHECKSUM_NUM] = {
+    CHECKSUM_SHA1_ID,
+    CHECKSUM_SHA256_ID,
+    CHECKSUM_SHA512_ID
+};
+const uint16_t sect_checksum_len[SECT_CHECKSUM_NUM] = {
+    SHA_DIGEST_LENGTH,
+    SHA256_DIGEST_LENGTH,
+    SHA512_DIGEST_LENGTH
+};
+
 /* For entry */
-init_generic_trans_struct_one_to_one(eid, e)
+init_generic_trans_struct_one_to_one_key(eid, e)
 init_layer1_generic_arr(eid, e, L1_EID_TO_E_ARR_SIZE)
 init_layer2_generic_arr(eid, e, L2_EIE_INIT_SIZE)
-init_generic_exist_mat(eid, EID_STR_MAX)
+init_generic_digest_index(eid, EID_LEN)
 
-add_generic_to_htab(eid, e)
+add_generic_key_to_htab(eid, e, EID_LEN)
 del_generic_from_htab(eid, e);
 
 add_generic_to_layer2_arr(eid, e, L2_EIE_GROW_SIZE, L1_EID_TO_E_ARR_SIZE)
@@ -459,20 +1636,21 @@ get_l1_generic_from_layer2_arr(eid, e)
 
 del_l2_generic_arr(eid, e, L2_EIE_INIT_SIZE, L2_EIE_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(eid, L2_EIE_GROW_SIZE, L1_EID_TO_E_ARR_SIZE, EID_STR_MAX)
-del_generic_from_generic_exist_mat(eid, e, L1_EID_TO_E_ARR_SIZE)
+add_generic_to_generic_digest_index(eid, e)
+del_generic_from_generic_digest_index(eid, e)
 
 /* For file name */
-init_generic_trans_struct_one_to_many(fn, e)
+init_generic_trans_struct_one_to_many_str_id(fn, e)
 init_layer1_generic_arr(fn, e, L1_FN_TO_E_ARR_SIZE)
 init_layer2_generic_arr(fn, e, L2_FNE_INIT_SIZE)
-init_generic_exist_mat(fn, FILE_NAME_MAX)
+init_generic_gram_index(fn)
 
-add_generic_to_htab(fn, e)
+add_generic_str_id_to_htab(fn, e)
 del_generic_from_htab(fn, e)
 
-add_generic_to_generic_chain(fn, e, prev_same_fn, next_same_fn, file_name, linked_entry)
-del_generic_from_generic_chain(fn, e, prev_same_fn, next_same_fn, linked_entry)
+add_generic_to_generic_str_id_postings(fn, e, fn_slot, file_name_id, linked_entry)
+del_generic_from_generic_postings(fn, e, fn_slot, linked_entry, gram_index)
+fres_generic_postings(fn, e)
 
 add_generic_to_layer2_arr(fn, e, L2_FNE_GROW_SIZE, L1_FN_TO_E_ARR_SIZE)
 del_generic_from_layer2_arr(fn, e, L1_FN_TO_E_ARR_SIZE)
@@ -481,20 +1659,21 @@ get_l1_generic_from_layer2_arr(fn, e)
 
 del_l2_generic_arr(fn, e, L2_FNE_INIT_SIZE, L2_FNE_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(fn, L2_FNE_GROW_SIZE, L1_FN_TO_E_ARR_SIZE, FILE_NAME_MAX)
-del_generic_from_generic_exist_mat(fn, e, L1_FN_TO_E_ARR_SIZE)
+add_generic_to_generic_gram_index(fn, FILE_NAME_MAX)
+del_generic_from_generic_gram_index(fn, e)
 
 /* For tag */
-init_generic_trans_struct_one_to_many(tag, e)
+init_generic_trans_struct_one_to_many_str_id(tag, e)
 init_layer1_generic_arr(tag, e, L1_TAG_TO_E_ARR_SIZE)
 init_layer2_generic_arr(tag, e, L2_TGE_INIT_SIZE)
-init_generic_exist_mat(tag, TAG_STR_MAX)
+init_generic_gram_index(tag)
 
-add_generic_to_htab(tag, e)
+add_generic_str_id_to_htab(tag, e)
 del_generic_from_htab(tag, e)
 
-add_generic_to_generic_chain(tag, e, prev_same_tag, next_same_tag, tag_str, linked_entry)
-del_generic_from_generic_chain(tag, e, prev_same_tag, next_same_tag, linked_entry)
+add_generic_to_generic_str_id_postings(tag, e, tag_slot, tag_str_id, linked_entry)
+del_generic_from_generic_postings(tag, e, tag_slot, linked_entry, gram_index)
+fres_generic_postings(tag, e)
 
 add_generic_to_layer2_arr(tag, e, L2_TGE_GROW_SIZE, L1_TAG_TO_E_ARR_SIZE)
 del_generic_from_layer2_arr(tag, e, L1_TAG_TO_E_ARR_SIZE)
@@ -503,21 +1682,22 @@ get_l1_generic_from_layer2_arr(tag, e)
 
 del_l2_generic_arr(tag, e, L2_TGE_INIT_SIZE, L2_TGE_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(tag, L2_TGE_GROW_SIZE, L1_TAG_TO_E_ARR_SIZE, TAG_STR_MAX)
-del_generic_from_generic_exist_mat(tag, e, L1_TAG_TO_E_ARR_SIZE)
+add_generic_to_generic_gram_index(tag, TAG_STR_MAX)
+del_generic_from_generic_gram_index(tag, e)
 
 /* For file data checksum */
 // sha1
-init_generic_trans_struct_one_to_many(sha1f, fd)
+init_generic_trans_struct_one_to_many_key(sha1f, fd)
 init_layer1_generic_arr(sha1f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 init_layer2_generic_arr(sha1f, fd, L2_CSF_INIT_SIZE)
-init_generic_exist_mat(sha1f, CHECKSUM_STR_MAX)
+init_generic_digest_index(sha1f, SHA_DIGEST_LENGTH)
 
-add_generic_to_htab(sha1f, fd)
+add_generic_key_to_htab(sha1f, fd, SHA_DIGEST_LENGTH)
 del_generic_from_htab(sha1f, fd)
 
-add_generic_to_generic_chain(sha1f, fd, prev_same_sha1, next_same_sha1, checksum[CHECKSUM_SHA1_INDEX].checksum_str, file_data)
-del_generic_from_generic_chain(sha1f, fd, prev_same_sha1, next_same_sha1, file_data)
+add_generic_to_generic_key_postings(sha1f, fd, sha1f_slot, checksum[CHECKSUM_SHA1_INDEX].checksum, SHA_DIGEST_LENGTH, file_data)
+del_generic_from_generic_postings(sha1f, fd, sha1f_slot, file_data, digest_index)
+fres_generic_postings(sha1f, fd)
 
 add_generic_to_layer2_arr(sha1f, fd, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE)
 del_generic_from_layer2_arr(sha1f, fd, L1_CSUM_TO_FD_ARR_SIZE)
@@ -526,20 +1706,21 @@ get_l1_generic_from_layer2_arr(sha1f, fd)
 
 del_l2_generic_arr(sha1f, fd, L2_CSF_INIT_SIZE, L2_CSF_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha1f, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha1f, fd, L1_CSUM_TO_FD_ARR_SIZE)
+add_generic_to_generic_digest_index(sha1f, fd)
+del_generic_from_generic_digest_index(sha1f, fd)
 
 // sha256
-init_generic_trans_struct_one_to_many(sha256f, fd)
+init_generic_trans_struct_one_to_many_key(sha256f, fd)
 init_layer1_generic_arr(sha256f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 init_layer2_generic_arr(sha256f, fd, L2_CSF_INIT_SIZE)
-init_generic_exist_mat(sha256f, CHECKSUM_STR_MAX)
+init_generic_digest_index(sha256f, SHA256_DIGEST_LENGTH)
 
-add_generic_to_htab(sha256f, fd)
+add_generic_key_to_htab(sha256f, fd, SHA256_DIGEST_LENGTH)
 del_generic_from_htab(sha256f, fd)
 
-add_generic_to_generic_chain(sha256f, fd, prev_same_sha256, next_same_sha256, checksum[CHECKSUM_SHA256_INDEX].checksum_str, file_data)
-del_generic_from_generic_chain(sha256f, fd, prev_same_sha256, next_same_sha256, file_data)
+add_generic_to_generic_key_postings(sha256f, fd, sha256f_slot, checksum[CHECKSUM_SHA256_INDEX].checksum, SHA256_DIGEST_LENGTH, file_data)
+del_generic_from_generic_postings(sha256f, fd, sha256f_slot, file_data, digest_index)
+fres_generic_postings(sha256f, fd)
 
 add_generic_to_layer2_arr(sha256f, fd, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE)
 del_generic_from_layer2_arr(sha256f, fd, L1_CSUM_TO_FD_ARR_SIZE)
@@ -548,20 +1729,21 @@ get_l1_generic_from_layer2_arr(sha256f, fd)
 
 del_l2_generic_arr(sha256f, fd, L2_CSF_INIT_SIZE, L2_CSF_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha256f, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha256f, fd, L1_CSUM_TO_FD_ARR_SIZE)
+add_generic_to_generic_digest_index(sha256f, fd)
+del_generic_from_generic_digest_index(sha256f, fd)
 
 // sha512
-init_generic_trans_struct_one_to_many(sha512f, fd)
+init_generic_trans_struct_one_to_many_key(sha512f, fd)
 init_layer1_generic_arr(sha512f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 init_layer2_generic_arr(sha512f, fd, L2_CSF_INIT_SIZE)
-init_generic_exist_mat(sha512f, CHECKSUM_STR_MAX)
+init_generic_digest_index(sha512f, SHA512_DIGEST_LENGTH)
 
-add_generic_to_htab(sha512f, fd)
+add_generic_key_to_htab(sha512f, fd, SHA512_DIGEST_LENGTH)
 del_generic_from_htab(sha512f, fd)
 
-add_generic_to_generic_chain(sha512f, fd, prev_same_sha512, next_same_sha512, checksum[CHECKSUM_SHA512_INDEX].checksum_str, file_data)
-del_generic_from_generic_chain(sha512f, fd, prev_same_sha512, next_same_sha512, file_data)
+add_generic_to_generic_key_postings(sha512f, fd, sha512f_slot, checksum[CHECKSUM_SHA512_INDEX].checksum, SHA512_DIGEST_LENGTH, file_data)
+del_generic_from_generic_postings(sha512f, fd, sha512f_slot, file_data, digest_index)
+fres_generic_postings(sha512f, fd)
 
 add_generic_to_layer2_arr(sha512f, fd, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE)
 del_generic_from_layer2_arr(sha512f, fd, L1_CSUM_TO_FD_ARR_SIZE)
@@ -570,21 +1752,44 @@ get_l1_generic_from_layer2_arr(sha512f, fd)
 
 del_l2_generic_arr(sha512f, fd, L2_CSF_INIT_SIZE, L2_CSF_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha512f, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha512f, fd, L1_CSUM_TO_FD_ARR_SIZE)
+add_generic_to_generic_digest_index(sha512f, fd)
+del_generic_from_generic_digest_index(sha512f, fd)
+
+// merkle
+init_generic_trans_struct_one_to_many_key(mrklf, fd)
+init_layer1_generic_arr(mrklf, fd, L1_CSUM_TO_FD_ARR_SIZE)
+init_layer2_generic_arr(mrklf, fd, L2_CSF_INIT_SIZE)
+init_generic_digest_index(mrklf, MRKL_DIGEST_LENGTH)
+
+add_generic_key_to_htab(mrklf, fd, MRKL_DIGEST_LENGTH)
+del_generic_from_htab(mrklf, fd)
+
+add_generic_to_generic_key_postings(mrklf, fd, mrklf_slot, checksum[CHECKSUM_MRKL_INDEX].checksum, MRKL_DIGEST_LENGTH, file_data)
+del_generic_from_generic_postings(mrklf, fd, mrklf_slot, file_data, digest_index)
+fres_generic_postings(mrklf, fd)
+
+add_generic_to_layer2_arr(mrklf, fd, L2_CSF_GROW_SIZE, L1_CSUM_TO_FD_ARR_SIZE)
+del_generic_from_layer2_arr(mrklf, fd, L1_CSUM_TO_FD_ARR_SIZE)
+get_generic_from_layer2_arr(mrklf, fd, L1_CSUM_TO_FD_ARR_SIZE)
+get_l1_generic_from_layer2_arr(mrklf, fd)
+
+del_l2_generic_arr(mrklf, fd, L2_CSF_INIT_SIZE, L2_CSF_GROW_SIZE)
+
+add_generic_to_generic_digest_index(mrklf, fd)
+del_generic_from_generic_digest_index(mrklf, fd)
 
 /* For section checksum */
 // sha1
-init_generic_trans_struct_one_to_many(sha1s, s)
-init_generic_exist_mat(sha1s, CHECKSUM_STR_MAX)
+init_generic_trans_struct_one_to_many_sect_key(sha1s, s)
+init_generic_digest_index(sha1s, SHA_DIGEST_LENGTH)
 init_layer1_generic_arr(sha1s, s, L1_CSUM_TO_S_ARR_SIZE)
 init_layer2_generic_arr(sha1s, s, L2_CSS_INIT_SIZE)
 
-add_generic_to_htab(sha1s, s)
+add_generic_key_to_htab(sha1s, s, SHA_DIGEST_LENGTH)
 del_generic_from_htab(sha1s, s)
 
-add_generic_to_generic_chain(sha1s, s, prev_same_sha1, next_same_sha1, checksum[CHECKSUM_SHA512_INDEX].checksum_str, section)
-del_generic_from_generic_chain(sha1s, s, prev_same_sha1, next_same_sha1, section)
+add_generic_to_generic_sect_postings(sha1s, s)
+del_generic_from_generic_sect_postings(sha1s, s, CHECKSUM_SHA1_INDEX, SHA_DIGEST_LENGTH, digest_index)
 
 add_generic_to_layer2_arr(sha1s, s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE)
 del_generic_from_layer2_arr(sha1s, s, L1_CSUM_TO_S_ARR_SIZE)
@@ -593,20 +1798,20 @@ get_l1_generic_from_layer2_arr(sha1s, s)
 
 del_l2_generic_arr(sha1s, s, L2_CSS_INIT_SIZE, L2_CSS_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha1s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha1s, s, L1_CSUM_TO_S_ARR_SIZE)
+add_generic_to_generic_digest_index(sha1s, s)
+del_generic_from_generic_digest_index(sha1s, s)
 
 // sha256
-init_generic_trans_struct_one_to_many(sha256s, s)
-init_generic_exist_mat(sha256s, CHECKSUM_STR_MAX)
+init_generic_trans_struct_one_to_many_sect_key(sha256s, s)
+init_generic_digest_index(sha256s, SHA256_DIGEST_LENGTH)
 init_layer1_generic_arr(sha256s, s, L1_CSUM_TO_S_ARR_SIZE)
 init_layer2_generic_arr(sha256s, s, L2_CSS_INIT_SIZE)
 
-add_generic_to_htab(sha256s, s)
+add_generic_key_to_htab(sha256s, s, SHA256_DIGEST_LENGTH)
 del_generic_from_htab(sha256s, s)
 
-add_generic_to_generic_chain(sha256s, s, prev_same_sha256, next_same_sha256, checksum[CHECKSUM_SHA512_INDEX].checksum_str, section)
-del_generic_from_generic_chain(sha256s, s, prev_same_sha256, next_same_sha256, section)
+add_generic_to_generic_sect_postings(sha256s, s)
+del_generic_from_generic_sect_postings(sha256s, s, CHECKSUM_SHA256_INDEX, SHA256_DIGEST_LENGTH, digest_index)
 
 add_generic_to_layer2_arr(sha256s, s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE)
 del_generic_from_layer2_arr(sha256s, s, L1_CSUM_TO_S_ARR_SIZE)
@@ -615,20 +1820,20 @@ get_l1_generic_from_layer2_arr(sha256s, s)
 
 del_l2_generic_arr(sha256s, s, L2_CSS_INIT_SIZE, L2_CSS_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha256s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha256s, s, L1_CSUM_TO_S_ARR_SIZE)
+add_generic_to_generic_digest_index(sha256s, s)
+del_generic_from_generic_digest_index(sha256s, s)
 
 // sha512
-init_generic_trans_struct_one_to_many(sha512s, s)
-init_generic_exist_mat(sha512s, CHECKSUM_STR_MAX)
+init_generic_trans_struct_one_to_many_sect_key(sha512s, s)
+init_generic_digest_index(sha512s, SHA512_DIGEST_LENGTH)
 init_layer1_generic_arr(sha512s, s, L1_CSUM_TO_S_ARR_SIZE)
 init_layer2_generic_arr(sha512s, s, L2_CSS_INIT_SIZE)
 
-add_generic_to_htab(sha512s, s)
+add_generic_key_to_htab(sha512s, s, SHA512_DIGEST_LENGTH)
 del_generic_from_htab(sha512s, s)
 
-add_generic_to_generic_chain(sha512s, s, prev_same_sha512, next_same_sha512, checksum[CHECKSUM_SHA512_INDEX].checksum_str, section)
-del_generic_from_generic_chain(sha512s, s, prev_same_sha512, next_same_sha512, section)
+add_generic_to_generic_sect_postings(sha512s, s)
+del_generic_from_generic_sect_postings(sha512s, s, CHECKSUM_SHA512_INDEX, SHA512_DIGEST_LENGTH, digest_index)
 
 add_generic_to_layer2_arr(sha512s, s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE)
 del_generic_from_layer2_arr(sha512s, s, L1_CSUM_TO_S_ARR_SIZE)
@@ -637,12 +1842,12 @@ get_l1_generic_from_layer2_arr(sha512s, s)
 
 del_l2_generic_arr(sha512s, s, L2_CSS_INIT_SIZE, L2_CSS_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(sha512s, L2_CSS_GROW_SIZE, L1_CSUM_TO_S_ARR_SIZE, CHECKSUM_STR_MAX)
-del_generic_from_generic_exist_mat(sha512s, s, L1_CSUM_TO_S_ARR_SIZE)
+add_generic_to_generic_digest_index(sha512s, s)
+del_generic_from_generic_digest_index(sha512s, s)
 
 /* For file size */
 init_generic_trans_struct_one_to_many(f_size, fd)
-init_generic_exist_mat(f_size, FILE_SIZE_STR_MAX)
+init_generic_gram_index(f_size)
 init_layer1_generic_arr(f_size, fd, L1_FSIZE_TO_FD_ARR_SIZE)
 
 add_generic_to_htab(f_size, fd)
@@ -650,8 +1855,9 @@ del_generic_from_htab(f_size, fd)
 
 init_layer2_generic_arr(f_size, fd, L2_FZF_INIT_SIZE)
 
-add_generic_to_generic_chain(f_size, fd, prev_same_f_size, next_same_f_size, file_size_str, file_data)
-del_generic_from_generic_chain(f_size, fd, prev_same_f_size, next_same_f_size, file_data)
+add_generic_to_generic_num_postings(f_size, fd, f_size_slot, file_size, file_data)
+del_generic_from_generic_postings(f_size, fd, f_size_slot, file_data, gram_index)
+fres_generic_postings(f_size, fd)
 
 add_generic_to_layer2_arr(f_size, fd, L2_FZF_GROW_SIZE, L1_FSIZE_TO_FD_ARR_SIZE)
 del_generic_from_layer2_arr(f_size, fd, L1_FSIZE_TO_FD_ARR_SIZE)
@@ -660,8 +1866,8 @@ get_l1_generic_from_layer2_arr(f_size, fd)
 
 del_l2_generic_arr(f_size, fd, L2_FZF_INIT_SIZE, L2_FZF_GROW_SIZE)
 
-add_generic_to_generic_exist_mat(f_size, L2_FZF_GROW_SIZE, L1_FSIZE_TO_FD_ARR_SIZE, FILE_SIZE_STR_MAX)
-del_generic_from_generic_exist_mat(f_size, fd, L1_FSIZE_TO_FD_ARR_SIZE)
+add_generic_to_generic_gram_index(f_size, FILE_SIZE_STR_MAX)
+del_generic_from_generic_gram_index(f_size, fd)
 
 /* other pool allocated objects */
 init_layer1_obj_arr(entry, L1_ENTRY_ARR_SIZE)
@@ -680,14 +1886,6 @@ get_obj_from_layer2_arr(file_data, file_data, L1_FILE_DATA_ARR_SIZE)
 get_l1_obj_from_layer2_arr(file_data)
 del_l2_obj_arr(file_data, L2_FILE_DATA_INIT_SIZE, L2_FILE_DATA_GROW_SIZE)
 
-init_layer1_obj_arr(section, L1_SECT_ARR_SIZE)
-init_layer2_obj_arr(section, L2_SECT_INIT_SIZE)
-add_obj_to_layer2_arr(section, section, L2_SECT_GROW_SIZE, L1_SECT_ARR_SIZE)
-del_obj_from_layer2_arr(section, section, L1_SECT_ARR_SIZE)
-get_obj_from_layer2_arr(section, section, L1_SECT_ARR_SIZE)
-get_l1_obj_from_layer2_arr(section)
-del_l2_obj_arr(section, L2_SECT_INIT_SIZE, L2_SECT_GROW_SIZE)
-
 init_layer1_obj_arr(misc_alloc_record, L1_MISC_ALLOC_ARR_SIZE)
 init_layer2_obj_arr(misc_alloc_record, L2_MISC_ALLOC_INIT_SIZE)
 add_obj_to_layer2_arr(misc_alloc_record, misc_alloc_record, L2_MISC_ALLOC_GROW_SIZE, L1_MISC_ALLOC_ARR_SIZE)
@@ -696,14 +1894,6 @@ get_obj_from_layer2_arr(misc_alloc_record, misc_alloc_record, L1_MISC_ALLOC_ARR_
 get_l1_obj_from_layer2_arr(misc_alloc_record)
 del_l2_obj_arr(misc_alloc_record, L2_MISC_ALLOC_INIT_SIZE, L2_MISC_ALLOC_GROW_SIZE)
 
-init_layer1_obj_arr(dtt_year, L1_DTT_YEAR_ARR_SIZE)
-init_layer2_obj_arr(dtt_year, L2_DTT_YEAR_INIT_SIZE)
-add_obj_to_layer2_arr(dtt_year, dtt_year, L2_DTT_YEAR_GROW_SIZE, L1_DTT_YEAR_ARR_SIZE)
-del_obj_from_layer2_arr(dtt_year, dtt_year, L1_DTT_YEAR_ARR_SIZE)
-get_obj_from_layer2_arr(dtt_year, dtt_year, L1_DTT_YEAR_ARR_SIZE)
-get_l1_obj_from_layer2_arr(dtt_year)
-del_l2_obj_arr(dtt_year, L2_DTT_YEAR_INIT_SIZE, L2_DTT_YEAR_GROW_SIZE)
-
 init_layer1_obj_arr(sect_field, L1_SECT_FIELD_ARR_SIZE)
 init_layer2_obj_arr(sect_field, L2_SECT_FIELD_INIT_SIZE)
 add_obj_to_layer2_arr(sect_field, sect_field, L2_SECT_FIELD_GROW_SIZE, L1_SECT_FIELD_ARR_SIZE)
@@ -712,6 +1902,392 @@ get_obj_from_layer2_arr(sect_field, sect_field, L1_SECT_FIELD_ARR_SIZE)
 get_l1_obj_from_layer2_arr(sect_field)
 del_l2_obj_arr(sect_field, L2_SECT_FIELD_INIT_SIZE, L2_SECT_FIELD_GROW_SIZE)
 
+static int set_entry_str (char** dst, str_len_int* dst_len, const char* src, str_len_int max_len) {
+    str_len_int src_len;
+
+    char* temp_str;
+
+    int ret;
+
+    if ((ret = verify_str_terminated(src, max_len, &src_len, 0))) {
+        return ret;
+    }
+
+    if (src_len == 0) {
+        temp_str = empty_entry_str;
+    }
+    else {
+        temp_str = malloc(src_len + 1);
+        if (!temp_str) {
+            return MALLOC_FAIL;
+        }
+        memcpy(temp_str, src, src_len + 1);
+    }
+
+    // src may be the old string itself
+    if (*dst && *dst != empty_entry_str) {
+        free(*dst);
+    }
+
+    *dst = temp_str;
+    *dst_len = src_len;
+
+    return 0;
+}
+
+int init_entry_strs (linked_entry* entry) {
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    entry->file_name = empty_entry_str;
+    entry->file_name_id = STR_ID_EMPTY;
+    entry->file_name_len = 0;
+    entry->tag_str = empty_entry_str;
+    entry->tag_str_id = STR_ID_EMPTY;
+    entry->tag_str_len = 0;
+    entry->user_msg = empty_entry_str;
+    entry->user_msg_len = 0;
+
+    return 0;
+}
+
+static int set_entry_interned_str (str_intern* strs, const char** dst, str_id* dst_id, str_len_int* dst_len, const char* src, str_len_int max_len) {
+    str_len_int src_len;
+
+    str_id temp_id;
+
+    int ret;
+
+    if ((ret = verify_str_terminated(src, max_len, &src_len, 0))) {
+        return ret;
+    }
+
+    if ((ret = str_intern_add(strs, src, src_len, &temp_id))) {
+        return ret;
+    }
+
+    *dst = str_intern_get(strs, temp_id);
+    *dst_id = temp_id;
+    *dst_len = src_len;
+
+    return 0;
+}
+
+int set_entry_file_name (database_handle* dh, linked_entry* entry, const char* file_name) {
+    linked_entry* parent;
+
+    int ret;
+
+    if (!dh || !entry) {
+        return WRONG_ARGS;
+    }
+
+    // child index of parent is keyed by file name id, so take entry out while the id changes
+    parent = entry->parent;
+    if (        parent
+            &&  parent->child_idx
+            &&  entry->child_slot < parent->child_num
+            &&  parent->child[entry->child_slot] == entry
+       )
+    {
+        del_from_child_index(parent, entry);
+    }
+    else {
+        parent = NULL;
+    }
+
+    ret = set_entry_interned_str(&dh->strs, &entry->file_name, &entry->file_name_id, &entry->file_name_len, file_name, FILE_NAME_MAX);
+
+    if (parent) {
+        add_to_child_index(parent, entry);
+    }
+
+    return ret;
+}
+
+int set_entry_tag_str (database_handle* dh, linked_entry* entry, const char* tag_str) {
+    if (!dh || !entry) {
+        return WRONG_ARGS;
+    }
+
+    return set_entry_interned_str(&dh->strs, &entry->tag_str, &entry->tag_str_id, &entry->tag_str_len, tag_str, TAG_STR_MAX);
+}
+
+int set_entry_user_msg (linked_entry* entry, const char* user_msg) {
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    return set_entry_str(&entry->user_msg, &entry->user_msg_len, user_msg, USER_MSG_MAX);
+}
+
+int fres_entry_strs (linked_entry* entry) {
+    if (!entry) {
+        return WRONG_ARGS;
+    }
+
+    // file name and tag string belong to the intern table of database
+    if (entry->user_msg && entry->user_msg != empty_entry_str) {
+        free(entry->user_msg);
+    }
+
+    return init_entry_strs(entry);
+}
+
+static uint64_t child_index_home (str_id id, uint64_t slot_num) {
+    return ((uint64_t) id * UINT64_C(0x9e3779b97f4a7c15) >> 32) & (slot_num - 1);
+}
+
+// table must have a free slot
+static void child_index_put (child_index* idx, linked_entry* entry) {
+    uint64_t mask = idx->slot_num - 1;
+    uint64_t i = child_index_home(entry->file_name_id, idx->slot_num);
+
+    while (idx->slot[i]) {
+        i = (i + 1) & mask;
+    }
+
+    idx->slot[i] = entry;
+    idx->used_num++;
+}
+
+static int child_index_grow (child_index* idx) {
+    linked_entry** old_slot = idx->slot;
+    uint64_t old_slot_num = idx->slot_num;
+
+    uint64_t i;
+
+    idx->slot = calloc(old_slot_num * 2, sizeof(linked_entry*));
+    if (!idx->slot) {
+        idx->slot = old_slot;
+        return MALLOC_FAIL;
+    }
+
+    idx->slot_num = old_slot_num * 2;
+    idx->used_num = 0;
+
+    for (i = 0; i < old_slot_num; i++) {
+        if (old_slot[i]) {
+            child_index_put(idx, old_slot[i]);
+        }
+    }
+
+    free(old_slot);
+
+    return 0;
+}
+
+static void child_index_drop_sorted (child_index* idx) {
+    free(idx->sorted);
+    idx->sorted = NULL;
+}
+
+int make_child_index (linked_entry* parent) {
+    child_index* idx;
+
+    ffp_eid_int i;
+
+    if (!parent) {
+        return WRONG_ARGS;
+    }
+
+    if (parent->child_idx) {
+        return 0;
+    }
+
+    idx = malloc(sizeof(child_index));
+    if (!idx) {
+        return MALLOC_FAIL;
+    }
+
+    // keep load factor at most half
+    idx->slot_num = CHILD_INDEX_INIT_SLOT_NUM;
+    while (idx->slot_num < parent->child_num * 2) {
+        idx->slot_num *= 2;
+    }
+
+    idx->slot = calloc(idx->slot_num, sizeof(linked_entry*));
+    if (!idx->slot) {
+        free(idx);
+        return MALLOC_FAIL;
+    }
+    idx->used_num = 0;
+    idx->sorted = NULL;
+
+    for (i = 0; i < parent->child_num; i++) {
+        child_index_put(idx, parent->child[i]);
+    }
+
+    parent->child_idx = idx;
+
+    return 0;
+}
+
+int add_to_child_index (linked_entry* parent, linked_entry* entry) {
+    child_index* idx;
+
+    int ret;
+
+    if (!parent || !entry) {
+        return WRONG_ARGS;
+    }
+
+    idx = parent->child_idx;
+    if (!idx) {
+        return 0;
+    }
+
+    child_index_drop_sorted(idx);
+
+    if ((idx->used_num + 1) * 2 > idx->slot_num) {
+        if ((ret = child_index_grow(idx))) {
+            return ret;
+        }
+    }
+
+    child_index_put(idx, entry);
+
+    return 0;
+}
+
+int del_from_child_index (linked_entry* parent, linked_entry* entry) {
+    child_index* idx;
+
+    uint64_t mask;
+    uint64_t i, j, home;
+
+    if (!parent || !entry) {
+        return WRONG_ARGS;
+    }
+
+    idx = parent->child_idx;
+    if (!idx) {
+        return 0;
+    }
+
+    child_index_drop_sorted(idx);
+
+    mask = idx->slot_num - 1;
+
+    for (i = child_index_home(entry->file_name_id, idx->slot_num); idx->slot[i] != entry; i = (i + 1) & mask) {
+        if (!idx->slot[i]) {
+            return FIND_FAIL;
+        }
+    }
+
+    // shift back later slots of the run which may not stay after the hole
+    for (j = (i + 1) & mask; idx->slot[j]; j = (j + 1) & mask) {
+        home = child_index_home(idx->slot[j]->file_name_id, idx->slot_num);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            idx->slot[i] = idx->slot[j];
+            i = j;
+        }
+    }
+
+    idx->slot[i] = NULL;
+    idx->used_num--;
+
+    return 0;
+}
+
+int fres_child_index (linked_entry* parent) {
+    if (!parent) {
+        return WRONG_ARGS;
+    }
+
+    if (parent->child_idx) {
+        free(parent->child_idx->slot);
+        free(parent->child_idx->sorted);
+        free(parent->child_idx);
+        parent->child_idx = NULL;
+    }
+
+    return 0;
+}
+
+int child_cursor_init (child_cursor* cursor, const linked_entry* parent, str_id id) {
+    if (!cursor || !parent) {
+        return WRONG_ARGS;
+    }
+
+    cursor->parent = parent;
+    cursor->id = id;
+    if (parent->child_idx) {
+        cursor->pos = child_index_home(id, parent->child_idx->slot_num);
+    }
+    else {
+        cursor->pos = 0;
+    }
+
+    return 0;
+}
+
+int child_cursor_next (child_cursor* cursor, linked_entry** entry) {
+    const linked_entry* parent;
+    const child_index* idx;
+
+    linked_entry* temp_entry;
+
+    if (!cursor || !entry) {
+        return WRONG_ARGS;
+    }
+
+    parent = cursor->parent;
+    idx = parent->child_idx;
+
+    if (idx) {
+        // run ends at first free slot
+        while ((temp_entry = idx->slot[cursor->pos])) {
+            cursor->pos = (cursor->pos + 1) & (idx->slot_num - 1);
+            if (temp_entry->file_name_id == cursor->id) {
+                *entry = temp_entry;
+                return 0;
+            }
+        }
+    }
+    else {
+        while (cursor->pos < parent->child_num) {
+            temp_entry = parent->child[cursor->pos];
+            cursor->pos++;
+            if (temp_entry->file_name_id == cursor->id) {
+                *entry = temp_entry;
+                return 0;
+            }
+        }
+    }
+
+    *entry = NULL;
+
+    return FIND_FAIL;
+}
+
+// norm_sect_size and last_sect_size are left as is
+int fres_section_array (file_data* target) {
+    int i;
+
+    if (!target) {
+        return WRONG_ARGS;
+    }
+
+    free(target->section);
+    free(target->sect_pos);
+    for (i = 0; i < SECT_CHECKSUM_NUM; i++) {
+        free(target->sect_digest[i]);
+        target->sect_digest[i] = NULL;
+    }
+    free(target->sect_extract);
+
+    target->section = NULL;
+    target->sect_pos = NULL;
+    target->sect_extract = NULL;
+
+    target->section_num = 0;
+    target->section_free_num = 0;
+
+    return 0;
+}
+
 // clear link
 int link_entry_clear(linked_entry* tar) {
     if (!tar) {
@@ -872,64 +2448,85 @@ int init_database_handle(database_handle* dh) {
 
     mem_wipe_sec(&dh->name, FILE_NAME_MAX);
 
+    ret = init_str_intern(&dh->strs);
+    if (ret) {
+        return ret;
+    }
+
     dh->eid_to_e = 0;
     init_layer2_eid_to_e_arr(&dh->l2_eid_to_e_arr);
-    init_eid_exist_mat(&dh->eid_mat);
+    init_eid_digest_index(&dh->eid_digest);
 
     mem_wipe_sec(&dh->tree, sizeof(linked_entry));
+    init_entry_strs(&dh->tree);
     dh->tree.type = ENTRY_GROUP;
     add_eid_to_e_to_layer2_arr(&dh->l2_eid_to_e_arr, &tree_eid_to_e, &temp_index);
     init_eid_to_e(tree_eid_to_e);
-    bytes_to_hex_str(dh->tree.entry_id_str, dh->tree.entry_id, EID_LEN);
-    bytes_to_hex_str(tree_eid_to_e->str, dh->tree.entry_id, EID_LEN);
+    memcpy(tree_eid_to_e->key, dh->tree.entry_id, EID_LEN);
     tree_eid_to_e->tar = &dh->tree;
     add_eid_to_e_to_htab(&dh->eid_to_e, tree_eid_to_e);
     dh->tree.eid_to_e = tree_eid_to_e;
-    add_eid_to_eid_exist_mat(&dh->eid_mat, tree_eid_to_e->str, temp_index);
+    add_eid_to_eid_digest_index(&dh->eid_digest, tree_eid_to_e);
     dh->tree.depth = 0;
 
     dh->fn_to_e = 0;
     init_layer2_fn_to_e_arr(&dh->l2_fn_to_e_arr);
-    init_fn_exist_mat(&dh->fn_mat);
+    init_fn_gram_index(&dh->fn_gram);
 
     dh->tag_to_e = 0;
     init_layer2_tag_to_e_arr(&dh->l2_tag_to_e_arr);
-    init_tag_exist_mat(&dh->tag_mat);
+    init_tag_gram_index(&dh->tag_gram);
 
     /* file data */
     // sha1
     dh->sha1f_to_fd = 0;
     init_layer2_sha1f_to_fd_arr(&dh->l2_sha1f_to_fd_arr);
-    init_sha1f_exist_mat(&dh->sha1f_mat);
+    init_sha1f_digest_index(&dh->sha1f_digest);
     // sha256
     dh->sha256f_to_fd = 0;
     init_layer2_sha256f_to_fd_arr(&dh->l2_sha256f_to_fd_arr);
-    init_sha256f_exist_mat(&dh->sha256f_mat);
+    init_sha256f_digest_index(&dh->sha256f_digest);
     // sha512
     dh->sha512f_to_fd = 0;
     init_layer2_sha512f_to_fd_arr(&dh->l2_sha512f_to_fd_arr);
-    init_sha512f_exist_mat(&dh->sha512f_mat);
+    init_sha512f_digest_index(&dh->sha512f_digest);
+    // merkle
+    dh->mrklf_to_fd = 0;
+    init_layer2_mrklf_to_fd_arr(&dh->l2_mrklf_to_fd_arr);
+    init_mrklf_digest_index(&dh->mrklf_digest);
 
     /* section */
     // sha1
     dh->sha1s_to_s = 0;
     init_layer2_sha1s_to_s_arr(&dh->l2_sha1s_to_s_arr);
-    init_sha1s_exist_mat(&dh->sha1s_mat);
+    init_sha1s_digest_index(&dh->sha1s_digest);
     // sha256
     dh->sha256s_to_s = 0;
     init_layer2_sha256s_to_s_arr(&dh->l2_sha256s_to_s_arr);
-    init_sha256s_exist_mat(&dh->sha256s_mat);
+    init_sha256s_digest_index(&dh->sha256s_digest);
     // sha512
     dh->sha512s_to_s = 0;
     init_layer2_sha512s_to_s_arr(&dh->l2_sha512s_to_s_arr);
-    init_sha512s_exist_mat(&dh->sha512s_mat);
+    init_sha512s_digest_index(&dh->sha512s_digest);
 
     dh->f_size_to_fd = 0;
     init_layer2_f_size_to_fd_arr(&dh->l2_f_size_to_fd_arr);
-    init_f_size_exist_mat(&dh->f_size_mat);
+    init_f_size_gram_index(&dh->f_size_gram);
+
+    mem_wipe_sec(&dh->tod_index,    sizeof(time_index));
+    mem_wipe_sec(&dh->tom_index,    sizeof(time_index));
+    mem_wipe_sec(&dh->tusr_index,   sizeof(time_index));
+
+    dh->fuzzy_index = NULL;
+    dh->fuzzy_num = 0;
+    dh->fuzzy_mark = 0;
+
+    dh->extract_index = NULL;
+    dh->extract_index_num = 0;
 
-    mem_wipe_sec(&dh->tod_dt_tree,  sizeof(dtt_year*));
-    mem_wipe_sec(&dh->tusr_dt_tree, sizeof(dtt_year*));
+    dh->pending_head = NULL;
+    dh->pending_tail = NULL;
+    dh->pending_num = 0;
 
     // pool allocatr structure
     // entry
@@ -941,27 +2538,116 @@ int init_database_handle(database_handle* dh) {
     if (ret) {
         return ret;
     }
-    ret = init_layer2_section_arr(&dh->l2_section_arr);
-    if (ret) {
-        return ret;
-    }
     ret = init_layer2_misc_alloc_record_arr(&dh->l2_misc_alloc_record_arr);
     if (ret) {
         return ret;
     }
-    ret = init_layer2_dtt_year_arr(&dh->l2_dtt_year_arr);
-    if (ret) {
-        return ret;
-    }
 
     return 0;
 }
 
 int fres_database_handle(database_handle* dh) {
-    int i, ret;
+    int ret;
+    bit_index i;
+
+    linked_entry* temp_entry;
 
     misc_alloc_record* temp_alloc_record;
 
+    file_data* temp_file_data;
+
+    fuzzy_gram* temp_gram;
+    fuzzy_gram* temp_gram_tmp;
+
+    extract_bucket* temp_bucket;
+    extract_bucket* temp_bucket_tmp;
+
+    t_sha1s_to_s* temp_sha1s_to_s;
+    t_sha1s_to_s* temp_sha1s_to_s_tmp;
+    t_sha256s_to_s* temp_sha256s_to_s;
+    t_sha256s_to_s* temp_sha256s_to_s_tmp;
+    t_sha512s_to_s* temp_sha512s_to_s;
+    t_sha512s_to_s* temp_sha512s_to_s_tmp;
+
+    // free gram indices
+    del_gram_index(&dh->fn_gram);
+    del_gram_index(&dh->tag_gram);
+    del_gram_index(&dh->f_size_gram);
+
+    // free digest indices
+    del_digest_index(&dh->eid_digest);
+    del_digest_index(&dh->sha1f_digest);
+    del_digest_index(&dh->sha256f_digest);
+    del_digest_index(&dh->sha512f_digest);
+    del_digest_index(&dh->mrklf_digest);
+    del_digest_index(&dh->sha1s_digest);
+    del_digest_index(&dh->sha256s_digest);
+    del_digest_index(&dh->sha512s_digest);
+
+    // free fuzzy index
+    HASH_ITER(hh, dh->fuzzy_index, temp_gram, temp_gram_tmp) {
+        HASH_DEL(dh->fuzzy_index, temp_gram);
+        free(temp_gram->fd);
+        free(temp_gram);
+    }
+    dh->fuzzy_num = 0;
+
+    // free extract index
+    HASH_ITER(hh, dh->extract_index, temp_bucket, temp_bucket_tmp) {
+        HASH_DEL(dh->extract_index, temp_bucket);
+        free(temp_bucket->fd);
+        free(temp_bucket);
+    }
+    dh->extract_index_num = 0;
+
+    // free paths of file data still waiting to be hashed
+    for (temp_file_data = dh->pending_head; temp_file_data; temp_file_data = temp_file_data->next_pending) {
+        free(temp_file_data->pending_path);
+    }
+    dh->pending_head = NULL;
+    dh->pending_tail = NULL;
+    dh->pending_num = 0;
+
+    // free strings and child indices of entries
+    fres_entry_strs(&dh->tree);
+    fres_child_index(&dh->tree);
+    for (i = 0; i < dh->l2_entry_arr.l1_arr_map.length * L1_ENTRY_ARR_SIZE; i++) {
+        if (get_entry_from_layer2_arr(&dh->l2_entry_arr, &temp_entry, i)) {
+            continue;   // slot not used
+        }
+        fres_entry_strs(temp_entry);
+        fres_child_index(temp_entry);
+    }
+
+    // free interned file names and tag strings
+    fres_str_intern(&dh->strs);
+
+    // free sections of file data
+    for (i = 0; i < dh->l2_file_data_arr.l1_arr_map.length * L1_FILE_DATA_ARR_SIZE; i++) {
+        if (get_file_data_from_layer2_arr(&dh->l2_file_data_arr, &temp_file_data, i)) {
+            continue;   // slot not used
+        }
+        fres_section_array(temp_file_data);
+    }
+
+    // free postings of translation structures
+    fres_fn_to_e_postings           (   dh->fn_to_e                     );
+    fres_tag_to_e_postings          (   dh->tag_to_e                    );
+    fres_sha1f_to_fd_postings       (   dh->sha1f_to_fd                 );
+    fres_sha256f_to_fd_postings     (   dh->sha256f_to_fd               );
+    fres_sha512f_to_fd_postings     (   dh->sha512f_to_fd               );
+    fres_mrklf_to_fd_postings       (   dh->mrklf_to_fd                 );
+    fres_f_size_to_fd_postings      (   dh->f_size_to_fd                );
+    HASH_ITER(hh, dh->sha1s_to_s, temp_sha1s_to_s, temp_sha1s_to_s_tmp) {
+        free(temp_sha1s_to_s->tar);
+    }
+    HASH_ITER(hh, dh->sha256s_to_s, temp_sha256s_to_s, temp_sha256s_to_s_tmp) {
+        free(temp_sha256s_to_s->tar);
+    }
+    HASH_ITER(hh, dh->sha512s_to_s, temp_sha512s_to_s, temp_sha512s_to_s_tmp) {
+        free(temp_sha512s_to_s->tar);
+    }
+
     // free allocations recorded in misc alloc record
     i = 0;
     ret = 0;
@@ -986,6 +2672,7 @@ int fres_database_handle(database_handle* dh) {
     del_l2_sha1f_to_fd_arr          (   &dh->l2_sha1f_to_fd_arr         );
     del_l2_sha256f_to_fd_arr        (   &dh->l2_sha256f_to_fd_arr       );
     del_l2_sha512f_to_fd_arr        (   &dh->l2_sha512f_to_fd_arr       );
+    del_l2_mrklf_to_fd_arr          (   &dh->l2_mrklf_to_fd_arr         );
     del_l2_sha1s_to_s_arr           (   &dh->l2_sha1s_to_s_arr          );
     del_l2_sha256s_to_s_arr         (   &dh->l2_sha256s_to_s_arr        );
     del_l2_sha512s_to_s_arr         (   &dh->l2_sha512s_to_s_arr        );
@@ -995,8 +2682,6 @@ int fres_database_handle(database_handle* dh) {
     del_l2_entry_arr                (   &dh->l2_entry_arr               );
     del_l2_file_data_arr            (   &dh->l2_file_data_arr           );
     del_l2_misc_alloc_record_arr    (   &dh->l2_misc_alloc_record_arr   );
-    del_l2_section_arr              (   &dh->l2_section_arr             );
-    del_l2_dtt_year_arr             (   &dh->l2_dtt_year_arr            );
 
     return 0;
 }
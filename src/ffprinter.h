@@ -16,7 +16,11 @@
  *  along with ffprinter.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// files asking for more (e.g. _GNU_SOURCE) get _XOPEN_SOURCE from features.h,
+// which must not be redefined when this header is included again
+#ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -83,6 +87,8 @@
 #define CHECKSUM_MAX_LEN    64
 #define CHECKSUM_STR_MAX    (CHECKSUM_MAX_LEN * 2)
 
+#define DIGEST_STATE_BLOCK  128     // multiple of sha1, sha256 and sha512 block sizes
+
 #define FILE_SIZE_STR_MAX   20
 #define FILE_SIZE_MAX       UINT64_C(109951162777600)     // 100 TB
 
@@ -138,6 +144,7 @@
 #define INDEX_OUT_OF_RANGE  46
 #define INVALID_HEX_STR     47
 
+// L2_*_GROW_SIZE is the minimum number of L1 arrays added at once, see note on layer 2 arrays
 #define L1_EID_TO_E_ARR_SIZE    100
 #define L2_EIE_INIT_SIZE        2
 #define L2_EIE_GROW_SIZE        1
@@ -170,18 +177,10 @@
 #define L2_FILE_DATA_INIT_SIZE  1
 #define L2_FILE_DATA_GROW_SIZE  1
 
-#define L1_SECT_ARR_SIZE        100
-#define L2_SECT_INIT_SIZE       1
-#define L2_SECT_GROW_SIZE       1
-
 #define L1_MISC_ALLOC_ARR_SIZE  100
 #define L2_MISC_ALLOC_INIT_SIZE 1
 #define L2_MISC_ALLOC_GROW_SIZE 1
 
-#define L1_DTT_YEAR_ARR_SIZE    10
-#define L2_DTT_YEAR_INIT_SIZE   1
-#define L2_DTT_YEAR_GROW_SIZE   1
-
 #define L1_SECT_FIELD_ARR_SIZE  1000
 #define L2_SECT_FIELD_INIT_SIZE 1
 #define L2_SECT_FIELD_GROW_SIZE 1
@@ -190,16 +189,26 @@
 #define ENTRY_FILE              0x11
 #define ENTRY_GROUP             0x22
 
-#define CHECKSUM_MAX_NUM        3
+#define CHECKSUM_MAX_NUM        4
 
 #define CHECKSUM_SHA1_INDEX     0
 #define CHECKSUM_SHA256_INDEX   1
 #define CHECKSUM_SHA512_INDEX   2
+#define CHECKSUM_MRKL_INDEX     3   // file wise only
 
 #define CHECKSUM_UNUSED         0x00
 #define CHECKSUM_SHA1_ID        0x01
 #define CHECKSUM_SHA256_ID      0x02
 #define CHECKSUM_SHA512_ID      0x03
+#define CHECKSUM_MRKL_ID        0x04
+
+#define MRKL_DIGEST_LENGTH      32  // sha256
+#define MRKL_LEVEL_MAX          64
+
+#define TREE_DIGEST_LENGTH      32  // sha256
+
+#define FUZZY_SIG_MAX           64  // length of first signature, second is half of it
+#define FUZZY_STR_MAX           (20 + 1 + FUZZY_SIG_MAX + 1 + FUZZY_SIG_MAX / 2)  // "block size:sig1:sig2"
 
 #define CREATED_BY_SYS          0x02
 #define CREATED_BY_USR          0x04
@@ -224,6 +233,10 @@
 #define FIELD_REC_USE_S_SHA1    UINT32_C(0x00000020)
 #define FIELD_REC_USE_S_SHA256  UINT32_C(0x00000040)
 #define FIELD_REC_USE_S_SHA512  UINT32_C(0x00000080)
+#define FIELD_REC_USE_F_MRKL    UINT32_C(0x00000100)
+#define FIELD_REC_USE_E_TADD    UINT32_C(0x00000200)
+#define FIELD_REC_USE_E_TMOD    UINT32_C(0x00000400)
+#define FIELD_REC_USE_E_TUSR    UINT32_C(0x00000800)
 
 #define sizeof_member(type, member) sizeof(((type*)0)->member)
 
@@ -307,6 +320,8 @@ int mem_wipe_sec(void* ptr, uint64_t size);
 typedef uint64_t str_len_int;
 
 typedef struct linked_entry linked_entry;
+typedef struct child_index  child_index;
+typedef struct child_cursor child_cursor;
 
 typedefs_trans(eid,         e   )
 typedefs_trans(fn,          e   )
@@ -314,6 +329,7 @@ typedefs_trans(tag,         e   )
 typedefs_trans(sha1f,       fd  )
 typedefs_trans(sha256f,     fd  )
 typedefs_trans(sha512f,     fd  )
+typedefs_trans(mrklf,       fd  )
 typedefs_trans(sha1s,       s   )
 typedefs_trans(sha256s,     s   )
 typedefs_trans(sha512s,     s   )
@@ -323,19 +339,20 @@ typedef struct file_data        file_data;
 typedef struct checksum_result  checksum_result;
 typedef struct extract_sample   extract_sample;
 typedef struct section          section;
+typedef struct sect_ref         sect_ref;
+typedef struct digest_state     digest_state;
+typedef struct fuzzy_digest     fuzzy_digest;
+typedef struct fuzzy_gram       fuzzy_gram;
+typedef struct extract_bucket   extract_bucket;
 
 typedef struct misc_alloc_record misc_alloc_record;
 
 typedefs_obj_arr(entry)
 typedefs_obj_arr(file_data)
-typedefs_obj_arr(section)
 typedefs_obj_arr(misc_alloc_record)
-typedefs_obj_arr(dtt_year)
 
-typedef struct dtt_year     dtt_year;
-typedef struct dtt_month    dtt_month;
-typedef struct dtt_day      dtt_day;
-typedef struct dtt_hour     dtt_hour;
+typedef struct time_node    time_node;
+typedef struct time_index   time_index;
 
 typedef uint64_t ffp_bid_int;
 typedef uint64_t ffp_eid_int;
@@ -353,6 +370,198 @@ struct uniq_char_map {
 
 int init_uniq_char_map (uniq_char_map* uniq_char);
 
+/*  Note on gram index :
+ *      inverted index used for partial matching of file names, tags and file size strings,
+ *      maps each run of GRAM_LEN characters (gram) to sorted list of indices (in layer 2 array)
+ *      of translation structures whose string contains the gram
+ *
+ *      lookup intersects lists of up to GRAM_QUERY_MAX rarest grams of the string to find,
+ *      then checks string of each candidate left, so only exact matches are returned
+ *      strings to find shorter than GRAM_LEN have no gram, lookup then goes through
+ *      the layer 2 array instead
+ *
+ *      list is split into blocks of at most GRAM_BLOCK_MAX indices, first index of block
+ *      is stored as is, the rest as gaps to previous index (varint encoded), blocks are
+ *      picked by binary search, so adding or deleting an index only touches one block
+ */
+#define GRAM_LEN            3
+#define GRAM_BLOCK_MAX      128
+#define GRAM_QUERY_MAX      8
+
+typedef struct gram_block gram_block;
+typedef struct gram_posting gram_posting;
+typedef struct gram_index gram_index;
+typedef struct gram_cursor gram_cursor;
+typedef struct gram_iter gram_iter;
+
+struct gram_block {
+    bit_index first;
+    bit_index last;
+    uint32_t num;           // number of indices
+    uint32_t len;           // bytes of gap used
+    uint32_t max;           // bytes of gap allocated
+    unsigned char* gap;     // NULL if block has only one index
+};
+
+struct gram_posting {
+    uint32_t key;           // characters of gram
+    uint32_t block_num;
+    uint32_t block_max;
+    gram_block* block;
+    uint64_t num;           // number of indices in all blocks
+
+    UT_hash_handle hh;
+};
+
+struct gram_index {
+    gram_posting* htab;
+    uint64_t gram_num;      // number of distinct grams
+    uint64_t str_num;       // number of strings indexed
+};
+
+struct gram_cursor {
+    gram_posting* post;
+    uint32_t block;         // block decoded into val, block_num once past the end
+    uint32_t pos;
+    uint32_t num;
+    bit_index val[GRAM_BLOCK_MAX];
+};
+
+struct gram_iter {
+    gram_cursor cur[GRAM_QUERY_MAX];    // sorted by length of list, shortest first
+    uint32_t cur_num;
+    unsigned char scan;     // no gram to use, go through all indices below limit
+    bit_index next;         // smallest index not yet returned
+    bit_index limit;
+};
+
+int init_gram_index (gram_index* index);
+
+int add_str_to_gram_index (gram_index* index, const char* str, str_len_int str_len, bit_index id);
+
+int del_str_from_gram_index (gram_index* index, const char* str, str_len_int str_len, bit_index id);
+
+int del_gram_index (gram_index* index);
+
+// limit is used only if str_part is shorter than GRAM_LEN, returns FIND_FAIL if some gram is not indexed
+int gram_iter_init (gram_iter* iter, gram_index* index, const char* str_part, str_len_int str_part_len, bit_index limit);
+
+int gram_iter_next (gram_iter* iter, bit_index* id);
+
+// skip indices below id
+int gram_iter_skip (gram_iter* iter, bit_index id);
+
+/*  Note on string interning :
+ *      file names and tag strings are stored once per database, every distinct
+ *      string gets a 32 bit id, so entries and translation structures only keep
+ *      the id and a pointer to the stored string, equal strings have equal ids
+ *
+ *      strings are copied into fixed size chunks which are never moved, so the
+ *      pointers stay valid until the database is freed, strings are not released
+ *      earlier even if no entry uses them anymore
+ *
+ *      id 0 is always the empty string
+ */
+#define STR_ID_EMPTY                0
+#define STR_INTERN_CHUNK_SIZE       65536   // must be larger than any interned string
+#define STR_INTERN_INIT_SLOT_NUM    1024    // must be power of 2
+
+typedef uint32_t str_id;
+
+typedef struct str_intern_chunk str_intern_chunk;
+typedef struct str_intern_rec str_intern_rec;
+typedef struct str_intern str_intern;
+
+struct str_intern_chunk {
+    str_intern_chunk* next;     // older chunk
+    uint32_t used;
+    char data[STR_INTERN_CHUNK_SIZE];
+};
+
+struct str_intern_rec {
+    const char* str;
+    str_len_int len;
+    uint32_t hash;
+};
+
+struct str_intern {
+    str_intern_rec* rec;        // indexed by id
+    uint32_t rec_num;
+    uint32_t rec_size;
+
+    uint32_t* slot;             // open addressing, holds id + 1, 0 if free
+    uint32_t slot_num;
+
+    str_intern_chunk* chunk;    // chunk being filled
+};
+
+#define str_intern_get(strs, id)    ((strs)->rec[(id)].str)
+
+int init_str_intern (str_intern* strs);
+
+// adds string if not interned already
+int str_intern_add (str_intern* strs, const char* str, str_len_int len, str_id* id);
+
+// returns FIND_FAIL if string was never interned
+int str_intern_find (const str_intern* strs, const char* str, str_len_int len, str_id* id);
+
+int fres_str_intern (str_intern* strs);
+
+/*  Note on digest index :
+ *      crit-bit tree used for prefix matching of entry ids and checksums,
+ *      leaves are the translation structures themselves, which start with the key,
+ *      each internal node records the first bit where the keys below it differ
+ *      so there is exactly one internal node per key after the first
+ *
+ *      prefix lookup walks down while the node tests a bit inside the prefix,
+ *      then checks the prefix against any leaf below, all leaves below then match,
+ *      and are returned in order of key by the cursor
+ *
+ *      prefixes are counted in bits so odd numbers of hex digits work
+ */
+#define DIGEST_KEY_MAX_LEN      64      // largest key, SHA512_DIGEST_LENGTH
+#define DIGEST_DEPTH_MAX        (DIGEST_KEY_MAX_LEN * 8)
+
+typedef struct digest_node digest_node;
+typedef struct digest_index digest_index;
+typedef struct digest_cursor digest_cursor;
+
+struct digest_node {
+    void* child[2];         // tagged with 1 in lowest bit if internal node
+    uint32_t byte;          // byte of critical bit
+    unsigned char other_bits;   // all bits set except critical bit
+};
+
+struct digest_index {
+    void* root;
+    uint32_t key_len;
+    uint64_t num;           // number of keys
+};
+
+struct digest_cursor {
+    void* stack[DIGEST_DEPTH_MAX + 1];
+    uint32_t depth;
+};
+
+int init_digest_index (digest_index* index, uint32_t key_len);
+
+// key is read from start of obj, returns DUPLICATE_ERROR if key already indexed
+int add_to_digest_index (digest_index* index, void* obj);
+
+int del_from_digest_index (digest_index* index, void* obj);
+
+int del_digest_index (digest_index* index);
+
+// turns hex digits into prefix, returns INVALID_HEX_STR if not hex or too long for key_len
+int hex_to_digest_prefix (unsigned char* prefix, uint32_t* prefix_bits, const char* hex, uint32_t key_len);
+
+int match_digest_prefix (const unsigned char* key, const unsigned char* prefix, uint32_t prefix_bits);
+
+// cursor returns every key starting with prefix, in order
+int digest_cursor_init (digest_cursor* cursor, digest_index* index, const unsigned char* prefix, uint32_t prefix_bits);
+
+int digest_cursor_next (digest_cursor* cursor, void** obj);
+
 struct misc_alloc_record {
     unsigned char* ptr;
 
@@ -363,70 +572,96 @@ struct misc_alloc_record {
 /* global variables */
 // none
 
+/*  Note on time index :
+ *      each kind of time (addition, modification, user specified) has its own
+ *      index of entries, ordered by time and then by obj_arr_index of entry,
+ *      so no two entries share a key
+ *
+ *      the index is a treap linked through time_node in the entries themselves,
+ *      priority of an entry is taken from its entry id, which is random, so the
+ *      tree stays balanced in expectation, and linking, unlinking and finding
+ *      start of a time range all take O(log n)
+ *
+ *      range lookups either mark obj_arr_index of matching entries in a bitmap,
+ *      to be combined with other fields by find_entry_in_sub_branch, or fill
+ *      a buffer in ascending order of time, see lookup_date_time
+ */
+struct time_node {
+    linked_entry* left;
+    linked_entry* right;
+};
+
+struct time_index {
+    linked_entry* root;
+    uint64_t num;               // number of entries linked
+};
+
+/*  Note on entry layout :
+ *      linked_entry holds only what tree walks and index linkage need,
+ *      names and tags are interned in the database (see string interning),
+ *      messages are allocated to fit and times are kept as seconds since epoch,
+ *      hex forms of ids are made when displayed
+ *
+ *      empty strings all point to one shared empty string, which must never
+ *      be written to, so set_entry_file_name and friends are the only ways to
+ *      change the strings
+ */
 /* main structure for tree */
 struct linked_entry {
     linked_entry* parent;
     linked_entry** child;
     bit_index child_arr_misc_record_number;
+    child_index* child_idx;         // null until made, see note on child index
+    ffp_eid_int child_slot;         // slot in parent->child
 
     unsigned char created_by;
 
-    linked_entry* prev_same_fn;     // prev entry with same file name
-    linked_entry* next_same_fn;     // next entry with same file name
-
     t_fn_to_e* fn_to_e;
-
-    linked_entry* prev_same_tag;     // prev entry with same tag
-    linked_entry* next_same_tag;     // next entry with same tag
+    uint32_t fn_slot;               // slot in fn_to_e->tar
 
     t_tag_to_e* tag_to_e;
+    uint32_t tag_slot;              // slot in tag_to_e->tar
 
-    linked_entry* tod_prev_sort_min;    // prev entry in same hour, sorted by minute
-    linked_entry* tod_next_sort_min;    // next entry in same hour, sorted by minute
-
-    dtt_hour* tod_hour;
-
-    linked_entry* tom_prev_sort_min;    // prev entry in same hour, sorted by minute
-    linked_entry* tom_next_sort_min;    // next entry in same hour, sorted by minute
-
-    dtt_hour* tom_hour;
-
-    linked_entry* tusr_prev_sort_min;
-    linked_entry* tusr_next_sort_min;
-
-    dtt_hour* tusr_hour;
+    time_node tod_node;             // links in time of addition index, see note on time index
+    time_node tom_node;             // links in time of modification index
+    time_node tusr_node;            // links in user specified time index
 
     ffp_eid_int child_num;                  // number of used children slot
     ffp_eid_int child_free_num;             // number of free children slot
-    unsigned char branch_id[EID_LEN];       // entry id of head of branch
-    char branch_id_str[EID_STR_MAX+1];
     ffp_eid_int depth;                  // not stored in file, depth of tree root is 0, 1 for head of branch, add 1 for deeper levels and so on
-    unsigned char entry_id[EID_LEN];
-    char entry_id_str[EID_STR_MAX+1];
+    unsigned char branch_id[EID_LEN];       // entry id of head of branch
+    unsigned char entry_id[EID_LEN];    // hex form is only made when needed, see bytes_to_hex_str
     unsigned char has_parent;           // not stored in file, 0 if head of branch
 
+    uint8_t type;
+
+    unsigned char tod_utc_used;     // time of addition usage indicator
+    unsigned char tom_utc_used;     // time of modification usage indicator
+    unsigned char tusr_utc_used;    // user specified time usage indicator
+
     t_eid_to_e* eid_to_e;
 
-    char file_name[FILE_NAME_MAX + 1];  // should always be terminated by null character
+    /* strings below are never null, see set_entry_file_name */
+    const char* file_name;              // interned, should always be terminated by null character
+    str_id file_name_id;
     str_len_int file_name_len;          // never counts null character
 
-    uint8_t type;
-
-    char tag_str[TAG_STR_MAX + 1];
+    const char* tag_str;                // interned
+    str_id tag_str_id;
     str_len_int tag_str_len;
 
-    char user_msg[USER_MSG_MAX + 1];
+    char* user_msg;                     // never null
     str_len_int user_msg_len;
 
-    unsigned char tod_utc_used;     // time of addition usage indicator
-    struct tm tod_utc;              // time of addition, UTC time zone
-    unsigned char tom_utc_used;     // time of modification usage indicator
-    struct tm tom_utc;              // time of modification, UTC time zone
-    unsigned char tusr_utc_used;    // user specified time usage indicator
-    struct tm tusr_utc;             // user specified time, defaults to nothing
+    int64_t tod_utc;                // time of addition, seconds since epoch (UTC)
+    int64_t tom_utc;                // time of modification, seconds since epoch (UTC)
+    int64_t tusr_utc;               // user specified time, seconds since epoch (UTC), defaults to nothing
 
     file_data* data; // may be null, if the entry is group, or is intended to be purely informative
 
+    unsigned char tree_sum[TREE_DIGEST_LENGTH];     // not stored in file, sum of tree hash of children
+    unsigned char tree_hash[TREE_DIGEST_LENGTH];    // not stored in file, contribution to tree sum of parent
+
 /* Temporary linkage */
     linked_entry* link_prev;
     linked_entry* link_next;
@@ -435,45 +670,121 @@ struct linked_entry {
     obj_meta_data_fields;
 };
 
-/* structure for translation */
-generic_trans_struct_one_to_one(eid,        e,  linked_entry,   EID_STR_MAX)
-generic_trans_struct_one_to_many(fn,        e,  linked_entry,   FILE_NAME_MAX)
-generic_trans_struct_one_to_many(tag,       e,  linked_entry,   TAG_STR_MAX)
-generic_trans_struct_one_to_many(sha1f,     fd, file_data,      CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(sha256f,   fd, file_data,      CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(sha512f,   fd, file_data,      CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(sha1s,     s,  section,        CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(sha256s,   s,  section,        CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(sha512s,   s,  section,        CHECKSUM_STR_MAX)
-generic_trans_struct_one_to_many(f_size,    fd, file_data,      FILE_SIZE_STR_MAX)
-
-/* structures for tree of date time */
-// dtt = date time tree
-
-struct dtt_hour {
-    unsigned char in_use;
-    linked_entry* head;
-};
+/*  Note on child index :
+ *      a parent with CHILD_INDEX_MIN_NUM or more children keeps an open addressing
+ *      table of its children keyed by file name id, so a child is found by name
+ *      without going through the children array, children with same name simply
+ *      take consecutive slots
+ *
+ *      the table is kept up to date by put_into_children_array, del_entry and
+ *      set_entry_file_name, and is freed along with the parent
+ *
+ *      a copy of the children array sorted by file name is made on request,
+ *      see get_sorted_children, and kept until the children change
+ *
+ *      children arrays grow geometrically, and an entry is removed from its parent
+ *      by moving the last child into its slot, so the order of children is not kept
+ */
+#define CHILD_INDEX_MIN_NUM         32
+#define CHILD_INDEX_INIT_SLOT_NUM   64      // must be power of 2
+#define CHILD_ARR_MIN_GROW_NUM      4
 
-struct dtt_day {
-    unsigned char in_use;
-    dtt_hour hour[24];
-};
+struct child_index {
+    linked_entry** slot;        // null if free
+    uint64_t slot_num;
+    uint64_t used_num;
 
-struct dtt_month {
-    unsigned char in_use;
-    dtt_day day[31];
+    linked_entry** sorted;      // null if not made or children changed since
 };
 
-struct dtt_year {
-    int year;       // always store actual year rather than offset from 1900
-    dtt_year* next;
-    dtt_month month[12];
-
-/* Pool allocator structure */
-    obj_meta_data_fields;
+struct child_cursor {
+    const linked_entry* parent;
+    str_id id;
+    uint64_t pos;               // slot in child index, or in children array if no index
 };
 
+/*  Note on binary keys :
+ *      hash tables of entry ids and checksums are keyed on the raw bytes
+ *      rather than the hex string, hex is only used for display and is turned
+ *      into a prefix for partial matching (see digest index)
+ *
+ *      these keys are (close to) uniformly random already and at least 8 bytes
+ *      long, so the first 8 bytes folded into 32 bits are used as the hash value
+ *      directly instead of running the key through HASH_FCN
+ *
+ *      such tables must only be added to and searched with HASH_ADD_DIGEST and
+ *      HASH_FIND_DIGEST, deletion, iteration and bucket expansion go through
+ *      uthash as usual, as those only use the stored hash value
+ */
+#define DIGEST_KEY_HASH(keyptr, hashv) \
+do {                                                                        \
+    uint64_t _dk_val;                                                       \
+    memcpy(&_dk_val, (keyptr), sizeof(uint64_t));                          \
+    (hashv) = (unsigned) (_dk_val ^ (_dk_val >> 32));                       \
+} while (0)
+
+#define HASH_FIND_DIGEST(head, keyptr, keylen_in, out) \
+do {                                                                        \
+    out = NULL;                                                             \
+    if (head != NULL) {                                                     \
+        unsigned _hf_bkt, _hf_hashv;                                        \
+        DIGEST_KEY_HASH(keyptr, _hf_hashv);                                 \
+        HASH_TO_BKT(_hf_hashv, (head)->hh.tbl->num_buckets, _hf_bkt);       \
+        if (HASH_BLOOM_TEST((head)->hh.tbl, _hf_hashv) != 0) {              \
+            HASH_FIND_IN_BKT((head)->hh.tbl, hh, (head)->hh.tbl->buckets[_hf_bkt], keyptr, keylen_in, out);\
+        }                                                                   \
+    }                                                                       \
+} while (0)
+
+#define HASH_ADD_DIGEST(head, fieldname, keylen_in, add) \
+do {                                                                        \
+    unsigned _ha_bkt;                                                       \
+    (add)->hh.next = NULL;                                                  \
+    (add)->hh.key = (char*) &((add)->fieldname);                            \
+    (add)->hh.keylen = (unsigned) (keylen_in);                              \
+    if (!(head)) {                                                          \
+        head = (add);                                                       \
+        (head)->hh.prev = NULL;                                             \
+        HASH_MAKE_TABLE(hh, head);                                          \
+    }                                                                       \
+    else {                                                                  \
+        (head)->hh.tbl->tail->next = (add);                                 \
+        (add)->hh.prev = ELMT_FROM_HH((head)->hh.tbl, (head)->hh.tbl->tail);\
+        (head)->hh.tbl->tail = &((add)->hh);                                \
+    }                                                                       \
+    (head)->hh.tbl->num_items++;                                            \
+    (add)->hh.tbl = (head)->hh.tbl;                                         \
+    DIGEST_KEY_HASH((add)->hh.key, (add)->hh.hashv);                        \
+    HASH_TO_BKT((add)->hh.hashv, (head)->hh.tbl->num_buckets, _ha_bkt);     \
+    HASH_ADD_TO_BKT((head)->hh.tbl->buckets[_ha_bkt], &(add)->hh);          \
+    HASH_BLOOM_ADD((head)->hh.tbl, (add)->hh.hashv);                        \
+    HASH_FSCK(hh, head);                                                    \
+} while (0)
+
+/*  Note on postings :
+ *      translation structures of one to many mappings keep their targets in
+ *      one array (tar), each target remembers its slot in the array, so
+ *      removal moves the last target into the slot instead of searching
+ *
+ *      most names, sizes and digests have a single target, so the first one is
+ *      kept in tar_one and the array is only allocated for the second one,
+ *      translation structures must therefore not be moved while in use
+ *
+ *      order of targets is not kept across removal
+ */
+/* structure for translation */
+generic_trans_struct_one_to_one_key(eid,        e,  linked_entry,   EID_LEN)
+generic_trans_struct_one_to_many_str_id(fn,     e,  linked_entry)
+generic_trans_struct_one_to_many_str_id(tag,    e,  linked_entry)
+generic_trans_struct_one_to_many_key(sha1f,     fd, file_data,      SHA_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_key(sha256f,   fd, file_data,      SHA256_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_key(sha512f,   fd, file_data,      SHA512_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_key(mrklf,     fd, file_data,      MRKL_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_sect_key(sha1s,    s,  SHA_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_sect_key(sha256s,  s,  SHA256_DIGEST_LENGTH)
+generic_trans_struct_one_to_many_sect_key(sha512s,  s,  SHA512_DIGEST_LENGTH)
+generic_trans_struct_one_to_many(f_size,        fd, file_data,      FILE_SIZE_STR_MAX)
+
 struct checksum_result {
     uint16_t type;
     uint16_t len;
@@ -491,37 +802,98 @@ struct extract_sample {
 
 int copy_extract_sample(extract_sample* dst, extract_sample* src);
 
-struct section {
-    uint64_t start_pos;     // start position in file
-    uint64_t end_pos;       // end position in file
+/*  Note on section layout :
+ *      sections of a file data are kept in one array (section), indexed by
+ *      section number, digests of sections are kept in one array per checksum
+ *      type (sect_digest), and extracts in one more array (sect_extract), each
+ *      array is only allocated once a section uses it
+ *
+ *      positions of continuous sections are derived from norm_sect_size and
+ *      last_sect_size, start and end positions (sect_pos) are only stored for
+ *      non-continuous sections, which have both sizes set to 0
+ *
+ *      sections are linked to digest translation structures by (file data,
+ *      section number) pairs kept in the translation structure, so sections
+ *      have to be unlinked before they are moved or deleted
+ *
+ *      only the first SECT_CHECKSUM_NUM checksum indices are used by sections
+ */
+#define SECT_CHECKSUM_NUM   3
 
-    checksum_result checksum[CHECKSUM_MAX_NUM];
-    uint16_t checksum_num;
-    extract_sample extract[EXTRACT_MAX_NUM];
+struct section {
     uint32_t extract_num;
+    uint32_t checksum_used;     // bit (1 << checksum index) is set for each checksum present
+};
 
-/* Translation structures */
-    section* prev_same_sha1;
-    section* next_same_sha1;
+struct sect_ref {
+    file_data* data;
+    uint64_t index;
+};
 
-    section* prev_same_sha256;
-    section* next_same_sha256;
+#define sect_has_checksum(data, sect_index, chks_index) \
+    ((data)->section[(sect_index)].checksum_used & (1 << (chks_index)))
 
-    section* prev_same_sha512;
-    section* next_same_sha512;
+// only valid if section has the checksum
+#define sect_digest(data, sect_index, chks_index) \
+    ((data)->sect_digest[(chks_index)] + (sect_index) * sect_checksum_len[(chks_index)])
 
-    t_sha1s_to_s*      sha1s_to_s;
-    t_sha256s_to_s*    sha256s_to_s;
-    t_sha512s_to_s*    sha512s_to_s;
+// NULL if no section of data has extracts
+#define sect_extract(data, sect_index) \
+    ((data)->sect_extract ? (data)->sect_extract + (sect_index) * EXTRACT_MAX_NUM : NULL)
 
-/* Parent linkage */
-    file_data* parent_file_data;
+extern const uint16_t sect_checksum_type[SECT_CHECKSUM_NUM];
+extern const uint16_t sect_checksum_len[SECT_CHECKSUM_NUM];
 
-/* Pool allocator structure */
-    obj_meta_data_fields;
+/*  Note on digest state :
+ *      intermediate state of file wise checksums, taken at the last
+ *      DIGEST_STATE_BLOCK boundary within the file, so checksums of
+ *      appended file can be continued from there instead of from start
+ *
+ *      as pos is always at block boundary, no buffered data is kept,
+ *      and bit count is derived from pos
+ *
+ *      flags is 0 if no state is present
+ */
+struct digest_state {
+    uint64_t pos;               // number of bytes hashed
+    uint32_t flags;             // fingerprint flags used when state was taken
+    uint32_t sha1_h     [5];
+    uint32_t sha256_h   [8];
+    uint64_t sha512_h   [8];
+};
 
-/* Hash table structure */
-    //UT_hash_handle hh;
+/*  Note on fuzzy digest :
+ *      similarity digest of content, see ffp_fuzzy.h
+ *
+ *      signatures are base64 characters and null terminated,
+ *      block_size is 0 if no fuzzy digest is present
+ */
+struct fuzzy_digest {
+    uint64_t block_size;
+    uint8_t len1;
+    uint8_t len2;
+    char sig1[FUZZY_SIG_MAX + 1];
+    char sig2[FUZZY_SIG_MAX / 2 + 1];
+};
+
+// file data having a gram of fuzzy digest in common, keyed by block size and gram
+struct fuzzy_gram {
+    uint64_t key;
+    file_data** fd;
+    uint32_t fd_num;
+    uint32_t fd_max;
+
+    UT_hash_handle hh;
+};
+
+// file data of same size and extracts, keyed by hash of both
+struct extract_bucket {
+    uint64_t key;
+    file_data** fd;
+    uint32_t fd_num;
+    uint32_t fd_max;
+
+    UT_hash_handle hh;
 };
 
 struct file_data {
@@ -534,8 +906,8 @@ struct file_data {
     uint32_t extract_num;
     char file_size_str[FILE_SIZE_STR_MAX+1];
 
-/* Section wise fields */
-    section**   section;            // sections are normally continuous
+/* Section wise fields, see note on section layout */
+    section*    section;            // sections are normally continuous
     uint64_t    section_num;        // number of used section slot
     uint64_t    section_free_num;   // number of free section slot
     // if one sets them to be non-continuous
@@ -543,25 +915,41 @@ struct file_data {
     // and both norm_sect_size and last_sect_size should be 0
     uint64_t    norm_sect_size;
     uint64_t    last_sect_size;
+    uint64_t*   sect_pos;           // start and end of each section, NULL if continuous
+    unsigned char* sect_digest[SECT_CHECKSUM_NUM];  // NULL if no section has the checksum
+    extract_sample* sect_extract;   // EXTRACT_MAX_NUM slots per section
 
-/* Translation structures */
-    file_data* prev_same_sha1;
-    file_data* next_same_sha1;
+/* Resumable state */
+    digest_state resume;
 
-    file_data* prev_same_sha256;
-    file_data* next_same_sha256;
+/* Fuzzy digest */
+    fuzzy_digest fuzzy;
+    uint64_t    fuzzy_mark;         // not stored in file, last lookup which visited this file data
 
-    file_data* prev_same_sha512;
-    file_data* next_same_sha512;
+/* Extract index */
+    uint64_t    extract_key;        // not stored in file, key file data is indexed under
+    unsigned char extract_indexed;  // not stored in file
 
+/* Deferred hashing */
+    uint32_t    pending_flags;      // flags content is still to be hashed with, 0 if not pending
+    char*       pending_path;       // absolute path of file in FS, NULL if not pending
+    file_data*  prev_pending;
+    file_data*  next_pending;
+
+/* Translation structures */
     t_sha1f_to_fd*     sha1f_to_fd;
     t_sha256f_to_fd*   sha256f_to_fd;
     t_sha512f_to_fd*   sha512f_to_fd;
+    t_mrklf_to_fd*     mrklf_to_fd;
 
-    file_data* prev_same_f_size;
-    file_data* next_same_f_size;
+    // slots in tar of translation structures above
+    uint32_t sha1f_slot;
+    uint32_t sha256f_slot;
+    uint32_t sha512f_slot;
+    uint32_t mrklf_slot;
 
     t_f_size_to_fd* f_size_to_fd;
+    uint32_t f_size_slot;
 
 /* Parent linkage */
     linked_entry* parent_entry;
@@ -582,13 +970,17 @@ typedefs_obj_arr(sect_field)
 struct field_record {
     uint64_t    field_usage_map;
     char        name        [FILE_NAME_MAX+1];
-    struct tm   tod_utc;
-    struct tm   tom_utc;
-    struct tm   tusr_utc;
+    int64_t     tod_from;       // time ranges are inclusive, seconds since epoch (UTC)
+    int64_t     tod_to;
+    int64_t     tom_from;
+    int64_t     tom_to;
+    int64_t     tusr_from;
+    int64_t     tusr_to;
     char        f_size      [FILE_SIZE_STR_MAX+1];
     char        f_sha1      [CHECKSUM_STR_MAX];
     char        f_sha256    [CHECKSUM_STR_MAX];
     char        f_sha512    [CHECKSUM_STR_MAX];
+    char        f_mrkl      [CHECKSUM_STR_MAX];
 
     sect_field**  sect;
     uint64_t sect_field_in_use_num;
@@ -613,10 +1005,14 @@ struct field_match_bitmap {
     simple_bitmap map_buf2;
 
     simple_bitmap map_name_match;
+    simple_bitmap map_tadd_match;
+    simple_bitmap map_tmod_match;
+    simple_bitmap map_tusr_match;
     simple_bitmap map_f_size_match;
     simple_bitmap map_f_sha1_match;
     simple_bitmap map_f_sha256_match;
     simple_bitmap map_f_sha512_match;
+    simple_bitmap map_f_mrkl_match;
     simple_bitmap map_s_sha1_match;
     simple_bitmap map_s_sha256_match;
     simple_bitmap map_s_sha512_match;
@@ -631,14 +1027,9 @@ layer2_obj_arr(entry)
 layer1_obj_arr(file_data, file_data, L1_FILE_DATA_ARR_SIZE)
 layer2_obj_arr(file_data)
 
-layer1_obj_arr(section, section, L1_SECT_ARR_SIZE)
-layer2_obj_arr(section)
-
 layer1_obj_arr(misc_alloc_record, misc_alloc_record, L1_MISC_ALLOC_ARR_SIZE)
 layer2_obj_arr(misc_alloc_record)
 
-layer1_obj_arr(dtt_year, dtt_year, L1_DTT_YEAR_ARR_SIZE)
-layer2_obj_arr(dtt_year)
 
 // max length excluding null character
 int verify_str_terminated (const char* str, str_len_int max_len, str_len_int* length, uint32_t flags);
@@ -661,14 +1052,20 @@ int bytes_to_hex_str (char* dst, unsigned char* ptr, uint32_t size);
 
 int hex_str_to_bytes (unsigned char* dst, char* src);
 
+// same as timegm, but not limited by time_t
+int64_t utc_tm_to_epoch (const struct tm* tm);
+
+// same as gmtime, but fills in tm given
+int epoch_to_utc_tm (int64_t epoch, struct tm* tm);
+
 // entry id translation
 
-generic_exist_mat(eid, EID_STR_MAX)
+generic_digest_index(eid)
 layer1_generic_arr(eid, e, L1_EID_TO_E_ARR_SIZE)
 layer2_generic_arr(eid, e)
 
 int init_eid_to_e (t_eid_to_e* eid_to_e);
-int init_eid_exist_mat (eid_exist_mat* matrix);
+int init_eid_digest_index (eid_digest_index* index);
 int init_layer2_eid_to_e_arr (layer2_eid_to_e_arr* l2_arr);
 
 int add_eid_to_e_to_htab (t_eid_to_e** htab, t_eid_to_e* eid_to_e);
@@ -681,24 +1078,24 @@ int get_l1_eid_to_e_from_layer2_arr (layer2_eid_to_e_arr* l2_arr, layer1_eid_to_
 
 int del_l2_eid_to_e_arr (layer2_eid_to_e_arr* l2_arr);
 
-int add_eid_to_eid_exist_mat (eid_exist_mat* matrix, char* eid_str, bit_index index_in_arr);
-int del_eid_from_eid_exist_mat (eid_exist_mat* matrix, layer2_eid_to_e_arr* l2_arr, bit_index index_in_arr);
+int add_eid_to_eid_digest_index (eid_digest_index* index, t_eid_to_e* target);
+int del_eid_from_eid_digest_index (eid_digest_index* index, layer2_eid_to_e_arr* l2_arr, bit_index index_in_arr);
 
 // for file name translation
 
-generic_exist_mat(fn, FILE_NAME_MAX)
+generic_gram_index(fn)
 layer1_generic_arr(fn, e, L1_FN_TO_E_ARR_SIZE)
 layer2_generic_arr(fn, e)
 
 int init_fn_to_e (t_fn_to_e* fn_to_e);
-int init_fn_exist_mat (fn_exist_mat* matrix);
 int init_layer2_fn_to_e_arr (layer2_fn_to_e_arr* l2_arr);
 
 int add_fn_to_e_to_htab (t_fn_to_e** htab, t_fn_to_e* fn_to_e);
 int del_fn_to_e_from_htab (t_fn_to_e** htab, t_fn_to_e* fn_to_e);
 
-int add_e_to_fn_to_e_chain (linked_entry* tar_entry, linked_entry* entry);
-int del_e_from_fn_to_e_chain (t_fn_to_e** htab, fn_exist_mat* matrix, layer2_fn_to_e_arr* l2_arr, linked_entry* entry);
+int add_e_to_fn_to_e_postings (t_fn_to_e* fn_to_e, linked_entry* entry);
+int del_e_from_fn_to_e_postings (t_fn_to_e** htab, fn_gram_index* index, layer2_fn_to_e_arr* l2_arr, linked_entry* entry);
+int fres_fn_to_e_postings (t_fn_to_e* htab);
 
 int add_fn_to_e_to_layer2_arr (layer2_fn_to_e_arr* l2_arr, t_fn_to_e** fn_to_e, bit_index* index);
 int del_fn_to_e_from_layer2_arr (layer2_fn_to_e_arr* l2_arr, bit_index index);
@@ -707,23 +1104,23 @@ int get_l1_fn_to_e_from_layer2_arr (layer2_fn_to_e_arr* l2_arr, layer1_fn_to_e_a
 
 int del_l2_fn_to_e_arr (layer2_fn_to_e_arr* l2_arr);
 
-int add_fn_to_fn_exist_mat (fn_exist_mat* matrix, char* file_name, bit_index index_in_arr);
-int del_fn_from_fn_exist_mat (fn_exist_mat* matrix, layer2_fn_to_e_arr* l2_arr, bit_index index_in_arr);
+int add_fn_to_fn_gram_index (fn_gram_index* index, const char* file_name, bit_index index_in_arr);
+int del_fn_from_fn_gram_index (fn_gram_index* index, layer2_fn_to_e_arr* l2_arr, bit_index index_in_arr);
 
 // for tag translation
-generic_exist_mat(tag, TAG_STR_MAX)
+generic_gram_index(tag)
 layer1_generic_arr(tag, e, L1_TAG_TO_E_ARR_SIZE)
 layer2_generic_arr(tag, e)
 
 int init_tag_to_e (t_tag_to_e* tag_to_e);
-int init_tag_exist_mat (tag_exist_mat* matrix);
 int init_layer2_tag_to_e_arr (layer2_tag_to_e_arr* l2_arr);
 
 int add_tag_to_e_to_htab (t_tag_to_e** htab, t_tag_to_e* tag_to_e);
 int del_tag_to_e_from_htab (t_tag_to_e** htab, t_tag_to_e* tag_to_e);
 
-int add_e_to_tag_to_e_chain (linked_entry* tar_entry, linked_entry* entry);
-int del_e_from_tag_to_e_chain (t_tag_to_e** htab, tag_exist_mat* matrix, layer2_tag_to_e_arr* l2_arr, linked_entry* entry);
+int add_e_to_tag_to_e_postings (t_tag_to_e* tag_to_e, linked_entry* entry);
+int del_e_from_tag_to_e_postings (t_tag_to_e** htab, tag_gram_index* index, layer2_tag_to_e_arr* l2_arr, linked_entry* entry);
+int fres_tag_to_e_postings (t_tag_to_e* htab);
 
 int add_tag_to_e_to_layer2_arr (layer2_tag_to_e_arr* l2_arr, t_tag_to_e** tag_to_e, bit_index* index);
 int del_tag_to_e_from_layer2_arr (layer2_tag_to_e_arr* l2_arr, bit_index index);
@@ -732,12 +1129,12 @@ int get_l1_tag_to_e_from_layer2_arr (layer2_tag_to_e_arr* l2_arr, layer1_tag_to_
 
 int del_l2_tag_to_e_arr (layer2_tag_to_e_arr* l2_arr);
 
-int add_tag_to_tag_exist_mat (tag_exist_mat* matrix, char* tag_str, bit_index index_in_arr);
-int del_tag_from_tag_exist_mat (tag_exist_mat* matrix, layer2_tag_to_e_arr* l2_arr, bit_index index_in_arr);
+int add_tag_to_tag_gram_index (tag_gram_index* index, const char* tag_str, bit_index index_in_arr);
+int del_tag_from_tag_gram_index (tag_gram_index* index, layer2_tag_to_e_arr* l2_arr, bit_index index_in_arr);
 
 /* For file data checksum */
 // sha1
-generic_exist_mat(sha1f, CHECKSUM_STR_MAX)
+generic_digest_index(sha1f)
 layer1_generic_arr(sha1f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 layer2_generic_arr(sha1f, fd)
 
@@ -747,8 +1144,8 @@ int init_layer2_sha1f_to_fd_arr (layer2_sha1f_to_fd_arr* l2_arr_arr);
 int add_sha1f_to_fd_to_htab (t_sha1f_to_fd** htab, t_sha1f_to_fd* target);
 int del_sha1f_to_fd_from_htab (t_sha1f_to_fd** htab, t_sha1f_to_fd* target);
 
-int add_sha1f_to_sha1f_exist_mat (sha1f_exist_mat* matrix, char* sha1_str, bit_index index_in_arr);
-int del_sha1f_from_sha1f_exist_mat (sha1f_exist_mat* matrix, layer2_sha1f_to_fd_arr* l2_arr, bit_index index_in_arr);
+int add_sha1f_to_sha1f_digest_index (sha1f_digest_index* index, t_sha1f_to_fd* target);
+int del_sha1f_from_sha1f_digest_index (sha1f_digest_index* index, layer2_sha1f_to_fd_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha1f_to_fd_to_layer2_arr (layer2_sha1f_to_fd_arr* l2_arr, t_sha1f_to_fd** target, bit_index* index);
 int del_sha1f_to_fd_from_layer2_arr (layer2_sha1f_to_fd_arr* l2_arr_arr, bit_index index);
@@ -757,11 +1154,12 @@ int get_l1_sha1f_to_fd_from_layer2_arr (layer2_sha1f_to_fd_arr* l2_arr_arr, laye
 
 int del_l2_sha1f_to_fd_arr (layer2_sha1f_to_fd_arr* l2_arr);
 
-int add_fd_to_sha1f_to_fd_chain (file_data* tar_fd, file_data* fd);
-int del_fd_from_sha1f_to_fd_chain (t_sha1f_to_fd** htab_p, sha1f_exist_mat* matrix_arr, layer2_sha1f_to_fd_arr* l2_arr_arr, file_data* fd);
+int add_fd_to_sha1f_to_fd_postings (t_sha1f_to_fd* sha1f_to_fd, file_data* fd);
+int del_fd_from_sha1f_to_fd_postings (t_sha1f_to_fd** htab_p, sha1f_digest_index* index, layer2_sha1f_to_fd_arr* l2_arr_arr, file_data* fd);
+int fres_sha1f_to_fd_postings (t_sha1f_to_fd* htab);
 
 // sha256
-generic_exist_mat(sha256f, CHECKSUM_STR_MAX)
+generic_digest_index(sha256f)
 layer1_generic_arr(sha256f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 layer2_generic_arr(sha256f, fd)
 
@@ -771,8 +1169,8 @@ int init_layer2_sha256f_to_fd_arr (layer2_sha256f_to_fd_arr* l2_arr_arr);
 int add_sha256f_to_fd_to_htab (t_sha256f_to_fd** htab, t_sha256f_to_fd* target);
 int del_sha256f_to_fd_from_htab (t_sha256f_to_fd** htab, t_sha256f_to_fd* target);
 
-int add_sha256f_to_sha256f_exist_mat (sha256f_exist_mat* matrix, char* sha256_str, bit_index index_in_arr);
-int del_sha256f_from_sha256f_exist_mat (sha256f_exist_mat* matrix, layer2_sha256f_to_fd_arr* l2_arr, bit_index index_in_arr);
+int add_sha256f_to_sha256f_digest_index (sha256f_digest_index* index, t_sha256f_to_fd* target);
+int del_sha256f_from_sha256f_digest_index (sha256f_digest_index* index, layer2_sha256f_to_fd_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha256f_to_fd_to_layer2_arr (layer2_sha256f_to_fd_arr* l2_arr, t_sha256f_to_fd** target, bit_index* index);
 int del_sha256f_to_fd_from_layer2_arr (layer2_sha256f_to_fd_arr* l2_arr, bit_index index);
@@ -781,11 +1179,12 @@ int get_l1_sha256f_to_fd_from_layer2_arr (layer2_sha256f_to_fd_arr* l2_arr, laye
 
 int del_l2_sha256f_to_fd_arr (layer2_sha256f_to_fd_arr* l2_arr);
 
-int add_fd_to_sha256f_to_fd_chain (file_data* tar_fd, file_data* fd);
-int del_fd_from_sha256f_to_fd_chain (t_sha256f_to_fd** htab_p, sha256f_exist_mat* matrix_arr, layer2_sha256f_to_fd_arr* l2_arr_arr, file_data* fd);
+int add_fd_to_sha256f_to_fd_postings (t_sha256f_to_fd* sha256f_to_fd, file_data* fd);
+int del_fd_from_sha256f_to_fd_postings (t_sha256f_to_fd** htab_p, sha256f_digest_index* index, layer2_sha256f_to_fd_arr* l2_arr_arr, file_data* fd);
+int fres_sha256f_to_fd_postings (t_sha256f_to_fd* htab);
 
 // sha512
-generic_exist_mat(sha512f, CHECKSUM_STR_MAX)
+generic_digest_index(sha512f)
 layer1_generic_arr(sha512f, fd, L1_CSUM_TO_FD_ARR_SIZE)
 layer2_generic_arr(sha512f, fd)
 
@@ -795,8 +1194,8 @@ int init_layer2_sha512f_to_fd_arr (layer2_sha512f_to_fd_arr* l2_arr_arr);
 int add_sha512f_to_fd_to_htab (t_sha512f_to_fd** htab, t_sha512f_to_fd* target);
 int del_sha512f_to_fd_from_htab (t_sha512f_to_fd** htab, t_sha512f_to_fd* target);
 
-int add_sha512f_to_sha512f_exist_mat (sha512f_exist_mat* matrix, char* sha512_str, bit_index index_in_arr);
-int del_sha512f_from_sha512f_exist_mat (sha512f_exist_mat* matrix, layer2_sha512f_to_fd_arr* l2_arr, bit_index index_in_arr);
+int add_sha512f_to_sha512f_digest_index (sha512f_digest_index* index, t_sha512f_to_fd* target);
+int del_sha512f_from_sha512f_digest_index (sha512f_digest_index* index, layer2_sha512f_to_fd_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha512f_to_fd_to_layer2_arr (layer2_sha512f_to_fd_arr* l2_arr, t_sha512f_to_fd** target, bit_index* index);
 int del_sha512f_to_fd_from_layer2_arr (layer2_sha512f_to_fd_arr* l2_arr, bit_index index);
@@ -805,12 +1204,38 @@ int get_l1_sha512f_to_fd_from_layer2_arr (layer2_sha512f_to_fd_arr* l2_arr, laye
 
 int del_l2_sha512f_to_fd_arr (layer2_sha512f_to_fd_arr* l2_arr);
 
-int add_fd_to_sha512f_to_fd_chain (file_data* tar_fd, file_data* fd);
-int del_fd_from_sha512f_to_fd_chain (t_sha512f_to_fd** htab_p, sha512f_exist_mat* matrix_arr, layer2_sha512f_to_fd_arr* l2_arr_arr, file_data* fd);
+int add_fd_to_sha512f_to_fd_postings (t_sha512f_to_fd* sha512f_to_fd, file_data* fd);
+int del_fd_from_sha512f_to_fd_postings (t_sha512f_to_fd** htab_p, sha512f_digest_index* index, layer2_sha512f_to_fd_arr* l2_arr_arr, file_data* fd);
+int fres_sha512f_to_fd_postings (t_sha512f_to_fd* htab);
+
+// merkle
+generic_digest_index(mrklf)
+layer1_generic_arr(mrklf, fd, L1_CSUM_TO_FD_ARR_SIZE)
+layer2_generic_arr(mrklf, fd)
+
+int init_mrklf_to_fd (t_mrklf_to_fd* target);
+int init_layer2_mrklf_to_fd_arr (layer2_mrklf_to_fd_arr* l2_arr_arr);
+
+int add_mrklf_to_fd_to_htab (t_mrklf_to_fd** htab, t_mrklf_to_fd* target);
+int del_mrklf_to_fd_from_htab (t_mrklf_to_fd** htab, t_mrklf_to_fd* target);
+
+int add_mrklf_to_mrklf_digest_index (mrklf_digest_index* index, t_mrklf_to_fd* target);
+int del_mrklf_from_mrklf_digest_index (mrklf_digest_index* index, layer2_mrklf_to_fd_arr* l2_arr, bit_index index_in_arr);
+
+int add_mrklf_to_fd_to_layer2_arr (layer2_mrklf_to_fd_arr* l2_arr, t_mrklf_to_fd** target, bit_index* index);
+int del_mrklf_to_fd_from_layer2_arr (layer2_mrklf_to_fd_arr* l2_arr, bit_index index);
+int get_mrklf_to_fd_from_layer2_arr (layer2_mrklf_to_fd_arr* l2_arr, t_mrklf_to_fd** result, bit_index index);
+int get_l1_mrklf_to_fd_from_layer2_arr (layer2_mrklf_to_fd_arr* l2_arr, layer1_mrklf_to_fd_arr** result, bit_index index_of_l1_arr);
+
+int del_l2_mrklf_to_fd_arr (layer2_mrklf_to_fd_arr* l2_arr);
+
+int add_fd_to_mrklf_to_fd_postings (t_mrklf_to_fd* mrklf_to_fd, file_data* fd);
+int del_fd_from_mrklf_to_fd_postings (t_mrklf_to_fd** htab_p, mrklf_digest_index* index, layer2_mrklf_to_fd_arr* l2_arr_arr, file_data* fd);
+int fres_mrklf_to_fd_postings (t_mrklf_to_fd* htab);
 
 /* For section checksum */
 // sha1
-generic_exist_mat(sha1s, CHECKSUM_STR_MAX)
+generic_digest_index(sha1s)
 layer1_generic_arr(sha1s, s, L1_CSUM_TO_S_ARR_SIZE)
 layer2_generic_arr(sha1s, s)
 
@@ -820,8 +1245,8 @@ int init_layer2_sha1s_to_s_arr (layer2_sha1s_to_s_arr* l2_arr_arr);
 int add_sha1s_to_s_to_htab (t_sha1s_to_s** htab, t_sha1s_to_s* target);
 int del_sha1s_to_s_from_htab (t_sha1s_to_s** htab, t_sha1s_to_s* target);
 
-int add_sha1s_to_sha1s_exist_mat (sha1s_exist_mat* matrix, char* sha1_str, bit_index index_in_arr);
-int del_sha1s_from_sha1s_exist_mat (sha1s_exist_mat* matrix, layer2_sha1s_to_s_arr* l2_arr, bit_index index_in_arr);
+int add_sha1s_to_sha1s_digest_index (sha1s_digest_index* index, t_sha1s_to_s* target);
+int del_sha1s_from_sha1s_digest_index (sha1s_digest_index* index, layer2_sha1s_to_s_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha1s_to_s_to_layer2_arr (layer2_sha1s_to_s_arr* l2_arr, t_sha1s_to_s** sha1s_to_s, bit_index* index);
 int del_sha1s_to_s_from_layer2_arr (layer2_sha1s_to_s_arr* l2_arr, bit_index index);
@@ -830,11 +1255,12 @@ int get_l1_sha1s_to_s_from_layer2_arr (layer2_sha1s_to_s_arr* l2_arr, layer1_sha
 
 int del_l2_sha1s_to_s_arr (layer2_sha1s_to_s_arr* l2_arr);
 
-int add_s_to_sha1s_to_s_chain (section* tar_sect, section* sect);
-int del_s_from_sha1s_to_s_chain (t_sha1s_to_s** htab_p, sha1s_exist_mat* matrix, layer2_sha1s_to_s_arr* l2_arr_arr, section* sect);
+int add_s_to_sha1s_to_s_postings (t_sha1s_to_s* tran, file_data* data, uint64_t sect_index);
+int del_s_from_sha1s_to_s_postings (t_sha1s_to_s** htab_p, sha1s_digest_index* index, layer2_sha1s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
+int purge_fd_from_sha1s_to_s_postings (t_sha1s_to_s** htab_p, sha1s_digest_index* index, layer2_sha1s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
 
 // sha256
-generic_exist_mat(sha256s, CHECKSUM_STR_MAX)
+generic_digest_index(sha256s)
 layer1_generic_arr(sha256s, s, L1_CSUM_TO_S_ARR_SIZE)
 layer2_generic_arr(sha256s, s)
 
@@ -844,8 +1270,8 @@ int init_layer2_sha256s_to_s_arr (layer2_sha256s_to_s_arr* l2_arr_arr);
 int add_sha256s_to_s_to_htab (t_sha256s_to_s** htab, t_sha256s_to_s* target);
 int del_sha256s_to_s_from_htab (t_sha256s_to_s** htab, t_sha256s_to_s* target);
 
-int add_sha256s_to_sha256s_exist_mat (sha256s_exist_mat* matrix, char* sha256_str, bit_index index_in_arr);
-int del_sha256s_from_sha256s_exist_mat (sha256s_exist_mat* matrix, layer2_sha256s_to_s_arr* l2_arr, bit_index index_in_arr);
+int add_sha256s_to_sha256s_digest_index (sha256s_digest_index* index, t_sha256s_to_s* target);
+int del_sha256s_from_sha256s_digest_index (sha256s_digest_index* index, layer2_sha256s_to_s_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha256s_to_s_to_layer2_arr (layer2_sha256s_to_s_arr* l2_arr, t_sha256s_to_s** sha256s_to_s, bit_index* index);
 int del_sha256s_to_s_from_layer2_arr (layer2_sha256s_to_s_arr* l2_arr_arr, bit_index index);
@@ -854,11 +1280,12 @@ int get_l1_sha256s_to_s_from_layer2_arr (layer2_sha256s_to_s_arr* l2_arr, layer1
 
 int del_l2_sha256s_to_s_arr (layer2_sha256s_to_s_arr* l2_arr);
 
-int add_s_to_sha256s_to_s_chain (section* tar_sect, section* sect);
-int del_s_from_sha256s_to_s_chain (t_sha256s_to_s** htab_p, sha256s_exist_mat* matrix, layer2_sha256s_to_s_arr* l2_arr_arr, section* sect);
+int add_s_to_sha256s_to_s_postings (t_sha256s_to_s* tran, file_data* data, uint64_t sect_index);
+int del_s_from_sha256s_to_s_postings (t_sha256s_to_s** htab_p, sha256s_digest_index* index, layer2_sha256s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
+int purge_fd_from_sha256s_to_s_postings (t_sha256s_to_s** htab_p, sha256s_digest_index* index, layer2_sha256s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
 
 // sha512
-generic_exist_mat(sha512s, CHECKSUM_STR_MAX)
+generic_digest_index(sha512s)
 layer1_generic_arr(sha512s, s, L1_CSUM_TO_S_ARR_SIZE)
 layer2_generic_arr(sha512s, s)
 
@@ -868,8 +1295,8 @@ int init_layer2_sha512s_to_s_arr (layer2_sha512s_to_s_arr* l2_arr_arr);
 int add_sha512s_to_s_to_htab (t_sha512s_to_s** htab, t_sha512s_to_s* target);
 int del_sha512s_to_s_from_htab (t_sha512s_to_s** htab, t_sha512s_to_s* target);
 
-int add_sha512s_to_sha512s_exist_mat (sha512s_exist_mat* matrix, char* sha512_str, bit_index index_in_arr);
-int del_sha512s_from_sha512s_exist_mat (sha512s_exist_mat* matrix, layer2_sha512s_to_s_arr* l2_arr, bit_index index_in_arr);
+int add_sha512s_to_sha512s_digest_index (sha512s_digest_index* index, t_sha512s_to_s* target);
+int del_sha512s_from_sha512s_digest_index (sha512s_digest_index* index, layer2_sha512s_to_s_arr* l2_arr, bit_index index_in_arr);
 
 int add_sha512s_to_s_to_layer2_arr (layer2_sha512s_to_s_arr* l2_arr, t_sha512s_to_s** sha512s_to_s, bit_index* index);
 int del_sha512s_to_s_from_layer2_arr (layer2_sha512s_to_s_arr* l2_arr_arr, bit_index index);
@@ -878,23 +1305,23 @@ int get_l1_sha512s_to_s_from_layer2_arr (layer2_sha512s_to_s_arr* l2_arr, layer1
 
 int del_l2_sha512s_to_s_arr (layer2_sha512s_to_s_arr* l2_arr);
 
-int add_s_to_sha512s_to_s_chain (section* tar_sect, section* sect);
-int del_s_from_sha512s_to_s_chain (t_sha512s_to_s** htab_p, sha512s_exist_mat* matrix, layer2_sha512s_to_s_arr* l2_arr_arr, section* sect);
+int add_s_to_sha512s_to_s_postings (t_sha512s_to_s* tran, file_data* data, uint64_t sect_index);
+int del_s_from_sha512s_to_s_postings (t_sha512s_to_s** htab_p, sha512s_digest_index* index, layer2_sha512s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
+int purge_fd_from_sha512s_to_s_postings (t_sha512s_to_s** htab_p, sha512s_digest_index* index, layer2_sha512s_to_s_arr* l2_arr, file_data* data, uint64_t sect_index);
 
 /* For file size */
-generic_exist_mat(f_size, FILE_SIZE_STR_MAX)
+generic_gram_index(f_size)
 layer1_generic_arr(f_size, fd, L1_FSIZE_TO_FD_ARR_SIZE)
 layer2_generic_arr(f_size, fd)
 
 int init_f_size_to_fd (t_f_size_to_fd* f_size_to_fd);
-int init_f_size_exist_mat (f_size_exist_mat* matrix);
 int init_layer2_f_size_to_fd_arr (layer2_f_size_to_fd_arr* l2_arr);
 
 int add_f_size_to_fd_to_htab (t_f_size_to_fd** htab, t_f_size_to_fd* f_size_to_fd);
 int del_f_size_to_fd_from_htab (t_f_size_to_fd** htab, t_f_size_to_fd* f_size_to_fd);
 
-int add_f_size_to_f_size_exist_mat (f_size_exist_mat* matrix, char* f_size_str, bit_index index_in_arr);
-int del_f_size_from_f_size_exist_mat (f_size_exist_mat* matrix, layer2_f_size_to_fd_arr* l2_arr, bit_index index_in_arr);
+int add_f_size_to_f_size_gram_index (f_size_gram_index* index, const char* f_size_str, bit_index index_in_arr);
+int del_f_size_from_f_size_gram_index (f_size_gram_index* index, layer2_f_size_to_fd_arr* l2_arr, bit_index index_in_arr);
 
 int add_f_size_to_fd_to_layer2_arr (layer2_f_size_to_fd_arr* l2_arr, t_f_size_to_fd** f_size_to_fd, bit_index* index);
 int del_f_size_to_fd_from_layer2_arr (layer2_f_size_to_fd_arr* l2_arr, bit_index index);
@@ -903,8 +1330,9 @@ int get_l1_f_size_to_fd_from_layer2_arr (layer2_f_size_to_fd_arr* l2_arr, layer1
 
 int del_l2_f_size_to_fd_arr (layer2_f_size_to_fd_arr* l2_arr);
 
-int add_fd_to_f_size_to_fd_chain (file_data* tar_fd, file_data* fd);
-int del_fd_from_f_size_to_fd_chain (t_f_size_to_fd** htab_p, f_size_exist_mat* matrix, layer2_f_size_to_fd_arr* l2_arr, file_data* fd);
+int add_fd_to_f_size_to_fd_postings (t_f_size_to_fd* f_size_to_fd, file_data* fd);
+int del_fd_from_f_size_to_fd_postings (t_f_size_to_fd** htab_p, f_size_gram_index* index, layer2_f_size_to_fd_arr* l2_arr, file_data* fd);
+int fres_f_size_to_fd_postings (t_f_size_to_fd* htab);
 
 // pool allocator functions
 // entry
@@ -923,14 +1351,6 @@ int get_file_data_from_layer2_arr(layer2_file_data_arr* l2_arr, file_data** ret_
 int get_l1_file_data_from_layer2_arr(layer2_file_data_arr* l2_arr, layer1_file_data_arr** ret_file_data, bit_index index_of_l1_arr);
 int del_l2_file_data_arr(layer2_file_data_arr* l2_arr);
 
-// section
-int init_layer2_section_arr(layer2_section_arr* l2_arr);
-int add_section_to_layer2_arr(layer2_section_arr* l2_arr, section** ret_section, bit_index* index);
-int del_section_from_layer2_arr(layer2_section_arr* l2_arr, bit_index index);
-int get_section_from_layer2_arr(layer2_section_arr* l2_arr, section** ret_section, bit_index index);
-int get_l1_section_from_layer2_arr(layer2_section_arr* l2_arr, layer1_section_arr** ret_section, bit_index index_of_l1_arr);
-int del_l2_section_arr(layer2_section_arr* l2_arr);
-
 // misc alloc record
 int init_layer2_misc_alloc_record_arr(layer2_misc_alloc_record_arr* l2_arr);
 int add_misc_alloc_record_to_layer2_arr(layer2_misc_alloc_record_arr* l2_arr, misc_alloc_record** ret_misc_alloc_record, bit_index* index);
@@ -939,14 +1359,6 @@ int get_misc_alloc_record_from_layer2_arr(layer2_misc_alloc_record_arr* l2_arr,
 int get_l1_misc_alloc_record_from_layer2_arr(layer2_misc_alloc_record_arr* l2_arr, layer1_misc_alloc_record_arr** ret_misc_alloc_record, bit_index index_of_l1_arr);
 int del_l2_misc_alloc_record_arr(layer2_misc_alloc_record_arr* l2_arr);
 
-// dtt year
-int init_layer2_dtt_year_arr(layer2_dtt_year_arr* l2_arr);
-int add_dtt_year_to_layer2_arr(layer2_dtt_year_arr* l2_arr, dtt_year** ret_dtt_year, bit_index* index);
-int del_dtt_year_from_layer2_arr(layer2_dtt_year_arr* l2_arr, bit_index index);
-int get_dtt_year_from_layer2_arr(layer2_dtt_year_arr* l2_arr, dtt_year** ret_dtt_year, bit_index index);
-int get_l1_dtt_year_from_layer2_arr(layer2_dtt_year_arr* l2_arr, layer1_dtt_year_arr** ret_dtt_year, bit_index index_of_l1_arr);
-int del_l2_dtt_year_arr(layer2_dtt_year_arr* l2_arr);
-
 // sect field
 int init_layer2_sect_field_arr(layer2_sect_field_arr* l2_arr);
 int add_sect_field_to_layer2_arr(layer2_sect_field_arr* l2_arr, sect_field** ret_sect_field, bit_index* index);
@@ -962,68 +1374,87 @@ struct database_handle {
 
     char                    name[FILE_NAME_MAX+1];
 
+    /* interned file names and tag strings */
+    str_intern              strs;
+
     /* main tree */
     linked_entry            tree;
 
     /* ID translation */
     t_eid_to_e*             eid_to_e;           // hash table, used for exact matching
-    eid_exist_mat           eid_mat;            // existence matrix, used for partial matching
+    eid_digest_index        eid_digest;         // digest index, used for partial matching
     layer2_eid_to_e_arr     l2_eid_to_e_arr;    // layer 2 array, used for partial matching
 
     /* for file name translation */
     t_fn_to_e*              fn_to_e;            // hash table, used for exact matching
-    fn_exist_mat            fn_mat;             // existence matrix, used for partial matching
+    fn_gram_index           fn_gram;            // gram index, used for partial matching
     layer2_fn_to_e_arr      l2_fn_to_e_arr;     // layer 2 array, used for partial matching
 
     /* for tag translation */
     t_tag_to_e*             tag_to_e;           // hash table, used for exact matching
-    tag_exist_mat           tag_mat;            // existence matrix, used for partial matching
+    tag_gram_index          tag_gram;           // gram index, used for partial matching
     layer2_tag_to_e_arr     l2_tag_to_e_arr;    // layer 2 array, used for partial matching
 
     /* for file data checksum translation */
     // sha1
     t_sha1f_to_fd*              sha1f_to_fd;    // hash table, used for exact matching
-    sha1f_exist_mat             sha1f_mat;      // existence matrix, used for partial matching
+    sha1f_digest_index          sha1f_digest;   // digest index, used for partial matching
     layer2_sha1f_to_fd_arr      l2_sha1f_to_fd_arr; // layer 2 array, used for partial matching
     // sha256
     t_sha256f_to_fd*            sha256f_to_fd;      // hash table, used for exact matching
-    sha256f_exist_mat           sha256f_mat;        // existence matrix, used for partial matching
+    sha256f_digest_index        sha256f_digest;     // digest index, used for partial matching
     layer2_sha256f_to_fd_arr    l2_sha256f_to_fd_arr;   // layer 2 array, used for partial matching
     // sha512
     t_sha512f_to_fd*            sha512f_to_fd;      // hash table, used for exact matching
-    sha512f_exist_mat           sha512f_mat;        // existence matrix, used for partial matching
+    sha512f_digest_index        sha512f_digest;     // digest index, used for partial matching
     layer2_sha512f_to_fd_arr    l2_sha512f_to_fd_arr;   // layer 2 array, used for partial matching
+    // merkle
+    t_mrklf_to_fd*              mrklf_to_fd;        // hash table, used for exact matching
+    mrklf_digest_index          mrklf_digest;       // digest index, used for partial matching
+    layer2_mrklf_to_fd_arr      l2_mrklf_to_fd_arr;     // layer 2 array, used for partial matching
 
     /* for section checksum translation */
     // sha1
     t_sha1s_to_s*           sha1s_to_s;         // hash table, used for exact matching
-    sha1s_exist_mat         sha1s_mat;          // existence matrix, used for partial matching
+    sha1s_digest_index      sha1s_digest;       // digest index, used for partial matching
     layer2_sha1s_to_s_arr   l2_sha1s_to_s_arr;  // layer 2 array, used for partial matching
     // sha256
     t_sha256s_to_s*             sha256s_to_s;           // hash table, used for exact matching
-    sha256s_exist_mat           sha256s_mat;            // existence matrix, used for partial matching
+    sha256s_digest_index        sha256s_digest;         // digest index, used for partial matching
     layer2_sha256s_to_s_arr     l2_sha256s_to_s_arr;    // layer 2 array, used for partial matching
     // sha512
     t_sha512s_to_s*             sha512s_to_s;           // hash table, used for exact matching
-    sha512s_exist_mat           sha512s_mat;            // existence matrix, used for partial matching
+    sha512s_digest_index        sha512s_digest;         // digest index, used for partial matching
     layer2_sha512s_to_s_arr     l2_sha512s_to_s_arr;    // layer 2 array, used for partial matching
 
     /* for file size translation */
     t_f_size_to_fd*             f_size_to_fd;    // hash table, used for exact matching
-    f_size_exist_mat            f_size_mat;     // existence matrix, used for partial matching
+    f_size_gram_index           f_size_gram;    // gram index, used for partial matching
     layer2_f_size_to_fd_arr     l2_f_size_to_fd_arr;  // layer 2 array, used for partial matching
 
-    /* for date time tree */
-    dtt_year*                   tod_dt_tree;
-    dtt_year*                   tom_dt_tree;
-    dtt_year*                   tusr_dt_tree;
+    /* for time index, see note on time index */
+    time_index                  tod_index;
+    time_index                  tom_index;
+    time_index                  tusr_index;
+
+    /* for fuzzy digest lookup */
+    fuzzy_gram*                 fuzzy_index;    // hash table, gram to file data
+    uint64_t                    fuzzy_num;      // number of file data indexed
+    uint64_t                    fuzzy_mark;     // incremented per lookup
+
+    /* for lookup by size and extracts */
+    extract_bucket*             extract_index;  // hash table, size and extracts to file data
+    uint64_t                    extract_index_num;  // number of file data indexed
+
+    /* for deferred hashing */
+    file_data*                  pending_head;   // oldest pending file data
+    file_data*                  pending_tail;
+    uint64_t                    pending_num;
 
     /* pool allocator structure */
     layer2_entry_arr                l2_entry_arr;
     layer2_file_data_arr            l2_file_data_arr;
-    layer2_section_arr              l2_section_arr;
     layer2_misc_alloc_record_arr    l2_misc_alloc_record_arr;
-    layer2_dtt_year_arr             l2_dtt_year_arr;
 
     bit_index max_misc_alloc_record_index;
 
@@ -1031,6 +1462,37 @@ struct database_handle {
     UT_hash_handle hh;
 }; 
 
+// every new entry needs init_entry_strs before use, see note on entry layout
+int init_entry_strs (linked_entry* entry);
+
+// name and tag are interned in dh, returns VERIFY_FAIL if too long
+int set_entry_file_name (database_handle* dh, linked_entry* entry, const char* file_name);
+
+int set_entry_tag_str (database_handle* dh, linked_entry* entry, const char* tag_str);
+
+// string is copied, returns VERIFY_FAIL if too long
+int set_entry_user_msg (linked_entry* entry, const char* user_msg);
+
+int fres_entry_strs (linked_entry* entry);
+
+// makes child index of parent if not made already
+int make_child_index (linked_entry* parent);
+
+// following two do nothing if parent has no child index
+int add_to_child_index (linked_entry* parent, linked_entry* entry);
+
+int del_from_child_index (linked_entry* parent, linked_entry* entry);
+
+int fres_child_index (linked_entry* parent);
+
+// cursor returns every child of parent with file name id
+int child_cursor_init (child_cursor* cursor, const linked_entry* parent, str_id id);
+
+int child_cursor_next (child_cursor* cursor, linked_entry** entry);
+
+// frees section array and side arrays of file data
+int fres_section_array (file_data* target);
+
 int link_entry_clear(linked_entry* tar);
 
 int link_entry_tail(linked_entry* dst, linked_entry* tar);
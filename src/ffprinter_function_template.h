@@ -90,12 +90,6 @@
  /* helper functions for use in templates */
 #define fft_int_div_round_up(a, b) ((a) % (b) == 0 ? ((a) / (b) + 1) : (((a) + (b) - 1) / (b)))
 
-#define link_to_tran(tar_p, tran_p) \
-    strcpy(tran_p->str, (tar_p)->id);       \
-    tran_p->head_tar = tar_p;               \
-    tran_p->tail_tar = tar_p;               \
-    tran_p->str_len = strlen((tar_p)->id);
-
 #define init_obj_meta_data(obj_name, obj_type) \
     int init_##obj_name##_meta_data (obj_type * obj) { \
         if (!obj) {                 \
@@ -151,18 +145,59 @@
         }                                                                   \
                                                                             \
         tar->str[0] = 0;                                                    \
-        tar->number = 0;                                                    \
-        tar->head_tar = 0;                                                  \
-        tar->tail_tar = 0;                                                  \
+        tar->tar = &tar->tar_one;                                           \
+        tar->tar_one = 0;                                                   \
+        tar->tar_num = 0;                                                   \
+        tar->tar_max = 1;                                                   \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define init_generic_trans_struct_one_to_many_str_id(tag_attr, tag_target) \
+    int init_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar) { \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        tar->id = STR_ID_EMPTY;                                             \
+        tar->str = NULL;                                                    \
+        tar->str_len = 0;                                                   \
+        tar->tar = &tar->tar_one;                                           \
+        tar->tar_one = 0;                                                   \
+        tar->tar_num = 0;                                                   \
+        tar->tar_max = 1;                                                   \
                                                                             \
         return 0;                                                           \
     }
 
-#define verify_generic_trans_struct_one_to_many(tag_attr, tag_target, tag_prev, tag_next, target_type, STR_MAX_LEN) \
+/* checks size of posting array, and every slot if GO_THROUGH_CHAIN is set */
+#define verify_generic_postings(tag_attr, tag_target, slot_name)         \
+        if (!tar->tar || tar->tar_num > tar->tar_max) {                     \
+            if (error_code) {                                               \
+                *error_code = VERIFY_MISSING_HEAD;                          \
+            }                                                               \
+            return VERIFY_FAIL;                                             \
+        }                                                                   \
+                                                                            \
+        if (flags & GO_THROUGH_CHAIN) {                                     \
+            for (u32i = 0; u32i < tar->tar_num; u32i++) {                   \
+                if (    !tar->tar[u32i]                                     \
+                    ||  tar->tar[u32i]->tag_attr##_to_##tag_target != tar   \
+                    ||  tar->tar[u32i]->slot_name != u32i                   \
+                   )                                                        \
+                {                                                           \
+                    if (error_code) {                                       \
+                        *error_code = VERIFY_BROKEN_FORWARD_LINK;           \
+                    }                                                       \
+                    return VERIFY_FAIL;                                     \
+                }                                                           \
+            }                                                               \
+        }
+
+#define verify_generic_trans_struct_one_to_many(tag_attr, tag_target, slot_name, STR_MAX_LEN) \
     int verify_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar, int * error_code, uint32_t flags) { \
-        uint64_t u64i;                                                      \
+        uint32_t u32i;                                                      \
         str_len_int str_len;                                                \
-        target_type * temp_entry;                                           \
                                                                             \
         if (!tar) {                                                         \
             return WRONG_ARGS;                                              \
@@ -182,55 +217,105 @@
             return VERIFY_FAIL;                                             \
         }                                                                   \
                                                                             \
-        if (tar->number > 0) {                                              \
-            if (!tar->head_tar) {                                           \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_MISSING_HEAD;                      \
-                }                                                           \
-                return VERIFY_FAIL;                                         \
-            }                                                               \
-            if (!tar->tail_tar) {                                           \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_MISSING_TAIL;                      \
-                }                                                           \
-                return VERIFY_FAIL;                                         \
-            }                                                               \
+        verify_generic_postings(tag_attr, tag_target, slot_name)            \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define init_generic_trans_struct_one_to_one_key(tag_attr, tag_target) \
+    int init_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar) { \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
         }                                                                   \
                                                                             \
-        if (flags & GO_THROUGH_CHAIN && tar->number > 0) {                  \
-            /* forward direction */                                         \
-            temp_entry = tar->head_tar;                                     \
-            for (u64i = 1; u64i < tar->number && temp_entry; u64i++) {      \
-                temp_entry = temp_entry->tag_next;                          \
-            }                                                               \
-            if (temp_entry != tar->tail_tar) {                              \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_BROKEN_FORWARD_LINK;               \
-                }                                                           \
-                return VERIFY_FAIL;                                         \
-            }                                                               \
-            if (u64i != tar->number) {                                      \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_WRONG_FORWARD_STAT;                \
-                }                                                           \
-                return VERIFY_FAIL;                                         \
-            }                                                               \
-            /* backward direction */                                        \
-            temp_entry = tar->tail_tar;                                     \
-            for (u64i = 1; u64i < tar->number && temp_entry; u64i++) {      \
-                temp_entry = temp_entry->tag_prev;                          \
-            }                                                               \
-            if (temp_entry != tar->head_tar) {                              \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_BROKEN_BACKWARD_LINK;              \
-                }                                                           \
-                return VERIFY_FAIL;                                         \
+        memset(tar->key, 0, sizeof(tar->key));                              \
+        tar->tar = 0;                                                       \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define verify_generic_trans_struct_one_to_one_key(tag_attr, tag_target) \
+    int verify_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar, int * error_code, uint32_t flags) { \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define init_generic_trans_struct_one_to_many_key(tag_attr, tag_target) \
+    int init_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar) { \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        memset(tar->key, 0, sizeof(tar->key));                              \
+        tar->tar = &tar->tar_one;                                           \
+        tar->tar_one = 0;                                                   \
+        tar->tar_num = 0;                                                   \
+        tar->tar_max = 1;                                                   \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define verify_generic_trans_struct_one_to_many_key(tag_attr, tag_target, slot_name) \
+    int verify_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar, int * error_code, uint32_t flags) { \
+        uint32_t u32i;                                                      \
+                                                                            \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        verify_generic_postings(tag_attr, tag_target, slot_name)            \
+                                                                            \
+        return 0;                                                           \
+    }
+
+#define init_generic_trans_struct_one_to_many_sect_key(tag_attr, tag_target) \
+    int init_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar) { \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        memset(tar->key, 0, sizeof(tar->key));                              \
+        tar->tar = 0;                                                       \
+        tar->tar_num = 0;                                                   \
+        tar->tar_max = 0;                                                   \
+        tar->purged = 0;                                                    \
+                                                                            \
+        return 0;                                                           \
+    }
+
+/* with GO_THROUGH_CHAIN, every section referred to is checked to carry the key */
+#define verify_generic_trans_struct_one_to_many_sect_key(tag_attr, tag_target, chks_index) \
+    int verify_##tag_attr##_to_##tag_target (t_##tag_attr##_to_##tag_target * tar, int * error_code, uint32_t flags) { \
+        uint32_t i;                                                         \
+        sect_ref* ref;                                                      \
+                                                                            \
+        if (!tar) {                                                         \
+            return WRONG_ARGS;                                              \
+        }                                                                   \
+                                                                            \
+        if (tar->tar_num > tar->tar_max || (tar->tar_num > 0 && !tar->tar)) { \
+            if (error_code) {                                               \
+                *error_code = VERIFY_MISSING_HEAD;                          \
             }                                                               \
-            if (u64i != tar->number) {                                      \
-                if (error_code) {                                           \
-                    *error_code = VERIFY_WRONG_BACKWARD_STAT;               \
+            return VERIFY_FAIL;                                             \
+        }                                                                   \
+                                                                            \
+        if (flags & GO_THROUGH_CHAIN) {                                     \
+            for (i = 0; i < tar->tar_num; i++) {                            \
+                ref = tar->tar + i;                                         \
+                if (    ref->index >= ref->data->section_num                \
+                    ||  !sect_has_checksum(ref->data, ref->index, chks_index) \
+                    ||  memcmp(sect_digest(ref->data, ref->index, chks_index), tar->key, sizeof(tar->key)) != 0 \
+                   )                                                        \
+                {                                                           \
+                    if (error_code) {                                       \
+                        *error_code = VERIFY_BROKEN_FORWARD_LINK;           \
+                    }                                                       \
+                    return VERIFY_FAIL;                                     \
                 }                                                           \
-                return VERIFY_FAIL;                                         \
             }                                                               \
         }                                                                   \
                                                                             \
@@ -252,6 +337,34 @@
                                                                                     \
     }
 
+#define add_generic_str_id_to_htab(tag_attr, tag_target) \
+    int add_##tag_attr##_to_##tag_target##_to_htab (t_##tag_attr##_to_##tag_target ** htab_p, t_##tag_attr##_to_##tag_target * tar) { \
+        if (!htab_p) {                                                              \
+            return WRONG_ARGS;                                                      \
+        }                                                                           \
+        if (!tar) {                                                                 \
+            return WRONG_ARGS;                                                      \
+        }                                                                           \
+                                                                                    \
+        HASH_ADD(hh, *htab_p, id, sizeof(str_id), tar);                             \
+                                                                                    \
+        return 0;                                                                   \
+    }
+
+#define add_generic_key_to_htab(tag_attr, tag_target, KEY_LEN) \
+    int add_##tag_attr##_to_##tag_target##_to_htab (t_##tag_attr##_to_##tag_target ** htab_p, t_##tag_attr##_to_##tag_target * tar) { \
+        if (!htab_p) {                                                              \
+            return WRONG_ARGS;                                                      \
+        }                                                                           \
+        if (!tar) {                                                                 \
+            return WRONG_ARGS;                                                      \
+        }                                                                           \
+                                                                                    \
+        HASH_ADD_DIGEST(*htab_p, key, KEY_LEN, tar);                                \
+                                                                                    \
+        return 0;                                                                   \
+    }
+
 #define del_generic_from_htab(tag_attr, tag_target) \
     int del_##tag_attr##_to_##tag_target##_from_htab (t_##tag_attr##_to_##tag_target ** htab_p, t_##tag_attr##_to_##tag_target * tar) { \
         if (!htab_p) {                                                              \
@@ -266,6 +379,22 @@
         return 0;                                                                   \
     }
 
+/* Note on layer 2 arrays
+ *
+ *  Objects live in fixed size layer 1 arrays, so obj_arr_index stays as
+ *      index of L1 array * L1_ARR_SIZE + offset in L1 array
+ *  and usage maps are kept up to date for code which walks the L1 arrays directly
+ *
+ *  Free slots are not searched for via the bitmaps
+ *      - each L1 array hands out slots past bump_index first, then freed slots,
+ *        which are chained through the obj_arr_index field of the (wiped) objects
+ *      - L1 arrays with free slots are chained via next_avail, starting at avail_head
+ *  so both allocation and deallocation are O(1)
+ *
+ *  When all L1 arrays are full, a new chunk of L1 arrays as large as all existing ones
+ *  combined (but at least L2_ARR_GROW_SIZE) is allocated as one block, so the number of
+ *  chunks only grows logarithmically, del_l2_obj_arr relies on this layout
+ */
 #define init_layer1_obj_arr(obj_name, L1_ARR_SIZE)  \
     static int init_layer1_##obj_name##_arr (layer1_##obj_name##_arr* l1_arr) { \
         if (!l1_arr) {                                                                  \
@@ -276,6 +405,10 @@
                                                                                         \
         bitmap_init(&l1_arr->usage_map, l1_arr->usage_map_raw, 0, L1_ARR_SIZE, 0);      \
                                                                                         \
+        l1_arr->free_head = 0;                                                          \
+        l1_arr->bump_index = 0;                                                         \
+        l1_arr->next_avail = 0;                                                         \
+                                                                                        \
         return 0;                                                                       \
     }
 
@@ -310,13 +443,18 @@
             return MALLOC_FAIL;                                                             \
         }                                                                                   \
                                                                                             \
+        /* all L1 arrays start out usable, chain them up */                                 \
         for (i = 0; i < L2_ARR_INIT_SIZE; i++) {                                            \
             init_layer1_##obj_name##_arr(temp_l1_arr + i);                                  \
+            if (i + 1 < L2_ARR_INIT_SIZE) {                                                 \
+                temp_l1_arr[i].next_avail = i + 2;                                          \
+            }                                                                               \
             l2_arr->l1_arr[i] = temp_l1_arr + i;                                            \
         }                                                                                   \
+        l2_arr->avail_head = 1;                                                             \
                                                                                             \
         /* grab space for bitmap */                                                         \
-        temp_base = malloc(get_bitmap_map_block_number(L2_ARR_INIT_SIZE));                  \
+        temp_base = malloc(get_bitmap_map_block_number(L2_ARR_INIT_SIZE) * sizeof(map_block)); \
         if (!temp_base) {                                                                   \
             return MALLOC_FAIL;                                                             \
         }                                                                                   \
@@ -332,12 +470,13 @@
         layer1_##obj_name##_arr** temp_l1_arr_p;                                            \
         obj_type * temp_obj_p;                                                              \
                                                                                             \
-        int i;                                                                              \
+        bit_index i;                                                                        \
                                                                                             \
-        bit_index temp_index_result;                                                        \
-        bit_index temp_index_result_backup;                                                 \
+        bit_index l2_index;                                                                 \
+        bit_index l1_index;                                                                 \
                                                                                             \
         uint64_t l2_num_total;                                                              \
+        uint64_t grow_num;                                                                  \
                                                                                             \
         if (        !l2_arr                                                                 \
            /* must return either object or index, otherwise the object will be stranded */  \
@@ -348,47 +487,65 @@
         }                                                                                   \
                                                                                             \
         /* if no more usable l1_arr */                                                      \
-        if (l2_arr->l1_arr_map.number_of_zeros == 0) {                                      \
+        if (l2_arr->avail_head == 0) {                                                      \
             l2_num_total = l2_arr->l1_arr_map.length;                                       \
+            /* grow geometrically, see note on layer 2 arrays */                            \
+            grow_num = l2_num_total < L2_ARR_GROW_SIZE ? L2_ARR_GROW_SIZE : l2_num_total;   \
+                                                                                            \
             /* realloc for more pointers */                                                 \
             temp_l1_arr_p =                                                                 \
             realloc(                                                                        \
                     l2_arr->l1_arr,                                                         \
                                                                                             \
-                    (l2_num_total + L2_ARR_GROW_SIZE)                                       \
+                    (l2_num_total + grow_num)                                               \
                     * sizeof(layer1_##obj_name##_arr*)                                      \
                    );                                                                       \
             if (!temp_l1_arr_p) {                                                           \
                 return MALLOC_FAIL;                                                         \
             }                                                                               \
+            l2_arr->l1_arr = temp_l1_arr_p;                                                 \
+                                                                                            \
             /* grab space make pointers point to them */                                    \
             temp_l1_arr =                                                                   \
             malloc(                                                                         \
-                    L2_ARR_GROW_SIZE                                                        \
+                    grow_num                                                                \
                     * sizeof(layer1_##obj_name##_arr)                                       \
                   );                                                                        \
             if (!temp_l1_arr) {                                                             \
                 return MALLOC_FAIL;                                                         \
             }                                                                               \
                                                                                             \
-            for (i = 0; i < L2_ARR_GROW_SIZE; i++) {                                        \
+            if (ffp_grow_bitmap(&l2_arr->l1_arr_map, l2_num_total + grow_num)) {            \
+                free(temp_l1_arr);                                                          \
+                return MALLOC_FAIL;                                                         \
+            }                                                                               \
+                                                                                            \
+            for (i = 0; i < grow_num; i++) {                                                \
                 init_layer1_##obj_name##_arr(temp_l1_arr + i);                              \
+                if (i + 1 < grow_num) {                                                     \
+                    temp_l1_arr[i].next_avail = l2_num_total + i + 2;                       \
+                }                                                                           \
                 temp_l1_arr_p[l2_num_total + i] = temp_l1_arr + i;                          \
             }                                                                               \
                                                                                             \
-            l2_arr->l1_arr = temp_l1_arr_p;                                                 \
-                                                                                            \
-            ffp_grow_bitmap(&l2_arr->l1_arr_map, l2_num_total + L2_ARR_GROW_SIZE);          \
+            l2_arr->avail_head = l2_num_total + 1;                                          \
         }                                                                                   \
                                                                                             \
-        /* find first usable l1_arr */                                                      \
-        bitmap_first_zero_bit_index(&l2_arr->l1_arr_map, &temp_index_result, 0);            \
-        temp_l1_arr = *(l2_arr->l1_arr + temp_index_result);                                \
-        temp_index_result_backup = temp_index_result;                                       \
+        /* take first usable l1_arr */                                                      \
+        l2_index = l2_arr->avail_head - 1;                                                  \
+        temp_l1_arr = l2_arr->l1_arr[l2_index];                                             \
                                                                                             \
-        /* find first usable slot in the l1_arr */                                          \
-        bitmap_first_zero_bit_index(&temp_l1_arr->usage_map, &temp_index_result, 0);        \
-        temp_obj_p = temp_l1_arr->arr + temp_index_result;                                  \
+        /* take a freed slot if any, otherwise a fresh one */                               \
+        if (temp_l1_arr->free_head) {                                                       \
+            l1_index = temp_l1_arr->free_head - 1;                                          \
+            temp_obj_p = temp_l1_arr->arr + l1_index;                                       \
+            temp_l1_arr->free_head = (uint32_t) temp_obj_p->obj_arr_index;                  \
+        }                                                                                   \
+        else {                                                                              \
+            l1_index = temp_l1_arr->bump_index;                                             \
+            temp_l1_arr->bump_index++;                                                      \
+            temp_obj_p = temp_l1_arr->arr + l1_index;                                       \
+        }                                                                                   \
                                                                                             \
         /* wipe object */                                                                   \
         mem_wipe_sec(temp_obj_p, sizeof(obj_type));                                         \
@@ -397,13 +554,16 @@
         if (ret_obj) {                                                                      \
             *ret_obj = temp_obj_p;                                                          \
         }                                                                                   \
-        bitmap_write(&temp_l1_arr->usage_map, temp_index_result, 1);                        \
+        bitmap_write(&temp_l1_arr->usage_map, l1_index, 1);                                 \
                                                                                             \
+        /* if the l1_arr is now full, take it off the usable chain */                       \
         if (temp_l1_arr->usage_map.number_of_zeros == 0) {                                  \
-            bitmap_write(&l2_arr->l1_arr_map, temp_index_result_backup, 1);                 \
+            bitmap_write(&l2_arr->l1_arr_map, l2_index, 1);                                 \
+            l2_arr->avail_head = temp_l1_arr->next_avail;                                   \
+            temp_l1_arr->next_avail = 0;                                                    \
         }                                                                                   \
                                                                                             \
-        temp_obj_p->obj_arr_index = temp_index_result_backup * L1_ARR_SIZE + temp_index_result;\
+        temp_obj_p->obj_arr_index = l2_index * L1_ARR_SIZE + l1_index;                      \
                                                                                             \
         if (index) {                                                                        \
             *index = temp_obj_p->obj_arr_index;                                             \
@@ -450,10 +610,16 @@
         /* mark it in bitmap */                                             \
         bitmap_write(&temp_l1_arr->usage_map, l1_index, 0);                 \
                                                                             \
+        /* put slot on free chain */                                        \
+        temp_obj_p->obj_arr_index = temp_l1_arr->free_head;                 \
+        temp_l1_arr->free_head = l1_index + 1;                              \
+                                                                            \
         /* if the l1_arr was previously marked full, now mark it usable */  \
         bitmap_read(&l2_arr->l1_arr_map, l2_index, &temp_block);            \
         if (temp_block == 1) {                                              \
             bitmap_write(&l2_arr->l1_arr_map, l2_index, 0);                 \
+            temp_l1_arr->next_avail = l2_arr->avail_head;                   \
+            l2_arr->avail_head = l2_index + 1;                              \
         }                                                                   \
                                                                             \
         return 0;                                                           \
@@ -520,6 +686,7 @@
 #define del_l2_obj_arr(obj_name, L2_ARR_INIT_SIZE, L2_ARR_GROW_SIZE) \
     int del_l2_##obj_name##_arr(layer2_##obj_name##_arr * l2_arr) { \
         bit_index i;                                                                        \
+        uint64_t chunk_num;                                                                 \
         layer1_##obj_name##_arr* temp_l1_arr;                                               \
         simple_bitmap* temp_map;                                                            \
                                                                                             \
@@ -535,10 +702,11 @@
         mem_wipe_sec(temp_l1_arr, L2_ARR_INIT_SIZE * sizeof(layer1_##obj_name##_arr));      \
         free(temp_l1_arr);                                                                  \
                                                                                             \
-        /* wipe and free remaining chunks */                                                \
-        for (i = L2_ARR_INIT_SIZE; i < temp_map->length; i += L2_ARR_GROW_SIZE) {           \
+        /* wipe and free remaining chunks, see note on layer 2 arrays for sizes */          \
+        for (i = L2_ARR_INIT_SIZE; i < temp_map->length; i += chunk_num) {                  \
+            chunk_num = i < L2_ARR_GROW_SIZE ? L2_ARR_GROW_SIZE : i;                        \
             temp_l1_arr = l2_arr->l1_arr[i];                                                \
-            mem_wipe_sec(temp_l1_arr, L2_ARR_GROW_SIZE * sizeof(layer1_##obj_name##_arr));  \
+            mem_wipe_sec(temp_l1_arr, chunk_num * sizeof(layer1_##obj_name##_arr));         \
             free(temp_l1_arr);                                                              \
         }                                                                                   \
                                                                                             \
@@ -561,6 +729,8 @@
         /* wipe bitmap meta data */                                                         \
         mem_wipe_sec(temp_map, sizeof(simple_bitmap));                                      \
                                                                                             \
+        l2_arr->avail_head = 0;                                                             \
+                                                                                            \
         return 0;                                                                           \
     }
 
@@ -839,35 +1009,170 @@
         return 0;                                                           \
     }
 
-#define add_generic_to_generic_chain(tag_attr, tag_target, tag_prev, tag_next, str_name, target_type) \
-    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_chain (target_type * dst, target_type * tar) { \
-        t_##tag_attr##_to_##tag_target * temp_tran;                             \
+#define init_generic_gram_index(tag_attr) \
+    int init_##tag_attr##_gram_index (tag_attr##_gram_index* index) { \
+        return init_gram_index(index);                                  \
+    }
+
+#define add_generic_to_generic_gram_index(tag_attr, STR_MAX_LEN) \
+    int add_##tag_attr##_to_##tag_attr##_gram_index (tag_attr##_gram_index * index, const char* str, bit_index index_in_arr) { \
+        int ret;                                                                    \
+                                                                                    \
+        str_len_int str_len;                                                        \
+                                                                                    \
+        if ((ret = verify_str_terminated(str, STR_MAX_LEN, &str_len, 0))) {         \
+            return ret;                                                             \
+        }                                                                           \
+                                                                                    \
+        return add_str_to_gram_index(index, str, str_len, index_in_arr);            \
+    }
+
+#define del_generic_from_generic_gram_index(tag_attr, tag_target) \
+    int del_##tag_attr##_from_##tag_attr##_gram_index (tag_attr##_gram_index * index, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, bit_index index_in_arr) { \
+        t_##tag_attr##_to_##tag_target * result;                                    \
+                                                                                    \
+        int ret;                                                                    \
+                                                                                    \
+        if ((ret = get_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, &result, index_in_arr))) {\
+            return ret;                                                             \
+        }                                                                           \
+                                                                                    \
+        return del_str_from_gram_index(index, result->str, strlen(result->str), index_in_arr);\
+    }
+
+#define init_generic_digest_index(tag_attr, KEY_LEN) \
+    int init_##tag_attr##_digest_index (tag_attr##_digest_index* index) { \
+        return init_digest_index(index, KEY_LEN);                           \
+    }
+
+#define add_generic_to_generic_digest_index(tag_attr, tag_target) \
+    int add_##tag_attr##_to_##tag_attr##_digest_index (tag_attr##_digest_index * index, t_##tag_attr##_to_##tag_target * target) { \
+        return add_to_digest_index(index, target);                                  \
+    }
+
+#define del_generic_from_generic_digest_index(tag_attr, tag_target) \
+    int del_##tag_attr##_from_##tag_attr##_digest_index (tag_attr##_digest_index * index, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, bit_index index_in_arr) { \
+        t_##tag_attr##_to_##tag_target * result;                                    \
+                                                                                    \
+        int ret;                                                                    \
+                                                                                    \
+        if ((ret = get_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, &result, index_in_arr))) {\
+            return ret;                                                             \
+        }                                                                           \
+                                                                                    \
+        return del_from_digest_index(index, result);                                \
+    }
+
+/* appends tar to posting array of tran, array is grown by doubling, see note on postings */
+#define append_generic_to_postings(tag_attr, tag_target, slot_name, target_type) \
+        if (tran->tar_num == tran->tar_max) {                                   \
+            if (tran->tar == &tran->tar_one) {                                  \
+                temp_tar = malloc(sizeof(target_type *) * 2);                   \
+                if (!temp_tar) {                                                \
+                    return MALLOC_FAIL;                                         \
+                }                                                               \
+                temp_tar[0] = tran->tar_one;                                    \
+            }                                                                   \
+            else {                                                              \
+                temp_tar = realloc(tran->tar, sizeof(target_type *) * tran->tar_max * 2); \
+                if (!temp_tar) {                                                \
+                    return MALLOC_FAIL;                                         \
+                }                                                               \
+            }                                                                   \
+            tran->tar = temp_tar;                                               \
+            tran->tar_max *= 2;                                                 \
+        }                                                                       \
                                                                                 \
-        if (!dst) {                                                             \
+        tran->tar[tran->tar_num] = tar;                                         \
+        tar->slot_name = tran->tar_num;                                         \
+        tran->tar_num++;                                                        \
+                                                                                \
+        tar->tag_attr##_to_##tag_target = tran;
+
+#define add_generic_to_generic_postings(tag_attr, tag_target, slot_name, str_name, target_type) \
+    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * tran, target_type * tar) { \
+        target_type ** temp_tar;                                                \
+                                                                                \
+        if (!tran) {                                                            \
             return WRONG_ARGS;                                                  \
         }                                                                       \
         if (!tar) {                                                             \
             return WRONG_ARGS;                                                  \
         }                                                                       \
-        if (strcmp((const char*) dst->str_name, (const char*) tar->str_name) != 0) {\
+        if (strcmp((const char*) tran->str, (const char*) tar->str_name) != 0) {\
             return WRONG_ARGS;                                                  \
         }                                                                       \
                                                                                 \
-        temp_tran = dst->tag_attr##_to_##tag_target;                            \
-        tar->tag_attr##_to_##tag_target = dst->tag_attr##_to_##tag_target;      \
+        append_generic_to_postings(tag_attr, tag_target, slot_name, target_type)\
                                                                                 \
-        tar->tag_prev = temp_tran->tail_tar;                                    \
-        temp_tran->tail_tar->tag_next = tar;                                    \
-        tar->tag_next = 0;                                                      \
-        temp_tran->tail_tar = tar;                                              \
+        return 0;                                                               \
+    }
+
+#define add_generic_to_generic_key_postings(tag_attr, tag_target, slot_name, key_name, KEY_LEN, target_type) \
+    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * tran, target_type * tar) { \
+        target_type ** temp_tar;                                                \
                                                                                 \
-        temp_tran->number++;                                                    \
+        if (!tran) {                                                            \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (!tar) {                                                             \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (memcmp(tran->key, tar->key_name, KEY_LEN) != 0) {                   \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+                                                                                \
+        append_generic_to_postings(tag_attr, tag_target, slot_name, target_type)\
+                                                                                \
+        return 0;                                                               \
+    }
+
+/* strings are interned, so equal strings have equal ids */
+#define add_generic_to_generic_str_id_postings(tag_attr, tag_target, slot_name, id_name, target_type) \
+    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * tran, target_type * tar) { \
+        target_type ** temp_tar;                                                \
+                                                                                \
+        if (!tran) {                                                            \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (!tar) {                                                             \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (tran->id != tar->id_name) {                                         \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+                                                                                \
+        append_generic_to_postings(tag_attr, tag_target, slot_name, target_type)\
                                                                                 \
         return 0;                                                               \
     }
 
-#define del_generic_from_generic_chain(tag_attr, tag_target, tag_prev, tag_next, target_type) \
-    int del_##tag_target##_from_##tag_attr##_to_##tag_target##_chain (t_##tag_attr##_to_##tag_target ** htab_p, tag_attr##_exist_mat * matrix, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, target_type * tar) { \
+/* key string is zero padded, so compare on the number it holds rather than the text */
+#define add_generic_to_generic_num_postings(tag_attr, tag_target, slot_name, num_name, target_type) \
+    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * tran, target_type * tar) { \
+        target_type ** temp_tar;                                                \
+                                                                                \
+        if (!tran) {                                                            \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (!tar) {                                                             \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (strtoull((const char*) tran->str, NULL, 10) != tar->num_name) {     \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+                                                                                \
+        append_generic_to_postings(tag_attr, tag_target, slot_name, target_type)\
+                                                                                \
+        return 0;                                                               \
+    }
+
+/*  part_index is gram_index or digest_index, whichever tag_attr uses for partial matching
+ *
+ *  translation structure is deleted once no target refers to it
+ */
+#define del_generic_from_generic_postings(tag_attr, tag_target, slot_name, target_type, part_index) \
+    int del_##tag_target##_from_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target ** htab_p, tag_attr##_##part_index * matrix, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, target_type * tar) { \
         t_##tag_attr##_to_##tag_target * temp_tran;                                         \
                                                                                             \
         if (!matrix) {                                                                      \
@@ -886,28 +1191,168 @@
                                                                                             \
         temp_tran = tar->tag_attr##_to_##tag_target;                                        \
                                                                                             \
-        if (tar->tag_prev == NULL && tar->tag_next == NULL) {  /* last entry in list */     \
+        /* order does not matter, move last one in */                                       \
+        temp_tran->tar_num--;                                                               \
+        temp_tran->tar[tar->slot_name] = temp_tran->tar[temp_tran->tar_num];                \
+        temp_tran->tar[tar->slot_name]->slot_name = tar->slot_name;                         \
+                                                                                            \
+        if (temp_tran->tar_num == 0) {  /* last target */                                   \
             /* delete from hash table */                                                    \
             del_##tag_attr##_to_##tag_target##_from_htab(htab_p, temp_tran);                \
-            /* delete from existence matrix */                                              \
-            del_##tag_attr##_from_##tag_attr##_exist_mat(matrix, l2_arr, temp_tran->obj_arr_index);\
+            /* delete from gram index or digest index */                                    \
+            del_##tag_attr##_from_##tag_attr##_##part_index(matrix, l2_arr, temp_tran->obj_arr_index);\
+            /* free posting array */                                                        \
+            if (temp_tran->tar != &temp_tran->tar_one) {                                    \
+                free(temp_tran->tar);                                                       \
+            }                                                                               \
+            temp_tran->tar = &temp_tran->tar_one;                                           \
+            temp_tran->tar_max = 1;                                                         \
             /* delete from layer 2 array */                                                 \
             del_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, temp_tran->obj_arr_index);\
-            /* nullify link */                                                              \
-            tar->tag_attr##_to_##tag_target = NULL;                                         \
         }                                                                                   \
-        else if (tar->tag_prev == NULL) {    /* head of list */                             \
-            temp_tran->head_tar = tar->tag_next;                                            \
-            tar->tag_next->tag_prev = NULL;                                                 \
+                                                                                            \
+        /* nullify link */                                                                  \
+        tar->tag_attr##_to_##tag_target = NULL;                                             \
+                                                                                            \
+        return 0;                                                                           \
+    }
+
+/* frees posting arrays of all translation structures in hash table, structures are left in place */
+#define fres_generic_postings(tag_attr, tag_target) \
+    int fres_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * htab) { \
+        t_##tag_attr##_to_##tag_target * temp_tran;                             \
+        t_##tag_attr##_to_##tag_target * temp_tran_tmp;                         \
+                                                                                \
+        HASH_ITER(hh, htab, temp_tran, temp_tran_tmp) {                         \
+            if (temp_tran->tar != &temp_tran->tar_one) {                        \
+                free(temp_tran->tar);                                           \
+            }                                                                   \
+            temp_tran->tar = &temp_tran->tar_one;                               \
+            temp_tran->tar_max = 1;                                             \
+        }                                                                       \
+                                                                                \
+        return 0;                                                               \
+    }
+
+/* sections are referred to by (file data, section number), see note on section layout */
+#define add_generic_to_generic_sect_postings(tag_attr, tag_target) \
+    int add_##tag_target##_to_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target * tran, file_data * data, uint64_t sect_index) { \
+        sect_ref* temp_ref;                                                     \
+                                                                                \
+        if (!tran) {                                                            \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+        if (!data) {                                                            \
+            return WRONG_ARGS;                                                  \
+        }                                                                       \
+                                                                                \
+        if (tran->tar_num == tran->tar_max) {                                   \
+            temp_ref = realloc(tran->tar, sizeof(sect_ref) * (tran->tar_max ? tran->tar_max * 2 : 1)); \
+            if (!temp_ref) {                                                    \
+                return MALLOC_FAIL;                                             \
+            }                                                                   \
+            tran->tar = temp_ref;                                               \
+            tran->tar_max = tran->tar_max ? tran->tar_max * 2 : 1;              \
+        }                                                                       \
+                                                                                \
+        tran->tar[tran->tar_num].data = data;                                   \
+        tran->tar[tran->tar_num].index = sect_index;                            \
+        tran->tar_num++;                                                        \
+                                                                                \
+        tran->purged = 0;                                                       \
+                                                                                \
+        return 0;                                                               \
+    }
+
+/*  del removes one section, purge removes all sections of data in one pass,
+ *  purged remembers data so later sections of data with the same digest skip the scan
+ *
+ *  translation structure is deleted once no section refers to it
+ */
+#define del_generic_from_generic_sect_postings(tag_attr, tag_target, chks_index, KEY_LEN, part_index) \
+    static void drop_##tag_attr##_to_##tag_target##_if_unused (t_##tag_attr##_to_##tag_target ** htab_p, tag_attr##_##part_index * matrix, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, t_##tag_attr##_to_##tag_target * tran) { \
+        if (tran->tar_num > 0) {                                                            \
+            return;                                                                         \
         }                                                                                   \
-        else if(tar->tag_next == NULL) {     /* tail of list */                             \
-            temp_tran->tail_tar = tar->tag_prev;                                            \
-            tar->tag_prev->tag_next = NULL;                                                 \
+                                                                                            \
+        del_##tag_attr##_to_##tag_target##_from_htab(htab_p, tran);                         \
+        del_##tag_attr##_from_##tag_attr##_##part_index(matrix, l2_arr, tran->obj_arr_index);\
+        free(tran->tar);                                                                    \
+        tran->tar = 0;                                                                      \
+        tran->tar_max = 0;                                                                  \
+        del_##tag_attr##_to_##tag_target##_from_layer2_arr(l2_arr, tran->obj_arr_index);    \
+    }                                                                                       \
+                                                                                            \
+    int del_##tag_target##_from_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target ** htab_p, tag_attr##_##part_index * matrix, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, file_data * data, uint64_t sect_index) { \
+        t_##tag_attr##_to_##tag_target * temp_tran;                                         \
+        uint32_t i;                                                                         \
+                                                                                            \
+        if (!matrix) {                                                                      \
+            return WRONG_ARGS;                                                              \
         }                                                                                   \
-        else {      /* somewhere in list */                                                 \
-            tar->tag_prev->tag_next = tar->tag_next;                                        \
-            tar->tag_next->tag_prev = tar->tag_prev;                                        \
+        if (!l2_arr) {                                                                      \
+            return WRONG_ARGS;                                                              \
         }                                                                                   \
+        if (!data) {                                                                        \
+            return WRONG_ARGS;                                                              \
+        }                                                                                   \
+                                                                                            \
+        if (!sect_has_checksum(data, sect_index, chks_index)) {  /* not linked */           \
+            return 0;                                                                       \
+        }                                                                                   \
+                                                                                            \
+        HASH_FIND_DIGEST(*htab_p, sect_digest(data, sect_index, chks_index), KEY_LEN, temp_tran);\
+        if (!temp_tran) {                                                                   \
+            return 0;                                                                       \
+        }                                                                                   \
+                                                                                            \
+        /* order does not matter, move last one in */                                       \
+        for (i = 0; i < temp_tran->tar_num; i++) {                                          \
+            if (temp_tran->tar[i].data == data && temp_tran->tar[i].index == sect_index) {  \
+                temp_tran->tar[i] = temp_tran->tar[--temp_tran->tar_num];                   \
+                break;                                                                      \
+            }                                                                               \
+        }                                                                                   \
+                                                                                            \
+        drop_##tag_attr##_to_##tag_target##_if_unused(htab_p, matrix, l2_arr, temp_tran);   \
+                                                                                            \
+        return 0;                                                                           \
+    }                                                                                       \
+                                                                                            \
+    int purge_fd_from_##tag_attr##_to_##tag_target##_postings (t_##tag_attr##_to_##tag_target ** htab_p, tag_attr##_##part_index * matrix, layer2_##tag_attr##_to_##tag_target##_arr * l2_arr, file_data * data, uint64_t sect_index) { \
+        t_##tag_attr##_to_##tag_target * temp_tran;                                         \
+        uint32_t i;                                                                         \
+                                                                                            \
+        if (!matrix) {                                                                      \
+            return WRONG_ARGS;                                                              \
+        }                                                                                   \
+        if (!l2_arr) {                                                                      \
+            return WRONG_ARGS;                                                              \
+        }                                                                                   \
+        if (!data) {                                                                        \
+            return WRONG_ARGS;                                                              \
+        }                                                                                   \
+                                                                                            \
+        if (!sect_has_checksum(data, sect_index, chks_index)) {  /* not linked */           \
+            return 0;                                                                       \
+        }                                                                                   \
+                                                                                            \
+        HASH_FIND_DIGEST(*htab_p, sect_digest(data, sect_index, chks_index), KEY_LEN, temp_tran);\
+        if (!temp_tran || temp_tran->purged == data) {                                      \
+            return 0;                                                                       \
+        }                                                                                   \
+                                                                                            \
+        for (i = 0; i < temp_tran->tar_num; ) {                                             \
+            if (temp_tran->tar[i].data == data) {                                           \
+                temp_tran->tar[i] = temp_tran->tar[--temp_tran->tar_num];                   \
+            }                                                                               \
+            else {                                                                          \
+                i++;                                                                        \
+            }                                                                               \
+        }                                                                                   \
+        temp_tran->purged = data;                                                           \
+                                                                                            \
+        drop_##tag_attr##_to_##tag_target##_if_unused(htab_p, matrix, l2_arr, temp_tran);   \
                                                                                             \
         return 0;                                                                           \
     }
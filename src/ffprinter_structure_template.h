@@ -34,15 +34,75 @@
         UT_hash_handle hh;                  \
     };
 
+/* tar points to tar_one until a second target is added, see note on postings */
 #define generic_trans_struct_one_to_many(tag_attr, tag_target, target_type, STR_LEN) \
     struct t_##tag_attr##_to_##tag_target { \
         char str[(STR_LEN) + 1];            \
         str_len_int str_len;                \
                                             \
-        uint32_t number;                    \
+        target_type ** tar;                 \
+        target_type * tar_one;              \
+        uint32_t tar_num;                   \
+        uint32_t tar_max;                   \
                                             \
-        target_type * head_tar;             \
-        target_type * tail_tar;             \
+        obj_meta_data_fields;               \
+                                            \
+        UT_hash_handle hh;                  \
+    };
+
+/* id is the key, str points to the interned string, see string interning */
+#define generic_trans_struct_one_to_many_str_id(tag_attr, tag_target, target_type) \
+    struct t_##tag_attr##_to_##tag_target { \
+        str_id id;                          \
+        const char* str;                    \
+        str_len_int str_len;                \
+                                            \
+        target_type ** tar;                 \
+        target_type * tar_one;              \
+        uint32_t tar_num;                   \
+        uint32_t tar_max;                   \
+                                            \
+        obj_meta_data_fields;               \
+                                            \
+        UT_hash_handle hh;                  \
+    };
+
+/* key is the binary value (entry id or digest), key must stay the first field, see digest index */
+#define generic_trans_struct_one_to_one_key(tag_attr, tag_target, target_type, KEY_LEN) \
+    struct t_##tag_attr##_to_##tag_target { \
+        unsigned char key[(KEY_LEN)];       \
+                                            \
+        target_type * tar;                  \
+                                            \
+        obj_meta_data_fields;               \
+                                            \
+        UT_hash_handle hh;                  \
+    };
+
+#define generic_trans_struct_one_to_many_key(tag_attr, tag_target, target_type, KEY_LEN) \
+    struct t_##tag_attr##_to_##tag_target { \
+        unsigned char key[(KEY_LEN)];       \
+                                            \
+        target_type ** tar;                 \
+        target_type * tar_one;              \
+        uint32_t tar_num;                   \
+        uint32_t tar_max;                   \
+                                            \
+        obj_meta_data_fields;               \
+                                            \
+        UT_hash_handle hh;                  \
+    };
+
+/* key is the digest, sections are referred to by (file data, section number), see note on section layout */
+#define generic_trans_struct_one_to_many_sect_key(tag_attr, tag_target, KEY_LEN) \
+    struct t_##tag_attr##_to_##tag_target { \
+        unsigned char key[(KEY_LEN)];       \
+                                            \
+        sect_ref* tar;                      \
+        uint32_t tar_num;                   \
+        uint32_t tar_max;                   \
+                                            \
+        file_data* purged;                  \
                                             \
         obj_meta_data_fields;               \
                                             \
@@ -55,6 +115,12 @@
         uint16_t max_length;                \
     };
 
+#define generic_gram_index(tag_attr) \
+    typedef gram_index tag_attr##_gram_index;
+
+#define generic_digest_index(tag_attr) \
+    typedef digest_index tag_attr##_digest_index;
+
 #define obj_meta_data_fields \
     bit_index obj_arr_index;
 
@@ -62,17 +128,26 @@
     typedef struct layer1_##obj_name##_arr layer1_##obj_name##_arr; \
     typedef struct layer2_##obj_name##_arr layer2_##obj_name##_arr;
 
+/* free_head : offset + 1 of first freed slot, 0 if none, freed slots are chained via obj_arr_index
+ * bump_index : slots at and after this offset have never been handed out
+ * next_avail : index + 1 of next L1 array with free slots, 0 if last
+ */
 #define layer1_obj_arr(obj_name, obj_type, L1_ARR_SIZE) \
     struct layer1_##obj_name##_arr {                                            \
         obj_type arr[(L1_ARR_SIZE)];                                            \
         simple_bitmap usage_map;                                                \
         map_block usage_map_raw[get_bitmap_map_block_number((L1_ARR_SIZE))];    \
+        uint32_t free_head;                                                     \
+        uint32_t bump_index;                                                    \
+        bit_index next_avail;                                                   \
     };
 
+/* avail_head : index + 1 of first L1 array with free slots, 0 if all full */
 #define layer2_obj_arr(obj_name) \
     struct layer2_##obj_name##_arr {          \
         layer1_##obj_name##_arr ** l1_arr;    \
         simple_bitmap l1_arr_map;             \
+        bit_index avail_head;                 \
     };
 
 #define layer1_generic_arr(tag_attr, tag_target, L1_ARR_SIZE) \
@@ -33,6 +33,9 @@ int main (void) {
 
     srand(time(NULL));
 
+    // pick hashing backend
+    afalg_probe();
+
     ret = 0;
     while (ret != QUIT_REQUESTED) {
         ret = prompt(&info, &dir);
@@ -31,6 +31,7 @@
  *
  *  Notes for using tests in case of modification of templates:
  *      Below tests assumes that addition of pointers/values are all sequential
+ *      for fresh slots, freed slots may be handed out again in any order
  *      If your implementation is randomness based, please devise another set of tests
  *      as the tests below will not work properly in that case
  *
@@ -50,12 +51,14 @@
 #include "../src/ffprinter.h"
 #include "../src/ffprinter_function_template.h"
 #include "../src/ffp_database_function_template.h"
+#include "../src/ffp_database.h"
 
 // use small sizes to force growth handling quicker
 #define UTEST_ID_LENGTH         10
 #define UTEST_L1_SIZE           4
 #define UTEST_L2_INIT_SIZE      10
 #define UTEST_L2_GROW_SIZE      2
+#define UTEST_KEY_LENGTH        4
 
 #define LARGE_INT               100000
 
@@ -63,15 +66,15 @@
 
 typedef struct utester utester;
 
+typedefs_trans(id, ut)
+
 struct utester {
     char id[UTEST_ID_LENGTH+1];
 
-    utester* prev_same_id;
-    utester* next_same_id;
+    t_id_to_ut* id_to_ut;
+    uint32_t id_slot;
 };
 
-typedefs_trans(id, ut)
-
 generic_trans_struct_one_to_many(id, ut, utester, UTEST_ID_LENGTH)
 layer1_generic_arr(id, ut, UTEST_L1_SIZE)
 layer2_generic_arr(id, ut)
@@ -95,10 +98,40 @@ del_generic_from_generic_exist_mat(id, ut, UTEST_L1_SIZE)
 
 del_generic_exist_mat(id, 10)
 
-lookup_generic_one_to_many_tran(id, ut, id, utester)
+add_generic_to_htab(id, ut)
+del_generic_from_htab(id, ut)
+
+add_generic_to_generic_postings(id, ut, id_slot, id, utester)
+del_generic_from_generic_postings(id, ut, id_slot, utester, exist_mat)
+
+lookup_generic_one_to_many_tran(id, ut, id)
 lookup_generic_part_map(id, ut, id, UTEST_ID_LENGTH)
 lookup_generic_part(id, ut, id, UTEST_ID_LENGTH)
 
+generic_gram_index(id)
+init_generic_gram_index(id)
+add_generic_to_generic_gram_index(id, UTEST_ID_LENGTH)
+del_generic_from_generic_gram_index(id, ut)
+lookup_generic_part_gram(id, ut, id_gram, UTEST_ID_LENGTH, UTEST_L1_SIZE)
+
+typedefs_trans(sum, ut)
+
+generic_trans_struct_one_to_many_key(sum, ut, utester, UTEST_KEY_LENGTH)
+generic_digest_index(sum)
+
+init_generic_digest_index(sum, UTEST_KEY_LENGTH)
+add_generic_to_generic_digest_index(sum, ut)
+
+lookup_generic_part_digest(sum, ut, sum, UTEST_KEY_LENGTH * 2)
+
+// fills in string of tran from tar, then appends tar to postings of tran
+int link_to_postings(utester* tar, t_id_to_ut* tran) {
+    strcpy(tran->str, tar->id);
+    tran->str_len = strlen(tar->id);
+
+    return add_ut_to_id_to_ut_postings(tran, tar);
+}
+
 // no dependencies on correctness of other structures
 int test_add_get_del_with_layer2_arr() {
     uint64_t i;
@@ -161,7 +194,7 @@ int test_add_get_del_with_layer2_arr() {
     // setup translation structure
     init_id_to_ut(id_to_ut);
     // link id_to_ut to tdum
-    link_to_tran(&tdum, id_to_ut);
+    link_to_postings(&tdum, id_to_ut);
 
     // test valid get using used index
     printf("test area 3 : valid get using used index\n");
@@ -230,11 +263,12 @@ int test_add_get_del_with_layer2_arr() {
     incre_check();
     for (i = 0; i < LARGE_INT; i++) {
         add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        init_id_to_ut(id_to_ut);
         if (i % 2 == 0) {
-            link_to_tran(&tdum, id_to_ut);
+            link_to_postings(&tdum, id_to_ut);
         }
         else {
-            link_to_tran(&tdum2, id_to_ut);
+            link_to_postings(&tdum2, id_to_ut);
         }
     }
     // check for allocations using get
@@ -249,8 +283,9 @@ int test_add_get_del_with_layer2_arr() {
         }
         if (i % 2 == 0) {
             if (        strcmp(id_to_ut_found->str, tdum.id) != 0
-                    ||  id_to_ut_found->head_tar    != &tdum
-                    ||  id_to_ut_found->tail_tar    != &tdum
+                    ||  id_to_ut_found->tar_num     != 1
+                    ||  id_to_ut_found->tar[0]      != &tdum
+                    ||  id_to_ut_found->tar         != &id_to_ut_found->tar_one
                     ||  id_to_ut_found->str_len     != strlen(tdum.id)
                )
             {
@@ -262,8 +297,9 @@ int test_add_get_del_with_layer2_arr() {
         }
         else {
             if (        strcmp(id_to_ut_found->str, tdum2.id) != 0
-                    ||  id_to_ut_found->head_tar    != &tdum2
-                    ||  id_to_ut_found->tail_tar    != &tdum2
+                    ||  id_to_ut_found->tar_num     != 1
+                    ||  id_to_ut_found->tar[0]      != &tdum2
+                    ||  id_to_ut_found->tar         != &id_to_ut_found->tar_one
                     ||  id_to_ut_found->str_len     != strlen(tdum2.id)
                )
             {
@@ -301,13 +337,15 @@ int test_add_get_del_with_layer2_arr() {
     // with different offsets
     printf("test area 10 : large quantity allocation to test index reuse\n");
     incre_check();
+    // freed slots are not handed out in index order, so link by index rather than by order of allocation
     for (i = 0; i < LARGE_INT; i++) {
-        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, NULL);
-        if (i % 2 == 0) {
-            link_to_tran(&tdum, id_to_ut);
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        init_id_to_ut(id_to_ut);
+        if (index_in_arr % 2 == 0) {
+            link_to_postings(&tdum, id_to_ut);
         }
         else {
-            link_to_tran(&tdum2, id_to_ut);
+            link_to_postings(&tdum2, id_to_ut);
         }
     }
     // confirm allocations
@@ -322,8 +360,9 @@ int test_add_get_del_with_layer2_arr() {
         }
         if (i % 2 == 0) {
             if (        strcmp(id_to_ut_found->str, tdum.id) != 0
-                    ||  id_to_ut_found->head_tar    != &tdum
-                    ||  id_to_ut_found->tail_tar    != &tdum
+                    ||  id_to_ut_found->tar_num     != 1
+                    ||  id_to_ut_found->tar[0]      != &tdum
+                    ||  id_to_ut_found->tar         != &id_to_ut_found->tar_one
                     ||  id_to_ut_found->str_len     != strlen(tdum.id)
                )
             {
@@ -335,8 +374,9 @@ int test_add_get_del_with_layer2_arr() {
         }
         else {
             if (        strcmp(id_to_ut_found->str, tdum2.id) != 0
-                    ||  id_to_ut_found->head_tar    != &tdum2
-                    ||  id_to_ut_found->tail_tar    != &tdum2
+                    ||  id_to_ut_found->tar_num     != 1
+                    ||  id_to_ut_found->tar[0]      != &tdum2
+                    ||  id_to_ut_found->tar         != &id_to_ut_found->tar_one
                     ||  id_to_ut_found->str_len     != strlen(tdum2.id)
                )
             {
@@ -407,42 +447,26 @@ int test_add_get_del_with_layer2_arr() {
             goto end_test11;
         }
     }
-    // allocate 201 units, which should use index 200 to 400
-    for (i = 0; i <= 200; i++) {
-        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, NULL);
-    }
-    // confirm prediction
-    for (i = 200; i <= 400; i++) {
-        ret = get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, i);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour error code to be 0\n");
-            printf("returned error code : %d\n", ret);
+    // allocate 1703 units, which should use up exactly the freed slots
+    // order in which freed slots are handed out is not within any requirement
+    for (i = 0; i < 201 + 501 + 1001; i++) {
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        if (index_in_arr >= LARGE_INT) {
+            printf("got fresh slot while freed slots remain\n");
+            printf("expected behaviour : freed slots to be used before fresh ones\n");
+            printf("index handed out : %"PRIu64"\n", index_in_arr);
             incre_error();
             goto end_test11;
         }
     }
-    // allocate 501 units, which should use index 500 to 1000
-    for (i = 0; i <= 500; i++) {
-        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, NULL);
-    }
     // confirm prediction
-    for (i = 500; i <= 1000; i++) {
-        ret = get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, i);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test11;
+    for (i = 200; i <= 3000; i++) {
+        if (i == 401) {
+            i = 500;
+        }
+        else if (i == 1001) {
+            i = 2000;
         }
-    }
-    // allocate 1001 units, which should use index 2000 to 3000
-    for (i = 0; i <= 1000; i++) {
-        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, NULL);
-    }
-    // confirm prediction
-    for (i = 2000; i <= 3000; i++) {
         ret = get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, i);
         if (ret != 0) {
             printf("got error code other than 0\n");
@@ -476,216 +500,766 @@ end_test12:
     return error_num;
 }
 
-// depends on layer2 array to be correct, for the buffer filling function
-// well supposedly correct, cause tests cannot prove correctness yadadadada
-int test_add_lookup_buffer_del_with_exist_mat(int ret_test_l2_arr) {
-    int i;
+// depends on layer2 array to be correct, for get and delete
+int test_layer2_arr_reuse_and_growth(int ret_test_l2_arr) {
+    uint64_t i;
 
-    utester tdum;
-    utester tdum2;
     t_id_to_ut* id_to_ut;
+    t_id_to_ut* id_to_ut_found;
+    t_id_to_ut* first_chunk[UTEST_L2_INIT_SIZE * UTEST_L1_SIZE];
     layer2_id_to_ut_arr l2_arr;
     uint64_t index_in_arr;
-
-    id_exist_mat matrix;
-    simple_bitmap map_buffer;
-    map_block raw_map_buffer[get_bitmap_map_block_number(MAT_MAX_INDEX)];
-    simple_bitmap map_buffer2;
-    map_block raw_map_buffer2[get_bitmap_map_block_number(MAT_MAX_INDEX)];
-
-    t_id_to_ut* tran_buffer[100];
-    const uint64_t buffer_size = 100;
-    uint64_t num_used;
+    uint64_t reused[4];
 
     int ret;
 
     add_trackers();
 
-    announce_test(test_add_lookup_buffer_del_with_exist_mat);
+    announce_test(test_layer2_arr_reuse_and_growth);
     announce_test_begin();
 
     skip_if_prereq_failed(ret_test_l2_arr);
 
-    // setup data object
-    strcpy(tdum.id, "id_abc");
-    strcpy(tdum2.id, "id_def");
-
-    // setup translation structures
-    init_id_exist_mat(&matrix);
+    // setup layer 2 array
     init_layer2_id_to_ut_arr(&l2_arr);
-    bitmap_init(&map_buffer, raw_map_buffer, NULL, MAT_MAX_INDEX, 0);
-    bitmap_init(&map_buffer2, raw_map_buffer2, NULL, MAT_MAX_INDEX, 0);
 
-    // empty lookup via existence matrix
-    printf("test area 1 : lookup when existence matrix is empty\n");
+    // fresh slots are handed out in index order
+    printf("test area 1 : fill all layer 1 arrays allocated at init\n");
     incre_check();
-    ret = lookup_id_part(&l2_arr, &matrix, "foobar", &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
-    if (num_used != 0) {
-        printf("number of slots in buffer filled was reported to be non-zero\n");
-        printf("expected behaviour : report 0 slots filled\n");
-        printf("reported value : %"PRIu64"\n", num_used);
-        incre_error();
-        goto end_test1;
-    }
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
-        incre_error();
-        goto end_test1;
-    }
-    for (i = 0; i < buffer_size; i++) {
-        if (tran_buffer[i] != NULL) {
-            printf("slot %d in buffer was not 0/null\n", i);
-            printf("expected behaviour : all slots to be 0/null\n");
-            printf("filled slot : %p\n", tran_buffer[i]);
+    for (i = 0; i < UTEST_L2_INIT_SIZE * UTEST_L1_SIZE; i++) {
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        first_chunk[i] = id_to_ut;
+        if (index_in_arr != i) {
+            printf("got index other than %"PRIu64"\n", i);
+            printf("expected behaviour : fresh slots to be handed out in index order\n");
+            printf("index handed out : %"PRIu64"\n", index_in_arr);
             incre_error();
             goto end_test1;
         }
     }
+    if (l2_arr.avail_head != 0 || l2_arr.l1_arr_map.length != UTEST_L2_INIT_SIZE) {
+        printf("layer 2 array has usable layer 1 arrays left or has grown\n");
+        printf("expected behaviour : all %d layer 1 arrays to be full, no growth\n", UTEST_L2_INIT_SIZE);
+        printf("number of layer 1 arrays : %"PRIu64"\n", (uint64_t) l2_arr.l1_arr_map.length);
+        incre_error();
+    }
 
 end_test1:
 
-    // invalid delete when empty
-    printf("test area 2 : invalid delete of entry when matrix is empty\n");
+    // next object spills into a new layer 1 array, chunks grow geometrically
+    // 10 -> 20 -> 40 -> 80 layer 1 arrays, i.e. 320 slots
+    printf("test area 2 : growth across layer 1 array boundary\n");
     incre_check();
-    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
-    // should return FIND_FAIL
-    // as it uses get_id_to_ut_from_layer2_arr to retrieve the translation structure first
-    if (ret != FIND_FAIL) {
-        printf("got error code other than FIND_FAIL\n");
-        printf("expected behaviour : error code to be FIND_FAIL\n");
-        printf("returned error code : %d\n", ret);
+    add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (        index_in_arr != UTEST_L2_INIT_SIZE * UTEST_L1_SIZE
+            ||  l2_arr.l1_arr_map.length != UTEST_L2_INIT_SIZE * 2
+       )
+    {
+        printf("first object after growth is not in first new layer 1 array\n");
+        printf("expected behaviour : index %d, with %d layer 1 arrays\n", UTEST_L2_INIT_SIZE * UTEST_L1_SIZE, UTEST_L2_INIT_SIZE * 2);
+        printf("index handed out : %"PRIu64", number of layer 1 arrays : %"PRIu64"\n", index_in_arr, (uint64_t) l2_arr.l1_arr_map.length);
+        incre_error();
+        goto end_test2;
+    }
+    for (i = UTEST_L2_INIT_SIZE * UTEST_L1_SIZE + 1; i < 200; i++) {
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        if (index_in_arr != i) {
+            printf("got index other than %"PRIu64"\n", i);
+            printf("expected behaviour : fresh slots to be handed out in index order\n");
+            printf("index handed out : %"PRIu64"\n", index_in_arr);
+            incre_error();
+            goto end_test2;
+        }
+    }
+    if (l2_arr.l1_arr_map.length != UTEST_L2_INIT_SIZE * 8) {
+        printf("layer 2 array did not grow geometrically\n");
+        printf("expected behaviour : %d layer 1 arrays\n", UTEST_L2_INIT_SIZE * 8);
+        printf("number of layer 1 arrays : %"PRIu64"\n", (uint64_t) l2_arr.l1_arr_map.length);
         incre_error();
         goto end_test2;
     }
+    // objects do not move when layer 2 array grows
+    for (i = 0; i < 200; i++) {
+        ret = get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, i);
+        if (        ret != 0
+                ||  id_to_ut_found->obj_arr_index != i
+                ||  (i < UTEST_L2_INIT_SIZE * UTEST_L1_SIZE && id_to_ut_found != first_chunk[i])
+           )
+        {
+            printf("object at index %"PRIu64" is missing or has moved\n", i);
+            printf("expected behaviour : object to stay in place with its index\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test2;
+        }
+    }
 
 end_test2:
 
-    // add test data to layer 2 array, layer 2 array related functions assumed to be correct
+    // 5, 6, 7 share a layer 1 array, 41 sits in another
+    printf("test area 3 : freed slots are reused before fresh ones\n");
+    incre_check();
+    del_id_to_ut_from_layer2_arr(&l2_arr, 5);
+    del_id_to_ut_from_layer2_arr(&l2_arr, 6);
+    del_id_to_ut_from_layer2_arr(&l2_arr, 7);
+    del_id_to_ut_from_layer2_arr(&l2_arr, 41);
+    for (i = 0; i < 4; i++) {
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &reused[i]);
+    }
+    // order in which freed slots are handed out is not within any requirement
+    if (        reused[0] + reused[1] + reused[2] + reused[3] != 5 + 6 + 7 + 41
+            ||  get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, 5)
+            ||  get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, 6)
+            ||  get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, 7)
+            ||  get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, 41)
+       )
+    {
+        printf("freed slots were not all reused\n");
+        printf("expected behaviour : indices 5, 6, 7, 41 to be handed out again\n");
+        printf("indices handed out : %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64"\n", reused[0], reused[1], reused[2], reused[3]);
+        incre_error();
+        goto end_test3;
+    }
+    // free chain is empty again
     add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
-    // init
-    init_id_to_ut(id_to_ut);
-    // linkage creation
-    link_to_tran(&tdum, id_to_ut)
-    // add to existence matrix
-    add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
-    // full text lookup on non-empty structure
-    printf("test area 3 : full text lookup when one entry exists in matrix\n");
+    if (index_in_arr != 200 || l2_arr.l1_arr_map.length != UTEST_L2_INIT_SIZE * 8) {
+        printf("got index other than 200 after freed slots were used up\n");
+        printf("expected behaviour : next fresh slot, without growth\n");
+        printf("index handed out : %"PRIu64"\n", index_in_arr);
+        incre_error();
+        goto end_test3;
+    }
+
+end_test3:
+
+    printf("test area 4 : cleanup\n");
     incre_check();
-    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    // clear everything
+    ret = del_l2_id_to_ut_arr(&l2_arr);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test3;
+        goto end_test4;
     }
-    if (num_used != 1) {
-        printf("number of slots used in buffer is not one\n");
-        printf("expected behaviour : number used to be exactly one\n");
-        printf("number used reported : %"PRIu64"\n", num_used);
+
+end_test4:
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_layer2_arr_reuse_and_growth);
+
+    return error_num;
+}
+
+// depends on layer2 array to be correct, for the buffer filling function
+int test_add_lookup_del_with_gram_index(int ret_test_l2_arr) {
+    int i;
+
+    const char* strs[] = {"id_abc", "id_abd", "xx_abc", "abcXbcd"};
+    char str[UTEST_ID_LENGTH+1];
+
+    t_id_to_ut* id_to_ut;
+    layer2_id_to_ut_arr l2_arr;
+    uint64_t index_in_arr;
+
+    id_gram_index index;
+
+    t_id_to_ut* tran_buffer[400];
+    const uint64_t buffer_size = 400;
+    uint64_t num_used;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_add_lookup_del_with_gram_index);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+
+    // setup translation structures
+    init_id_gram_index(&index);
+    init_layer2_id_to_ut_arr(&l2_arr);
+
+    // empty lookup via gram index
+    printf("test area 1 : lookup when gram index is empty\n");
+    incre_check();
+    ret = lookup_id_gram_part(&l2_arr, &index, "abc", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("got error code other than 0 or non-zero number of slots filled\n");
+        printf("expected behaviour : error code to be 0, 0 slots filled\n");
+        printf("returned error code : %d, reported value : %"PRIu64"\n", ret, num_used);
         incre_error();
-        goto end_test3;
     }
-    if (strcmp(tran_buffer[0]->str, tdum.id) != 0) {
-        printf("retrieved id_to_ut does not contain the correct id\n");
-        printf("expected behaviour : retrieved translation structure to contain the id of tdum\n");
-        printf("id of retrieved translation structure : %s\n", tran_buffer[0]->str);
-        printf("id of tdum : %s\n", tdum.id);
+
+    // index 0 to 3
+    for (i = 0; i < 4; i++) {
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        init_id_to_ut(id_to_ut);
+        strcpy(id_to_ut->str, strs[i]);
+        id_to_ut->str_len = strlen(strs[i]);
+        add_id_to_id_gram_index(&index, id_to_ut->str, index_in_arr);
+    }
+
+    // "abcXbcd" has both grams of "abcd", but does not contain it
+    printf("test area 2 : lookups return exact matches only\n");
+    incre_check();
+    ret = lookup_id_gram_part(&l2_arr, &index, "abc", tran_buffer, buffer_size, &num_used);
+    if (        ret != 0
+            ||  num_used != 3
+            ||  strcmp(tran_buffer[0]->str, "id_abc") != 0
+            ||  strcmp(tran_buffer[1]->str, "xx_abc") != 0
+            ||  strcmp(tran_buffer[2]->str, "abcXbcd") != 0
+       )
+    {
+        printf("lookup of \"abc\" did not return id_abc, xx_abc, abcXbcd\n");
+        printf("expected behaviour : 3 matches in order of index\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
         incre_error();
-        goto end_test3;
+        goto end_test2;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
-        printf("address of tdum : %p\n", &tdum);
+    ret = lookup_id_gram_part(&l2_arr, &index, "abcd", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("lookup of \"abcd\" returned candidate which does not contain it\n");
+        printf("expected behaviour : 0 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
         incre_error();
-        goto end_test3;
+        goto end_test2;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    ret = lookup_id_gram_part(&l2_arr, &index, "zzz", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("lookup of gram not in any string returned something\n");
+        printf("expected behaviour : 0 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
         incre_error();
-        goto end_test3;
+        goto end_test2;
     }
 
-end_test3:
+end_test2:
 
-    // invalid delete when not empty
-    printf("test area 4 : invalid delete of entry when matrix is not empty\n");
+    // shorter than GRAM_LEN, goes through layer 2 array
+    printf("test area 3 : lookup of string without any gram\n");
     incre_check();
-    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 2);
-    // should return FIND_FAIL
-    // as it uses get_id_to_ut_from_layer2_arr to retrieve the translation structure first
-    if (ret != FIND_FAIL) {
-        printf("got error code other than FIND_FAIL\n");
-        printf("expected behaviour : error code to be FIND_FAIL\n");
-        printf("returned error code : %d\n", ret);
+    ret = lookup_id_gram_part(&l2_arr, &index, "_a", tran_buffer, buffer_size, &num_used);
+    if (        ret != 0
+            ||  num_used != 3
+            ||  strcmp(tran_buffer[0]->str, "id_abc") != 0
+            ||  strcmp(tran_buffer[1]->str, "id_abd") != 0
+            ||  strcmp(tran_buffer[2]->str, "xx_abc") != 0
+       )
+    {
+        printf("lookup of \"_a\" did not return id_abc, id_abd, xx_abc\n");
+        printf("expected behaviour : 3 matches in order of index\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+    }
+
+    printf("test area 4 : ranged lookup and full buffer\n");
+    incre_check();
+    ret = lookup_id_gram_part_ranged(&l2_arr, &index, "abc", 3, 3, tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 2 || tran_buffer[1]->obj_arr_index != 2) {
+        printf("ranged lookup of \"abc\" at position 3 did not return id_abc, xx_abc\n");
+        printf("expected behaviour : 2 matches\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test4;
+    }
+    ret = lookup_id_gram_part(&l2_arr, &index, "abc", tran_buffer, 2, &num_used);
+    if (ret != BUFFER_FULL || num_used != 2) {
+        printf("got error code other than BUFFER_FULL\n");
+        printf("expected behaviour : error code to be BUFFER_FULL, 2 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
         incre_error();
         goto end_test4;
     }
 
 end_test4:
 
-    // valid delete of added entry from test area 2
-    // technically should also delete from layer 2 array
-    // but since this is the only entry, and the only entry in its layer 1 array
-    // so existence matrix will register the entire layer 1 array as having no
-    // matching entries
-    // thus lookup will fail regardless
-    // regardles of whether the uniq_char structure is deleted or not
-    printf("test area 5 : continuing from test area 2, deleting valid entry\n");
+    printf("test area 5 : delete from gram index\n");
     incre_check();
-    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
-    if (ret != 0) {
-        printf("function del_id_from_id_exist_mat\n");
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
-        incre_error();
-        goto end_test5;
-    }
-    // confirm via lookup
-    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    ret = del_id_from_id_gram_index(&index, &l2_arr, 0);
     if (ret != 0) {
-        printf("function lookup_id_part\n");
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
         goto end_test5;
     }
-    if (num_used != 0) {
-        printf("number of slots used in buffer is not zero\n");
-        printf("expected behaviour : number used to be exactly one\n");
-        printf("number used reported : %"PRIu64"\n", num_used);
+    del_id_to_ut_from_layer2_arr(&l2_arr, 0);
+    ret = lookup_id_gram_part(&l2_arr, &index, "abc", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 2 || strcmp(tran_buffer[0]->str, "xx_abc") != 0) {
+        printf("deleted string is still found\n");
+        printf("expected behaviour : xx_abc, abcXbcd to be found\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
         incre_error();
         goto end_test5;
     }
 
 end_test5:
 
-    // add same entry many times
-    printf("test area 6 : adding same entry multiple times\n");
+    // lists longer than GRAM_BLOCK_MAX are split into blocks
+    printf("test area 6 : add and delete across blocks of one gram\n");
     incre_check();
-    for (i = 0; i < LARGE_INT; i++) {
-        ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
+    for (i = 0; i < 300; i++) {
+        sprintf(str, "qqq%05d", i);
+        add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        init_id_to_ut(id_to_ut);
+        strcpy(id_to_ut->str, str);
+        id_to_ut->str_len = strlen(str);
+        add_id_to_id_gram_index(&index, id_to_ut->str, index_in_arr);
+    }
+    // delete every third one
+    for (i = 0; i < 300; i += 3) {
+        sprintf(str, "qqq%05d", i);
+        ret = lookup_id_gram_part(&l2_arr, &index, str, tran_buffer, buffer_size, &num_used);
+        if (ret != 0 || num_used != 1) {
+            printf("lookup of \"%s\" did not return exactly one match\n", str);
+            printf("expected behaviour : 1 slot filled\n");
+            printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
             incre_error();
             goto end_test6;
         }
+        index_in_arr = tran_buffer[0]->obj_arr_index;
+        del_id_from_id_gram_index(&index, &l2_arr, index_in_arr);
+        del_id_to_ut_from_layer2_arr(&l2_arr, index_in_arr);
     }
-    // confirm via lookup
-    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
-    if (ret != 0) {
-        printf("function lookup_id_part\n");
+    ret = lookup_id_gram_part(&l2_arr, &index, "qqq", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 200) {
+        printf("number of slots used in buffer is not 200\n");
+        printf("expected behaviour : 200 matches left\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test6;
+    }
+    for (i = 0; i < 200; i++) {
+        sprintf(str, "qqq%05d", i / 2 * 3 + i % 2 + 1);
+        if (strcmp(tran_buffer[i]->str, str) != 0) {
+            printf("slot %d in buffer holds %s\n", i, tran_buffer[i]->str);
+            printf("expected behaviour : to hold %s\n", str);
+            incre_error();
+            goto end_test6;
+        }
+    }
+
+end_test6:
+
+    printf("test area 7 : cleanup\n");
+    incre_check();
+    // clear everything
+    ret = del_l2_id_to_ut_arr(&l2_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test7;
+    }
+    ret = del_gram_index(&index);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test7;
+    }
+
+end_test7:
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_lookup_del_with_gram_index);
+
+    return error_num;
+}
+
+// no dependencies on correctness of other structures
+int test_add_lookup_del_with_digest_index() {
+    int i;
+
+    // keys share prefixes of various lengths, listed in order of key
+    const unsigned char keys[5][UTEST_KEY_LENGTH] = {
+        {0x12, 0x00, 0x00, 0x00},
+        {0xAB, 0x12, 0x00, 0x00},
+        {0xAB, 0x12, 0x00, 0x01},
+        {0xAB, 0x13, 0xFF, 0x00},
+        {0xAB, 0x80, 0x00, 0x00}
+    };
+
+    t_sum_to_ut sum_to_ut[5];
+
+    sum_digest_index index;
+
+    t_sum_to_ut* tran_buffer[10];
+    const uint64_t buffer_size = 10;
+    uint64_t num_used;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_add_lookup_del_with_digest_index);
+    announce_test_begin();
+
+    init_sum_digest_index(&index);
+
+    printf("test area 1 : lookup when digest index is empty\n");
+    incre_check();
+    ret = lookup_sum_part(&index, "ab", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("got error code other than 0 or non-zero number of slots filled\n");
+        printf("expected behaviour : error code to be 0, 0 slots filled\n");
+        printf("returned error code : %d, reported value : %"PRIu64"\n", ret, num_used);
+        incre_error();
+    }
+
+    // add in other order than key order
+    for (i = 4; i >= 0; i--) {
+        memcpy(sum_to_ut[i].key, keys[i], UTEST_KEY_LENGTH);
+        add_sum_to_sum_digest_index(&index, &sum_to_ut[i]);
+    }
+
+    printf("test area 2 : adding key twice\n");
+    incre_check();
+    ret = add_sum_to_sum_digest_index(&index, &sum_to_ut[2]);
+    if (ret != DUPLICATE_ERROR) {
+        printf("got error code other than DUPLICATE_ERROR\n");
+        printf("expected behaviour : error code to be DUPLICATE_ERROR\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+    }
+
+    // "ab1" is 12 bits, so critical bit of ab12/ab13 lies past the prefix
+    printf("test area 3 : prefix lookups with shared prefixes\n");
+    incre_check();
+    ret = lookup_sum_part(&index, "ab1", tran_buffer, buffer_size, &num_used);
+    if (        ret != 0
+            ||  num_used != 3
+            ||  tran_buffer[0] != &sum_to_ut[1]
+            ||  tran_buffer[1] != &sum_to_ut[2]
+            ||  tran_buffer[2] != &sum_to_ut[3]
+       )
+    {
+        printf("lookup of \"ab1\" did not return ab120000, ab120001, ab13ff00\n");
+        printf("expected behaviour : 3 matches in order of key\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test3;
+    }
+    ret = lookup_sum_part(&index, "AB12000", tran_buffer, buffer_size, &num_used);
+    if (        ret != 0
+            ||  num_used != 2
+            ||  tran_buffer[0] != &sum_to_ut[1]
+            ||  tran_buffer[1] != &sum_to_ut[2]
+       )
+    {
+        printf("lookup of \"AB12000\" did not return ab120000, ab120001\n");
+        printf("expected behaviour : 2 matches in order of key\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test3;
+    }
+    ret = lookup_sum_part(&index, "ab120001", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 1 || tran_buffer[0] != &sum_to_ut[2]) {
+        printf("lookup of full key did not return ab120001 only\n");
+        printf("expected behaviour : 1 match\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test3;
+    }
+    ret = lookup_sum_part(&index, "a", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 4 || tran_buffer[3] != &sum_to_ut[4]) {
+        printf("lookup of \"a\" did not return all keys starting with ab\n");
+        printf("expected behaviour : 4 matches in order of key\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test3;
+    }
+
+end_test3:
+
+    // walk ends in ab12/ab13 subtree, whose keys do not match
+    printf("test area 4 : prefix lookups without matches\n");
+    incre_check();
+    ret = lookup_sum_part(&index, "ab14", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("lookup of \"ab14\" returned something\n");
+        printf("expected behaviour : 0 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+    }
+    ret = lookup_sum_part(&index, "ab1x", tran_buffer, buffer_size, &num_used);
+    if (ret != 0 || num_used != 0) {
+        printf("lookup of non hex string returned something\n");
+        printf("expected behaviour : 0 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+    }
+
+    printf("test area 5 : full buffer\n");
+    incre_check();
+    ret = lookup_sum_part(&index, "ab", tran_buffer, 2, &num_used);
+    if (ret != BUFFER_FULL || num_used != 2 || tran_buffer[1] != &sum_to_ut[2]) {
+        printf("got error code other than BUFFER_FULL\n");
+        printf("expected behaviour : error code to be BUFFER_FULL, 2 slots filled\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+    }
+
+    printf("test area 6 : delete from digest index\n");
+    incre_check();
+    ret = del_from_digest_index(&index, &sum_to_ut[1]);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test6;
+    }
+    ret = lookup_sum_part(&index, "ab1", tran_buffer, buffer_size, &num_used);
+    if (        ret != 0
+            ||  num_used != 2
+            ||  tran_buffer[0] != &sum_to_ut[2]
+            ||  tran_buffer[1] != &sum_to_ut[3]
+            ||  index.num != 4
+       )
+    {
+        printf("lookup of \"ab1\" did not return ab120001, ab13ff00\n");
+        printf("expected behaviour : 2 matches in order of key\n");
+        printf("returned error code : %d, number used reported : %"PRIu64"\n", ret, num_used);
+        incre_error();
+        goto end_test6;
+    }
+
+end_test6:
+
+    printf("test area 7 : cleanup\n");
+    incre_check();
+    ret = del_digest_index(&index);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+    }
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_lookup_del_with_digest_index);
+
+    return error_num;
+}
+
+// depends on layer2 array to be correct, for the buffer filling function
+// well supposedly correct, cause tests cannot prove correctness yadadadada
+int test_add_lookup_buffer_del_with_exist_mat(int ret_test_l2_arr) {
+    int i;
+
+    utester tdum;
+    utester tdum2;
+    t_id_to_ut* id_to_ut;
+    layer2_id_to_ut_arr l2_arr;
+    uint64_t index_in_arr;
+
+    id_exist_mat matrix;
+    simple_bitmap map_buffer;
+    map_block raw_map_buffer[get_bitmap_map_block_number(MAT_MAX_INDEX)];
+    simple_bitmap map_buffer2;
+    map_block raw_map_buffer2[get_bitmap_map_block_number(MAT_MAX_INDEX)];
+
+    t_id_to_ut* tran_buffer[100];
+    const uint64_t buffer_size = 100;
+    uint64_t num_used;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_add_lookup_buffer_del_with_exist_mat);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+
+    // setup data object
+    strcpy(tdum.id, "id_abc");
+    strcpy(tdum2.id, "id_def");
+
+    // setup translation structures
+    init_id_exist_mat(&matrix);
+    init_layer2_id_to_ut_arr(&l2_arr);
+    bitmap_init(&map_buffer, raw_map_buffer, NULL, MAT_MAX_INDEX, 0);
+    bitmap_init(&map_buffer2, raw_map_buffer2, NULL, MAT_MAX_INDEX, 0);
+
+    // empty lookup via existence matrix
+    printf("test area 1 : lookup when existence matrix is empty\n");
+    incre_check();
+    ret = lookup_id_part(&l2_arr, &matrix, "foobar", &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (num_used != 0) {
+        printf("number of slots in buffer filled was reported to be non-zero\n");
+        printf("expected behaviour : report 0 slots filled\n");
+        printf("reported value : %"PRIu64"\n", num_used);
+        incre_error();
+        goto end_test1;
+    }
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    for (i = 0; i < buffer_size; i++) {
+        if (tran_buffer[i] != NULL) {
+            printf("slot %d in buffer was not 0/null\n", i);
+            printf("expected behaviour : all slots to be 0/null\n");
+            printf("filled slot : %p\n", tran_buffer[i]);
+            incre_error();
+            goto end_test1;
+        }
+    }
+
+end_test1:
+
+    // invalid delete when empty
+    printf("test area 2 : invalid delete of entry when matrix is empty\n");
+    incre_check();
+    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
+    // should return FIND_FAIL
+    // as it uses get_id_to_ut_from_layer2_arr to retrieve the translation structure first
+    if (ret != FIND_FAIL) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : error code to be FIND_FAIL\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+
+end_test2:
+
+    // add test data to layer 2 array, layer 2 array related functions assumed to be correct
+    add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    // init
+    init_id_to_ut(id_to_ut);
+    // linkage creation
+    link_to_postings(&tdum, id_to_ut);
+    // add to existence matrix
+    add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+    // full text lookup on non-empty structure
+    printf("test area 3 : full text lookup when one entry exists in matrix\n");
+    incre_check();
+    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test3;
+    }
+    if (num_used != 1) {
+        printf("number of slots used in buffer is not one\n");
+        printf("expected behaviour : number used to be exactly one\n");
+        printf("number used reported : %"PRIu64"\n", num_used);
+        incre_error();
+        goto end_test3;
+    }
+    if (strcmp(tran_buffer[0]->str, tdum.id) != 0) {
+        printf("retrieved id_to_ut does not contain the correct id\n");
+        printf("expected behaviour : retrieved translation structure to contain the id of tdum\n");
+        printf("id of retrieved translation structure : %s\n", tran_buffer[0]->str);
+        printf("id of tdum : %s\n", tdum.id);
+        incre_error();
+        goto end_test3;
+    }
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
+        printf("expected behaviour : to point to tdum\n");
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
+        printf("address of tdum : %p\n", &tdum);
+        incre_error();
+        goto end_test3;
+    }
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
+        incre_error();
+        goto end_test3;
+    }
+
+end_test3:
+
+    // invalid delete when not empty
+    printf("test area 4 : invalid delete of entry when matrix is not empty\n");
+    incre_check();
+    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 2);
+    // should return FIND_FAIL
+    // as it uses get_id_to_ut_from_layer2_arr to retrieve the translation structure first
+    if (ret != FIND_FAIL) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : error code to be FIND_FAIL\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test4;
+    }
+
+end_test4:
+
+    // valid delete of added entry from test area 2
+    // technically should also delete from layer 2 array
+    // but since this is the only entry, and the only entry in its layer 1 array
+    // so existence matrix will register the entire layer 1 array as having no
+    // matching entries
+    // thus lookup will fail regardless
+    // regardles of whether the uniq_char structure is deleted or not
+    printf("test area 5 : continuing from test area 2, deleting valid entry\n");
+    incre_check();
+    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
+    if (ret != 0) {
+        printf("function del_id_from_id_exist_mat\n");
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test5;
+    }
+    // confirm via lookup
+    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (ret != 0) {
+        printf("function lookup_id_part\n");
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test5;
+    }
+    if (num_used != 0) {
+        printf("number of slots used in buffer is not zero\n");
+        printf("expected behaviour : number used to be exactly one\n");
+        printf("number used reported : %"PRIu64"\n", num_used);
+        incre_error();
+        goto end_test5;
+    }
+
+end_test5:
+
+    // add same entry many times
+    printf("test area 6 : adding same entry multiple times\n");
+    incre_check();
+    for (i = 0; i < LARGE_INT; i++) {
+        ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+        if (ret != 0) {
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test6;
+        }
+    }
+    // confirm via lookup
+    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (ret != 0) {
+        printf("function lookup_id_part\n");
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
@@ -729,19 +1303,18 @@ end_test6:
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test7;
     }
@@ -769,19 +1342,18 @@ end_test6:
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test7;
     }
@@ -809,19 +1381,18 @@ end_test6:
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test7;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test7;
     }
@@ -855,19 +1426,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -895,19 +1465,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -935,19 +1504,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -975,19 +1543,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -1015,19 +1582,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -1056,19 +1622,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -1098,19 +1663,18 @@ end_test7:
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test8;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test8;
     }
@@ -1119,8 +1683,10 @@ end_test8:
 
     // add second test data to layer 2 array, layer 2 array functions assumed to be correct
     add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    // init
+    init_id_to_ut(id_to_ut);
     // create linkage
-    link_to_tran(&tdum2, id_to_ut)
+    link_to_postings(&tdum2, id_to_ut);
     // add to existence matrix
     add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
     // valid partial lookups with two entries in matrix
@@ -1153,19 +1719,18 @@ end_test8:
         incre_error();
         goto end_test9;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test9;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test9;
     }
@@ -1178,19 +1743,18 @@ end_test8:
         incre_error();
         goto end_test9;
     }
-    if (tran_buffer[1]->head_tar != &tdum2) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum2\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[1]->head_tar);
+    if (tran_buffer[1]->tar[0] != &tdum2) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum2\n");
+        printf("expected behaviour : to point to tdum2\n");
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[1]->tar[0]);
         printf("address of tdum : %p\n", &tdum2);
         incre_error();
         goto end_test9;
     }
-    if (tran_buffer[1]->tail_tar != &tdum2) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum2\n");
-        printf("expected behaviour : to point to tdum2\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[1]->tail_tar);
-        printf("address of tdum : %p\n", &tdum2);
+    if (tran_buffer[1]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum2 only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[1]->tar_num);
         incre_error();
         goto end_test9;
     }
@@ -1256,19 +1820,18 @@ end_test9:
         incre_error();
         goto end_test10;
     }
-    if (tran_buffer[0]->head_tar != &tdum2) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum2\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+    if (tran_buffer[0]->tar[0] != &tdum2) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum2\n");
+        printf("expected behaviour : to point to tdum2\n");
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum2);
         incre_error();
         goto end_test10;
     }
-    if (tran_buffer[0]->tail_tar != &tdum2) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum2\n");
-        printf("expected behaviour : to point to tdum2\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum2);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum2 only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test10;
     }
@@ -1277,7 +1840,7 @@ end_test9:
     // init
     init_id_to_ut(id_to_ut);
     // linkage creation
-    link_to_tran(&tdum, id_to_ut);
+    link_to_postings(&tdum, id_to_ut);
     add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
     // delete the second entry
     ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 1);
@@ -1336,19 +1899,18 @@ end_test9:
         incre_error();
         goto end_test10;
     }
-    if (tran_buffer[0]->head_tar != &tdum) {
-        printf("retrieved id_to_ut head pointer is not pointing to tdum\n");
+    if (tran_buffer[0]->tar[0] != &tdum) {
+        printf("retrieved id_to_ut first posting is not pointing to tdum\n");
         printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut head_tar pointer : %p\n", tran_buffer[0]->head_tar);
+        printf("address stored in id_to_ut tar[0] : %p\n", tran_buffer[0]->tar[0]);
         printf("address of tdum : %p\n", &tdum);
         incre_error();
         goto end_test10;
     }
-    if (tran_buffer[0]->tail_tar != &tdum) {
-        printf("retrieved id_to_ut tail pointer is not pointing to tdum\n");
-        printf("expected behaviour : to point to tdum\n");
-        printf("address stored in id_to_ut tail_tar pointer : %p\n", tran_buffer[0]->tail_tar);
-        printf("address of tdum : %p\n", &tdum);
+    if (tran_buffer[0]->tar_num != 1) {
+        printf("retrieved id_to_ut does not hold exactly one posting\n");
+        printf("expected behaviour : to hold tdum only\n");
+        printf("number of postings : %"PRIu32"\n", tran_buffer[0]->tar_num);
         incre_error();
         goto end_test10;
     }
@@ -1463,7 +2025,7 @@ end_test2:
     // init
     init_id_to_ut(id_to_ut);
     // linkage creation
-    link_to_tran(&tdum, id_to_ut);
+    link_to_postings(&tdum, id_to_ut);
     // add to existence matrix
     add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
     // full text lookup on non-empty structure
@@ -1754,7 +2316,7 @@ end_test8:
     // init
     init_id_to_ut(id_to_ut);
     // linkage creation
-    link_to_tran(&tdum2, id_to_ut);
+    link_to_postings(&tdum2, id_to_ut);
     // add to existence matrix
     add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
     // valid partial lookups with two entries in matrix
@@ -1787,7 +2349,7 @@ end_test9:
         // init
         init_id_to_ut(id_to_ut);
         // linkage creation
-        link_to_tran(&tdum2, id_to_ut);
+        link_to_postings(&tdum2, id_to_ut);
         add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
     }
     // lookup id_def
@@ -1808,41 +2370,242 @@ end_test9:
         goto end_test10;
     }
 
-end_test10:
+end_test10:
+
+    printf("test area 11 : cleanup\n");
+    incre_check();
+    // clear everything
+    ret = del_l2_id_to_ut_arr(&l2_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test11;
+    }
+    ret = del_id_exist_mat(&matrix);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test11;
+    }
+
+end_test11:
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_lookup_map_del_with_exist_mat);
+
+    return error_num;
+}
+
+int test_stress_add_del(int ret_test_l2_arr, int ret_test_exist_mat) {
+    int i, j;
+
+    utester* tdum;
+    t_id_to_ut* id_to_ut;
+    layer2_id_to_ut_arr l2_arr;
+    uint64_t index_in_arr;
+
+    id_exist_mat matrix;
+    simple_bitmap map_buffer;
+    map_block raw_map_buffer[get_bitmap_map_block_number(MAT_MAX_INDEX)];
+
+    int ret = 0;
+
+    uint64_t t1_index_arr[LARGE_INT];
+    uint64_t t2_index_arr[LARGE_INT];
+
+    time_t t;
+
+    add_trackers();
+
+    announce_test(test_stress_add);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+    skip_if_prereq_failed(ret_test_exist_mat);
+
+    // does not need high quality randomness
+    srand(0);
+
+    init_id_exist_mat(&matrix);
+    init_layer2_id_to_ut_arr(&l2_arr);
+    bitmap_init(&map_buffer, raw_map_buffer, NULL, MAT_MAX_INDEX, 0);
+
+    // stress test on both layer 2 array addition and existence matrix addition, using 0 as seed
+    printf("test area 1 : stress test on adding to layer 2 array and existence matrix, fixed random seed for id generation\n");
+    printf("        seed : 0\n");
+    incre_check();
+    for (i = 0; i < LARGE_INT; i++) {
+        // create data object with mildly random string
+        tdum = malloc(sizeof(utester));
+        for (j = 0; j < UTEST_ID_LENGTH; j++) {
+            tdum->id[j] = rand() % 128;  // should be good enough to avoid integer overflow
+        }
+        tdum->id[UTEST_ID_LENGTH] = 0;
+
+        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test1;
+        }
+        // init
+        init_id_to_ut(id_to_ut);
+        // linkage creation
+        link_to_postings(tdum, id_to_ut);
+        t1_index_arr[i] = index_in_arr;
+        ret = add_id_to_id_exist_mat(&matrix, tdum->id, index_in_arr);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test1;
+        }
+    }
+
+end_test1:
+
+    // stress test again, but using time as seed
+    srand((unsigned) time(&t));
+    printf("test area 2 : stress test on adding to layer 2 array and existence matrix, using time as random seed for id generation\n");
+    printf("        seed : %ld\n", t);
+    incre_check();
+    for (i = 0; i < LARGE_INT; i++) {
+        // create data object with mildly random string
+        tdum = malloc(sizeof(utester));
+        for (j = 0; j < UTEST_ID_LENGTH; j++) {
+            tdum->id[j] = rand() % 128;  // should be good enough to avoid integer overflow
+        }
+        tdum->id[UTEST_ID_LENGTH] = 0;
+
+        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test2;
+        }
+        // init
+        init_id_to_ut(id_to_ut);
+        // linkage creation
+        link_to_postings(tdum, id_to_ut);
+        t2_index_arr[i] = index_in_arr;
+        ret = add_id_to_id_exist_mat(&matrix, tdum->id, index_in_arr);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test2;
+        }
+    }
+
+end_test2:
+
+    printf("test area 3 : continuing from test area 1, stress test on releasing all the entries\n");
+    incre_check();
+    for (i = 0; i < LARGE_INT; i++) {
+        ret = del_id_from_id_exist_mat(&matrix, &l2_arr, t1_index_arr[i]);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("function : del_id_from_id_exist_mat\n");
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test3;
+        }
+        ret = del_id_to_ut_from_layer2_arr(&l2_arr, t1_index_arr[i]);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("function : del_id_to_ut_from_layer2_arr\n");
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test3;
+        }
+    }
+
+end_test3:
+
+    printf("test area 4 : continuing from test area 2, stress test on releasing all the entries\n");
+    incre_check();
+    for (i = 0; i < LARGE_INT; i++) {
+        ret = del_id_from_id_exist_mat(&matrix, &l2_arr, t2_index_arr[i]);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("function : del_id_from_id_exist_mat\n");
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test4;
+        }
+        ret = del_id_to_ut_from_layer2_arr(&l2_arr, t2_index_arr[i]);
+        if (ret != 0) {
+            printf("iteration : %d\n", i);
+            printf("function : del_id_to_ut_from_layer2_arr\n");
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test4;
+        }
+    }
+
+end_test4:
 
-    printf("test area 11 : cleanup\n");
+    printf("test area 5 : test releasing layer 2 array\n");
     incre_check();
-    // clear everything
     ret = del_l2_id_to_ut_arr(&l2_arr);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test11;
+        goto end_test5;
     }
+
+end_test5:
+
+    printf("test area 6 : test releasing existence matrix\n");
+    incre_check();
     ret = del_id_exist_mat(&matrix);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test11;
+        goto end_test6;
     }
 
-end_test11:
+end_test6:
 
     announce_test_end();
     report_stat();
-    print_test_tag_for_report_collector(test_add_lookup_map_del_with_exist_mat);
+    print_test_tag_for_report_collector(test_stress_add);
 
     return error_num;
 }
 
-int test_stress_add_del(int ret_test_l2_arr, int ret_test_exist_mat) {
-    int i, j;
+int test_possibly_wonky_deletion(int ret_test_l2_arr, int ret_test_exist_mat) {
+    int i;
 
-    utester* tdum;
+    utester tdum;
+    utester tdum2;
     t_id_to_ut* id_to_ut;
     layer2_id_to_ut_arr l2_arr;
     uint64_t index_in_arr;
@@ -1850,44 +2613,64 @@ int test_stress_add_del(int ret_test_l2_arr, int ret_test_exist_mat) {
     id_exist_mat matrix;
     simple_bitmap map_buffer;
     map_block raw_map_buffer[get_bitmap_map_block_number(MAT_MAX_INDEX)];
+    simple_bitmap map_buffer2;
+    map_block raw_map_buffer2[get_bitmap_map_block_number(MAT_MAX_INDEX)];
+    simple_bitmap map_result;
+    map_block raw_map_result[get_bitmap_map_block_number(MAT_MAX_INDEX)];
 
-    int ret = 0;
-
-    uint64_t t1_index_arr[LARGE_INT];
-    uint64_t t2_index_arr[LARGE_INT];
+    t_id_to_ut* tran_buffer[100];
+    const uint64_t buffer_size = 100;
+    uint64_t num_used;
 
-    time_t t;
+    int ret;
 
     add_trackers();
 
-    announce_test(test_stress_add);
+    announce_test(test_add_get_del_with_layer2_arr);
     announce_test_begin();
 
     skip_if_prereq_failed(ret_test_l2_arr);
     skip_if_prereq_failed(ret_test_exist_mat);
 
-    // does not need high quality randomness
-    srand(0);
+    // setup data object
+    strcpy(tdum.id, "id_abc");
+    strcpy(tdum2.id, "id_def");
 
+    // setup translation structures
     init_id_exist_mat(&matrix);
     init_layer2_id_to_ut_arr(&l2_arr);
     bitmap_init(&map_buffer, raw_map_buffer, NULL, MAT_MAX_INDEX, 0);
+    bitmap_init(&map_buffer2, raw_map_buffer2, NULL, MAT_MAX_INDEX, 0);
+    bitmap_init(&map_result, raw_map_result, NULL, MAT_MAX_INDEX, 0);
 
-    // stress test on both layer 2 array addition and existence matrix addition, using 0 as seed
-    printf("test area 1 : stress test on adding to layer 2 array and existence matrix, fixed random seed for id generation\n");
-    printf("        seed : 0\n");
+    // test for when the target of deletion from matrix is the only matching entry in layer 1 array it's residing in, buffer version
+    printf("test area 1 : target of deletion is the only matching entry in layer 1 array, lookup using both buffer version and map version\n");
     incre_check();
-    for (i = 0; i < LARGE_INT; i++) {
-        // create data object with mildly random string
-        tdum = malloc(sizeof(utester));
-        for (j = 0; j < UTEST_ID_LENGTH; j++) {
-            tdum->id[j] = rand() % 128;  // should be good enough to avoid integer overflow
-        }
-        tdum->id[UTEST_ID_LENGTH] = 0;
-
+    // fill one entry
+    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    // init
+    init_id_to_ut(id_to_ut);
+    // linkage creation
+    link_to_postings(&tdum, id_to_ut);
+    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    // fill the remaining space in layer 1 array(spilling out to next layer 1 array doesn't hurt)
+    for (i = 0; i < UTEST_L1_SIZE; i++) {
         ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
@@ -1897,11 +2680,9 @@ int test_stress_add_del(int ret_test_l2_arr, int ret_test_exist_mat) {
         // init
         init_id_to_ut(id_to_ut);
         // linkage creation
-        link_to_tran(tdum, id_to_ut);
-        t1_index_arr[i] = index_in_arr;
-        ret = add_id_to_id_exist_mat(&matrix, tdum->id, index_in_arr);
+        link_to_postings(&tdum2, id_to_ut);
+        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
@@ -1909,25 +2690,101 @@ int test_stress_add_del(int ret_test_l2_arr, int ret_test_exist_mat) {
             goto end_test1;
         }
     }
+    // now delete the first entry from existence matrix
+    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    // lookup should fail for both buffer and map version of lookup function
+    // lookup using buffer version
+    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    if (num_used != 0) {
+        printf("number of slots in buffer filled was reported to be non-zero\n");
+        printf("expected behaviour : report 0 slots filled\n");
+        printf("reported value : %"PRIu64"\n", num_used);
+        incre_error();
+        goto end_test1;
+    }
+    // lookup using map version
+    ret = lookup_id_part_map(&matrix, tdum.id, &map_buffer, &map_result);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test1;
+    }
+    if (map_result.number_of_ones != 0) {
+        printf("number of layer 1 array containing the entry reported to be non-zero\n");
+        printf("expected behaviour : report zero layer 1 array matching\n");
+        printf("reported number : %"PRIu64"\n", map_result.number_of_ones);
+        incre_error();
+        goto end_test1;
+    }
 
 end_test1:
 
-    // stress test again, but using time as seed
-    srand((unsigned) time(&t));
-    printf("test area 2 : stress test on adding to layer 2 array and existence matrix, using time as random seed for id generation\n");
-    printf("        seed : %ld\n", t);
-    incre_check();
-    for (i = 0; i < LARGE_INT; i++) {
-        // create data object with mildly random string
-        tdum = malloc(sizeof(utester));
-        for (j = 0; j < UTEST_ID_LENGTH; j++) {
-            tdum->id[j] = rand() % 128;  // should be good enough to avoid integer overflow
-        }
-        tdum->id[UTEST_ID_LENGTH] = 0;
+    // clear everything
+    ret = del_l2_id_to_ut_arr(&l2_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    ret = del_id_exist_mat(&matrix);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    // init again
+    init_id_exist_mat(&matrix);
+    init_layer2_id_to_ut_arr(&l2_arr);
+    bitmap_zero(&map_buffer);
 
+    // test for when the target of deletion from matrix is NOT the only matching entry in layer 1 array it's residing in
+    printf("test area 2 : target of deletion is not the only matching entry in layer 1 array, lookup using both buffer version and map version\n");
+    incre_check();
+    // fill one entry
+    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    // init
+    init_id_to_ut(id_to_ut);
+    // linkage creation
+    link_to_postings(&tdum, id_to_ut);
+    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    // fill up a bit (around half of layer 1 array)
+    for (i = 0; i < UTEST_L1_SIZE / 2; i++) {
         ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
@@ -1937,11 +2794,9 @@ end_test1:
         // init
         init_id_to_ut(id_to_ut);
         // linkage creation
-        link_to_tran(tdum, id_to_ut);
-        t2_index_arr[i] = index_in_arr;
-        ret = add_id_to_id_exist_mat(&matrix, tdum->id, index_in_arr);
+        link_to_postings(&tdum2, id_to_ut);
+        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
@@ -1949,407 +2804,869 @@ end_test1:
             goto end_test2;
         }
     }
-
-end_test2:
-
-    printf("test area 3 : continuing from test area 1, stress test on releasing all the entries\n");
-    incre_check();
-    for (i = 0; i < LARGE_INT; i++) {
-        ret = del_id_from_id_exist_mat(&matrix, &l2_arr, t1_index_arr[i]);
-        if (ret != 0) {
-            printf("iteration : %d\n", i);
-            printf("function : del_id_from_id_exist_mat\n");
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test3;
-        }
-        ret = del_id_to_ut_from_layer2_arr(&l2_arr, t1_index_arr[i]);
-        if (ret != 0) {
-            printf("iteration : %d\n", i);
-            printf("function : del_id_to_ut_from_layer2_arr\n");
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test3;
-        }
+    // fill another entry
+    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
     }
-
-end_test3:
-
-    printf("test area 4 : continuing from test area 2, stress test on releasing all the entries\n");
-    incre_check();
-    for (i = 0; i < LARGE_INT; i++) {
-        ret = del_id_from_id_exist_mat(&matrix, &l2_arr, t2_index_arr[i]);
+    // init
+    init_id_to_ut(id_to_ut);
+    // linkage creation
+    link_to_postings(&tdum, id_to_ut);
+    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    // fill up remaining space of layer 1 array, again spilling out doesn't hurt
+    for (i = 0; i < UTEST_L1_SIZE / 2; i++) {
+        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
-            printf("function : del_id_from_id_exist_mat\n");
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
             incre_error();
-            goto end_test4;
+            goto end_test2;
         }
-        ret = del_id_to_ut_from_layer2_arr(&l2_arr, t2_index_arr[i]);
+        // init
+        init_id_to_ut(id_to_ut);
+        // linkage creation
+        link_to_postings(&tdum2, id_to_ut);
+        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
         if (ret != 0) {
-            printf("iteration : %d\n", i);
-            printf("function : del_id_to_ut_from_layer2_arr\n");
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
             incre_error();
-            goto end_test4;
+            goto end_test2;
         }
     }
+    // lookup should succeed for both buffer and map version of lookup function
+    // lookup using buffer version
+    // as inspection of entire layer 1 array takes place, it will reveal that there
+    // are two matching entries within
+    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    if (num_used != 2) {
+        printf("number of slots in buffer filled was reported to be not two\n");
+        printf("expected behaviour : report 2 slots filled\n");
+        printf("reported value : %"PRIu64"\n", num_used);
+        incre_error();
+        goto end_test2;
+    }
+    // lookup using map version
+    // should report that one layer 1 array still contains matching entries
+    ret = lookup_id_part_map(&matrix, tdum.id, &map_buffer, &map_result);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test2;
+    }
+    if (map_result.number_of_ones != 1) {
+        printf("number of layer 1 array containing the entry reported to be not one\n");
+        printf("expected behaviour : report one layer 1 array matching\n");
+        printf("reported number : %"PRIu64"\n", map_result.number_of_ones);
+        incre_error();
+        goto end_test2;
+    }
 
-end_test4:
+end_test2:
 
-    printf("test area 5 : test releasing layer 2 array\n");
+    printf("test area 3 : cleanup\n");
     incre_check();
+    // clear everything
     ret = del_l2_id_to_ut_arr(&l2_arr);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test5;
+        goto end_test3;
     }
-
-end_test5:
-
-    printf("test area 6 : test releasing existence matrix\n");
-    incre_check();
     ret = del_id_exist_mat(&matrix);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test6;
+        goto end_test3;
     }
 
-end_test6:
+end_test3:
 
     announce_test_end();
     report_stat();
-    print_test_tag_for_report_collector(test_stress_add);
+    print_test_tag_for_report_collector(test_add_get_del_with_layer2_arr);
 
     return error_num;
 }
 
-int test_possibly_wonky_deletion(int ret_test_l2_arr, int ret_test_exist_mat) {
+// depends on layer2 array and existence matrix to be correct, for deleting the last posting
+int test_add_del_with_postings(int ret_test_l2_arr, int ret_test_exist_mat) {
     int i;
 
-    utester tdum;
-    utester tdum2;
+    utester tdum[5];
+    utester tdum_other;
     t_id_to_ut* id_to_ut;
+    t_id_to_ut* id_to_ut_found;
+    t_id_to_ut* htab = NULL;
     layer2_id_to_ut_arr l2_arr;
     uint64_t index_in_arr;
 
     id_exist_mat matrix;
-    simple_bitmap map_buffer;
-    map_block raw_map_buffer[get_bitmap_map_block_number(MAT_MAX_INDEX)];
-    simple_bitmap map_buffer2;
-    map_block raw_map_buffer2[get_bitmap_map_block_number(MAT_MAX_INDEX)];
-    simple_bitmap map_result;
-    map_block raw_map_result[get_bitmap_map_block_number(MAT_MAX_INDEX)];
-
-    t_id_to_ut* tran_buffer[100];
-    const uint64_t buffer_size = 100;
-    uint64_t num_used;
 
     int ret;
 
     add_trackers();
 
-    announce_test(test_add_get_del_with_layer2_arr);
+    announce_test(test_add_del_with_postings);
     announce_test_begin();
 
     skip_if_prereq_failed(ret_test_l2_arr);
     skip_if_prereq_failed(ret_test_exist_mat);
 
-    // setup data object
-    strcpy(tdum.id, "id_abc");
-    strcpy(tdum2.id, "id_def");
+    // setup data objects, all sharing one id
+    for (i = 0; i < 5; i++) {
+        strcpy(tdum[i].id, "id_abc");
+    }
+    strcpy(tdum_other.id, "id_def");
 
     // setup translation structures
     init_id_exist_mat(&matrix);
     init_layer2_id_to_ut_arr(&l2_arr);
-    bitmap_init(&map_buffer, raw_map_buffer, NULL, MAT_MAX_INDEX, 0);
-    bitmap_init(&map_buffer2, raw_map_buffer2, NULL, MAT_MAX_INDEX, 0);
-    bitmap_init(&map_result, raw_map_result, NULL, MAT_MAX_INDEX, 0);
 
-    // test for when the target of deletion from matrix is the only matching entry in layer 1 array it's residing in, buffer version
-    printf("test area 1 : target of deletion is the only matching entry in layer 1 array, lookup using both buffer version and map version\n");
+    add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    init_id_to_ut(id_to_ut);
+    link_to_postings(&tdum[0], id_to_ut);
+    add_id_to_ut_to_htab(&htab, id_to_ut);
+    add_id_to_id_exist_mat(&matrix, tdum[0].id, index_in_arr);
+
+    // single posting is kept inline
+    printf("test area 1 : single posting is kept in tar_one\n");
     incre_check();
-    // fill one entry
-    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (        id_to_ut->tar       != &id_to_ut->tar_one
+            ||  id_to_ut->tar_num   != 1
+            ||  id_to_ut->tar_max   != 1
+            ||  id_to_ut->tar[0]    != &tdum[0]
+       )
+    {
+        printf("posting array of id_to_ut is not inline after a single posting\n");
+        printf("expected behaviour : tar to point to tar_one, holding tdum[0] only\n");
+        printf("tar : %p, &tar_one : %p, tar_num : %"PRIu32", tar_max : %"PRIu32"\n", id_to_ut->tar, &id_to_ut->tar_one, id_to_ut->tar_num, id_to_ut->tar_max);
+        incre_error();
+    }
+    if (tdum[0].id_to_ut != id_to_ut || tdum[0].id_slot != 0) {
+        printf("tdum[0] is not linked back to its slot\n");
+        printf("expected behaviour : tdum[0] to point to id_to_ut, with slot 0\n");
+        printf("slot of tdum[0] : %"PRIu32"\n", tdum[0].id_slot);
+        incre_error();
+    }
+
+    // append moves the postings out of tar_one and grows by doubling
+    printf("test area 2 : append to posting array\n");
+    incre_check();
+    for (i = 1; i < 5; i++) {
+        ret = add_ut_to_id_to_ut_postings(id_to_ut, &tdum[i]);
+        if (ret != 0) {
+            printf("got error code other than 0\n");
+            printf("expected behaviour : error code to be 0\n");
+            printf("returned error code : %d\n", ret);
+            incre_error();
+            goto end_test2;
+        }
+    }
+    if (        id_to_ut->tar       == &id_to_ut->tar_one
+            ||  id_to_ut->tar_num   != 5
+            ||  id_to_ut->tar_max   != 8
+       )
+    {
+        printf("posting array of id_to_ut has wrong size\n");
+        printf("expected behaviour : 5 postings in array of 8 slots, outside of tar_one\n");
+        printf("tar_num : %"PRIu32", tar_max : %"PRIu32"\n", id_to_ut->tar_num, id_to_ut->tar_max);
+        incre_error();
+        goto end_test2;
+    }
+    for (i = 0; i < 5; i++) {
+        if (        id_to_ut->tar[i]        != &tdum[i]
+                ||  tdum[i].id_to_ut        != id_to_ut
+                ||  tdum[i].id_slot         != i
+           )
+        {
+            printf("posting %d does not match tdum[%d]\n", i, i);
+            printf("expected behaviour : postings to be kept in order of appending\n");
+            incre_error();
+            goto end_test2;
+        }
+    }
+
+end_test2:
+
+    // mismatching string
+    printf("test area 3 : append of target with different id\n");
+    incre_check();
+    ret = add_ut_to_id_to_ut_postings(id_to_ut, &tdum_other);
+    if (ret != WRONG_ARGS) {
+        printf("got error code other than WRONG_ARGS\n");
+        printf("expected behaviour : error code to be WRONG_ARGS\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+    }
+    if (id_to_ut->tar_num != 5) {
+        printf("number of postings changed\n");
+        printf("expected behaviour : number of postings to stay at 5\n");
+        printf("tar_num : %"PRIu32"\n", id_to_ut->tar_num);
+        incre_error();
+    }
+
+    // postings : 0 1 2 3 4 -> 0 4 2 3
+    printf("test area 4 : delete from middle of posting array, last posting moves in\n");
+    incre_check();
+    ret = del_ut_from_id_to_ut_postings(&htab, &matrix, &l2_arr, &tdum[1]);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test1;
+        goto end_test4;
     }
-    // init
-    init_id_to_ut(id_to_ut);
-    // linkage creation
-    link_to_tran(&tdum, id_to_ut);
-    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
+    if (        id_to_ut->tar_num   != 4
+            ||  id_to_ut->tar[1]    != &tdum[4]
+            ||  tdum[4].id_slot     != 1
+            ||  tdum[1].id_to_ut    != NULL
+       )
+    {
+        printf("last posting was not moved into slot of deleted posting\n");
+        printf("expected behaviour : tdum[4] to take slot 1, tdum[1] to be unlinked\n");
+        printf("tar_num : %"PRIu32", slot of tdum[4] : %"PRIu32"\n", id_to_ut->tar_num, tdum[4].id_slot);
+        incre_error();
+        goto end_test4;
+    }
+
+end_test4:
+
+    // postings : 0 4 2 3 -> 0 4 2
+    printf("test area 5 : delete last element of posting array\n");
+    incre_check();
+    ret = del_ut_from_id_to_ut_postings(&htab, &matrix, &l2_arr, &tdum[3]);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test1;
+        goto end_test5;
     }
-    // fill the remaining space in layer 1 array(spilling out to next layer 1 array doesn't hurt)
-    for (i = 0; i < UTEST_L1_SIZE; i++) {
-        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
+    if (        id_to_ut->tar_num   != 3
+            ||  id_to_ut->tar[0]    != &tdum[0]
+            ||  id_to_ut->tar[1]    != &tdum[4]
+            ||  id_to_ut->tar[2]    != &tdum[2]
+            ||  tdum[0].id_slot     != 0
+            ||  tdum[4].id_slot     != 1
+            ||  tdum[2].id_slot     != 2
+            ||  tdum[3].id_to_ut    != NULL
+       )
+    {
+        printf("remaining postings were disturbed by deleting the last element\n");
+        printf("expected behaviour : postings to be tdum[0], tdum[4], tdum[2] in their slots\n");
+        printf("tar_num : %"PRIu32"\n", id_to_ut->tar_num);
+        incre_error();
+        goto end_test5;
+    }
+
+end_test5:
+
+    // unlinked target
+    printf("test area 6 : delete of target which is not linked\n");
+    incre_check();
+    ret = del_ut_from_id_to_ut_postings(&htab, &matrix, &l2_arr, &tdum[1]);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+    }
+    if (id_to_ut->tar_num != 3) {
+        printf("number of postings changed\n");
+        printf("expected behaviour : number of postings to stay at 3\n");
+        printf("tar_num : %"PRIu32"\n", id_to_ut->tar_num);
+        incre_error();
+    }
+
+    // deleting the last posting deletes the translation structure
+    printf("test area 7 : delete all remaining postings\n");
+    incre_check();
+    for (i = 0; i < 5; i++) {
+        ret = del_ut_from_id_to_ut_postings(&htab, &matrix, &l2_arr, &tdum[i]);
         if (ret != 0) {
             printf("got error code other than 0\n");
             printf("expected behaviour : error code to be 0\n");
             printf("returned error code : %d\n", ret);
             incre_error();
-            goto end_test1;
+            goto end_test7;
         }
-        // init
-        init_id_to_ut(id_to_ut);
-        // linkage creation
-        link_to_tran(&tdum2, id_to_ut);
-        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
+        ret = lookup_id(htab, "id_abc", &id_to_ut_found);
+        if (i < 4 && (ret != 0 || id_to_ut_found != id_to_ut)) {
+            printf("translation structure was deleted while postings remain\n");
+            printf("expected behaviour : lookup to find id_to_ut\n");
             printf("returned error code : %d\n", ret);
             incre_error();
-            goto end_test1;
+            goto end_test7;
         }
     }
-    // now delete the first entry from existence matrix
-    ret = del_id_from_id_exist_mat(&matrix, &l2_arr, 0);
+    if (ret != FIND_FAIL) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : translation structure to be deleted from hash table\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test7;
+    }
+    ret = get_id_to_ut_from_layer2_arr(&l2_arr, &id_to_ut_found, index_in_arr);
+    if (ret != FIND_FAIL) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : translation structure to be deleted from layer 2 array\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test7;
+    }
+
+end_test7:
+
+    printf("test area 8 : cleanup\n");
+    incre_check();
+    // clear everything
+    ret = del_l2_id_to_ut_arr(&l2_arr);
+    if (ret != 0) {
+        printf("got error code other than 0\n");
+        printf("expected behaviour : error code to be 0\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
+        goto end_test8;
+    }
+    ret = del_id_exist_mat(&matrix);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test1;
+        goto end_test8;
+    }
+
+end_test8:
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_del_with_postings);
+
+    return error_num;
+}
+
+// adds entry under parent, linked the way make_entry in ffp_term.c does
+linked_entry* add_test_entry(database_handle* dh, linked_entry* parent, const char* name) {
+    linked_entry* entry;
+
+    if (add_entry_to_layer2_arr(&dh->l2_entry_arr, &entry, NULL)) {
+        return NULL;
+    }
+    init_entry_strs(entry);
+    set_entry_file_name(dh, entry, name);
+    entry->type = ENTRY_FILE;
+    set_new_entry_id(dh, entry);
+
+    put_into_children_array(parent, entry);
+    entry->has_parent = parent != &dh->tree;
+
+    link_entry_to_file_name_structures(dh, entry);
+    link_entry_to_entry_id_structures(dh, entry);
+
+    return entry;
+}
+
+// counts children of parent named name via child cursor, returns -1 if a wrong child shows up
+int count_children_via_cursor(linked_entry* parent, linked_entry* named) {
+    child_cursor cursor;
+    linked_entry* temp_entry;
+
+    int count = 0;
+
+    child_cursor_init(&cursor, parent, named->file_name_id);
+    while (child_cursor_next(&cursor, &temp_entry) == 0) {
+        if (temp_entry->file_name_id != named->file_name_id || temp_entry->parent != parent) {
+            return -1;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+// checks child_slot of every child, and that every child is found by name
+int check_children(linked_entry* parent) {
+    ffp_eid_int i;
+
+    int count;
+    int dup_num = 0;
+
+    for (i = 0; i < parent->child_num; i++) {
+        dup_num += strcmp(parent->child[i]->file_name, "dup") == 0;
+    }
+
+    for (i = 0; i < parent->child_num; i++) {
+        if (parent->child[i]->child_slot != i) {
+            printf("child %d has child_slot %d\n", (int) i, (int) parent->child[i]->child_slot);
+            return 1;
+        }
+        count = count_children_via_cursor(parent, parent->child[i]);
+        if (count != (strcmp(parent->child[i]->file_name, "dup") == 0 ? dup_num : 1)) {
+            printf("child %s is found %d times via cursor\n", parent->child[i]->file_name, count);
+            return 1;
+        }
+    }
+
+    if (parent->child_idx && parent->child_idx->used_num != parent->child_num) {
+        printf("child index holds %d children, parent has %d\n", (int) parent->child_idx->used_num, (int) parent->child_num);
+        return 1;
+    }
+
+    return 0;
+}
+
+// depends on layer2 array to be correct, for entry allocation
+int test_add_del_with_child_index(int ret_test_l2_arr) {
+    int i;
+
+    char name[FILE_NAME_MAX+1];
+
+    database_handle* dh;
+    linked_entry* parent;
+    linked_entry* last;
+    linked_entry* temp_entry;
+    child_cursor cursor;
+    str_id deleted_id;
+    linked_entry* sorted_buf[16];
+    bit_index num_used;
+    bit_index total_used;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_add_del_with_child_index);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+
+    dh = malloc(sizeof(database_handle));
+    init_database_handle(dh);
+    parent = add_test_entry(dh, &dh->tree, "parent");
+
+    // children 0, 10, 20, ... are all named "dup"
+    printf("test area 1 : children below CHILD_INDEX_MIN_NUM are not indexed\n");
+    incre_check();
+    for (i = 0; i < CHILD_INDEX_MIN_NUM - 1; i++) {
+        sprintf(name, i % 10 == 0 ? "dup" : "c%03d", i);
+        add_test_entry(dh, parent, name);
+    }
+    if (parent->child_idx || check_children(parent)) {
+        printf("children are indexed or not found via cursor\n");
+        printf("expected behaviour : no child index, every child found by name\n");
+        incre_error();
+    }
+
+    printf("test area 2 : child index is made at CHILD_INDEX_MIN_NUM children\n");
+    incre_check();
+    add_test_entry(dh, parent, "c031");
+    if (!parent->child_idx || check_children(parent)) {
+        printf("children are not indexed or not found via cursor\n");
+        printf("expected behaviour : child index made, every child found by name\n");
+        incre_error();
+    }
+
+    // last child moves into slot 5
+    printf("test area 3 : delete from middle of children array\n");
+    incre_check();
+    last = parent->child[parent->child_num - 1];
+    deleted_id = parent->child[5]->file_name_id;
+    ret = del_entry(dh, parent->child[5]);
+    child_cursor_init(&cursor, parent, deleted_id);
+    if (        ret != 0
+            ||  parent->child_num != CHILD_INDEX_MIN_NUM - 1
+            ||  parent->child[5] != last
+            ||  last->child_slot != 5
+            ||  child_cursor_next(&cursor, &temp_entry) != FIND_FAIL
+            ||  check_children(parent)
+       )
+    {
+        printf("last child was not moved into slot of deleted child\n");
+        printf("expected behaviour : last child to take slot 5, with child_slot fixed up\n");
+        printf("returned error code : %d\n", ret);
+        incre_error();
     }
-    // lookup should fail for both buffer and map version of lookup function
-    // lookup using buffer version
-    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
+
+    printf("test area 4 : delete last child and a child with shared name\n");
+    incre_check();
+    del_entry(dh, parent->child[parent->child_num - 1]);
+    ret = del_entry(dh, parent->child[0]);
+    if (ret != 0 || parent->child_num != CHILD_INDEX_MIN_NUM - 3 || check_children(parent)) {
+        printf("children array or child index is off after deletes\n");
+        printf("expected behaviour : %d children, every child found by name\n", CHILD_INDEX_MIN_NUM - 3);
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test1;
     }
-    if (num_used != 0) {
-        printf("number of slots in buffer filled was reported to be non-zero\n");
-        printf("expected behaviour : report 0 slots filled\n");
-        printf("reported value : %"PRIu64"\n", num_used);
-        incre_error();
-        goto end_test1;
+
+    // index is kept below CHILD_INDEX_MIN_NUM, and grows past half of CHILD_INDEX_INIT_SLOT_NUM
+    printf("test area 5 : delete below then add past size of child index\n");
+    incre_check();
+    while (parent->child_num > 10) {
+        del_entry(dh, parent->child[parent->child_num / 2]);
     }
-    // lookup using map version
-    ret = lookup_id_part_map(&matrix, tdum.id, &map_buffer, &map_result);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
-        incre_error();
-        goto end_test1;
+    for (i = 100; i < 200; i++) {
+        sprintf(name, "c%03d", i);
+        add_test_entry(dh, parent, name);
     }
-    if (map_result.number_of_ones != 0) {
-        printf("number of layer 1 array containing the entry reported to be non-zero\n");
-        printf("expected behaviour : report zero layer 1 array matching\n");
-        printf("reported number : %"PRIu64"\n", map_result.number_of_ones);
+    if (        !parent->child_idx
+            ||  parent->child_idx->slot_num <= CHILD_INDEX_INIT_SLOT_NUM
+            ||  check_children(parent)
+       )
+    {
+        printf("child index did not grow or children are not found\n");
+        printf("expected behaviour : child index grown, every child found by name\n");
         incre_error();
-        goto end_test1;
     }
 
-end_test1:
+    // pages of 16 from get_sorted_children should be in order by name
+    printf("test area 6 : sorted children in pages\n");
+    incre_check();
+    total_used = 0;
+    last = NULL;
+    do {
+        ret = get_sorted_children(parent, total_used, sorted_buf, 16, &num_used);
+        for (i = 0; i < num_used; i++) {
+            if (last && strcmp(last->file_name, sorted_buf[i]->file_name) > 0) {
+                break;
+            }
+            last = sorted_buf[i];
+        }
+        total_used += num_used;
+    } while (ret == BUFFER_FULL && i == num_used);
+    if (ret != 0 || total_used != parent->child_num) {
+        printf("sorted children are out of order or do not cover all children\n");
+        printf("expected behaviour : %d children in order\n", (int) parent->child_num);
+        printf("returned error code : %d, number of children got : %"PRIu64"\n", ret, total_used);
+        incre_error();
+    }
 
-    // clear everything
-    ret = del_l2_id_to_ut_arr(&l2_arr);
+    printf("test area 7 : cleanup\n");
+    incre_check();
+    ret = fres_database_handle(dh);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test2;
     }
-    ret = del_id_exist_mat(&matrix);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
+    free(dh);
+
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_del_with_child_index);
+
+    return error_num;
+}
+
+// checks result of time range lookup is in ascending order and in [from, to]
+int check_time_range(linked_entry** buf, bit_index num, int64_t from, int64_t to) {
+    bit_index i;
+
+    for (i = 0; i < num; i++) {
+        if (        buf[i]->tod_utc < from
+                ||  buf[i]->tod_utc > to
+                ||  (i > 0 && buf[i-1]->tod_utc > buf[i]->tod_utc)
+           )
+        {
+            printf("entry %d of result has time %"PRId64", out of order or not in [%"PRId64", %"PRId64"]\n", (int) i, buf[i]->tod_utc, from, to);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// depends on layer2 array to be correct, for entry allocation
+int test_add_lookup_del_with_time_index(int ret_test_l2_arr) {
+    int i;
+
+    char name[FILE_NAME_MAX+1];
+
+    database_handle* dh;
+    linked_entry* entry[26];
+    linked_entry* result_buf[32];
+    bit_index num_used;
+    bit_index total_used;
+    int64_t from;
+
+    simple_bitmap entry_map;
+    map_block* raw_entry_map;
+    map_block temp_result;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_add_lookup_del_with_time_index);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+
+    dh = malloc(sizeof(database_handle));
+    init_database_handle(dh);
+
+    // 20 entries 10 seconds apart from 1000, then 3 more at 1050 and 3 more at 1100
+    for (i = 0; i < 26; i++) {
+        sprintf(name, "t%03d", i);
+        entry[i] = add_test_entry(dh, &dh->tree, name);
+        entry[i]->tod_utc = i < 20 ? 1000 + i * 10 : (i < 23 ? 1050 : 1100);
+        link_entry_to_date_time_tree(dh, entry[i], DATE_TOD);
+    }
+
+    printf("test area 1 : lookup with ties on both ends of range\n");
+    incre_check();
+    ret = lookup_date_time(dh, DATE_TOD, 1050, 1100, result_buf, 32, &num_used);
+    if (ret != 0 || num_used != 12 || check_time_range(result_buf, num_used, 1050, 1100)) {
+        printf("got error code other than 0, or wrong entries\n");
+        printf("expected behaviour : 12 entries from 1050 to 1100 in ascending order\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
-        goto end_test2;
     }
-    // init again
-    init_id_exist_mat(&matrix);
-    init_layer2_id_to_ut_arr(&l2_arr);
-    bitmap_zero(&map_buffer);
 
-    // test for when the target of deletion from matrix is NOT the only matching entry in layer 1 array it's residing in
-    printf("test area 2 : target of deletion is not the only matching entry in layer 1 array, lookup using both buffer version and map version\n");
+    printf("test area 2 : lookup just inside ends and outside of all entries\n");
     incre_check();
-    // fill one entry
-    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
+    ret = lookup_date_time(dh, DATE_TOD, 1051, 1099, result_buf, 32, &num_used);
+    if (ret != 0 || num_used != 4 || check_time_range(result_buf, num_used, 1051, 1099)) {
+        printf("got error code other than 0, or wrong entries\n");
+        printf("expected behaviour : 4 entries from 1060 to 1090\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
         goto end_test2;
     }
-    // init
-    init_id_to_ut(id_to_ut);
-    // linkage creation
-    link_to_tran(&tdum, id_to_ut);
-    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
+    ret = lookup_date_time(dh, DATE_TOD, 1191, 2000, result_buf, 32, &num_used);
+    if (ret != FIND_FAIL || num_used != 0) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : no entries after 1190\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
         goto end_test2;
     }
-    // fill up a bit (around half of layer 1 array)
-    for (i = 0; i < UTEST_L1_SIZE / 2; i++) {
-        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test2;
-        }
-        // init
-        init_id_to_ut(id_to_ut);
-        // linkage creation
-        link_to_tran(&tdum2, id_to_ut);
-        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test2;
-        }
-    }
-    // fill another entry
-    ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
+    ret = lookup_date_time(dh, DATE_TOD, 1100, 1050, result_buf, 32, &num_used);
+    if (ret != FIND_FAIL || num_used != 0) {
+        printf("got error code other than FIND_FAIL\n");
+        printf("expected behaviour : no entries in empty range\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
         goto end_test2;
     }
-    // init
-    init_id_to_ut(id_to_ut);
-    // linkage creation
-    link_to_tran(&tdum, id_to_ut);
-    ret = add_id_to_id_exist_mat(&matrix, tdum.id, index_in_arr);
-    if (ret != 0) {
+
+end_test2:
+
+    // 1110 to 1190 holds 9 entries, taken 4 at a time starting after last time seen
+    printf("test area 3 : lookup in pages\n");
+    incre_check();
+    ret = lookup_date_time(dh, DATE_TOD, 1110, 1140, result_buf, 4, &num_used);
+    if (ret != 0 || num_used != 4) {
         printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
-        printf("returned error code : %d\n", ret);
+        printf("expected behaviour : exactly 4 entries fit in buffer of 4\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
-        goto end_test2;
+        goto end_test3;
     }
-    // fill up remaining space of layer 1 array, again spilling out doesn't hurt
-    for (i = 0; i < UTEST_L1_SIZE / 2; i++) {
-        ret = add_id_to_ut_to_layer2_arr(&l2_arr, &id_to_ut, &index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test2;
+    from = 1110;
+    total_used = 0;
+    for (i = 0; i < 3; i++) {
+        ret = lookup_date_time(dh, DATE_TOD, from, 1190, result_buf, 4, &num_used);
+        if (        ret != (i < 2 ? BUFFER_FULL : 0)
+                ||  num_used != (i < 2 ? 4 : 1)
+                ||  check_time_range(result_buf, num_used, from, 1190)
+           )
+        {
+            break;
         }
-        // init
-        init_id_to_ut(id_to_ut);
-        // linkage creation
-        link_to_tran(&tdum2, id_to_ut);
-        ret = add_id_to_id_exist_mat(&matrix, tdum2.id, index_in_arr);
-        if (ret != 0) {
-            printf("got error code other than 0\n");
-            printf("expected behaviour : error code to be 0\n");
-            printf("returned error code : %d\n", ret);
-            incre_error();
-            goto end_test2;
+        total_used += num_used;
+        from = result_buf[num_used - 1]->tod_utc + 1;
+    }
+    if (i != 3 || total_used != 9) {
+        printf("page %d is off\n", i);
+        printf("expected behaviour : BUFFER_FULL on first 2 pages, 9 entries in total\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
+        incre_error();
+        goto end_test3;
+    }
+
+end_test3:
+
+    // map starts at 1 bit, lookup grows it as needed
+    printf("test area 4 : lookup into map\n");
+    incre_check();
+    raw_entry_map = malloc(sizeof(map_block) * get_bitmap_map_block_number(1));
+    bitmap_init(&entry_map, raw_entry_map, NULL, 1, 0);
+    ret = lookup_date_time_map(dh, DATE_TOD, 1050, 1100, &entry_map);
+    for (i = 0; i < 26; i++) {
+        temp_result = 0;
+        if (entry[i]->obj_arr_index < entry_map.length) {
+            bitmap_read(&entry_map, entry[i]->obj_arr_index, &temp_result);
+        }
+        if (temp_result != (entry[i]->tod_utc >= 1050 && entry[i]->tod_utc <= 1100)) {
+            break;
         }
     }
-    // lookup should succeed for both buffer and map version of lookup function
-    // lookup using buffer version
-    // as inspection of entire layer 1 array takes place, it will reveal that there
-    // are two matching entries within
-    ret = lookup_id_part(&l2_arr, &matrix, tdum.id, &map_buffer, &map_buffer2, tran_buffer, buffer_size, &num_used);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
-        printf("expected behaviour : error code to be 0\n");
+    if (ret != 0 || i != 26) {
+        printf("entry %d is marked wrongly\n", i);
+        printf("expected behaviour : exactly the entries from 1050 to 1100 marked\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test2;
     }
-    if (num_used != 2) {
-        printf("number of slots in buffer filled was reported to be not two\n");
-        printf("expected behaviour : report 2 slots filled\n");
-        printf("reported value : %"PRIu64"\n", num_used);
+    free(entry_map.base);
+
+    // one entry on each end of range, one by deletion, the other by unlinking
+    printf("test area 5 : lookup after unlink and delete\n");
+    incre_check();
+    unlink_entry_from_date_time_tree(dh, entry[5], DATE_TOD);
+    del_entry(dh, entry[25]);
+    ret = lookup_date_time(dh, DATE_TOD, 1050, 1100, result_buf, 32, &num_used);
+    for (i = 0; i < num_used; i++) {
+        if (result_buf[i] == entry[5] || result_buf[i] == entry[25]) {
+            break;
+        }
+    }
+    if (ret != 0 || num_used != 10 || i != num_used || check_time_range(result_buf, num_used, 1050, 1100)) {
+        printf("got error code other than 0, or removed entries are still found\n");
+        printf("expected behaviour : 10 entries from 1050 to 1100\n");
+        printf("returned error code : %d, number used reported : %d\n", ret, (int) num_used);
         incre_error();
-        goto end_test2;
     }
-    // lookup using map version
-    // should report that one layer 1 array still contains matching entries
-    ret = lookup_id_part_map(&matrix, tdum.id, &map_buffer, &map_result);
+
+    printf("test area 6 : cleanup\n");
+    incre_check();
+    ret = fres_database_handle(dh);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test2;
-    }
-    if (map_result.number_of_ones != 1) {
-        printf("number of layer 1 array containing the entry reported to be not one\n");
-        printf("expected behaviour : report one layer 1 array matching\n");
-        printf("reported number : %"PRIu64"\n", map_result.number_of_ones);
-        incre_error();
-        goto end_test2;
     }
+    free(dh);
 
-end_test2:
+    announce_test_end();
+    report_stat();
+    print_test_tag_for_report_collector(test_add_lookup_del_with_time_index);
 
-    printf("test area 3 : cleanup\n");
+    return error_num;
+}
+
+// depends on layer2 array to be correct, for file data allocation
+int test_link_file_data_via_file_size(int ret_test_l2_arr) {
+    int i;
+
+    char file_size_str[FILE_SIZE_STR_MAX+1];
+
+    database_handle* dh;
+    file_data* data[3];
+    t_f_size_to_fd* tran;
+
+    int ret;
+
+    add_trackers();
+
+    announce_test(test_link_file_data_via_file_size);
+    announce_test_begin();
+
+    skip_if_prereq_failed(ret_test_l2_arr);
+
+    dh = malloc(sizeof(database_handle));
+    init_database_handle(dh);
+
+    // size string is unpadded after fingerprinting, and left empty by older loaders
+    for (i = 0; i < 3; i++) {
+        add_file_data_to_layer2_arr(&dh->l2_file_data_arr, &data[i], NULL);
+        data[i]->file_size = i < 2 ? 300000 : 42;
+    }
+    sprintf(data[0]->file_size_str, "%"PRIu64"", data[0]->file_size);
+    data[1]->file_size_str[0] = 0;
+
+    printf("test area 1 : link file data with same and different sizes\n");
     incre_check();
-    // clear everything
-    ret = del_l2_id_to_ut_arr(&l2_arr);
-    if (ret != 0) {
-        printf("got error code other than 0\n");
+    for (i = 0; i < 3; i++) {
+        ret = link_file_data_to_file_size_structures(dh, data[i]);
+        if (ret) {
+            break;
+        }
+    }
+    if (ret) {
+        printf("got error code other than 0 for file data %d\n", i);
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test3;
     }
-    ret = del_id_exist_mat(&matrix);
+
+    printf("test area 2 : file data with same size share posting array\n");
+    incre_check();
+    strfy_sprintf(file_size_str, FILE_SIZE_STR_MAX, PRIu64, (uint64_t) 300000);
+    lookup_file_size_via_dh(dh, file_size_str, &tran);
+    if (        !tran
+            ||  tran->tar_num != 2
+            ||  data[0]->f_size_to_fd != tran
+            ||  data[1]->f_size_to_fd != tran
+            ||  !data[2]->f_size_to_fd
+            ||  data[2]->f_size_to_fd->tar_num != 1
+       )
+    {
+        printf("file data missing from size postings\n");
+        printf("expected behaviour : 2 file data of size 300000, 1 of size 42\n");
+        printf("number of file data of size 300000 : %d\n", tran ? (int) tran->tar_num : -1);
+        incre_error();
+    }
+
+    printf("test area 3 : unlink file data until translation structure goes\n");
+    incre_check();
+    for (i = 0; i < 2; i++) {
+        del_fd_from_f_size_to_fd_postings(&dh->f_size_to_fd, &dh->f_size_gram, &dh->l2_f_size_to_fd_arr, data[i]);
+        lookup_file_size_via_dh(dh, file_size_str, &tran);
+        if (i == 0 ? (!tran || tran->tar_num != 1 || tran->tar[0] != data[1]) : tran != NULL) {
+            break;
+        }
+    }
+    if (i != 2) {
+        printf("size postings are off after unlinking file data %d\n", i);
+        printf("expected behaviour : size 300000 found until last file data is unlinked\n");
+        incre_error();
+    }
+
+    printf("test area 4 : cleanup\n");
+    incre_check();
+    ret = fres_database_handle(dh);
     if (ret != 0) {
         printf("got error code other than 0\n");
         printf("expected behaviour : error code to be 0\n");
         printf("returned error code : %d\n", ret);
         incre_error();
-        goto end_test3;
     }
-
-end_test3:
+    free(dh);
 
     announce_test_end();
     report_stat();
-    print_test_tag_for_report_collector(test_add_get_del_with_layer2_arr);
+    print_test_tag_for_report_collector(test_link_file_data_via_file_size);
 
     return error_num;
 }
@@ -2365,6 +3682,12 @@ int main (void) {
 
     ret_total += ret_test_l2_arr = test_add_get_del_with_layer2_arr();
 
+    ret_total += test_layer2_arr_reuse_and_growth(ret_test_l2_arr);
+
+    ret_total += test_add_lookup_del_with_gram_index(ret_test_l2_arr);
+
+    ret_total += test_add_lookup_del_with_digest_index();
+
     ret_total += ret_test_exist_mat = test_add_lookup_buffer_del_with_exist_mat(ret_test_l2_arr);
 
     ret_total += ret_test_exist_mat = test_add_lookup_map_del_with_exist_mat(ret_test_l2_arr, ret_test_exist_mat);
@@ -2373,6 +3696,14 @@ int main (void) {
 
     ret_total += test_possibly_wonky_deletion(ret_test_l2_arr, ret_test_exist_mat);
 
+    ret_total += test_add_del_with_postings(ret_test_l2_arr, ret_test_exist_mat);
+
+    ret_total += test_add_del_with_child_index(ret_test_l2_arr);
+
+    ret_total += test_add_lookup_del_with_time_index(ret_test_l2_arr);
+
+    ret_total += test_link_file_data_via_file_size(ret_test_l2_arr);
+
     report_total(ret_total);
 
     return ret_total;